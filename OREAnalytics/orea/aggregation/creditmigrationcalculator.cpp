@@ -29,13 +29,14 @@ CreditMigrationCalculator::CreditMigrationCalculator(
     const QuantLib::ext::shared_ptr<NPVCube>& nettedCube,
     const QuantLib::ext::shared_ptr<AggregationScenarioData>& aggregationScenarioData,
     const std::vector<Real>& creditMigrationDistributionGrid, const std::vector<Size>& creditMigrationTimeSteps,
-    const Matrix& creditStateCorrelationMatrix, const std::string baseCurrency)
+    const Matrix& creditStateCorrelationMatrix, const std::string baseCurrency,
+    const QuantLib::ext::shared_ptr<QuantExt::WorkerPool>& workerPool)
     : portfolio_(portfolio), creditSimulationParameters_(creditSimulationParameters), cube_(cube),
       cubeInterpretation_(cubeInterpretation), nettedCube_(nettedCube),
       aggregationScenarioData_(aggregationScenarioData),
       creditMigrationDistributionGrid_(creditMigrationDistributionGrid),
       creditMigrationTimeSteps_(creditMigrationTimeSteps), creditStateCorrelationMatrix_(creditStateCorrelationMatrix),
-      baseCurrency_(baseCurrency) {}
+      baseCurrency_(baseCurrency), workerPool_(workerPool) {}
 
 void CreditMigrationCalculator::build() {
 
@@ -66,7 +67,7 @@ void CreditMigrationCalculator::build() {
                               cubeInterpretation_->mporFlowsIndex(), cubeInterpretation_->creditStateNPVsIndex(),
                               creditMigrationDistributionGrid_[0], creditMigrationDistributionGrid_[1],
                               static_cast<Size>(creditMigrationDistributionGrid_[2]), creditStateCorrelationMatrix_,
-                              baseCurrency_);
+                              baseCurrency_, workerPool_);
 
     hlp.build(portfolio_->trades());
 
@@ -78,11 +79,14 @@ void CreditMigrationCalculator::build() {
     cdf_.clear();
     pdf_.clear();
 
+    // all time steps are processed in one sweep over the paths
+    std::vector<Array> dists = hlp.pnlDistributions(creditMigrationTimeSteps_);
+
     for (Size i = 0; i < creditMigrationTimeSteps_.size(); ++i) {
         DLOG("Generating pnl distribution for timestep " << creditMigrationTimeSteps_[i]);
         cdf_.push_back({});
         pdf_.push_back({});
-        Array dist = hlp.pnlDistribution(creditMigrationTimeSteps_[i]);
+        const Array& dist = dists[i];
         Real mean = 0.0, stdev = 0.0;
         Real sum = 0.0;
         for (Size j = 1; j < hlp.upperBucketBound().size() - 1; ++j) {
@@ -28,6 +28,8 @@
 #include <orea/cube/npvcube.hpp>
 #include <ored/portfolio/portfolio.hpp>
 
+#include <qle/utilities/workerpool.hpp>
+
 #include <ql/shared_ptr.hpp>
 
 namespace ore {
@@ -49,7 +51,8 @@ public:
                               const QuantLib::ext::shared_ptr<AggregationScenarioData>& aggregationScenarioData,
                               const std::vector<Real>& creditMigrationDistributionGrid,
                               const std::vector<Size>& creditMigrationTimeSteps,
-                              const Matrix& creditStateCorrelationMatrix, const std::string baseCurrency);
+                              const Matrix& creditStateCorrelationMatrix, const std::string baseCurrency,
+                              const QuantLib::ext::shared_ptr<QuantExt::WorkerPool>& workerPool = nullptr);
 
     void build();
 
@@ -68,6 +71,7 @@ private:
     std::vector<Size> creditMigrationTimeSteps_;
     Matrix creditStateCorrelationMatrix_;
     std::string baseCurrency_;
+    QuantLib::ext::shared_ptr<QuantExt::WorkerPool> workerPool_;
 
     std::vector<Real> upperBucketBounds_;
     std::vector<std::vector<Real>> cdf_;
@@ -32,6 +32,9 @@
 #include <ql/math/distributions/normaldistribution.hpp>
 #include <ql/time/daycounters/actualactual.hpp>
 
+#include <algorithm>
+#include <numeric>
+
 using namespace QuantLib;
 using namespace QuantExt;
 
@@ -45,10 +48,11 @@ CreditMigrationHelper::CreditMigrationHelper(const QuantLib::ext::shared_ptr<Cre
                                              const Size cubeIndexCashflows, const Size cubeIndexStateNpvs,
                                              const Real distributionLowerBound, const Real distributionUpperBound,
                                              const Size buckets, const Matrix& globalFactorCorrelation,
-                                             const string& baseCurrency)
+                                             const string& baseCurrency,
+                                             const QuantLib::ext::shared_ptr<QuantExt::WorkerPool>& workerPool)
     : parameters_(parameters), cube_(cube), nettedCube_(nettedCube), aggData_(aggData),
       cubeIndexCashflows_(cubeIndexCashflows), cubeIndexStateNpvs_(cubeIndexStateNpvs),
-      globalFactorCorrelation_(globalFactorCorrelation), baseCurrency_(baseCurrency),
+      globalFactorCorrelation_(globalFactorCorrelation), baseCurrency_(baseCurrency), workerPool_(workerPool),
       creditMode_(parseCreditMode(parameters_->creditMode())),
       loanExposureMode_(parseLoanExposureMode(parameters_->loanExposureMode())),
       evaluation_(parseEvaluation(parameters_->evaluation())),
@@ -56,12 +60,13 @@ CreditMigrationHelper::CreditMigrationHelper(const QuantLib::ext::shared_ptr<Cre
 
     rescaledTransitionMatrices_.resize(cube_->numDates());
     init();
-    if (evaluation_ == Evaluation::TerminalSimulation)
-        initEntityStateSimulation();
 } // CreditMigrationHelper()
 
 namespace {
 
+// number of global paths per block in pnlDistributions(), the blocks are distributed over the worker pool's threads
+constexpr Size pathsPerBlock = 16;
+
 Real conditionalProb(const Real p, const Real m, const Real v) {
     QuantLib::CumulativeNormalDistribution nd;
     QuantLib::InverseCumulativeNormal icn;
@@ -197,27 +202,14 @@ void CreditMigrationHelper::init() {
 
 } // init
 
-void CreditMigrationHelper::initEntityStateSimulation() {
-
-    LOG("Init entity state simulation");
-
-    simulatedEntityState_ =
-        std::vector<std::vector<Size>>(parameters_->entities().size(), std::vector<Size>(cube_->samples()));
-
-    LOG("Init entity state simulation done.");
-
-} // initEntityStatesSimulation
-
-std::vector<Matrix> CreditMigrationHelper::initEntityStateSimulation(const Size date, const Size path) {
+std::vector<Matrix> CreditMigrationHelper::initEntityStateSimulation(const Size date, const Size path,
+                                                                     const std::vector<const Matrix*>& transMat) const {
     std::vector<Matrix> res = std::vector<Matrix>(parameters_->entities().size(), Matrix(n_, n_, 0.0));
 
-    const std::vector<string>& matrixNames = parameters_->transitionMatrices();
-
     // build terminal matrices conditional on global states
     Size numWarnings = 0;
-    auto transMat = rescaledTransitionMatrices(date);
     for (Size i = 0; i < parameters_->entities().size(); ++i) {
-        const Matrix& m = transMat.at(matrixNames[i]);
+        const Matrix& m = *transMat[i];
         for (Size ii = 0; ii < m.rows(); ++ii) {
             Real p = 0.0, condProb0 = 0.0;
             for (Size jj = 0; jj < m.columns(); ++jj) {
@@ -253,32 +245,25 @@ std::vector<Matrix> CreditMigrationHelper::initEntityStateSimulation(const Size
     return res;
 }
 
-void CreditMigrationHelper::simulateEntityStates(const std::vector<Matrix>& cond, const Size path,
-                                                 const MersenneTwisterUniformRng& mt) {
+void CreditMigrationHelper::simulateEntityStates(const std::vector<Matrix>& cond,
+                                                 const QuantExt::Philox4x32UniformRng& rng,
+                                                 std::vector<Size>& entityStates) const {
 
     QL_REQUIRE(evaluation_ != Evaluation::Analytic,
                "CreditMigrationHelper::simulateEntityStates() unexpected call, not in simulation mode");
 
     for (Size i = 0; i < parameters_->entities().size(); ++i) {
         Size initialState = parameters_->initialStates()[i];
-            Real tmp = mt.next().value;
-            Size entityState =
-                std::lower_bound(cond[i].row_begin(initialState), cond[i].row_end(initialState), tmp) -
-                cond[i].row_begin(initialState);
-            entityState = std::min(entityState, cond[i].columns() - 1); // play safe
-            simulatedEntityState_[i][path] = entityState;
-            initialState = entityState;
+        Real tmp = rng.nextReal();
+        Size entityState = std::lower_bound(cond[i].row_begin(initialState), cond[i].row_end(initialState), tmp) -
+                           cond[i].row_begin(initialState);
+        entityStates[i] = std::min(entityState, cond[i].columns() - 1); // play safe
     }
 
 } // simulateEntityStates
 
-Size CreditMigrationHelper::simulatedEntityState(const Size i, const Size path) const {
-    QL_REQUIRE(evaluation_ != Evaluation::Analytic,
-               "CreditMigrationHelper::simulatedEntityState() unexpected call, not in simulation mode");
-    return simulatedEntityState_[i][path];
-} // simulatedEntityState
-
-Real CreditMigrationHelper::generateMigrationPnl(const Size date, const Size path, const Size n) const {
+Real CreditMigrationHelper::generateMigrationPnl(const Size date, const Size path,
+                                                 const std::vector<Size>& entityStates) const {
 
     QL_REQUIRE(!parameters_->doubleDefault(),
                "CreditMigrationHelper::generateMigrationPnl() does not support double default");
@@ -289,54 +274,46 @@ Real CreditMigrationHelper::generateMigrationPnl(const Size date, const Size pat
     for (Size i = 0; i < entities.size(); ++i) {
         // compute credit state of entitiy
         // issuer migration risk
-        Size simEntityState = simulatedEntityState(i, path);
-        for (auto const& tradeId : issuerTradeIds_[i]) {
+        Size simEntityState = entityStates[i];
+        for (auto const& trade : issuerTrades_[i]) {
             try {
-                Size tid = cube_->getTradeIndex(tradeId);
-                Real baseValue = cube_->get(tid, date, path, 0);
-                Real stateValue = cube_->get(tid, date, path, cubeIndexStateNpvs_ + simEntityState);
+                Real baseValue = cube_->get(trade.cubeIndex, date, path, 0);
+                Real stateValue = cube_->get(trade.cubeIndex, date, path, cubeIndexStateNpvs_ + simEntityState);
                 if (loanExposureMode_ == LoanExposureMode::Notional) {
-                    if (tradeNotionals_.find(tradeId) != tradeNotionals_.end()) {
+                    if (trade.notional != Null<Real>()) {
                         // this is a bond
-                        string tradeCcy = tradeCurrencies_.at(tradeId);
-                        string ccypair = tradeCcy + baseCurrency_;
-                        Real fx = 1.0;
-                        if (tradeCcy != baseCurrency_) {
-                            QL_REQUIRE(aggData_->has(AggregationScenarioDataType::FXSpot, ccypair),
-                                       "FX spot data not found in aggregation data for currency pair " << ccypair);
-                            fx = aggData_->get(date, path, AggregationScenarioDataType::FXSpot, ccypair);
-                        }
+                        Real fx = trade.ccyPair.empty()
+                                      ? 1.0
+                                      : aggData_->get(date, path, AggregationScenarioDataType::FXSpot, trade.ccyPair);
                         // FIXME: We actually need the correct current notional as of the future horizon date,
                         // but we have the current notional as of today
-                        baseValue = tradeNotionals_.at(tradeId) * fx;
+                        baseValue = trade.notional * fx;
                         // FIXME: get the bond's recovery rate
                         Real rr = 0.0;
-                        stateValue = simEntityState == n - 1 ? rr * baseValue : baseValue;
+                        stateValue = simEntityState == n_ - 1 ? rr * baseValue : baseValue;
                     }
-                    if (tradeCdsCptyIdx_.find(tradeId) != tradeCdsCptyIdx_.end()) {
+                    if (trade.cdsCptyIdx != Null<Size>()) {
                         // this is a cds
                         baseValue = 0.0;
-                        if (simEntityState < n - 1)
+                        if (simEntityState < n_ - 1)
                             stateValue = 0.0;
                         else
                             stateValue *= aggData_->get(date, path, AggregationScenarioDataType::Numeraire);
                     }
                 }
-                if (creditMode_ == CreditMode::Default && simEntityState < n - 1) {
+                if (creditMode_ == CreditMode::Default && simEntityState < n_ - 1) {
                     stateValue = baseValue;
                 }
                 pnl += stateValue - baseValue;
             } catch (const std::exception& e) {
-                ALOG("can not get state npv for trade " << tradeId << " (reason:" << e.what() << "), state "
+                ALOG("can not get state npv for trade " << trade.id << " (reason:" << e.what() << "), state "
                                                         << simEntityState << ", assume zero credit migration pnl");
             }
         }
         // default risk for derivative exposure
         // TODO, assuming a zero recovery here...
-        for (auto const& nettingSetId : cptyNettingSetIds_[i]) {
-            Size nid = nettedCube_->getTradeIndex(nettingSetId);
-            QL_REQUIRE(nettedCube_, "empty netted cube");
-            if (simEntityState == n - 1)
+        if (simEntityState == n_ - 1) {
+            for (auto const nid : cptyNettingSetIndices_[i])
                 pnl -= std::max(nettedCube_->get(nid, date, path), 0.0);
         }
     }
@@ -344,20 +321,19 @@ Real CreditMigrationHelper::generateMigrationPnl(const Size date, const Size pat
 } // generateMigrationPnl
 
 void CreditMigrationHelper::generateConditionalMigrationPnl(const Size date, const Size path,
-                                                            const std::map<string, Matrix>& transMat,
+                                                            const std::vector<const Matrix*>& transMat,
                                                             std::vector<Array>& condProbs,
                                                             std::vector<Array>& pnl) const {
 
     Real t = cubeTimes_[date];
 
     const std::vector<string>& entities = parameters_->entities();
-    const std::vector<string>& matrixNames = parameters_->transitionMatrices();
 
     for (Size i = 0; i < entities.size(); ++i) {
         // compute conditional migration prob
         Size initialState = parameters_->initialStates()[i];
         Real p = 0.0, condProb0 = 0.0;
-        const Matrix& m = transMat.at(matrixNames[i]);
+        const Matrix& m = *transMat[i];
         for (Size j = 0; j < n_; ++j) {
             p += m[initialState][j];
             Real condProb = conditionalProb(p, globalStates_[date][i][path], globalVar_[i]);
@@ -366,31 +342,26 @@ void CreditMigrationHelper::generateConditionalMigrationPnl(const Size date, con
         }
         // issuer migration risk
         Size cdsCptyIdx = Null<Size>();
-        for (auto const& tradeId : issuerTradeIds_[i]) {
+        for (auto const& trade : issuerTrades_[i]) {
             for (Size j = 0; j < n_; ++j) {
                 try {
-                    Size tid = cube_->getTradeIndex(tradeId);
-                    Real baseValue = cube_->get(tid, date, path, 0);
-                    Real stateValue = cube_->get(tid, date, path, cubeIndexStateNpvs_ + j);
+                    Real baseValue = cube_->get(trade.cubeIndex, date, path, 0);
+                    Real stateValue = cube_->get(trade.cubeIndex, date, path, cubeIndexStateNpvs_ + j);
                     if (loanExposureMode_ == LoanExposureMode::Notional) {
-                        if (tradeNotionals_.find(tradeId) != tradeNotionals_.end()) {
+                        if (trade.notional != Null<Real>()) {
                             // this is a bond
-                            string tradeCcy = tradeCurrencies_.at(tradeId);
-                            string ccypair = tradeCcy + baseCurrency_;
-                            Real fx = 1.0;
-                            if (tradeCcy != baseCurrency_) {
-                                QL_REQUIRE(aggData_->has(AggregationScenarioDataType::FXSpot, ccypair),
-                                           "FX spot data not found in aggregation data for currency pair " << ccypair);
-                                fx = aggData_->get(date, path, AggregationScenarioDataType::FXSpot, ccypair);
-                            }
+                            Real fx = trade.ccyPair.empty() ? 1.0
+                                                            : aggData_->get(date, path,
+                                                                            AggregationScenarioDataType::FXSpot,
+                                                                            trade.ccyPair);
                             // FIXME: We actually need the correct current notional as of the future horizon date,
                             // but we have the current notional as of today
-                            baseValue = tradeNotionals_.at(tradeId) * fx;
+                            baseValue = trade.notional * fx;
                             // FIXME: get the bond's recovery rate
                             Real rr = 0.0;
                             stateValue = j == n_ - 1 ? rr * baseValue : baseValue;
                         }
-                        if (tradeCdsCptyIdx_.find(tradeId) != tradeCdsCptyIdx_.end()) {
+                        if (trade.cdsCptyIdx != Null<Size>()) {
                             // this is a cds
                             baseValue = 0.0;
                             if (j < n_ - 1)
@@ -407,228 +378,330 @@ void CreditMigrationHelper::generateConditionalMigrationPnl(const Size date, con
                     if (j == n_ - 1)
                         pnl[i][n_] += stateValue - baseValue;
                     // for a CDS we have to subdivide the default migration event into two events (see above)
-                    if (parameters_->doubleDefault() && j == n_ - 1 &&
-                        tradeCdsCptyIdx_.find(tradeId) != tradeCdsCptyIdx_.end()) {
+                    if (parameters_->doubleDefault() && j == n_ - 1 && trade.cdsCptyIdx != Null<Size>()) {
                         // FIXME currently we can not handle two CDS cptys for same underlying issuer
-                        QL_REQUIRE(cdsCptyIdx == Null<Size>() || cdsCptyIdx == tradeCdsCptyIdx_.at(tradeId),
+                        QL_REQUIRE(cdsCptyIdx == Null<Size>() || cdsCptyIdx == trade.cdsCptyIdx,
                                    "CreditMigrationHelper: Two different CDS cptys found for same issuer "
                                        << entities[i]);
                         // only adjust probability once
                         if (cdsCptyIdx == Null<Size>()) {
-                            Real cptyDefaultPd =
-                                transMat.at(matrixNames[tradeCdsCptyIdx_.at(tradeId)])[initialState][n_ - 1];
+                            Real cptyDefaultPd = (*transMat[trade.cdsCptyIdx])[initialState][n_ - 1];
                             Real pd = prob_tauA_lt_tauB_lt_T(cptyDefaultPd, condProbs[i][n_ - 1], t);
                             QL_REQUIRE(pd <= condProbs[i][n_ - 1],
                                        "CreditMigrationHelper: unexpected probability for double default event "
                                            << pd << " > " << condProbs[i][n_ - 1]);
                             condProbs[i][n_ - 1] -= pd;
                             condProbs[i][n_] = pd;
-                            cdsCptyIdx = tradeCdsCptyIdx_.at(tradeId);
+                            cdsCptyIdx = trade.cdsCptyIdx;
                             // pnl for new state is zero
                             pnl[i][n_] -= stateValue - baseValue;
                         }
                     }
                 } catch (const std::exception& e) {
-                    ALOG("can not get state npv for trade " << tradeId << " (reason:" << e.what() << "), state " << j
+                    ALOG("can not get state npv for trade " << trade.id << " (reason:" << e.what() << "), state " << j
                                                             << ", assume zero credit migration pnl");
                 }
             }
         }
         // default risk for derivative exposure
         // TODO, assuming a zero recovery here...
-        for (auto const& nettingSetId : cptyNettingSetIds_[i]) {
-            auto nid = nettedCube_->getTradeIndex(nettingSetId);
-            QL_REQUIRE(nettedCube_, "empty netted cube");
+        for (auto const nid : cptyNettingSetIndices_[i])
             pnl[i][n_ - 1] -= std::max(nettedCube_->get(nid, date, path), 0.0);
-        }
     }
 } // generateConditionalMigrationPnl
 
-Array CreditMigrationHelper::pnlDistribution(const Size date) {
+void CreditMigrationHelper::marketPnl(const Size path, const std::vector<Size>& sortedDates,
+                                      std::vector<Real>& cash) const {
+
+    // FIXME 1
+    // Methodology question: Do we need/want to multiply with the stochastic discount factor
+    // here if we do an explicit credit default simulation at horizon?
+    // FIXME 2
+    // make CDS PnL neutral bei weighting flows with surv prob and generating protection flow
+    // with default prob
+    auto survivalWeight = [this, path](const MarketTrade& trade, const Size date) {
+        // get cumulative survival probability on the path
+        if (parameters_->zeroMarketPnl() && !trade.creditCurve.empty())
+            return aggData_->get(date, path, AggregationScenarioDataType::SurvivalWeight, trade.creditCurve);
+        return 1.0;
+    };
+
+    // at t0 we flip the sign of the npvs to get the initial cash balance and collect the intermediate cashflows
 
-    // FIXME if we ask this method for more than one time step, it might be more efficient to
-    // pass a vector of those time steps and compute the distirbutions in one sweep here
-    // in particular step 2b-1 (in forward simulation mode)
+    Real flows = 0.0;
+    for (auto const& trade : marketTrades_) {
+        flows -= cube_->getT0(trade.cubeIndex, 0);
+        if (cubeIndexCashflows_ != Null<Size>())
+            flows += cube_->getT0(trade.cubeIndex, cubeIndexCashflows_);
+    }
 
-    LOG("Compute PnL distribution for date " << date);
-    QL_REQUIRE(date < cube_->numDates(), "date index " << date << " out of range 0..." << cube_->numDates() - 1);
-    const std::vector<string>& entities = parameters_->entities();
+    Size next = 0;
+    for (Size date = 0; next < sortedDates.size(); ++date) {
+        if (sortedDates[next] == date) {
+            // at the horizon date we realise the npv
+            Real c = flows;
+            for (auto const& trade : marketTrades_)
+                c += survivalWeight(trade, date) * cube_->get(trade.cubeIndex, date, path, 0);
+            while (next < sortedDates.size() && sortedDates[next] == date)
+                cash[next++] = c;
+        }
+        // collect intermediate cashflows for later horizon dates
+        if (next < sortedDates.size() && cubeIndexCashflows_ != Null<Size>()) {
+            for (auto const& trade : marketTrades_)
+                flows += survivalWeight(trade, date) * cube_->get(trade.cubeIndex, date, path, cubeIndexCashflows_);
+        }
+    }
+} // marketPnl
 
-    // 1 get transition matrices for entities and rescale them to horizon
+Array CreditMigrationHelper::pnlDistribution(const Size date) { return pnlDistributions({date}).front(); }
 
-    std::map<string, Matrix> transMat; // rescaled transition matrix per (matrix) name
+std::vector<Array> CreditMigrationHelper::pnlDistributions(const std::vector<Size>& dates) {
+
+    QL_REQUIRE(built_, "CreditMigrationHelper::pnlDistributions(): build() must be called first");
+    LOG("Compute PnL distributions for " << dates.size() << " dates");
+    for (auto const date : dates) {
+        QL_REQUIRE(date < cube_->numDates(), "date index " << date << " out of range 0..." << cube_->numDates() - 1);
+    }
+
+    // process the dates in ascending order, so that the market pnl can be accumulated in one sweep over the cube
 
-    // 1 get transition matrices for time step and compute variance of global factors for each entiity
+    Size numDates = dates.size();
+    std::vector<Size> order(numDates);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&dates](Size a, Size b) { return dates[a] < dates[b]; });
+    std::vector<Size> sortedDates(numDates);
+    for (Size k = 0; k < numDates; ++k)
+        sortedDates[k] = dates[order[k]];
+
+    const std::vector<string>& entities = parameters_->entities();
+
+    // 1 get transition matrices for entities and rescale them to horizon, index them by entity
+
+    std::vector<std::map<string, Matrix>> transMat(numDates); // rescaled transition matrix per (matrix) name
+    std::vector<std::vector<const Matrix*>> entityTransMat(numDates,
+                                                           std::vector<const Matrix*>(entities.size(), nullptr));
 
     if (parameters_->creditRisk()) {
-        transMat = rescaledTransitionMatrices(date);
+        for (Size k = 0; k < numDates; ++k) {
+            transMat[k] = rescaledTransitionMatrices(sortedDates[k]);
+            for (Size i = 0; i < entities.size(); ++i)
+                entityTransMat[k][i] = &transMat[k].at(parameters_->transitionMatrices()[i]);
+        }
     }
 
-    // 2 compute conditional pnl distributions and average over paths
-
-    const std::set<std::string>& tradeIds = cube_->ids();
-    Array res(bucketing_.buckets(), 0.0);
+    // 2 compute conditional pnl distributions and average over paths, each block of paths contributes a partial
+    //   result, the partial results are added in a fixed order, so the result does not depend on the number of threads
 
     Size numPaths = cube_->samples();
-    Real avgCash = 0.0;
-
-    HullWhiteBucketing hwBucketing(bucketing_.upperBucketBound().begin(), bucketing_.upperBucketBound().end());
-
-    MersenneTwisterUniformRng mt(parameters_->seed());
-
-    for (Size path = 0; path < numPaths; ++path) {
-
-        // 2a market pnl (t0 to horizon date, over whole cube)
-
-        Real cash = 0.0;
-
-        if (parameters_->marketRisk()) {
-            for (Size j = 0; j <= date + 1; ++j) {
-                for (auto const& tradeId : tradeIds) {
-                    Size i = cube_->getTradeIndex(tradeId);
-                    // get cumulative survival probability on the path
-                    Real sp = 1.0;
-                    //Real rr = 0.0;
-                    // FIXME 1
-                    // Methodology question: Do we need/want to multiply with the stochastic discount factor
-                    // here if we do an explicit credit default simulation at horizon?
-                    // FIXME 2
-                    // make CDS PnL neutral bei weighting flows with surv prob and generating protection flow
-                    // with default prob
-                    if (parameters_->zeroMarketPnl() && j > 0 &&
-                        tradeCreditCurves_.find(tradeId) != tradeCreditCurves_.end()) {
-                        string creditCurve = tradeCreditCurves_.at(tradeId);
-                        sp = aggData_->get(j - 1, path, AggregationScenarioDataType::SurvivalWeight, creditCurve);
-                        //rr = aggData_->get(j - 1, path, AggregationScenarioDataType::RecoveryRate, creditCurve);
+    Size numBlocks = (numPaths + pathsPerBlock - 1) / pathsPerBlock;
+    std::vector<std::vector<Array>> partialRes(numBlocks,
+                                               std::vector<Array>(numDates, Array(bucketing_.buckets(), 0.0)));
+    std::vector<std::vector<Real>> partialAvgCash(numBlocks, std::vector<Real>(numDates, 0.0));
+
+    auto processBlocks = [this, numPaths, numDates, &sortedDates, &entities, &entityTransMat, &partialRes,
+                          &partialAvgCash](std::size_t blockBegin, std::size_t blockEnd, std::size_t) {
+
+        HullWhiteBucketing hwBucketing(bucketing_.upperBucketBound().begin(), bucketing_.upperBucketBound().end());
+        std::vector<Real> cash(numDates, 0.0);
+        std::vector<Size> entityStates(entities.size());
+
+        for (Size block = blockBegin; block < blockEnd; ++block) {
+            for (Size path = block * pathsPerBlock; path < std::min(numPaths, (block + 1) * pathsPerBlock); ++path) {
+
+                // 2a market pnl (t0 to horizon dates, over whole cube)
+
+                if (parameters_->marketRisk())
+                    marketPnl(path, sortedDates, cash);
+
+                for (Size k = 0; k < numDates; ++k) {
+
+                    Size date = sortedDates[k];
+
+                    // average market risk pnl
+                    partialAvgCash[block][k] += cash[k] / static_cast<Real>(numPaths);
+
+                    if (!parameters_->creditRisk()) {
+                        // if we just add scalar market pnl realisations, we don't really need
+                        // the bucketing algorithm to do that, we just update the result
+                        // distribution directly
+                        partialRes[block][k][hwBucketing.index(cash[k])] += 1.0 / static_cast<Real>(numPaths);
+                        continue;
                     }
-                    if (j == 0) {
-                        // at t0 we flip the sign of the npvs to get the initial cash balance
-                        cash -= cube_->getT0(i, 0);
-                        // collect intermediate cashflows
-                        if (cubeIndexCashflows_ != Null<Size>())
-                            cash += cube_->getT0(i, cubeIndexCashflows_);
-                    } else if (j <= date) {
-                        // collect intermediate cashflows
-                        if (cubeIndexCashflows_ != Null<Size>())
-                            cash += sp * cube_->get(i, j - 1, path, cubeIndexCashflows_);
+
+                    // 2b credit migration pnl (at horizon date, over entities specified in credit simulation
+                    // parameters)
+
+                    std::vector<Array> condProbs, pnl;
+
+                    if (evaluation_ != Evaluation::Analytic) {
+                        // 2b-1 generate pnl on the path using simulated idiosyncratic factors, the random numbers
+                        // for the global path and date are taken from their own stream
+                        condProbs.resize(1,
+                                         Array(parameters_->paths(), 1.0 / static_cast<Real>(parameters_->paths())));
+                        // we could build the distribution more efficiently here, but later in 2c we add the market
+                        // pnl maybe extend the hw bucketing so that we can feed precomputed distributions and just
+                        // update these with additional data?
+                        pnl.resize(1, Array(parameters_->paths(), 0.0));
+                        auto cond = initEntityStateSimulation(date, path, entityTransMat[k]);
+                        QuantExt::Philox4x32UniformRng rng(parameters_->seed(), path * cube_->numDates() + date);
+                        for (Size path2 = 0; path2 < parameters_->paths(); ++path2) {
+                            simulateEntityStates(cond, rng, entityStates);
+                            pnl[0][path2] = generateMigrationPnl(date, path, entityStates);
+                        }
                     } else {
-                        // at the horizon date we realise the npv
-                        cash += sp * cube_->get(i, j - 1, path, 0);
+                        // 2b-2 generate pnl distribution without simulation of idiosyncratic factors using the
+                        // conditional independence of migration on the path / systemic factors
+
+                        // n+1 states, since for CDS we have to subdivide the issuer default into
+                        // i) default of issuer and non-default of CDS cpty
+                        // ii) default of issuer, default of CDS cpty (but after the issuer default)
+                        // iii) default of issuer, default of CDS cpty (before the issuer default)
+                        // for non-CDS trades for all sub-states the pnl will be set to the same value
+                        // for CDS trades i)+ii) will have the same pnl, but iii) will have a zero pnl
+                        // in total, we only have to distinguish i)+ii) and iii), i.e. we need one
+                        // additional state
+
+                        condProbs.resize(entities.size(), Array(n_ + 1, 0.0));
+                        pnl.resize(entities.size(), Array(n_ + 1, 0.0));
+                        generateConditionalMigrationPnl(date, path, entityTransMat[k], condProbs, pnl);
                     }
-                }
-            } // for data
-        }     // if market risk
-
-        if (!parameters_->creditRisk()) {
-            // if we just add scalar market pnl realisations, we don't really need
-            // the bucketing algorithm to do that, we just update the result
-            // distribution directly
-            res[hwBucketing.index(cash)] += 1.0 / static_cast<Real>(numPaths);
-            continue;
-        }
 
-        // 2b credit migration pnl (at horizon date, over entities specified in credit simulation parameters)
-
-        std::vector<Array> condProbs, pnl;
-
-        if (evaluation_ != Evaluation::Analytic) {
-            // 2b-1 generate pnl on the path using simulated idiosyncratic factors
-            condProbs.resize(1, Array(parameters_->paths(), 1.0 / static_cast<Real>(parameters_->paths())));
-            // we could build the distribution more efficiently here, but later in 2c we add the market pnl
-            // maybe extend the hw bucketing so that we can feed precomputed distributions and just update
-            // these with additional data?
-            pnl.resize(1, Array(parameters_->paths(), 0.0));
-            auto cond = initEntityStateSimulation(date, path);
-            for (Size path2 = 0; path2 < parameters_->paths(); ++path2) {
-                simulateEntityStates(cond, path, mt);
-                pnl[0][path2] = generateMigrationPnl(date, path, n_);
-            }
-        } else {
-            // 2b-2 generate pnl distribution without simulation of idiosyncratic factors using the conditional
-            // independence of migration on the path / systemic factors
-
-            // n+1 states, since for CDS we have to subdivide the issuer default into
-            // i) default of issuer and non-default of CDS cpty
-            // ii) default of issuer, default of CDS cpty (but after the issuer default)
-            // iii) default of issuer, default of CDS cpty (before the issuer default)
-            // for non-CDS trades for all sub-states the pnl will be set to the same value
-            // for CDS trades i)+ii) will have the same pnl, but iii) will have a zero pnl
-            // in total, we only have to distinguish i)+ii) and iii), i.e. we need one
-            // additional state
-
-            condProbs.resize(entities.size(), Array(n_ + 1, 0.0));
-            pnl.resize(entities.size(), Array(n_ + 1, 0.0));
-            generateConditionalMigrationPnl(date, path, transMat, condProbs, pnl);
-        }
+                    // 2c aggregate market pnl and credit migration pnl
 
-        // 2c aggregate market pnl and credit migration pnl
+                    if (parameters_->marketRisk()) {
+                        condProbs.push_back(Array(1, 1.0));
+                        pnl.push_back(Array(1, cash[k]));
+                    }
 
-        if (parameters_->marketRisk()) {
-            condProbs.push_back(Array(1, 1.0));
-            pnl.push_back(Array(1, cash));
-        }
+                    hwBucketing.computeMultiState(condProbs.begin(), condProbs.end(), pnl.begin());
 
-        hwBucketing.computeMultiState(condProbs.begin(), condProbs.end(), pnl.begin());
+                    // 2d add pnl contribution of path to result distribution
+                    partialRes[block][k] += hwBucketing.probability() / static_cast<Real>(numPaths);
 
-        // 2d add pnl contribution of path to result distribution
-        res += hwBucketing.probability() / static_cast<Real>(numPaths);
-        // average market risk pnl
-        avgCash += cash / static_cast<Real>(numPaths);
+                } // for date
+            }     // for path
+        }         // for block
+    };
 
-    } // for path
+    if (workerPool_)
+        workerPool_->parallelFor(numBlocks, 1, processBlocks);
+    else
+        processBlocks(0, numBlocks, 0);
 
-    DLOG("Expected Market Risk PnL at date " << date << ": " << avgCash);
-    return res;
-} // pnlDistribution
+    // 3 add up the partial results
+
+    std::vector<Array> result(numDates);
+    for (Size k = 0; k < numDates; ++k) {
+        Array res(bucketing_.buckets(), 0.0);
+        Real avgCash = 0.0;
+        for (Size block = 0; block < numBlocks; ++block) {
+            res += partialRes[block][k];
+            avgCash += partialAvgCash[block][k];
+        }
+        DLOG("Expected Market Risk PnL at date " << sortedDates[k] << ": " << avgCash);
+        result[order[k]] = res;
+    }
+
+    return result;
+} // pnlDistributions
 
 void CreditMigrationHelper::build(const std::map<std::string, QuantLib::ext::shared_ptr<Trade>>& trades) {
-    LOG("CreditMigrationHelper: Build trade ID map");
-    issuerTradeIds_.resize(parameters_->entities().size());
-    cptyNettingSetIds_.resize(parameters_->entities().size());
-    for (Size i = 0; i < parameters_->entities().size(); ++i) {
-        string entity = parameters_->entities()[i];
-        std::set<string> tmp, tmp2;
+    LOG("CreditMigrationHelper: Build trade index maps");
+
+    const std::vector<string>& entities = parameters_->entities();
+
+    // bond and cds data by trade id
+
+    std::map<std::string, std::string> tradeCreditCurves;
+    std::map<std::string, Real> tradeNotionals;
+    std::map<std::string, std::string> tradeCurrencies;
+    std::map<std::string, Size> tradeCdsCptyIdx;
+
+    for (const auto& [_, t] : trades) {
+        QuantLib::ext::shared_ptr<Bond> bond = QuantLib::ext::dynamic_pointer_cast<Bond>(t);
+        if (bond) {
+            tradeCreditCurves[t->id()] = bond->bondData().creditCurveId();
+            // FIXME: We actually need the notional schedule here to determine future notionals
+            tradeNotionals[t->id()] = bond->notional();
+            tradeCurrencies[t->id()] = bond->bondData().currency();
+        }
+        QuantLib::ext::shared_ptr<CreditDefaultSwap> cds = QuantLib::ext::dynamic_pointer_cast<CreditDefaultSwap>(t);
+        if (cds) {
+            string cpty = cds->envelope().counterparty();
+            QL_REQUIRE(cpty != t->issuer(), "CDS has same CPTY and issuer " << cpty);
+            Size idx = std::find(entities.begin(), entities.end(), cpty) - entities.begin();
+            if (idx < entities.size())
+                tradeCdsCptyIdx[t->id()] = idx;
+            else
+                WLOG("CreditMigrationHelepr: CDS trade "
+                     << t->id() << " has cpty " << cpty
+                     << " which is not in the list of simulated entities, "
+                        "ignore joint default event of issuer and cpty for this CDS");
+        }
+    }
+
+    // trades with issuer risk and netting sets with derivative exposure risk by entity, resolved to cube indices
+
+    issuerTrades_.assign(entities.size(), {});
+    cptyNettingSetIndices_.assign(entities.size(), {});
+    for (Size i = 0; i < entities.size(); ++i) {
+        string entity = entities[i];
+        std::set<string> issuerTradeIds, nettingSetIds;
         for (const auto& [_, t] : trades) {
             if (t->issuer() == entity) {
-                tmp.insert(t->id());
+                issuerTradeIds.insert(t->id());
             }
             if (t->envelope().counterparty() == entity &&
                 std::find(parameters_->nettingSetIds().begin(), parameters_->nettingSetIds().end(),
                           t->envelope().nettingSetId()) != parameters_->nettingSetIds().end()) {
-                tmp2.insert(t->envelope().nettingSetId());
+                nettingSetIds.insert(t->envelope().nettingSetId());
             }
-            QuantLib::ext::shared_ptr<Bond> bond = QuantLib::ext::dynamic_pointer_cast<Bond>(t);
-            if (bond) {
-                tradeCreditCurves_[t->id()] = bond->bondData().creditCurveId();
-                // FIXME: We actually need the notional schedule here to determine future notionals
-                tradeNotionals_[t->id()] = bond->notional();
-                tradeCurrencies_[t->id()] = bond->bondData().currency();
-            }
-            QuantLib::ext::shared_ptr<CreditDefaultSwap> cds = QuantLib::ext::dynamic_pointer_cast<CreditDefaultSwap>(t);
-            if (cds) {
-                string cpty = cds->envelope().counterparty();
-                QL_REQUIRE(cpty != t->issuer(), "CDS has same CPTY and issuer " << cpty);
-                Size idx = std::find(parameters_->entities().begin(), parameters_->entities().end(), cpty) -
-                           parameters_->entities().begin();
-                if (idx < parameters_->entities().size())
-                    tradeCdsCptyIdx_[t->id()] = idx;
-                else
-                    WLOG("CreditMigrationHelepr: CDS trade "
-                         << t->id() << " has cpty " << cpty
-                         << " which is not in the list of simulated entities, "
-                            "ignore joint default event of issuer and cpty for this CDS");
+        }
+        for (auto const& tradeId : issuerTradeIds) {
+            IssuerTrade trade{tradeId, Null<Size>(), Null<Real>(), std::string(), Null<Size>()};
+            try {
+                trade.cubeIndex = cube_->getTradeIndex(tradeId);
+                if (loanExposureMode_ == LoanExposureMode::Notional) {
+                    if (auto n = tradeNotionals.find(tradeId); n != tradeNotionals.end()) {
+                        trade.notional = n->second;
+                        string tradeCcy = tradeCurrencies.at(tradeId);
+                        if (tradeCcy != baseCurrency_) {
+                            trade.ccyPair = tradeCcy + baseCurrency_;
+                            QL_REQUIRE(aggData_->has(AggregationScenarioDataType::FXSpot, trade.ccyPair),
+                                       "FX spot data not found in aggregation data for currency pair "
+                                           << trade.ccyPair);
+                        }
+                    }
+                }
+            } catch (const std::exception& e) {
+                ALOG("can not get state npvs for trade " << tradeId << " (reason:" << e.what()
+                                                         << "), assume zero credit migration pnl");
+                continue;
             }
+            if (auto c = tradeCdsCptyIdx.find(tradeId); c != tradeCdsCptyIdx.end())
+                trade.cdsCptyIdx = c->second;
+            issuerTrades_[i].push_back(trade);
+        }
+        for (auto const& nettingSetId : nettingSetIds) {
+            QL_REQUIRE(nettedCube_, "empty netted cube");
+            cptyNettingSetIndices_[i].push_back(nettedCube_->getTradeIndex(nettingSetId));
         }
-        issuerTradeIds_[i] = tmp;
-        cptyNettingSetIds_[i] = tmp2;
     }
-    LOG("CreditMigrationHelper: Built issuer and cpty trade ID sets for " << parameters_->entities().size()
-                                                                          << " entities.");
-    for (Size i = 0; i < parameters_->entities().size(); ++i) {
-        DLOG("Entity " << parameters_->entities()[i] << ": " << issuerTradeIds_[i].size()
-                       << " trades with issuer risk, " << cptyNettingSetIds_[i].size()
-                       << " nettings sets with derivative exposure risk.");
+    LOG("CreditMigrationHelper: Built issuer and cpty trade index maps for " << entities.size() << " entities.");
+    for (Size i = 0; i < entities.size(); ++i) {
+        DLOG("Entity " << entities[i] << ": " << issuerTrades_[i].size() << " trades with issuer risk, "
+                       << cptyNettingSetIndices_[i].size() << " nettings sets with derivative exposure risk.");
     }
+
+    // trades entering the market pnl
+
+    marketTrades_.clear();
+    for (auto const& tradeId : cube_->ids()) {
+        auto c = tradeCreditCurves.find(tradeId);
+        marketTrades_.push_back({cube_->getTradeIndex(tradeId), c == tradeCreditCurves.end() ? string() : c->second});
+    }
+
+    built_ = true;
 }
 
 CreditMigrationHelper::CreditMode parseCreditMode(const std::string& s) {
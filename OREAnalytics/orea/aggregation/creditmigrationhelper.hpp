@@ -31,10 +31,11 @@
 #include <ored/portfolio/trade.hpp>
 #include <ored/utilities/log.hpp>
 
+#include <qle/math/philoxuniformrng.hpp>
 #include <qle/models/hullwhitebucketing.hpp>
+#include <qle/utilities/workerpool.hpp>
 
 #include <ql/math/matrix.hpp>
-#include <ql/math/randomnumbers/mt19937uniformrng.hpp>
 
 namespace ore {
 namespace analytics {
@@ -47,7 +48,11 @@ namespace analytics {
      - n correlated global factors \f$ G_j \f$
      - entity specific factor loadings \f$ \beta_{ij} \f$
      - idiosyncratic part \f$ dZ_i = \sigma_i dW_i \f$
-     - independent  Wiener processes W, i.e. \f$ dW_k dW_l = 0 \f$ and \f$ dW_k dG_j = 0 \f$ */
+     - independent  Wiener processes W, i.e. \f$ dW_k dW_l = 0 \f$ and \f$ dW_k dG_j = 0 \f$
+
+   The global paths are processed in blocks on the given worker pool, if any. In simulation mode each global path and
+   date uses its own stream of a counter based random number generator, so the results do not depend on the number of
+   threads nor on the dates requested together. */
 class CreditMigrationHelper {
 public:
     enum class CreditMode { Migration, Default };
@@ -59,15 +64,20 @@ public:
                           const QuantLib::ext::shared_ptr<AggregationScenarioData> aggData, const Size cubeIndexCashflows,
                           const Size cubeIndexStateNpvs, const Real distributionLowerBound,
                           const Real distributionUpperBound, const Size buckets, const Matrix& globalFactorCorrelation,
-                          const std::string& baseCurrency);
+                          const std::string& baseCurrency,
+                          const QuantLib::ext::shared_ptr<QuantExt::WorkerPool>& workerPool = nullptr);
 
     //! builds the helper for a specific subset of trades stored in the cube
     void build(const std::map<std::string, QuantLib::ext::shared_ptr<Trade>>& trades);
 
     const std::vector<Real>& upperBucketBound() const { return bucketing_.upperBucketBound(); }
-    //
+
+    //! pnl distribution for the given date index
     Array pnlDistribution(const Size date);
 
+    //! pnl distributions for several date indices, computed in one sweep over the paths
+    std::vector<Array> pnlDistributions(const std::vector<Size>& dates);
+
 private:
     /*! Get the transition matrix from today to date by entity,
       sanitise the annual transition matrix input,
@@ -81,37 +91,57 @@ private:
         using the simulated global state paths stored in the aggregation scenario data object */
     void init();
 
-    //! Allocate 3d storage for the simulated idiosyncratic factors by entity, date and sample
-    void initEntityStateSimulation();
-
     /*! Initialise the entity state simulationn for a given date for
         Evaluation = TerminalSimulation:
         Return transition matrix for each entity for the given date,
-        conditional on the global terminal state on the given path */
-    std::vector<Matrix> initEntityStateSimulation(const Size date, const Size path);
+        conditional on the global terminal state on the given path,
+        transMat holds the rescaled transition matrix by entity index */
+    std::vector<Matrix> initEntityStateSimulation(const Size date, const Size path,
+                                                  const std::vector<const Matrix*>& transMat) const;
 
-    /*! Generate one entity state sample path for all entities given the global state path
+    /*! Generate one entity state sample for all entities given the global state path
         and given the conditional transition matrices for all entities at the terminal date. */
-    void simulateEntityStates(const std::vector<Matrix>& cond, const Size path, const MersenneTwisterUniformRng& mt);
-
-    //! Look up the simulated entity credit state for the given entity, date and path
-    Size simulatedEntityState(const Size i, const Size path) const;
+    void simulateEntityStates(const std::vector<Matrix>& cond, const QuantExt::Philox4x32UniformRng& rng,
+                              std::vector<Size>& entityStates) const;
 
     /*! Return a single PnL impact due to credit migration or default of Bond/CDS issuers and default of
-      netting set counterparties on the given global path */
-    Real generateMigrationPnl(const Size date, const Size path, const Size n) const;
+      netting set counterparties on the given global path, given the simulated entity states */
+    Real generateMigrationPnl(const Size date, const Size path, const std::vector<Size>& entityStates) const;
 
     /*! Return a vector of PnL impacts and associated conditional probabilities for the specified global path,
-      due to credit migration or default of Bond/CDS issuers and default of netting set counterparties */
-    void generateConditionalMigrationPnl(const Size date, const Size path, const std::map<string, Matrix>& transMat,
+      due to credit migration or default of Bond/CDS issuers and default of netting set counterparties,
+      transMat holds the rescaled transition matrix by entity index */
+    void generateConditionalMigrationPnl(const Size date, const Size path, const std::vector<const Matrix*>& transMat,
                                          std::vector<Array>& condProbs, std::vector<Array>& pnl) const;
 
+    /*! Market pnl from t0 to each of the given dates on the given global path, the dates must be sorted, the
+      intermediate cashflows are accumulated in one sweep over the cube dates */
+    void marketPnl(const Size path, const std::vector<Size>& sortedDates, std::vector<Real>& cash) const;
+
+    // trade with issuer risk, with its cube index and the data needed in the pnl generation
+    struct IssuerTrade {
+        std::string id;
+        Size cubeIndex;
+        // bond notional and fx pair to convert it to base currency (empty if not needed), Null if not a bond
+        Real notional;
+        std::string ccyPair;
+        // entity index of the cpty if this is a cds with cpty in the list of entities, Null otherwise
+        Size cdsCptyIdx;
+    };
+
+    // trade entering the market pnl, with its cube index and credit curve (empty if none)
+    struct MarketTrade {
+        Size cubeIndex;
+        std::string creditCurve;
+    };
+
     QuantLib::ext::shared_ptr<CreditSimulationParameters> parameters_;
     QuantLib::ext::shared_ptr<NPVCube> cube_, nettedCube_;
     QuantLib::ext::shared_ptr<AggregationScenarioData> aggData_;
     Size cubeIndexCashflows_, cubeIndexStateNpvs_;
     Matrix globalFactorCorrelation_;
     std::string baseCurrency_;
+    QuantLib::ext::shared_ptr<QuantExt::WorkerPool> workerPool_;
 
     CreditMode creditMode_;
     LoanExposureMode loanExposureMode_;
@@ -120,23 +150,17 @@ private:
 
     QuantExt::Bucketing bucketing_;
 
-    std::vector<std::set<std::string>> issuerTradeIds_;
-    std::vector<std::set<std::string>> cptyNettingSetIds_;
-
-    std::map<std::string, std::string> tradeCreditCurves_;
-    std::map<std::string, Real> tradeNotionals_;
-    std::map<std::string, std::string> tradeCurrencies_;
-    std::map<std::string, Size> tradeCdsCptyIdx_;
+    // set by build(), by entity index resp. in the order of the cube ids
+    bool built_ = false;
+    std::vector<std::vector<IssuerTrade>> issuerTrades_;
+    std::vector<std::vector<Size>> cptyNettingSetIndices_;
+    std::vector<MarketTrade> marketTrades_;
 
     // Transition matrix rows
     Size n_;
     std::vector<std::map<string, Matrix>> rescaledTransitionMatrices_;
     // Variance of the systemic part (Y_i) of entity state X_i
     std::vector<Real> globalVar_;
-    // Storage for the simulated idiosyncratic factors Z by entity, sample number
-    std::vector<std::vector<Size>> simulatedEntityState_;
-
-    std::vector<std::vector<Matrix>> entityStateSimulationMatrices_;
     // Systemic part (Y_i) of entity state X_i by date index, entity index, sample number
     std::vector<std::vector<std::vector<Real>>> globalStates_;
 };
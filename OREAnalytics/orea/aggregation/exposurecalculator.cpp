@@ -17,7 +17,7 @@
 */
 
 #include <orea/aggregation/exposurecalculator.hpp>
-#include <orea/cube/inmemorycube.hpp>
+#include <orea/cube/contiguousinmemorycube.hpp>
 
 #include <ored/portfolio/structuredtradeerror.hpp>
 #include <ored/portfolio/trade.hpp>
@@ -25,6 +25,8 @@
 #include <ql/time/date.hpp>
 #include <ql/time/calendars/weekendsonly.hpp>
 
+#include <numeric>
+
 using namespace std;
 using namespace QuantLib;
 
@@ -38,22 +40,22 @@ ExposureCalculator::ExposureCalculator(
     const QuantLib::ext::shared_ptr<Market>& market, bool exerciseNextBreak, const string& baseCurrency,
     const string& configuration, const Real quantile, const CollateralExposureHelper::CalculationType calcType,
     const bool multiPath, const bool flipViewXVA, const bool exposureProfilesUseCloseOutValues, bool continueOnError,
-    bool useDoublePrecisionCubes)
+    bool useDoublePrecisionCubes, const QuantLib::ext::shared_ptr<QuantExt::WorkerPool>& workerPool)
     : portfolio_(portfolio), cube_(cube), cubeInterpretation_(cubeInterpretation),
       aggregationScenarioData_(aggregationScenarioData), market_(market), exerciseNextBreak_(exerciseNextBreak),
       baseCurrency_(baseCurrency), configuration_(configuration), quantile_(quantile), calcType_(calcType),
       multiPath_(multiPath), dates_(cube->dates()), today_(market_->asofDate()), dc_(ActualActual(ActualActual::ISDA)),
       flipViewXVA_(flipViewXVA), exposureProfilesUseCloseOutValues_(exposureProfilesUseCloseOutValues),
-      continueOnError_(continueOnError) {
+      continueOnError_(continueOnError), workerPool_(workerPool) {
 
     QL_REQUIRE(portfolio_, "portfolio is null");
 
     // EPE, ENE, allocatedEPE, allocatedENE
     if (useDoublePrecisionCubes) {
-        exposureCube_ = QuantLib::ext::make_shared<InMemoryCubeOpt<double>>(
+        exposureCube_ = QuantLib::ext::make_shared<ContiguousInMemoryCube<double>>(
             market->asofDate(), portfolio_->ids(), dates_, multiPath ? cube_->samples() : 1, EXPOSURE_CUBE_DEPTH);
     } else {
-        exposureCube_ = QuantLib::ext::make_shared<InMemoryCubeOpt<float>>(
+        exposureCube_ = QuantLib::ext::make_shared<ContiguousInMemoryCube<float>>(
             market->asofDate(), portfolio_->ids(), dates_, multiPath ? cube_->samples() : 1, EXPOSURE_CUBE_DEPTH);
     }
 
@@ -86,6 +88,27 @@ void ExposureCalculator::build() {
         included.
         This may effect DateGrids with daily data points*/
     const Date baselMaxEEPDate = WeekendsOnly().adjust(today + 1 * Years + 4 * Days);
+
+    /* The calculation is split into three steps
+       1) per trade set up, this requires the market and QuantLib's settings and therefore runs on this thread
+       2) aggregation over the samples, parallel over the dates if a worker pool is given; all results of this step
+          are indexed by date, and the trades are processed in the same order for each date, so the results do not
+          depend on the number of threads
+       3) per trade profiles that depend on the previous dates, this requires the market again */
+
+    struct TradeExposure {
+        string tradeId;
+        QuantLib::ext::shared_ptr<Trade> trade;
+        Size cubeIdx, exposureCubeIdx;
+        Date nextBreakDate;
+        vector<vector<Real>>* nettingSetDefaultValue;
+        vector<vector<Real>>* nettingSetCloseOutValue;
+        vector<vector<Real>>* nettingSetMporPositiveFlow;
+        vector<vector<Real>>* nettingSetMporNegativeFlow;
+        vector<Real> epe, ene, pfe;
+    };
+    vector<TradeExposure> tradeExposures;
+
     for (auto const& [tradeId, trade] : portfolio_->trades()) {
         string nettingSetId = trade->envelope().nettingSetId();
         std::size_t i = cube_->getTradeIndex(tradeId);
@@ -146,35 +169,49 @@ void ExposureCalculator::build() {
             }
         }
 
-        Handle<YieldTermStructure> curve = market_->discountCurve(baseCurrency_, configuration_);
         Real npv0;
         if (flipViewXVA_) {
             npv0 = -cube_->getT0(i);
         } else {
             npv0 = cube_->getT0(i);
         }
-        Real epe_b_runningSum = 0.0;
-        Real eepe_b_runningSum = 0.0;
-        vector<Real> epe(dates_.size() + 1, 0.0);
-        vector<Real> ene(dates_.size() + 1, 0.0);
-        vector<Real> ee_b(dates_.size() + 1, 0.0);
-        vector<Real> eee_b(dates_.size() + 1, 0.0);
-        vector<Real> pfe(dates_.size() + 1, 0.0);
-        vector<Real> epe_b(dates_.size() + 1, 0.0);
-        vector<Real> eepe_b(dates_.size() + 1, 0.0);
-        epe[0] = std::max(npv0, 0.0);
-        ene[0] = std::max(-npv0, 0.0);
-        ee_b[0] = epe[0];
-        eee_b[0] = ee_b[0];
-        epe_b[0] = ee_b[0];
-        eepe_b[0] = eee_b[0];
-        pfe[0] = std::max(npv0, 0.0);
-        exposureCube_->setT0(epe[0], tradeId, ExposureIndex::EPE);
-        exposureCube_->setT0(ene[0], tradeId, ExposureIndex::ENE);
-        for (Size j = 0; j < dates_.size(); ++j) {
+        TradeExposure t{tradeId,
+                        trade,
+                        i,
+                        exposureCube_->getTradeIndex(tradeId),
+                        nextBreakDate,
+                        &nettingSetDefaultValue_[nettingSetId],
+                        &nettingSetCloseOutValue_[nettingSetId],
+                        &nettingSetMporPositiveFlow_[nettingSetId],
+                        &nettingSetMporNegativeFlow_[nettingSetId],
+                        vector<Real>(dates_.size() + 1, 0.0),
+                        vector<Real>(dates_.size() + 1, 0.0),
+                        vector<Real>(dates_.size() + 1, 0.0)};
+        t.epe[0] = std::max(npv0, 0.0);
+        t.ene[0] = std::max(-npv0, 0.0);
+        t.pfe[0] = std::max(npv0, 0.0);
+        exposureCube_->setT0(t.epe[0], tradeId, ExposureIndex::EPE);
+        exposureCube_->setT0(t.ene[0], tradeId, ExposureIndex::ENE);
+        tradeExposures.push_back(std::move(t));
+    }
+
+    // buffers for the values of all samples on a date, read from / written to the cubes in bulk, one set per thread
+    struct SampleBuffers {
+        vector<Real> defaultValues, closeOutValues, positiveCashFlows, negativeCashFlows;
+        vector<Real> epeSamples, eneSamples, distribution;
+    };
+    vector<SampleBuffers> buffers(workerPool_ ? workerPool_->size() : 1);
+    const Size samples = cube_->samples();
+    const Size pfeIndex = Size(floor(quantile_ * (samples - 1) + 0.5));
+
+    auto aggregateDates = [&](Size dateBegin, Size dateEnd, Size threadIndex) {
+        SampleBuffers& b = buffers[threadIndex];
+        b.epeSamples.resize(samples);
+        b.eneSamples.resize(samples);
+        b.distribution.resize(samples);
+        for (Size j = dateBegin; j < dateEnd; ++j) {
             Date d = cube_->dates()[j];
-            vector<Real> distribution(cube_->samples(), 0.0);
-            for (Size k = 0; k < cube_->samples(); ++k) {
+            for (auto& t : tradeExposures) {
                 // RL 2020-07-17
                 // 1) If the calculation type is set to NoLag:
                 //    Collateral balances are NOT delayed by the MPoR, but we use the close-out NPV.
@@ -182,58 +219,93 @@ void ExposureCalculator::build() {
                 //    Collateral balances are delayed by the MPoR (if possible, i.e. the valuation
                 //    grid has MPoR spacing), and we use the default date NPV.
                 //    This is the treatment in the ORE releases up to June 2020).
-                Real defaultValue =
-                    d > nextBreakDate && exerciseNextBreak_ ? 0.0 : cubeInterpretation_->getDefaultNpv(cube_, i, j, k);
-                Real closeOutValue;
+                bool afterBreak = d > t.nextBreakDate && exerciseNextBreak_;
+                if (afterBreak)
+                    b.defaultValues.assign(samples, 0.0);
+                else
+                    cubeInterpretation_->getDefaultNpv(cube_, t.cubeIdx, j, b.defaultValues);
                 if (isRegularCubeStorage_ && j == dates_.size() - 1)
-                    closeOutValue = defaultValue;
+                    b.closeOutValues = b.defaultValues;
+                else if (afterBreak)
+                    b.closeOutValues.assign(samples, 0.0);
                 else
-                    closeOutValue = d > nextBreakDate && exerciseNextBreak_
-                                        ? 0.0
-                                        : cubeInterpretation_->getCloseOutNpv(cube_, i, j, k, aggregationScenarioData_);
-
-                Real positiveCashFlow = cubeInterpretation_->getMporPositiveFlows(cube_, i, j, k);
-                Real negativeCashFlow = cubeInterpretation_->getMporNegativeFlows(cube_, i, j, k);
-                // for single trade exposures, the default value is relevant, unless we force
-		// using the close out value instead
-                Real npv = exposureProfilesUseCloseOutValues_ ? closeOutValue : defaultValue;
-                epe[j + 1] += std::max(npv, 0.0) / cube_->samples();
-                ene[j + 1] += std::max(-npv, 0.0) / cube_->samples();
-                nettingSetDefaultValue_[nettingSetId][j][k] += defaultValue;
-                nettingSetCloseOutValue_[nettingSetId][j][k] += closeOutValue;
-                nettingSetMporPositiveFlow_[nettingSetId][j][k] += positiveCashFlow;
-                nettingSetMporNegativeFlow_[nettingSetId][j][k] += negativeCashFlow;
-                distribution[k] = npv;
+                    cubeInterpretation_->getCloseOutNpv(cube_, t.cubeIdx, j, aggregationScenarioData_,
+                                                        b.closeOutValues);
+                cubeInterpretation_->getMporPositiveFlows(cube_, t.cubeIdx, j, b.positiveCashFlows);
+                cubeInterpretation_->getMporNegativeFlows(cube_, t.cubeIdx, j, b.negativeCashFlows);
+
+                vector<Real>& nettingSetDefaultValue = (*t.nettingSetDefaultValue)[j];
+                vector<Real>& nettingSetCloseOutValue = (*t.nettingSetCloseOutValue)[j];
+                vector<Real>& nettingSetMporPositiveFlow = (*t.nettingSetMporPositiveFlow)[j];
+                vector<Real>& nettingSetMporNegativeFlow = (*t.nettingSetMporNegativeFlow)[j];
+                Real epeMean = 0.0, eneMean = 0.0;
+                for (Size k = 0; k < samples; ++k) {
+                    // for single trade exposures, the default value is relevant, unless we force
+                    // using the close out value instead
+                    Real npv = exposureProfilesUseCloseOutValues_ ? b.closeOutValues[k] : b.defaultValues[k];
+                    epeMean += std::max(npv, 0.0) / samples;
+                    eneMean += std::max(-npv, 0.0) / samples;
+                    nettingSetDefaultValue[k] += b.defaultValues[k];
+                    nettingSetCloseOutValue[k] += b.closeOutValues[k];
+                    nettingSetMporPositiveFlow[k] += b.positiveCashFlows[k];
+                    nettingSetMporNegativeFlow[k] += b.negativeCashFlows[k];
+                    b.distribution[k] = npv;
+                    b.epeSamples[k] = std::max(npv, 0.0);
+                    b.eneSamples[k] = std::max(-npv, 0.0);
+                }
+                t.epe[j + 1] = epeMean;
+                t.ene[j + 1] = eneMean;
                 if (multiPath_) {
-                    exposureCube_->set(std::max(npv, 0.0), tradeId, d, k, ExposureIndex::EPE);
-                    exposureCube_->set(std::max(-npv, 0.0), tradeId, d, k, ExposureIndex::ENE);
+                    exposureCube_->setSamples(b.epeSamples, t.exposureCubeIdx, j, ExposureIndex::EPE);
+                    exposureCube_->setSamples(b.eneSamples, t.exposureCubeIdx, j, ExposureIndex::ENE);
+                } else {
+                    exposureCube_->set(epeMean, t.exposureCubeIdx, j, 0, ExposureIndex::EPE);
+                    exposureCube_->set(eneMean, t.exposureCubeIdx, j, 0, ExposureIndex::ENE);
                 }
+                // the quantile only requires a partial sort of the distribution
+                std::nth_element(b.distribution.begin(), b.distribution.begin() + pfeIndex, b.distribution.end());
+                t.pfe[j + 1] = std::max(b.distribution[pfeIndex], 0.0);
             }
-            if (!multiPath_) {
-                exposureCube_->set(epe[j + 1], tradeId, d, 0, ExposureIndex::EPE);
-                exposureCube_->set(ene[j + 1], tradeId, d, 0, ExposureIndex::ENE);
-            }
-            ee_b[j + 1] = epe[j + 1] / curve->discount(cube_->dates()[j]);
+        }
+    };
+
+    if (workerPool_)
+        workerPool_->parallelFor(dates_.size(), 1, aggregateDates);
+    else
+        aggregateDates(0, dates_.size(), 0);
+
+    Handle<YieldTermStructure> curve = market_->discountCurve(baseCurrency_, configuration_);
+    for (auto& t : tradeExposures) {
+        Real epe_b_runningSum = 0.0;
+        Real eepe_b_runningSum = 0.0;
+        vector<Real> ee_b(dates_.size() + 1, 0.0);
+        vector<Real> eee_b(dates_.size() + 1, 0.0);
+        vector<Real> epe_b(dates_.size() + 1, 0.0);
+        vector<Real> eepe_b(dates_.size() + 1, 0.0);
+        ee_b[0] = t.epe[0];
+        eee_b[0] = ee_b[0];
+        epe_b[0] = ee_b[0];
+        eepe_b[0] = eee_b[0];
+        for (Size j = 0; j < dates_.size(); ++j) {
+            Date d = cube_->dates()[j];
+            ee_b[j + 1] = t.epe[j + 1] / curve->discount(cube_->dates()[j]);
             eee_b[j + 1] = std::max(eee_b[j], ee_b[j + 1]);
-            if (d <= trade->maturity()) {
+            if (d <= t.trade->maturity()) {
                 epe_b_runningSum += ee_b[j + 1] * timeDeltas[j];
                 eepe_b_runningSum += eee_b[j + 1] * timeDeltas[j];
                 epe_b[j + 1] = epe_b_runningSum / times[j];
                 eepe_b[j + 1] = eepe_b_runningSum / times[j];
                 if(d <= baselMaxEEPDate){
-                    epe_b_[tradeId] = epe_b[j + 1];
-                    eepe_b_[tradeId] = eepe_b[j + 1];
+                    epe_b_[t.tradeId] = epe_b[j + 1];
+                    eepe_b_[t.tradeId] = eepe_b[j + 1];
                 }
             }
-            std::sort(distribution.begin(), distribution.end());
-            Size index = Size(floor(quantile_ * (cube_->samples() - 1) + 0.5));
-            pfe[j + 1] = std::max(distribution[index], 0.0);
         }
-        ee_b_[tradeId] = ee_b;
-        eee_b_[tradeId] = eee_b;
-        pfe_[tradeId] = pfe;
-        epe_bTimeWeighted_[tradeId] = epe_b;
-        eepe_bTimeWeighted_[tradeId] = eepe_b;
+        ee_b_[t.tradeId] = ee_b;
+        eee_b_[t.tradeId] = eee_b;
+        pfe_[t.tradeId] = t.pfe;
+        epe_bTimeWeighted_[t.tradeId] = epe_b;
+        eepe_bTimeWeighted_[t.tradeId] = eepe_b;
     }
 }
 
@@ -241,11 +313,10 @@ vector<Real> ExposureCalculator::getMeanExposure(const string& tid, ExposureInde
     Size tidx = exposureCube_->getTradeIndex(tid);
     vector<Real> exp(dates_.size() + 1, 0.0);
     exp[0] = exposureCube_->getT0(tidx, index);
+    vector<Real> values;
     for (Size i = 0; i < dates_.size(); i++) {
-        for (Size k = 0; k < exposureCube_->samples(); k++) {
-            exp[i + 1] += exposureCube_->get(tidx, i, k, index);
-        }
-        exp[i + 1] /= exposureCube_->samples();
+        exposureCube_->getSamples(values, tidx, i, index);
+        exp[i + 1] = std::accumulate(values.begin(), values.end(), 0.0) / exposureCube_->samples();
     }
     return exp;
 }
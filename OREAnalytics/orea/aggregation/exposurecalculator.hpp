@@ -28,6 +28,8 @@
 #include <orea/cube/npvcube.hpp>
 #include <ored/portfolio/portfolio.hpp>
 
+#include <qle/utilities/workerpool.hpp>
+
 #include <ql/shared_ptr.hpp>
 
 namespace ore {
@@ -73,7 +75,9 @@ public:
         //! Continue with the calculation if possible when there is an error
         bool continueOnError = false,
         //! use double precision cube
-        bool useDoublePrecisionCubes = false);
+        bool useDoublePrecisionCubes = false,
+        //! if given, the aggregation over the samples runs in parallel over the dates
+        const QuantLib::ext::shared_ptr<QuantExt::WorkerPool>& workerPool = nullptr);
 
     virtual ~ExposureCalculator() {}
 
@@ -163,6 +167,7 @@ protected:
     bool flipViewXVA_;
     bool exposureProfilesUseCloseOutValues_ = false;
     bool continueOnError_;
+    QuantLib::ext::shared_ptr<QuantExt::WorkerPool> workerPool_;
 };
 
 } // namespace analytics
@@ -17,6 +17,7 @@
 */
 
 #include <orea/aggregation/nettedexposurecalculator.hpp>
+#include <orea/cube/contiguousinmemorycube.hpp>
 
 #include <ored/portfolio/trade.hpp>
 
@@ -24,6 +25,8 @@
 #include <ql/time/calendars/weekendsonly.hpp>
 #include <ql/time/date.hpp>
 
+#include <numeric>
+
 using namespace std;
 using namespace QuantLib;
 
@@ -47,7 +50,8 @@ NettedExposureCalculator::NettedExposureCalculator(
     const QuantLib::ext::shared_ptr<NPVCube>& tradeExposureCube, const Size allocatedEpeIndex,
     const Size allocatedEneIndex, const bool flipViewXVA, const bool withMporStickyDate,
     const MporCashFlowMode mporCashFlowMode, const bool firstMporCollateralAdjustment,
-    const bool exposureProfilesUseCloseOutValues, const bool useDoublePrecisionCubes)
+    const bool exposureProfilesUseCloseOutValues, const bool useDoublePrecisionCubes,
+    const QuantLib::ext::shared_ptr<QuantExt::WorkerPool>& workerPool)
     : portfolio_(portfolio), market_(market), cube_(cube), baseCurrency_(baseCurrency), configuration_(configuration),
       quantile_(quantile), calcType_(calcType), multiPath_(multiPath), nettingSetManager_(nettingSetManager),
       collateralBalances_(collateralBalances), nettingSetDefaultValue_(nettingSetDefaultValue),
@@ -59,7 +63,7 @@ NettedExposureCalculator::NettedExposureCalculator(
       allocatedEpeIndex_(allocatedEpeIndex), allocatedEneIndex_(allocatedEneIndex), flipViewXVA_(flipViewXVA),
       withMporStickyDate_(withMporStickyDate), mporCashFlowMode_(mporCashFlowMode),
       firstMporCollateralAdjustment_(firstMporCollateralAdjustment),
-      exposureProfilesUseCloseOutValues_(exposureProfilesUseCloseOutValues) {
+      exposureProfilesUseCloseOutValues_(exposureProfilesUseCloseOutValues), workerPool_(workerPool) {
 
     set<string> nettingSetIds;
     for (auto nettingSet : nettingSetDefaultValue) {
@@ -73,15 +77,15 @@ NettedExposureCalculator::NettedExposureCalculator(
 
     if(useDoublePrecisionCubes) {
         // Exposure after collateral
-        nettedCube_ = QuantLib::ext::make_shared<InMemoryCubeOpt<double>>(market_->asofDate(), nettingSetIds,
-                                                                          cube->dates(), cube->samples());
+        nettedCube_ = QuantLib::ext::make_shared<ContiguousInMemoryCube<double>>(market_->asofDate(), nettingSetIds,
+                                                                                 cube->dates(), cube->samples());
         // EPE, ENE
-        exposureCube_ = QuantLib::ext::make_shared<InMemoryCubeOpt<double>>(
+        exposureCube_ = QuantLib::ext::make_shared<ContiguousInMemoryCube<double>>(
             market_->asofDate(), nettingSetIds, cube->dates(), multiPath ? cube_->samples() : 1, EXPOSURE_CUBE_DEPTH);
     } else {
-        nettedCube_ = QuantLib::ext::make_shared<InMemoryCubeOpt<float>>(market_->asofDate(), nettingSetIds,
-                                                                         cube->dates(), cube->samples());
-        exposureCube_ = QuantLib::ext::make_shared<InMemoryCubeOpt<float>>(
+        nettedCube_ = QuantLib::ext::make_shared<ContiguousInMemoryCube<float>>(market_->asofDate(), nettingSetIds,
+                                                                                cube->dates(), cube->samples());
+        exposureCube_ = QuantLib::ext::make_shared<ContiguousInMemoryCube<float>>(
             market_->asofDate(), nettingSetIds, cube->dates(), multiPath ? cube_->samples() : 1, EXPOSURE_CUBE_DEPTH);
     }
 
@@ -137,9 +141,9 @@ void NettedExposureCalculator::build() {
     const Date baselMaxEEPDate = WeekendsOnly().adjust(today + 1 * Years + 4 * Days);
 
     Size nettingSetCount = 0;
-    for (auto n : nettingSetDefaultValue_) {
+    for (auto const& n : nettingSetDefaultValue_) {
         string nettingSetId = n.first;
-        vector<vector<Real>> data = n.second;
+        const vector<vector<Real>>* data = &n.second;
         QuantLib::ext::shared_ptr<NettingSetDefinition> netting = nettingSetManager_->get(nettingSetId);
 
         // retrieve collateral balances object, if possible
@@ -153,10 +157,10 @@ void NettedExposureCalculator::build() {
 	// using close-out values in the absence of an active CSA
         if ((netting->activeCsaFlag() || exposureProfilesUseCloseOutValues_) &&
 	    calcType_ == CollateralExposureHelper::CalculationType::NoLag) 
-            data = nettingSetCloseOutValue_[nettingSetId];
+            data = &nettingSetCloseOutValue_[nettingSetId];
         
-        vector<vector<Real>> nettingSetMporPositiveFlow = nettingSetMporPositiveFlow_[nettingSetId];
-        vector<vector<Real>> nettingSetMporNegativeFlow = nettingSetMporNegativeFlow_[nettingSetId];
+        const vector<vector<Real>>& nettingSetMporPositiveFlow = nettingSetMporPositiveFlow_[nettingSetId];
+        const vector<vector<Real>>& nettingSetMporNegativeFlow = nettingSetMporNegativeFlow_[nettingSetId];
 
         LOG("Aggregate exposure for netting set " << nettingSetId);
         // Get the collateral account balance paths for the netting set.
@@ -256,133 +260,156 @@ void NettedExposureCalculator::build() {
         exposureCube_->setT0(ene[0], nettingSetCount, ExposureIndex::ENE);
 
         std::string csaCurrency = netting->activeCsaFlag() ? netting->csaDetails()->csaCurrency() : std::string();
+        DayCounter csaDc = csaIndexName != "" ? csaIndex->dayCounter() : DayCounter(ActualActual(ActualActual::ISDA));
+        // don't apply initial margin without VM, i.e. inactive CSA
+        const vector<vector<Real>>* dynamicIM =
+            applyInitialMargin && !collateral.empty() ? &dimCalculator_->dynamicIM(nettingSetId) : nullptr;
+
+        // cube and trade exposure cube indices of the trades in the netting set, for the marginal allocation
+        vector<std::pair<Size, Size>> nettingSetTrades;
+        const Size nettingSetTradeCount = nettingSetSize[nettingSetId];
+        if (marginalAllocation_) {
+            for (auto const& [tradeId, trade] : portfolio_->trades()) {
+                if (trade->envelope().nettingSetId() == nettingSetId)
+                    nettingSetTrades.emplace_back(cube_->getTradeIndex(tradeId),
+                                                  tradeExposureCube_->getTradeIndex(tradeId));
+            }
+        }
 
-        for (Size j = 0; j < cube_->dates().size(); ++j) {
+        /* time weighted exposures after collateral and IM per block of dates and sample, the blocks are summed up
+           below, so only nDates / dateBlockSize sums per sample are held instead of the exposures per date */
+        const Size dateBlockSize = 4;
+        const Size nDateBlocks = (cube_->dates().size() + dateBlockSize - 1) / dateBlockSize;
+        vector<vector<Real>> positiveExposureSum(nDateBlocks, vector<Real>(cube_->samples(), 0.0));
+        vector<vector<Real>> negativeExposureSum(nDateBlocks, vector<Real>(cube_->samples(), 0.0));
+        vector<vector<Real>> distributions(workerPool_ ? workerPool_->size() : 1);
+        const Size pfeIndex = Size(floor(quantile_ * (cube_->samples() - 1) + 0.5));
+
+        // the trace output is written after the aggregation, the worker threads only store the values to log
+        struct SampleTrace {
+            Real mporCashFlow, dim, balance, exposure, dimEpe;
+        };
+        const bool traceSamples = Log::instance().enabled() && Log::instance().filter(ORE_DATA);
+        vector<vector<SampleTrace>> sampleTraces(traceSamples ? cube_->dates().size() : 0,
+                                                 vector<SampleTrace>(traceSamples ? cube_->samples() : 0));
+
+        /* The aggregation over the samples is parallel over the blocks of dates if a worker pool is given. All results
+           of this step are indexed by date or date block, the sums over the dates and blocks are taken afterwards on
+           this thread, so the results do not depend on the number of threads. */
+        auto aggregateDates = [&](Size dateBegin, Size dateEnd, Size threadIndex) {
+            vector<Real>& distribution = distributions[threadIndex];
+            vector<Real>& positiveSum = positiveExposureSum[dateBegin / dateBlockSize];
+            vector<Real>& negativeSum = negativeExposureSum[dateBegin / dateBlockSize];
+            distribution.resize(cube_->samples());
+            for (Size j = dateBegin; j < dateEnd; ++j) {
+
+                Date date = cube_->dates()[j];
+                Date prevDate = j > 0 ? cube_->dates()[j - 1] : today;
+                Real dcf = netting->activeCsaFlag() ? csaDc.yearFraction(prevDate, date) : 0.0;
+
+                for (Size k = 0; k < cube_->samples(); ++k) {
+                    Real balance = 0.0;
+                    if (!collateral.empty()) {
+                        balance = collateral[k]->accountBalance(date);
+                        if (csaCurrency != baseCurrency_) {
+                            // Convert from CSACurrency to baseCurrency
+                            double fxRate = scenarioData_->get(j, k, AggregationScenarioDataType::FXSpot, csaCurrency);
+                            balance *= fxRate;
+                        }
+                    }
 
-            Date date = cube_->dates()[j];
-            Date prevDate = j > 0 ? cube_->dates()[j - 1] : today;
+                    eab[j + 1] += balance / cube_->samples();
+
+                    Real mporCashFlow = 0;
+                    // If ActualDate is active, then the cash flows over mpor can be configured.
+                    // Otherwise (StickyDate is active), it is assumed that no cash flow over mpor is paid out.
+                    if (!withMporStickyDate_) {
+                        if (mporCashFlowMode_ == MporCashFlowMode::BothPay) {
+                            // in cube generation -actual date- the (+/-) cashflows over mpor are
+                            // payed out, i.e. are not part of the exposure .
+                            mporCashFlow = 0;
+                        } else if (mporCashFlowMode_ == MporCashFlowMode::NonePay) {
+                            // +/- cashflows is to be incorporated in the exposure
+                            mporCashFlow = (nettingSetMporPositiveFlow[j][k] + nettingSetMporNegativeFlow[j][k]);
+                        } else if (mporCashFlowMode_ ==
+                                   MporCashFlowMode::WePay) { 
+                            // only positive cash flows (i.e. cp's cashflows) is to be
+                            // incorporated in the exposure, since cp does not pay out cash
+                            // flows
+                            mporCashFlow = nettingSetMporPositiveFlow[j][k];
+                        } else if (mporCashFlowMode_ ==
+                                   MporCashFlowMode::TheyPay) { // onyl negative cash flows (i.e. our cashflows)  is to be
+                            // incorporated in the exposure,  ince we do not pay out cash
+                            // flows
+                            mporCashFlow = nettingSetMporNegativeFlow[j][k];
+                     
+                        }
+                    }
+                    if (netting->activeCsaFlag() && firstMporCollateralAdjustment_ && date <= endFirstMpor) {
+                        balance += initalVmCollateralMismatch;
+                    }
 
-            vector<Real> distribution(cube_->samples(), 0.0);
-            for (Size k = 0; k < cube_->samples(); ++k) {
-                Real balance = 0.0;
-                if (!collateral.empty()) {
-                    balance = collateral[k]->accountBalance(date);
-                    if (csaCurrency != baseCurrency_) {
-                        // Convert from CSACurrency to baseCurrency
-                        double fxRate = scenarioData_->get(j, k, AggregationScenarioDataType::FXSpot, csaCurrency);
-                        balance *= fxRate;
+                    Real exposure = (*data)[j][k] - balance + mporCashFlow;
+                    Real dim = 0.0;
+                    if (dynamicIM) { 
+                        // Initial Margin
+                        // Use IM to reduce exposure
+                        // Size dimIndex = j == 0 ? 0 : j - 1;
+                        Size dimIndex = j;
+                        dim = (*dynamicIM)[dimIndex][k];
+                        QL_REQUIRE(dim >= 0, "negative DIM for set " << nettingSetId << ", date " << j << ", sample " << k
+                                                                     << ": " << dim);
                     }
-                }
-                
-                eab[j + 1] += balance / cube_->samples();
-                
-                Real mporCashFlow = 0;
-                // If ActualDate is active, then the cash flows over mpor can be configured.
-                // Otherwise (StickyDate is active), it is assumed that no cash flow over mpor is paid out.
-                if (!withMporStickyDate_) {
-                    if (mporCashFlowMode_ == MporCashFlowMode::BothPay) {
-                        // in cube generation -actual date- the (+/-) cashflows over mpor are
-                        // payed out, i.e. are not part of the exposure .
-                        mporCashFlow = 0;
-                    } else if (mporCashFlowMode_ == MporCashFlowMode::NonePay) {
-                        // +/- cashflows is to be incorporated in the exposure
-                        mporCashFlow = (nettingSetMporPositiveFlow[j][k] + nettingSetMporNegativeFlow[j][k]);
-                    } else if (mporCashFlowMode_ ==
-                               MporCashFlowMode::WePay) { 
-                        // only positive cash flows (i.e. cp's cashflows) is to be
-                        // incorporated in the exposure, since cp does not pay out cash
-                        // flows
-                        mporCashFlow = nettingSetMporPositiveFlow[j][k];
-                    } else if (mporCashFlowMode_ ==
-                               MporCashFlowMode::TheyPay) { // onyl negative cash flows (i.e. our cashflows)  is to be
-                        // incorporated in the exposure,  ince we do not pay out cash
-                        // flows
-                        mporCashFlow = nettingSetMporNegativeFlow[j][k];
-                 
+                    Real dim_epe = 0;
+                    Real dim_ene = 0;
+                    if (initialMarginType != CSA::Type::PostOnly)
+                        dim_epe = dim;
+                    if (initialMarginType != CSA::Type::CallOnly)
+                        dim_ene = dim;
+
+                    // dim here represents the held IM, and is expressed as a positive number
+                    Real positiveExposure = std::max(exposure - dim_epe, 0.0);
+                    // dim here represents the posted IM, and is expressed as a positive number
+                    Real negativeExposure = std::max(-exposure - dim_ene, 0.0);
+                    epe[j + 1] += positiveExposure / cube_->samples(); 
+                    ene[j + 1] += negativeExposure / cube_->samples(); 
+                    positiveSum[k] += positiveExposure * timeDeltas[j];
+                    negativeSum[k] += negativeExposure * timeDeltas[j];
+                    distribution[k] = exposure - dim_epe;
+                    nettedCube_->set(exposure, nettingSetCount, j, k);
+
+                    if (traceSamples)
+                        sampleTraces[j][k] = {mporCashFlow, dim, balance, exposure, dim_epe};
+
+                    if (multiPath_) {
+                        exposureCube_->set(positiveExposure, nettingSetCount, j, k, ExposureIndex::EPE);
+                        exposureCube_->set(negativeExposure, nettingSetCount, j, k, ExposureIndex::ENE);
                     }
-                }
-                if (netting->activeCsaFlag() && firstMporCollateralAdjustment_ && date <= endFirstMpor) {
-                    balance += initalVmCollateralMismatch;
-                }
 
-                Real exposure = data[j][k] - balance + mporCashFlow;
-                Real dim = 0.0;
-                // don't apply initial margin without VM, i.e. inactive CSA
-                if (applyInitialMargin && !collateral.empty()) { 
-                    // Initial Margin
-                    // Use IM to reduce exposure
-                    // Size dimIndex = j == 0 ? 0 : j - 1;
-                    Size dimIndex = j;
-                    dim = dimCalculator_->dynamicIM(nettingSetId)[dimIndex][k];
-                    QL_REQUIRE(dim >= 0, "negative DIM for set " << nettingSetId << ", date " << j << ", sample " << k
-                                                                 << ": " << dim);
-                }
-                Real dim_epe = 0;
-                Real dim_ene = 0;
-                if (initialMarginType != CSA::Type::PostOnly)
-                    dim_epe = dim;
-                if (initialMarginType != CSA::Type::CallOnly)
-                    dim_ene = dim;
-                
-                // dim here represents the held IM, and is expressed as a positive number
-                epe[j + 1] += std::max(exposure - dim_epe, 0.0) / cube_->samples(); 
-                // dim here represents the posted IM, and is expressed as a positive number
-                ene[j + 1] += std::max(-exposure - dim_ene, 0.0) / cube_->samples(); 
-                distribution[k] = exposure - dim_epe;
-                nettedCube_->set(exposure, nettingSetCount, j, k);
-                
-                Real epeIncrement = std::max(exposure - dim_epe, 0.0) / cube_->samples();
-                TLOG("sample " << k << " date " << j << fixed << showpos << setprecision(2)
-                     << ": MporFLow " << setw(15) << mporCashFlow
-                     << ": Dim " << setw(15) << dim
-                     << ": Exposure " << setw(15) <<exposure
-                     << ": InitalCollateralMismatch " << setw(15) << initalVmCollateralMismatch
-                     << ": VM "  << setw(15) << balance
-                     << ": NPV " << setw(15) << data[j][k]
-                     << ": NPV-C " << setw(15) << distribution[k]
-                     << ": EPE " << setw(15) << epeIncrement);
-                
-                if (multiPath_) {
-                    exposureCube_->set(std::max(exposure - dim_epe, 0.0), nettingSetCount, j, k, ExposureIndex::EPE);
-                    exposureCube_->set(std::max(-exposure - dim_ene, 0.0), nettingSetCount, j, k, ExposureIndex::ENE);
-                }
- 
-                if (netting->activeCsaFlag()) {
-                    Real indexValue = 0.0;
-                    DayCounter dc = ActualActual(ActualActual::ISDA);
-                    if (csaIndexName != "") {
-                        indexValue = scenarioData_->get(j, k, AggregationScenarioDataType::IndexFixing, csaIndexName);
-                        dc = csaIndex->dayCounter();
+                    if (netting->activeCsaFlag()) {
+                        Real indexValue = 0.0;
+                        if (csaIndexName != "")
+                            indexValue = scenarioData_->get(j, k, AggregationScenarioDataType::IndexFixing, csaIndexName);
+                        Real collateralSpread = (balance >= 0.0 ? netting->csaDetails()->collatSpreadRcv() : netting->csaDetails()->collatSpreadPay());
+                        Real numeraire = scenarioData_->get(j, k, AggregationScenarioDataType::Numeraire);
+                        Real colvaDelta = -balance * collateralSpread * dcf / numeraire / cube_->samples();
+                        // intuitive floorDelta including collateralSpread would be:
+                        // -balance * (max(indexValue - collateralSpread,0) - (indexValue - collateralSpread)) * dcf /
+                        // samples
+                        Real floorDelta = -balance * std::max(-(indexValue - collateralSpread), 0.0) * dcf / numeraire / cube_->samples();
+                        colvaInc[j + 1] += colvaDelta;
+                        eoniaFloorInc[j + 1] += floorDelta;
                     }
-                    Real dcf = dc.yearFraction(prevDate, date);
-                    Real collateralSpread = (balance >= 0.0 ? netting->csaDetails()->collatSpreadRcv() : netting->csaDetails()->collatSpreadPay());
-                    Real numeraire = scenarioData_->get(j, k, AggregationScenarioDataType::Numeraire);
-                    Real colvaDelta = -balance * collateralSpread * dcf / numeraire / cube_->samples();
-                    // intuitive floorDelta including collateralSpread would be:
-                    // -balance * (max(indexValue - collateralSpread,0) - (indexValue - collateralSpread)) * dcf /
-                    // samples
-                    Real floorDelta = -balance * std::max(-(indexValue - collateralSpread), 0.0) * dcf / numeraire / cube_->samples();
-                    colvaInc[j + 1] += colvaDelta;
-                    colva_[nettingSetId] += colvaDelta;
-                    eoniaFloorInc[j + 1] += floorDelta;
-                    collateralFloor_[nettingSetId] += floorDelta;
-                }
 
-                if (marginalAllocation_) {
-                    for (auto const& [tradeId, trade] : portfolio_->trades()) {
-                        const string& nid = trade->envelope().nettingSetId();
-                        if (nid != nettingSetId)
-                            continue;
-                        std::size_t i = cube_->getTradeIndex(tradeId);
-                        std::size_t i2 = tradeExposureCube_->getTradeIndex(tradeId);
+                    for (auto const& [i, i2] : nettingSetTrades) {
                         Real allocation = 0.0;
                         if (balance == 0.0)
                             allocation = cubeInterpretation_->getDefaultNpv(cube_, i, j, k);
                         // else if (data[j][k] == 0.0)
-                        else if (fabs(data[j][k]) <= marginalAllocationLimit_)
-                            allocation = exposure / nettingSetSize[nid];
+                        else if (fabs((*data)[j][k]) <= marginalAllocationLimit_)
+                            allocation = exposure / nettingSetTradeCount;
                         else
-                            allocation = exposure * cubeInterpretation_->getDefaultNpv(cube_, i, j, k) / data[j][k];
+                            allocation = exposure * cubeInterpretation_->getDefaultNpv(cube_, i, j, k) / (*data)[j][k];
 
                         if (multiPath_) {
                             if (exposure > 0.0)
@@ -396,23 +423,45 @@ void NettedExposureCalculator::build() {
                                 averageNegativeAllocation[i2][j] -= allocation / cube_->samples();
                         }
                     }
+                } // for k cube->samples()
+                if (!multiPath_) {
+                    exposureCube_->set(epe[j + 1], nettingSetCount, j, 0, ExposureIndex::EPE);
+                    exposureCube_->set(ene[j + 1], nettingSetCount, j, 0, ExposureIndex::ENE);
                 }
+                // the quantile only requires a partial sort of the distribution
+                std::nth_element(distribution.begin(), distribution.begin() + pfeIndex, distribution.end());
+                pfe[j + 1] = std::max(distribution[pfeIndex], 0.0);
+            }
+        };
 
-                // expressions "exposure - dim_epe" and "-exposure - dim_ene" are taken from above
-                timeAveragedNettedExposure[k].positiveExposureBeforeCollateral +=
-                    std::max(0.0, data[j][k]) * timeDeltas[j];
-                timeAveragedNettedExposure[k].negativeExposureBeforeCollateral +=
-                    -std::max(0.0, -data[j][k]) * timeDeltas[j];
-                timeAveragedNettedExposure[k].positiveExposureAfterCollateral +=
-                    std::max(0.0, exposure - dim_epe) * timeDeltas[j];
-                timeAveragedNettedExposure[k].negativeExposureAfterCollateral +=
-                    -std::max(0.0, -exposure - dim_ene) * timeDeltas[j];
-
-            } // for k cube->samples()
-            if (!multiPath_) {
-                exposureCube_->set(epe[j + 1], nettingSetCount, j, 0, ExposureIndex::EPE);
-                exposureCube_->set(ene[j + 1], nettingSetCount, j, 0, ExposureIndex::ENE);
+        if (workerPool_) {
+            workerPool_->parallelFor(cube_->dates().size(), dateBlockSize, aggregateDates);
+        } else {
+            for (Size b = 0; b < nDateBlocks; ++b)
+                aggregateDates(b * dateBlockSize, std::min((b + 1) * dateBlockSize, cube_->dates().size()), 0);
+        }
+
+        if (traceSamples) {
+            for (Size j = 0; j < cube_->dates().size(); ++j) {
+                for (Size k = 0; k < cube_->samples(); ++k) {
+                    const SampleTrace& t = sampleTraces[j][k];
+                    TLOG("sample " << k << " date " << j << fixed << showpos << setprecision(2)
+                         << ": MporFLow " << setw(15) << t.mporCashFlow
+                         << ": Dim " << setw(15) << t.dim
+                         << ": Exposure " << setw(15) << t.exposure
+                         << ": InitalCollateralMismatch " << setw(15) << initalVmCollateralMismatch
+                         << ": VM "  << setw(15) << t.balance
+                         << ": NPV " << setw(15) << (*data)[j][k]
+                         << ": NPV-C " << setw(15) << t.exposure - t.dimEpe
+                         << ": EPE " << setw(15) << std::max(t.exposure - t.dimEpe, 0.0) / cube_->samples());
+                }
             }
+        }
+
+        for (Size j = 0; j < cube_->dates().size(); ++j) {
+            Date date = cube_->dates()[j];
+            colva_[nettingSetId] += colvaInc[j + 1];
+            collateralFloor_[nettingSetId] += eoniaFloorInc[j + 1];
             ee_b[j + 1] = epe[j + 1] / curve->discount(cube_->dates()[j]);
             eee_b[j + 1] = std::max(eee_b[j], ee_b[j + 1]);
             if(date <= nettingSetMaturity[nettingSetId]){
@@ -425,9 +474,19 @@ void NettedExposureCalculator::build() {
                     eepe_b_[nettingSetId] = eepe_b[j + 1];
                 }
             }
-            std::sort(distribution.begin(), distribution.end());
-            Size index = Size(floor(quantile_ * (cube_->samples() - 1) + 0.5));
-            pfe[j + 1] = std::max(distribution[index], 0.0);
+            for (Size k = 0; k < cube_->samples(); ++k) {
+                // positive / negative exposure as computed above
+                timeAveragedNettedExposure[k].positiveExposureBeforeCollateral +=
+                    std::max(0.0, (*data)[j][k]) * timeDeltas[j];
+                timeAveragedNettedExposure[k].negativeExposureBeforeCollateral +=
+                    -std::max(0.0, -(*data)[j][k]) * timeDeltas[j];
+            }
+        }
+        for (Size b = 0; b < nDateBlocks; ++b) {
+            for (Size k = 0; k < cube_->samples(); ++k) {
+                timeAveragedNettedExposure[k].positiveExposureAfterCollateral += positiveExposureSum[b][k];
+                timeAveragedNettedExposure[k].negativeExposureAfterCollateral += -negativeExposureSum[b][k];
+            }
         }
         ee_b_[nettingSetId] = ee_b;
         eee_b_[nettingSetId] = eee_b;
@@ -544,12 +603,11 @@ vector<Real> NettedExposureCalculator::getMeanExposure(const string& tid, Exposu
     std::size_t tidx = exposureCube_->getTradeIndex(tid);
     vector<Real> exp(cube_->dates().size() + 1, 0.0);
     exp[0] = exposureCube_->getT0(tid, index);
+    vector<Real> values;
     for (Size i = 0; i < cube_->dates().size(); i++) {
         if (multiPath_) {
-	        for (Size k = 0; k < exposureCube_->samples(); k++) {
-	            exp[i + 1] += exposureCube_->get(tidx, i, k, index);
-	        }
-	        exp[i + 1] /= exposureCube_->samples();
+            exposureCube_->getSamples(values, tidx, i, index);
+            exp[i + 1] = std::accumulate(values.begin(), values.end(), 0.0) / exposureCube_->samples();
 	    }
 	    else {
 	        exp[i + 1] = exposureCube_->get(tidx, i, 0, index);
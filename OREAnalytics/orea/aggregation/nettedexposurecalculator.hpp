@@ -69,7 +69,9 @@ public:
                              //  vm margin and mtm)  constant during first mpor period,
                              //  analog for overcollaterializations in case of negative mtm.
                              const bool firstMporCollateralAdjustment,
-                             const bool exposureProfilesUseCloseOutValues = false, const bool useDoublePrecisionCubes = false);
+                             const bool exposureProfilesUseCloseOutValues = false, const bool useDoublePrecisionCubes = false,
+                             //! if given, the aggregation over the samples runs in parallel over the dates
+                             const QuantLib::ext::shared_ptr<QuantExt::WorkerPool>& workerPool = nullptr);
 
     virtual ~NettedExposureCalculator() {}
     const QuantLib::ext::shared_ptr<NPVCube>& exposureCube() { return exposureCube_; }
@@ -170,6 +172,7 @@ protected:
     MporCashFlowMode mporCashFlowMode_;
     bool firstMporCollateralAdjustment_ = false;
     bool exposureProfilesUseCloseOutValues_ = false;
+    QuantLib::ext::shared_ptr<QuantExt::WorkerPool> workerPool_;
 };
 
 } // namespace analytics
@@ -72,7 +72,8 @@ PostProcess::PostProcess(const QuantLib::ext::shared_ptr<Portfolio>& portfolio,
                          const std::vector<Real>& creditMigrationDistributionGrid,
                          const std::vector<Size>& creditMigrationTimeSteps, const Matrix& creditStateCorrelationMatrix,
                          bool withMporStickyDate, MporCashFlowMode mporCashFlowMode,
-                         const bool firstMporCollateralAdjustment, bool continueOnError, bool useDoublePrecisionCubes)
+                         const bool firstMporCollateralAdjustment, bool continueOnError, bool useDoublePrecisionCubes,
+                         Size nThreads)
     : portfolio_(portfolio), nettingSetManager_(nettingSetManager), collateralBalances_(collateralBalances),
       market_(market), configuration_(configuration), cube_(cube), cptyCube_(cptyCube), scenarioData_(scenarioData),
       analytics_(analytics), baseCurrency_(baseCurrency), quantile_(quantile),
@@ -119,6 +120,12 @@ PostProcess::PostProcess(const QuantLib::ext::shared_ptr<Portfolio>& portfolio,
     Date today = market->asofDate();
     LOG("AsOfDate = " << QuantLib::io::iso_date(today));
 
+    QuantLib::ext::shared_ptr<QuantExt::WorkerPool> workerPool;
+    if (nThreads > 1) {
+        LOG("Exposure aggregation uses " << nThreads << " threads");
+        workerPool = QuantLib::ext::make_shared<QuantExt::WorkerPool>(nThreads);
+    }
+
     /***************************************************************
      * Step 1: Dynamic Initial Margin calculation
      * Fills DIM cube per netting set that can be
@@ -142,7 +149,7 @@ PostProcess::PostProcess(const QuantLib::ext::shared_ptr<Portfolio>& portfolio,
     exposureCalculator_ = QuantLib::ext::make_shared<ExposureCalculator>(
         portfolio, cube_, cubeInterpretation_, scenarioData_, market_, analytics_["exerciseNextBreak"], baseCurrency_,
         configuration_, quantile_, calcType_, analytics_["dynamicCredit"], analytics_["flipViewXVA"],
-        analytics_["exposureProfilesUseCloseOutValues"], continueOnError_, useDoublePrecisionCubes_);
+        analytics_["exposureProfilesUseCloseOutValues"], continueOnError_, useDoublePrecisionCubes_, workerPool);
     exposureCalculator_->build();
 
     /******************************************************************
@@ -167,7 +174,7 @@ PostProcess::PostProcess(const QuantLib::ext::shared_ptr<Portfolio>& portfolio,
         allocationMethod == ExposureAllocator::AllocationMethod::Marginal, marginalAllocationLimit,
         exposureCalculator_->exposureCube(), ExposureCalculator::allocatedEPE, ExposureCalculator::allocatedENE,
         analytics_["flipViewXVA"], withMporStickyDate_, mporCashFlowMode_, firstMporCollateralAdjustment_,
-        analytics_["exposureProfilesUseCloseOutValues"], useDoublePrecisionCubes_);
+        analytics_["exposureProfilesUseCloseOutValues"], useDoublePrecisionCubes_, workerPool);
     nettedExposureCalculator_->build();
 
     /********************************************************
@@ -293,7 +300,7 @@ PostProcess::PostProcess(const QuantLib::ext::shared_ptr<Portfolio>& portfolio,
         creditMigrationCalculator_ = QuantLib::ext::make_shared<CreditMigrationCalculator>(
             portfolio_, creditSimulationParameters_, cube_, cubeInterpretation_,
             nettedExposureCalculator_->nettedCube(), scenarioData_, creditMigrationDistributionGrid_,
-            creditMigrationTimeSteps_, creditStateCorrelationMatrix_, baseCurrency_);
+            creditMigrationTimeSteps_, creditStateCorrelationMatrix_, baseCurrency_, workerPool);
         creditMigrationCalculator_->build();
         creditMigrationUpperBucketBounds_ = creditMigrationCalculator_->upperBucketBounds();
         creditMigrationCdf_ = creditMigrationCalculator_->cdf();
@@ -179,7 +179,9 @@ public:
         //! Continue with the calculation if possible when there is an error
         bool continueOnError = false,
         //! use double precision cubes
-        bool useDoublePrecisionCubes = false);
+        bool useDoublePrecisionCubes = false,
+        //! number of threads for the trade and netting set exposure aggregation
+        Size nThreads = 1);
 
     void setDimCalculator(QuantLib::ext::shared_ptr<DynamicInitialMarginCalculator> dimCalculator) {
         dimCalculator_ = dimCalculator;
@@ -261,7 +261,8 @@ void Analytic::buildMarket(const QuantLib::ext::shared_ptr<ore::data::InMemoryLo
             market_ = QuantLib::ext::make_shared<TodaysMarket>(
                 configurations().asofDate, configurations().todaysMarketParams, loader_, configurations().curveConfig,
                 inputs()->continueOnError(), false, inputs()->lazyMarketBuilding(), inputs()->refDataManager(), false,
-                inputs()->iborFallbackConfig(), true, true, inputs()->useAtParCouponsCurves());
+                inputs()->iborFallbackConfig(), true, true, inputs()->useAtParCouponsCurves(),
+                inputs()->marketBuildThreads());
         } catch (const std::exception& e) {
             if (marketRequired) {
                 stopTimer("buildMarket()");
@@ -288,6 +289,7 @@ void Analytic::buildPortfolio(const bool emitStructuredError) {
     startTimer("buildPortfolio()");
     
     portfolio_->setBuildFailedTrades(inputs()->buildFailedTrades());
+    portfolio_->setThreads(inputs()->portfolioThreads());
     portfolio_->reset();
     
     if (market_) {
@@ -171,6 +171,8 @@ void PricingAnalyticImpl::runAnalytic(
                 LOG("Multi-threaded sensi analysis created");
             }
 
+            sensiAnalysis_->skipIndependentTrades(inputs_->sensiSkipIndependentTrades());
+
             if (offsetScenario_ != nullptr) {
                 sensiAnalysis_->setOffsetScenario(offsetScenario_);
                 sensiAnalysis_->setOffsetSimMarketParams(offsetSimMarketParams_);
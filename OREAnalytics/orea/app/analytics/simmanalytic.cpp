@@ -76,7 +76,10 @@ void SimmAnalyticImpl::runAnalytic(const QuantLib::ext::shared_ptr<ore::data::In
                                                    inputs_->simmResultCurrency(),
                                                    analytic()->market(),
                                                    simmAnalytic->determineWinningRegulations(),
-                                                   inputs_->enforceIMRegulations());
+                                                   inputs_->enforceIMRegulations(),
+                                                   false,
+                                                   {},
+                                                   inputs_->simmThreads());
     CONSOLE("OK");    
     analytic()->addTimer("SimmCalculator", simm->timer());
 
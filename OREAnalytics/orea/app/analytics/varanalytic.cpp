@@ -136,8 +136,8 @@ void ParametricVarAnalyticImpl::setVarReport(const QuantLib::ext::shared_ptr<ore
         QuantLib::ext::shared_ptr<ScenarioShiftCalculator> shiftCalculator = QuantLib::ext::make_shared<ScenarioShiftCalculator>(
             analytic()->configurations().sensiScenarioData, analytic()->configurations().simMarketParams);
 
-        std::unique_ptr<MarketRiskReport::SensiRunArgs> sensiArgs =
-            std::make_unique<MarketRiskReport::SensiRunArgs>(ss, shiftCalculator, 0.01, inputs_->covarianceData());
+        std::unique_ptr<MarketRiskReport::SensiRunArgs> sensiArgs = std::make_unique<MarketRiskReport::SensiRunArgs>(
+            ss, shiftCalculator, 0.01, inputs_->covarianceData(), inputs_->covarianceDecayFactor());
 
         varReport_ = ext::make_shared<ParametricVarReport>(
             inputs_->baseCurrency(), analytic()->portfolio(), inputs_->portfolioFilter(), scenarios,
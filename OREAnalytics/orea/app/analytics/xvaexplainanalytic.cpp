@@ -139,11 +139,11 @@ XvaExplainResults::XvaExplainResults(const QuantLib::ext::shared_ptr<InMemoryRep
     size_t cvaColumn = xvaReport->columnPosition("CVA");
     for (size_t i = 0; i < xvaReport->rows(); ++i) {
 
-        const std::string& scenario = boost::get<std::string>(xvaReport->data(scenarioIdColumn, i));
+        const std::string scenario = boost::get<std::string>(xvaReport->data(scenarioIdColumn, i));
 
-        const std::string& tradeId = boost::get<std::string>(xvaReport->data(tradeIdColumn, i));
+        const std::string tradeId = boost::get<std::string>(xvaReport->data(tradeIdColumn, i));
 
-        const std::string& nettingset = boost::get<std::string>(xvaReport->data(nettingSetIdColumn, i));
+        const std::string nettingset = boost::get<std::string>(xvaReport->data(nettingSetIdColumn, i));
 
         const double cva = boost::get<double>(xvaReport->data(cvaColumn, i));
 
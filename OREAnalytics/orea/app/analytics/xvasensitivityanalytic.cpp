@@ -49,8 +49,8 @@ XvaResults::XvaResults(const QuantLib::ext::shared_ptr<InMemoryReport>& xvaRepor
     size_t fcaColumn = xvaReport->columnPosition("FCA");
 
     for (size_t i = 0; i < xvaReport->rows(); ++i) {
-        const std::string& tradeId = boost::get<std::string>(xvaReport->data(tradeIdColumn, i));
-        const std::string& nettingset = boost::get<std::string>(xvaReport->data(nettingSetIdColumn, i));
+        const std::string tradeId = boost::get<std::string>(xvaReport->data(tradeIdColumn, i));
+        const std::string nettingset = boost::get<std::string>(xvaReport->data(nettingSetIdColumn, i));
         const double cva = boost::get<double>(xvaReport->data(cvaColumn, i));
         const double dva = boost::get<double>(xvaReport->data(dvaColumn, i));
         const double fba = boost::get<double>(xvaReport->data(fbaColumn, i));
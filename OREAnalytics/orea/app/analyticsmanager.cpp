@@ -20,19 +20,27 @@
 #include <orea/app/analyticsmanager.hpp>
 #include <orea/app/reportwriter.hpp>
 #include <orea/app/structuredanalyticserror.hpp>
+#include <orea/engine/observationmode.hpp>
 
 #include <ored/utilities/log.hpp>
 #include <ored/utilities/to_string.hpp>
+#include <ored/utilities/workerthreadstate.hpp>
 
 #include <ql/errors.hpp>
 
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <numeric>
+#include <thread>
+
 using namespace std;
 using namespace boost::filesystem;
 using ore::data::InMemoryReport;
 
 namespace ore {
 namespace analytics {
-    
+
 void AnalyticsManager::initialise() {
     for (const auto& a : inputs_->analytics()) 
         auto ap = AnalyticFactory::instance().build(a, inputs_, shared_from_this(), true);
@@ -145,20 +153,22 @@ void AnalyticsManager::runAnalytics(
     }
 
     // run requested analytics
-    for (auto a : analytics_) {
-        LOG("run analytic with label '" << a.first << "'");
-        a.second->startTimer("Run " + a.second->label() + "Analytic");
-        try {
-            a.second->runAnalytic(marketDataLoader_->loader(), inputs_->analytics());
-        } catch (const exception& e) {
-            failedAnalytics_.push_back(a.first);
-            StructuredAnalyticsErrorMessage(a.first, "Failed Analytic", e.what());
+    Timer managerTimer;
+    managerTimer.start("Run analytics");
+    if (inputs_->analyticsThreads() > 1 && analytics_.size() > 1 &&
+        runAnalyticsConcurrently(inputs_->analyticsThreads())) {
+        // populate the market calibration reports in the order of registration, as in a sequential run
+        for (auto a : analytics_)
+            a.second->marketCalibration(marketCalibrationReport);
+    } else {
+        for (auto a : analytics_) {
+            if (!runAnalytic(a.first, a.second))
+                failedAnalytics_.push_back(a.first);
+            // then populate the market calibration report if required
+            a.second->marketCalibration(marketCalibrationReport);
         }
-        a.second->stopTimer("Run " + a.second->label() + "Analytic");
-        LOG("run analytic with label '" << a.first << "' finished.");
-        // then populate the market calibration report if required
-        a.second->marketCalibration(marketCalibrationReport);
     }
+    managerTimer.stop("Run analytics");
 
     if (inputs_->portfolio()) {
         auto pricingStatsReport = QuantLib::ext::make_shared<InMemoryReport>(inputs_->reportBufferSize());
@@ -173,6 +183,9 @@ void AnalyticsManager::runAnalytics(
             timer.addTimer(a.first, analyticTimer);
         }
     }
+    // the wall time of all analytics, in a concurrent run this is less than the sum of the single analytics' times
+    if (!timer.empty())
+        timer.addTimer("AnalyticsManager", managerTimer);
     if (!timer.empty()) {
         auto runTimesReport = QuantLib::ext::make_shared<InMemoryReport>();
         ReportWriter(inputs_->reportNaString()).writeRunTimes(*runTimesReport, timer);
@@ -194,6 +207,218 @@ void AnalyticsManager::runAnalytics(
     inputs_->writeOutParameters();
 }
 
+bool AnalyticsManager::runAnalytic(const std::string& label, const QuantLib::ext::shared_ptr<Analytic>& analytic) {
+    bool success = true;
+    LOG("run analytic with label '" << label << "'");
+    analytic->startTimer("Run " + analytic->label() + "Analytic");
+    try {
+        analytic->runAnalytic(marketDataLoader_->loader(), inputs_->analytics());
+    } catch (const exception& e) {
+        success = false;
+        StructuredAnalyticsErrorMessage(label, "Failed Analytic", e.what());
+    }
+    analytic->stopTimer("Run " + analytic->label() + "Analytic");
+    LOG("run analytic with label '" << label << "' finished.");
+    return success;
+}
+
+bool AnalyticsManager::runAnalyticsConcurrently(const Size nThreads) {
+
+#ifndef QL_ENABLE_SESSIONS
+    WLOG("AnalyticsManager: running analytics concurrently requires QuantLib to be built with sessions, running "
+         "them sequentially.");
+    return false;
+#else
+
+    const Size n = analytics_.size();
+
+    // the analytics each analytic depends on, directly or indirectly
+
+    std::vector<std::set<const Analytic*>> dependents(n);
+    for (Size i = 0; i < n; ++i) {
+        for (auto const& d : analytics_[i].second->allDependentAnalytics())
+            dependents[i].insert(d.get());
+    }
+
+    /* build the dag: j has to complete before i is started, if j is a dependent analytic of i or if i and j share a
+       dependent analytic and j was registered before i (and is not depending on i itself) */
+
+    std::vector<std::vector<Size>> successors(n);
+    std::vector<Size> nPredecessors(n, 0);
+    for (Size i = 0; i < n; ++i) {
+        for (Size j = 0; j < n; ++j) {
+            if (i == j)
+                continue;
+            bool edge = dependents[i].find(analytics_[j].second.get()) != dependents[i].end();
+            if (!edge && j < i && dependents[j].find(analytics_[i].second.get()) == dependents[j].end()) {
+                edge = std::any_of(dependents[i].begin(), dependents[i].end(),
+                                   [&dependents, j](const Analytic* a) { return dependents[j].count(a) > 0; });
+            }
+            if (edge) {
+                successors[j].push_back(i);
+                ++nPredecessors[i];
+            }
+        }
+    }
+
+    // check that the graph is acyclic
+
+    {
+        std::vector<Size> np(nPredecessors), ready;
+        Size count = 0;
+        for (Size i = 0; i < n; ++i)
+            if (np[i] == 0)
+                ready.push_back(i);
+        while (!ready.empty()) {
+            Size i = ready.back();
+            ready.pop_back();
+            ++count;
+            for (auto s : successors[i])
+                if (--np[s] == 0)
+                    ready.push_back(s);
+        }
+        if (count != n) {
+            WLOG("AnalyticsManager: cyclic dependencies between analytics, running them sequentially.");
+            return false;
+        }
+    }
+
+    /* group the analytics that are connected in the dag, the analytics of a group are run one after the other and
+       may see each other's changes to the inputs, as in a sequential run */
+
+    std::vector<Size> group(n);
+    std::iota(group.begin(), group.end(), 0);
+    std::function<Size(Size)> root = [&group, &root](Size i) { return group[i] == i ? i : group[i] = root(group[i]); };
+    for (Size j = 0; j < n; ++j)
+        for (auto i : successors[j])
+            group[root(i)] = root(j);
+
+    /* give each group its own copy of the inputs, including the input portfolio, the sensitivity stream and the
+       scenario reader, and each analytic its own copy of its portfolio, so that the inputs are not changed, the trades
+       are not built concurrently and the streams are not read concurrently */
+
+    std::map<Size, QuantLib::ext::shared_ptr<InputParameters>> inputsCopies;
+    std::map<const Analytic*, QuantLib::ext::shared_ptr<ore::data::Portfolio>> portfolioCopies;
+    try {
+        for (Size i = 0; i < n; ++i) {
+            if (inputsCopies.count(root(i)) == 0)
+                inputsCopies[root(i)] = inputs_->copy();
+        }
+        for (auto const& a : analytics_) {
+            std::vector<QuantLib::ext::shared_ptr<Analytic>> all = a.second->allDependentAnalytics();
+            all.push_back(a.second);
+            for (auto const& b : all) {
+                if (!b->portfolio() || b->portfolio()->empty() || portfolioCopies.count(b.get()) > 0)
+                    continue;
+                auto p = QuantLib::ext::make_shared<ore::data::Portfolio>(b->portfolio()->buildFailedTrades());
+                p->fromXMLString(b->portfolio()->toXMLString());
+                portfolioCopies[b.get()] = p;
+            }
+        }
+    } catch (const std::exception& e) {
+        WLOG("AnalyticsManager: could not copy inputs (" << e.what() << "), running analytics sequentially.");
+        return false;
+    }
+    std::map<Analytic*, QuantLib::ext::shared_ptr<InputParameters>> originalInputs;
+    for (Size i = 0; i < n; ++i) {
+        std::vector<QuantLib::ext::shared_ptr<Analytic>> all = analytics_[i].second->allDependentAnalytics();
+        all.push_back(analytics_[i].second);
+        for (auto const& b : all) {
+            if (auto p = portfolioCopies.find(b.get()); p != portfolioCopies.end())
+                b->setPortfolio(p->second);
+            originalInputs.insert(std::make_pair(b.get(), b->inputs()));
+            b->setInputs(inputsCopies[root(i)]);
+            if (b->impl())
+                b->impl()->setInputs(inputsCopies[root(i)]);
+        }
+    }
+
+    // run the analytics, a thread picks the next ready analytic with the lowest index
+
+    LOG("AnalyticsManager: run " << n << " analytics on " << std::min(nThreads, n) << " threads");
+
+    /* The market data loader is populated before and only read by the analytics. The reports of an analytic are
+       written by the thread running it, analytics sharing a dependent analytic are not run at the same time. */
+
+    auto threadState = ore::data::WorkerThreadState::fromCurrentThread();
+    auto observationMode = ObservationMode::instance().mode();
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::set<Size> ready;
+    Size nCompleted = 0;
+    std::vector<char> success(n, 0);
+    for (Size i = 0; i < n; ++i)
+        if (nPredecessors[i] == 0)
+            ready.insert(i);
+
+    auto worker = [this, &threadState, observationMode, &mutex, &cv, &ready, &nCompleted, &success, &successors,
+                   &nPredecessors, n]() {
+        threadState.apply();
+        ObservationMode::instance().setMode(observationMode);
+        for (;;) {
+            Size i;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [&ready, &nCompleted, n] { return !ready.empty() || nCompleted == n; });
+                if (ready.empty())
+                    return;
+                i = *ready.begin();
+                ready.erase(ready.begin());
+            }
+            bool s = runAnalytic(analytics_[i].first, analytics_[i].second);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                success[i] = s;
+                ++nCompleted;
+                for (auto j : successors[i])
+                    if (--nPredecessors[j] == 0)
+                        ready.insert(j);
+            }
+            cv.notify_all();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (Size t = 0; t < std::min(nThreads, n); ++t)
+        threads.emplace_back(worker);
+    for (auto& t : threads)
+        t.join();
+
+    for (Size i = 0; i < n; ++i)
+        if (!success[i])
+            failedAnalytics_.push_back(analytics_[i].first);
+
+    for (auto const& [analytic, inputs] : originalInputs) {
+        analytic->setInputs(inputs);
+        if (analytic->impl())
+            analytic->impl()->setInputs(inputs);
+    }
+
+    // add the pricing stats of the copies to the trades of the input portfolio
+
+    std::vector<QuantLib::ext::shared_ptr<ore::data::Portfolio>> copies;
+    for (auto const& [_, p] : portfolioCopies)
+        copies.push_back(p);
+    for (auto const& [_, i] : inputsCopies) {
+        if (i->portfolio())
+            copies.push_back(i->portfolio());
+    }
+    if (auto portfolio = inputs_->portfolio()) {
+        for (auto const& p : copies) {
+            for (auto const& [tradeId, trade] : p->trades()) {
+                if (!portfolio->has(tradeId))
+                    continue;
+                auto t = portfolio->get(tradeId);
+                t->resetPricingStats(t->getNumberOfPricings() + trade->getNumberOfPricings(),
+                                     t->getCumulativePricingTime() + trade->getCumulativePricingTime());
+            }
+        }
+    }
+
+    return true;
+#endif
+}
+
 Analytic::analytic_reports const AnalyticsManager::reports() {
     Analytic::analytic_reports reports = reports_;
     for (auto a : analytics_) {
@@ -265,6 +490,7 @@ void AnalyticsManager::toFile(const ore::analytics::Analytic::analytic_reports&
         for (auto b : rep.second) {
             string reportName = b.first;
             QuantLib::ext::shared_ptr<InMemoryReport> report = b.second;
+            report->setThreads(inputs_->nThreads());
             string fileName;
             auto it = hits.find(reportName);
             QL_REQUIRE(it != hits.end(), "something wrong here");
@@ -53,6 +53,8 @@ public:
     Size numberOfAnalytics() { return analytics_.size(); }
     const QuantLib::ext::shared_ptr<InputParameters>& inputs() { return inputs_; }
     std::vector<QuantLib::ext::shared_ptr<ore::data::TodaysMarketParameters>> todaysMarketParams();
+    /*! Runs the registered analytics. If InputParameters::analyticsThreads() > 1, analytics that do not depend on each
+        other are run concurrently, see runAnalyticsConcurrently(). */
     void runAnalytics(const QuantLib::ext::shared_ptr<MarketCalibrationReportBase>& marketCalibrationReport = nullptr);
     void
     runAnalytics(const std::vector<QuantLib::ext::shared_ptr<MarketCalibrationReportBase>>& marketCalibrationReport);
@@ -79,6 +81,16 @@ public:
                 const std::set<std::string>& lowerHeaderReportNames = {});
 
 private:
+    //! run a single analytic, returns false if it failed
+    bool runAnalytic(const std::string& label, const QuantLib::ext::shared_ptr<Analytic>& analytic);
+    /*! Runs the analytics on nThreads threads. An analytic is started once all of its dependent analytics that are
+        registered in this manager have completed, analytics sharing a dependent analytic are run sequentially in the
+        order of registration. Each analytic is run on its own copy of the portfolio, the pricing stats of the copies
+        are added to the trades of the input portfolio afterwards. The analytics that depend on each other share a copy
+        of the inputs, see InputParameters::copy(), the analytics keep the inputs of this manager after the run.
+        Returns false if the analytics can not be run concurrently, nothing has been run in this case. */
+    bool runAnalyticsConcurrently(const QuantLib::Size nThreads);
+
     std::vector<std::pair<std::string, QuantLib::ext::shared_ptr<Analytic>>> analytics_;
     QuantLib::ext::shared_ptr<InputParameters> inputs_;
     QuantLib::ext::shared_ptr<MarketDataLoader> marketDataLoader_;
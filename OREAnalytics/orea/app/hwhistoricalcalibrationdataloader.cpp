@@ -17,6 +17,7 @@
 */
 
 #include <orea/app/hwhistoricalcalibrationdataloader.hpp>
+#include <orea/scenario/scenarioarchive.hpp>
 #include <orea/scenario/scenariofilereader.hpp>
 #include <orea/scenario/simplescenariofactory.hpp>
 #include <orea/scenario/scenarioloader.hpp>
@@ -47,9 +48,13 @@ HwHistoricalCalibrationDataLoader::HwHistoricalCalibrationDataLoader(const std::
 void HwHistoricalCalibrationDataLoader::loadFromScenarioFile(const std::string& fileName) {
     LOG("Load Historical time series data from scenario file " << fileName);
 
-    ext::shared_ptr<SimpleScenarioFactory> scenarioFactory = ext::make_shared<SimpleScenarioFactory>(false);
-    ext::shared_ptr<ScenarioFileReader> scenarioReader =
-        ext::make_shared<ScenarioFileReader>(fileName, scenarioFactory);
+    ext::shared_ptr<ScenarioReader> scenarioReader;
+    if (ScenarioArchive::isScenarioArchive(fileName)) {
+        scenarioReader = ext::make_shared<ScenarioArchiveReader>(fileName);
+    } else {
+        ext::shared_ptr<SimpleScenarioFactory> scenarioFactory = ext::make_shared<SimpleScenarioFactory>(false);
+        scenarioReader = ext::make_shared<ScenarioFileReader>(fileName, scenarioFactory);
+    }
     ext::shared_ptr<HistoricalScenarioLoader> historicalScenarioLoader =
         ext::make_shared<HistoricalScenarioLoader>(scenarioReader, startDate_, endDate_, NullCalendar());
 
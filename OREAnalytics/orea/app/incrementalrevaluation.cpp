@@ -0,0 +1,234 @@
+/*
+ Copyright (C) 2025 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+#include <orea/app/incrementalrevaluation.hpp>
+#include <orea/app/reportwriter.hpp>
+
+#include <ored/marketdata/todaysmarket.hpp>
+#include <ored/portfolio/structuredtradeerror.hpp>
+#include <ored/portfolio/tradefactory.hpp>
+#include <ored/utilities/log.hpp>
+#include <ored/utilities/xmlutils.hpp>
+
+#include <ql/quotes/simplequote.hpp>
+#include <ql/settings.hpp>
+
+using namespace ore::data;
+using namespace QuantLib;
+
+namespace ore {
+namespace analytics {
+
+namespace {
+
+// quotes that stay linked to the market objects built from them, see YieldCurve (piecewise curves with quote linkage
+// preserved) and the fx triangulation in TodaysMarket, all other quotes enter the market by value
+const std::set<MarketDatum::InstrumentType> linkedInstrumentTypes = {
+    MarketDatum::InstrumentType::MM,         MarketDatum::InstrumentType::MM_FUTURE,
+    MarketDatum::InstrumentType::OI_FUTURE,  MarketDatum::InstrumentType::FRA,
+    MarketDatum::InstrumentType::IMM_FRA,    MarketDatum::InstrumentType::IR_SWAP,
+    MarketDatum::InstrumentType::BASIS_SWAP, MarketDatum::InstrumentType::BMA_SWAP,
+    MarketDatum::InstrumentType::FX_SPOT,    MarketDatum::InstrumentType::FX_FWD,
+    MarketDatum::InstrumentType::CC_BASIS_SWAP, MarketDatum::InstrumentType::CC_FIX_FLOAT_SWAP};
+
+const std::string context = "incremental revaluation";
+
+// copy of a trade via its XML representation, so that building the copy does not change the caller's trade
+QuantLib::ext::shared_ptr<Trade> copyTrade(const QuantLib::ext::shared_ptr<Trade>& trade) {
+    XMLDocument doc;
+    auto copy = TradeFactory::instance().build(trade->tradeType());
+    copy->fromXML(trade->toXML(doc));
+    copy->id() = trade->id();
+    return copy;
+}
+
+} // namespace
+
+IncrementalRevaluation::TradeObserver::TradeObserver(const QuantLib::ext::shared_ptr<Trade>& trade) {
+    if (auto const& w = trade->instrument()) {
+        if (auto const& inst = w->qlInstrument())
+            registerWith(inst);
+        for (auto const& inst : w->additionalInstruments())
+            registerWith(inst);
+    }
+}
+
+IncrementalRevaluation::IncrementalRevaluation(const QuantLib::ext::shared_ptr<InputParameters>& inputs,
+                                               const QuantLib::ext::shared_ptr<InMemoryLoader>& loader)
+    : inputs_(inputs), loader_(loader) {
+    QL_REQUIRE(inputs_, "IncrementalRevaluation: inputs not set");
+    QL_REQUIRE(loader_, "IncrementalRevaluation: loader not set");
+    QL_REQUIRE(inputs_->todaysMarketParams(), "IncrementalRevaluation: todays market parameters not set");
+    QL_REQUIRE(loader_->hasQuotes(inputs_->asof()),
+               "IncrementalRevaluation: there are no quotes available for date " << inputs_->asof());
+
+    Settings::instance().evaluationDate() = inputs_->asof();
+
+    // the trades are copied, the portfolio of the inputs is not rebuilt against the resident market
+    portfolio_ = QuantLib::ext::make_shared<Portfolio>(inputs_->buildFailedTrades());
+    portfolio_->setThreads(inputs_->portfolioThreads());
+    if (inputs_->portfolio())
+        portfolio_->fromXMLString(inputs_->portfolio()->toXMLString());
+
+    buildMarket();
+    buildPortfolio();
+}
+
+void IncrementalRevaluation::buildMarket() {
+    LOG("IncrementalRevaluation: build market");
+    // preserve the quote linkage, so that the bootstrapped curves react to quote changes
+    market_ = QuantLib::ext::make_shared<TodaysMarket>(
+        inputs_->asof(), inputs_->todaysMarketParams(), loader_, inputs_->curveConfigs().get(),
+        inputs_->continueOnError(), false, inputs_->lazyMarketBuilding(), inputs_->refDataManager(), true,
+        inputs_->iborFallbackConfig(), false, true, inputs_->useAtParCouponsCurves(), inputs_->marketBuildThreads());
+
+    QuantLib::ext::shared_ptr<EngineData> edCopy = QuantLib::ext::make_shared<EngineData>(*inputs_->pricingEngine());
+    edCopy->globalParameters()["GenerateAdditionalResults"] = "false";
+    edCopy->globalParameters()["RunType"] = "NPV";
+    std::map<MarketContext, std::string> configurations;
+    configurations[MarketContext::irCalibration] = inputs_->marketConfig("lgmcalibration");
+    configurations[MarketContext::fxCalibration] = inputs_->marketConfig("fxcalibration");
+    configurations[MarketContext::pricing] = inputs_->marketConfig("pricing");
+    engineFactory_ = QuantLib::ext::make_shared<EngineFactory>(
+        edCopy, market_, configurations, inputs_->refDataManager(), inputs_->iborFallbackConfig());
+}
+
+void IncrementalRevaluation::buildPortfolio() {
+    LOG("IncrementalRevaluation: build portfolio with " << portfolio_->size() << " trades");
+    portfolio_->setBuildFailedTrades(inputs_->buildFailedTrades());
+    portfolio_->setThreads(inputs_->portfolioThreads());
+    portfolio_->reset();
+    portfolio_->build(engineFactory_, context, true, inputs_->useAtParCouponsTrades());
+    portfolio_->removeMatured(inputs_->asof());
+
+    observers_.clear();
+    npvs_.clear();
+    for (auto const& [tradeId, trade] : portfolio_->trades())
+        observe(trade);
+}
+
+void IncrementalRevaluation::observe(const QuantLib::ext::shared_ptr<Trade>& trade) {
+    observers_[trade->id()] = QuantLib::ext::make_shared<TradeObserver>(trade);
+}
+
+void IncrementalRevaluation::updateQuotes(const std::map<std::string, Real>& quotes) {
+    Size linked = 0;
+    for (auto const& [name, value] : quotes) {
+        if (!loader_->has(name, inputs_->asof())) {
+            DLOG("IncrementalRevaluation: add new quote " << name << ", requires market rebuild");
+            loader_->add(inputs_->asof(), name, value);
+            rebuildRequired_ = true;
+            continue;
+        }
+        auto md = loader_->get(name, inputs_->asof());
+        auto q = QuantLib::ext::dynamic_pointer_cast<SimpleQuote>(*md->quote());
+        QL_REQUIRE(q, "IncrementalRevaluation: quote " << name << " is not a simple quote, can not update it");
+        if (linkedInstrumentTypes.find(md->instrumentType()) != linkedInstrumentTypes.end()) {
+            ++linked;
+        } else if (!rebuildRequired_) {
+            DLOG("IncrementalRevaluation: quote " << name << " is not linked to the market, requires market rebuild");
+            rebuildRequired_ = true;
+        }
+        q->setValue(value);
+    }
+    LOG("IncrementalRevaluation: updated " << quotes.size() << " quotes (" << linked
+                                           << " linked), market rebuild required: " << std::boolalpha
+                                           << rebuildRequired_);
+}
+
+void IncrementalRevaluation::addTrade(const QuantLib::ext::shared_ptr<Trade>& trade) {
+    QL_REQUIRE(trade, "IncrementalRevaluation::addTrade(): trade is null");
+    auto t = copyTrade(trade);
+    auto [failed, success] = buildTrade(t, engineFactory_, context, false, inputs_->buildFailedTrades(), true,
+                                        inputs_->useAtParCouponsTrades());
+    if (!success) {
+        QL_REQUIRE(failed, "IncrementalRevaluation::addTrade(): failed to build trade '" << t->id() << "'");
+        t = failed;
+    }
+    if (portfolio_->has(t->id()))
+        portfolio_->remove(t->id());
+    portfolio_->add(t);
+    pendingRemovals_.erase(t->id());
+    observe(t);
+    DLOG("IncrementalRevaluation: added trade " << t->id());
+}
+
+bool IncrementalRevaluation::removeTrade(const std::string& tradeId) {
+    if (!portfolio_->remove(tradeId))
+        return false;
+    observers_.erase(tradeId);
+    npvs_.erase(tradeId);
+    pendingRemovals_.insert(tradeId);
+    DLOG("IncrementalRevaluation: removed trade " << tradeId);
+    return true;
+}
+
+const std::set<std::string>& IncrementalRevaluation::reprice() {
+    Settings::instance().evaluationDate() = inputs_->asof();
+
+    if (rebuildRequired_) {
+        buildMarket();
+        buildPortfolio();
+        rebuildRequired_ = false;
+        ++marketRebuilds_;
+    }
+
+    repricedTrades_.clear();
+    removedTrades_.swap(pendingRemovals_);
+    pendingRemovals_.clear();
+
+    for (auto const& [tradeId, trade] : portfolio_->trades()) {
+        auto o = observers_.find(tradeId);
+        QL_REQUIRE(o != observers_.end(), "IncrementalRevaluation: no observer for trade " << tradeId);
+        if (!o->second->dirty)
+            continue;
+        o->second->dirty = false;
+        Real npv = Null<Real>();
+        try {
+            npv = trade->instrument()->NPV();
+        } catch (const std::exception& e) {
+            StructuredTradeErrorMessage(trade, "Error during trade pricing", e.what()).log();
+            // the instrument is not calculated and will not notify again, so we keep the trade marked
+            o->second->dirty = true;
+        }
+        npvs_[tradeId] = npv;
+        repricedTrades_.insert(tradeId);
+    }
+
+    LOG("IncrementalRevaluation: repriced " << repricedTrades_.size() << " out of " << portfolio_->size()
+                                            << " trades, " << removedTrades_.size() << " trades removed");
+    return repricedTrades_;
+}
+
+QuantLib::ext::shared_ptr<Portfolio> IncrementalRevaluation::repricedPortfolio() const {
+    auto p = QuantLib::ext::make_shared<Portfolio>(inputs_->buildFailedTrades());
+    for (auto const& tradeId : repricedTrades_) {
+        if (auto t = portfolio_->get(tradeId))
+            p->add(t);
+    }
+    return p;
+}
+
+void IncrementalRevaluation::writeNpvReport(Report& report) {
+    reprice();
+    // the trades not repriced above return their cached npvs
+    ReportWriter().writeNpv(report, inputs_->baseCurrency(), market_, inputs_->marketConfig("pricing"), portfolio_);
+}
+
+} // namespace analytics
+} // namespace ore
@@ -0,0 +1,127 @@
+/*
+ Copyright (C) 2025 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+/*! \file orea/app/incrementalrevaluation.hpp
+    \brief resident market and portfolio that are revalued incrementally on quote and trade changes
+    \ingroup app
+*/
+
+#pragma once
+
+#include <orea/app/inputparameters.hpp>
+
+#include <ored/marketdata/inmemoryloader.hpp>
+#include <ored/marketdata/market.hpp>
+#include <ored/portfolio/enginefactory.hpp>
+#include <ored/portfolio/portfolio.hpp>
+#include <ored/report/report.hpp>
+
+#include <ql/patterns/observable.hpp>
+
+#include <map>
+#include <set>
+#include <string>
+
+namespace ore {
+namespace analytics {
+
+//! Incremental revaluation of a resident portfolio
+/*! The market is built once from the given loader, keeping yield curves linked to the loader's quotes, and the
+    portfolio from the inputs is built once against it. Afterwards quote changes and trade additions, amendments and
+    removals can be applied and reprice() only reprices the trades that are affected by the changes since the last
+    call.
+
+    Changes to quotes the linked market objects are built from (money market, futures, FRA, swap, basis swap and fx
+    forward quotes bootstrapping a piecewise yield curve and fx spots) only trigger the re-bootstrap of the curves
+    depending on these quotes, and only the trades observing these curves are repriced. All other market objects are
+    built from the quote values (e.g. volatility, default and inflation curves), a change to such a quote (or a quote
+    that is not known to the loader yet) triggers a full rebuild of the market and the portfolio on the next call to
+    reprice(), see marketRebuilds().
+
+    Only the todays market is kept resident, there is no resident scenario sim market, and sensitivities are not kept
+    resident either. The trades repriced by the last call to reprice() are available as a portfolio though, so that a
+    sensitivity analysis can be run on this subset only and merged with earlier results.
+
+    The trades of the inputs' portfolio and the trades passed to addTrade() are copied, i.e. the caller's trades are
+    not built against the resident market.
+
+    The class is not thread safe. It sets the global evaluation date to the inputs' asof date. */
+class IncrementalRevaluation {
+public:
+    IncrementalRevaluation(const QuantLib::ext::shared_ptr<InputParameters>& inputs,
+                           const QuantLib::ext::shared_ptr<ore::data::InMemoryLoader>& loader);
+
+    //! set new quote values, quotes not known to the loader are added
+    void updateQuotes(const std::map<std::string, QuantLib::Real>& quotes);
+
+    //! add a copy of a trade or replace a trade with the same id, the copy is built immediately, throws if this fails
+    void addTrade(const QuantLib::ext::shared_ptr<ore::data::Trade>& trade);
+
+    //! remove a trade, returns false if the trade is not in the portfolio
+    bool removeTrade(const std::string& tradeId);
+
+    //! reprice the trades affected by the changes since the last call, returns their ids
+    const std::set<std::string>& reprice();
+
+    //! \name Inspectors
+    //@{
+    const QuantLib::ext::shared_ptr<ore::data::Market>& market() const { return market_; }
+    const QuantLib::ext::shared_ptr<ore::data::EngineFactory>& engineFactory() const { return engineFactory_; }
+    const QuantLib::ext::shared_ptr<ore::data::Portfolio>& portfolio() const { return portfolio_; }
+    //! trade npvs in npv currency as of the last call to reprice(), null if the pricing failed
+    const std::map<std::string, QuantLib::Real>& npvs() const { return npvs_; }
+    //! trades repriced resp. removed since the previous call to reprice()
+    const std::set<std::string>& repricedTrades() const { return repricedTrades_; }
+    const std::set<std::string>& removedTrades() const { return removedTrades_; }
+    //! the repriced trades as a portfolio, e.g. to run a sensitivity analysis on them
+    QuantLib::ext::shared_ptr<ore::data::Portfolio> repricedPortfolio() const;
+    //! number of market rebuilds since construction (excluding the initial build)
+    QuantLib::Size marketRebuilds() const { return marketRebuilds_; }
+    //@}
+
+    //! reprice() and write the npv report for the whole portfolio
+    void writeNpvReport(ore::data::Report& report);
+
+private:
+    // marks a trade for repricing when one of its instruments notifies
+    class TradeObserver : public QuantLib::Observer {
+    public:
+        explicit TradeObserver(const QuantLib::ext::shared_ptr<ore::data::Trade>& trade);
+        void update() override { dirty = true; }
+        bool dirty = true;
+    };
+
+    void buildMarket();
+    void buildPortfolio();
+    void observe(const QuantLib::ext::shared_ptr<ore::data::Trade>& trade);
+
+    QuantLib::ext::shared_ptr<InputParameters> inputs_;
+    QuantLib::ext::shared_ptr<ore::data::InMemoryLoader> loader_;
+    QuantLib::ext::shared_ptr<ore::data::Market> market_;
+    QuantLib::ext::shared_ptr<ore::data::EngineFactory> engineFactory_;
+    QuantLib::ext::shared_ptr<ore::data::Portfolio> portfolio_;
+
+    std::map<std::string, QuantLib::ext::shared_ptr<TradeObserver>> observers_;
+    std::map<std::string, QuantLib::Real> npvs_;
+    std::set<std::string> repricedTrades_, removedTrades_, pendingRemovals_;
+    bool rebuildRequired_ = false;
+    QuantLib::Size marketRebuilds_ = 0;
+};
+
+} // namespace analytics
+} // namespace ore
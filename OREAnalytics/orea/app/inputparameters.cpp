@@ -22,6 +22,7 @@
 #include <orea/engine/observationmode.hpp>
 #include <orea/engine/sensitivityfilestream.hpp>
 #include <orea/engine/sacvasensitivityloader.hpp>
+#include <orea/scenario/scenarioarchive.hpp>
 #include <orea/scenario/scenariofilereader.hpp>
 #include <orea/scenario/shiftscenariogenerator.hpp>
 #include <orea/scenario/simplescenariofactory.hpp>
@@ -274,8 +275,44 @@ void InputParameters::setPortfolio(const QuantLib::ext::shared_ptr<Portfolio>& p
     scaleUpPortfolio(portfolio_);
 }
 
+QuantLib::ext::shared_ptr<InputParameters> InputParameters::copy() const {
+    auto c = QuantLib::ext::make_shared<InputParameters>(*this);
+    c->copyPortfolios();
+    c->copyReaders();
+    return c;
+}
+
+void InputParameters::copyReaders() {
+    // the streams keep their read position, so a copy has to read from its own stream
+    if (sensitivityStream_) {
+        if (!sensitivityStreamFile_.empty())
+            setSensitivityStreamFromFile(sensitivityStreamFile_);
+        else if (!sensitivityStreamBuffer_.empty())
+            setSensitivityStreamFromBuffer(sensitivityStreamBuffer_);
+        else
+            QL_FAIL("InputParameters::copy(): sensitivity stream has no source, can not copy it");
+    }
+    if (scenarioReader_) {
+        QL_REQUIRE(!scenarioReaderSource_.empty(),
+                   "InputParameters::copy(): scenario reader has no source, can not copy it");
+        setScenarioReader(scenarioReaderSource_);
+    }
+}
+
+void InputParameters::copyPortfolios() {
+    for (auto p : {&portfolio_, &useCounterpartyOriginalPortfolio_, &mporPortfolio_}) {
+        if (!*p)
+            continue;
+        auto c = QuantLib::ext::make_shared<Portfolio>((*p)->buildFailedTrades(), (*p)->ignoreTradeBuildFail());
+        c->setThreads((*p)->threads());
+        c->fromXMLString((*p)->toXMLString());
+        *p = c;
+    }
+}
+
 void InputParameters::setPortfolio(const std::string& xml) {
     portfolio_ = QuantLib::ext::make_shared<Portfolio>(buildFailedTrades_);
+    portfolio_->setThreads(portfolioThreads_);
     portfolio_->fromXMLString(xml);
     scaleUpPortfolio(portfolio_);
 }
@@ -283,6 +320,7 @@ void InputParameters::setPortfolio(const std::string& xml) {
 void InputParameters::setPortfolioFromFile(const std::string& fileNameString, const std::filesystem::path& inputPath) {
     vector<string> files = getFileNames(fileNameString, inputPath);
     portfolio_ = QuantLib::ext::make_shared<Portfolio>(buildFailedTrades_);
+    portfolio_->setThreads(portfolioThreads_);
     for (auto file : files) {
         LOG("Loading portfolio from file: " << file);
         portfolio_->fromFile(file);
@@ -761,11 +799,15 @@ void InputParameters::setCorrelationDataFromBuffer(const std::string& xml) {
 }
 
 void InputParameters::setSensitivityStreamFromFile(const std::string& fileName) {
+    sensitivityStreamFile_ = fileName;
+    sensitivityStreamBuffer_.clear();
     sensitivityStream_ = QuantLib::ext::make_shared<SensitivityFileStream>(
         fileName, csvSeparator_, csvCommentCharacter_, csvQuoteChar_, csvEscapeChar_);
 }
 
 void InputParameters::setSensitivityStreamFromBuffer(const std::string& buffer) {
+    sensitivityStreamFile_.clear();
+    sensitivityStreamBuffer_ = buffer;
     sensitivityStream_ = QuantLib::ext::make_shared<SensitivityBufferStream>(
         buffer, csvSeparator_, csvCommentCharacter_, csvQuoteChar_, csvEscapeChar_);
 }
@@ -775,10 +817,15 @@ void InputParameters::setBenchmarkVarPeriod(const std::string& period) {
 }
 
 void InputParameters::setScenarioReader(const std::string& fileName) {
+    scenarioReaderSource_ = fileName;
     boost::filesystem::path baseScenarioPath;
     try {
         boost::filesystem::path baseScenarioPath(fileName);
         if (exists(baseScenarioPath) && is_regular_file(baseScenarioPath)) {
+            if (ScenarioArchive::isScenarioArchive(fileName)) {
+                scenarioReader_ = QuantLib::ext::make_shared<ScenarioArchiveReader>(fileName);
+                return;
+            }
             scenarioReader_ = QuantLib::ext::make_shared<ScenarioFileReader>(
                 fileName, QuantLib::ext::make_shared<SimpleScenarioFactory>(false));
         }
@@ -131,6 +131,11 @@ public:
     void setContinueOnError(bool b) { continueOnError_ = b; }
     void setAllowModelBuilderFallbacks(bool b) { allowModelBuilderFallbacks_ = b; }
     void setLazyMarketBuilding(bool b) { lazyMarketBuilding_ = b; }
+    void setMarketBuildThreads(QuantLib::Size n) { marketBuildThreads_ = n; }
+    void setAnalyticsThreads(QuantLib::Size n) { analyticsThreads_ = n; }
+    void setPortfolioThreads(QuantLib::Size n) { portfolioThreads_ = n; }
+    void setSimmThreads(QuantLib::Size n) { simmThreads_ = n; }
+    void setIncrementalRevaluation(bool b) { incrementalRevaluation_ = b; }
     void setBuildFailedTrades(bool b) { buildFailedTrades_ = b; }
     void setObservationModel(const std::string& s) { observationModel_ = s; }
     void setImplyTodaysFixings(bool b) { implyTodaysFixings_ = b; }
@@ -175,6 +180,7 @@ public:
     void setMporPortfolioFromFile(const std::string& fileNameString, const std::filesystem::path& inputPath); 
     void setMarketConfigs(const std::map<std::string, std::string>& m);
     void setThreads(int i) { nThreads_ = i; }
+    void setWorkUnitsPerThread(QuantLib::Size n) { workUnitsPerThread_ = n; }
     void setEntireMarket(bool b) { entireMarket_ = b; }
     void setAllFixings(bool b) { allFixings_ = b; }
     void setEomInflationFixings(bool b) { eomInflationFixings_ = b; }
@@ -221,6 +227,7 @@ public:
     void setSensiThreshold(Real r) { sensiThreshold_ = r; }
     void setSensiRecalibrateModels(bool b) { sensiRecalibrateModels_ = b; }
     void setSensiLaxFxConversion(bool b) { sensiLaxFxConversion_ = b; }
+    void setSensiSkipIndependentTrades(bool b) { sensiSkipIndependentTrades_ = b; }
     void setSensiDecomposition(bool b) { sensiDecomposition_ = b; }
     void setSensiSimMarketParams(const std::string& xml);
     void setSensiSimMarketParamsFromFile(const std::string& fileName);
@@ -273,6 +280,7 @@ public:
     void setVarMethod(const std::string& s) { varMethod_ = s; }
     void setMcVarSamples(Size s) { mcVarSamples_ = s; }
     void setMcVarSeed(long l) { mcVarSeed_ = l; }
+    void setCovarianceDecayFactor(Real r) { covarianceDecayFactor_ = r; }
     void setCovarianceData(ore::data::CSVReader& reader);  
     void setCovarianceDataFromFile(const std::string& fileName);
     void setCovarianceDataFromBuffer(const std::string& xml);
@@ -617,6 +625,11 @@ public:
     bool continueOnError() const { return continueOnError_; }
     bool allowModelBuilderFallbacks() const { return allowModelBuilderFallbacks_; }
     bool lazyMarketBuilding() const { return lazyMarketBuilding_; }
+    QuantLib::Size marketBuildThreads() const { return marketBuildThreads_; }
+    QuantLib::Size analyticsThreads() const { return analyticsThreads_; }
+    QuantLib::Size portfolioThreads() const { return portfolioThreads_; }
+    QuantLib::Size simmThreads() const { return simmThreads_; }
+    bool incrementalRevaluation() const { return incrementalRevaluation_; }
     bool buildFailedTrades() const { return buildFailedTrades_; }
     const std::string& observationModel() const { return observationModel_; }
     bool implyTodaysFixings() const { return implyTodaysFixings_; }
@@ -648,6 +661,7 @@ public:
 
     QuantLib::Size maxRetries() const { return maxRetries_; }
     QuantLib::Size nThreads() const { return nThreads_; }
+    QuantLib::Size workUnitsPerThread() const { return workUnitsPerThread_; }
     bool entireMarket() const { return entireMarket_; }
     bool allFixings() const { return allFixings_; }
     bool eomInflationFixings() const { return eomInflationFixings_; }
@@ -709,6 +723,7 @@ public:
     QuantLib::Real sensiThreshold() const { return sensiThreshold_; }
     bool sensiRecalibrateModels() const { return sensiRecalibrateModels_; }
     bool sensiLaxFxConversion() const { return sensiLaxFxConversion_; }
+    bool sensiSkipIndependentTrades() const { return sensiSkipIndependentTrades_; }
     bool sensiDecomposition() const { return sensiDecomposition_; }
     const QuantLib::ext::shared_ptr<ore::analytics::ScenarioSimMarketParameters>& sensiSimMarketParams() const { return sensiSimMarketParams_; }
     const QuantLib::ext::shared_ptr<ore::analytics::SensitivityScenarioData>& sensiScenarioData() const { return sensiScenarioData_; }
@@ -765,6 +780,7 @@ public:
     Size mcVarSamples() const { return mcVarSamples_; }
     long mcVarSeed() const { return mcVarSeed_; }
     const std::map<std::pair<RiskFactorKey, RiskFactorKey>, Real>& covarianceData() const { return covarianceData_; }
+    Real covarianceDecayFactor() const { return covarianceDecayFactor_; }
     const QuantLib::ext::shared_ptr<SensitivityStream>& sensitivityStream() const { return sensitivityStream_; }
     std::string benchmarkVarPeriod() const { return benchmarkVarPeriod_; }
     QuantLib::ext::shared_ptr<ScenarioReader> scenarioReader() const { return scenarioReader_;};
@@ -1089,7 +1105,16 @@ public:
     virtual void loadParameters();
     virtual void writeOutParameters(){}
 
+    /*! Returns a copy of these parameters with its own copies of the portfolios and its own sensitivity stream and
+        scenario reader, so that analytics run concurrently can change their inputs, build their trades and read the
+        streams independently. Derived classes should override this. */
+    virtual QuantLib::ext::shared_ptr<InputParameters> copy() const;
+
 protected:
+    //! replace the portfolios by copies, used by copy()
+    void copyPortfolios();
+    //! replace the sensitivity stream and the scenario reader by new ones reading from the same source, used by copy()
+    void copyReaders();
 
     // List of analytics that shall be run, including
     // - NPV
@@ -1115,6 +1140,11 @@ protected:
     bool continueOnError_ = true;
     bool allowModelBuilderFallbacks_ = true;
     bool lazyMarketBuilding_ = true;
+    QuantLib::Size marketBuildThreads_ = 1;
+    QuantLib::Size analyticsThreads_ = 1;
+    QuantLib::Size portfolioThreads_ = 1;
+    QuantLib::Size simmThreads_ = 1;
+    bool incrementalRevaluation_ = false;
     bool buildFailedTrades_ = true;
     std::string observationModel_ = "None";
     bool implyTodaysFixings_ = false;
@@ -1143,6 +1173,7 @@ protected:
     QuantLib::ext::shared_ptr<ore::data::Portfolio> portfolio_, useCounterpartyOriginalPortfolio_, mporPortfolio_;
     QuantLib::Size maxRetries_ = 7;
     QuantLib::Size nThreads_ = 1;
+    QuantLib::Size workUnitsPerThread_ = 1;
    
     bool entireMarket_ = false; 
     bool allFixings_ = false; 
@@ -1197,6 +1228,7 @@ protected:
     QuantLib::Real sensiThreshold_ = 1e-6;
     bool sensiRecalibrateModels_ = true;
     bool sensiLaxFxConversion_ = false;
+    bool sensiSkipIndependentTrades_ = false;
     bool sensiDecomposition_ = false;
     QuantLib::ext::shared_ptr<ore::analytics::ScenarioSimMarketParameters> sensiSimMarketParams_;
     QuantLib::ext::shared_ptr<ore::analytics::SensitivityScenarioData> sensiScenarioData_;
@@ -1244,9 +1276,13 @@ protected:
     Size mcVarSamples_ = 1000000;
     long mcVarSeed_ = 42;
     std::map<std::pair<RiskFactorKey, RiskFactorKey>, Real> covarianceData_;
+    Real covarianceDecayFactor_ = 1.0;
     QuantLib::ext::shared_ptr<SensitivityStream> sensitivityStream_;
+    // the sources of the sensitivity stream and the scenario reader, to create new readers in copy()
+    std::string sensitivityStreamFile_, sensitivityStreamBuffer_;
     std::string benchmarkVarPeriod_;
     QuantLib::ext::shared_ptr<ScenarioReader> scenarioReader_;
+    std::string scenarioReaderSource_;
     QuantLib::ext::shared_ptr<ore::analytics::ScenarioSimMarketParameters> histVarSimMarketParams_;
     std::string baseScenarioLoc_;
     bool outputHistoricalScenarios_ = false;
@@ -225,8 +225,14 @@ QuantLib::ext::shared_ptr<CSVLoader> OREApp::buildCsvLoader(const QuantLib::ext:
     else {
         WLOG("fixing cutoff date not set");
     }
-    
-    auto loader = QuantLib::ext::make_shared<CSVLoader>(marketFiles, fixingFiles, dividendFiles, implyTodaysFixings, cutoff);
+
+    tmp = params->get("setup", "marketDataThreads", false);
+    Size nThreads = 1;
+    if (tmp != "")
+        nThreads = parseInteger(tmp);
+
+    auto loader = QuantLib::ext::make_shared<CSVLoader>(marketFiles, fixingFiles, dividendFiles, implyTodaysFixings, cutoff,
+                                                        nThreads);
 
     return loader;
 }
@@ -275,6 +281,8 @@ void OREApp::analytics() {
         // Run the requested analytics
         analyticsManager_->runAnalytics(mcr);
 
+        buildIncrementalRevaluation(loader);
+
         CONSOLEW("Writing reports...");
 
         // Write reports to files in the results path
@@ -390,10 +398,28 @@ void OREApp::initFromParams() {
         if (!tmp.empty()) {
             structuredLogRotationSize_ = static_cast<Size>(parseInteger(tmp));
         }
+        tmp = params_->get("logging", "asyncLog", false);
+        if (!tmp.empty()) {
+            asyncLog_ = ore::data::parseBool(tmp);
+        }
+        tmp = params_->get("logging", "asyncLogBufferSize", false);
+        if (!tmp.empty()) {
+            asyncLogBufferSize_ = static_cast<Size>(parseInteger(tmp));
+        }
+        tmp = params_->get("logging", "asyncLogOverflowPolicy", false);
+        if (!tmp.empty()) {
+            if (tmp == "Block")
+                asyncLogOverflowPolicy_ = AsyncLogger::OverflowPolicy::Block;
+            else if (tmp == "Drop")
+                asyncLogOverflowPolicy_ = AsyncLogger::OverflowPolicy::Drop;
+            else
+                QL_FAIL("invalid asyncLogOverflowPolicy '" << tmp << "', expected Block or Drop");
+        }
     }
 
     setupLog(logMask_, outputPath_, logFile_, logRootPath_, progressLogFile_, progressLogRotationSize_,
-             progressLogToConsole_, structuredLogFile_, structuredLogRotationSize_);
+             progressLogToConsole_, structuredLogFile_, structuredLogRotationSize_, asyncLog_, asyncLogBufferSize_,
+             asyncLogOverflowPolicy_);
 
     // Log the input parameters
     params_->log();
@@ -428,7 +454,8 @@ void OREApp::initFromInputs() {
     outputPath_ = inputs_->resultsPath().string();
     if (clearLog_)
         setupLog(logMask_, outputPath_, logFile_, logRootPath_, progressLogFile_, progressLogRotationSize_,
-                 progressLogToConsole_, structuredLogFile_, structuredLogRotationSize_);
+                 progressLogToConsole_, structuredLogFile_, structuredLogRotationSize_, asyncLog_,
+                 asyncLogBufferSize_, asyncLogOverflowPolicy_);
 
     inputs_->loadScriptLibrary();
 
@@ -558,6 +585,8 @@ void OREApp::run(const QuantLib::ext::shared_ptr<MarketDataLoader> loader) {
         // Run the requested analytics
         analyticsManager_->runAnalytics(mcr);
 
+        buildIncrementalRevaluation(loader);
+
         MEM_LOG_USING_LEVEL(ORE_WARNING, "Finishing OREApp::run()");
         // Leave any report writing to the calling aplication
     } catch (std::exception& e) {
@@ -576,10 +605,28 @@ void OREApp::run(const QuantLib::ext::shared_ptr<MarketDataLoader> loader) {
     LOG("ORE analytics done");
 }
 
+const QuantLib::ext::shared_ptr<IncrementalRevaluation>& OREApp::getIncrementalRevaluation() {
+    QL_REQUIRE(incrementalRevaluation_,
+               "incremental revaluation not available, set incrementalRevaluation in the setup and call run first");
+    return incrementalRevaluation_;
+}
+
+void OREApp::buildIncrementalRevaluation(const QuantLib::ext::shared_ptr<MarketDataLoader>& loader) {
+    incrementalRevaluation_ = nullptr;
+    if (!inputs_->incrementalRevaluation())
+        return;
+    // the loader holds the quotes requested by the analytics, if none of them required market data we load them here
+    if (!loader->loader()->hasQuotes(inputs_->asof()))
+        loader->populateLoader(inputs_->todaysMarketParams(), {inputs_->asof()});
+    LOG("Build resident market and portfolio for incremental revaluation");
+    incrementalRevaluation_ = QuantLib::ext::make_shared<IncrementalRevaluation>(inputs_, loader->loader());
+}
+
 void OREApp::setupLog(Size mask, const std::string& path, const std::string& file,
                       const boost::filesystem::path& logRootPath, const std::string& progressLogFile,
                       Size progressLogRotationSize, bool progressLogToConsole, const std::string& structuredLogFile,
-                      Size structuredLogRotationSize) {
+                      Size structuredLogRotationSize, bool asyncLog, Size asyncLogBufferSize,
+                      AsyncLogger::OverflowPolicy asyncLogOverflowPolicy) {
     closeLog();
 
     if (file == "" && path == "") {
@@ -599,7 +646,13 @@ void OREApp::setupLog(Size mask, const std::string& path, const std::string& fil
     }
     QL_REQUIRE(boost::filesystem::is_directory(p), "output path '" << path << "' is not a directory.");
 
-    Log::instance().registerLogger(QuantLib::ext::make_shared<FileLogger>(file));
+    // with async logging the file is flushed by the writer thread once per batch of messages
+    auto fileLogger = QuantLib::ext::make_shared<FileLogger>(file, !asyncLog);
+    if (asyncLog)
+        Log::instance().registerLogger(
+            QuantLib::ext::make_shared<AsyncLogger>(fileLogger, asyncLogBufferSize, asyncLogOverflowPolicy));
+    else
+        Log::instance().registerLogger(fileLogger);
     boost::filesystem::path oreRootPath =
         logRootPath.empty() ? boost::filesystem::path(__FILE__).parent_path().parent_path().parent_path().parent_path()
                             : logRootPath;
@@ -724,6 +777,13 @@ void OREAppInputParameters::loadParameters() {
     if (tmp != "")
         setThreads(parseInteger(tmp));
 
+    tmp = params_->get("setup", "workUnitsPerThread", false);
+    if (tmp != "") {
+        int n = parseInteger(tmp);
+        QL_REQUIRE(n > 0, "workUnitsPerThread (" << n << ") must be positive");
+        setWorkUnitsPerThread(n);
+    }
+
     tmp = params_->get("setup", "entireMarket", false);
     if (tmp != "")
         setEntireMarket(parseBool(tmp));
@@ -744,6 +804,26 @@ void OREAppInputParameters::loadParameters() {
     if (tmp != "")
         setLazyMarketBuilding(parseBool(tmp));
 
+    tmp = params_->get("setup", "marketBuildThreads", false);
+    if (tmp != "")
+        setMarketBuildThreads(parseInteger(tmp));
+
+    tmp = params_->get("setup", "analyticsThreads", false);
+    if (tmp != "")
+        setAnalyticsThreads(parseInteger(tmp));
+
+    tmp = params_->get("setup", "portfolioThreads", false);
+    if (tmp != "")
+        setPortfolioThreads(parseInteger(tmp));
+
+    tmp = params_->get("setup", "simmThreads", false);
+    if (tmp != "")
+        setSimmThreads(parseInteger(tmp));
+
+    tmp = params_->get("setup", "incrementalRevaluation", false);
+    if (tmp != "")
+        setIncrementalRevaluation(parseBool(tmp));
+
     tmp = params_->get("setup", "buildFailedTrades", false);
     if (tmp != "")
         setBuildFailedTrades(parseBool(tmp));
@@ -1040,6 +1120,10 @@ void OREAppInputParameters::loadParameters() {
         if (tmp != "")
             setSensiLaxFxConversion(parseBool(tmp));
 
+        tmp = params_->get("sensitivity", "skipIndependentTrades", false);
+        if (tmp != "")
+            setSensiSkipIndependentTrades(parseBool(tmp));
+
         tmp = params_->get("sensitivity", "decomposeIndexSensitivities", false);
         if (tmp != "")
             setSensiDecomposition(parseBool(tmp));
@@ -1345,6 +1429,10 @@ void OREAppInputParameters::loadParameters() {
         if (tmp != "")
             setBenchmarkVarPeriod(tmp);
 
+        tmp = params_->get("parametricVar", "covarianceDecayFactor", false);
+        if (tmp != "")
+            setCovarianceDecayFactor(parseReal(tmp));
+
         tmp = params_->get("parametricVar", "sensitivityConfigFile", false);
         if (tmp != "") {
             string file = (inputPath_ / tmp).generic_string();
@@ -26,6 +26,9 @@
 #include <orea/app/inputparameters.hpp>
 #include <orea/app/parameters.hpp>
 #include <orea/app/analyticsmanager.hpp>
+#include <orea/app/incrementalrevaluation.hpp>
+
+#include <ored/utilities/asynclogger.hpp>
 
 #include <boost/make_shared.hpp>
 #include <boost/timer/timer.hpp>
@@ -81,6 +84,11 @@ public:
 
     std::vector<std::string> getErrors();
 
+    /*! The market and portfolio of the last run kept resident for incremental revaluation, only available if
+        incrementalRevaluation is set in the inputs. Only piecewise yield curve and fx spot quotes are linked, other
+        quote changes trigger a full rebuild, see IncrementalRevaluation. */
+    const QuantLib::ext::shared_ptr<IncrementalRevaluation>& getIncrementalRevaluation();
+
     QuantLib::ext::shared_ptr<BufferLogger> getLogger(const std::string& name);
 
     std::vector<std::string>& getProgressLog();
@@ -96,7 +104,9 @@ public:
                   const boost::filesystem::path& logRootPath = boost::filesystem::path(),
                   const std::string& progressLogFile = "", QuantLib::Size progressLogRotationSize = 100 * 1024 * 1024,
                   bool progressLogToConsole = false, const std::string& structuredLogFile = "",
-                  QuantLib::Size structuredLogRotationSize = 100 * 1024 * 1024);
+                  QuantLib::Size structuredLogRotationSize = 100 * 1024 * 1024, bool asyncLog = false,
+                  QuantLib::Size asyncLogBufferSize = 8192,
+                  AsyncLogger::OverflowPolicy asyncLogOverflowPolicy = AsyncLogger::OverflowPolicy::Block);
     
     //! remove logs
     void closeLog();
@@ -111,6 +121,9 @@ protected:
 
     void initFromParams();
     void initFromInputs();
+
+    //! build the incremental revaluation from the market data of the run, if requested in the inputs
+    void buildIncrementalRevaluation(const QuantLib::ext::shared_ptr<MarketDataLoader>& loader);
       
     //! ORE Input parameters
     QuantLib::ext::shared_ptr<Parameters> params_;
@@ -118,6 +131,7 @@ protected:
     QuantLib::ext::shared_ptr<OutputParameters> outputs_;
 
     QuantLib::ext::shared_ptr<AnalyticsManager> analyticsManager_;
+    QuantLib::ext::shared_ptr<IncrementalRevaluation> incrementalRevaluation_;
     QuantLib::ext::shared_ptr<StructuredLogger> structuredLogger_;
     boost::timer::cpu_timer runTimer_;
 
@@ -133,6 +147,9 @@ protected:
     bool progressLogToConsole_ = false;
     string structuredLogFile_ = "";
     QuantLib::Size structuredLogRotationSize_ = 100 * 1024 * 1024;
+    bool asyncLog_ = false;
+    QuantLib::Size asyncLogBufferSize_ = 8192;
+    AsyncLogger::OverflowPolicy asyncLogOverflowPolicy_ = AsyncLogger::OverflowPolicy::Block;
 
     // Cached error messages of a run
     std::vector<std::string> errorMessages_;
@@ -147,6 +164,13 @@ public:
 
     //! write out parameters
     virtual void writeOutParameters() override{};
+
+    QuantLib::ext::shared_ptr<InputParameters> copy() const override {
+        auto c = QuantLib::ext::make_shared<OREAppInputParameters>(*this);
+        c->copyPortfolios();
+        c->copyReaders();
+        return c;
+    }
           
     std::string loadParameterString(const std::string& analytic, const std::string& param, bool mandatory) override;
     std::string loadParameterXMLString(const std::string& analytic, const std::string& param,
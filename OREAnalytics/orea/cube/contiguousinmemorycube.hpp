@@ -0,0 +1,166 @@
+/*
+ Copyright (C) 2025 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+/*! \file orea/cube/contiguousinmemorycube.hpp
+    \brief cube storing data in memory in one contiguous block
+    \ingroup cube
+*/
+
+#pragma once
+
+#include <orea/cube/npvcube.hpp>
+
+#include <ql/errors.hpp>
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+namespace ore {
+namespace analytics {
+
+using QuantLib::Date;
+using QuantLib::Size;
+
+/*! Cube storing all values in one contiguous allocation. Contrary to InMemoryCubeOpt the memory for all (id, date)
+    pairs is allocated on construction, so this cube is suitable for dense data.
+
+    The layout determines which values are adjacent in memory:
+    - TradeMajor: ordered by id, date, depth, sample, i.e. the samples for an (id, date, depth) are contiguous, this
+      is the layout for getSamples() / setSamples()
+    - SampleMajor: ordered by date, sample, depth, id, i.e. the ids for a (date, sample, depth) are contiguous, this
+      is the layout for getIds()
+*/
+template <typename T> class ContiguousInMemoryCube : public NPVCube {
+public:
+    enum class Layout { TradeMajor, SampleMajor };
+
+    ContiguousInMemoryCube(const Date& asof, const std::set<std::string>& ids, const std::vector<Date>& dates,
+                           Size samples, Size depth = 1, const Layout layout = Layout::TradeMajor)
+        : asof_(asof), dates_(dates), samples_(samples), depth_(depth), layout_(layout),
+          t0data_(depth * ids.size(), T(0)), data_(ids.size() * dates.size() * depth * samples, T(0)) {
+        Size pos = 0;
+        for (const auto& id : ids) {
+            idIdx_[id] = pos++;
+        }
+    }
+
+    Size numIds() const override { return idIdx_.size(); }
+    Size numDates() const override { return dates_.size(); }
+    Size samples() const override { return samples_; }
+    Size depth() const override { return depth_; }
+    const std::map<std::string, Size>& idsAndIndexes() const override { return idIdx_; }
+    const std::vector<QuantLib::Date>& dates() const override { return dates_; }
+    QuantLib::Date asof() const override { return asof_; }
+    Layout layout() const { return layout_; }
+
+    Real getT0(Size i, Size d) const override {
+        this->check(i, 0, 0, d);
+        return static_cast<Real>(t0data_[d * idIdx_.size() + i]);
+    }
+
+    void setT0(Real value, Size i, Size d) override {
+        this->check(i, 0, 0, d);
+        t0data_[d * idIdx_.size() + i] = static_cast<T>(value);
+    }
+
+    Real get(Size i, Size j, Size k, Size d) const override {
+        this->check(i, j, k, d);
+        return static_cast<Real>(data_[index(i, j, k, d)]);
+    }
+
+    void set(Real value, Size i, Size j, Size k, Size d) override {
+        this->check(i, j, k, d);
+        data_[index(i, j, k, d)] = static_cast<T>(value);
+    }
+
+    void getSamples(std::vector<Real>& result, Size i, Size j, Size d) const override {
+        this->check(i, j, 0, d);
+        result.resize(samples_);
+        if (layout_ == Layout::TradeMajor) {
+            auto begin = data_.begin() + index(i, j, 0, d);
+            std::copy(begin, begin + samples_, result.begin());
+        } else {
+            Size stride = depth_ * idIdx_.size();
+            for (Size k = 0, pos = index(i, j, 0, d); k < samples_; ++k, pos += stride)
+                result[k] = static_cast<Real>(data_[pos]);
+        }
+    }
+
+    void setSamples(const std::vector<Real>& values, Size i, Size j, Size d) override {
+        this->check(i, j, 0, d);
+        QL_REQUIRE(values.size() == samples_, "ContiguousInMemoryCube::setSamples(): values size ("
+                                                  << values.size() << ") does not match samples (" << samples_ << ")");
+        if (layout_ == Layout::TradeMajor) {
+            std::transform(values.begin(), values.end(), data_.begin() + index(i, j, 0, d),
+                           [](const Real v) { return static_cast<T>(v); });
+        } else {
+            Size stride = depth_ * idIdx_.size();
+            for (Size k = 0, pos = index(i, j, 0, d); k < samples_; ++k, pos += stride)
+                data_[pos] = static_cast<T>(values[k]);
+        }
+    }
+
+    void getIds(std::vector<Real>& result, Size j, Size k, Size d) const override {
+        this->check(0, j, k, d);
+        result.resize(idIdx_.size());
+        if (layout_ == Layout::SampleMajor) {
+            auto begin = data_.begin() + index(0, j, k, d);
+            std::copy(begin, begin + idIdx_.size(), result.begin());
+        } else {
+            Size stride = dates_.size() * depth_ * samples_;
+            for (Size i = 0, pos = index(0, j, k, d); i < idIdx_.size(); ++i, pos += stride)
+                result[i] = static_cast<Real>(data_[pos]);
+        }
+    }
+
+    bool usesDoublePrecision() const override;
+
+private:
+    std::size_t index(Size i, Size j, Size k, Size d) const {
+        if (layout_ == Layout::TradeMajor)
+            return ((i * dates_.size() + j) * depth_ + d) * samples_ + k;
+        else
+            return ((j * samples_ + k) * depth_ + d) * idIdx_.size() + i;
+    }
+
+    void check(Size i, Size j, Size k, Size d) const {
+        QL_REQUIRE(i < numIds(), "Out of bounds on ids (i=" << i << ", numIds=" << numIds() << ")");
+        QL_REQUIRE(j < numDates(), "Out of bounds on dates (j=" << j << ", numDates=" << numDates() << ")");
+        QL_REQUIRE(k < samples(), "Out of bounds on samples (k=" << k << ", samples=" << samples() << ")");
+        QL_REQUIRE(d < depth(), "Out of bounds on depth (d=" << d << ", depth=" << depth() << ")");
+    }
+
+    QuantLib::Date asof_;
+    std::vector<QuantLib::Date> dates_;
+    Size samples_;
+    Size depth_;
+    Layout layout_;
+
+    std::vector<T> t0data_;
+    std::vector<T> data_;
+
+    std::map<std::string, Size> idIdx_;
+};
+
+// specialisations are defined in contiguousinmemorycube.cpp
+template <> bool ContiguousInMemoryCube<double>::usesDoublePrecision() const;
+template <> bool ContiguousInMemoryCube<float>::usesDoublePrecision() const;
+
+} // namespace analytics
+} // namespace ore
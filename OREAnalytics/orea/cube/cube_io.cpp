@@ -18,6 +18,7 @@
 
 #include <orea/cube/cube_io.hpp>
 #include <orea/cube/inmemorycube.hpp>
+#include <orea/cube/mappednpvcube.hpp>
 
 #include <ored/utilities/to_string.hpp>
 
@@ -28,6 +29,8 @@
 #endif
 #include <boost/iostreams/filtering_stream.hpp>
 
+#include <cstdint>
+#include <cstring>
 #include <iomanip>
 #include <regex>
 
@@ -58,10 +61,234 @@ std::string getMetaData(const std::string& line, const std::string& tag, const b
     return line.substr(0, 1) == "#" && line.substr(2, tag.size()) == tag ? line.substr(15) : std::string();
 }
 
+// binary cube format, see cube_io.hpp
+
+constexpr char binaryCubeMagic[8] = {'O', 'R', 'E', 'C', 'U', 'B', 'E', 'B'};
+constexpr std::uint32_t binaryCubeVersion = 1;
+constexpr std::uint32_t binaryCubeByteOrderMark = 0x01020304;
+constexpr std::size_t binaryCubeAlignment = 64;
+
+bool use_binary_format(const std::string& filename) {
+    return boost::filesystem::path(filename).extension().string() == ".bin";
+}
+
+bool is_binary_cube_file(const std::string& filename) {
+    std::ifstream in(filename, std::ios::binary | std::ios::in);
+    char magic[sizeof(binaryCubeMagic)];
+    return in.read(magic, sizeof(magic)) && std::memcmp(magic, binaryCubeMagic, sizeof(magic)) == 0;
+}
+
+QuantLib::Date binaryCubeDate(const std::int64_t serial) {
+    return serial == 0 ? QuantLib::Date() : QuantLib::Date(static_cast<QuantLib::Date::serial_type>(serial));
+}
+
+std::size_t alignBinaryCubeOffset(const std::size_t offset) {
+    return (offset + binaryCubeAlignment - 1) / binaryCubeAlignment * binaryCubeAlignment;
+}
+
+template <typename I> void appendBinary(std::string& buffer, const I value) {
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(I));
+}
+
+void appendBinary(std::string& buffer, const std::string& value) {
+    appendBinary<std::uint64_t>(buffer, value.size());
+    buffer.append(value);
+}
+
+class BinaryCubeReader {
+public:
+    BinaryCubeReader(const char* data, const std::size_t size, const std::string& filename)
+        : data_(data), size_(size), pos_(0), filename_(filename) {}
+
+    template <typename I> I read() {
+        checkAvailable(sizeof(I));
+        I value;
+        std::memcpy(&value, data_ + pos_, sizeof(I));
+        pos_ += sizeof(I);
+        return value;
+    }
+
+    std::string readString() {
+        std::size_t n = read<std::uint64_t>();
+        checkAvailable(n);
+        std::string value(data_ + pos_, n);
+        pos_ += n;
+        return value;
+    }
+
+private:
+    void checkAvailable(const std::size_t n) const {
+        QL_REQUIRE(pos_ + n <= size_, "loadCube(): unexpected end of binary cube file '" << filename_ << "'");
+    }
+
+    const char* data_;
+    std::size_t size_;
+    std::size_t pos_;
+    std::string filename_;
+};
+
+NPVCubeWithMetaData loadCubeBinary(const std::string& filename) {
+
+    NPVCubeWithMetaData result;
+
+    // map file copy-on-write, so that the cube can be modified without changing the file
+
+    boost::iostreams::mapped_file_params params(filename);
+    params.flags = boost::iostreams::mapped_file::priv;
+    auto file = QuantLib::ext::make_shared<boost::iostreams::mapped_file>(params);
+    BinaryCubeReader in(file->const_data(), file->size(), filename);
+
+    // read header
+
+    char magic[sizeof(binaryCubeMagic)];
+    for (auto& c : magic)
+        c = in.read<char>();
+    QL_REQUIRE(std::memcmp(magic, binaryCubeMagic, sizeof(magic)) == 0,
+               "loadCube(): file '" << filename << "' is not a binary cube file");
+    auto version = in.read<std::uint32_t>();
+    QL_REQUIRE(version == binaryCubeVersion, "loadCube(): binary cube file '" << filename << "' has version " << version
+                                                                              << ", expected " << binaryCubeVersion);
+    QL_REQUIRE(in.read<std::uint32_t>() == binaryCubeByteOrderMark,
+               "loadCube(): binary cube file '" << filename << "' was written on a platform with different byte order");
+    auto valueSize = in.read<std::uint32_t>();
+    QL_REQUIRE(valueSize == sizeof(double) || valueSize == sizeof(float),
+               "loadCube(): binary cube file '" << filename << "' has invalid value size " << valueSize);
+    in.read<std::uint32_t>(); // reserved
+    QuantLib::Date asof = binaryCubeDate(in.read<std::int64_t>());
+    Size numIds = in.read<std::uint64_t>();
+    Size numDates = in.read<std::uint64_t>();
+    Size samples = in.read<std::uint64_t>();
+    Size depth = in.read<std::uint64_t>();
+    std::size_t t0Offset = in.read<std::uint64_t>();
+    std::size_t dataOffset = in.read<std::uint64_t>();
+
+    // read date and id tables
+
+    std::vector<QuantLib::Date> dates;
+    for (Size i = 0; i < numDates; ++i)
+        dates.push_back(binaryCubeDate(in.read<std::int64_t>()));
+
+    std::map<std::string, Size> ids;
+    for (Size i = 0; i < numIds; ++i) {
+        QL_REQUIRE(ids.insert(std::make_pair(in.readString(), i)).second,
+                   "loadCube(): binary cube file '" << filename << "' contains duplicate ids");
+    }
+
+    // read meta data
+
+    if (std::string md = in.readString(); !md.empty()) {
+        result.scenarioGeneratorData = QuantLib::ext::make_shared<ScenarioGeneratorData>();
+        result.scenarioGeneratorData->fromXMLString(md);
+        DLOG("overwrite scenario generator data with meta data from cube: " << md);
+    }
+
+    if (auto md = in.read<std::int8_t>(); md >= 0) {
+        result.storeFlows = md == 1;
+        DLOG("overwrite storeFlows with meta data from cube: " << std::boolalpha << *result.storeFlows);
+    }
+
+    if (auto md = in.read<std::int64_t>(); md >= 0) {
+        result.storeCreditStateNPVs = static_cast<Size>(md);
+        DLOG("overwrite storeCreditStateNPVs with meta data from cube: " << md);
+    }
+
+    // build the cube on top of the mapped file
+
+    if (valueSize == sizeof(double)) {
+        result.cube = QuantLib::ext::make_shared<MappedNPVCube<double>>(file, asof, ids, dates, samples, depth,
+                                                                       t0Offset, dataOffset);
+    } else {
+        result.cube = QuantLib::ext::make_shared<MappedNPVCube<float>>(file, asof, ids, dates, samples, depth,
+                                                                      t0Offset, dataOffset);
+    }
+
+    LOG("mapped binary cube from " << filename << ": asof = " << asof << ", dim = " << numIds << " x " << numDates
+                                   << " x " << samples << " x " << depth << ", value size " << valueSize << ".");
+
+    return result;
+}
+
+template <typename T> void saveCubeBinary(const std::string& filename, const NPVCubeWithMetaData& cube) {
+
+    const NPVCube& c = *cube.cube;
+
+    // variable part of the header: dates, ids and meta data
+
+    std::string tables;
+    for (auto const& d : c.dates())
+        appendBinary<std::int64_t>(tables, d.serialNumber());
+
+    std::vector<std::string> ids(c.numIds());
+    for (auto const& [id, index] : c.idsAndIndexes())
+        ids[index] = id;
+    for (auto const& id : ids)
+        appendBinary(tables, id);
+
+    appendBinary(tables, cube.scenarioGeneratorData ? cube.scenarioGeneratorData->toXMLString() : std::string());
+    appendBinary<std::int8_t>(tables, cube.storeFlows ? static_cast<std::int8_t>(*cube.storeFlows) : -1);
+    appendBinary<std::int64_t>(tables,
+                               cube.storeCreditStateNPVs ? static_cast<std::int64_t>(*cube.storeCreditStateNPVs) : -1);
+
+    // fixed part of the header
+
+    constexpr std::size_t fixedHeaderSize = sizeof(binaryCubeMagic) + 4 * sizeof(std::uint32_t) +
+                                            sizeof(std::int64_t) + 6 * sizeof(std::uint64_t);
+
+    std::size_t t0Offset = alignBinaryCubeOffset(fixedHeaderSize + tables.size());
+    std::size_t dataOffset = alignBinaryCubeOffset(t0Offset + c.numIds() * c.depth() * sizeof(T));
+
+    std::string header(binaryCubeMagic, sizeof(binaryCubeMagic));
+    appendBinary<std::uint32_t>(header, binaryCubeVersion);
+    appendBinary<std::uint32_t>(header, binaryCubeByteOrderMark);
+    appendBinary<std::uint32_t>(header, sizeof(T));
+    appendBinary<std::uint32_t>(header, 0);
+    appendBinary<std::int64_t>(header, c.asof().serialNumber());
+    appendBinary<std::uint64_t>(header, c.numIds());
+    appendBinary<std::uint64_t>(header, c.numDates());
+    appendBinary<std::uint64_t>(header, c.samples());
+    appendBinary<std::uint64_t>(header, c.depth());
+    appendBinary<std::uint64_t>(header, t0Offset);
+    appendBinary<std::uint64_t>(header, dataOffset);
+    QL_REQUIRE(header.size() == fixedHeaderSize, "internal error: saveCube(): unexpected binary header size");
+
+    header.append(tables);
+    header.resize(t0Offset, '\0');
+
+    // write header and data
+
+    std::ofstream out(filename, std::ios::binary | std::ios::out);
+    QL_REQUIRE(out, "saveCube(): could not open file '" << filename << "' for writing");
+    out.write(header.data(), header.size());
+
+    std::vector<T> t0(c.numIds() * c.depth());
+    for (Size d = 0; d < c.depth(); ++d)
+        for (Size i = 0; i < c.numIds(); ++i)
+            t0[d * c.numIds() + i] = static_cast<T>(c.getT0(i, d));
+    out.write(reinterpret_cast<const char*>(t0.data()), t0.size() * sizeof(T));
+
+    std::string padding(dataOffset - t0Offset - t0.size() * sizeof(T), '\0');
+    out.write(padding.data(), padding.size());
+
+    std::vector<T> block(c.depth() * c.samples());
+    for (Size i = 0; i < c.numIds(); ++i) {
+        for (Size j = 0; j < c.numDates(); ++j) {
+            for (Size d = 0; d < c.depth(); ++d)
+                for (Size k = 0; k < c.samples(); ++k)
+                    block[d * c.samples() + k] = static_cast<T>(c.get(i, j, k, d));
+            out.write(reinterpret_cast<const char*>(block.data()), block.size() * sizeof(T));
+        }
+    }
+
+    QL_REQUIRE(out, "saveCube(): error while writing binary cube file '" << filename << "'");
+}
+
 } // namespace
 
 NPVCubeWithMetaData loadCube(const std::string& filename) {
 
+    if (is_binary_cube_file(filename))
+        return loadCubeBinary(filename);
+
     NPVCubeWithMetaData result;
 
     // open file
@@ -164,6 +391,14 @@ NPVCubeWithMetaData loadCube(const std::string& filename) {
 
 void saveCube(const std::string& filename, const NPVCubeWithMetaData& cube) {
 
+    if (use_binary_format(filename)) {
+        if (cube.cube->usesDoublePrecision())
+            saveCubeBinary<double>(filename, cube);
+        else
+            saveCubeBinary<float>(filename, cube);
+        return;
+    }
+
     // open file
 
     bool gzip = use_compression(filename);
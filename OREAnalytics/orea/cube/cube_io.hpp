@@ -43,6 +43,20 @@ struct NPVCubeWithMetaData {
     QuantLib::ext::optional<Size> storeCreditStateNPVs;
 };
 
+/*! The cube is saved in a binary format if the filename has the extension .bin, otherwise as text (compressed unless
+    the extension is .csv or .txt). The binary format (version 1) consists of
+
+    - a fixed header: magic "ORECUBEB", version, byte order mark, value size (4 or 8 bytes), asof (serial number),
+      numIds, numDates, samples, depth, offsets of the T0 and the other values in the file
+    - the date table (serial numbers) and the id table (length + characters, in index order)
+    - the optional meta data
+    - the T0 values as T[depth][numIds] and the other values as one block T[depth][samples] per (id, date), ordered by
+      id first, then by date. The T0 values and the other values each start at a file offset that is a multiple of 64
+      bytes, the header and the T0 values are padded with zeros up to these offsets. The blocks within the other
+      values follow each other without padding.
+
+    loadCube() detects the binary format from the magic. A binary cube is not read into memory, but returned as a
+    MappedNPVCube on top of a copy-on-write mapping of the file. */
 NPVCubeWithMetaData loadCube(const std::string& filename);
 void saveCube(const std::string& filename, const NPVCubeWithMetaData& cube);
 
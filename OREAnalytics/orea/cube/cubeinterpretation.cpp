@@ -137,6 +137,60 @@ Real CubeInterpretation::getMporFlows(const QuantLib::ext::shared_ptr<NPVCube>&
     return getMporPositiveFlows(cube, tradeIdx, dateIdx, sampleIdx) + getMporNegativeFlows(cube, tradeIdx, dateIdx, sampleIdx) ;
 }
 
+void CubeInterpretation::getGenericValue(const QuantLib::ext::shared_ptr<NPVCube>& cube, Size tradeIdx, Size dateIdx,
+                                         Size depth, std::vector<Real>& result) const {
+    cube->getSamples(result, tradeIdx, dateIdx, depth);
+    if (flipViewXVA_) {
+        for (auto& v : result)
+            v = -v;
+    }
+}
+
+void CubeInterpretation::getDefaultNpv(const QuantLib::ext::shared_ptr<NPVCube>& cube, Size tradeIdx, Size dateIdx,
+                                       std::vector<Real>& result) const {
+    getGenericValue(cube, tradeIdx, dateIdx, defaultDateNpvIndex_, result);
+}
+
+void CubeInterpretation::getCloseOutNpv(const QuantLib::ext::shared_ptr<NPVCube>& cube, Size tradeIdx, Size dateIdx,
+                                        const QuantLib::ext::shared_ptr<AggregationScenarioData>& data,
+                                        std::vector<Real>& result) const {
+    if (withCloseOutLag_) {
+        getGenericValue(cube, tradeIdx, dateIdx, closeOutDateNpvIndex_, result);
+        for (Size k = 0; k < result.size(); ++k)
+            result[k] /= getCloseOutAggregationScenarioData(data, AggregationScenarioDataType::Numeraire, dateIdx, k);
+    } else {
+        getGenericValue(cube, tradeIdx, dateIdx + 1, defaultDateNpvIndex_, result);
+    }
+}
+
+namespace {
+void getMporFlowsForAllSamples(const CubeInterpretation& ci, const QuantLib::ext::shared_ptr<NPVCube>& cube,
+                               Size tradeIdx, Size dateIdx, Size depth, std::vector<Real>& result) {
+    if (depth == QuantLib::Null<Size>()) {
+        result.assign(cube->samples(), 0.0);
+        return;
+    }
+    try {
+        ci.getGenericValue(cube, tradeIdx, dateIdx, depth, result);
+    } catch (std::exception& e) {
+        DLOG("Unable to retrieve MPOR flows for trade " << tradeIdx << ", date " << dateIdx << "; " << e.what());
+        result.assign(cube->samples(), 0.0);
+    }
+}
+} // namespace
+
+void CubeInterpretation::getMporPositiveFlows(const QuantLib::ext::shared_ptr<NPVCube>& cube, Size tradeIdx,
+                                              Size dateIdx, std::vector<Real>& result) const {
+    getMporFlowsForAllSamples(*this, cube, tradeIdx, dateIdx, mporFlowsIndex_, result);
+}
+
+void CubeInterpretation::getMporNegativeFlows(const QuantLib::ext::shared_ptr<NPVCube>& cube, Size tradeIdx,
+                                              Size dateIdx, std::vector<Real>& result) const {
+    getMporFlowsForAllSamples(*this, cube, tradeIdx, dateIdx,
+                              mporFlowsIndex_ == QuantLib::Null<Size>() ? mporFlowsIndex_ : mporFlowsIndex_ + 1,
+                              result);
+}
+
 Real CubeInterpretation::getDefaultAggregationScenarioData(
     const QuantLib::ext::shared_ptr<AggregationScenarioData>& data, const AggregationScenarioDataType& dataType,
     Size dateIdx, Size sampleIdx, const std::string& qualifier) const {
@@ -90,6 +90,19 @@ public:
     //! Retrieve the aggregate value of Margin Period of Risk cashflows from the Cube
     Real getMporFlows(const QuantLib::ext::shared_ptr<NPVCube>& cube, Size tradeIdx, Size dateIdx, Size sampleIdx) const;
 
+    /*! Same as above, but retrieving the values for all samples at once, result is resized to the number of samples.
+        These use the bulk accessors of the cube and should be preferred in loops over samples. */
+    void getGenericValue(const QuantLib::ext::shared_ptr<NPVCube>& cube, Size tradeIdx, Size dateIdx, Size depth,
+                         std::vector<Real>& result) const;
+    void getDefaultNpv(const QuantLib::ext::shared_ptr<NPVCube>& cube, Size tradeIdx, Size dateIdx,
+                       std::vector<Real>& result) const;
+    void getCloseOutNpv(const QuantLib::ext::shared_ptr<NPVCube>& cube, Size tradeIdx, Size dateIdx,
+                        const QuantLib::ext::shared_ptr<AggregationScenarioData>& data, std::vector<Real>& result) const;
+    void getMporPositiveFlows(const QuantLib::ext::shared_ptr<NPVCube>& cube, Size tradeIdx, Size dateIdx,
+                              std::vector<Real>& result) const;
+    void getMporNegativeFlows(const QuantLib::ext::shared_ptr<NPVCube>& cube, Size tradeIdx, Size dateIdx,
+                              std::vector<Real>& result) const;
+
     //! Retrieve a (default date) simulated risk factor value from AggregationScenarioData
     Real getDefaultAggregationScenarioData(const QuantLib::ext::shared_ptr<AggregationScenarioData>& data,
                                            const AggregationScenarioDataType& dataType, Size dateIdx, Size sampleIdx,
@@ -29,6 +29,7 @@
 
 #include <boost/make_shared.hpp>
 
+#include <algorithm>
 #include <map>
 #include <vector>
 
@@ -108,6 +109,29 @@ public:
         data_[j][i][d * samples_ + k] = static_cast<T>(value);
     }
 
+    void getSamples(std::vector<Real>& result, Size i, Size j, Size d) const override {
+        this->check(i, j, 0, d);
+        result.resize(samples_);
+        if (data_[j][i] == nullptr)
+            std::fill(result.begin(), result.end(), 0.0);
+        else
+            std::copy(data_[j][i] + d * samples_, data_[j][i] + (d + 1) * samples_, result.begin());
+    }
+
+    void setSamples(const std::vector<Real>& values, Size i, Size j, Size d) override {
+        this->check(i, j, 0, d);
+        QL_REQUIRE(values.size() == samples_, "InMemoryCubeOpt::setSamples(): values size ("
+                                                  << values.size() << ") does not match samples (" << samples_ << ")");
+        if (data_[j][i] == nullptr) {
+            if (std::all_of(values.begin(), values.end(), [](const Real v) { return v == 0.0; }))
+                return;
+            data_[j][i] = new T[depth_ * samples_];
+            std::fill(data_[j][i], data_[j][i] + depth_ * samples_, 0.0);
+        }
+        std::transform(values.begin(), values.end(), data_[j][i] + d * samples_,
+                       [](const Real v) { return static_cast<T>(v); });
+    }
+
     bool usesDoublePrecision() const override;
 
 private:
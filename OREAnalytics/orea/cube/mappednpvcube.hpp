@@ -0,0 +1,142 @@
+/*
+ Copyright (C) 2025 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+/*! \file orea/cube/mappednpvcube.hpp
+    \brief cube on top of a memory mapped file in the binary cube format
+    \ingroup cube
+*/
+
+#pragma once
+
+#include <orea/cube/npvcube.hpp>
+
+#include <ql/errors.hpp>
+
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+namespace ore {
+namespace analytics {
+
+using QuantLib::Date;
+using QuantLib::Size;
+
+/*! Cube reading its data directly from a memory mapped file written by saveCube() in the binary format, see
+    cube_io.hpp. Nothing is copied on construction, pages are loaded by the OS on first access.
+
+    The file should be mapped copy-on-write (boost::iostreams::mapped_file::priv). Then set() and setT0() are
+    allowed and only modify private copies of the touched pages, the file on disk remains unchanged.
+
+    The T0 values are expected at t0Offset as T[depth][numIds], the other values at dataOffset as one block
+    T[depth][samples] per (id, date), the blocks ordered by id first, then by date and stored without padding. The
+    offsets must be multiples of alignof(T), saveCube() writes them as multiples of 64. */
+template <typename T> class MappedNPVCube : public NPVCube {
+public:
+    MappedNPVCube(const QuantLib::ext::shared_ptr<boost::iostreams::mapped_file>& file, const Date& asof,
+                  const std::map<std::string, Size>& idIdx, const std::vector<Date>& dates, const Size samples,
+                  const Size depth, const std::size_t t0Offset, const std::size_t dataOffset)
+        : file_(file), asof_(asof), dates_(dates), samples_(samples), depth_(depth), idIdx_(idIdx) {
+        QL_REQUIRE(file_ && file_->is_open(), "MappedNPVCube: file is not open");
+        QL_REQUIRE(t0Offset % alignof(T) == 0 && dataOffset % alignof(T) == 0,
+                   "MappedNPVCube: offsets (" << t0Offset << ", " << dataOffset << ") are not aligned");
+        QL_REQUIRE(t0Offset + idIdx_.size() * depth_ * sizeof(T) <= dataOffset,
+                   "MappedNPVCube: t0 data (offset " << t0Offset << ") overlaps data (offset " << dataOffset << ")");
+        QL_REQUIRE(dataOffset + idIdx_.size() * dates_.size() * depth_ * samples_ * sizeof(T) <= file_->size(),
+                   "MappedNPVCube: file size (" << file_->size() << ") is too small for cube data at offset "
+                                                << dataOffset);
+        char* base = file_->flags() == boost::iostreams::mapped_file::readonly
+                         ? const_cast<char*>(file_->const_data())
+                         : file_->data();
+        t0data_ = reinterpret_cast<T*>(base + t0Offset);
+        data_ = reinterpret_cast<T*>(base + dataOffset);
+    }
+
+    Size numIds() const override { return idIdx_.size(); }
+    Size numDates() const override { return dates_.size(); }
+    Size samples() const override { return samples_; }
+    Size depth() const override { return depth_; }
+    const std::map<std::string, Size>& idsAndIndexes() const override { return idIdx_; }
+    const std::vector<QuantLib::Date>& dates() const override { return dates_; }
+    QuantLib::Date asof() const override { return asof_; }
+
+    Real getT0(Size i, Size d) const override {
+        this->check(i, 0, 0, d);
+        return static_cast<Real>(t0data_[d * idIdx_.size() + i]);
+    }
+
+    void setT0(Real value, Size i, Size d) override {
+        this->check(i, 0, 0, d);
+        checkWritable();
+        t0data_[d * idIdx_.size() + i] = static_cast<T>(value);
+    }
+
+    Real get(Size i, Size j, Size k, Size d) const override {
+        this->check(i, j, k, d);
+        return static_cast<Real>(data_[offset(i, j) + d * samples_ + k]);
+    }
+
+    void set(Real value, Size i, Size j, Size k, Size d) override {
+        this->check(i, j, k, d);
+        checkWritable();
+        data_[offset(i, j) + d * samples_ + k] = static_cast<T>(value);
+    }
+
+    void getSamples(std::vector<Real>& result, Size i, Size j, Size d) const override {
+        this->check(i, j, 0, d);
+        result.resize(samples_);
+        const T* block = data_ + offset(i, j) + d * samples_;
+        std::copy(block, block + samples_, result.begin());
+    }
+
+    bool usesDoublePrecision() const override;
+
+private:
+    std::size_t offset(Size i, Size j) const { return (i * dates_.size() + j) * depth_ * samples_; }
+
+    void check(Size i, Size j, Size k, Size d) const {
+        QL_REQUIRE(i < numIds(), "Out of bounds on ids (i=" << i << ", numIds=" << numIds() << ")");
+        QL_REQUIRE(j < numDates(), "Out of bounds on dates (j=" << j << ", numDates=" << numDates() << ")");
+        QL_REQUIRE(k < samples(), "Out of bounds on samples (k=" << k << ", samples=" << samples() << ")");
+        QL_REQUIRE(d < depth(), "Out of bounds on depth (d=" << d << ", depth=" << depth() << ")");
+    }
+
+    void checkWritable() const {
+        QL_REQUIRE(file_->flags() != boost::iostreams::mapped_file::readonly,
+                   "MappedNPVCube: can not set values, file is mapped read-only");
+    }
+
+    QuantLib::ext::shared_ptr<boost::iostreams::mapped_file> file_;
+    QuantLib::Date asof_;
+    std::vector<QuantLib::Date> dates_;
+    Size samples_;
+    Size depth_;
+    std::map<std::string, Size> idIdx_;
+
+    T* t0data_;
+    T* data_;
+};
+
+// specialisations are defined in mappednpvcube.cpp
+template <> bool MappedNPVCube<double>::usesDoublePrecision() const;
+template <> bool MappedNPVCube<float>::usesDoublePrecision() const;
+
+} // namespace analytics
+} // namespace ore
@@ -108,6 +108,17 @@ public:
         set(value, index(id), index(date), sample, depth);
     }
 
+    /*! Bulk accessors, these allow to stream through the cube instead of calling get() / set() per element. The
+        default implementations loop over get() / set(), implementations that store the values contiguously should
+        override them. */
+
+    //! Get the values for all samples for a given id, date and depth, result is resized to samples()
+    virtual void getSamples(std::vector<Real>& result, Size id, Size date, Size depth = 0) const;
+    //! Set the values for all samples for a given id, date and depth, values must have size samples()
+    virtual void setSamples(const std::vector<Real>& values, Size id, Size date, Size depth = 0);
+    //! Get the values for all ids for a given date, sample and depth, result is resized to numIds()
+    virtual void getIds(std::vector<Real>& result, Size date, Size sample, Size depth = 0) const;
+
     /*! Remove t0 values for a given id */
     virtual void removeT0(Size id);
 
@@ -136,6 +147,26 @@ protected:
 
 // impl
 
+inline void NPVCube::getSamples(std::vector<Real>& result, Size id, Size date, Size depth) const {
+    result.resize(samples());
+    for (Size k = 0; k < result.size(); ++k)
+        result[k] = get(id, date, k, depth);
+}
+
+inline void NPVCube::setSamples(const std::vector<Real>& values, Size id, Size date, Size depth) {
+    QL_REQUIRE(values.size() == samples(),
+               "NPVCube::setSamples(): values size (" << values.size() << ") does not match samples (" << samples()
+                                                      << ")");
+    for (Size k = 0; k < values.size(); ++k)
+        set(values[k], id, date, k, depth);
+}
+
+inline void NPVCube::getIds(std::vector<Real>& result, Size date, Size sample, Size depth) const {
+    result.resize(numIds());
+    for (Size i = 0; i < result.size(); ++i)
+        result[i] = get(i, date, sample, depth);
+}
+
 inline void NPVCube::removeT0(Size id) {
     for (Size depth = 0; depth < this->depth(); ++depth) {
         setT0(0.0, id, depth);
@@ -23,6 +23,8 @@
 
 #include <boost/range/adaptor/indexed.hpp>
 
+#include <algorithm>
+
 using namespace QuantLib;
 using namespace std;
 
@@ -50,6 +52,16 @@ index(const ore::analytics::RiskFactorKey& k,
     return it->second;
 }
 
+Real scaling(const SensitivityCube::FactorData& fd) {
+    if (fd.targetShiftSize == 0.0 || fd.actualShiftSize == 0) {
+        WLOG("Sensitivity Calculation: Scaling from different shift size is not possible, if that is configured. No "
+             "shift sizes available for '"
+             << fd.rfkey << "', check consistency of simulation and sensitivity config.");
+        return 1.0;
+    }
+    return fd.targetShiftSize / fd.actualShiftSize;
+}
+
 } // namespace
 
 std::ostream& operator<<(std::ostream& out, const SensitivityCube::crossPair& cp) {
@@ -112,7 +124,6 @@ void SensitivityCube::initialise() {
                                                               << des.key1() << "]");
             factors_.insert(des.key1());
             upFactors_[des.key1()] = fd;
-            upIndexToKey_[fd.index] = des.key1();
             break;
         case ShiftScenarioDescription::Type::Down:
             QL_REQUIRE(downFactors_.count(des.key1()) == 0, "Cannot have multiple down factors with "
@@ -120,7 +131,6 @@ void SensitivityCube::initialise() {
                                                                 << des.key1() << "]");
             factors_.insert(des.key1());
             downFactors_[des.key1()] = fd;
-            downIndexToKey_[fd.index] = des.key1();
             break;
         case ShiftScenarioDescription::Type::Cross:
             factorPair = make_pair(des.key1(), des.key2());
@@ -142,18 +152,40 @@ void SensitivityCube::initialise() {
         FactorData id_2 = index(cf.first.second, upFactors_);
         crossFactors_[cf.first] = make_tuple(id_1, id_2, cf.second);
     }
+
+    // Assign the factor ids in the order of factors_ and precompute the scalings used in delta() and gamma()
+    factorKeys_.assign(factors_.begin(), factors_.end());
+    factorIndices_.resize(factorKeys_.size());
+    scenarioFactorIds_.assign(scenarioDescriptions_.size(), Null<Size>());
+    for (Size id = 0; id < factorKeys_.size(); ++id) {
+        FactorIndices& f = factorIndices_[id];
+        if (auto s = shiftSchemes_.find(factorKeys_[id]); s != shiftSchemes_.end()) {
+            f.hasShiftScheme = true;
+            f.shiftScheme = s->second;
+        }
+        if (auto d = downFactors_.find(factorKeys_[id]); d != downFactors_.end()) {
+            f.down = d->second.index;
+            f.data = d->second;
+            if (f.hasShiftScheme && f.shiftScheme == ShiftScheme::Backward)
+                f.downScaling = scaling(d->second);
+            scenarioFactorIds_[f.down] = id;
+        }
+        if (auto u = upFactors_.find(factorKeys_[id]); u != upFactors_.end()) {
+            f.up = u->second.index;
+            f.data = u->second;
+            f.upScaling = scaling(u->second);
+            scenarioFactorIds_[f.up] = id;
+        }
+    }
 }
 
 bool SensitivityCube::hasTrade(const string& tradeId) const { return tradeIdx_.count(tradeId) > 0; }
 
 RiskFactorKey SensitivityCube::upDownFactor(const Size index) const {
-    if (auto k = upIndexToKey_.find(index); k != upIndexToKey_.end()) {
-        return k->second;
-    } else if (auto k = downIndexToKey_.find(index); k != downIndexToKey_.end()) {
-        return k->second;
-    } else {
+    if (Size id = scenarioFactorId(index); id != Null<Size>())
+        return factorKeys_[id];
+    else
         return RiskFactorKey();
-    }
 }
 
 SensitivityCube::FactorData SensitivityCube::upThenDownFactorData(const RiskFactorKey& rfkey) {
@@ -214,36 +246,10 @@ Real SensitivityCube::npv(const string& tradeId) const { return cube_->getT0(tra
 
 Real SensitivityCube::npv(Size id) const { return cube_->getT0(id, 0); }
 
-namespace {
-Real scaling(const SensitivityCube::FactorData& fd) {
-    if (fd.targetShiftSize == 0.0 || fd.actualShiftSize == 0) {
-        WLOG("Sensitivity Calculation: Scaling from different shift size is not possible, if that is configured. No "
-             "shift sizes available for '"
-             << fd.rfkey << "', check consistency of simulation and sensitivity config.");
-        return 1.0;
-    }
-    return fd.targetShiftSize / fd.actualShiftSize;
-}
-} // namespace
-
 Real SensitivityCube::delta(const Size tradeIdx, const RiskFactorKey& riskFactorKey) const {
-    auto s = shiftSchemes_.find(riskFactorKey);
-    QL_REQUIRE(s != shiftSchemes_.end(),
-               "SensitivityCube::delta(" << tradeIdx << ", " << riskFactorKey << "): no shift scheme stored.");
-    if (s->second == ShiftScheme::Forward) {
-        auto fd = index(riskFactorKey, upFactors_);
-        return (cube_->get(tradeIdx, fd.index) - cube_->getT0(tradeIdx, 0)) * scaling(fd);
-    } else if (s->second == ShiftScheme::Backward) {
-        auto fd = index(riskFactorKey, downFactors_);
-        return (cube_->getT0(tradeIdx, 0) - cube_->get(tradeIdx, fd.index)) * scaling(fd);
-    } else if (s->second == ShiftScheme::Central) {
-        auto fdup = index(riskFactorKey, upFactors_);
-        auto fddown = index(riskFactorKey, downFactors_);
-        return (cube_->get(tradeIdx, fdup.index) - cube_->get(tradeIdx, fddown.index)) / 2.0 * scaling(fdup);
-    } else {
-        QL_FAIL("SensitivityCube::delta(" << tradeIdx << ", " << riskFactorKey << "): unknown shift scheme '"
-                                          << s->second << "'");
-    }
+    Size id = factorId(riskFactorKey);
+    QL_REQUIRE(id != Null<Size>(), "Key, " << riskFactorKey << ", was not found in the sensitivity cube.");
+    return delta(tradeIdx, id);
 }
 
 Real SensitivityCube::delta(const string& tradeId, const RiskFactorKey& riskFactorKey) const {
@@ -251,12 +257,9 @@ Real SensitivityCube::delta(const string& tradeId, const RiskFactorKey& riskFact
 }
 
 Real SensitivityCube::gamma(const Size tradeIdx, const RiskFactorKey& riskFactorKey) const {
-    auto fdup = index(riskFactorKey, upFactors_);
-    auto fddown = index(riskFactorKey, downFactors_);
-    Real baseNpv = cube_->getT0(tradeIdx, 0);
-    Real upNpv = cube_->get(tradeIdx, fdup.index);
-    Real downNpv = cube_->get(tradeIdx, fddown.index);
-    return (upNpv - 2.0 * baseNpv + downNpv) * std::pow(scaling(fdup), 2);
+    Size id = factorId(riskFactorKey);
+    QL_REQUIRE(id != Null<Size>(), "Key, " << riskFactorKey << ", was not found in the sensitivity cube.");
+    return gamma(tradeIdx, id);
 }
 
 Real SensitivityCube::gamma(const string& tradeId, const RiskFactorKey& riskFactorKey) const {
@@ -297,5 +300,146 @@ std::set<RiskFactorKey> SensitivityCube::relevantRiskFactors() const {
     return result;
 }
 
+const RiskFactorKey& SensitivityCube::factorKey(const Size factorId) const {
+    QL_REQUIRE(factorId < factorKeys_.size(), "SensitivityCube::factorKey(): factor id "
+                                                  << factorId << " out of range, cube has " << numFactors()
+                                                  << " factors");
+    return factorKeys_[factorId];
+}
+
+Size SensitivityCube::factorId(const RiskFactorKey& riskFactorKey) const {
+    auto it = std::lower_bound(factorKeys_.begin(), factorKeys_.end(), riskFactorKey);
+    if (it == factorKeys_.end() || *it != riskFactorKey)
+        return Null<Size>();
+    return std::distance(factorKeys_.begin(), it);
+}
+
+Size SensitivityCube::scenarioFactorId(const Size scenarioIdx) const {
+    return scenarioIdx < scenarioFactorIds_.size() ? scenarioFactorIds_[scenarioIdx] : Null<Size>();
+}
+
+const SensitivityCube::FactorData& SensitivityCube::factorData(const Size factorId) const {
+    QL_REQUIRE(factorId < factorIndices_.size(), "SensitivityCube::factorData(): factor id "
+                                                     << factorId << " out of range, cube has " << numFactors()
+                                                     << " factors");
+    return factorIndices_[factorId].data;
+}
+
+bool SensitivityCube::hasDelta(const FactorIndices& f) {
+    if (!f.hasShiftScheme)
+        return false;
+    switch (f.shiftScheme) {
+    case ShiftScheme::Forward:
+        return f.up != Null<Size>();
+    case ShiftScheme::Backward:
+        return f.down != Null<Size>();
+    case ShiftScheme::Central:
+        return f.up != Null<Size>() && f.down != Null<Size>();
+    default:
+        return false;
+    }
+}
+
+const SensitivityCube::FactorIndices& SensitivityCube::checkedFactorIndices(const std::string& method,
+                                                                            const Size factorId,
+                                                                            const bool gamma) const {
+    QL_REQUIRE(factorId < factorIndices_.size(), "SensitivityCube::" << method << "(): factor id " << factorId
+                                                                     << " out of range, cube has " << numFactors()
+                                                                     << " factors");
+    const FactorIndices& f = factorIndices_[factorId];
+    if (gamma) {
+        QL_REQUIRE(hasGamma(f), "SensitivityCube::" << method << "(): no up and down shift for "
+                                                    << factorKeys_[factorId]);
+    } else {
+        QL_REQUIRE(f.hasShiftScheme,
+                   "SensitivityCube::" << method << "(): no shift scheme stored for " << factorKeys_[factorId]);
+        QL_REQUIRE(hasDelta(f), "SensitivityCube::" << method << "(): shifts required by shift scheme '"
+                                                    << f.shiftScheme << "' not found for " << factorKeys_[factorId]);
+    }
+    return f;
+}
+
+Real SensitivityCube::delta(const FactorIndices& f, const Real baseNpv, const Real upNpv, const Real downNpv) const {
+    if (f.shiftScheme == ShiftScheme::Forward)
+        return (upNpv - baseNpv) * f.upScaling;
+    else if (f.shiftScheme == ShiftScheme::Backward)
+        return (baseNpv - downNpv) * f.downScaling;
+    else
+        return (upNpv - downNpv) / 2.0 * f.upScaling;
+}
+
+Real SensitivityCube::gamma(const FactorIndices& f, const Real baseNpv, const Real upNpv, const Real downNpv) const {
+    return (upNpv - 2.0 * baseNpv + downNpv) * std::pow(f.upScaling, 2);
+}
+
+Real SensitivityCube::delta(const Size tradeIdx, const Size factorId) const {
+    const FactorIndices& f = checkedFactorIndices("delta", factorId, false);
+    // only look up the npvs used by the shift scheme
+    Real baseNpv = f.shiftScheme != ShiftScheme::Central ? cube_->getT0(tradeIdx, 0) : 0.0;
+    Real upNpv = f.shiftScheme != ShiftScheme::Backward ? cube_->get(tradeIdx, f.up) : 0.0;
+    Real downNpv = f.shiftScheme != ShiftScheme::Forward ? cube_->get(tradeIdx, f.down) : 0.0;
+    return delta(f, baseNpv, upNpv, downNpv);
+}
+
+Real SensitivityCube::gamma(const Size tradeIdx, const Size factorId) const {
+    const FactorIndices& f = checkedFactorIndices("gamma", factorId, true);
+    return gamma(f, cube_->getT0(tradeIdx, 0), cube_->get(tradeIdx, f.up), cube_->get(tradeIdx, f.down));
+}
+
+void SensitivityCube::deltas(const Size tradeIdx, std::vector<Real>& result) const {
+    // scenario npvs of the trade, the cube returns the base npv for scenarios that are not stored
+    Real baseNpv = cube_->getT0(tradeIdx, 0);
+    std::vector<Real> npvs(scenarioDescriptions_.size(), baseNpv);
+    for (auto const& [idx, npv] : cube_->getTradeNPVs(tradeIdx)) {
+        if (idx < npvs.size())
+            npvs[idx] = npv;
+    }
+    result.resize(factorIndices_.size());
+    for (Size id = 0; id < factorIndices_.size(); ++id) {
+        const FactorIndices& f = factorIndices_[id];
+        result[id] = hasDelta(f) ? delta(f, baseNpv, f.up == Null<Size>() ? 0.0 : npvs[f.up],
+                                         f.down == Null<Size>() ? 0.0 : npvs[f.down])
+                                 : Null<Real>();
+    }
+}
+
+void SensitivityCube::gammas(const Size tradeIdx, std::vector<Real>& result) const {
+    Real baseNpv = cube_->getT0(tradeIdx, 0);
+    std::vector<Real> npvs(scenarioDescriptions_.size(), baseNpv);
+    for (auto const& [idx, npv] : cube_->getTradeNPVs(tradeIdx)) {
+        if (idx < npvs.size())
+            npvs[idx] = npv;
+    }
+    result.resize(factorIndices_.size());
+    for (Size id = 0; id < factorIndices_.size(); ++id) {
+        const FactorIndices& f = factorIndices_[id];
+        result[id] = hasGamma(f) ? gamma(f, baseNpv, npvs[f.up], npvs[f.down]) : Null<Real>();
+    }
+}
+
+void SensitivityCube::factorDeltas(const Size factorId, std::vector<Real>& result) const {
+    const FactorIndices& f = checkedFactorIndices("factorDeltas", factorId, false);
+    std::vector<Real> upNpvs, downNpvs;
+    if (f.shiftScheme != ShiftScheme::Backward)
+        cube_->getIds(upNpvs, 0, f.up);
+    if (f.shiftScheme != ShiftScheme::Forward)
+        cube_->getIds(downNpvs, 0, f.down);
+    result.resize(cube_->numIds());
+    for (Size i = 0; i < result.size(); ++i) {
+        result[i] = delta(f, f.shiftScheme != ShiftScheme::Central ? cube_->getT0(i, 0) : 0.0,
+                          upNpvs.empty() ? 0.0 : upNpvs[i], downNpvs.empty() ? 0.0 : downNpvs[i]);
+    }
+}
+
+void SensitivityCube::factorGammas(const Size factorId, std::vector<Real>& result) const {
+    const FactorIndices& f = checkedFactorIndices("factorGammas", factorId, true);
+    std::vector<Real> upNpvs, downNpvs;
+    cube_->getIds(upNpvs, 0, f.up);
+    cube_->getIds(downNpvs, 0, f.down);
+    result.resize(cube_->numIds());
+    for (Size i = 0; i < result.size(); ++i)
+        result[i] = gamma(f, cube_->getT0(i, 0), upNpvs[i], downNpvs[i]);
+}
+
 } // namespace analytics
 } // namespace ore
@@ -39,6 +39,9 @@ namespace ore {
 namespace analytics {
 
 //! SensitivityCube is a wrapper for an npvCube that gives easier access to the underlying cube elements
+/*! The factors() are numbered 0, 1, 2, ... in their (sorted) order on construction. The methods taking a factor id
+    instead of a risk factor key avoid the map lookups of the key based methods, the bulk methods return the deltas and
+    gammas for all factors of a trade resp. for all trades of a factor at once. */
 class SensitivityCube {
 
 public:
@@ -150,7 +153,72 @@ public:
     //! Get the relevant risk factors
     std::set<RiskFactorKey> relevantRiskFactors() const;
 
+    //! \name Factor id based access
+    //@{
+    //! Number of factors, the factor ids are 0, ..., numFactors() - 1
+    QuantLib::Size numFactors() const { return factorKeys_.size(); }
+
+    //! Risk factor key for factor id \p factorId
+    const RiskFactorKey& factorKey(const QuantLib::Size factorId) const;
+
+    //! Factor id for risk factor key \p riskFactorKey, Null<Size>() if the key is not in factors()
+    QuantLib::Size factorId(const RiskFactorKey& riskFactorKey) const;
+
+    //! Factor id for the up or down scenario with index \p scenarioIdx, Null<Size>() for other scenarios
+    QuantLib::Size scenarioFactorId(const QuantLib::Size scenarioIdx) const;
+
+    //! Factor data of the up shift for factor id \p factorId, if that does not exist of the down shift
+    const FactorData& factorData(const QuantLib::Size factorId) const;
+
+    //! Get the trade delta for trade with index \p tradeIdx and factor id \p factorId
+    QuantLib::Real delta(const Size tradeIdx, const Size factorId) const;
+
+    //! Get the trade gamma for trade with index \p tradeIdx and factor id \p factorId
+    QuantLib::Real gamma(const Size tradeIdx, const Size factorId) const;
+
+    /*! Get the deltas for trade with index \p tradeIdx for all factor ids, the result is resized to numFactors(),
+        Null<Real>() is returned for factors for which no delta can be computed */
+    void deltas(const Size tradeIdx, std::vector<QuantLib::Real>& result) const;
+
+    /*! Get the gammas for trade with index \p tradeIdx for all factor ids, the result is resized to numFactors(),
+        Null<Real>() is returned for factors without both an up and a down shift */
+    void gammas(const Size tradeIdx, std::vector<QuantLib::Real>& result) const;
+
+    /*! Get the deltas for factor id \p factorId for all trade indices, the result is resized to the number of
+        trades in the cube, throws if no delta can be computed for the factor */
+    void factorDeltas(const Size factorId, std::vector<QuantLib::Real>& result) const;
+
+    /*! Get the gammas for factor id \p factorId for all trade indices, the result is resized to the number of
+        trades in the cube, throws if the factor does not have both an up and a down shift */
+    void factorGammas(const Size factorId, std::vector<QuantLib::Real>& result) const;
+    //@}
+
 private:
+    // scenario indices and scalings by factor id, the scalings are only set where they are used
+    struct FactorIndices {
+        QuantLib::Size up = QuantLib::Null<QuantLib::Size>();
+        QuantLib::Size down = QuantLib::Null<QuantLib::Size>();
+        bool hasShiftScheme = false;
+        ShiftScheme shiftScheme = ShiftScheme::Forward;
+        QuantLib::Real upScaling = 1.0, downScaling = 1.0;
+        FactorData data;
+    };
+
+    //! True if there is a shift scheme and the shifts it requires for the delta
+    static bool hasDelta(const FactorIndices& f);
+    //! True if there is an up and a down shift
+    static bool hasGamma(const FactorIndices& f) {
+        return f.up != QuantLib::Null<QuantLib::Size>() && f.down != QuantLib::Null<QuantLib::Size>();
+    }
+    //! Check that a delta resp. gamma can be computed for factor id \p factorId
+    const FactorIndices& checkedFactorIndices(const std::string& method, const Size factorId, const bool gamma) const;
+    //! Delta from the given npvs, requires hasDelta(f), the npvs of shifts not used by the shift scheme are ignored
+    QuantLib::Real delta(const FactorIndices& f, const QuantLib::Real baseNpv, const QuantLib::Real upNpv,
+                         const QuantLib::Real downNpv) const;
+    //! Gamma from the given npvs, requires hasGamma(f)
+    QuantLib::Real gamma(const FactorIndices& f, const QuantLib::Real baseNpv, const QuantLib::Real upNpv,
+                         const QuantLib::Real downNpv) const;
+
     //! Initialise method used by the constructors
     void initialise();
 
@@ -174,11 +242,14 @@ private:
     // crossFactor)
     std::map<crossPair, std::tuple<FactorData, FactorData, QuantLib::Size>> crossFactors_;
 
-    // map of up / down / cross factor index to risk factor key
-    std::map<QuantLib::Size, RiskFactorKey> upIndexToKey_;
-    std::map<QuantLib::Size, RiskFactorKey> downIndexToKey_;
+    // map of cross factor index to risk factor key pair
     std::map<QuantLib::Size, crossPair> crossIndexToKey_;
 
+    // risk factor keys and scenario indices by factor id, factor id by scenario index (Null if not up or down)
+    std::vector<RiskFactorKey> factorKeys_;
+    std::vector<FactorIndices> factorIndices_;
+    std::vector<QuantLib::Size> scenarioFactorIds_;
+
 };
 
 std::ostream& operator<<(std::ostream& out, const SensitivityCube::crossPair& cp);
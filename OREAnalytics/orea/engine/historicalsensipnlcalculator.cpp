@@ -21,21 +21,56 @@
 #include <orea/engine/historicalsensipnlcalculator.hpp>
 #include <ored/utilities/to_string.hpp>
 
-#include <boost/accumulators/statistics/tail_quantile.hpp>
+#include <qle/utilities/workerpool.hpp>
+
 #include <boost/range/adaptor/indexed.hpp>
 
+#include <numeric>
+#include <unordered_map>
+
 using namespace std;
 using namespace QuantLib;
-using namespace boost::accumulators;
 
 namespace {
- 
-using TradeSensiCache = map<Size, map<Size, pair<Real, Real>>>;
+
+// number of scenarios merged into the covariance in one rank-k update
+constexpr Size covarianceBlockSize = 64;
+
+using ore::analytics::RiskFactorKey;
 using ore::analytics::SensitivityRecord;
 
-void cacheTradeSensitivities(TradeSensiCache& cache, ore::analytics::SensitivityStream& ss,
-                             const set<SensitivityRecord>& srs,
-                             const vector<string>& tradeIds) {
+// a sensitivity record with the columns of its keys in the shift matrix, col_2 is null unless it is a cross gamma
+struct IndexedSensitivity {
+    Size col_1, col_2;
+    Real delta, gamma;
+};
+
+// delta and gamma of a trade w.r.t. the risk factor(s) of a sensitivity record
+struct TradeSensitivity {
+    Size record;
+    Real delta, gamma;
+};
+
+// trade level sensitivities as a sparse trade x record matrix in compressed row format, the entries of trade t are
+// entries[rowBegin[t]], ..., entries[rowBegin[t + 1] - 1] ordered by record
+struct TradeSensitivities {
+    vector<Size> rowBegin;
+    vector<TradeSensitivity> entries;
+};
+
+TradeSensitivities cacheTradeSensitivities(ore::analytics::SensitivityStream& ss, const set<SensitivityRecord>& srs,
+                                           const vector<string>& tradeIds) {
+
+    // The sensitivity records are matched on their keys to the passed in records, the first match wins.
+    map<pair<RiskFactorKey, RiskFactorKey>, Size> recordIndex;
+    for (const auto elem : srs | boost::adaptors::indexed(0))
+        recordIndex.emplace(make_pair(elem.value().key_1, elem.value().key_2), elem.index());
+
+    unordered_map<string, Size> tradeIndex;
+    for (Size t = 0; t < tradeIds.size(); ++t)
+        tradeIndex.emplace(tradeIds[t], t);
+
+    vector<map<Size, pair<Real, Real>>> byTrade(tradeIds.size());
 
     // Reset the stream to ensure at start.
     ss.reset();
@@ -44,97 +79,171 @@ void cacheTradeSensitivities(TradeSensiCache& cache, ore::analytics::Sensitivity
     while (SensitivityRecord sr = ss.next()) {
 
         // Sensitivity record is only relevant if it is in our set of trade IDs
-        auto itTrade = find(tradeIds.begin(), tradeIds.end(), sr.tradeId);
-        if (itTrade == tradeIds.end())
+        auto itTrade = tradeIndex.find(sr.tradeId);
+        if (itTrade == tradeIndex.end())
             continue;
 
         // This sensitivity record should be in the set of passed in sensitivity records.
-        auto itSr = find_if(srs.begin(), srs.end(), [&sr](const SensitivityRecord& other) {
-            return sr.key_1 == other.key_1 && sr.key_2 == other.key_2;
-        });
-
-        // Positions for the cache keys.
-        auto posTrade = distance(tradeIds.begin(), itTrade);
-        auto posSr = distance(srs.begin(), itSr);
-
-        // Add the sensitivity record values to the cache.
-        auto itCacheSr = cache.find(posSr);
-        if (itCacheSr == cache.end()) {
-            cache[posSr][posTrade] = make_pair(sr.delta, sr.gamma);
-        } else {
-            auto itCacheTrade = itCacheSr->second.find(posTrade);
-            if (itCacheTrade == itCacheSr->second.end()) {
-                itCacheSr->second[posTrade] = make_pair(sr.delta, sr.gamma);
-            } else {
-                auto& p = itCacheTrade->second;
-                p.first += sr.delta;
-                p.second += sr.gamma;
-            }
-        }
+        auto itSr = recordIndex.find(make_pair(sr.key_1, sr.key_2));
+        if (itSr == recordIndex.end())
+            continue;
+
+        auto& p = byTrade[itTrade->second][itSr->second];
+        p.first += sr.delta;
+        p.second += sr.gamma;
     }
 
     // Reset the stream to ensure at start.
     ss.reset();
-}
 
+    TradeSensitivities result;
+    result.rowBegin.reserve(tradeIds.size() + 1);
+    for (const auto& row : byTrade) {
+        result.rowBegin.push_back(result.entries.size());
+        for (const auto& [record, s] : row)
+            result.entries.push_back({record, s.first, s.second});
+    }
+    result.rowBegin.push_back(result.entries.size());
+    return result;
 }
 
+} // namespace
+
 namespace ore {
 namespace analytics {
 
+CovarianceCalculator::CovarianceCalculator(ore::data::TimePeriod covariancePeriod,
+                                           const QuantLib::ext::shared_ptr<QuantExt::WorkerPool>& workerPool,
+                                           const Real decayFactor)
+    : covariancePeriod_(covariancePeriod), decayFactor_(decayFactor), workerPool_(workerPool) {
+    QL_REQUIRE(decayFactor_ > 0.0 && decayFactor_ <= 1.0,
+               "CovarianceCalculator: decay factor (" << decayFactor_ << ") must be in (0, 1]");
+}
+
 void CovarianceCalculator::initialise(const set<pair<RiskFactorKey, Size>>& keys) {
-    // Set up the boost accumulators that will calculate the covariance between the time series of historical shifts for
-    // each relevant risk factor key i.e. the risk factor keys in the set keys over the benchmark period
-    
-    for (auto ito = keys.begin(); ito != keys.end(); ito++) {
-        accCov_[make_pair(ito->second, ito->second)] = accumulator();
-        for (auto iti = keys.begin(); iti != ito; iti++) {
-            accCov_[make_pair(iti->second, ito->second)] = accumulator();
-        }
-    }
+    // Set up the running moments of the time series of historical shifts for each relevant risk factor key i.e. the
+    // risk factor keys in the set keys over the benchmark period
+    cubeIndices_.clear();
+    for (const auto& k : keys)
+        cubeIndices_.push_back(k.second);
+    Size n = cubeIndices_.size();
+    block_.assign(covarianceBlockSize * n, 0.0);
+    blockRows_ = 0;
+    weight_ = 0.0;
+    mean_.assign(n, 0.0);
+    crossProducts_ = Matrix(n, n, 0.0);
+    samples_ = 0;
 }
 
 void CovarianceCalculator::updateAccumulators(const ext::shared_ptr<NPVCube>& shiftCube, Date startDate, Date endDate, Size index) {
     TLOG("Updating Covariance accumlators for sensitivity record " << index);
     if (covariancePeriod_.contains(startDate) &&
         covariancePeriod_.contains(endDate)) {
-        // Update the covariance accumulators if in benchmark period
-        for (auto it = accCov_.begin(); it != accCov_.end(); it++) {
-            Real oShift = shiftCube->get(it->first.first, 0, index);
-            if (it->first.first == it->first.second) {
-                it->second(oShift, covariate1 = oShift);
-            } else {
-                Real iShift = shiftCube->get(it->first.second, 0, index);
-                it->second(oShift, covariate1 = iShift);
+        // Collect the shifts if in benchmark period
+        Size n = cubeIndices_.size();
+        Real* row = block_.data() + blockRows_ * n;
+        for (Size i = 0; i < n; ++i)
+            row[i] = shiftCube->get(cubeIndices_[i], 0, index);
+        ++samples_;
+        if (++blockRows_ == covarianceBlockSize)
+            mergeBlock();
+    }
+}
+
+void CovarianceCalculator::mergeBlock() {
+    Size n = cubeIndices_.size();
+    Size k = blockRows_;
+    if (k == 0)
+        return;
+
+    // weights of the block's rows, the last row has weight 1
+    vector<Real> w(k, 1.0);
+    for (Size j = k - 1; j > 0; --j)
+        w[j - 1] = w[j] * decayFactor_;
+    Real blockWeight = std::accumulate(w.begin(), w.end(), 0.0);
+
+    // centre the rows on the block mean and scale them by the square root of their weights
+    vector<Real> blockMean(n, 0.0);
+    for (Size j = 0; j < k; ++j) {
+        const Real* row = block_.data() + j * n;
+        for (Size i = 0; i < n; ++i)
+            blockMean[i] += w[j] * row[i];
+    }
+    for (Size i = 0; i < n; ++i)
+        blockMean[i] /= blockWeight;
+    for (Size j = 0; j < k; ++j) {
+        Real* row = block_.data() + j * n;
+        Real sw = std::sqrt(w[j]);
+        for (Size i = 0; i < n; ++i)
+            row[i] = sw * (row[i] - blockMean[i]);
+    }
+
+    // merge with the running moments, the previous scenarios decay by lambda^k
+    Real decay = std::pow(decayFactor_, static_cast<Real>(k));
+    Real previousWeight = weight_ * decay;
+    Real totalWeight = previousWeight + blockWeight;
+    Real meanCorrection = previousWeight * blockWeight / totalWeight;
+    vector<Real> delta(n);
+    for (Size i = 0; i < n; ++i)
+        delta[i] = blockMean[i] - mean_[i];
+
+    auto updateRows = [this, n, k, decay, meanCorrection, &delta](std::size_t begin, std::size_t end, std::size_t) {
+        for (Size i = begin; i < end; ++i) {
+            Real* c = crossProducts_.row_begin(i);
+            if (decay != 1.0) {
+                for (Size l = i; l < n; ++l)
+                    c[l] *= decay;
+            }
+            for (Size j = 0; j < k; ++j) {
+                const Real* row = block_.data() + j * n;
+                Real a = row[i];
+                if (a == 0.0)
+                    continue;
+                for (Size l = i; l < n; ++l)
+                    c[l] += a * row[l];
             }
+            Real a = meanCorrection * delta[i];
+            for (Size l = i; l < n; ++l)
+                c[l] += a * delta[l];
         }
-    }
+    };
+    if (workerPool_)
+        workerPool_->parallelFor(n, 8, updateRows);
+    else
+        updateRows(0, n, 0);
+
+    for (Size i = 0; i < n; ++i)
+        mean_[i] += delta[i] * blockWeight / totalWeight;
+    weight_ = totalWeight;
+    blockRows_ = 0;
 }
 
 void CovarianceCalculator::populateCovariance(const std::set<std::pair<RiskFactorKey, QuantLib::Size>>& keys) {
     LOG("Populate the covariance matrix with the calculated covariances");
-    covariance_ = Matrix(keys.size(), keys.size());
-    correlation_ = Matrix(keys.size(), keys.size());
-    Size i = 0;
-    for (auto ito = keys.begin(); ito != keys.end(); ito++) {
-        covariance_[i][i] = boost::accumulators::covariance(accCov_.at(make_pair(ito->second, ito->second)));
+    QL_REQUIRE(keys.size() == cubeIndices_.size(), "CovarianceCalculator: got " << keys.size()
+                                                       << " keys, expected " << cubeIndices_.size()
+                                                       << " as passed to initialise()");
+    mergeBlock();
+    Size n = keys.size();
+    covariance_ = Matrix(n, n, 0.0);
+    correlation_ = Matrix(n, n, 0.0);
+    if (weight_ > 0.0) {
+        for (Size i = 0; i < n; ++i) {
+            for (Size j = i; j < n; ++j)
+                covariance_[i][j] = covariance_[j][i] = crossProducts_[i][j] / weight_;
+        }
+    }
+    for (Size i = 0; i < n; ++i) {
         correlation_[i][i] = 1.0;
-        Real var_i = boost::accumulators::variance(accCov_.at(std::make_pair(ito->second, ito->second)));
-        Size j = 0;
-        for (auto iti = keys.begin(); iti != ito; iti++) {
-            Size key_j = iti->second;
-            covariance_[i][j] = covariance_[j][i] =
-                boost::accumulators::covariance(accCov_.at(make_pair(iti->second, ito->second)));
-            const auto& acc_jj = accCov_.at(std::make_pair(key_j, key_j));
-            Real var_j = boost::accumulators::variance(acc_jj);
+        Real var_i = covariance_[i][i];
+        for (Size j = 0; j < i; ++j) {
+            Real var_j = covariance_[j][j];
             Real corr_ij = 0.0;
             if (var_i > 0.0 && var_j > 0.0) {
                 corr_ij = covariance_[i][j] / (std::sqrt(var_i) * std::sqrt(var_j));
             }
             correlation_[i][j] = correlation_[j][i] = corr_ij;
-            j++;
         }
-        i++;
     }
 }
 
@@ -229,225 +338,254 @@ void HistoricalSensiPnlCalculator::calculateSensiPnl(
                    "Could not find key " << *it << " in sensi shift cube keys");
         keys.insert(make_pair(*it, it1->second));
     }
-    // Create an index pair for each sensitivity record. The first element holds the index position
-    // in the sensi shift cube of key_1. The second element holds the index of key_2 for cross
-    // gamma record.
-    vector<pair<Size, Size>> srsIndex;
-    for (auto it = srs.begin(); it != srs.end(); it++) {
-        auto it1 = shiftCube->idsAndIndexes().find(ore::data::to_string(it->key_1));
-        QL_REQUIRE(it1 != shiftCube->idsAndIndexes().end(),
-                   "Could not find key " << it->key_1 << " in sensi shift cube keys");
-        Size ind_1 = it1->second;
-        Size ind_2 = Size();
-        if (it->isCrossGamma()) {
-            auto it2 = shiftCube->idsAndIndexes().find(ore::data::to_string(it->key_2));
-            QL_REQUIRE(it2 != shiftCube->idsAndIndexes().end(),
-                       "Could not find key " << it->key_2 << " in sensi shift cube keys");
-            ind_2 = it2->second;
-        }
-        srsIndex.push_back(make_pair(ind_1, ind_2));
-    }
+
+    // Index the sensitivity records by the columns of their keys in the shift matrix. The columns are the distinct
+    // sensi shift cube indices of key_1 and, for cross gamma records, key_2.
+    map<Size, Size> columns;
+    vector<Size> cubeIndices;
+    auto column = [&shiftCube, &columns, &cubeIndices](const RiskFactorKey& key) {
+        auto it = shiftCube->idsAndIndexes().find(ore::data::to_string(key));
+        QL_REQUIRE(it != shiftCube->idsAndIndexes().end(), "Could not find key " << key << " in sensi shift cube keys");
+        auto c = columns.emplace(it->second, cubeIndices.size());
+        if (c.second)
+            cubeIndices.push_back(it->second);
+        return c.first->second;
+    };
+    vector<IndexedSensitivity> records;
+    records.reserve(srs.size());
+    for (const auto& sr : srs)
+        records.push_back(
+            {column(sr.key_1), sr.isCrossGamma() ? column(sr.key_2) : Null<Size>(), sr.delta, sr.gamma});
 
     if (covarianceCalculator)
         covarianceCalculator->initialise(keys);
 
     // we require a sensitivity stream to run at trade level
     bool runTradeLevel = tradeLevel && sensitivityStream_;
+    bool runRiskFactorLevel = riskFactorLevel && sensitivityStream_;
 
-    // Local P&L vectors to hold _all_ historical P&Ls
     Size nScenarios = hisScenGen_->numScenarios();
     Size nCalculators = pnlCalculators.size();
-    vector<Real> allPnls(hisScenGen_->numScenarios(), 0.0);
-    vector<Real> allFoPnls(hisScenGen_->numScenarios(), 0.0);
-    
-    // calculators,scenarios, trades
-    using TradePnLStore = std::vector<std::vector<QuantLib::Real>>;
-    std::vector<TradePnLStore> tradePnls, foTradePnls;
-
-    // We may need to store trade level P&Ls.
-    if (runTradeLevel) {
-        tradePnls.clear();
-        tradePnls.reserve(nCalculators);
-        foTradePnls.clear();
-        foTradePnls.reserve(nCalculators);
-        for (Size i = 0; i < nCalculators; i++) {
-            tradePnls.push_back(std::vector<std::vector<QuantLib::Real>>());
-            tradePnls.at(i).reserve(nScenarios);
-            foTradePnls.push_back(std::vector<std::vector<QuantLib::Real>>());
-            foTradePnls.at(i).reserve(nScenarios);
-        }
-    }
-    using RiskFactorTradePnLStore = std::vector<std::map<std::string, std::vector<QuantLib::Real>>>;
+    Size nColumns = cubeIndices.size();
+    Size nTrades = tradeIds.size();
 
-    //calculators, scenarios, map<risk factors,  trades>
-    std::vector<RiskFactorTradePnLStore> riskFactorTradePnls, riskFactorFoTradePnls;
+    hisScenGen_->reset();
 
-    bool runRiskFactorLevel = riskFactorLevel && sensitivityStream_;
-    if (runRiskFactorLevel){
-        riskFactorTradePnls.clear();
-        riskFactorTradePnls.reserve(nCalculators);
-        riskFactorFoTradePnls.clear();
-        riskFactorFoTradePnls.reserve(nCalculators);
-        for (Size i = 0; i < nCalculators; i++) {
-            riskFactorTradePnls.push_back(std::vector<std::map<std::string, std::vector<QuantLib::Real>>>());
-            riskFactorTradePnls.at(i).reserve(nScenarios);
-            riskFactorFoTradePnls.push_back(std::vector<std::map<std::string, std::vector<QuantLib::Real>>>());
-            riskFactorFoTradePnls.at(i).reserve(nScenarios);
-        }
+    // Dense scenario x risk factor matrix of the historical shifts, one row per scenario
+    vector<Real> shifts(nScenarios * nColumns);
+    for (Size i = 0; i < nScenarios; ++i) {
+        for (Size c = 0; c < nColumns; ++c)
+            shifts[i * nColumns + c] = shiftCube->get(cubeIndices[c], 0, i);
     }
 
-    hisScenGen_->reset();
-    QuantLib::ext::shared_ptr<Scenario> baseScenario = hisScenGen_->baseScenario();
+    // Scenarios in the period of each calculator
+    vector<vector<bool>> inPeriod(nCalculators, vector<bool>(nScenarios));
+    vector<bool> anyInPeriod(nScenarios, false);
+    for (Size k = 0; k < nCalculators; ++k) {
+        for (Size i = 0; i < nScenarios; ++i) {
+            inPeriod[k][i] =
+                pnlCalculators[k]->isInTimePeriod(hisScenGen_->startDates()[i], hisScenGen_->endDates()[i]);
+            anyInPeriod[i] = anyInPeriod[i] || inPeriod[k][i];
+        }
+    }
 
     // If we have been asked for a trade level P&L contribution report or detail report, store the trade level
-    // sensitivities. We store them in a container here that is easily looked up in the loop below.
-    TradeSensiCache tradeSensiCache;
-    if (runTradeLevel || runRiskFactorLevel) {
-        cacheTradeSensitivities(tradeSensiCache, *sensitivityStream_, srs, tradeIds);
+    // sensitivities as a sparse trade x record matrix.
+    TradeSensitivities tradeSensis;
+    if (runTradeLevel || runRiskFactorLevel)
+        tradeSensis = cacheTradeSensitivities(*sensitivityStream_, srs, tradeIds);
+
+    // For the risk factor level P&Ls, the risk factor of each record as an index into the sorted risk factor names
+    vector<string> riskFactorNames;
+    vector<Size> recordRiskFactor;
+    if (runRiskFactorLevel) {
+        map<string, Size> names;
+        vector<string> recordNames;
+        for (const auto& sr : srs) {
+            recordNames.push_back(QuantExt::reconstructFactor(sr.key_1, sr.desc_1));
+            names.emplace(recordNames.back(), 0);
+        }
+        for (auto& [name, index] : names) {
+            index = riskFactorNames.size();
+            riskFactorNames.push_back(name);
+        }
+        for (const auto& name : recordNames)
+            recordRiskFactor.push_back(names.at(name));
     }
 
-    // Loop over each historical
-    for (Size i = 0; i < hisScenGen_->numScenarios(); i++) {
-
-        // Add trade level P&L vector if needed.
-        if (runTradeLevel) {
-            for (Size j = 0; j < pnlCalculators.size(); j++) {
-                bool inPeriod =
-                    pnlCalculators.at(j)->isInTimePeriod(hisScenGen_->startDates()[i], hisScenGen_->endDates()[i]);
-                if (inPeriod) {
-                    tradePnls.at(j).push_back(vector<Real>(tradeIds.size(), 0.0));
-                    foTradePnls.at(j).push_back(vector<Real>(tradeIds.size(), 0.0));
+    // Local P&L vectors to hold _all_ historical P&Ls, and the trade and risk factor level P&Ls by scenario
+    vector<Real> allPnls(nScenarios, 0.0);
+    vector<Real> allFoPnls(nScenarios, 0.0);
+    using TradePnLStore = std::vector<std::vector<QuantLib::Real>>;
+    using RiskFactorTradePnLStore = std::vector<std::map<std::string, std::vector<QuantLib::Real>>>;
+    TradePnLStore scenarioTradePnls(runTradeLevel ? nScenarios : 0);
+    TradePnLStore scenarioFoTradePnls(runTradeLevel ? nScenarios : 0);
+    RiskFactorTradePnLStore scenarioRiskFactorPnls(runRiskFactorLevel ? nScenarios : 0);
+    RiskFactorTradePnLStore scenarioRiskFactorFoPnls(runRiskFactorLevel ? nScenarios : 0);
+
+    auto calculateScenarios = [&](std::size_t begin, std::size_t end, std::size_t) {
+        for (Size i = begin; i < end; ++i) {
+            const Real* s = shifts.data() + i * nColumns;
+
+            // Portfolio level P&L, the records are processed in the order of the set
+            Real pnl = 0.0, foPnl = 0.0;
+            for (const auto& r : records) {
+                if (r.col_2 == Null<Size>()) {
+                    Real shift = s[r.col_1];
+                    Real deltaPnl = shift * r.delta;
+                    Real gammaPnl = 0.5 * shift * shift * r.gamma;
+                    // Update the first order P&L
+                    foPnl += deltaPnl;
+                    // If backtesting curvature margin, we exclude deltas i.e. 1st order effects from the sensi P&L
+                    if (includeDeltaMargin)
+                        pnl += deltaPnl;
+                    // If backtesting delta margin, we exclude gammas i.e. second order effects from the sensi P&L
+                    if (includeGammaMargin)
+                        pnl += gammaPnl;
+                } else if (includeGammaMargin) {
+                    pnl += s[r.col_1] * s[r.col_2] * r.gamma;
                 }
             }
-        }
-
-        std::map<std::string, std::vector<QuantLib::Real>> riskFactorTradeMap;
-        if (runRiskFactorLevel){
-            for (Size j = 0; j < pnlCalculators.size(); j++) {
-                bool inPeriod =
-                    pnlCalculators.at(j)->isInTimePeriod(hisScenGen_->startDates()[i], hisScenGen_->endDates()[i]);
-                if (inPeriod) {
-                    for (const auto elem : srs | boost::adaptors::indexed(0)) {
-                        const auto& sr = elem.value();
-                        std::string riskFactorKey = QuantExt::reconstructFactor(sr.key_1, sr.desc_1);
-                        riskFactorTradeMap[riskFactorKey] = vector<Real>(tradeIds.size(), 0.0);
+            allPnls[i] = pnl;
+            allFoPnls[i] = foPnl;
+
+            if ((!runTradeLevel && !runRiskFactorLevel) || !anyInPeriod[i])
+                continue;
+
+            // Trade and risk factor level P&Ls, sparse trade x record matrix times the scenario's shifts
+            vector<Real> tradePnl(runTradeLevel ? nTrades : 0, 0.0), tradeFoPnl(runTradeLevel ? nTrades : 0, 0.0);
+            vector<vector<Real>> rfPnl(riskFactorNames.size(), vector<Real>(nTrades, 0.0));
+            vector<vector<Real>> rfFoPnl(riskFactorNames.size(), vector<Real>(nTrades, 0.0));
+            for (Size t = 0; t < nTrades; ++t) {
+                for (Size e = tradeSensis.rowBegin[t]; e < tradeSensis.rowBegin[t + 1]; ++e) {
+                    const auto& ts = tradeSensis.entries[e];
+                    const auto& r = records[ts.record];
+                    if (r.col_2 == Null<Size>()) {
+                        Real shift = s[r.col_1];
+                        Real tradeDeltaPnl = shift * ts.delta;
+                        Real tradeGammaPnl = 0.5 * shift * shift * ts.gamma;
+                        if (runTradeLevel) {
+                            tradeFoPnl[t] += tradeDeltaPnl;
+                            if (includeDeltaMargin)
+                                tradePnl[t] += tradeDeltaPnl;
+                            if (includeGammaMargin)
+                                tradePnl[t] += tradeGammaPnl;
+                        }
+                        if (runRiskFactorLevel) {
+                            Size f = recordRiskFactor[ts.record];
+                            rfFoPnl[f][t] += tradeDeltaPnl;
+                            if (includeDeltaMargin)
+                                rfPnl[f][t] += tradeDeltaPnl;
+                            if (includeGammaMargin)
+                                rfPnl[f][t] += tradeGammaPnl;
+                        }
+                    } else if (includeGammaMargin) {
+                        Real tradeGammaPnl = s[r.col_1] * s[r.col_2] * ts.gamma;
+                        if (runTradeLevel)
+                            tradePnl[t] += tradeGammaPnl;
+                        if (runRiskFactorLevel)
+                            rfPnl[recordRiskFactor[ts.record]][t] += tradeGammaPnl;
                     }
-                    riskFactorTradePnls.at(j).push_back(riskFactorTradeMap);
-                    riskFactorFoTradePnls.at(j).push_back(riskFactorTradeMap);
                 }
             }
-        }
 
-        for (const auto elem : srs | boost::adaptors::indexed(0)) {
-
-            const auto& sr = elem.value();
-            auto j = elem.index();
-
-            if (!sr.isCrossGamma()) {
-
-                Real shift = shiftCube->get(srsIndex[j].first, 0, i);
-                Real deltaPnl = shift * sr.delta;
-                Real gammaPnl = 0.5 * shift * shift * sr.gamma;
-                // Update the first order P&L
-                allFoPnls[i] += deltaPnl;
-                // If backtesting curvature margin, we exclude deltas i.e. 1st order effects from the sensi P&L
-                if (includeDeltaMargin)
-                    allPnls[i] += deltaPnl;
-                // If backtesting delta margin, we exclude gammas i.e. second order effects from the sensi P&L
-                if (includeGammaMargin)
-                    allPnls[i] += gammaPnl;
-
-                for (Size k = 0; k < pnlCalculators.size(); k++) {
-                    if (pnlCalculators.at(k)->isInTimePeriod(hisScenGen_->startDates()[i],
-                                                             hisScenGen_->endDates()[i])) {
-                        pnlCalculators.at(k)->writePNL(i, true, sr.key_1, shift, sr.delta, sr.gamma, deltaPnl,
-                                                       gammaPnl);
-                        if (!tradeSensiCache.empty()) {
-                            auto itSr = tradeSensiCache.find(j);
-                            if (itSr != tradeSensiCache.end()) {
-                                for (const auto& kv : itSr->second) {
-                                    const auto& tradeId = tradeIds[kv.first];
-                                    Real tradeDelta = kv.second.first;
-                                    Real tradeDeltaPnl = shift * tradeDelta;
-                                    Real tradeGamma = kv.second.second;
-                                    Real tradeGammaPnl = 0.5 * shift * shift * tradeGamma;
-                                    // Attempt to write trade level P&L contribution row.
-                                    pnlCalculators.at(k)->writePNL(i, true, sr.key_1, shift, tradeDelta, tradeGamma,
-                                                                   tradeDeltaPnl, tradeGammaPnl, RiskFactorKey(), 0.0,
-                                                                   tradeId);
-                                    // Update the sensitivity based trade level P&Ls
-                                    if (runTradeLevel) {
-                                        foTradePnls.at(k).back()[kv.first] += tradeDeltaPnl;
-                                        if (includeDeltaMargin)
-                                            tradePnls.at(k).back()[kv.first] += tradeDeltaPnl;
-                                        if (includeGammaMargin)
-                                            tradePnls.at(k).back()[kv.first] += tradeGammaPnl;
-                                    }
-                                    if (runRiskFactorLevel) {        
-                                        std::string riskFactorKey = QuantExt::reconstructFactor(sr.key_1, sr.desc_1);
-                                        riskFactorFoTradePnls.at(k).back()[riskFactorKey][kv.first] = tradeDeltaPnl;
-                                        if (includeDeltaMargin)
-                                            riskFactorTradePnls.at(k).back()[riskFactorKey][kv.first] = tradeDeltaPnl;
-                                        if (includeGammaMargin)
-                                            riskFactorTradePnls.at(k).back()[riskFactorKey][kv.first] += tradeGammaPnl;
-                                    }
-                                }
-                            }
-                        }
-                    }
+            if (runTradeLevel) {
+                scenarioTradePnls[i] = std::move(tradePnl);
+                scenarioFoTradePnls[i] = std::move(tradeFoPnl);
+            }
+            if (runRiskFactorLevel) {
+                for (Size f = 0; f < riskFactorNames.size(); ++f) {
+                    scenarioRiskFactorPnls[i].emplace_hint(scenarioRiskFactorPnls[i].end(), riskFactorNames[f],
+                                                           std::move(rfPnl[f]));
+                    scenarioRiskFactorFoPnls[i].emplace_hint(scenarioRiskFactorFoPnls[i].end(), riskFactorNames[f],
+                                                             std::move(rfFoPnl[f]));
                 }
-            } else {
-                Real shift_1 = shiftCube->get(srsIndex[j].first, 0, i);
-                Real shift_2 = shiftCube->get(srsIndex[j].second, 0, i);
-                Real gammaPnl = shift_1 * shift_2 * sr.gamma;
-
-                // If backtesting delta margin, we exclude gammas i.e. second order effects from the sensi P&L
-                if (includeGammaMargin)
-                    allPnls[i] += gammaPnl;
-                                
-                for (Size j = 0; j < pnlCalculators.size(); j++) {
-                    const auto& c = pnlCalculators[j];
-                    if (c->isInTimePeriod(hisScenGen_->startDates()[i], hisScenGen_->endDates()[i])) {
-                        c->writePNL(i, true, sr.key_1, shift_1, sr.delta, sr.gamma, 0.0, gammaPnl, sr.key_2, shift_2);
-                        if (!tradeSensiCache.empty()) {
-                            auto itSr = tradeSensiCache.find(j);
-                            if (itSr != tradeSensiCache.end()) {
-                                for (const auto& kv : itSr->second) {
-                                    const auto& tradeId = tradeIds[kv.first];
-                                    Real tradeGamma = kv.second.second;
-                                    Real tradeGammaPnl = shift_1 * shift_2 * tradeGamma;
-                                    // Attempt to write trade level P&L contribution row.
-                                    c->writePNL(i, true, sr.key_1, shift_1, 0.0, tradeGamma, 0.0, tradeGammaPnl,
-                                                  sr.key_2, shift_2, tradeId);
-                                    // Update the sensitivity based trade level P&Ls
-                                    if (runTradeLevel && includeGammaMargin) {
-                                        tradePnls.at(j).back()[kv.first] += tradeGammaPnl;
-                                    }
-                                    if (runRiskFactorLevel && includeGammaMargin) {        
-                                        std::string riskFactorKey = QuantExt::reconstructFactor(sr.key_1, sr.desc_1);
-                                        riskFactorTradePnls.at(j).back()[riskFactorKey][kv.first] += tradeGammaPnl;
-                                    }
-                            }
+            }
+        }
+    };
+
+    if (workerPool_)
+        workerPool_->parallelFor(nScenarios, 16, calculateScenarios);
+    else
+        calculateScenarios(0, nScenarios, 0);
+
+    // Write the P&L rows for the calculators asking for them, in the order scenario, record, calculator, trade
+    vector<Size> rowCalculators;
+    for (Size k = 0; k < nCalculators; ++k) {
+        if (pnlCalculators[k]->requiresPnlRows())
+            rowCalculators.push_back(k);
+    }
+    if (!rowCalculators.empty()) {
+        // trade level sensitivities by record, ordered by trade
+        vector<vector<pair<Size, const TradeSensitivity*>>> recordTradeSensis(records.size());
+        for (Size t = 0; t + 1 < tradeSensis.rowBegin.size(); ++t) {
+            for (Size e = tradeSensis.rowBegin[t]; e < tradeSensis.rowBegin[t + 1]; ++e)
+                recordTradeSensis[tradeSensis.entries[e].record].push_back(make_pair(t, &tradeSensis.entries[e]));
+        }
+        for (Size i = 0; i < nScenarios; ++i) {
+            const Real* s = shifts.data() + i * nColumns;
+            for (const auto elem : srs | boost::adaptors::indexed(0)) {
+                const auto& sr = elem.value();
+                const auto& r = records[elem.index()];
+                for (Size k : rowCalculators) {
+                    if (!inPeriod[k][i])
+                        continue;
+                    const auto& c = pnlCalculators[k];
+                    if (r.col_2 == Null<Size>()) {
+                        Real shift = s[r.col_1];
+                        c->writePNL(i, true, sr.key_1, shift, sr.delta, sr.gamma, shift * sr.delta,
+                                    0.5 * shift * shift * sr.gamma);
+                        for (const auto& [t, ts] : recordTradeSensis[elem.index()]) {
+                            // Attempt to write trade level P&L contribution row.
+                            c->writePNL(i, true, sr.key_1, shift, ts->delta, ts->gamma, shift * ts->delta,
+                                        0.5 * shift * shift * ts->gamma, RiskFactorKey(), 0.0, tradeIds[t]);
+                        }
+                    } else {
+                        Real shift_1 = s[r.col_1];
+                        Real shift_2 = s[r.col_2];
+                        c->writePNL(i, true, sr.key_1, shift_1, sr.delta, sr.gamma, 0.0, shift_1 * shift_2 * sr.gamma,
+                                    sr.key_2, shift_2);
+                        for (const auto& [t, ts] : recordTradeSensis[elem.index()]) {
+                            // Attempt to write trade level P&L contribution row.
+                            c->writePNL(i, true, sr.key_1, shift_1, 0.0, ts->gamma, 0.0, shift_1 * shift_2 * ts->gamma,
+                                        sr.key_2, shift_2, tradeIds[t]);
                         }
                     }
-
                 }
             }
         }
-        }
-        if (covarianceCalculator)
-            covarianceCalculator->updateAccumulators(shiftCube, hisScenGen_->startDates()[i], hisScenGen_->endDates()[i], i);
     }
-    if (covarianceCalculator)
+
+    if (covarianceCalculator) {
+        for (Size i = 0; i < nScenarios; i++)
+            covarianceCalculator->updateAccumulators(shiftCube, hisScenGen_->startDates()[i],
+                                                     hisScenGen_->endDates()[i], i);
         covarianceCalculator->populateCovariance(keys);
+    }
 
     LOG("Populate the sensitivity backtesting P&L vectors");
-    for (Size j = 0; j < pnlCalculators.size(); j++) {
-        pnlCalculators.at(j)->populatePNLs(allPnls, allFoPnls, hisScenGen_->startDates(), hisScenGen_->endDates());
-        if (runTradeLevel)
-            pnlCalculators.at(j)->populateTradePNLs(tradePnls.at(j), foTradePnls.at(j));
-        if (runRiskFactorLevel){
-            pnlCalculators.at(j)->populateRiskFactorTradePNLs(riskFactorTradePnls.at(j), riskFactorFoTradePnls.at(j));
+    for (Size k = 0; k < nCalculators; k++) {
+        pnlCalculators.at(k)->populatePNLs(allPnls, allFoPnls, hisScenGen_->startDates(), hisScenGen_->endDates());
+        // calculators, scenarios, trades resp. map<risk factors, trades>
+        if (runTradeLevel) {
+            TradePnLStore tradePnls, foTradePnls;
+            for (Size i = 0; i < nScenarios; ++i) {
+                if (inPeriod[k][i]) {
+                    tradePnls.push_back(scenarioTradePnls[i]);
+                    foTradePnls.push_back(scenarioFoTradePnls[i]);
+                }
+            }
+            pnlCalculators.at(k)->populateTradePNLs(tradePnls, foTradePnls);
+        }
+        if (runRiskFactorLevel) {
+            RiskFactorTradePnLStore riskFactorTradePnls, riskFactorFoTradePnls;
+            for (Size i = 0; i < nScenarios; ++i) {
+                if (inPeriod[k][i]) {
+                    riskFactorTradePnls.push_back(scenarioRiskFactorPnls[i]);
+                    riskFactorFoTradePnls.push_back(scenarioRiskFactorFoPnls[i]);
+                }
+            }
+            pnlCalculators.at(k)->populateRiskFactorTradePNLs(riskFactorTradePnls, riskFactorFoTradePnls);
         }
     }
 }
@@ -32,29 +32,28 @@
 #include <ql/math/matrix.hpp>
 #include <ql/shared_ptr.hpp>
 
-#include <boost/accumulators/accumulators.hpp>
-// Including <boost/accumulators/statistics.hpp> causes the following swig wrapper compiler errors
-//   explicit specialization of 'boost::accumulators::feature_of<boost::accumulators::tag::weighted_skewness>'
-//   explicit specialization of 'boost::accumulators::feature_of<boost::accumulators::tag::weighted_kurtosis>'
-// see https://github.com/boostorg/accumulators/issues/20
-// The following subset of includes is sufficient here and circumvents the swig errors
-#include <boost/accumulators/statistics/stats.hpp>
-#include <boost/accumulators/statistics/variance.hpp>
-#include <boost/accumulators/statistics/covariance.hpp>
-#include <boost/accumulators/statistics/variates/covariate.hpp>
+namespace QuantExt {
+class WorkerPool;
+}
 
 namespace ore {
 namespace analytics {
 
 class PNLCalculator {
 public:
-    PNLCalculator(ore::data::TimePeriod pnlPeriod, bool runRiskFactorLevel = false) : pnlPeriod_(pnlPeriod) {}
+    /*! Set requiresPnlRows to false if the calculator only needs the aggregated pnls, so that the writePNL() rows are
+        not generated for it */
+    PNLCalculator(ore::data::TimePeriod pnlPeriod, bool runRiskFactorLevel = false, bool requiresPnlRows = true)
+        : pnlPeriod_(pnlPeriod), requiresPnlRows_(requiresPnlRows) {}
     virtual ~PNLCalculator() {}
     virtual void writePNL(QuantLib::Size scenarioIdx, bool isCall,
                           const RiskFactorKey& key_1, QuantLib::Real shift_1, QuantLib::Real delta,
                           QuantLib::Real gamma, QuantLib::Real deltaPnl, Real gammaPnl,
                           const RiskFactorKey& key_2 = RiskFactorKey(),
                           QuantLib::Real shift_2 = 0.0, const std::string& tradeId = "") {}
+    /*! If true, writePNL() is called for each scenario in the period and each sensitivity record (and trade). The
+        default is true, calculators that do not use the rows can opt out via the constructor or by overriding this */
+    virtual bool requiresPnlRows() const { return requiresPnlRows_; }
     const bool isInTimePeriod(QuantLib::Date startDate, QuantLib::Date endDate);
 
     void populatePNLs(const std::vector<QuantLib::Real>& allPnls, const std::vector<QuantLib::Real>& foPnls,
@@ -88,25 +87,47 @@ protected:
     ore::data::TimePeriod pnlPeriod_;
     TradePnLStore tradePnls_, foTradePnls_;
     RiskFactorTradePnLStore riskFactorTradePnls_, riskFactorFoTradePnls_;
+    bool requiresPnlRows_;
 };
 
+//! Covariance of the historical shifts over the covariance period
+/*! The shift vectors of the scenarios in the period are collected in blocks of rows. Each block is centred on its own
+    mean and merged into a running mean and a single contiguous matrix of centred cross products by a rank-k update,
+    which keeps the one pass estimate stable. The rows of the cross product matrix are updated on the threads of the
+    worker pool if one is given.
+
+    If a decay factor lambda < 1 is given, the scenarios are weighted exponentially: the last scenario added has weight
+    1 and each scenario lambda times the weight of its successor. The covariance is the (weighted) population
+    covariance, i.e. the centred cross products divided by the sum of the weights. */
 class CovarianceCalculator {
 public:
-    CovarianceCalculator(ore::data::TimePeriod covariancePeriod) : covariancePeriod_(covariancePeriod) {}
+    CovarianceCalculator(ore::data::TimePeriod covariancePeriod,
+                         const QuantLib::ext::shared_ptr<QuantExt::WorkerPool>& workerPool = nullptr,
+                         const QuantLib::Real decayFactor = 1.0);
     void initialise(const std::set<std::pair<RiskFactorKey, QuantLib::Size>>& keys);
     void updateAccumulators(const QuantLib::ext::shared_ptr<NPVCube>& shiftCube, QuantLib::Date startDate, QuantLib::Date endDate, QuantLib::Size index);
     void populateCovariance(const std::set<std::pair<RiskFactorKey, QuantLib::Size>>& keys);
     const Matrix& covariance() const { return covariance_; }
     const Matrix& correlation() const { return correlation_; }
+    //! number of scenarios that entered the covariance
+    QuantLib::Size samples() const { return samples_; }
 
 private:
-    typedef boost::accumulators::accumulator_set<
-        QuantLib::Real,
-        boost::accumulators::stats<
-            boost::accumulators::tag::covariance<QuantLib::Real, boost::accumulators::tag::covariate1>,
-            boost::accumulators::tag::variance>>accumulator;
-    std::map<std::pair<QuantLib::Size, QuantLib::Size>, accumulator> accCov_;
+    void mergeBlock();
+
     ore::data::TimePeriod covariancePeriod_;
+    QuantLib::Real decayFactor_;
+    QuantLib::ext::shared_ptr<QuantExt::WorkerPool> workerPool_;
+    // sensi shift cube index per key, in the order of the keys
+    std::vector<QuantLib::Size> cubeIndices_;
+    // shift vectors not merged yet, one row per scenario
+    std::vector<QuantLib::Real> block_;
+    QuantLib::Size blockRows_ = 0;
+    // sum of weights, weighted mean and centred cross products (upper triangle) of the merged scenarios
+    QuantLib::Real weight_ = 0.0;
+    std::vector<QuantLib::Real> mean_;
+    QuantLib::Matrix crossProducts_;
+    QuantLib::Size samples_ = 0;
     QuantLib::Matrix covariance_;
     QuantLib::Matrix correlation_;
 };
@@ -114,13 +135,18 @@ private:
 class HistoricalSensiPnlCalculator {
 public:
     HistoricalSensiPnlCalculator(const QuantLib::ext::shared_ptr<HistoricalScenarioGenerator>& hisScenGen,
-                                 const QuantLib::ext::shared_ptr<SensitivityStream>& ss)
-        : hisScenGen_(hisScenGen), sensitivityStream_(ss) {}
+                                 const QuantLib::ext::shared_ptr<SensitivityStream>& ss,
+                                 const QuantLib::ext::shared_ptr<QuantExt::WorkerPool>& workerPool = nullptr)
+        : hisScenGen_(hisScenGen), sensitivityStream_(ss), workerPool_(workerPool) {}
     
     void populateSensiShifts(QuantLib::ext::shared_ptr<NPVCube>& cube, const vector<RiskFactorKey>& keys,
                              QuantLib::ext::shared_ptr<ScenarioShiftCalculator> shiftCalculator,
                              const bool& supressError = false);
 
+    /*! The shifts are read from the shift cube into a dense scenario x risk factor matrix and the sensitivities are
+        indexed by their columns in this matrix (the trade level sensitivities as a sparse trade x record matrix), so
+        that the pnls for blocks of scenarios are computed as sparse-dense products, on the threads of the worker pool
+        if one is given */
     void calculateSensiPnl(const std::set<SensitivityRecord>& srs,
         const std::vector<RiskFactorKey>& rfKeys,
         QuantLib::ext::shared_ptr<NPVCube>& shiftCube,
@@ -137,6 +163,7 @@ private:
     QuantLib::ext::shared_ptr<HistoricalScenarioGenerator> hisScenGen_;
     //! Stream of sensitivity records used for the sensitivity based backtest
     QuantLib::ext::shared_ptr<SensitivityStream> sensitivityStream_;
+    QuantLib::ext::shared_ptr<QuantExt::WorkerPool> workerPool_;
 };
 
 } // namespace analytics
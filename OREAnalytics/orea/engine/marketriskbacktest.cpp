@@ -91,7 +91,7 @@ bool MarketRiskBacktest::runTradeDetail(const ext::shared_ptr<MarketRiskReport::
 
 void MarketRiskBacktest::addPnlCalculators(const ext::shared_ptr<MarketRiskReport::Reports>& reports) {
     pnlCalculators_.push_back(
-        QuantLib::ext::make_shared<PNLCalculator>(btArgs_->benchmarkPeriod_));
+        QuantLib::ext::make_shared<PNLCalculator>(btArgs_->benchmarkPeriod_, false, false));
     auto btRpts = ext::dynamic_pointer_cast<BacktestReports>(reports);
     pnlCalculators_.push_back(
         QuantLib::ext::make_shared<BacktestPNLCalculator>(btArgs_->backtestPeriod_, writePnl_, this, btRpts));
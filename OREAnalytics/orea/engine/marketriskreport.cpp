@@ -27,6 +27,7 @@
 #include <orea/engine/sensitivityaggregator.hpp>
 #include <ql/math/matrixutilities/pseudosqrt.hpp>
 #include <ql/math/matrixutilities/symmetricschurdecomposition.hpp>
+#include <qle/utilities/workerpool.hpp>
 
 #include <regex>
 
@@ -137,9 +138,12 @@ void MarketRiskReport::initialise() {
             hisScenGen_->baseScenario() = fullRevalArgs_->simMarket_->baseScenario();
     }
 
+    if (multiThreadArgs_ && multiThreadArgs_->nThreads_ > 1 && !workerPool_)
+        workerPool_ = QuantLib::ext::make_shared<QuantExt::WorkerPool>(multiThreadArgs_->nThreads_);
+
     if (sensiArgs_ && hisScenGen_)
         sensiPnlCalculator_ =
-            ext::make_shared<HistoricalSensiPnlCalculator>(hisScenGen_, sensiArgs_->sensitivityStream_);
+            ext::make_shared<HistoricalSensiPnlCalculator>(hisScenGen_, sensiArgs_->sensitivityStream_, workerPool_);
 
     if (fullRevalArgs_) {
         LOG("Build the portfolio for full reval bt.");
@@ -416,7 +420,8 @@ void MarketRiskReport::calculate(const ext::shared_ptr<MarketRiskReport::Reports
                             salvage_ = QuantLib::ext::make_shared<QuantExt::NoCovarianceSalvage>();
                         }
                     } else
-                        covCalculator = ext::make_shared<CovarianceCalculator>(covariancePeriod());
+                        covCalculator = ext::make_shared<CovarianceCalculator>(
+                            covariancePeriod(), workerPool_, sensiArgs_->covarianceDecayFactor_);
 
                     includeDeltaMargin_ = includeDeltaMargin(riskGroup);
                     includeGammaMargin_ = includeGammaMargin(riskGroup);
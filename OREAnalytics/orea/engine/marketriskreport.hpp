@@ -163,13 +163,16 @@ public:
         QuantLib::Real pnlWriteThreshold_;
         //! Optional input of covariance matrix
         std::map<std::pair<RiskFactorKey, RiskFactorKey>, Real> covarianceInput_;
+        //! Decay factor of the exponentially weighted covariance of the historical shifts, 1 means equal weights
+        QuantLib::Real covarianceDecayFactor_;
 
         SensiRunArgs(const QuantLib::ext::shared_ptr<SensitivityStream>& ss,
                      const QuantLib::ext::shared_ptr<ScenarioShiftCalculator>& sc,
                      QuantLib::Real pnlThres = 0.01,
-                     std::map<std::pair<RiskFactorKey, RiskFactorKey>, Real> ci = {})
+                     std::map<std::pair<RiskFactorKey, RiskFactorKey>, Real> ci = {},
+                     QuantLib::Real covDecay = 1.0)
             : sensitivityStream_(ss), shiftCalculator_(sc), pnlWriteThreshold_(pnlThres),
-              covarianceInput_(ci) {}
+              covarianceInput_(ci), covarianceDecayFactor_(covDecay) {}
     };
 
     struct FullRevalArgs {
@@ -307,6 +310,8 @@ protected:
 
     QuantLib::ext::shared_ptr<ore::analytics::HistoricalPnlGenerator> histPnlGen_;
     QuantLib::ext::shared_ptr<HistoricalSensiPnlCalculator> sensiPnlCalculator_;
+    // shared by the sensi pnl and covariance calculators, initialized if the run is multithreaded
+    QuantLib::ext::shared_ptr<QuantExt::WorkerPool> workerPool_;
 
     virtual void registerProgressIndicators();
     virtual void createReports(const QuantLib::ext::shared_ptr<MarketRiskReport::Reports>& reports) = 0;
@@ -30,7 +30,9 @@
 
 #include <boost/timer/timer.hpp>
 
+#include <atomic>
 #include <future>
+#include <mutex>
 #include <random>
 
 #ifdef ORE_MULTITHREADING_CPU_AFFINITY
@@ -38,8 +40,6 @@
 #include <sched.h>
 #endif
 
-// #include <ctpl_stl.h>
-
 namespace ore {
 namespace analytics {
 
@@ -74,6 +74,59 @@ std::vector<std::size_t> getCpuIds(std::size_t nThreads) {
 }
 #endif
 
+/* Consolidates the progress of the units processed by the worker threads. The valuation engine of a thread reports
+   the progress within its current unit, finished units are accumulated separately, so that the total (number of trades
+   times number of samples) stays the same during the whole run. */
+class WorkQueueProgressIndicator : public ore::data::ProgressIndicator {
+public:
+    WorkQueueProgressIndicator(const std::set<QuantLib::ext::shared_ptr<ore::data::ProgressIndicator>>& indicators,
+                               const std::size_t nTrades, const std::size_t nSamples)
+        : indicators_(indicators), nSamples_(nSamples), total_(nTrades * nSamples), finished_(0) {
+        std::ostringstream detail;
+        detail << nTrades << " trade" << (nTrades == 1 ? "" : "s") << ", " << nSamples << " sample"
+               << (nSamples == 1 ? "" : "s");
+        detail_ = detail.str();
+    }
+
+    void updateProgress(const unsigned long progress, const unsigned long, const std::string&) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        current_[std::this_thread::get_id()] = progress;
+        notify();
+    }
+
+    void reset() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& i : indicators_)
+            i->reset();
+        current_.clear();
+        finished_ = 0;
+    }
+
+    //! to be called by a worker thread when it has finished a unit with the given number of trades
+    void finishUnit(const std::size_t nTrades) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        current_.erase(std::this_thread::get_id());
+        finished_ += nTrades * nSamples_;
+        notify();
+    }
+
+private:
+    void notify() {
+        unsigned long progress = finished_;
+        for (auto const& c : current_)
+            progress += c.second;
+        for (auto& i : indicators_)
+            i->updateProgress(std::min(progress, total_), total_, detail_);
+    }
+
+    std::mutex mutex_;
+    std::set<QuantLib::ext::shared_ptr<ore::data::ProgressIndicator>> indicators_;
+    std::size_t nSamples_;
+    unsigned long total_, finished_;
+    std::string detail_;
+    std::map<std::thread::id, unsigned long> current_;
+};
+
 } // namespace
 
 using QuantLib::Size;
@@ -144,6 +197,11 @@ void MultiThreadedValuationEngine::setAggregationScenarioData(
     aggregationScenarioData_ = aggregationScenarioData;
 }
 
+void MultiThreadedValuationEngine::setWorkUnitsPerThread(const Size workUnitsPerThread) {
+    QL_REQUIRE(workUnitsPerThread > 0, "MultiThreadedValuationEngine: workUnitsPerThread must be > 0");
+    workUnitsPerThread_ = workUnitsPerThread;
+}
+
 void MultiThreadedValuationEngine::buildCube(
     const QuantLib::ext::shared_ptr<ore::data::Portfolio>& portfolio,
     const std::function<std::vector<QuantLib::ext::shared_ptr<ore::analytics::ValuationCalculator>>()>& calculators,
@@ -186,7 +244,7 @@ void MultiThreadedValuationEngine::buildCube(
                             << t->npvCurrency());
     }
 
-    // split portfolio into nThreads parts such that each part has an approximately similar total avg pricing time
+    // split portfolio into work units, which are pulled from a shared queue by the worker threads
 
     Size eff_nThreads = std::min(portfolio->size(), nThreads_);
 
@@ -194,14 +252,9 @@ void MultiThreadedValuationEngine::buildCube(
 
     LOG("portfolio size = " << portfolio->size());
     LOG("nThreads       = " << nThreads_);
-    LOG("eff nThreads   = " << eff_nThreads);
 
     QL_REQUIRE(eff_nThreads > 0, "effective threads are zero, this is not allowed.");
 
-    std::vector<QuantLib::ext::shared_ptr<ore::data::Portfolio>> portfolios;
-    for (Size i = 0; i < eff_nThreads; ++i)
-        portfolios.push_back(QuantLib::ext::make_shared<ore::data::Portfolio>());
-
     double totalAvgPricingTime = 0.0;
     std::vector<std::pair<std::string, double>> timings;
     for (auto const& [tid, t] : portfolio->trades()) {
@@ -223,28 +276,47 @@ void MultiThreadedValuationEngine::buildCube(
                       return p1.second > p2.second;
               });
 
-    std::vector<double> portfolioTotalAvgPricingTime(portfolios.size());
-    Size portfolioIndex = 0;
+    /* The trades are sorted by descending avg pricing time. A unit is closed as soon as its total avg pricing time
+       reaches the target time or its size reaches the max size. Expensive trades therefore form units on their own
+       and are processed first, the remaining trades are grouped into smaller units at the end of the queue which
+       balance the load between the threads. Every unit requires a separate run over all scenarios, so we do not go
+       below a unit size that yields workUnitsPerThread_ units per thread. */
+
+    Size targetUnits = std::min(portfolio->size(), eff_nThreads * workUnitsPerThread_);
+    Size maxUnitSize = (portfolio->size() + targetUnits - 1) / targetUnits;
+    double targetUnitTime = totalAvgPricingTime / static_cast<double>(targetUnits);
+
+    std::vector<QuantLib::ext::shared_ptr<ore::data::Portfolio>> units;
+    std::vector<double> unitTotalAvgPricingTime;
+    bool newUnit = true;
     for (auto const& t : timings) {
-        portfolios[portfolioIndex]->add(portfolio->get(t.first));
-        portfolioTotalAvgPricingTime[portfolioIndex] += t.second;
-        if (++portfolioIndex >= eff_nThreads)
-            portfolioIndex = 0;
+        if (newUnit) {
+            units.push_back(QuantLib::ext::make_shared<ore::data::Portfolio>());
+            unitTotalAvgPricingTime.push_back(0.0);
+        }
+        units.back()->add(portfolio->get(t.first));
+        unitTotalAvgPricingTime.back() += t.second;
+        newUnit = units.back()->size() >= maxUnitSize ||
+                  (targetUnitTime > 0.0 && unitTotalAvgPricingTime.back() >= targetUnitTime);
     }
 
-    // output the portfolios into strings so that the worker threads can load them from there
+    eff_nThreads = std::min(eff_nThreads, units.size());
+    LOG("eff nThreads   = " << eff_nThreads);
 
-    std::vector<std::string> portfoliosAsString;
-    for (auto const& p : portfolios) {
-        portfoliosAsString.emplace_back(p->toXMLString());
+    // output the units into strings so that the worker threads can load them from there
+
+    std::vector<std::string> unitsAsString;
+    for (auto const& p : units) {
+        unitsAsString.emplace_back(p->toXMLString());
     }
 
     // log info on the portfolio split
 
     LOG("Total avg pricing time     : " << totalAvgPricingTime / 1E6 << " ms");
-    for (Size i = 0; i < eff_nThreads; ++i) {
-        LOG("Portfolio #" << i << " number of trades       : " << portfolios[i]->size());
-        LOG("Portfolio #" << i << " total avg pricing time : " << portfolioTotalAvgPricingTime[i] / 1E6 << " ms");
+    LOG("Number of work units       : " << units.size());
+    for (Size i = 0; i < units.size(); ++i) {
+        DLOG("Unit #" << i << " number of trades       : " << units[i]->size());
+        DLOG("Unit #" << i << " total avg pricing time : " << unitTotalAvgPricingTime[i] / 1E6 << " ms");
     }
 
     // build scenario generators for each thread as clones of the original one
@@ -267,35 +339,34 @@ void MultiThreadedValuationEngine::buildCube(
     for (Size i = 0; i < eff_nThreads; ++i)
         loaders.push_back(QuantLib::ext::make_shared<ore::data::ClonedLoader>(today_, loader_));
 
-    // build nThreads mini-cubes to which each thread writes its results
+    // build one mini-cube per unit, the thread processing the unit writes its results there
 
-    LOG("Build " << eff_nThreads << " mini result cubes...");
+    LOG("Build " << units.size() << " mini result cubes...");
     miniCubes_.clear();
     miniNettingSetCubes_.clear();
     miniCptyCubes_.clear();
-    for (Size i = 0; i < eff_nThreads; ++i) {
-        miniCubes_.push_back(cubeFactory_(today_, portfolios[i]->ids(), dateGrid_->valuationDates(), nSamples_));
+    for (Size i = 0; i < units.size(); ++i) {
+        miniCubes_.push_back(cubeFactory_(today_, units[i]->ids(), dateGrid_->valuationDates(), nSamples_));
         miniNettingSetCubes_.push_back(nettingSetCubeFactory_(today_, dateGrid_->valuationDates(), nSamples_));
         miniCptyCubes_.push_back(
-            cptyCubeFactory_(today_, portfolios[i]->counterparties(), dateGrid_->valuationDates(), nSamples_));
+            cptyCubeFactory_(today_, units[i]->counterparties(), dateGrid_->valuationDates(), nSamples_));
     }
 
-    // build progress indicator consolidating the results from the threads
-
-    auto progressIndicator =
-        QuantLib::ext::make_shared<ore::analytics::MultiThreadedProgressIndicator>(this->progressIndicators());
-
-    // create the thread pool with eff_nThreads and queue size = eff_nThreads as well
+    // build progress indicator consolidating the results from the units
 
-    // LOG("Create thread pool with " << eff_nThreads);
-    // ctpl::thread_pool threadPool(eff_nThreads);
+    auto progressIndicator = QuantLib::ext::make_shared<WorkQueueProgressIndicator>(
+        this->progressIndicators(), portfolio->size(), nSamples_);
 
-    // create the jobs and push them to the pool
+    // create the jobs
 
     using resultType = int;
     std::vector<std::future<resultType>> results(eff_nThreads);
 
-    std::vector<std::thread> jobs; // not needed if thread pool is used
+    std::vector<std::thread> jobs;
+
+    // the work queue, the threads stop pulling units as soon as one of them failed
+    std::atomic<Size> nextUnit(0);
+    std::atomic<bool> failed(false);
 
     // pricing stats accumulated in worker threads
     std::vector<std::map<std::string, std::pair<std::size_t, boost::timer::nanosecond_type>>> workerPricingStats(
@@ -320,8 +391,8 @@ void MultiThreadedValuationEngine::buildCube(
                     &cpuIds,
 #endif
                     obsMode, includeTodaysCashFlows, localIncRefDateEvents, dryRun, &calculators, errorPolicy,
-                    &cptyCalculators, mporStickyDate, &portfoliosAsString,
-                    &scenarioGenerators, &loaders, &workerPricingStats, &progressIndicator](int id) -> resultType {
+                    &cptyCalculators, mporStickyDate, &unitsAsString, &nextUnit, &failed, &scenarioGenerators,
+                    &loaders, &workerPricingStats, &progressIndicator](int id) -> resultType {
 
 #ifdef ORE_MULTITHREADING_CPU_AFFINITY
             pthread_t self = pthread_self();
@@ -365,11 +436,6 @@ void MultiThreadedValuationEngine::buildCube(
                         useSpreadedTermStructures_, cacheSimData_, false, iborFallbackConfig_,
                         handlePseudoCurrenciesSimMarket_, offsetScenario_);
 
-                // set aggregation scenario data, but only in one of the sim markets, that's sufficient to populate it
-
-                if (id == 0 && aggregationScenarioData_ != nullptr)
-                    simMarket->aggregationScenarioData() = aggregationScenarioData_;
-
                 // link scenario generator to sim market
 
                 simMarket->scenarioGenerator() = scenarioGenerators[id];
@@ -379,39 +445,61 @@ void MultiThreadedValuationEngine::buildCube(
                 if (scenarioFilter_)
                     simMarket->filter() = scenarioFilter_;
 
-                // build portfolio against sim market
+                // process units from the queue until it is drained
+
+                Size processedUnits = 0;
+                for (Size unit = nextUnit++; unit < unitsAsString.size() && !failed; unit = nextUnit++) {
+
+                    // set aggregation scenario data, but only for the run over the first unit, that's sufficient to
+                    // populate it
 
-                auto portfolio = QuantLib::ext::make_shared<ore::data::Portfolio>();
-                portfolio->fromXMLString(portfoliosAsString[id]);
-                auto engineFactory = QuantLib::ext::make_shared<ore::data::EngineFactory>(
-                    engineData_, simMarket, std::map<ore::data::MarketContext, string>(), referenceData_,
-                    iborFallbackConfig_);
+                    simMarket->aggregationScenarioData() = unit == 0 ? aggregationScenarioData_ : nullptr;
 
-                portfolio->build(engineFactory, context_, true, useAtParCouponsTrades_);
+                    // each unit is a new run over all scenarios
 
-                // build valuation engine
+                    scenarioGenerators[id]->reset();
 
-                auto valEngine = QuantLib::ext::make_shared<ore::analytics::ValuationEngine>(
-                    today_, dateGrid_, simMarket, engineFactory->modelBuilders(), recalibrateModels_);
-                valEngine->registerProgressIndicator(progressIndicator);
+                    // build unit portfolio against sim market
 
-                // build mini-cube
+                    auto portfolio = QuantLib::ext::make_shared<ore::data::Portfolio>();
+                    portfolio->fromXMLString(unitsAsString[unit]);
+                    auto engineFactory = QuantLib::ext::make_shared<ore::data::EngineFactory>(
+                        engineData_, simMarket, std::map<ore::data::MarketContext, string>(), referenceData_,
+                        iborFallbackConfig_);
 
-                valEngine->buildCube(portfolio, miniCubes_[id], calculators(), errorPolicy, mporStickyDate,
-                                     miniNettingSetCubes_[id], miniCptyCubes_[id],
-                                     cptyCalculators ? cptyCalculators()
-                                                     : std::vector<QuantLib::ext::shared_ptr<CounterpartyCalculator>>(),
-                                     dryRun);
+                    portfolio->build(engineFactory, context_, true, useAtParCouponsTrades_);
 
-                // set pricing stats for val engine run
+                    // build valuation engine
 
-                for (auto const& [tid, t] : portfolio->trades())
-                    workerPricingStats[id][tid] =
-                        std::make_pair(t->getNumberOfPricings(), t->getCumulativePricingTime());
+                    auto valEngine = QuantLib::ext::make_shared<ore::analytics::ValuationEngine>(
+                        today_, dateGrid_, simMarket, engineFactory->modelBuilders(), recalibrateModels_);
+                    valEngine->registerProgressIndicator(progressIndicator);
+
+                    // build mini-cube
+
+                    valEngine->buildCube(
+                        portfolio, miniCubes_[unit], calculators(), errorPolicy, mporStickyDate,
+                        miniNettingSetCubes_[unit], miniCptyCubes_[unit],
+                        cptyCalculators ? cptyCalculators()
+                                        : std::vector<QuantLib::ext::shared_ptr<CounterpartyCalculator>>(),
+                        dryRun);
+
+                    progressIndicator->finishUnit(portfolio->size());
+
+                    // set pricing stats for val engine run
+
+                    for (auto const& [tid, t] : portfolio->trades())
+                        workerPricingStats[id][tid] =
+                            std::make_pair(t->getNumberOfPricings(), t->getCumulativePricingTime());
+
+                    ++processedUnits;
+                }
+
+                simMarket->aggregationScenarioData() = nullptr;
 
                 // return code 0 = ok
 
-                LOG("Thread " << id << " successfully finished.");
+                LOG("Thread " << id << " successfully finished, processed " << processedUnits << " units.");
 
                 rc = 0;
 
@@ -419,6 +507,7 @@ void MultiThreadedValuationEngine::buildCube(
 
                 // log error and return code 1 = not ok
 
+                failed = true;
                 ore::analytics::StructuredAnalyticsErrorMessage("Multithreaded Valuation Engine", "", e.what()).log();
                 rc = 1;
             }
@@ -428,9 +517,6 @@ void MultiThreadedValuationEngine::buildCube(
             return rc;
         };
 
-        // results[i] = threadPool.push(job);
-
-        // not needed if thread pool is used
         std::packaged_task<resultType(int)> task(job);
         results[i] = task.get_future();
         std::thread thread(std::move(task), i);
@@ -439,7 +525,6 @@ void MultiThreadedValuationEngine::buildCube(
 
     // check return codes from jobs
 
-    // not needed if thread pool is used
     for (auto& t : jobs)
         t.join();
 
@@ -454,11 +539,6 @@ void MultiThreadedValuationEngine::buildCube(
                                              << ". Check for structured errors from 'MultiThreaded Valuation Engine'.");
     }
 
-    // stop the thread pool, wait for unfinished jobs
-
-    // LOG("Stop thread pool");
-    // threadPool.stop(true);
-
     // set updated pricing stats in original portfolio
 
     LOG("Update pricing stats of trades.");
@@ -74,6 +74,12 @@ public:
     // can be optionally called to set the agg scen data (which is done in the ssm for single-threaded runs)
     void setAggregationScenarioData(const QuantLib::ext::shared_ptr<AggregationScenarioData>& aggregationScenarioData);
 
+    /* can be optionally called to set the number of work units per thread, the default is 1. The portfolio is split
+       into approximately nThreads x workUnitsPerThread units which the threads pull from a shared queue. More units
+       give a better load balance, but each unit requires a separate run over all scenarios (including the scenario
+       generation and sim market updates) in the thread processing it. */
+    void setWorkUnitsPerThread(const QuantLib::Size workUnitsPerThread);
+
     /* analoguous to buildCube() in the single-threaded engine, results are retrieved using below constructors
        if no cptyCalculators is given a function returning an empty vector of calculators will be returned */
     void buildCube(
@@ -84,7 +90,7 @@ public:
             cptyCalculators = {},
         bool mporStickyDate = true, bool dryRun = false);
 
-    // result output cubes (mini-cubes, one per thread)
+    // result output cubes (mini-cubes, one per work unit)
     std::vector<QuantLib::ext::shared_ptr<ore::analytics::NPVCube>> outputCubes() const { return miniCubes_; }
 
     // TODO: add error reporting as in single-threaded engine
@@ -130,6 +136,7 @@ private:
     QuantLib::ext::shared_ptr<ore::analytics::Scenario> offsetScenario_;
     bool useAtParCouponsCurves_ = true;
     bool useAtParCouponsTrades_ = true;
+    QuantLib::Size workUnitsPerThread_ = 1;
 
     QuantLib::ext::shared_ptr<AggregationScenarioData>
             aggregationScenarioData_;
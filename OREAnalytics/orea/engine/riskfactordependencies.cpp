@@ -0,0 +1,337 @@
+/*
+ Copyright (C) 2025 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+#include <orea/engine/dependencymarket.hpp>
+#include <orea/engine/riskfactordependencies.hpp>
+#include <orea/scenario/deltascenario.hpp>
+
+#include <ored/portfolio/enginefactory.hpp>
+#include <ored/utilities/log.hpp>
+
+#include <algorithm>
+
+using namespace ore::data;
+using QuantLib::Size;
+using std::map;
+using std::set;
+using std::string;
+using std::vector;
+
+namespace ore {
+namespace analytics {
+
+namespace {
+
+using KeyType = RiskFactorKey::KeyType;
+
+// the key types for which the dependencies are analysed, a trade depends on all keys of any other type
+const set<KeyType> analysedTypes = {KeyType::DiscountCurve,
+                                    KeyType::YieldCurve,
+                                    KeyType::IndexCurve,
+                                    KeyType::FXSpot,
+                                    KeyType::FXVolatility,
+                                    KeyType::SwaptionVolatility,
+                                    KeyType::YieldVolatility,
+                                    KeyType::OptionletVolatility,
+                                    KeyType::EquitySpot,
+                                    KeyType::DividendYield,
+                                    KeyType::EquityVolatility,
+                                    KeyType::SurvivalProbability,
+                                    KeyType::RecoveryRate,
+                                    KeyType::CDSVolatility,
+                                    KeyType::BaseCorrelation,
+                                    KeyType::ZeroInflationCurve,
+                                    KeyType::YoYInflationCurve,
+                                    KeyType::ZeroInflationCapFloorVolatility,
+                                    KeyType::YoYInflationCapFloorVolatility,
+                                    KeyType::CommodityCurve,
+                                    KeyType::CommodityVolatility,
+                                    KeyType::SecuritySpread,
+                                    KeyType::Correlation,
+                                    KeyType::CPR};
+
+// the key types for which the sim market builds term structures that also depend on other risk factors
+const set<KeyType> derivedTypes = {KeyType::FXVolatility,
+                                   KeyType::SwaptionVolatility,
+                                   KeyType::YieldVolatility,
+                                   KeyType::OptionletVolatility,
+                                   KeyType::EquitySpot,
+                                   KeyType::DividendYield,
+                                   KeyType::EquityVolatility,
+                                   KeyType::CDSVolatility,
+                                   KeyType::ZeroInflationCurve,
+                                   KeyType::YoYInflationCurve,
+                                   KeyType::ZeroInflationCapFloorVolatility,
+                                   KeyType::YoYInflationCapFloorVolatility,
+                                   KeyType::CommodityCurve,
+                                   KeyType::CommodityVolatility};
+
+} // namespace
+
+RiskFactorDependencies::RiskFactorDependencies(const QuantLib::ext::shared_ptr<Portfolio>& portfolio,
+                                               const QuantLib::ext::shared_ptr<EngineData>& engineData,
+                                               const string& baseCcy, const vector<RiskFactorKey>& simMarketKeys,
+                                               const QuantLib::ext::shared_ptr<CurveConfigurations>& curveConfigs,
+                                               const QuantLib::ext::shared_ptr<ReferenceDataManager>& referenceData,
+                                               const QuantLib::ext::shared_ptr<IborFallbackConfig>& iborFallbackConfig)
+    : baseCcy_(baseCcy), curveConfigs_(curveConfigs) {
+
+    QL_REQUIRE(portfolio, "RiskFactorDependencies: portfolio is null");
+    QL_REQUIRE(engineData, "RiskFactorDependencies: engine data is null");
+
+    for (auto const& k : simMarketKeys)
+        simMarketNames_[k.keytype].insert(k.name);
+
+    // work on a copy, so that the trades of the given portfolio are not rebuilt
+    auto pf = QuantLib::ext::make_shared<Portfolio>();
+    pf->fromXMLString(portfolio->toXMLString());
+
+    // avoid calibrations on the dependency market, as in the PortfolioAnalyser
+    auto ed = QuantLib::ext::make_shared<EngineData>(*engineData);
+    ed->globalParameters()["Calibrate"] = "false";
+
+    for (auto const& [tradeId, trade] : pf->trades()) {
+        // use a new market and engine factory per trade, cached engines would hide the market lookups otherwise
+        auto market = QuantLib::ext::make_shared<DependencyMarket>(baseCcy_, true, curveConfigs_, iborFallbackConfig);
+        auto factory = QuantLib::ext::make_shared<EngineFactory>(ed, market, map<MarketContext, string>(),
+                                                                 referenceData, iborFallbackConfig);
+        try {
+            trade->build(factory);
+        } catch (const std::exception& e) {
+            DLOG("RiskFactorDependencies: could not build trade '" << tradeId
+                                                                  << "' against dependency market, it will depend on "
+                                                                     "all risk factors: "
+                                                                  << e.what());
+            unknownTrades_.insert(tradeId);
+            continue;
+        }
+        // some engines look up market data during the calculation only
+        try {
+            trade->instrument()->NPV();
+        } catch (const std::exception& e) {
+            DLOG("RiskFactorDependencies: could not price trade '" << tradeId << "' against dependency market, "
+                                                                   << "ignore the error: " << e.what());
+        }
+        dependencies_[tradeId] = expand(market->riskFactors(), trade->npvCurrency());
+    }
+
+    for (auto const& [tradeId, _] : portfolio->trades()) {
+        if (!pf->has(tradeId))
+            unknownTrades_.insert(tradeId);
+    }
+
+    LOG("RiskFactorDependencies: analysed " << dependencies_.size() << " trades, " << unknownTrades_.size()
+                                            << " trades depend on all risk factors");
+}
+
+RiskFactorDependencies::TradeDependencies
+RiskFactorDependencies::expand(const map<KeyType, set<string>>& recorded, const string& npvCurrency) const {
+
+    TradeDependencies result;
+
+    auto simMarketNames = [this](const KeyType type) -> const set<string>& {
+        static const set<string> empty;
+        auto s = simMarketNames_.find(type);
+        return s == simMarketNames_.end() ? empty : s->second;
+    };
+
+    auto addIfSimulated = [&result, &simMarketNames](const KeyType type, const string& name) {
+        if (simMarketNames(type).count(name) == 0)
+            return false;
+        result.names[type].insert(name);
+        return true;
+    };
+
+    // the currencies of the trade
+
+    set<string> ccys;
+    if (!npvCurrency.empty())
+        ccys.insert(npvCurrency);
+    for (auto const& [type, names] : recorded) {
+        for (auto const& n : names) {
+            if (type == KeyType::DiscountCurve) {
+                ccys.insert(n);
+            } else if (type == KeyType::IndexCurve && n.size() > 3) {
+                ccys.insert(n.substr(0, 3));
+            } else if ((type == KeyType::FXSpot || type == KeyType::FXVolatility) && n.size() == 6) {
+                ccys.insert(n.substr(0, 3));
+                ccys.insert(n.substr(3));
+            } else if (type == KeyType::EquitySpot || type == KeyType::DividendYield ||
+                       type == KeyType::EquityVolatility) {
+                if (curveConfigs_ && curveConfigs_->hasEquityCurveConfig(n))
+                    ccys.insert(curveConfigs_->equityCurveConfig(n)->currency());
+                else
+                    result.allNames.insert(KeyType::DiscountCurve);
+            } else if (type == KeyType::CommodityCurve || type == KeyType::CommodityVolatility) {
+                if (curveConfigs_ && curveConfigs_->hasCommodityCurveConfig(n))
+                    ccys.insert(curveConfigs_->commodityCurveConfig(n)->currency());
+                else
+                    result.allNames.insert(KeyType::DiscountCurve);
+            }
+        }
+    }
+
+    // the recorded names, names that are not simulated might be aliases of simulated ones
+
+    for (auto const& [type, names] : recorded) {
+        if (type == KeyType::FXSpot)
+            continue;
+        for (auto const& n : names) {
+            if (addIfSimulated(type, n))
+                continue;
+            if (type == KeyType::FXVolatility && n.size() == 6 && addIfSimulated(type, n.substr(3) + n.substr(0, 3)))
+                continue;
+            if (auto p = n.find('&'); type == KeyType::Correlation && p != string::npos &&
+                                      addIfSimulated(type, n.substr(p + 1) + "&" + n.substr(0, p)))
+                continue;
+            result.allNames.insert(type);
+        }
+    }
+
+    // fx spots, the sim market triangulates over the base ccy
+
+    bool hasForeignCcy = std::any_of(ccys.begin(), ccys.end(), [this](const string& c) { return c != baseCcy_; });
+    for (auto const& n : simMarketNames(KeyType::FXSpot)) {
+        bool depends;
+        if (n.size() != 6) {
+            depends = true;
+        } else {
+            string ccy1 = n.substr(0, 3), ccy2 = n.substr(3);
+            if (ccy1 == baseCcy_)
+                depends = ccys.count(ccy2) > 0;
+            else if (ccy2 == baseCcy_)
+                depends = ccys.count(ccy1) > 0;
+            else
+                depends = hasForeignCcy;
+        }
+        if (depends)
+            result.names[KeyType::FXSpot].insert(n);
+    }
+
+    // risk factors the derived term structures of the sim market depend on
+
+    if (std::none_of(recorded.begin(), recorded.end(),
+                     [](const std::pair<const KeyType, set<string>>& r) { return derivedTypes.count(r.first) > 0; }))
+        return result;
+
+    for (auto type : {KeyType::DiscountCurve, KeyType::IndexCurve}) {
+        for (auto const& n : simMarketNames(type)) {
+            if (n.size() >= 3 && ccys.count(n.substr(0, 3)) > 0)
+                result.names[type].insert(n);
+        }
+    }
+    result.allNames.insert(KeyType::YieldCurve);
+
+    for (auto const& [type, names] : recorded) {
+        for (auto const& n : names) {
+            if (type == KeyType::EquitySpot || type == KeyType::DividendYield || type == KeyType::EquityVolatility) {
+                addIfSimulated(KeyType::EquitySpot, n);
+                addIfSimulated(KeyType::DividendYield, n);
+            } else if (type == KeyType::CommodityVolatility) {
+                addIfSimulated(KeyType::CommodityCurve, n);
+            } else if (type == KeyType::ZeroInflationCurve || type == KeyType::YoYInflationCurve ||
+                       type == KeyType::ZeroInflationCapFloorVolatility ||
+                       type == KeyType::YoYInflationCapFloorVolatility) {
+                addIfSimulated(KeyType::ZeroInflationCurve, n);
+                addIfSimulated(KeyType::YoYInflationCurve, n);
+            } else if (type == KeyType::CDSVolatility) {
+                // the cds vol names are not related to the credit curve names
+                result.allNames.insert(KeyType::SurvivalProbability);
+                result.allNames.insert(KeyType::RecoveryRate);
+            }
+        }
+    }
+
+    return result;
+}
+
+bool RiskFactorDependencies::dependsOn(const string& tradeId, const RiskFactorKey& key) const {
+    if (analysedTypes.count(key.keytype) == 0)
+        return true;
+    auto d = dependencies_.find(tradeId);
+    if (d == dependencies_.end())
+        return true;
+    if (d->second.allNames.count(key.keytype) > 0)
+        return true;
+    auto n = d->second.names.find(key.keytype);
+    return n != d->second.names.end() && n->second.count(key.name) > 0;
+}
+
+vector<QuantLib::ext::optional<vector<Size>>>
+RiskFactorDependencies::dependentTrades(const Portfolio& portfolio,
+                                        const vector<QuantLib::ext::shared_ptr<Scenario>>& scenarios) const {
+
+    // invert the dependencies: trades per (type, name), trades depending on all names of a type and unknown trades
+
+    map<std::pair<KeyType, string>, vector<Size>> tradesByName;
+    map<KeyType, vector<Size>> tradesByType;
+    vector<Size> unknown;
+    Size i = 0;
+    for (auto const& [tradeId, _] : portfolio.trades()) {
+        if (auto d = dependencies_.find(tradeId); d != dependencies_.end()) {
+            for (auto const& [type, names] : d->second.names) {
+                for (auto const& n : names)
+                    tradesByName[std::make_pair(type, n)].push_back(i);
+            }
+            for (auto const& type : d->second.allNames)
+                tradesByType[type].push_back(i);
+        } else {
+            unknown.push_back(i);
+        }
+        ++i;
+    }
+
+    vector<QuantLib::ext::optional<vector<Size>>> result(scenarios.size());
+    Size nAll = 0, nPairs = 0;
+    for (Size k = 0; k < scenarios.size(); ++k) {
+        auto delta = QuantLib::ext::dynamic_pointer_cast<DeltaScenario>(scenarios[k]);
+        if (delta == nullptr || delta->delta_keys().empty()) {
+            ++nAll;
+            continue;
+        }
+        set<std::pair<KeyType, string>> factors;
+        for (auto const& key : delta->delta_keys())
+            factors.insert(std::make_pair(key.keytype, key.name));
+        if (std::any_of(factors.begin(), factors.end(), [](const std::pair<KeyType, string>& f) {
+                return analysedTypes.count(f.first) == 0;
+            })) {
+            ++nAll;
+            continue;
+        }
+        vector<Size> trades(unknown);
+        for (auto const& f : factors) {
+            if (auto t = tradesByName.find(f); t != tradesByName.end())
+                trades.insert(trades.end(), t->second.begin(), t->second.end());
+            if (auto t = tradesByType.find(f.first); t != tradesByType.end())
+                trades.insert(trades.end(), t->second.begin(), t->second.end());
+        }
+        std::sort(trades.begin(), trades.end());
+        trades.erase(std::unique(trades.begin(), trades.end()), trades.end());
+        nPairs += trades.size();
+        result[k] = std::move(trades);
+    }
+
+    LOG("RiskFactorDependencies: " << nAll << " out of " << scenarios.size()
+                                   << " scenarios require all trades, the other scenarios require " << nPairs
+                                   << " trade valuations instead of " << (scenarios.size() - nAll) * i);
+
+    return result;
+}
+
+} // namespace analytics
+} // namespace ore
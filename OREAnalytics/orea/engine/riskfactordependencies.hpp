@@ -0,0 +1,106 @@
+/*
+ Copyright (C) 2025 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+/*! \file orea/engine/riskfactordependencies.hpp
+    \brief risk factors the single trades of a portfolio depend on
+    \ingroup engine
+*/
+
+#pragma once
+
+#include <orea/scenario/scenario.hpp>
+
+#include <ored/configuration/curveconfigurations.hpp>
+#include <ored/configuration/iborfallbackconfig.hpp>
+#include <ored/portfolio/enginedata.hpp>
+#include <ored/portfolio/portfolio.hpp>
+#include <ored/portfolio/referencedata.hpp>
+
+#include <ql/optional.hpp>
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace ore {
+namespace analytics {
+
+//! Risk factor dependencies of single trades
+/*! Each trade of the portfolio is built (and priced) against its own DependencyMarket, which records the risk factors
+    the trade requests. The recorded names are then mapped to the keys of a simulation market, erring on the side of
+    caution, i.e. a trade might be reported to depend on a key even if it does not, but never the other way round:
+
+    - the trade depends on all FX spots involving one of its currencies, including the npv currency, since the sim
+      market triangulates the FX rates over the base currency
+    - a recorded name that is not among the sim market keys lets the trade depend on all keys of that type, since
+      the name might be an alias of a simulated one
+    - for volatilities, equities, commodities and inflation the sim market derives term structures from other risk
+      factors (e.g. the equity forecast curve, the ATM level of a vol surface), for trades depending on these types
+      all discount and index curves in the trade's currencies and all yield curves are added
+    - key types that are not analysed, trades that fail to build against the dependency market and trades that are
+      not known to this class depend on all keys
+
+    The given portfolio is not modified, the analysis is run on a copy built from its XML representation.
+
+    \ingroup engine
+*/
+class RiskFactorDependencies {
+public:
+    RiskFactorDependencies(const QuantLib::ext::shared_ptr<ore::data::Portfolio>& portfolio,
+                           const QuantLib::ext::shared_ptr<ore::data::EngineData>& engineData,
+                           const std::string& baseCcy, const std::vector<RiskFactorKey>& simMarketKeys,
+                           const QuantLib::ext::shared_ptr<ore::data::CurveConfigurations>& curveConfigs = nullptr,
+                           const QuantLib::ext::shared_ptr<ore::data::ReferenceDataManager>& referenceData = nullptr,
+                           const QuantLib::ext::shared_ptr<ore::data::IborFallbackConfig>& iborFallbackConfig =
+                               QuantLib::ext::make_shared<ore::data::IborFallbackConfig>(
+                                   ore::data::IborFallbackConfig::defaultConfig()));
+
+    //! true if the value of the trade might change when the key is shifted
+    bool dependsOn(const std::string& tradeId, const RiskFactorKey& key) const;
+
+    //! trades that could not be analysed and therefore depend on all keys
+    const std::set<std::string>& unknownTrades() const { return unknownTrades_; }
+
+    /*! For each scenario the indices of the trades of the given portfolio (in the order of Portfolio::trades()) that
+        might depend on one of the keys changed by the scenario. For a DeltaScenario these are the keys of the delta.
+        For all other scenarios, a DeltaScenario without changes or changes of keys with a type that is not analysed
+        the entry is empty, meaning that all trades have to be priced. */
+    std::vector<QuantLib::ext::optional<std::vector<QuantLib::Size>>>
+    dependentTrades(const ore::data::Portfolio& portfolio,
+                    const std::vector<QuantLib::ext::shared_ptr<Scenario>>& scenarios) const;
+
+private:
+    struct TradeDependencies {
+        std::map<RiskFactorKey::KeyType, std::set<std::string>> names;
+        // the trade depends on all keys of these types
+        std::set<RiskFactorKey::KeyType> allNames;
+    };
+
+    TradeDependencies expand(const std::map<RiskFactorKey::KeyType, std::set<std::string>>& recorded,
+                             const std::string& npvCurrency) const;
+
+    std::string baseCcy_;
+    QuantLib::ext::shared_ptr<ore::data::CurveConfigurations> curveConfigs_;
+    std::map<RiskFactorKey::KeyType, std::set<std::string>> simMarketNames_;
+    std::map<std::string, TradeDependencies> dependencies_;
+    std::set<std::string> unknownTrades_;
+};
+
+} // namespace analytics
+} // namespace ore
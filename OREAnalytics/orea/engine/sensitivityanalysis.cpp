@@ -19,6 +19,7 @@
 #include <orea/cube/jointnpvsensicube.hpp>
 #include <orea/cube/sensicube.hpp>
 #include <orea/engine/multithreadedvaluationengine.hpp>
+#include <orea/engine/riskfactordependencies.hpp>
 #include <orea/engine/sensitivityanalysis.hpp>
 #include <orea/engine/valuationcalculator.hpp>
 #include <orea/engine/valuationengine.hpp>
@@ -193,6 +194,14 @@ void SensitivityAnalysis::generateSensitivities() {
             calculators.push_back(
                 QuantLib::ext::make_shared<NPVCalculator>(simMarketData_->baseCcy(), 0, laxFxConversion_));
 
+        QuantLib::ext::shared_ptr<RiskFactorDependencies> dependencies;
+        if (skipIndependentTrades_ && !dryRun_) {
+            LOG("Analyse the risk factor dependencies of the trades");
+            dependencies = QuantLib::ext::make_shared<RiskFactorDependencies>(
+                portfolio_, ed, simMarketData_->baseCcy(), simMarket_->baseScenario()->keys(), curveConfigs_,
+                referenceData_, iborFallbackConfig_);
+        }
+
         sensiCubes_.clear();
         for (auto const& [pf, scenGen] :
              splitPortfolioByScenarioGenerators(portfolio_, sensiTemplateIds, scenarioGenerators)) {
@@ -209,8 +218,11 @@ void SensitivityAnalysis::generateSensitivities() {
             ValuationEngine engine(asof_, dg, simMarket_, factory->modelBuilders(), recalibrateModels_);
             for (auto const& i : this->progressIndicators())
                 engine.registerProgressIndicator(i);
+            std::vector<QuantLib::ext::optional<std::vector<Size>>> sampleTrades;
+            if (dependencies)
+                sampleTrades = dependencies->dependentTrades(*pf, scenGen->scenarios());
             engine.buildCube(pf, cube, calculators, ValuationEngine::ErrorPolicy::RemoveAll, true, nullptr, nullptr, {},
-                             dryRun_);
+                             dryRun_, nullptr, sampleTrades);
 
             sensiCubes_.push_back(QuantLib::ext::make_shared<SensitivityCube>(cube, scenGen->scenarioDescriptions(),
                                                                       scenarioGenerator_->shiftSizes(),
@@ -220,6 +232,10 @@ void SensitivityAnalysis::generateSensitivities() {
 
         // handle request to use multi-threaded engine
 
+        if (skipIndependentTrades_)
+            WLOG("SensitivityAnalysis::generateSensitivities(): skipping independent trades is not supported by the "
+                 "multi-threaded engine, all trades are priced in all scenarios.");
+
         LOG("SensitivitiyAnalysis::generateSensitivities(): use multi-threaded engine to generate sensi cube. Using "
             "configuration '"
             << marketConfiguration_ << "'");
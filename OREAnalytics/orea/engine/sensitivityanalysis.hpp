@@ -125,6 +125,10 @@ public:
     //! override shift tenors with sim market tenors
     void overrideTenors(const bool b) { overrideTenors_ = b; }
 
+    /*! only reprice the trades that depend on the risk factors shifted in a scenario, see RiskFactorDependencies,
+        this is supported by the single-threaded engine only */
+    void skipIndependentTrades(const bool b) { skipIndependentTrades_ = b; }
+
     //! the portfolio of trades
     QuantLib::ext::shared_ptr<Portfolio> portfolio() const { return portfolio_; }
 
@@ -177,6 +181,8 @@ private:
     QuantLib::ext::shared_ptr<Portfolio> portfolio_;
     //! do dry run
     bool dryRun_;
+    //! reprice the dependent trades only
+    bool skipIndependentTrades_ = false;
 
     //! sensitivityCube
     std::vector<QuantLib::ext::shared_ptr<SensitivityCube>> sensiCubes_;
@@ -67,7 +67,7 @@ SensitivityRecord SensitivityCubeStream::next() {
     if (cubes_.size() == 0)
         return SensitivityRecord();
 
-    while (tradeIdx_ != cubes_[currentCubeIdx_]->tradeIdx().end() && currentDeltaKey_ == currentDeltaKeys_.end() &&
+    while (tradeIdx_ != cubes_[currentCubeIdx_]->tradeIdx().end() && currentDeltaId_ == currentDeltaIds_.end() &&
            currentCrossGammaKey_ == currentCrossGammaKeys_.end()) {
         ++tradeIdx_;
         updateForNewTrade();
@@ -92,17 +92,17 @@ SensitivityRecord SensitivityCubeStream::next() {
     sr.tradeCurrency = currentTradeCurrency_;
     sr.baseNpv = cubes_[currentCubeIdx_]->npv(tradeIdx);
 
-    if (currentDeltaKey_ != currentDeltaKeys_.end()) {
-        auto const& fd = cubes_[currentCubeIdx_]->upThenDownFactorData(*currentDeltaKey_);
-        sr.key_1 = *currentDeltaKey_;
+    if (currentDeltaId_ != currentDeltaIds_.end()) {
+        auto const& fd = cubes_[currentCubeIdx_]->factorData(*currentDeltaId_);
+        sr.key_1 = cubes_[currentCubeIdx_]->factorKey(*currentDeltaId_);
         sr.desc_1 = fd.factorDesc;
         sr.shift_1 = fd.targetShiftSize;
-        sr.delta = cubes_[currentCubeIdx_]->delta(tradeIdx_->first, *currentDeltaKey_);
+        sr.delta = cubes_[currentCubeIdx_]->delta(tradeIdx, *currentDeltaId_);
         if (canComputeGamma_)
-            sr.gamma = cubes_[currentCubeIdx_]->gamma(tradeIdx_->first, *currentDeltaKey_);
+            sr.gamma = cubes_[currentCubeIdx_]->gamma(tradeIdx, *currentDeltaId_);
         else
             sr.gamma = Null<Real>();
-        ++currentDeltaKey_;
+        ++currentDeltaId_;
     } else if (currentCrossGammaKey_ != currentCrossGammaKeys_.end()) {
         auto const& fd = cubes_[currentCubeIdx_]->crossFactors().at(*currentCrossGammaKey_);
         sr.key_1 = currentCrossGammaKey_->first;
@@ -111,7 +111,7 @@ SensitivityRecord SensitivityCubeStream::next() {
         sr.key_2 = currentCrossGammaKey_->second;
         sr.desc_2 = std::get<1>(fd).factorDesc;
         sr.shift_2 = std::get<1>(fd).targetShiftSize;
-        sr.gamma = cubes_[currentCubeIdx_]->crossGamma(tradeIdx_->first, *currentCrossGammaKey_);
+        sr.gamma = cubes_[currentCubeIdx_]->crossGamma(tradeIdx, *currentCrossGammaKey_);
         ++currentCrossGammaKey_;
     }
     TLOG("Next record is: " << sr);
@@ -119,7 +119,7 @@ SensitivityRecord SensitivityCubeStream::next() {
 }
 
 void SensitivityCubeStream::updateForNewTrade() {
-    currentDeltaKeys_.clear();
+    currentDeltaIds_.clear();
     currentCrossGammaKeys_.clear();
 
     if (tradeIdx_ != cubes_[currentCubeIdx_]->tradeIdx().end()) {
@@ -128,11 +128,11 @@ void SensitivityCubeStream::updateForNewTrade() {
         if (!tradeCurrency_.empty())
             currentTradeCurrency_ = tradeCurrency_.find(tradeIdx_->first)->second;
 
-        // add delta keys
+        // add delta factor ids, these are in the order of the risk factor keys
 
         for (auto const& [idx, _] : cubes_[currentCubeIdx_]->npvCube()->getTradeNPVs(tradeIdx_->second)) {
-            if (auto k = cubes_[currentCubeIdx_]->upDownFactor(idx); k.keytype != RiskFactorKey::KeyType::None)
-                currentDeltaKeys_.insert(k);
+            if (auto id = cubes_[currentCubeIdx_]->scenarioFactorId(idx); id != Null<Size>())
+                currentDeltaIds_.insert(id);
         }
 
         // add cross gamma keys
@@ -146,13 +146,13 @@ void SensitivityCubeStream::updateForNewTrade() {
 
                 // make sure, delta keys contain both cross keys, that's a guarantee of the SensitivityCubeStream
 
-                currentDeltaKeys_.insert(crossPair.first);
-                currentDeltaKeys_.insert(crossPair.second);
+                currentDeltaIds_.insert(cubes_[currentCubeIdx_]->scenarioFactorId(std::get<0>(data).index));
+                currentDeltaIds_.insert(cubes_[currentCubeIdx_]->scenarioFactorId(std::get<1>(data).index));
             }
         }
     }
 
-    currentDeltaKey_ = currentDeltaKeys_.begin();
+    currentDeltaId_ = currentDeltaIds_.begin();
     currentCrossGammaKey_ = currentCrossGammaKeys_.begin();
 }
 
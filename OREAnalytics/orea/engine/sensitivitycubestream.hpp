@@ -68,11 +68,11 @@ private:
     //! Current cube index in vector
     Size currentCubeIdx_;
 
-    //! Current delta risk factor keys to process and iterators
-    std::set<RiskFactorKey> currentDeltaKeys_;
+    //! Current delta factor ids (see SensitivityCube::factorId()) and cross gamma keys to process and iterators
+    std::set<Size> currentDeltaIds_;
     std::set<std::pair<RiskFactorKey,RiskFactorKey>> currentCrossGammaKeys_;
 
-    std::set<RiskFactorKey>::const_iterator currentDeltaKey_;
+    std::set<Size>::const_iterator currentDeltaId_;
     std::set<std::pair<RiskFactorKey,RiskFactorKey>>::const_iterator currentCrossGammaKey_;
 
     //! Current trade iterator
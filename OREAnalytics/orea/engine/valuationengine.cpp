@@ -17,6 +17,7 @@
 */
 
 #include <orea/cube/npvcube.hpp>
+#include <orea/cube/npvsensicube.hpp>
 #include <orea/engine/cptycalculator.hpp>
 #include <orea/engine/observationmode.hpp>
 #include <orea/engine/valuationcalculator.hpp>
@@ -78,7 +79,7 @@ void ValuationEngine::buildCube(const QuantLib::ext::shared_ptr<data::Portfolio>
                                 QuantLib::ext::shared_ptr<analytics::NPVCube> outputCubeNettingSet,
                                 QuantLib::ext::shared_ptr<analytics::NPVCube> outputCptyCube,
                                 vector<QuantLib::ext::shared_ptr<CounterpartyCalculator>> cptyCalculators, bool dryRun,
-                                Errors* errors) {
+                                Errors* errors, const vector<QuantLib::ext::optional<vector<Size>>>& sampleTrades) {
 
     struct SimMarketResetter {
         SimMarketResetter(QuantLib::ext::shared_ptr<SimMarket> simMarket) : simMarket_(simMarket) {}
@@ -111,6 +112,17 @@ void ValuationEngine::buildCube(const QuantLib::ext::shared_ptr<data::Portfolio>
                                                                           << dg_->dates().size() << ")");
     }
 
+    if (!sampleTrades.empty()) {
+        QL_REQUIRE(sampleTrades.size() == outputCube->samples(), "ValuationEngine: sample trades size ("
+                                                                     << sampleTrades.size()
+                                                                     << ") does not match cube samples ("
+                                                                     << outputCube->samples() << ")");
+        QL_REQUIRE(QuantLib::ext::dynamic_pointer_cast<NPVSensiCube>(outputCube) != nullptr,
+                   "ValuationEngine: sample trades can only be used with a NPVSensiCube");
+        QL_REQUIRE(outputCubeNettingSet == nullptr && outputCptyCube == nullptr,
+                   "ValuationEngine: sample trades can not be used with netting set or counterparty cubes");
+    }
+
     LOG("Starting ValuationEngine for " << portfolio->size() << " trades, " << outputCube->samples() << " samples and "
                                         << dg_->size() << " dates.");
 
@@ -128,14 +140,15 @@ void ValuationEngine::buildCube(const QuantLib::ext::shared_ptr<data::Portfolio>
 
     // Loop is Samples, Dates, Trades
     const auto& dates = dg_->dates();
-    const auto& trades = portfolio->trades();
+    IndexedTrades trades;
+    for (auto const& [tradeId, trade] : portfolio->trades())
+        trades.push_back(std::make_pair(trades.size(), trade));
     auto& counterparties = outputCptyCube ? outputCptyCube->idsAndIndexes() : std::map<string, Size>();
     std::vector<bool> tradeHasT0Error(portfolio->size(), false);
     std::vector<bool> tradeHasSampleError(portfolio->size(), false);
     LOG("Initialise state objects...");
     // initialise state objects for each trade (required for path-dependent derivatives in particular)
-    size_t i = 0;
-    for (const auto& [tradeId, trade] : trades) {
+    for (const auto& [i, trade] : trades) {
         QL_REQUIRE(!trade->npvCurrency().empty(), "NPV currency not set for trade " << trade->id());
 
         DLOG("Initialise wrapper for trade " << trade->id());
@@ -149,7 +162,7 @@ void ValuationEngine::buildCube(const QuantLib::ext::shared_ptr<data::Portfolio>
                 calc->calculateT0(trade, i, simMarket_, outputCube, outputCubeNettingSet);
         } catch (const std::exception& e) {
             string expMsg = string("T0 valuation error: ") + e.what();
-            StructuredTradeErrorMessage(tradeId, trade->tradeType(), "ScenarioValuation", expMsg.c_str()).log();
+            StructuredTradeErrorMessage(trade->id(), trade->tradeType(), "ScenarioValuation", expMsg.c_str()).log();
             tradeHasT0Error[i] = true;
             if (errors)
                 errors->t0.insert(i);
@@ -171,7 +184,6 @@ void ValuationEngine::buildCube(const QuantLib::ext::shared_ptr<data::Portfolio>
                 }
             }
         }
-        ++i;
     }
     LOG("Total number of trades = " << portfolio->size());
 
@@ -183,6 +195,7 @@ void ValuationEngine::buildCube(const QuantLib::ext::shared_ptr<data::Portfolio>
     cpu_timer timer;
     cpu_timer loopTimer;
     Size nTrades = trades.size();
+    Size nSkipped = 0;
 
     // We call Cube::samples() each time here to allow for dynamic stopping times
     // e.g. MC convergence tests
@@ -190,7 +203,19 @@ void ValuationEngine::buildCube(const QuantLib::ext::shared_ptr<data::Portfolio>
          ++sample) {
         TLOG("ValuationEngine: apply scenario sample #" << sample);
 
-        for (auto& [tradeId, trade] : portfolio->trades())
+        // the trades to price in this sample, the values of the other trades are not touched
+        IndexedTrades sampleTradesTmp;
+        if (!sampleTrades.empty() && sampleTrades[sample]) {
+            for (auto const i : *sampleTrades[sample]) {
+                QL_REQUIRE(i < nTrades, "ValuationEngine: sample trade index " << i << " out of range (" << nTrades
+                                                                                << " trades) for sample " << sample);
+                sampleTradesTmp.push_back(trades[i]);
+            }
+            nSkipped += nTrades - sampleTradesTmp.size();
+        }
+        const IndexedTrades& tradesToPrice = !sampleTrades.empty() && sampleTrades[sample] ? sampleTradesTmp : trades;
+
+        for (auto& [i, trade] : tradesToPrice)
             trade->instrument()->reset();
 
         // loop over Dates, increase cubeDateIndex for each valuation date we hit
@@ -206,17 +231,18 @@ void ValuationEngine::buildCube(const QuantLib::ext::shared_ptr<data::Portfolio>
                 Date valueDate = dg_->valuationDates()[i];
                 Date closeOutDate = dg_->closeOutDateFromValuationDate(valueDate);
                 std::tie(priceTime, upTime, calTime) =
-                    populateCube(valueDate, cubeDateIndex, sample, true, false, scenarioUpdated, trades, errorPolicy,
-                                 tradeHasT0Error, tradeHasSampleError, calculators, outputCube, outputCubeNettingSet,
-                                 counterparties, cptyCalculators, outputCptyCube, errors);
+                    populateCube(valueDate, cubeDateIndex, sample, true, false, scenarioUpdated, tradesToPrice,
+                                 errorPolicy, tradeHasT0Error, tradeHasSampleError, calculators, outputCube,
+                                 outputCubeNettingSet, counterparties, cptyCalculators, outputCptyCube, errors);
                 pricingTime += priceTime;
                 updateTime += upTime;
                 calibrationTime += calTime;
                 if (closeOutDate != Date()) {
                     std::tie(priceTime, upTime, calTime) =
                         populateCube(closeOutDate, cubeDateIndex, sample, false, mporStickyDate, scenarioUpdated,
-                                     trades, errorPolicy, tradeHasT0Error, tradeHasSampleError, calculators, outputCube,
-                                     outputCubeNettingSet, counterparties, cptyCalculators, outputCptyCube, errors);
+                                     tradesToPrice, errorPolicy, tradeHasT0Error, tradeHasSampleError, calculators,
+                                     outputCube, outputCubeNettingSet, counterparties, cptyCalculators, outputCptyCube,
+                                     errors);
                     pricingTime += priceTime;
                     updateTime += upTime;
                     calibrationTime += calTime;
@@ -239,9 +265,10 @@ void ValuationEngine::buildCube(const QuantLib::ext::shared_ptr<data::Portfolio>
                                "Need to calculate valuation date before close out date");
                     for (size_t& valueDateIndex : closeOutDateToValueDateIndex[d]) {
                         std::tie(priceTime, upTime, calTime) =
-                            populateCube(d, valueDateIndex, sample, false, mporStickyDate, scenarioUpdated, trades,
-                                         errorPolicy, tradeHasT0Error, tradeHasSampleError, calculators, outputCube,
-                                         outputCubeNettingSet, counterparties, cptyCalculators, outputCptyCube, errors);
+                            populateCube(d, valueDateIndex, sample, false, mporStickyDate, scenarioUpdated,
+                                         tradesToPrice, errorPolicy, tradeHasT0Error, tradeHasSampleError, calculators,
+                                         outputCube, outputCubeNettingSet, counterparties, cptyCalculators,
+                                         outputCptyCube, errors);
                         pricingTime += priceTime;
                         updateTime += upTime;
                         calibrationTime += calTime;
@@ -257,8 +284,8 @@ void ValuationEngine::buildCube(const QuantLib::ext::shared_ptr<data::Portfolio>
                     if (closeOutDate != Date())
                         closeOutDateToValueDateIndex[closeOutDate].push_back(cubeDateIndex);
                     std::tie(priceTime, upTime, calTime) =
-                        populateCube(d, cubeDateIndex, sample, true, false, scenarioUpdated, trades, errorPolicy,
-                                     tradeHasT0Error, tradeHasSampleError, calculators, outputCube,
+                        populateCube(d, cubeDateIndex, sample, true, false, scenarioUpdated, tradesToPrice,
+                                     errorPolicy, tradeHasT0Error, tradeHasSampleError, calculators, outputCube,
                                      outputCubeNettingSet, counterparties, cptyCalculators, outputCptyCube, errors);
                     pricingTime += priceTime;
                     updateTime += upTime;
@@ -304,24 +331,24 @@ void ValuationEngine::buildCube(const QuantLib::ext::shared_ptr<data::Portfolio>
                                            << "update " << updateTime << " sec, "
                                            << "calibration " << calibrationTime << " sec, "
                                            << "fixing " << fixingTime);
+    if (!sampleTrades.empty())
+        LOG("ValuationEngine skipped " << nSkipped << " out of " << nTrades * outputCube->samples()
+                                       << " trade valuations, because the trades do not depend on the sample");
 
     // for trades with errors set output cube values to zero depending on chosen error policy
-    i = 0;
-    for (auto& [tradeId, trade] : trades) {
+    for (auto& [i, trade] : trades) {
         if (tradeHasT0Error[i] || (tradeHasSampleError[i] && errorPolicy == ErrorPolicy::RemoveAll)) {
             LOG("Setting all results in output cube to zero for trade '"
-                << tradeId << "'. Trade has t0 valuation error: " << std::boolalpha << tradeHasT0Error[i]
+                << trade->id() << "'. Trade has t0 valuation error: " << std::boolalpha << tradeHasT0Error[i]
                 << ". Trade has sample valuation error: " << tradeHasSampleError[i]
                 << ". Error Policy is RemoveAll: " << (errorPolicy == ErrorPolicy::RemoveAll) << ".");
             outputCube->removeT0(i);
             outputCube->remove(i, Null<Size>(), false);
         }
-        i++;
     }
 }
 
-void ValuationEngine::runCalculators(bool isCloseOutDate,
-                                     const std::map<std::string, QuantLib::ext::shared_ptr<Trade>>& trades,
+void ValuationEngine::runCalculators(bool isCloseOutDate, const IndexedTrades& trades,
                                      const ErrorPolicy errorPolicy, std::vector<bool>& tradeHasT0Error,
                                      std::vector<bool>& tradeHasSampleError,
                                      const std::vector<QuantLib::ext::shared_ptr<ValuationCalculator>>& calculators,
@@ -333,9 +360,7 @@ void ValuationEngine::runCalculators(bool isCloseOutDate,
     for (auto& calc : calculators)
         calc->initScenario();
     // loop over trades
-    size_t j = 0;
-    for (auto tradeIt = trades.begin(); tradeIt != trades.end(); ++tradeIt, ++j) {
-        auto trade = tradeIt->second;
+    for (auto const& [j, trade] : trades) {
         if (tradeHasT0Error[j] || (tradeHasSampleError[j] && errorPolicy == ErrorPolicy::RemoveAll)) {
             outputCube->remove(j, sample, false);
             continue;
@@ -372,9 +397,8 @@ void ValuationEngine::runCalculators(bool isCloseOutDate, const std::map<std::st
     }
 }
 
-void ValuationEngine::tradeExercisable(bool enable,
-                                       const std::map<std::string, QuantLib::ext::shared_ptr<Trade>>& trades) {
-    for (const auto& [tradeId, trade] : trades) {
+void ValuationEngine::tradeExercisable(bool enable, const IndexedTrades& trades) {
+    for (const auto& [i, trade] : trades) {
         auto t = QuantLib::ext::dynamic_pointer_cast<OptionWrapper>(trade->instrument());
         if (t != nullptr) {
             if (enable)
@@ -387,7 +411,7 @@ void ValuationEngine::tradeExercisable(bool enable,
 
 std::tuple<double, double, double> ValuationEngine::populateCube(
     const QuantLib::Date& d, size_t cubeDateIndex, size_t sample, bool isValueDate, bool isStickyDate,
-    bool scenarioUpdated, const std::map<std::string, QuantLib::ext::shared_ptr<Trade>>& trades,
+    bool scenarioUpdated, const IndexedTrades& trades,
     const ErrorPolicy errorPolicy, std::vector<bool>& tradeHasT0Error, std::vector<bool>& tradeHasSampleError,
     const std::vector<QuantLib::ext::shared_ptr<ValuationCalculator>>& calculators,
     QuantLib::ext::shared_ptr<analytics::NPVCube>& outputCube,
@@ -25,6 +25,7 @@
 
 #include <ored/utilities/progressbar.hpp>
 
+#include <ql/optional.hpp>
 #include <ql/time/date.hpp>
 
 #include <map>
@@ -110,13 +111,18 @@ public:
         //! Limit samples to one and fill the rest of the cube with random values
         bool dryRun = false,
         //! errors
-        Errors* errors = nullptr);
-        
+        Errors* errors = nullptr,
+        /*! If not empty, the trades (given by their index in the portfolio) to price for each sample, a missing entry
+            meaning all trades. The cube values of the other trades are not set, therefore the output cube must be
+            a NPVSensiCube (which returns the T0 value for these) and there must be no netting set or cpty cube. */
+        const std::vector<QuantLib::ext::optional<std::vector<QuantLib::Size>>>& sampleTrades = {});
+
 private:
     void recalibrateModels();
+    using IndexedTrades = std::vector<std::pair<QuantLib::Size, QuantLib::ext::shared_ptr<ore::data::Trade>>>;
     std::tuple<double, double, double>
     populateCube(const QuantLib::Date& d, size_t cubeDateIndex, size_t sample, bool isValueDate, bool isStickyDate,
-                 bool scenarioUpdated, const std::map<std::string, QuantLib::ext::shared_ptr<ore::data::Trade>>& trades,
+                 bool scenarioUpdated, const IndexedTrades& trades,
                  const ErrorPolicy errorPolicy, std::vector<bool>& tradeHasT0Error,
                  std::vector<bool>& tradeHasSampleError,
                  const std::vector<QuantLib::ext::shared_ptr<ValuationCalculator>>& calculators,
@@ -125,8 +131,7 @@ private:
                  const std::map<std::string, size_t>& counterparties,
                  const std::vector<QuantLib::ext::shared_ptr<CounterpartyCalculator>>& cptyCalculators,
                  QuantLib::ext::shared_ptr<analytics::NPVCube>& outputCptyCube, Errors* errors);
-    void runCalculators(bool isCloseOutDate,
-                        const std::map<std::string, QuantLib::ext::shared_ptr<ore::data::Trade>>& trades,
+    void runCalculators(bool isCloseOutDate, const IndexedTrades& trades,
                         const ErrorPolicy errorPolicy, std::vector<bool>& tradeHasT0Error,
                         std::vector<bool>& tradeHasSampleError,
                         const std::vector<QuantLib::ext::shared_ptr<ValuationCalculator>>& calculators,
@@ -138,7 +143,7 @@ private:
                         const std::vector<QuantLib::ext::shared_ptr<CounterpartyCalculator>>& calculators,
                         QuantLib::ext::shared_ptr<analytics::NPVCube>& cptyCube, const QuantLib::Date& d,
                         const QuantLib::Size cubeDateIndex, const QuantLib::Size sample);
-    void tradeExercisable(bool enable, const std::map<std::string, QuantLib::ext::shared_ptr<ore::data::Trade>>& trades);
+    void tradeExercisable(bool enable, const IndexedTrades& trades);
     QuantLib::Date today_;
     QuantLib::ext::shared_ptr<ore::data::DateGrid> dg_;
     QuantLib::ext::shared_ptr<ore::analytics::SimMarket> simMarket_;
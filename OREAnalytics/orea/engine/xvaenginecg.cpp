@@ -35,6 +35,7 @@
 #include <qle/ad/forwardderivatives.hpp>
 #include <qle/ad/forwardevaluation.hpp>
 #include <qle/ad/ssaform.hpp>
+#include <qle/ad/tiledevaluation.hpp>
 #include <qle/math/randomvariable_ops.hpp>
 #include <qle/methods/multipathvariategenerator.hpp>
 
@@ -72,6 +73,10 @@ std::ostream& operator<<(std::ostream& os, XvaEngineCG::Mode m) {
 }
 
 namespace {
+
+// number of paths per tile in the multi-threaded fwd evaluation / bwd derivatives
+constexpr std::size_t tiledEvaluationTileSize = 1024;
+
 std::size_t numberOfStochasticRvs(const std::vector<RandomVariable>& v) {
     return std::count_if(v.begin(), v.end(),
                          [](const RandomVariable& r) { return r.initialised() && !r.deterministic(); });
@@ -107,11 +112,12 @@ XvaEngineCG::XvaEngineCG(const Mode mode, const Size nThreads, const Date& asof,
                          const bool continueOnCalibrationError, const bool allowModelFallbacks,
                          const bool continueOnError, const bool useAtParCouponsCurves, const bool useAtParCouponsTrades,
                          const std::string& context)
-    : mode_(mode), asof_(asof), loader_(loader), curveConfigs_(curveConfigs), todaysMarketParams_(todaysMarketParams),
-      simMarketData_(simMarketData), engineData_(engineData), crossAssetModelData_(crossAssetModelData),
-      scenarioGeneratorData_(scenarioGeneratorData), portfolio_(portfolio), marketConfiguration_(marketConfiguration),
-      marketConfigurationInCcy_(marketConfigurationInCcy), sensitivityData_(sensitivityData),
-      referenceData_(referenceData), iborFallbackConfig_(iborFallbackConfig), bumpCvaSensis_(bumpCvaSensis),
+    : mode_(mode), nThreads_(nThreads), asof_(asof), loader_(loader), curveConfigs_(curveConfigs),
+      todaysMarketParams_(todaysMarketParams), simMarketData_(simMarketData), engineData_(engineData),
+      crossAssetModelData_(crossAssetModelData), scenarioGeneratorData_(scenarioGeneratorData), portfolio_(portfolio),
+      marketConfiguration_(marketConfiguration), marketConfigurationInCcy_(marketConfigurationInCcy),
+      sensitivityData_(sensitivityData), referenceData_(referenceData), iborFallbackConfig_(iborFallbackConfig),
+      bumpCvaSensis_(bumpCvaSensis),
       enableDynamicIM_(enableDynamicIM), dynamicIMStepSize_(dynamicIMStepSize), regressionOrder_(regressionOrder),
       regressionVarianceCutoff_(regressionVarianceCutoff), regressionOrderDynamicIm_(regressionOrderDynamicIm),
       regressionVarianceCutoffDynamicIm_(regressionVarianceCutoffDynamicIm), tradeLevelBreakDown_(tradeLevelBreakDown),
@@ -610,6 +616,21 @@ void XvaEngineCG::finalizeExternalCalculation() {
     }
 }
 
+void XvaEngineCG::runBackwardDerivatives(std::vector<RandomVariable>& derivatives,
+                                         const std::vector<bool>& keepNodes) {
+    auto g = model_->computationGraph();
+    if (workerPool_) {
+        backwardDerivativesTiled(*workerPool_, tiledEvaluationTileSize, *g, values_, derivatives, gradsFactory_,
+                                 gradIsPathwise_, RandomVariable::deleter, keepNodes, opsFactory_, opIsPathwise_,
+                                 opNodeRequirements_, keepNodes_, RandomVariableOpCode::ConditionalExpectation,
+                                 ops_[RandomVariableOpCode::ConditionalExpectation]);
+    } else {
+        backwardDerivatives(*g, values_, derivatives, grads_, RandomVariable::deleter, keepNodes, ops_,
+                            opNodeRequirements_, keepNodes_, RandomVariableOpCode::ConditionalExpectation,
+                            ops_[RandomVariableOpCode::ConditionalExpectation]);
+    }
+}
+
 void XvaEngineCG::doForwardEvaluation() {
 
     DLOG("XvaEngineCG: do forward evaluation");
@@ -649,10 +670,24 @@ void XvaEngineCG::doForwardEvaluation() {
         opsExternal_ = getExternalRandomVariableOps();
         gradsExternal_ = getExternalRandomVariableGradients();
     } else {
-        ops_ = getRandomVariableOps(model_->size(), regressionOrder_, QuantLib::LsmBasisSystem::Monomial,
-                                    (sensitivityData_ && bumpCvaSensis_) ? eps : 0.0, regressionVarianceCutoff_,
-                                    pfRegressorPosGroups_, usePythonIntegration_);
-        grads_ = getRandomVariableGradients(model_->size(), regressionOrder_, QuantLib::LsmBasisSystem::Monomial, eps);
+        Real opsEps = (sensitivityData_ && bumpCvaSensis_) ? eps : 0.0;
+        if (nThreads_ > 1 && !workerPool_)
+            workerPool_ = QuantLib::ext::make_shared<QuantExt::WorkerPool>(nThreads_);
+        // the regressions of the conditional expectations, which are evaluated on all paths, use the worker pool
+        opsFactory_ = [this, opsEps](const std::size_t n) {
+            return getRandomVariableOps(n, regressionOrder_, QuantLib::LsmBasisSystem::Monomial, opsEps,
+                                        regressionVarianceCutoff_, pfRegressorPosGroups_, usePythonIntegration_,
+                                        workerPool_.get());
+        };
+        gradsFactory_ = [this, eps](const std::size_t n) {
+            return getRandomVariableGradients(n, regressionOrder_, QuantLib::LsmBasisSystem::Monomial, eps);
+        };
+        ops_ = opsFactory_(model_->size());
+        grads_ = gradsFactory_(model_->size());
+        if (nThreads_ > 1) {
+            opIsPathwise_ = getRandomVariableOpIsPathwise(opsEps);
+            gradIsPathwise_ = getRandomVariableGradientIsPathwise(eps);
+        }
     }
 
     bool keepValuesForDerivatives = (!bumpCvaSensis_ && sensitivityData_) || enableDynamicIM_;
@@ -750,6 +785,9 @@ void XvaEngineCG::doForwardEvaluation() {
                 valuesExternal_[n].declareAsOutput();
         }
         finalizeExternalCalculation();
+    } else if (workerPool_) {
+        forwardEvaluationTiled(*workerPool_, tiledEvaluationTileSize, *g, values_, opsFactory_, opIsPathwise_,
+                               RandomVariable::deleter, keepValuesForDerivatives, opNodeRequirements_, keepNodes_);
     } else {
         forwardEvaluation(*g, values_, ops_, RandomVariable::deleter, keepValuesForDerivatives, opNodeRequirements_,
                           keepNodes_);
@@ -1146,9 +1184,9 @@ RandomVariable XvaEngineCG::dynamicImCombineComponents(const std::vector<const R
 
     // combine the components
 
-    auto localOps =
-        getRandomVariableOps(model_->size(), regressionOrderDynamicIm_, QuantLib::LsmBasisSystem::Monomial, 0.0,
-                             regressionVarianceCutoffDynamicIm_, pfRegressorPosGroups_, usePythonIntegrationDynamicIm_);
+    auto localOps = getRandomVariableOps(model_->size(), regressionOrderDynamicIm_, QuantLib::LsmBasisSystem::Monomial,
+                                         0.0, regressionVarianceCutoffDynamicIm_, pfRegressorPosGroups_,
+                                         usePythonIntegrationDynamicIm_, workerPool_.get());
     forwardEvaluation(*g, tmp, localOps, RandomVariable::deleter, false, {}, keepNodes, startNode, endNode + 1);
 
     // populate regression report data (if requested)
@@ -1288,10 +1326,7 @@ void XvaEngineCG::calculateDynamicIM() {
 
             // run backward derivatives from n, note: we use eps = 0 in grads_ here!
 
-            backwardDerivatives(*g, values_, dynamicIMDerivatives_, grads_, RandomVariable::deleter,
-                                keepNodesDerivatives, ops_, opNodeRequirements_, keepNodes_,
-                                RandomVariableOpCode::ConditionalExpectation,
-                                ops_[RandomVariableOpCode::ConditionalExpectation]);
+            runBackwardDerivatives(dynamicIMDerivatives_, keepNodesDerivatives);
 
             dynamicImAddToPathSensis(parameterGroup, valDate, t, currencyLookup, irDeltaConverter, irVegaConverter,
                                      fxVegaConverter, pathIrDelta, pathFxDelta, pathIrVega, pathFxVega);
@@ -1318,11 +1353,15 @@ void XvaEngineCG::calculateDynamicIM() {
 
         auto regressorGroups = dynamicImInfo_[i].plainTradeRegressorGroups;
 
-        auto condExp = [this, &regressorGroups, i](const std::vector<const RandomVariable*>& args,
-                                                   const std::string& label) {
+        // all sensitivities are regressed against the same regressors, so the regression is factorised once only
+        RandomVariableRegressionCache regressionCache(1);
+
+        auto condExp = [this, &regressorGroups, &regressionCache, i](const std::vector<const RandomVariable*>& args,
+                                                                     const std::string& label) {
             auto result = randomVariableOpConditionalExpectation(
                 model_->size(), regressionOrderDynamicIm_, QuantLib::LsmBasisSystem::Monomial,
-                regressionVarianceCutoffDynamicIm_, regressorGroups, usePythonIntegrationDynamicIm_, args);
+                regressionVarianceCutoffDynamicIm_, regressorGroups, usePythonIntegrationDynamicIm_, args,
+                &regressionCache, workerPool_.get());
 
             if (std::find(regressionReportTimeStepsDynamicIM_.begin(), regressionReportTimeStepsDynamicIM_.end(), i) !=
                     regressionReportTimeStepsDynamicIM_.end() &&
@@ -1422,10 +1461,7 @@ void XvaEngineCG::calculateDynamicIM() {
 
                 dynamicIMDerivatives_[n].setAll(1.0);
 
-                backwardDerivatives(*g, values_, dynamicIMDerivatives_, grads_, RandomVariable::deleter,
-                                    keepNodesDerivatives, ops_, opNodeRequirements_, keepNodes_,
-                                    RandomVariableOpCode::ConditionalExpectation,
-                                    ops_[RandomVariableOpCode::ConditionalExpectation]);
+                runBackwardDerivatives(dynamicIMDerivatives_, keepNodesDerivatives);
 
                 dynamicImAddToPathSensis(parameterGroup, valDate, t, currencyLookup, irDeltaConverter, irVegaConverter,
                                          fxVegaConverter, pathIrDeltaC[comp], pathFxDeltaC[comp], pathIrVegaC[comp],
@@ -1548,9 +1584,7 @@ void XvaEngineCG::calculateSensitivities() {
 
             // backward derivatives run
 
-            backwardDerivatives(*g, values_, xvaDerivatives_, grads_, RandomVariable::deleter, keepNodesDerivatives,
-                                ops_, opNodeRequirements_, keepNodes_, RandomVariableOpCode::ConditionalExpectation,
-                                ops_[RandomVariableOpCode::ConditionalExpectation]);
+            runBackwardDerivatives(xvaDerivatives_, keepNodesDerivatives);
 
             // read model param derivatives
 
@@ -42,6 +42,7 @@
 
 #include <qle/ad/computationgraph.hpp>
 #include <qle/ad/external_randomvariable_ops.hpp>
+#include <qle/ad/tiledevaluation.hpp>
 #include <qle/math/computeenvironment.hpp>
 #include <qle/methods/cclgmfxoptionvegaparconverter.hpp>
 #include <qle/methods/irdeltaparconverter.hpp>
@@ -142,6 +143,7 @@ private:
     void outputGraphStats();
     void outputTimings();
     void finalizeExternalCalculation();
+    void runBackwardDerivatives(std::vector<RandomVariable>& derivatives, const std::vector<bool>& keepNodes);
 
     void populateRandomVariates(std::vector<RandomVariable>& values,
                                 std::vector<ExternalRandomVariable>& valuesExternal) const;
@@ -192,6 +194,7 @@ private:
     // input parameters from constructor
 
     Mode mode_;
+    Size nThreads_;
     Date asof_;
     QuantLib::ext::shared_ptr<ore::data::Loader> loader_;
     QuantLib::ext::shared_ptr<ore::data::CurveConfigurations> curveConfigs_;
@@ -249,6 +252,11 @@ private:
     std::vector<RandomVariableOpNodeRequirements> opNodeRequirements_;
     std::vector<RandomVariableOp> ops_;
     std::vector<RandomVariableGrad> grads_;
+    // for nThreads > 1 the fwd evaluation and bwd derivatives run on tiles of paths using the worker pool
+    QuantLib::ext::shared_ptr<QuantExt::WorkerPool> workerPool_;
+    RandomVariableOpsFactory opsFactory_;
+    RandomVariableGradsFactory gradsFactory_;
+    std::vector<bool> opIsPathwise_, gradIsPathwise_;
     std::vector<ExternalRandomVariableOp> opsExternal_;
     std::vector<ExternalRandomVariableGrad> gradsExternal_;
     std::size_t externalCalculationId_ = 0;
@@ -67,13 +67,14 @@ map<RiskFactorKey, Real> ZeroToParCube::parDeltas(QuantLib::Size cubeIdx, QuantL
     const QuantLib::ext::shared_ptr<SensitivityCube>& zeroCube = zeroCubes_[cubeIdx];
     const QuantLib::ext::shared_ptr<NPVSensiCube>& sensiCube = zeroCube->npvCube();
 
-    std::set<RiskFactorKey> rkeys;
+    std::set<Size> factorIds;
     for (auto const& kv : sensiCube->getTradeNPVs(tradeIdx)) {
-        if (auto k = zeroCube->upDownFactor(kv.first); k.keytype != RiskFactorKey::KeyType::None)
-            rkeys.insert(k);
+        if (auto id = zeroCube->scenarioFactorId(kv.first); id != Null<Size>())
+            factorIds.insert(id);
     }
 
-    for (auto const& rk : rkeys) {
+    for (auto const id : factorIds) {
+        const RiskFactorKey& rk = zeroCube->factorKey(id);
         auto it = factorToIndex_.find(rk);
         if (it == factorToIndex_.end()) {
             if (ParSensitivityAnalysis::isParType(rk.keytype) && typesDisabled_.count(rk.keytype) != 1) {
@@ -88,7 +89,7 @@ map<RiskFactorKey, Real> ZeroToParCube::parDeltas(QuantLib::Size cubeIdx, QuantL
                 }
             }
         } else {
-            zeroDeltas[it->second] = zeroCube->delta(tradeIdx, rk);
+            zeroDeltas[it->second] = zeroCube->delta(tradeIdx, id);
         }
     }
 
@@ -103,9 +104,10 @@ map<RiskFactorKey, Real> ZeroToParCube::parDeltas(QuantLib::Size cubeIdx, QuantL
     }
 
     // Add non-zero deltas that do not need to be converted from underlying zero cube
-    for (const auto& f : rkeys) {
+    for (auto const id : factorIds) {
+        const RiskFactorKey& f = zeroCube->factorKey(id);
         if (!ParSensitivityAnalysis::isParType(f.keytype) || typesDisabled_.count(f.keytype) == 1) {
-            Real delta = zeroCube->delta(tradeIdx, f);
+            Real delta = zeroCube->delta(tradeIdx, id);
             if (!close(delta, 0.0)) {
                 result[f] = delta;
             }
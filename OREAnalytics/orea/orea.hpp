@@ -58,6 +58,7 @@
 #include <orea/app/cleanupsingletons.hpp>
 #include <orea/app/dummymarketdataloader.hpp>
 #include <orea/app/hwhistoricalcalibrationdataloader.hpp>
+#include <orea/app/incrementalrevaluation.hpp>
 #include <orea/app/initbuilders.hpp>
 #include <orea/app/inputparameters.hpp>
 #include <orea/app/marketcalibrationreport.hpp>
@@ -73,6 +74,7 @@
 #include <orea/app/structuredanalyticswarning.hpp>
 #include <orea/app/zerosensitivityloader.hpp>
 #include <orea/cube/cube_io.hpp>
+#include <orea/cube/contiguousinmemorycube.hpp>
 #include <orea/cube/cubecsvreader.hpp>
 #include <orea/cube/cubeinterpretation.hpp>
 #include <orea/cube/cubewriter.hpp>
@@ -81,6 +83,7 @@
 #include <orea/cube/jaggedcube.hpp>
 #include <orea/cube/jointnpvcube.hpp>
 #include <orea/cube/jointnpvsensicube.hpp>
+#include <orea/cube/mappednpvcube.hpp>
 #include <orea/cube/npvcube.hpp>
 #include <orea/cube/npvsensicube.hpp>
 #include <orea/cube/overlaynpvcube.hpp>
@@ -117,6 +120,7 @@
 #include <orea/engine/parstressscenarioconverter.hpp>
 #include <orea/engine/pathdata.hpp>
 #include <orea/engine/pnlexplainreport.hpp>
+#include <orea/engine/riskfactordependencies.hpp>
 #include <orea/engine/riskfilter.hpp>
 #include <orea/engine/saccrcalculator.hpp>
 #include <orea/engine/saccrcrifgenerator.hpp>
@@ -158,6 +162,7 @@
 #include <orea/scenario/historicalscenarioreturn.hpp>
 #include <orea/scenario/lgmscenariogenerator.hpp>
 #include <orea/scenario/scenario.hpp>
+#include <orea/scenario/scenarioarchive.hpp>
 #include <orea/scenario/scenariofactory.hpp>
 #include <orea/scenario/scenariofilereader.hpp>
 #include <orea/scenario/scenariofilter.hpp>
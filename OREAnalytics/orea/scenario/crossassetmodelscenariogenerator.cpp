@@ -17,6 +17,7 @@
 */
 
 #include <orea/scenario/crossassetmodelscenariogenerator.hpp>
+#include <orea/scenario/simplescenario.hpp>
 #include <ored/utilities/log.hpp>
 #include <ored/utilities/parsers.hpp>
 
@@ -258,6 +259,7 @@ CrossAssetModelScenarioGenerator::CrossAssetModelScenarioGenerator(
         auto impliedFwdCurve = QuantLib::ext::make_shared<ModelImpliedYtsFwdFwdCorrected>(
             model_->irModel(model_->ccyIndex(index->currency())), fts, dc, false);
         fwdCurves_.push_back(impliedFwdCurve);
+        fwdTargetCurves_.push_back(fts);
         indices_.push_back(index->clone(Handle<YieldTermStructure>(impliedFwdCurve)));
     }
 
@@ -268,6 +270,7 @@ CrossAssetModelScenarioGenerator::CrossAssetModelScenarioGenerator(
         auto impliedYieldCurve = QuantLib::ext::make_shared<ModelImpliedYtsFwdFwdCorrected>(
             model_->irModel(model_->ccyIndex(ccy)), yts, dc, false);
         yieldCurves_.push_back(impliedYieldCurve);
+        yieldTargetCurves_.push_back(yts);
         yieldCurveCurrency_.push_back(ccy);
     }
 
@@ -378,15 +381,36 @@ void copyPathToArray(const MultiPath& p, Size t, Size a, Array& target) {
     for (Size k = 0; k < target.size(); ++k)
         target[k] = p[a + k][t];
 }
+
+void addValue(std::vector<Real>& values, std::vector<RiskFactorKey>* keys, const RiskFactorKey& key, const Real value) {
+    values.push_back(value);
+    if (keys)
+        keys->push_back(key);
+}
 } // namespace
 
+void CrossAssetModelScenarioGenerator::setBatchSize(const Size batchSize) {
+    QL_REQUIRE(batchSize > 0, "CrossAssetModelScenarioGenerator::setBatchSize(): batch size must be positive");
+    batchSize_ = batchSize;
+}
+
 std::vector<QuantLib::ext::shared_ptr<Scenario>> CrossAssetModelScenarioGenerator::nextPath() {
+    if (nextBufferedPath_ == bufferedPaths_.size()) {
+        Size n = batchSize_;
+        // do not draw more samples than announced, the amc path data buffers are sized accordingly
+        if (totalSamples_ != Null<Size>() && currentSample_ < totalSamples_)
+            n = std::min(n, totalSamples_ - currentSample_);
+        bufferedPaths_ = nextPaths(n);
+        nextBufferedPath_ = 0;
+    }
+    return std::move(bufferedPaths_[nextBufferedPath_++]);
+}
+
+Sample<MultiPath> CrossAssetModelScenarioGenerator::nextSample() {
 
-    std::vector<QuantLib::ext::shared_ptr<Scenario>> scenarios(dates_.size());
     QL_REQUIRE(pathGenerator_ != nullptr, "CrossAssetModelScenarioGenerator::nextPath(): pathGenerator is null");
     Sample<MultiPath> sample = pathGenerator_->next();
     ++currentSample_;
-    DayCounter dc = model_->irModel(0)->termStructure()->dayCounter();
 
     if (!amcPathDataOutput_.empty()) {
         for (Size k = 0; k < n_fx_; ++k) {
@@ -410,6 +434,98 @@ std::vector<QuantLib::ext::shared_ptr<Scenario>> CrossAssetModelScenarioGenerato
         }
     }
 
+    if (totalSamples_ == currentSample_ && !amcPathDataOutput_.empty()) {
+        LOG("Serialize paths, fx and irState buffers to'" << amcPathDataOutput_ << "'");
+        std::ofstream os(amcPathDataOutput_, std::ios::binary);
+        boost::archive::binary_oarchive oa(os, boost::archive::no_header);
+        oa << pathData_;
+        os.close();
+    }
+
+    return sample;
+}
+
+void CrossAssetModelScenarioGenerator::buildZeroBondCoefficients() {
+
+    DayCounter dc = model_->irModel(0)->termStructure()->dayCounter();
+
+    // same as LinearGaussMarkovModel::discountBond(t, T, x, curve) = ratio * exp(-h * x - c)
+    auto lgmCoefficients = [](const IrLgm1fParametrization& p, const YieldTermStructure& curve, const Time t,
+                              const Time T) {
+        if (QuantLib::close_enough(t, T))
+            return ZeroBondCoefficients{1.0, 0.0, 0.0};
+        QL_REQUIRE(T >= t && t >= 0.0, "T(" << T << ") >= t(" << t << ") >= 0 required in LGM::discountBond");
+        Real Ht = p.H(t);
+        Real HT = p.H(T);
+        return ZeroBondCoefficients{curve.discount(T) / curve.discount(t), HT - Ht,
+                                    0.5 * (HT * HT - Ht * Ht) * p.zeta(t)};
+    };
+
+    // discount curves, see ModelImpliedYieldTermStructure, moved by time
+    dscCoefficients_.assign(n_ccy_, {});
+    for (Size j = 0; j < n_ccy_; ++j) {
+        if (model_->modelType(CrossAssetModel::AssetType::IR, j) != CrossAssetModel::ModelType::LGM1F)
+            continue;
+        auto p = model_->irlgm1f(j);
+        dscCoefficients_[j].resize(dates_.size());
+        for (Size i = 0; i < dates_.size(); ++i) {
+            Real t = timeGrid_[i + 1];
+            for (Size k = 0; k < ten_dsc_[j].size(); ++k) {
+                Time T = dc.yearFraction(dates_[i], dates_[i] + ten_dsc_[j][k]);
+                dscCoefficients_[j][i].push_back(lgmCoefficients(*p, **p->termStructure(), t, t + T));
+            }
+        }
+    }
+
+    // index and yield curves, see ModelImpliedYtsFwdFwdCorrected, moved by date
+    auto fwdFwdCorrectedCoefficients =
+        [this, &dc, &lgmCoefficients](const QuantLib::ext::shared_ptr<ModelImpliedYieldTermStructure>& curve,
+                                      const Handle<YieldTermStructure>& target, const Size ccy,
+                                      const std::vector<Period>& tenors) {
+            std::vector<std::vector<ZeroBondCoefficients>> result;
+            if (model_->modelType(CrossAssetModel::AssetType::IR, ccy) != CrossAssetModel::ModelType::LGM1F)
+                return result;
+            auto p = model_->irlgm1f(ccy);
+            result.resize(dates_.size());
+            for (Size i = 0; i < dates_.size(); ++i) {
+                Time relativeTime = curve->dayCounter().yearFraction(p->termStructure()->referenceDate(), dates_[i]);
+                for (Size k = 0; k < tenors.size(); ++k) {
+                    Time T = dc.yearFraction(dates_[i], dates_[i] + tenors[k]);
+                    if (QuantLib::close_enough(relativeTime, 0.0))
+                        result[i].push_back(ZeroBondCoefficients{target->discount(T), 0.0, 0.0});
+                    else
+                        result[i].push_back(lgmCoefficients(*p, **target, relativeTime, relativeTime + T));
+                }
+            }
+            return result;
+        };
+
+    idxCoefficients_.resize(n_indices_);
+    for (Size j = 0; j < n_indices_; ++j)
+        idxCoefficients_[j] = fwdFwdCorrectedCoefficients(fwdCurves_[j], fwdTargetCurves_[j],
+                                                          model_->ccyIndex(indices_[j]->currency()), ten_idx_[j]);
+
+    ycCoefficients_.resize(n_curves_);
+    for (Size j = 0; j < n_curves_; ++j)
+        ycCoefficients_[j] = fwdFwdCorrectedCoefficients(yieldCurves_[j], yieldTargetCurves_[j],
+                                                         model_->ccyIndex(yieldCurveCurrency_[j]), ten_yc_[j]);
+
+    zeroBondCoefficientsBuilt_ = true;
+}
+
+std::vector<std::vector<QuantLib::ext::shared_ptr<Scenario>>>
+CrossAssetModelScenarioGenerator::nextPaths(const Size n) {
+
+    std::vector<Sample<MultiPath>> samples;
+    samples.reserve(n);
+    for (Size p = 0; p < n; ++p)
+        samples.push_back(nextSample());
+
+    if (!zeroBondCoefficientsBuilt_)
+        buildZeroBondCoefficients();
+
+    DayCounter dc = model_->irModel(0)->termStructure()->dayCounter();
+
     std::vector<Array> ir_state(n_ccy_);
     for (Size j = 0; j < n_ccy_; ++j) {
         ir_state[j] = Array(model_->irModel(j)->n());
@@ -425,282 +541,380 @@ std::vector<QuantLib::ext::shared_ptr<Scenario>> CrossAssetModelScenarioGenerato
     for (Size j = 0; j < n_curves_; ++j)
         yieldCurveCcyIdx[j] = model_->ccyIndex(yieldCurveCurrency_[j]);
 
+    std::vector<std::vector<QuantLib::ext::shared_ptr<Scenario>>> scenarios(
+        n, std::vector<QuantLib::ext::shared_ptr<Scenario>>(dates_.size()));
+    std::vector<std::vector<Real>> values(n);
+    std::vector<Real> numeraire(n), x(n), discount(n);
+
+    // the keys are collected while populating the first scenario, their order does not depend on the path
+    bool collectKeys = scenarioKeys_.empty();
+
+    // adds the zero bonds of an LGM1F curve for all paths at once
+    auto addLgmZeroBonds = [&values, &samples, &x, &discount, n](const std::vector<ZeroBondCoefficients>& coefficients,
+                                                                 const Size irIdx, const Size pathIdx,
+                                                                 const RiskFactorKey* curveKeys,
+                                                                 std::vector<RiskFactorKey>* keys) {
+        for (Size p = 0; p < n; ++p)
+            x[p] = samples[p].value[irIdx][pathIdx];
+        for (Size k = 0; k < coefficients.size(); ++k) {
+            const ZeroBondCoefficients& c = coefficients[k];
+            for (Size p = 0; p < n; ++p)
+                discount[p] = std::max(c.ratio * std::exp(-c.h * x[p] - c.c), 0.00001);
+            for (Size p = 0; p < n; ++p)
+                values[p].push_back(discount[p]);
+            if (keys)
+                keys->push_back(curveKeys[k]);
+        }
+    };
+
     for (Size i = 0; i < dates_.size(); i++) {
         Real t = timeGrid_[i + 1]; // recall: time grid has inserted t=0
+        Size pathIdx = gridIndexInPath_[i + 1];
+        std::vector<RiskFactorKey>* keys = collectKeys && i == 0 ? &scenarioKeys_ : nullptr;
 
-        scenarios[i] = scenarioFactory_->buildScenario(dates_[i], true);
-
-        // populate IR states
-        copyPathToArray(sample.value, gridIndexInPath_[i + 1], model_->pIdx(CrossAssetModel::AssetType::IR, 0),
-                        ir_state[0]);
-        copyPathToArray(sample.value, gridIndexInPath_[i + 1],
-                        model_->pIdx(CrossAssetModel::AssetType::IR, 0) + ir_state[0].size(), ir_state_aux);
-        for (Size j = 1; j < n_ccy_; ++j)
-            copyPathToArray(sample.value, gridIndexInPath_[i + 1], model_->pIdx(CrossAssetModel::AssetType::IR, j),
-                            ir_state[j]);
-
-        // Set numeraire from domestic ir process
-        scenarios[i]->setNumeraire(model_->numeraire(0, t, ir_state[0], Handle<YieldTermStructure>(), ir_state_aux));
+        for (Size p = 0; p < n; ++p) {
+            values[p].clear();
+            values[p].reserve(scenarioKeys_.size());
+        }
 
         // Discount curves
         for (Size j = 0; j < n_ccy_; j++) {
-            curves_[j]->move(t, ir_state[j]);
-            for (Size k = 0; k < ten_dsc_[j].size(); k++) {
-                Date d = dates_[i] + ten_dsc_[j][k];
-                Time T = dc.yearFraction(dates_[i], d);
-                Real discount = std::max(curves_[j]->discount(T), 0.00001);
-                scenarios[i]->add(discountCurveKeys_[j * ten_dsc_[j].size() + k], discount);
+            Size n_ten = ten_dsc_[j].size();
+            Size irIdx = model_->pIdx(CrossAssetModel::AssetType::IR, j);
+            if (!dscCoefficients_[j].empty()) {
+                addLgmZeroBonds(dscCoefficients_[j][i], irIdx, pathIdx, discountCurveKeys_.data() + j * n_ten, keys);
+                continue;
+            }
+            for (Size p = 0; p < n; ++p) {
+                copyPathToArray(samples[p].value, pathIdx, irIdx, ir_state[j]);
+                curves_[j]->move(t, ir_state[j]);
+                for (Size k = 0; k < n_ten; k++) {
+                    Date d = dates_[i] + ten_dsc_[j][k];
+                    Time T = dc.yearFraction(dates_[i], d);
+                    addValue(values[p], p == 0 ? keys : nullptr, discountCurveKeys_[j * n_ten + k],
+                             std::max(curves_[j]->discount(T), 0.00001));
+                }
             }
         }
 
         // Index curves and Index fixings
         for (Size j = 0; j < n_indices_; ++j) {
-            fwdCurves_[j]->move(dates_[i], ir_state[indexCcyIdx[j]]);
-            for (Size k = 0; k < ten_idx_[j].size(); ++k) {
-                Date d = dates_[i] + ten_idx_[j][k];
-                Time T = dc.yearFraction(dates_[i], d);
-                Real discount = std::max(fwdCurves_[j]->discount(T), 0.00001);
-                scenarios[i]->add(indexCurveKeys_[j * ten_idx_[j].size() + k], discount);
+            Size n_ten = ten_idx_[j].size();
+            Size irIdx = model_->pIdx(CrossAssetModel::AssetType::IR, indexCcyIdx[j]);
+            if (!idxCoefficients_[j].empty()) {
+                addLgmZeroBonds(idxCoefficients_[j][i], irIdx, pathIdx, indexCurveKeys_.data() + j * n_ten, keys);
+                continue;
+            }
+            for (Size p = 0; p < n; ++p) {
+                copyPathToArray(samples[p].value, pathIdx, irIdx, ir_state[indexCcyIdx[j]]);
+                fwdCurves_[j]->move(dates_[i], ir_state[indexCcyIdx[j]]);
+                for (Size k = 0; k < n_ten; ++k) {
+                    Date d = dates_[i] + ten_idx_[j][k];
+                    Time T = dc.yearFraction(dates_[i], d);
+                    addValue(values[p], p == 0 ? keys : nullptr, indexCurveKeys_[j * n_ten + k],
+                             std::max(fwdCurves_[j]->discount(T), 0.00001));
+                }
             }
         }
 
         // Yield curves
         for (Size j = 0; j < n_curves_; ++j) {
-            yieldCurves_[j]->move(dates_[i], ir_state[yieldCurveCcyIdx[j]]);
-            for (Size k = 0; k < ten_yc_[j].size(); ++k) {
-                Date d = dates_[i] + ten_yc_[j][k];
-                Time T = dc.yearFraction(dates_[i], d);
-                Real discount = std::max(yieldCurves_[j]->discount(T), 0.00001);
-                scenarios[i]->add(yieldCurveKeys_[j * ten_yc_[j].size() + k], discount);
+            Size n_ten = ten_yc_[j].size();
+            Size irIdx = model_->pIdx(CrossAssetModel::AssetType::IR, yieldCurveCcyIdx[j]);
+            if (!ycCoefficients_[j].empty()) {
+                addLgmZeroBonds(ycCoefficients_[j][i], irIdx, pathIdx, yieldCurveKeys_.data() + j * n_ten, keys);
+                continue;
+            }
+            for (Size p = 0; p < n; ++p) {
+                copyPathToArray(samples[p].value, pathIdx, irIdx, ir_state[yieldCurveCcyIdx[j]]);
+                yieldCurves_[j]->move(dates_[i], ir_state[yieldCurveCcyIdx[j]]);
+                for (Size k = 0; k < n_ten; ++k) {
+                    Date d = dates_[i] + ten_yc_[j][k];
+                    Time T = dc.yearFraction(dates_[i], d);
+                    addValue(values[p], p == 0 ? keys : nullptr, yieldCurveKeys_[j * n_ten + k],
+                             std::max(yieldCurves_[j]->discount(T), 0.00001));
+                }
             }
         }
 
-        // FX rates
-        for (Size k = 0; k < n_ccy_ - 1; k++) {
-            Real fx = std::exp(sample.value[model_->pIdx(CrossAssetModel::AssetType::FX, k)][gridIndexInPath_[i + 1]]);
-            scenarios[i]->add(fxKeys_[k], fx);
+        // Numeraire and remaining risk factors, path by path
+        for (Size p = 0; p < n; ++p) {
+            const MultiPath& path = samples[p].value;
+            copyPathToArray(path, pathIdx, model_->pIdx(CrossAssetModel::AssetType::IR, 0), ir_state[0]);
+            copyPathToArray(path, pathIdx, model_->pIdx(CrossAssetModel::AssetType::IR, 0) + ir_state[0].size(),
+                            ir_state_aux);
+            for (Size j = 1; j < n_ccy_; ++j)
+                copyPathToArray(path, pathIdx, model_->pIdx(CrossAssetModel::AssetType::IR, j), ir_state[j]);
+            // the model implied curves are read by the swaption vol term structures below, so they have to reflect
+            // the state of this path, also if their zero bonds were computed via the cached coefficients above
+            for (Size j = 0; j < n_ccy_; ++j)
+                curves_[j]->move(t, ir_state[j]);
+            for (Size j = 0; j < n_indices_; ++j)
+                fwdCurves_[j]->move(dates_[i], ir_state[indexCcyIdx[j]]);
+            for (Size j = 0; j < n_curves_; ++j)
+                yieldCurves_[j]->move(dates_[i], ir_state[yieldCurveCcyIdx[j]]);
+            numeraire[p] = model_->numeraire(0, t, ir_state[0], Handle<YieldTermStructure>(), ir_state_aux);
+            addPathValues(path, i, dc, ir_state, values[p], p == 0 ? keys : nullptr);
         }
 
-        // FX vols
-        if (simMarketConfig_->simulateFXVols()) {
-            for (Size k = 0; k < simMarketConfig_->fxVolCcyPairs().size(); k++) {
-                const string ccyPair = simMarketConfig_->fxVolCcyPairs()[k];
-                const vector<Period>& expires = simMarketConfig_->fxVolExpiries(ccyPair);
+        for (Size p = 0; p < n; ++p)
+            scenarios[p][i] = buildScenario(dates_[i], numeraire[p], values[p]);
+    }
+
+    return scenarios;
+}
+
+void CrossAssetModelScenarioGenerator::addPathValues(const MultiPath& path, const Size i, const DayCounter& dc,
+                                                     const std::vector<Array>& ir_state, std::vector<Real>& values,
+                                                     std::vector<RiskFactorKey>* keys) {
+
+    // FX rates
+    for (Size k = 0; k < n_ccy_ - 1; k++) {
+        Real fx = std::exp(path[model_->pIdx(CrossAssetModel::AssetType::FX, k)][gridIndexInPath_[i + 1]]);
+        addValue(values, keys, fxKeys_[k], fx);
+    }
 
-                Size fxIndex = fxVols_[k]->fxIndex();
-                Real zFor = sample.value[fxIndex + 1][gridIndexInPath_[i + 1]];
-                Real logFx =
-                    sample.value[n_ccy_ + fxIndex][gridIndexInPath_[i + 1]]; // multiplies USD amount to get EUR
-                fxVols_[k]->move(dates_[i], ir_state[0][0], zFor, logFx);
+    // FX vols
+    if (simMarketConfig_->simulateFXVols()) {
+        for (Size k = 0; k < simMarketConfig_->fxVolCcyPairs().size(); k++) {
+            const string ccyPair = simMarketConfig_->fxVolCcyPairs()[k];
+            const vector<Period>& expires = simMarketConfig_->fxVolExpiries(ccyPair);
 
-                for (Size j = 0; j < expires.size(); j++) {
-                    Real vol = fxVols_[k]->blackVol(dates_[i] + expires[j], Null<Real>(), true);
-                    scenarios[i]->add(RiskFactorKey(RiskFactorKey::KeyType::FXVolatility, ccyPair, j), vol);
-                }
+            Size fxIndex = fxVols_[k]->fxIndex();
+            Real zFor = path[fxIndex + 1][gridIndexInPath_[i + 1]];
+            Real logFx = path[n_ccy_ + fxIndex][gridIndexInPath_[i + 1]]; // multiplies USD amount to get EUR
+            fxVols_[k]->move(dates_[i], ir_state[0][0], zFor, logFx);
+
+            for (Size j = 0; j < expires.size(); j++) {
+                Real vol = fxVols_[k]->blackVol(dates_[i] + expires[j], Null<Real>(), true);
+                addValue(values, keys, RiskFactorKey(RiskFactorKey::KeyType::FXVolatility, ccyPair, j), vol);
             }
         }
+    }
 
-        // Equity spots
-        for (Size k = 0; k < n_eq_; k++) {
-            Real eqSpot =
-                std::exp(sample.value[model_->pIdx(CrossAssetModel::AssetType::EQ, k)][gridIndexInPath_[i + 1]]);
-            scenarios[i]->add(eqKeys_[k], eqSpot);
-        }
+    // Equity spots
+    for (Size k = 0; k < n_eq_; k++) {
+        Real eqSpot = std::exp(path[model_->pIdx(CrossAssetModel::AssetType::EQ, k)][gridIndexInPath_[i + 1]]);
+        addValue(values, keys, eqKeys_[k], eqSpot);
+    }
 
-        // Equity vols
-        if (simMarketConfig_->simulateEquityVols()) {
-            for (Size k = 0; k < simMarketConfig_->equityVolNames().size(); k++) {
-                const string equityName = simMarketConfig_->equityVolNames()[k];
+    // Equity vols
+    if (simMarketConfig_->simulateEquityVols()) {
+        for (Size k = 0; k < simMarketConfig_->equityVolNames().size(); k++) {
+            const string equityName = simMarketConfig_->equityVolNames()[k];
 
-                const vector<Period>& expiries = simMarketConfig_->equityVolExpiries(equityName);
+            const vector<Period>& expiries = simMarketConfig_->equityVolExpiries(equityName);
 
-                Size eqIndex = eqVols_[k]->equityIndex();
-                Size eqCcyIdx = eqVols_[k]->eqCcyIndex();
-                Real z_eqIr = sample.value[eqCcyIdx][gridIndexInPath_[i + 1]];
-                Real logEq = sample.value[eqIndex][gridIndexInPath_[i + 1]];
-                eqVols_[k]->move(dates_[i], z_eqIr, logEq);
+            Size eqIndex = eqVols_[k]->equityIndex();
+            Size eqCcyIdx = eqVols_[k]->eqCcyIndex();
+            Real z_eqIr = path[eqCcyIdx][gridIndexInPath_[i + 1]];
+            Real logEq = path[eqIndex][gridIndexInPath_[i + 1]];
+            eqVols_[k]->move(dates_[i], z_eqIr, logEq);
 
-                for (Size j = 0; j < expiries.size(); j++) {
-                    Real vol = eqVols_[k]->blackVol(dates_[i] + expiries[j], Null<Real>(), true);
-                    scenarios[i]->add(RiskFactorKey(RiskFactorKey::KeyType::EquityVolatility, equityName, j), vol);
-                }
+            for (Size j = 0; j < expiries.size(); j++) {
+                Real vol = eqVols_[k]->blackVol(dates_[i] + expiries[j], Null<Real>(), true);
+                addValue(values, keys, RiskFactorKey(RiskFactorKey::KeyType::EquityVolatility, equityName, j), vol);
             }
         }
+    }
 
-        // Swaption vols
-        if (simMarketConfig_->simulateSwapVols()) {
-            for (Size k = 0; k < simMarketConfig_->swapVolKeys().size(); k++) {
-                const string key = simMarketConfig_->swapVolKeys()[k];
-                const vector<Period>& expires = simMarketConfig_->swapVolExpiries(key);
-                const vector<Period>& terms = simMarketConfig_->swapVolTerms(key);
-
-                // ext::shared_ptr<YieldTermStructure> dts = curves_[swaptionVols_[k]->ccyIndex()];
-                // ext::shared_ptr<YieldTermStructure> fts = fwdCurves_[swaptionVols_[k]->indexIndex()];
-                // Update the implied swaption vols
-                swaptionVols_[k]->move(dates_[i], ir_state[0][0]);
-
-                for (Size j = 0; j < expires.size(); j++) {
-                    for (Size jj = 0; jj < terms.size(); jj++) {
-                        Real vol = swaptionVols_[k]->volatility(dates_[i] + expires[j], terms[jj], Null<Real>(), true);
-                        Size idx = j * terms.size() + jj;
-                        scenarios[i]->add(RiskFactorKey(RiskFactorKey::KeyType::SwaptionVolatility, key, idx), vol);
-                    }
+    // Swaption vols
+    if (simMarketConfig_->simulateSwapVols()) {
+        for (Size k = 0; k < simMarketConfig_->swapVolKeys().size(); k++) {
+            const string key = simMarketConfig_->swapVolKeys()[k];
+            const vector<Period>& expires = simMarketConfig_->swapVolExpiries(key);
+            const vector<Period>& terms = simMarketConfig_->swapVolTerms(key);
+
+            // ext::shared_ptr<YieldTermStructure> dts = curves_[swaptionVols_[k]->ccyIndex()];
+            // ext::shared_ptr<YieldTermStructure> fts = fwdCurves_[swaptionVols_[k]->indexIndex()];
+            // Update the implied swaption vols
+            swaptionVols_[k]->move(dates_[i], ir_state[0][0]);
+
+            for (Size j = 0; j < expires.size(); j++) {
+                for (Size jj = 0; jj < terms.size(); jj++) {
+                    Real vol = swaptionVols_[k]->volatility(dates_[i] + expires[j], terms[jj], Null<Real>(), true);
+                    Size idx = j * terms.size() + jj;
+                    addValue(values, keys, RiskFactorKey(RiskFactorKey::KeyType::SwaptionVolatility, key, idx), vol);
                 }
             }
         }
+    }
 
-        // Inflation index values
-        for (Size j = 0; j < n_inf_; j++) {
-
-            // Depending on type of model, i.e. DK or JY, z and y mean different things.
-            Real z = sample.value[model_->pIdx(CrossAssetModel::AssetType::INF, j, 0)][gridIndexInPath_[i + 1]];
-            Real y = sample.value[model_->pIdx(CrossAssetModel::AssetType::INF, j, 1)][gridIndexInPath_[i + 1]];
-
-            // Could possibly cache the model type outside the loop to improve performance.
-            Real cpi = 0.0;
-            if (model_->modelType(CrossAssetModel::AssetType::INF, j) == CrossAssetModel::ModelType::JY) {
-                cpi = std::exp(
-                    sample.value[model_->pIdx(CrossAssetModel::AssetType::INF, j, 1)][gridIndexInPath_[i + 1]]);
-            } else if (model_->modelType(CrossAssetModel::AssetType::INF, j) == CrossAssetModel::ModelType::DK) {
-                auto index = *initMarket_->zeroInflationIndex(model_->inf(j)->name());
-                Date baseDate = index->zeroInflationTermStructure()->baseDate();
-                auto zts = index->zeroInflationTermStructure();
-                Time relativeTime = inflationYearFraction(zts->frequency(), false, zts->dayCounter(), baseDate,
-                                                          dates_[i] - zts->observationLag());
-                std::tie(cpi, std::ignore) = model_->infdkI(j, relativeTime, relativeTime, z, y);
-                cpi *= index->fixing(baseDate);
-            } else {
-                QL_FAIL("CrossAssetModelScenarioGenerator: expected inflation model to be JY or DK.");
-            }
-
-            scenarios[i]->add(cpiKeys_[j], cpi);
+    // Inflation index values
+    for (Size j = 0; j < n_inf_; j++) {
+
+        // Depending on type of model, i.e. DK or JY, z and y mean different things.
+        Real z = path[model_->pIdx(CrossAssetModel::AssetType::INF, j, 0)][gridIndexInPath_[i + 1]];
+        Real y = path[model_->pIdx(CrossAssetModel::AssetType::INF, j, 1)][gridIndexInPath_[i + 1]];
+
+        // Could possibly cache the model type outside the loop to improve performance.
+        Real cpi = 0.0;
+        if (model_->modelType(CrossAssetModel::AssetType::INF, j) == CrossAssetModel::ModelType::JY) {
+            cpi = std::exp(
+                path[model_->pIdx(CrossAssetModel::AssetType::INF, j, 1)][gridIndexInPath_[i + 1]]);
+        } else if (model_->modelType(CrossAssetModel::AssetType::INF, j) == CrossAssetModel::ModelType::DK) {
+            auto index = *initMarket_->zeroInflationIndex(model_->inf(j)->name());
+            Date baseDate = index->zeroInflationTermStructure()->baseDate();
+            auto zts = index->zeroInflationTermStructure();
+            Time relativeTime = inflationYearFraction(zts->frequency(), false, zts->dayCounter(), baseDate,
+                                                      dates_[i] - zts->observationLag());
+            std::tie(cpi, std::ignore) = model_->infdkI(j, relativeTime, relativeTime, z, y);
+            cpi *= index->fixing(baseDate);
+        } else {
+            QL_FAIL("CrossAssetModelScenarioGenerator: expected inflation model to be JY or DK.");
         }
 
-        // Zero inflation curves
-        for (Size j = 0; j < zeroInfCurves_.size(); ++j) {
+        addValue(values, keys, cpiKeys_[j], cpi);
+    }
 
-            auto tup = zeroInfCurves_[j];
+    // Zero inflation curves
+    for (Size j = 0; j < zeroInfCurves_.size(); ++j) {
 
-            // State variables needed depends on model, 3 for JY and 2 for DK.
-            auto idx = std::get<0>(tup);
-            Array state(3);
-            state[0] = sample.value[model_->pIdx(CrossAssetModel::AssetType::INF, idx, 0)][gridIndexInPath_[i + 1]];
-            state[1] = sample.value[model_->pIdx(CrossAssetModel::AssetType::INF, idx, 1)][gridIndexInPath_[i + 1]];
-            if (std::get<2>(tup) == CrossAssetModel::ModelType::DK) {
-                state.resize(2);
-            } else {
-                state[2] = ir_state[std::get<1>(tup)][0];
-            }
+        auto tup = zeroInfCurves_[j];
 
-            // Update the term structure's date and state.
-            auto ts = std::get<3>(tup);
-            ts->move(dates_[i], state);
+        // State variables needed depends on model, 3 for JY and 2 for DK.
+        auto idx = std::get<0>(tup);
+        Array state(3);
+        state[0] = path[model_->pIdx(CrossAssetModel::AssetType::INF, idx, 0)][gridIndexInPath_[i + 1]];
+        state[1] = path[model_->pIdx(CrossAssetModel::AssetType::INF, idx, 1)][gridIndexInPath_[i + 1]];
+        if (std::get<2>(tup) == CrossAssetModel::ModelType::DK) {
+            state.resize(2);
+        } else {
+            state[2] = ir_state[std::get<1>(tup)][0];
+        }
 
-            // Populate the zero inflation scenario values based on the current date and state.
-            for (Size k = 0; k < ten_zinf_[j].size(); k++) {
-                Time T = dc.yearFraction(dates_[i], dates_[i] + ten_zinf_[j][k]);
-                scenarios[i]->add(zeroInflationKeys_[j * ten_zinf_[j].size() + k], ts->zeroRate(T));
-            }
+        // Update the term structure's date and state.
+        auto ts = std::get<3>(tup);
+        ts->move(dates_[i], state);
+
+        // Populate the zero inflation scenario values based on the current date and state.
+        for (Size k = 0; k < ten_zinf_[j].size(); k++) {
+            Time T = dc.yearFraction(dates_[i], dates_[i] + ten_zinf_[j][k]);
+            addValue(values, keys, zeroInflationKeys_[j * ten_zinf_[j].size() + k], ts->zeroRate(T));
         }
+    }
 
-        // YoY inflation curves
-        for (Size j = 0; j < yoyInfCurves_.size(); ++j) {
+    // YoY inflation curves
+    for (Size j = 0; j < yoyInfCurves_.size(); ++j) {
 
-            auto tup = yoyInfCurves_[j];
+        auto tup = yoyInfCurves_[j];
 
-            // For YoY model implied term structure, JY and DK both need 3 state variables.
-            auto idx = std::get<0>(tup);
-            Array state(3);
-            state[0] = sample.value[model_->pIdx(CrossAssetModel::AssetType::INF, idx, 0)][gridIndexInPath_[i + 1]];
-            state[1] = sample.value[model_->pIdx(CrossAssetModel::AssetType::INF, idx, 1)][gridIndexInPath_[i + 1]];
-            state[2] = ir_state[std::get<1>(tup)][0];
+        // For YoY model implied term structure, JY and DK both need 3 state variables.
+        auto idx = std::get<0>(tup);
+        Array state(3);
+        state[0] = path[model_->pIdx(CrossAssetModel::AssetType::INF, idx, 0)][gridIndexInPath_[i + 1]];
+        state[1] = path[model_->pIdx(CrossAssetModel::AssetType::INF, idx, 1)][gridIndexInPath_[i + 1]];
+        state[2] = ir_state[std::get<1>(tup)][0];
 
-            // Update the term structure's date and state.
-            auto ts = std::get<3>(tup);
-            ts->move(dates_[i], state);
+        // Update the term structure's date and state.
+        auto ts = std::get<3>(tup);
+        ts->move(dates_[i], state);
 
-            // Create the YoY pillar dates from the tenors.
-            vector<Date> pillarDates(ten_yinf_[j].size());
-            for (Size k = 0; k < pillarDates.size(); ++k)
-                pillarDates[k] = dates_[i] + ten_yinf_[j][k];
+        // Create the YoY pillar dates from the tenors.
+        vector<Date> pillarDates(ten_yinf_[j].size());
+        for (Size k = 0; k < pillarDates.size(); ++k)
+            pillarDates[k] = dates_[i] + ten_yinf_[j][k];
 
-            // Use the YoY term structure's YoY rates to populate the scenarios.
-            auto yoyRates = ts->yoyRates(pillarDates);
-            for (Size k = 0; k < pillarDates.size(); ++k) {
-                scenarios[i]->add(yoyInflationKeys_[j * ten_yinf_[j].size() + k], yoyRates.at(pillarDates[k]));
-            }
+        // Use the YoY term structure's YoY rates to populate the scenarios.
+        auto yoyRates = ts->yoyRates(pillarDates);
+        for (Size k = 0; k < pillarDates.size(); ++k) {
+            addValue(values, keys, yoyInflationKeys_[j * ten_yinf_[j].size() + k], yoyRates.at(pillarDates[k]));
         }
+    }
 
-        // Credit curves
-        for (Size j = 0; j < n_cr_; ++j) {
-            if (model_->modelType(CrossAssetModel::AssetType::CR, j) == CrossAssetModel::ModelType::LGM1F) {
-                Real z = sample.value[model_->pIdx(CrossAssetModel::AssetType::CR, j, 0)][gridIndexInPath_[i + 1]];
-                Real y = sample.value[model_->pIdx(CrossAssetModel::AssetType::CR, j, 1)][gridIndexInPath_[i + 1]];
-                lgmDefaultCurves_[j]->move(dates_[i], z, y);
-                for (Size k = 0; k < ten_dfc_[j].size(); k++) {
-                    Date d = dates_[i] + ten_dfc_[j][k];
-                    Time T = dc.yearFraction(dates_[i], d);
-                    Real survProb = std::max(lgmDefaultCurves_[j]->survivalProbability(T), 0.00001);
-                    scenarios[i]->add(defaultCurveKeys_[j * ten_dfc_[j].size() + k], survProb);
-                }
-            } else if (model_->modelType(CrossAssetModel::AssetType::CR, j) == CrossAssetModel::ModelType::CIRPP) {
-                Real y = sample.value[model_->pIdx(CrossAssetModel::AssetType::CR, j, 0)][gridIndexInPath_[i + 1]];
-                cirppDefaultCurves_[j]->move(dates_[i], y);
-                for (Size k = 0; k < ten_dfc_[j].size(); k++) {
-                    Date d = dates_[i] + ten_dfc_[j][k];
-                    Time T = dc.yearFraction(dates_[i], d);
-                    Real survProb = std::max(cirppDefaultCurves_[j]->survivalProbability(T), 0.00001);
-                    scenarios[i]->add(defaultCurveKeys_[j * ten_dfc_[j].size() + k], survProb);
-                }
+    // Credit curves
+    for (Size j = 0; j < n_cr_; ++j) {
+        if (model_->modelType(CrossAssetModel::AssetType::CR, j) == CrossAssetModel::ModelType::LGM1F) {
+            Real z = path[model_->pIdx(CrossAssetModel::AssetType::CR, j, 0)][gridIndexInPath_[i + 1]];
+            Real y = path[model_->pIdx(CrossAssetModel::AssetType::CR, j, 1)][gridIndexInPath_[i + 1]];
+            lgmDefaultCurves_[j]->move(dates_[i], z, y);
+            for (Size k = 0; k < ten_dfc_[j].size(); k++) {
+                Date d = dates_[i] + ten_dfc_[j][k];
+                Time T = dc.yearFraction(dates_[i], d);
+                Real survProb = std::max(lgmDefaultCurves_[j]->survivalProbability(T), 0.00001);
+                addValue(values, keys, defaultCurveKeys_[j * ten_dfc_[j].size() + k], survProb);
             }
-        }
-
-        // Commodity curves
-        Array comState(1, 0.0); // FIXME: single-factor for now
-        for (Size j = 0; j < n_com_; j++) {
-            comState[0] = sample.value[model_->pIdx(CrossAssetModel::AssetType::COM, j)][gridIndexInPath_[i + 1]];
-            comCurves_[j]->move(t, comState);
-            for (Size k = 0; k < ten_com_[j].size(); k++) {
-                Date d = dates_[i] + ten_com_[j][k];
+        } else if (model_->modelType(CrossAssetModel::AssetType::CR, j) == CrossAssetModel::ModelType::CIRPP) {
+            Real y = path[model_->pIdx(CrossAssetModel::AssetType::CR, j, 0)][gridIndexInPath_[i + 1]];
+            cirppDefaultCurves_[j]->move(dates_[i], y);
+            for (Size k = 0; k < ten_dfc_[j].size(); k++) {
+                Date d = dates_[i] + ten_dfc_[j][k];
                 Time T = dc.yearFraction(dates_[i], d);
-                Real price = std::max(comCurves_[j]->price(T), 0.00001);
-                scenarios[i]->add(commodityCurveKeys_[j * ten_com_[j].size() + k], price);
+                Real survProb = std::max(cirppDefaultCurves_[j]->survivalProbability(T), 0.00001);
+                addValue(values, keys, defaultCurveKeys_[j * ten_dfc_[j].size() + k], survProb);
             }
         }
+    }
 
-        // Credit States
-        for (Size k = 0; k < n_crstates_; ++k) {
-            Real z = sample.value[model_->pIdx(CrossAssetModel::AssetType::CrState, k)][gridIndexInPath_[i + 1]];
-            scenarios[i]->add(crStateKeys_[k], z);
+    // Commodity curves
+    Array comState(1, 0.0); // FIXME: single-factor for now
+    for (Size j = 0; j < n_com_; j++) {
+        comState[0] = path[model_->pIdx(CrossAssetModel::AssetType::COM, j)][gridIndexInPath_[i + 1]];
+        comCurves_[j]->move(timeGrid_[i + 1], comState);
+        for (Size k = 0; k < ten_com_[j].size(); k++) {
+            Date d = dates_[i] + ten_com_[j][k];
+            Time T = dc.yearFraction(dates_[i], d);
+            Real price = std::max(comCurves_[j]->price(T), 0.00001);
+            addValue(values, keys, commodityCurveKeys_[j * ten_com_[j].size() + k], price);
         }
+    }
 
-        // Survival Weights, stochastic cumulative survival probability, Recovery Rates
-        for (Size k = 0; k < n_survivalweights_; ++k) {
-            string name = simMarketConfig_->additionalScenarioDataSurvivalWeights()[k];
-            Real rr = survivalWeightsDefaultCurves_[k]->recovery().empty()
-                          ? 0.0
-                          : survivalWeightsDefaultCurves_[k]->recovery()->value();
-            scenarios[i]->add(survivalWeightKeys_[k],
-                              survivalWeightsDefaultCurves_[k]->curve()->survivalProbability(dates_[i]));
-            scenarios[i]->add(recoveryRateKeys_[k], rr);
-        }
+    // Credit States
+    for (Size k = 0; k < n_crstates_; ++k) {
+        Real z = path[model_->pIdx(CrossAssetModel::AssetType::CrState, k)][gridIndexInPath_[i + 1]];
+        addValue(values, keys, crStateKeys_[k], z);
     }
 
-    if (totalSamples_ == currentSample_ && !amcPathDataOutput_.empty()) {
-        LOG("Serialize paths, fx and irState buffers to'" << amcPathDataOutput_ << "'");
-        std::ofstream os(amcPathDataOutput_, std::ios::binary);
-        boost::archive::binary_oarchive oa(os, boost::archive::no_header);
-        oa << pathData_;
-        os.close();
+    // Survival Weights, stochastic cumulative survival probability, Recovery Rates
+    for (Size k = 0; k < n_survivalweights_; ++k) {
+        string name = simMarketConfig_->additionalScenarioDataSurvivalWeights()[k];
+        Real rr = survivalWeightsDefaultCurves_[k]->recovery().empty()
+                      ? 0.0
+                      : survivalWeightsDefaultCurves_[k]->recovery()->value();
+        addValue(values, keys, survivalWeightKeys_[k],
+                 survivalWeightsDefaultCurves_[k]->curve()->survivalProbability(dates_[i]));
+        addValue(values, keys, recoveryRateKeys_[k], rr);
     }
+}
 
-    return scenarios;
+QuantLib::ext::shared_ptr<Scenario> CrossAssetModelScenarioGenerator::buildScenario(const Date& d,
+                                                                                   const Real numeraire,
+                                                                                   std::vector<Real>& values) {
+    QL_REQUIRE(values.size() == scenarioKeys_.size(), "CrossAssetModelScenarioGenerator: number of values ("
+                                                          << values.size() << ") does not match number of keys ("
+                                                          << scenarioKeys_.size() << ")");
+    auto scenario = scenarioFactory_->buildScenario(d, true);
+    scenario->setNumeraire(numeraire);
+
+    // if the scenario shares its keys with the first scenario we built, we can move the values in
+    auto simpleScenario = QuantLib::ext::dynamic_pointer_cast<SimpleScenario>(scenario);
+    if (simpleScenario && scenarioSharedData_ && simpleScenario->sharedData() == scenarioSharedData_ &&
+        simpleScenario->keys().size() == values.size()) {
+        simpleScenario->setData(std::move(values));
+        return scenario;
+    }
+
+    for (Size k = 0; k < values.size(); ++k)
+        scenario->add(scenarioKeys_[k], values[k]);
+
+    if (simpleScenario && !scenarioSharedData_ && simpleScenario->keys() == scenarioKeys_)
+        scenarioSharedData_ = simpleScenario->sharedData();
+
+    return scenario;
 }
 
 void CrossAssetModelScenarioGenerator::reset() {
 
     pathGenerator_->reset();
 
+    bufferedPaths_.clear();
+    nextBufferedPath_ = 0;
+
+    dscCoefficients_.clear();
+    idxCoefficients_.clear();
+    ycCoefficients_.clear();
+    zeroBondCoefficientsBuilt_ = false;
+
     for (auto const& [x, b, m, t] : zeroInfCurves_)
         t->clearCache();
     for (auto const& [x, b, m, t] : yoyInfCurves_)
@@ -28,6 +28,7 @@
 #include <orea/scenario/scenariogenerator.hpp>
 #include <orea/scenario/scenariosimmarket.hpp>
 #include <orea/scenario/scenariosimmarketparameters.hpp>
+#include <orea/scenario/simplescenario.hpp>
 #include <ored/marketdata/market.hpp>
 #include <ored/utilities/dategrid.hpp>
 
@@ -62,6 +63,11 @@ using namespace QuantExt;
   - a simulation date grid that starts in the future, i.e. does not include today's date
   - the associated time grid including t=0
 
+  Paths can be generated in batches, see nextPaths() and setBatchSize(). Zero bonds on discount, index and yield
+  curves in currencies with an LGM1F model are then evaluated for all paths of the batch at once using coefficients
+  that are computed once per simulation date and tenor. If the scenario factory builds SimpleScenarios sharing their
+  keys, the generated values are moved into the scenarios without going through Scenario::add().
+
   \ingroup scenario
  */
 class CrossAssetModelScenarioGenerator : public ScenarioPathGenerator {
@@ -80,7 +86,26 @@ public:
     std::vector<QuantLib::ext::shared_ptr<Scenario>> nextPath() override;
     void reset() override;
 
+    /*! Generates the next n paths, the result is indexed by path, then by date. The paths are identical to the
+        ones returned by n calls to nextPath() with batch size 1. */
+    std::vector<std::vector<QuantLib::ext::shared_ptr<Scenario>>> nextPaths(const Size n);
+
+    /*! Sets the number of paths generated in one go by nextPath(), which returns the buffered paths one by one
+        afterwards. The default is 1. */
+    void setBatchSize(const Size batchSize);
+
 private:
+    // P(t, t + tenor) = ratio * exp(-h * x - c) in terms of the LGM1F state x
+    struct ZeroBondCoefficients {
+        Real ratio, h, c;
+    };
+
+    Sample<MultiPath> nextSample();
+    void buildZeroBondCoefficients();
+    void addPathValues(const MultiPath& path, const Size i, const DayCounter& dc, const std::vector<Array>& ir_state,
+                       std::vector<Real>& values, std::vector<RiskFactorKey>* keys);
+    QuantLib::ext::shared_ptr<Scenario> buildScenario(const Date& d, const Real numeraire, std::vector<Real>& values);
+
     QuantLib::ext::shared_ptr<QuantExt::CrossAssetModel> model_;
     QuantLib::ext::shared_ptr<QuantExt::MultiPathGeneratorBase> pathGenerator_;
     QuantLib::ext::shared_ptr<ScenarioFactory> scenarioFactory_;
@@ -102,6 +127,7 @@ private:
     vector<QuantLib::ext::shared_ptr<QuantExt::ModelImpliedYieldTermStructure>> curves_, fwdCurves_, yieldCurves_;
     vector<QuantLib::ext::shared_ptr<QuantExt::ModelImpliedPriceTermStructure>> comCurves_;
     vector<QuantLib::ext::shared_ptr<IborIndex>> indices_;
+    vector<Handle<YieldTermStructure>> fwdTargetCurves_, yieldTargetCurves_;
     vector<Currency> yieldCurveCurrency_;
     vector<string> zeroInflationIndex_, yoyInflationIndex_;
     vector<tuple<Size, Size, CrossAssetModel::ModelType, QuantLib::ext::shared_ptr<ZeroInflationModelTermStructure>>>
@@ -116,6 +142,17 @@ private:
     Size currentSample_ = 0;
     Size totalSamples_;
     std::vector<Size> gridIndexInPath_;
+
+    // batch generation
+    Size batchSize_ = 1;
+    std::vector<std::vector<QuantLib::ext::shared_ptr<Scenario>>> bufferedPaths_;
+    Size nextBufferedPath_ = 0;
+    // per curve, date, tenor, empty for curves in currencies without LGM1F model
+    std::vector<std::vector<std::vector<ZeroBondCoefficients>>> dscCoefficients_, idxCoefficients_, ycCoefficients_;
+    bool zeroBondCoefficientsBuilt_ = false;
+    // keys in the order of the generated values and the shared data of the scenarios that can take them directly
+    std::vector<RiskFactorKey> scenarioKeys_;
+    QuantLib::ext::shared_ptr<SimpleScenario::SharedData> scenarioSharedData_;
 };
 
 } // namespace analytics
@@ -0,0 +1,360 @@
+/*
+ Copyright (C) 2025 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+#include <orea/scenario/scenarioarchive.hpp>
+#include <orea/scenario/scenarioutilities.hpp>
+#include <orea/scenario/simplescenario.hpp>
+
+#include <ored/utilities/log.hpp>
+#include <ored/utilities/to_string.hpp>
+
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include <cstring>
+#include <limits>
+
+using namespace QuantLib;
+
+namespace ore {
+namespace analytics {
+
+namespace {
+
+// binary scenario archive format, see scenarioarchive.hpp
+
+constexpr char scenarioArchiveMagic[8] = {'O', 'R', 'E', 'S', 'C', 'E', 'N', 'B'};
+constexpr std::uint32_t scenarioArchiveVersion = 1;
+constexpr std::uint32_t scenarioArchiveByteOrderMark = 0x01020304;
+constexpr std::size_t scenarioArchiveAlignment = 64;
+constexpr std::uint32_t scenarioArchiveAbsoluteFlag = 1;
+constexpr std::uint32_t scenarioArchiveParFlag = 2;
+
+constexpr std::size_t scenarioArchiveHeaderSize =
+    sizeof(scenarioArchiveMagic) + 4 * sizeof(std::uint32_t) + 4 * sizeof(std::uint64_t);
+
+std::size_t alignScenarioArchiveOffset(const std::size_t offset) {
+    return (offset + scenarioArchiveAlignment - 1) / scenarioArchiveAlignment * scenarioArchiveAlignment;
+}
+
+template <typename I> void appendBinary(std::string& buffer, const I value) {
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(I));
+}
+
+void appendBinary(std::string& buffer, const std::string& value) {
+    appendBinary<std::uint64_t>(buffer, value.size());
+    buffer.append(value);
+}
+
+std::size_t keysHash(const std::vector<RiskFactorKey>& keys) {
+    // same as the hash of a SimpleScenario with these keys
+    std::size_t h = 0;
+    for (auto const& k : keys)
+        boost::hash_combine(h, k);
+    return h;
+}
+
+class BinaryScenarioReader {
+public:
+    BinaryScenarioReader(const char* data, const std::size_t size, const std::string& filename)
+        : data_(data), size_(size), pos_(0), filename_(filename) {}
+
+    template <typename I> I read() {
+        checkAvailable(sizeof(I));
+        I value;
+        std::memcpy(&value, data_ + pos_, sizeof(I));
+        pos_ += sizeof(I);
+        return value;
+    }
+
+    std::string readString() {
+        std::size_t n = read<std::uint64_t>();
+        checkAvailable(n);
+        std::string value(data_ + pos_, n);
+        pos_ += n;
+        return value;
+    }
+
+    void seek(const std::size_t pos) {
+        QL_REQUIRE(pos <= size_, "ScenarioArchive: invalid offset " << pos << " in file '" << filename_ << "'");
+        pos_ = pos;
+    }
+
+private:
+    void checkAvailable(const std::size_t n) const {
+        QL_REQUIRE(pos_ + n <= size_, "ScenarioArchive: unexpected end of file '" << filename_ << "'");
+    }
+
+    const char* data_;
+    std::size_t size_;
+    std::size_t pos_;
+    std::string filename_;
+};
+
+} // namespace
+
+ScenarioArchiveWriter::ScenarioArchiveWriter(const std::string& filename, const bool singlePrecision)
+    : filename_(filename), singlePrecision_(singlePrecision),
+      out_(filename, std::ios::binary | std::ios::out | std::ios::trunc) {
+    QL_REQUIRE(out_, "ScenarioArchiveWriter: could not open file '" << filename << "' for writing");
+}
+
+ScenarioArchiveWriter::~ScenarioArchiveWriter() {
+    try {
+        close();
+    } catch (const std::exception& e) {
+        ALOG("ScenarioArchiveWriter: error while closing file '" << filename_ << "': " << e.what());
+    }
+}
+
+void ScenarioArchiveWriter::writeHeader() {
+    std::size_t valueSize = singlePrecision_ ? sizeof(float) : sizeof(double);
+    std::string header(scenarioArchiveMagic, sizeof(scenarioArchiveMagic));
+    appendBinary<std::uint32_t>(header, scenarioArchiveVersion);
+    appendBinary<std::uint32_t>(header, scenarioArchiveByteOrderMark);
+    appendBinary<std::uint32_t>(header, static_cast<std::uint32_t>(valueSize));
+    appendBinary<std::uint32_t>(header, (isAbsolute_ ? scenarioArchiveAbsoluteFlag : 0) |
+                                            (isPar_ ? scenarioArchiveParFlag : 0));
+    appendBinary<std::uint64_t>(header, numKeys_);
+    appendBinary<std::uint64_t>(header, dates_.size());
+    appendBinary<std::uint64_t>(header, dataOffset_);
+    // the scenario index follows the value matrix
+    appendBinary<std::uint64_t>(header, dataOffset_ + dates_.size() * numKeys_ * valueSize);
+    QL_REQUIRE(header.size() == scenarioArchiveHeaderSize,
+               "internal error: ScenarioArchiveWriter: unexpected header size");
+    out_.write(header.data(), header.size());
+}
+
+void ScenarioArchiveWriter::add(const Scenario& s, const std::vector<RiskFactorKey>& keys, const std::string& label) {
+    QL_REQUIRE(!closed_, "ScenarioArchiveWriter: archive '" << filename_ << "' is closed, can not add scenario");
+
+    if (dataOffset_ == 0) {
+        // first scenario: write a preliminary header, the key dictionary and pad to the start of the value matrix
+        numKeys_ = keys.size();
+        keysHash_ = keysHash(keys);
+        isAbsolute_ = s.isAbsolute();
+        isPar_ = s.isPar();
+        std::string dictionary;
+        for (auto const& k : keys)
+            appendBinary(dictionary, ore::data::to_string(k));
+        dataOffset_ = alignScenarioArchiveOffset(scenarioArchiveHeaderSize + dictionary.size());
+        dictionary.resize(dataOffset_ - scenarioArchiveHeaderSize, '\0');
+        writeHeader();
+        out_.write(dictionary.data(), dictionary.size());
+    } else {
+        QL_REQUIRE(keys.size() == numKeys_ && keysHash(keys) == keysHash_,
+                   "ScenarioArchiveWriter: scenario for " << s.asof() << " has different keys than the previous "
+                                                          << "scenarios, all scenarios in an archive must have the "
+                                                          << "same keys");
+        QL_REQUIRE(s.isAbsolute() == isAbsolute_ && s.isPar() == isPar_,
+                   "ScenarioArchiveWriter: scenario for " << s.asof() << " has different absolute / par flags "
+                                                          << "than the previous scenarios");
+    }
+
+    if (singlePrecision_)
+        addRow<float>(s, keys);
+    else
+        addRow<double>(s, keys);
+
+    dates_.push_back(s.asof());
+    numeraires_.push_back(s.getNumeraire());
+    labels_.push_back(label);
+
+    QL_REQUIRE(out_, "ScenarioArchiveWriter: error while writing file '" << filename_ << "'");
+}
+
+template <typename T> void ScenarioArchiveWriter::addRow(const Scenario& s, const std::vector<RiskFactorKey>& keys) {
+    std::vector<T> row(keys.size());
+    for (Size k = 0; k < keys.size(); ++k) {
+        Real v = s.get(keys[k]);
+        row[k] = v == Null<Real>() ? std::numeric_limits<T>::quiet_NaN() : static_cast<T>(v);
+    }
+    out_.write(reinterpret_cast<const char*>(row.data()), row.size() * sizeof(T));
+}
+
+void ScenarioArchiveWriter::close() {
+    if (closed_)
+        return;
+    closed_ = true;
+
+    if (dataOffset_ == 0) {
+        // no scenarios were added, write an empty archive
+        dataOffset_ = alignScenarioArchiveOffset(scenarioArchiveHeaderSize);
+        writeHeader();
+        std::string padding(dataOffset_ - scenarioArchiveHeaderSize, '\0');
+        out_.write(padding.data(), padding.size());
+    }
+
+    std::string index;
+    for (Size i = 0; i < dates_.size(); ++i) {
+        appendBinary<std::int64_t>(index, dates_[i].serialNumber());
+        appendBinary<double>(index, numeraires_[i]);
+        appendBinary(index, labels_[i]);
+    }
+    out_.write(index.data(), index.size());
+
+    // rewrite the header with the final number of scenarios
+
+    out_.seekp(0);
+    writeHeader();
+    out_.close();
+    QL_REQUIRE(out_, "ScenarioArchiveWriter: error while writing file '" << filename_ << "'");
+
+    LOG("ScenarioArchiveWriter: wrote " << dates_.size() << " scenarios with " << numKeys_ << " keys to '"
+                                        << filename_ << "'");
+}
+
+ScenarioArchive::ScenarioArchive(const std::string& filename) : filename_(filename) {
+
+    file_ = QuantLib::ext::make_shared<boost::iostreams::mapped_file_source>(filename);
+    BinaryScenarioReader in(file_->data(), file_->size(), filename);
+
+    // read header
+
+    char magic[sizeof(scenarioArchiveMagic)];
+    for (auto& c : magic)
+        c = in.read<char>();
+    QL_REQUIRE(std::memcmp(magic, scenarioArchiveMagic, sizeof(magic)) == 0,
+               "ScenarioArchive: file '" << filename << "' is not a scenario archive");
+    auto version = in.read<std::uint32_t>();
+    QL_REQUIRE(version == scenarioArchiveVersion, "ScenarioArchive: file '" << filename << "' has version " << version
+                                                                             << ", expected "
+                                                                             << scenarioArchiveVersion);
+    QL_REQUIRE(in.read<std::uint32_t>() == scenarioArchiveByteOrderMark,
+               "ScenarioArchive: file '" << filename << "' was written on a platform with different byte order");
+    valueSize_ = in.read<std::uint32_t>();
+    QL_REQUIRE(valueSize_ == sizeof(double) || valueSize_ == sizeof(float),
+               "ScenarioArchive: file '" << filename << "' has invalid value size " << valueSize_);
+    auto flags = in.read<std::uint32_t>();
+    isAbsolute_ = (flags & scenarioArchiveAbsoluteFlag) != 0;
+    isPar_ = (flags & scenarioArchiveParFlag) != 0;
+    Size numKeys = in.read<std::uint64_t>();
+    Size numScenarios = in.read<std::uint64_t>();
+    std::size_t dataOffset = in.read<std::uint64_t>();
+    std::size_t indexOffset = in.read<std::uint64_t>();
+    QL_REQUIRE(dataOffset % scenarioArchiveAlignment == 0 &&
+                   indexOffset == dataOffset + numScenarios * numKeys * valueSize_ && indexOffset <= file_->size(),
+               "ScenarioArchive: file '" << filename << "' has inconsistent offsets, it might be truncated");
+
+    // read key dictionary
+
+    keys_.reserve(numKeys);
+    for (Size k = 0; k < numKeys; ++k) {
+        keys_.push_back(QuantExt::parseRiskFactorKey(in.readString()));
+        QL_REQUIRE(keyIndex_.insert(std::make_pair(keys_.back(), k)).second,
+                   "ScenarioArchive: file '" << filename << "' contains duplicate key " << keys_.back());
+    }
+    keysHash_ = keysHash(keys_);
+
+    // read scenario index
+
+    in.seek(indexOffset);
+    dates_.reserve(numScenarios);
+    numeraires_.reserve(numScenarios);
+    labels_.reserve(numScenarios);
+    for (Size i = 0; i < numScenarios; ++i) {
+        dates_.push_back(Date(static_cast<Date::serial_type>(in.read<std::int64_t>())));
+        numeraires_.push_back(in.read<double>());
+        labels_.push_back(in.readString());
+    }
+
+    data_ = file_->data() + dataOffset;
+
+    LOG("ScenarioArchive: mapped " << numScenarios << " scenarios with " << numKeys << " keys from '" << filename
+                                   << "', value size " << valueSize_);
+}
+
+ScenarioArchive::~ScenarioArchive() {}
+
+bool ScenarioArchive::isScenarioArchive(const std::string& filename) {
+    std::ifstream in(filename, std::ios::binary | std::ios::in);
+    char magic[sizeof(scenarioArchiveMagic)];
+    return in.read(magic, sizeof(magic)) && std::memcmp(magic, scenarioArchiveMagic, sizeof(magic)) == 0;
+}
+
+MappedScenario::MappedScenario(const QuantLib::ext::shared_ptr<const ScenarioArchive>& archive, const Size index)
+    : archive_(archive), index_(index) {
+    QL_REQUIRE(archive_, "MappedScenario: no archive given");
+    QL_REQUIRE(index_ < archive_->numScenarios(), "MappedScenario: index " << index_ << " out of range, archive has "
+                                                                          << archive_->numScenarios()
+                                                                          << " scenarios");
+    asof_ = archive_->date(index_);
+    label_ = archive_->label(index_);
+    numeraire_ = archive_->numeraire(index_);
+    isAbsolute_ = archive_->isAbsolute();
+    isPar_ = archive_->isPar();
+}
+
+const std::map<std::pair<RiskFactorKey::KeyType, std::string>, std::vector<std::vector<Real>>>&
+MappedScenario::coordinates() const {
+    static const std::map<std::pair<RiskFactorKey::KeyType, std::string>, std::vector<std::vector<Real>>> empty;
+    return empty;
+}
+
+bool MappedScenario::has(const RiskFactorKey& key) const {
+    return archive_->keyIndex().find(key) != archive_->keyIndex().end();
+}
+
+void MappedScenario::add(const RiskFactorKey& key, Real) {
+    QL_FAIL("MappedScenario::add(" << key << "): scenario is a read only view into a scenario archive, clone it first");
+}
+
+Real MappedScenario::get(const RiskFactorKey& key) const {
+    auto i = archive_->keyIndex().find(key);
+    QL_REQUIRE(i != archive_->keyIndex().end(), "MappedScenario does not provide data for key " << key);
+    Real v = archive_->value(index_, i->second);
+    return isAbsolute_ ? sanitizeScenarioValue(key.keytype, isPar_, v) : v;
+}
+
+QuantLib::ext::shared_ptr<Scenario> MappedScenario::clone() const {
+    auto s = QuantLib::ext::make_shared<SimpleScenario>(asof_, label_, numeraire_);
+    s->setAbsolute(isAbsolute_);
+    s->setPar(isPar_);
+    auto const& keys = archive_->keys();
+    for (Size k = 0; k < keys.size(); ++k)
+        s->add(keys[k], archive_->value(index_, k));
+    return s;
+}
+
+ScenarioArchiveReader::ScenarioArchiveReader(const std::string& filename)
+    : archive_(QuantLib::ext::make_shared<ScenarioArchive>(filename)) {}
+
+ScenarioArchiveReader::ScenarioArchiveReader(const QuantLib::ext::shared_ptr<const ScenarioArchive>& archive)
+    : archive_(archive) {
+    QL_REQUIRE(archive_, "ScenarioArchiveReader: no archive given");
+}
+
+bool ScenarioArchiveReader::next() {
+    if (current_ <= archive_->numScenarios())
+        ++current_;
+    return current_ <= archive_->numScenarios();
+}
+
+Date ScenarioArchiveReader::date() const {
+    if (current_ == 0 || current_ > archive_->numScenarios())
+        return Null<Date>();
+    return archive_->date(current_ - 1);
+}
+
+QuantLib::ext::shared_ptr<Scenario> ScenarioArchiveReader::scenario() const {
+    if (current_ == 0 || current_ > archive_->numScenarios())
+        return nullptr;
+    return QuantLib::ext::make_shared<MappedScenario>(archive_, current_ - 1);
+}
+
+} // namespace analytics
+} // namespace ore
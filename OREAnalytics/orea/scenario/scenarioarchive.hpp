@@ -0,0 +1,197 @@
+/*
+ Copyright (C) 2025 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+/*! \file orea/scenario/scenarioarchive.hpp
+    \brief binary scenario archive, memory mapped for reading
+    \ingroup scenario
+*/
+
+#pragma once
+
+#include <orea/scenario/scenario.hpp>
+#include <orea/scenario/scenarioreader.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace boost {
+namespace iostreams {
+class mapped_file_source;
+}
+} // namespace boost
+
+namespace ore {
+namespace analytics {
+
+/*! Binary scenario archive
+
+    The archive holds scenarios that provide values for the same risk factor keys, e.g. a history of market
+    scenarios. The layout is
+
+    - a fixed size header: magic "ORESCENB", version, byte order mark, value size (4 or 8), absolute / par flags,
+      number of keys, number of scenarios, offset of the value matrix, offset of the scenario index
+    - the key dictionary, i.e. the risk factor keys as strings
+    - the value matrix (64 byte aligned), one row of float or double values per scenario in the order of the key
+      dictionary, missing values are stored as NaN
+    - the scenario index: date, numeraire and label for each scenario
+
+    The archive is written by ScenarioWriter for file names with extension ".bin" and read by mapping the file into
+    memory, see ScenarioArchive and ScenarioArchiveReader. The file is only readable on platforms with the same byte
+    order as the one it was written on. */
+class ScenarioArchiveWriter {
+public:
+    ScenarioArchiveWriter(const std::string& filename, const bool singlePrecision = false);
+    ~ScenarioArchiveWriter();
+
+    /*! add a scenario, the keys define the columns of the archive and must be the same for all scenarios */
+    void add(const Scenario& s, const std::vector<RiskFactorKey>& keys, const std::string& label);
+
+    /*! write the scenario index and the final header, no more scenarios can be added after this call */
+    void close();
+
+private:
+    template <typename T> void addRow(const Scenario& s, const std::vector<RiskFactorKey>& keys);
+    void writeHeader();
+
+    std::string filename_;
+    bool singlePrecision_;
+    std::ofstream out_;
+    bool closed_ = false;
+    QuantLib::Size numKeys_ = 0;
+    std::size_t keysHash_ = 0;
+    bool isAbsolute_ = true, isPar_ = false;
+    std::size_t dataOffset_ = 0;
+    std::vector<QuantLib::Date> dates_;
+    std::vector<QuantLib::Real> numeraires_;
+    std::vector<std::string> labels_;
+};
+
+//! Read only access to a binary scenario archive, the file is mapped into memory
+class ScenarioArchive {
+public:
+    explicit ScenarioArchive(const std::string& filename);
+    ~ScenarioArchive();
+
+    //! true if the file starts with the magic of a scenario archive
+    static bool isScenarioArchive(const std::string& filename);
+
+    QuantLib::Size numScenarios() const { return dates_.size(); }
+    QuantLib::Size numKeys() const { return keys_.size(); }
+    const std::vector<RiskFactorKey>& keys() const { return keys_; }
+    const std::map<RiskFactorKey, QuantLib::Size>& keyIndex() const { return keyIndex_; }
+    std::size_t keysHash() const { return keysHash_; }
+    bool isAbsolute() const { return isAbsolute_; }
+    bool isPar() const { return isPar_; }
+    bool singlePrecision() const { return valueSize_ == sizeof(float); }
+
+    const QuantLib::Date& date(const QuantLib::Size scenario) const { return dates_[scenario]; }
+    QuantLib::Real numeraire(const QuantLib::Size scenario) const { return numeraires_[scenario]; }
+    const std::string& label(const QuantLib::Size scenario) const { return labels_[scenario]; }
+
+    //! value for a scenario and key index, Null<Real>() if the value is missing
+    QuantLib::Real value(const QuantLib::Size scenario, const QuantLib::Size key) const {
+        QuantLib::Real v = valueSize_ == sizeof(double)
+                               ? reinterpret_cast<const double*>(data_)[scenario * keys_.size() + key]
+                               : reinterpret_cast<const float*>(data_)[scenario * keys_.size() + key];
+        return std::isnan(v) ? QuantLib::Null<QuantLib::Real>() : v;
+    }
+
+private:
+    std::string filename_;
+    QuantLib::ext::shared_ptr<boost::iostreams::mapped_file_source> file_;
+    const char* data_ = nullptr;
+    std::uint32_t valueSize_ = 0;
+    bool isAbsolute_ = true, isPar_ = false;
+    std::vector<RiskFactorKey> keys_;
+    std::map<RiskFactorKey, QuantLib::Size> keyIndex_;
+    std::size_t keysHash_ = 0;
+    std::vector<QuantLib::Date> dates_;
+    std::vector<QuantLib::Real> numeraires_;
+    std::vector<std::string> labels_;
+};
+
+//! Scenario that is a view on one row of a scenario archive
+/*! The scenario does not copy the values, it keeps the archive (and with it the mapped file) alive. The values can
+    not be modified, add() throws, clone() returns a SimpleScenario holding a copy of the values instead. Date, label,
+    numeraire and the absolute / par flags can be overwritten on the view though. */
+class MappedScenario : public Scenario {
+public:
+    MappedScenario(const QuantLib::ext::shared_ptr<const ScenarioArchive>& archive, const QuantLib::Size index);
+
+    const QuantLib::Date& asof() const override { return asof_; }
+    void setAsof(const QuantLib::Date& d) override { asof_ = d; }
+
+    const std::string& label() const override { return label_; }
+    void label(const std::string& s) override { label_ = s; }
+
+    QuantLib::Real getNumeraire() const override { return numeraire_; }
+    void setNumeraire(QuantLib::Real n) override { numeraire_ = n; }
+
+    const bool isAbsolute() const override { return isAbsolute_; }
+    void setAbsolute(const bool isAbsolute) override { isAbsolute_ = isAbsolute; }
+    const bool isPar() const override { return isPar_; }
+    void setPar(const bool isPar) override { isPar_ = isPar; }
+
+    const std::map<std::pair<RiskFactorKey::KeyType, std::string>, std::vector<std::vector<QuantLib::Real>>>&
+    coordinates() const override;
+
+    std::size_t keysHash() const override { return archive_->keysHash(); }
+
+    bool has(const RiskFactorKey& key) const override;
+    const std::vector<RiskFactorKey>& keys() const override { return archive_->keys(); }
+    void add(const RiskFactorKey& key, QuantLib::Real value) override;
+    QuantLib::Real get(const RiskFactorKey& key) const override;
+
+    QuantLib::ext::shared_ptr<Scenario> clone() const override;
+
+    const QuantLib::ext::shared_ptr<const ScenarioArchive>& archive() const { return archive_; }
+    QuantLib::Size index() const { return index_; }
+
+private:
+    QuantLib::ext::shared_ptr<const ScenarioArchive> archive_;
+    QuantLib::Size index_;
+    QuantLib::Date asof_;
+    std::string label_;
+    QuantLib::Real numeraire_;
+    bool isAbsolute_, isPar_;
+};
+
+//! Scenario reader on a binary scenario archive, the scenarios are MappedScenario views into the archive
+class ScenarioArchiveReader : public ScenarioReader {
+public:
+    explicit ScenarioArchiveReader(const std::string& filename);
+    explicit ScenarioArchiveReader(const QuantLib::ext::shared_ptr<const ScenarioArchive>& archive);
+
+    bool next() override;
+    QuantLib::Date date() const override;
+    QuantLib::ext::shared_ptr<Scenario> scenario() const override;
+
+    const QuantLib::ext::shared_ptr<const ScenarioArchive>& archive() const { return archive_; }
+
+private:
+    QuantLib::ext::shared_ptr<const ScenarioArchive> archive_;
+    // index of the current scenario plus one, i.e. zero before the first call to next()
+    QuantLib::Size current_ = 0;
+};
+
+} // namespace analytics
+} // namespace ore
@@ -63,9 +63,11 @@ ScenarioGeneratorBuilder::build(QuantLib::ext::shared_ptr<QuantExt::CrossAssetMo
     auto pathGen = pf->build(data_->sequenceType(), process, processTimeGrid, data_->seed(), data_->ordering(),
                              data_->directionIntegers());
 
-    return QuantLib::ext::make_shared<CrossAssetModelScenarioGenerator>(
+    auto generator = QuantLib::ext::make_shared<CrossAssetModelScenarioGenerator>(
         model, pathGen, scenarioFactory, marketConfig, asof, data_->getGrid(), initMarket, configuration,
         amcPathDataInput, data_->samples());
+    generator->setBatchSize(data_->batchSize());
+    return generator;
 }
 } // namespace analytics
 } // namespace ore
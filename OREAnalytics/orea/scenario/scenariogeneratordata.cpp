@@ -132,6 +132,10 @@ void ScenarioGeneratorData::fromXML(XMLNode* root) {
 
     timeStepsPerYear_ = XMLUtils::getChildValueAsInt(node, "TimeStepsPerYear", false, Null<Size>());
 
+    int batchSize = XMLUtils::getChildValueAsInt(node, "BatchSize", false, 1);
+    QL_REQUIRE(batchSize > 0, "ScenarioGeneratorData: BatchSize must be positive, got " << batchSize);
+    batchSize_ = batchSize;
+
     LOG("ScenarioGeneratorData done.");
 }
 
@@ -168,6 +172,9 @@ XMLNode* ScenarioGeneratorData::toXML(XMLDocument& doc) const {
     if(timeStepsPerYear_ != Null<Size>())
         XMLUtils::addChild(doc, pNode, "TimeStepsPerYear", to_string(timeStepsPerYear_));
 
+    if (batchSize_ != 1)
+        XMLUtils::addChild(doc, pNode, "BatchSize", to_string(batchSize_));
+
     return node;
 }
 
@@ -54,7 +54,7 @@ public:
     ScenarioGeneratorData()
         : grid_(QuantLib::ext::make_shared<DateGrid>()), sequenceType_(SobolBrownianBridge), seed_(0), samples_(0),
           ordering_(SobolBrownianGenerator::Steps), directionIntegers_(SobolRsg::JoeKuoD7), withCloseOutLag_(false),
-          withMporStickyDate_(false), timeStepsPerYear_(Null<Size>()) {}
+          withMporStickyDate_(false), timeStepsPerYear_(Null<Size>()), batchSize_(1) {}
 
     //! Constructor
     ScenarioGeneratorData(QuantLib::ext::shared_ptr<DateGrid> dateGrid, SequenceType sequenceType, long seed,
@@ -64,7 +64,7 @@ public:
                           Size timeStepsPerYear = Null<Size>())
         : sequenceType_(sequenceType), seed_(seed), samples_(samples), ordering_(ordering),
           directionIntegers_(directionIntegers), withCloseOutLag_(false), withMporStickyDate_(false),
-          timeStepsPerYear_(timeStepsPerYear) {
+          timeStepsPerYear_(timeStepsPerYear), batchSize_(1) {
         setGrid(dateGrid);
     }
 
@@ -88,6 +88,7 @@ public:
     bool withMporStickyDate() const { return withMporStickyDate_; }
     Period closeOutLag() const { return closeOutLag_; }
     Size timeStepsPerYear() const { return timeStepsPerYear_; }
+    Size batchSize() const { return batchSize_; }
     //@}
 
     //! \name Setters
@@ -102,6 +103,7 @@ public:
     bool& withMporStickyDate() { return withMporStickyDate_; }
     Period& closeOutLag() { return closeOutLag_; }
     Size& timeStepsPerYear() { return timeStepsPerYear_; }
+    Size& batchSize() { return batchSize_; }
     //@}
 private:
     QuantLib::ext::shared_ptr<DateGrid> grid_;
@@ -113,6 +115,7 @@ private:
     bool withCloseOutLag_;
     bool withMporStickyDate_;
     Size timeStepsPerYear_;
+    Size batchSize_;
     Period closeOutLag_;
     MporCashFlowMode mporCashFlowMode_;
     string gridString_;
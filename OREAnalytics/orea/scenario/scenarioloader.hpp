@@ -85,6 +85,8 @@ protected:
 };
 
 //! Class for loading historical scenarios
+/*! If the scenarios are read from a binary archive (ScenarioArchiveReader) they are views into the memory mapped
+    archive, i.e. the values are not copied. */
 class HistoricalScenarioLoader : public ScenarioLoader {
 public:
     //! Default constructor
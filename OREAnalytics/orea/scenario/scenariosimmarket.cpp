@@ -3382,6 +3382,37 @@ void ScenarioSimMarket::reset() {
 }
 
 void ScenarioSimMarket::applyScenario(const QuantLib::ext::shared_ptr<QuantExt::Scenario>& s) {
+    // if updates are disabled already (e.g. by the caller), there is nothing to gain from batching
+    batchUpdates_ = ObservationMode::instance().mode() == ObservationMode::Mode::Batch &&
+                    ObservableSettings::instance().updatesEnabled();
+    pendingQuotes_.clear();
+    pendingValues_.clear();
+    applyScenarioData(s);
+    if (batchUpdates_) {
+        batchUpdates_ = false;
+        applyPendingUpdates();
+    }
+}
+
+void ScenarioSimMarket::setSimDataValue(const QuantLib::ext::shared_ptr<SimpleQuote>& quote, const Real value) {
+    if (batchUpdates_) {
+        pendingQuotes_.push_back(quote.get());
+        pendingValues_.push_back(value);
+    } else {
+        quote->setValue(value);
+    }
+}
+
+void ScenarioSimMarket::applyPendingUpdates() {
+    // with deferred updates the observers of the changed quotes are collected in a set and notified once, when updates
+    // are enabled again, instead of running through the notification chain for every single quote
+    ObservableSettings::instance().disableUpdates(true);
+    for (Size i = 0; i < pendingQuotes_.size(); ++i)
+        pendingQuotes_[i]->setValue(pendingValues_[i]);
+    ObservableSettings::instance().enableUpdates();
+}
+
+void ScenarioSimMarket::applyScenarioData(const QuantLib::ext::shared_ptr<QuantExt::Scenario>& s) {
 
     auto scenario = s;
     if (useSpreadedTermStructures_ && scenario->isAbsolute())
@@ -3406,14 +3437,17 @@ void ScenarioSimMarket::applyScenario(const QuantLib::ext::shared_ptr<QuantExt::
         delta scenarios or the base scenario */
 
     if (deltaScenario != nullptr) {
+        auto delta = deltaScenario->delta();
         for (auto const& key : diffToBaseKeys_) {
+            // keys that are set below anyway are not reset to their base value
+            if (delta->has(key) && filter_->allow(key))
+                continue;
             auto it = simData_.find(key);
             if (it != simData_.end()) {
-                it->second->setValue(baseScenario_->get(key));
+                setSimDataValue(it->second, baseScenario_->get(key));
             }
         }
         diffToBaseKeys_.clear();
-        auto delta = deltaScenario->delta();
         bool missingPoint = false;
         for (auto const& key : delta->keys()) {
             auto it = simData_.find(key);
@@ -3422,7 +3456,7 @@ void ScenarioSimMarket::applyScenario(const QuantLib::ext::shared_ptr<QuantExt::
                 missingPoint = true;
             } else {
                 if (filter_->allow(key)) {
-                    it->second->setValue(delta->get(key));
+                    setSimDataValue(it->second, delta->get(key));
                     diffToBaseKeys_.insert(key);
                 }
             }
@@ -3471,7 +3505,7 @@ void ScenarioSimMarket::applyScenario(const QuantLib::ext::shared_ptr<QuantExt::
             Size i = 0;
             for (auto const& q : s->data()) {
                 if (cachedSimDataActive_[i])
-                    cachedSimData_[i]->setValue(q);
+                    setSimDataValue(cachedSimData_[i], q);
                 ++i;
             }
 
@@ -3495,7 +3529,7 @@ void ScenarioSimMarket::applyScenario(const QuantLib::ext::shared_ptr<QuantExt::
             WLOG("simulation data point missing for key " << key);
         } else {
             if (filter_->allow(key)) {
-                it->second->setValue(scenario->get(key));
+                setSimDataValue(it->second, scenario->get(key));
             }
             count++;
         }
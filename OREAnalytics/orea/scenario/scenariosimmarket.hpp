@@ -149,10 +149,15 @@ public:
     //! is risk factor key simulated by this sim market instance?
     virtual bool isSimulated(const RiskFactorKey::KeyType& factor) const;
 
+    /*! Apply the scenario to the sim data. In ObservationMode::Batch the quote updates are collected first and then
+        applied with deferred notifications, so that each observer of the sim data is notified once per scenario. */
     void applyScenario(const QuantLib::ext::shared_ptr<Scenario>& scenario);
 
 protected:
-    
+    void applyScenarioData(const QuantLib::ext::shared_ptr<Scenario>& scenario);
+    void setSimDataValue(const QuantLib::ext::shared_ptr<SimpleQuote>& quote, const Real value);
+    void applyPendingUpdates();
+
 
     void writeSimData(std::map<RiskFactorKey, QuantLib::ext::shared_ptr<SimpleQuote>>& simDataTmp,
                       std::map<RiskFactorKey, Real>& absoluteSimDataTmp, const RiskFactorKey::KeyType keyType,
@@ -210,6 +215,11 @@ protected:
     // for delta scenario application
     std::set<ore::analytics::RiskFactorKey> diffToBaseKeys_;
 
+    // for batched scenario application (ObservationMode::Batch)
+    bool batchUpdates_ = false;
+    std::vector<SimpleQuote*> pendingQuotes_;
+    std::vector<Real> pendingValues_;
+
     mutable QuantLib::ext::shared_ptr<Scenario> currentScenario_;
     QuantLib::ext::shared_ptr<Scenario> offsetScenario_;
     QuantLib::ext::shared_ptr<QuantExt::ScenarioInformationSetter> scenarioInformationSetter_;
@@ -19,6 +19,8 @@
 #include <orea/scenario/scenariowriter.hpp>
 #include <ored/utilities/to_string.hpp>
 
+#include <boost/filesystem.hpp>
+
 using ore::data::to_string;
 
 namespace ore {
@@ -26,18 +28,18 @@ namespace analytics {
 
 ScenarioWriter::ScenarioWriter(const QuantLib::ext::shared_ptr<ScenarioGenerator>& src, const std::string& filename,
                                const char sep, const string& filemode, const std::vector<RiskFactorKey>& headerKeys,
-                               const bool writeDuplicateDates, Size precision)
+                               const bool writeDuplicateDates, Size precision, const bool singlePrecision)
     : src_(src), fp_(nullptr), i_(0), sep_(sep), headerKeys_(headerKeys), writeDuplicateDates_(writeDuplicateDates),
       precision_(precision) {
-    open(filename, filemode);
+    open(filename, filemode, singlePrecision);
 }
 
 ScenarioWriter::ScenarioWriter(const std::string& filename, const char sep, const string& filemode,
                                const std::vector<RiskFactorKey>& headerKeys, const bool writeDuplicateDates,
-                               Size precision)
+                               Size precision, const bool singlePrecision)
     : fp_(nullptr), i_(0), sep_(sep), headerKeys_(headerKeys), writeDuplicateDates_(writeDuplicateDates),
       precision_(precision) {
-    open(filename, filemode);
+    open(filename, filemode, singlePrecision);
 }
 
 ScenarioWriter::ScenarioWriter(const QuantLib::ext::shared_ptr<ScenarioGenerator>& src,
@@ -47,7 +49,14 @@ ScenarioWriter::ScenarioWriter(const QuantLib::ext::shared_ptr<ScenarioGenerator
     : src_(src), report_(report), fp_(nullptr), i_(0), sep_(','), headerKeys_(headerKeys),
       writeDuplicateDates_(writeDuplicateDates), precision_(precision) {}
 
-void ScenarioWriter::open(const std::string& filename, const std::string& filemode) {
+void ScenarioWriter::open(const std::string& filename, const std::string& filemode, const bool singlePrecision) {
+    if (boost::filesystem::path(filename).extension().string() == ".bin") {
+        QL_REQUIRE(filemode.substr(0, 1) == "w",
+                   "ScenarioWriter: file mode '" << filemode << "' not supported for binary scenario archive "
+                                                 << filename << ", the archive can not be appended to");
+        archive_ = std::make_unique<ScenarioArchiveWriter>(filename, singlePrecision);
+        return;
+    }
     fp_ = fopen(filename.c_str(), filemode.c_str());
     QL_REQUIRE(fp_, "Error opening file " << filename << " for scenarios");
 }
@@ -69,6 +78,10 @@ void ScenarioWriter::close() {
         fclose(fp_);
         fp_ = nullptr;
     }
+    if (archive_) {
+        archive_->close();
+        archive_.reset();
+    }
     if (report_)
         report_->end();
 }
@@ -106,6 +119,9 @@ void ScenarioWriter::writeScenario(const QuantLib::ext::shared_ptr<Scenario>& s,
         keysHash_ = s->keysHash();
     }
 
+    if (archive_)
+        archive_->add(*s, keys_, s->label().empty() ? to_string(i_) : s->label());
+
     if (fp_) {
         if (writeHeader) {
             QL_REQUIRE(keys_.size() > 0, "No keys in scenario");
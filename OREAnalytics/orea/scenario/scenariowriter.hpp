@@ -24,26 +24,32 @@
 #pragma once
 
 #include <orea/scenario/scenario.hpp>
+#include <orea/scenario/scenarioarchive.hpp>
 #include <orea/scenario/scenariogenerator.hpp>
 #include <orea/scenario/shiftscenariogenerator.hpp>
 #include <ored/report/report.hpp>
 
+#include <memory>
+
 namespace ore {
 namespace analytics {
 
 //! Class for writing scenarios to file.
+/*! If the file name has the extension ".bin" the scenarios are written to a binary scenario archive instead of a csv
+    file, see ScenarioArchiveWriter. In this case all scenarios must provide the same keys, the separator and precision
+    are ignored and the values are stored as float if singlePrecision is true, as double otherwise. */
 class ScenarioWriter : public ScenarioGenerator {
 public:
     //! Constructor
     ScenarioWriter(const QuantLib::ext::shared_ptr<ScenarioGenerator>& src, const std::string& filename,
                    const char sep = ',', const string& filemode = "w+",
                    const std::vector<RiskFactorKey>& headerKeys = {}, const bool writeDuplicateDates = true, 
-                   QuantLib::Size precision = 8);
+                   QuantLib::Size precision = 8, const bool singlePrecision = false);
 
     //! Constructor to write single scenarios
     ScenarioWriter(const std::string& filename, const char sep = ',', const string& filemode = "w+",
                    const std::vector<RiskFactorKey>& headerKeys = {}, const bool writeDuplicateDates = true, 
-                   QuantLib::Size precision = 8);
+                   QuantLib::Size precision = 8, const bool singlePrecision = false);
 
     //! Constructor to write into an in-memory report for later io
     ScenarioWriter(const QuantLib::ext::shared_ptr<ScenarioGenerator>& src,
@@ -67,12 +73,13 @@ public:
     void close();
 
 private:
-    void open(const std::string& filename, const std::string& filemode = "w+");
+    void open(const std::string& filename, const std::string& filemode = "w+", const bool singlePrecision = false);
 
     QuantLib::ext::shared_ptr<ScenarioGenerator> src_;
     std::vector<RiskFactorKey> keys_;
     QuantLib::ext::shared_ptr<ore::data::Report> report_;
     FILE* fp_;
+    std::unique_ptr<ScenarioArchiveWriter> archive_;
     Date firstDate_;
     Size i_;
     const char sep_ = ',';
@@ -54,6 +54,13 @@ void SimpleScenario::add(const RiskFactorKey& key, QuantLib::Real value) {
     data_[dataIndex] = value;
 }
 
+void SimpleScenario::setData(std::vector<QuantLib::Real>&& data) {
+    QL_REQUIRE(data.size() == sharedData_->keys.size(), "SimpleScenario::setData(): data size ("
+                                                            << data.size() << ") does not match number of keys ("
+                                                            << sharedData_->keys.size() << ")");
+    data_ = std::move(data);
+}
+
 QuantLib::Real SimpleScenario::get(const RiskFactorKey& key) const {
     auto i = sharedData_->keyIndex.find(key);
     QL_REQUIRE(i != sharedData_->keyIndex.end(), "SimpleScenario does not provide data for key " << key);
@@ -87,8 +87,19 @@ QuantLib::Date BucketMapping::validFromDate() const {
 string SimmBucketMapperBase::bucket(const RiskType& riskType, const string& qualifier) const {
 
     auto key = std::make_pair(riskType, qualifier);
-    if (auto b = cache_.find(key); b != cache_.end())
-        return b->second;
+    {
+        boost::shared_lock<boost::shared_mutex> lock(mutex_);
+        if (auto b = cache_.find(key); b != cache_.end())
+            return b->second;
+    }
+
+    string bucket = lookupBucket(riskType, qualifier);
+    boost::unique_lock<boost::shared_mutex> lock(mutex_);
+    cache_[key] = bucket;
+    return bucket;
+}
+
+string SimmBucketMapperBase::lookupBucket(const RiskType& riskType, const string& qualifier) const {
 
     QL_REQUIRE(hasBuckets(riskType), "The risk type " << riskType << " does not have buckets");
 
@@ -101,9 +112,7 @@ string SimmBucketMapperBase::bucket(const RiskType& riskType, const string& qual
 
     // Deal with RiskType::IRCurve
     if (lookupRiskType == RiskType::IRCurve || lookupRiskType == RiskType::GIRR_DELTA) {
-        auto tmp = irBucket(qualifier);
-        cache_[key] = tmp;
-        return tmp;
+        return irBucket(qualifier);
     }
 
     string bucket;
@@ -167,6 +176,7 @@ string SimmBucketMapperBase::bucket(const RiskType& riskType, const string& qual
         fm.lookupName = lookupName;
         fm.riskType = riskType;
         fm.lookupRiskType = lookupRiskType;
+        boost::unique_lock<boost::shared_mutex> lock(mutex_);
         failedMappings_.insert(fm);
 
     } else {
@@ -174,16 +184,13 @@ string SimmBucketMapperBase::bucket(const RiskType& riskType, const string& qual
         Date today = Settings::instance().evaluationDate();
         for (auto m : bucketMapping_.at(lookupRiskType).at(lookupName)) {
             if (m.validToDate() >= today && m.validFromDate() <= today && m.fallback() == !haveMapping) {
-                bucket = m.bucket();
-                cache_[key] = bucket;
-                return bucket;
+                return m.bucket();
             }
         }
         TLOG("bucket mapping for risk type " << riskType << " and qualifier " << qualifier << " inactive, return Residual");
         bucket = "Residual";
     }
 
-    cache_[key] = bucket;
     return bucket;
 }
 
@@ -323,7 +330,10 @@ XMLNode* SimmBucketMapperBase::toXML(ore::data::XMLDocument& doc) const {
 void SimmBucketMapperBase::addMapping(const RiskType& riskType, const string& qualifier, const string& bucket,
                                       const string& validFrom, const string& validTo, bool fallback) {
 
-    cache_.clear();
+    {
+        boost::unique_lock<boost::shared_mutex> lock(mutex_);
+        cache_.clear();
+    }
 
     // Possibly map to non-vol counterpart for lookup
     RiskType rt = riskType;
@@ -386,6 +396,7 @@ void SimmBucketMapperBase::checkRiskType(const RiskType& riskType) const {
 }
 
 void SimmBucketMapperBase::reset() {
+    boost::unique_lock<boost::shared_mutex> lock(mutex_);
     cache_.clear();
     // Clear the bucket mapper and add back the commodity mappings
     bucketMapping_.clear();
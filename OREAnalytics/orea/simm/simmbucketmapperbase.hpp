@@ -28,6 +28,8 @@
 #include <ored/utilities/xmlutils.hpp>
 #include <ored/portfolio/referencedata.hpp>
 
+#include <boost/thread/shared_mutex.hpp>
+
 #include <map>
 #include <set>
 #include <string>
@@ -115,7 +117,13 @@ protected:
     std::set<CrifRecord::RiskType> rtWithBuckets_;
 
 private:
+    //! Look up the bucket without using the cache
+    std::string lookupBucket(const CrifRecord::RiskType& riskType, const std::string& qualifier) const;
+
+    /*! Cache of the bucket lookups, guarded by the mutex together with the failed mappings so that bucket() can be
+        called concurrently */
     mutable std::map<std::pair<CrifRecord::RiskType, std::string>, std::string> cache_;
+    mutable boost::shared_mutex mutex_;
 
     //! Reset the SIMM bucket mapper i.e. clears all mappings and adds the initial hard-coded commodity mappings
     void reset();
@@ -29,8 +29,11 @@
 #include <ored/utilities/log.hpp>
 #include <ored/utilities/parsers.hpp>
 #include <ored/utilities/to_string.hpp>
+#include <ored/utilities/workerthreadstate.hpp>
 #include <ql/math/comparison.hpp>
 #include <ql/quote.hpp>
+#include <ql/settings.hpp>
+#include <qle/utilities/workerpool.hpp>
 
 using std::abs;
 using std::accumulate;
@@ -52,8 +55,12 @@ using ore::data::NettingSetDetails;
 using ore::data::parseBool;
 using ore::data::to_string;
 using QuantLib::close_enough;
+using QuantLib::Date;
+using QuantLib::Matrix;
 using QuantLib::Null;
 using QuantLib::Real;
+using QuantLib::Settings;
+using QuantLib::Size;
 
 namespace ore {
 namespace analytics {
@@ -73,12 +80,20 @@ struct RegulationCompare {
     }
 };
 
+namespace {
+// Maximum number of risk factors per risk type, bucket and calculation currency for which the correlations are cached,
+// this limits the memory used by the cache to 8MB per bucket. Correlations between other risk factors are computed on
+// each use.
+constexpr Size maxCachedRiskFactors = 1024;
+} // namespace
+
 SimmCalculator::SimmCalculator(const QuantLib::ext::shared_ptr<ore::analytics::Crif>& crif,
                                const QuantLib::ext::shared_ptr<SimmConfiguration>& simmConfiguration,
                                const string& calculationCcyCall, const string& calculationCcyPost,
                                const string& resultCcy, const QuantLib::ext::shared_ptr<Market> market,
                                const bool determineWinningRegulations, const bool enforceIMRegulations,
-                               const bool quiet, const map<SimmSide, set<NettingSetDetails>>& hasSEC)
+                               const bool quiet, const map<SimmSide, set<NettingSetDetails>>& hasSEC,
+                               const Size nThreads)
     : simmConfiguration_(simmConfiguration), calculationCcyCall_(calculationCcyCall),
       calculationCcyPost_(calculationCcyPost), resultCcy_(resultCcy.empty() ? calculationCcyCall_ : resultCcy),
       market_(market), quiet_(quiet), hasSEC_(hasSEC) {
@@ -210,10 +225,16 @@ SimmCalculator::SimmCalculator(const QuantLib::ext::shared_ptr<ore::analytics::C
         }
     }
 
-    // Calculate SIMM call and post for each regulation under each netting set
+    // Collect the side-nettingSet-regulation combinations to calculate SIMM for
+    struct RegulationSimm {
+        SimmSide side;
+        const NettingSetDetails* nsd;
+        const set<Regulation>* regulation;
+        const Crif* crif;
+    };
+    vector<RegulationSimm> regulationSimms;
     for (const auto& [side, nettingSetRegulationCrifMap] : regSensitivities_) {
         for (const auto& [nsd, regulationCrifMap] : nettingSetRegulationCrifMap) {
-            // Calculate SIMM for particular side-nettingSet-regulation combination
             for (const auto& [regulation, crif] : regulationCrifMap) {
                 bool hasFixedAddOn = false;
                 for (const auto& sp : *crif) {
@@ -223,12 +244,53 @@ SimmCalculator::SimmCalculator(const QuantLib::ext::shared_ptr<ore::analytics::C
                     }
                 }
                 if (crif->hasCrifRecords() || hasFixedAddOn) {
-                    calculateRegulationSimm(*crif, nsd, regulation, side);
+                    regulationSimms.push_back({side, &nsd, &regulation, crif.get()});
                 }
             }
         }
     }
 
+    // Calculate SIMM call and post for each regulation under each netting set
+    if (nThreads > 1 && regulationSimms.size() > 1) {
+        Size n = regulationSimms.size();
+        if (!quiet_) {
+            LOG("SimmCalculator: Calculating SIMM for " << n << " side-nettingSet-regulation combinations on "
+                                                        << std::min(nThreads, n) << " threads");
+        }
+        // Each calculation writes its own results, which are merged in the serial order below
+        vector<SimmResults> results(n);
+        vector<vector<CrifRecord>> simmParameters(n);
+        vector<ore::data::Timer> timers(n);
+        // The market is not accessed on the worker threads, the fx rate for the concentration thresholds is looked up
+        // here
+        if (resultCcy_ != "USD" && market_)
+            concentrationFxRate();
+        // The bucket mappings depend on the evaluation date, which is thread local if QuantLib uses sessions
+        auto threadState = ore::data::WorkerThreadState::fromCurrentThread();
+        QuantExt::WorkerPool pool(std::min(nThreads, n));
+        vector<char> threadInitialised(pool.size(), 0);
+        pool.parallelFor(n, 1, [&](Size begin, Size end, Size t) {
+            if (t > 0 && !threadInitialised[t]) {
+                threadState.apply();
+                threadInitialised[t] = 1;
+            }
+            for (Size i = begin; i < end; ++i) {
+                const auto& r = regulationSimms[i];
+                calculateRegulationSimm(*r.crif, *r.nsd, *r.regulation, r.side, results[i], simmParameters[i],
+                                        timers[i]);
+            }
+        });
+        for (Size i = 0; i < n; ++i) {
+            const auto& r = regulationSimms[i];
+            simmResults_[r.side][*r.nsd][*r.regulation] = results[i];
+            addSimmParameters(simmParameters[i]);
+            timer_.addTime(timers[i]);
+        }
+    } else {
+        for (const auto& r : regulationSimms)
+            calculateRegulationSimm(*r.crif, *r.nsd, *r.regulation, r.side);
+    }
+
     // Determine winning call and post regulations
     if (determineWinningRegulations) {
         timer_.start("Determining winning regulations");
@@ -274,10 +336,20 @@ SimmCalculator::SimmCalculator(const QuantLib::ext::shared_ptr<ore::analytics::C
 
 const void SimmCalculator::calculateRegulationSimm(const Crif& crif, const NettingSetDetails& nettingSetDetails,
                                                    const set<Regulation>& regulations, const SimmSide& side) {
+    vector<CrifRecord> simmParameters;
+    SimmResults& results = simmResults_[side][nettingSetDetails][regulations];
+    calculateRegulationSimm(crif, nettingSetDetails, regulations, side, results, simmParameters, timer_);
+    addSimmParameters(simmParameters);
+}
+
+void SimmCalculator::calculateRegulationSimm(const Crif& crif, const NettingSetDetails& nettingSetDetails,
+                                             const set<Regulation>& regulations, const SimmSide& side,
+                                             SimmResults& results, vector<CrifRecord>& simmParameters,
+                                             ore::data::Timer& timer) const {
 
     const string regTimerKey =
         "calculate " + ore::data::to_string(side) + " SIMM (" + regulationsToString(regulations) + ")";
-    timer_.start(regTimerKey);
+    timer.start(regTimerKey);
 
     if (!quiet_) {
         LOG("SimmCalculator: Calculating SIMM " << side << " for portfolio [" << nettingSetDetails << "], regulations "
@@ -292,116 +364,124 @@ const void SimmCalculator::calculateRegulationSimm(const Crif& crif, const Netti
         // Delta margin components
         RiskClass rc = RiskClass::InterestRate;
         MarginType mt = MarginType::Delta;
-        auto p = irDeltaMargin(nettingSetDetails, productClass, crif, side);
+        auto p = irDeltaMargin(nettingSetDetails, productClass, crif, side, timer);
         if (p.second)
-            add(nettingSetDetails, regulations, productClass, rc, mt, p.first, side);
+            add(results, nettingSetDetails, productClass, rc, mt, p.first, side);
 
         rc = RiskClass::FX;
-        p = margin(nettingSetDetails, productClass, RiskType::FX, crif, side);
+        p = margin(nettingSetDetails, productClass, RiskType::FX, crif, side, timer);
         if (p.second)
-            add(nettingSetDetails, regulations, productClass, rc, mt, p.first, side);
+            add(results, nettingSetDetails, productClass, rc, mt, p.first, side);
 
         rc = RiskClass::CreditQualifying;
-        p = margin(nettingSetDetails, productClass, RiskType::CreditQ, crif, side);
+        p = margin(nettingSetDetails, productClass, RiskType::CreditQ, crif, side, timer);
         if (p.second)
-            add(nettingSetDetails, regulations, productClass, rc, mt, p.first, side);
+            add(results, nettingSetDetails, productClass, rc, mt, p.first, side);
 
         rc = RiskClass::CreditNonQualifying;
-        p = margin(nettingSetDetails, productClass, RiskType::CreditNonQ, crif, side);
+        p = margin(nettingSetDetails, productClass, RiskType::CreditNonQ, crif, side, timer);
         if (p.second)
-            add(nettingSetDetails, regulations, productClass, rc, mt, p.first, side);
+            add(results, nettingSetDetails, productClass, rc, mt, p.first, side);
 
         rc = RiskClass::Equity;
-        p = margin(nettingSetDetails, productClass, RiskType::Equity, crif, side);
+        p = margin(nettingSetDetails, productClass, RiskType::Equity, crif, side, timer);
         if (p.second)
-            add(nettingSetDetails, regulations, productClass, rc, mt, p.first, side);
+            add(results, nettingSetDetails, productClass, rc, mt, p.first, side);
 
         rc = RiskClass::Commodity;
-        p = margin(nettingSetDetails, productClass, RiskType::Commodity, crif, side);
+        p = margin(nettingSetDetails, productClass, RiskType::Commodity, crif, side, timer);
         if (p.second)
-            add(nettingSetDetails, regulations, productClass, rc, mt, p.first, side);
+            add(results, nettingSetDetails, productClass, rc, mt, p.first, side);
 
         // Vega margin components
         mt = MarginType::Vega;
         rc = RiskClass::InterestRate;
-        p = irVegaMargin(nettingSetDetails, productClass, crif, side);
+        p = irVegaMargin(nettingSetDetails, productClass, crif, side, timer);
         if (p.second)
-            add(nettingSetDetails, regulations, productClass, rc, mt, p.first, side);
+            add(results, nettingSetDetails, productClass, rc, mt, p.first, side);
 
         rc = RiskClass::FX;
-        p = margin(nettingSetDetails, productClass, RiskType::FXVol, crif, side);
+        p = margin(nettingSetDetails, productClass, RiskType::FXVol, crif, side, timer);
         if (p.second)
-            add(nettingSetDetails, regulations, productClass, rc, mt, p.first, side);
+            add(results, nettingSetDetails, productClass, rc, mt, p.first, side);
 
         rc = RiskClass::CreditQualifying;
-        p = margin(nettingSetDetails, productClass, RiskType::CreditVol, crif, side);
+        p = margin(nettingSetDetails, productClass, RiskType::CreditVol, crif, side, timer);
         if (p.second)
-            add(nettingSetDetails, regulations, productClass, rc, mt, p.first, side);
+            add(results, nettingSetDetails, productClass, rc, mt, p.first, side);
 
         rc = RiskClass::CreditNonQualifying;
-        p = margin(nettingSetDetails, productClass, RiskType::CreditVolNonQ, crif, side);
+        p = margin(nettingSetDetails, productClass, RiskType::CreditVolNonQ, crif, side, timer);
         if (p.second)
-            add(nettingSetDetails, regulations, productClass, rc, mt, p.first, side);
+            add(results, nettingSetDetails, productClass, rc, mt, p.first, side);
 
         rc = RiskClass::Equity;
-        p = margin(nettingSetDetails, productClass, RiskType::EquityVol, crif, side);
+        p = margin(nettingSetDetails, productClass, RiskType::EquityVol, crif, side, timer);
         if (p.second)
-            add(nettingSetDetails, regulations, productClass, rc, mt, p.first, side);
+            add(results, nettingSetDetails, productClass, rc, mt, p.first, side);
 
         rc = RiskClass::Commodity;
-        p = margin(nettingSetDetails, productClass, RiskType::CommodityVol, crif, side);
+        p = margin(nettingSetDetails, productClass, RiskType::CommodityVol, crif, side, timer);
         if (p.second)
-            add(nettingSetDetails, regulations, productClass, rc, mt, p.first, side);
+            add(results, nettingSetDetails, productClass, rc, mt, p.first, side);
 
         // Curvature margin components for sides call and post
         mt = MarginType::Curvature;
         rc = RiskClass::InterestRate;
 
-        p = irCurvatureMargin(nettingSetDetails, productClass, side, crif);
+        p = irCurvatureMargin(nettingSetDetails, productClass, side, crif, timer);
         if (p.second)
-            add(nettingSetDetails, regulations, productClass, rc, mt, p.first, side);
+            add(results, nettingSetDetails, productClass, rc, mt, p.first, side);
 
         rc = RiskClass::FX;
-        p = curvatureMargin(nettingSetDetails, productClass, RiskType::FXVol, side, crif, false);
+        p = curvatureMargin(nettingSetDetails, productClass, RiskType::FXVol, side, crif, timer, false);
         if (p.second)
-            add(nettingSetDetails, regulations, productClass, rc, mt, p.first, side);
+            add(results, nettingSetDetails, productClass, rc, mt, p.first, side);
 
         rc = RiskClass::CreditQualifying;
-        p = curvatureMargin(nettingSetDetails, productClass, RiskType::CreditVol, side, crif);
+        p = curvatureMargin(nettingSetDetails, productClass, RiskType::CreditVol, side, crif, timer);
         if (p.second)
-            add(nettingSetDetails, regulations, productClass, rc, mt, p.first, side);
+            add(results, nettingSetDetails, productClass, rc, mt, p.first, side);
 
         rc = RiskClass::CreditNonQualifying;
-        p = curvatureMargin(nettingSetDetails, productClass, RiskType::CreditVolNonQ, side, crif);
+        p = curvatureMargin(nettingSetDetails, productClass, RiskType::CreditVolNonQ, side, crif, timer);
         if (p.second)
-            add(nettingSetDetails, regulations, productClass, rc, mt, p.first, side);
+            add(results, nettingSetDetails, productClass, rc, mt, p.first, side);
 
         rc = RiskClass::Equity;
-        p = curvatureMargin(nettingSetDetails, productClass, RiskType::EquityVol, side, crif, false);
+        p = curvatureMargin(nettingSetDetails, productClass, RiskType::EquityVol, side, crif, timer, false);
         if (p.second)
-            add(nettingSetDetails, regulations, productClass, rc, mt, p.first, side);
+            add(results, nettingSetDetails, productClass, rc, mt, p.first, side);
 
         rc = RiskClass::Commodity;
-        p = curvatureMargin(nettingSetDetails, productClass, RiskType::CommodityVol, side, crif, false);
+        p = curvatureMargin(nettingSetDetails, productClass, RiskType::CommodityVol, side, crif, timer, false);
         if (p.second)
-            add(nettingSetDetails, regulations, productClass, rc, mt, p.first, side);
+            add(results, nettingSetDetails, productClass, rc, mt, p.first, side);
 
         // Base correlation margin components. This risk type came later so need to check
         // first if it is valid under the configuration
         if (simmConfiguration_->isValidRiskType(RiskType::BaseCorr)) {
-            p = margin(nettingSetDetails, productClass, RiskType::BaseCorr, crif, side);
+            p = margin(nettingSetDetails, productClass, RiskType::BaseCorr, crif, side, timer);
             if (p.second)
-                add(nettingSetDetails, regulations, productClass, RiskClass::CreditQualifying, MarginType::BaseCorr,
+                add(results, nettingSetDetails, productClass, RiskClass::CreditQualifying, MarginType::BaseCorr,
                     p.first, side);
         }
     }
 
     // Calculate the higher level margins
-    populateResults(side, nettingSetDetails, regulations);
+    populateResults(side, nettingSetDetails, results);
 
-    calcAddMargin(side, nettingSetDetails, regulations, crif);
+    calcAddMargin(side, nettingSetDetails, regulations, crif, results, simmParameters, timer);
 
-    timer_.stop(regTimerKey);
+    timer.stop(regTimerKey);
+}
+
+void SimmCalculator::addSimmParameters(const vector<CrifRecord>& simmParameters) {
+    for (const auto& spRecord : simmParameters) {
+        if (!simmParameters_)
+            simmParameters_ = QuantLib::ext::make_shared<Crif>();
+        simmParameters_->addRecord(spRecord);
+    }
 }
 
 const Regulation& SimmCalculator::winningRegulations(const SimmSide& side,
@@ -474,8 +554,9 @@ const map<SimmSide, map<NettingSetDetails, pair<Regulation, SimmResults>>>& Simm
 
 pair<map<string, QuantLib::Real>, bool> SimmCalculator::irDeltaMargin(const NettingSetDetails& nettingSetDetails,
                                                                       const ProductClass& pc, const Crif& crif,
-                                                                      const SimmSide& side) const {
-    timer_.start("irDeltaMargin()");
+                                                                      const SimmSide& side,
+                                                                      ore::data::Timer& timer) const {
+    timer.start("irDeltaMargin()");
 
     const string& calcCcy = side == SimmSide::Call ? calculationCcyCall_ : calculationCcyPost_;
 
@@ -489,7 +570,7 @@ pair<map<string, QuantLib::Real>, bool> SimmCalculator::irDeltaMargin(const Nett
     // If there are no qualifiers, return early and set bool to false to indicate margin does not apply
     if (qualifiers.empty()) {
         bucketMargins["All"] = 0.0;
-        timer_.stop("irDeltaMargin()");
+        timer.stop("irDeltaMargin()");
         return make_pair(bucketMargins, false);
     }
 
@@ -529,36 +610,52 @@ pair<map<string, QuantLib::Real>, bool> SimmCalculator::irDeltaMargin(const Nett
         // Divide by the concentration risk threshold
         QuantLib::Real concThreshold = simmConfiguration_->concentrationThreshold(RiskType::IRCurve, qualifier);
         if (resultCcy_ != "USD")
-            concThreshold *= fxRate("USD" + resultCcy_);
+            concThreshold *= concentrationFxRate();
         concentrationRisk[qualifier] /= concThreshold;
         // Final concentration risk amount
         concentrationRisk[qualifier] = std::max(1.0, std::sqrt(std::abs(concentrationRisk[qualifier])));
 
-        // Calculate the delta margin piece for this qualifier i.e. $K_b$ from SIMM docs
-        for (auto itOuter = pIrQualifier.first; itOuter != pIrQualifier.second; ++itOuter) {
+        // Weighted sensitivities i.e. $WS_{k,i}$ from SIMM docs and the risk factor of each sensitivity
+        vector<QuantLib::Real> ws;
+        vector<RiskFactor> factors;
+        vector<Size> recordFactors;
+        map<RiskFactor, Size> factorIndex;
+        for (auto it = pIrQualifier.first; it != pIrQualifier.second; ++it) {
             // Risk weight i.e. $RW_k$ from SIMM docs
-            QuantLib::Real rwOuter = simmConfiguration_->weight(RiskType::IRCurve, qualifier, itOuter->getLabel1());
-            // Weighted sensitivity i.e. $WS_{k,i}$ from SIMM docs
-            QuantLib::Real wsOuter = rwOuter * itOuter->amountResultCurrency() * concentrationRisk[qualifier];
+            QuantLib::Real rw = simmConfiguration_->weight(RiskType::IRCurve, qualifier, it->getLabel1());
+            ws.push_back(rw * it->amountResultCurrency() * concentrationRisk[qualifier]);
+            auto f = factorIndex.insert(
+                make_pair(make_tuple(qualifier, it->getLabel1(), it->getLabel2()), factors.size()));
+            if (f.second)
+                factors.push_back(f.first->first);
+            recordFactors.push_back(f.first->second);
+        }
+
+        // Product of the Label2 level correlation i.e. $\phi_{i,j}$ and the Label1 level correlation i.e.
+        // $\rho_{k,l}$ from SIMM docs
+        Matrix curveCorr = bucketCorrelations(
+            RiskType::IRCurve, qualifier, calcCcy, factors, recordFactors,
+            [this, &qualifier, &calcCcy](const RiskFactor& f1, const RiskFactor& f2) {
+                QuantLib::Real subCurveCorr =
+                    simmConfiguration_->correlation(RiskType::IRCurve, qualifier, "", "", std::get<2>(f1),
+                                                    RiskType::IRCurve, qualifier, "", "", std::get<2>(f2), calcCcy);
+                QuantLib::Real tenorCorr =
+                    simmConfiguration_->correlation(RiskType::IRCurve, qualifier, "", std::get<1>(f1), "",
+                                                    RiskType::IRCurve, qualifier, "", std::get<1>(f2), "", calcCcy);
+                return subCurveCorr * tenorCorr;
+            });
+
+        // Calculate the delta margin piece for this qualifier i.e. $K_b$ from SIMM docs
+        QuantLib::Real& kb = deltaMargin[qualifier];
+        for (Size k = 0; k < ws.size(); ++k) {
             // Update weighted sensitivity sum
-            sumWeightedSensis[qualifier] += wsOuter;
+            sumWeightedSensis[qualifier] += ws[k];
             // Add diagonal element to delta margin
-            deltaMargin[qualifier] += wsOuter * wsOuter;
+            kb += ws[k] * ws[k];
             // Add the cross elements to the delta margin
-            for (auto itInner = pIrQualifier.first; itInner != itOuter; ++itInner) {
-                // Label2 level correlation i.e. $\phi_{i,j}$ from SIMM docs
-                QuantLib::Real subCurveCorr = simmConfiguration_->correlation(
-                    RiskType::IRCurve, qualifier, "", "", itOuter->getLabel2(), RiskType::IRCurve, qualifier, "", "",
-                    itInner->getLabel2(), calcCcy);
-                // Label1 level correlation i.e. $\rho_{k,l}$ from SIMM docs
-                QuantLib::Real tenorCorr = simmConfiguration_->correlation(
-                    RiskType::IRCurve, qualifier, "", itOuter->getLabel1(), "", RiskType::IRCurve, qualifier, "",
-                    itInner->getLabel1(), "", calcCcy);
-                // Add cross element to delta margin
-                QuantLib::Real rwInner = simmConfiguration_->weight(RiskType::IRCurve, qualifier, itInner->getLabel1());
-                QuantLib::Real wsInner = rwInner * itInner->amountResultCurrency() * concentrationRisk[qualifier];
-                deltaMargin[qualifier] += 2 * subCurveCorr * tenorCorr * wsOuter * wsInner;
-            }
+            const Real* corrRow = curveCorr[recordFactors[k]];
+            for (Size l = 0; l < k; ++l)
+                kb += 2 * corrRow[recordFactors[l]] * ws[k] * ws[l];
         }
 
         // Add the Inflation component, if any
@@ -577,11 +674,9 @@ pair<map<string, QuantLib::Real>, bool> SimmCalculator::irDeltaMargin(const Nett
             // Correlation (know that Label1 and Label2 do not matter)
             QuantLib::Real corr = simmConfiguration_->correlation(RiskType::IRCurve, qualifier, "", "", "",
                                                                   RiskType::Inflation, qualifier, "", "", "", calcCcy);
-            for (auto it = pIrQualifier.first; it != pIrQualifier.second; ++it) {
+            for (Size k = 0; k < ws.size(); ++k) {
                 // Add cross element to delta margin
-                QuantLib::Real rw = simmConfiguration_->weight(RiskType::IRCurve, qualifier, it->getLabel1());
-                QuantLib::Real ws = rw * it->amountResultCurrency() * concentrationRisk[qualifier];
-                deltaMargin[qualifier] += 2 * corr * ws * wsInflation;
+                deltaMargin[qualifier] += 2 * corr * ws[k] * wsInflation;
             }
         }
 
@@ -654,16 +749,17 @@ pair<map<string, QuantLib::Real>, bool> SimmCalculator::irDeltaMargin(const Nett
         bucketMargins[m.first] = m.second;
     bucketMargins["All"] = margin;
 
-    timer_.stop("irDeltaMargin()");
+    timer.stop("irDeltaMargin()");
 
     return make_pair(bucketMargins, true);
 }
 
 pair<map<string, QuantLib::Real>, bool> SimmCalculator::irVegaMargin(const NettingSetDetails& nettingSetDetails,
                                                                      const ProductClass& pc, const Crif& crif,
-                                                                     const SimmSide& side) const {
+                                                                     const SimmSide& side,
+                                                                     ore::data::Timer& timer) const {
 
-    timer_.start("irVegaMargin()");
+    timer.start("irVegaMargin()");
 
     const string& calcCcy = side == SimmSide::Call ? calculationCcyCall_ : calculationCcyPost_;
 
@@ -676,7 +772,7 @@ pair<map<string, QuantLib::Real>, bool> SimmCalculator::irVegaMargin(const Netti
     // If there are no qualifiers, return early and set bool to false to indicate margin does not apply
     if (qualifiers.empty()) {
         bucketMargins["All"] = 0.0;
-        timer_.stop("irVegaMargin()");
+        timer.stop("irVegaMargin()");
         return make_pair(bucketMargins, false);
     }
 
@@ -705,7 +801,7 @@ pair<map<string, QuantLib::Real>, bool> SimmCalculator::irVegaMargin(const Netti
         // Divide by the concentration risk threshold
         QuantLib::Real concThreshold = simmConfiguration_->concentrationThreshold(RiskType::IRVol, qualifier);
         if (resultCcy_ != "USD")
-            concThreshold *= fxRate("USD" + resultCcy_);
+            concThreshold *= concentrationFxRate();
         concentrationRisk[qualifier] /= concThreshold;
 
         // Final concentration risk amount
@@ -802,15 +898,16 @@ pair<map<string, QuantLib::Real>, bool> SimmCalculator::irVegaMargin(const Netti
         bucketMargins[m.first] = m.second;
     bucketMargins["All"] = margin;
 
-    timer_.stop("irVegaMargin()");
+    timer.stop("irVegaMargin()");
 
     return make_pair(bucketMargins, true);
 }
 
 pair<map<string, QuantLib::Real>, bool> SimmCalculator::irCurvatureMargin(const NettingSetDetails& nettingSetDetails,
                                                                           const ProductClass& pc, const SimmSide& side,
-                                                                          const Crif& crif) const {
-    timer_.start("irCurvatureMargin()");
+                                                                          const Crif& crif,
+                                                                          ore::data::Timer& timer) const {
+    timer.start("irCurvatureMargin()");
 
     const string& calcCcy = side == SimmSide::Call ? calculationCcyCall_ : calculationCcyPost_;
 
@@ -826,7 +923,7 @@ pair<map<string, QuantLib::Real>, bool> SimmCalculator::irCurvatureMargin(const
     // If there are no qualifiers, return early and set bool to false to indicate margin does not apply
     if (qualifiers.empty()) {
         bucketMargins["All"] = 0.0;
-        timer_.stop("irCurvatureMargin()");
+        timer.stop("irCurvatureMargin()");
         return make_pair(bucketMargins, false);
     }
 
@@ -913,7 +1010,7 @@ pair<map<string, QuantLib::Real>, bool> SimmCalculator::irCurvatureMargin(const
     // If sum of absolute value of all individual curvature risks is zero, we can return 0.0
     if (close_enough(sumAbsWs, 0.0)) {
         bucketMargins["All"] = 0.0;
-        timer_.stop("irCurvatureMargin()");
+        timer.stop("irCurvatureMargin()");
         return make_pair(bucketMargins, true);
     }
 
@@ -945,15 +1042,16 @@ pair<map<string, QuantLib::Real>, bool> SimmCalculator::irCurvatureMargin(const
     // TODO: Review, should we return the pre-scaled value instead?
     bucketMargins["All"] = totalCurvatureMargin;
 
-    timer_.stop("irCurvatureMargin()");
+    timer.stop("irCurvatureMargin()");
 
     return make_pair(bucketMargins, true);
 }
 
 pair<map<string, QuantLib::Real>, bool> SimmCalculator::margin(const NettingSetDetails& nettingSetDetails,
                                                                const ProductClass& pc, const RiskType& rt,
-                                                               const Crif& crif, const SimmSide& side) const {
-    timer_.start("margin()");
+                                                               const Crif& crif, const SimmSide& side,
+                                                               ore::data::Timer& timer) const {
+    timer.start("margin()");
 
     const string& calcCcy = side == SimmSide::Call ? calculationCcyCall_ : calculationCcyPost_;
 
@@ -983,7 +1081,7 @@ pair<map<string, QuantLib::Real>, bool> SimmCalculator::margin(const NettingSetD
     // If there are no buckets, return early and set bool to false to indicate margin does not apply
     if (buckets.empty()) {
         bucketMargins["All"] = 0.0;
-        timer_.stop("margin()");
+        timer.stop("margin()");
         return make_pair(bucketMargins, false);
     }
 
@@ -1016,8 +1114,8 @@ pair<map<string, QuantLib::Real>, bool> SimmCalculator::margin(const NettingSetD
                 continue;
             }
 
-            // Pair of iterators to start and end of sensitivities with current qualifier
-            auto pQualifier = crifByQualifierAndBucket[std::make_pair(qualifier, bucket)];
+            // Sensitivities with current qualifier
+            const auto& pQualifier = crifByQualifierAndBucket[std::make_pair(qualifier, bucket)];
 
             // One pass to get the concentration risk for this qualifier
             for (auto it = pQualifier.begin(); it != pQualifier.end(); ++it) {
@@ -1028,67 +1126,71 @@ pair<map<string, QuantLib::Real>, bool> SimmCalculator::margin(const NettingSetD
             // Divide by the concentration risk threshold
             QuantLib::Real concThreshold = simmConfiguration_->concentrationThreshold(rt, qualifier);
             if (resultCcy_ != "USD")
-                concThreshold *= fxRate("USD" + resultCcy_);
+                concThreshold *= concentrationFxRate();
             concentrationRisk[qualifier] /= concThreshold;
             // Final concentration risk amount
             concentrationRisk[qualifier] = std::max(1.0, std::sqrt(std::abs(concentrationRisk[qualifier])));
         }
 
         // Calculate the margin component for the current bucket
-        // Pair of iterators to start and end of sensitivities within current bucket
-        auto pBucket = crifByBucket[bucket];
-        for (auto itOuter = pBucket.begin(); itOuter != pBucket.end(); ++itOuter) {
+        // Sensitivities within current bucket
+        const auto& pBucket = crifByBucket[bucket];
+
+        // The weighted sensitivity i.e. $WS_{k}$ from SIMM docs, the concentration risk and the risk factor of each
+        // sensitivity that enters the bucket margin
+        vector<const CrifRecord*> records;
+        vector<QuantLib::Real> ws, cr;
+        vector<RiskFactor> factors;
+        vector<Size> recordFactors;
+        map<RiskFactor, Size> factorIndex;
+        for (const auto& r : pBucket) {
             // Do not include Risk_FX components in the calculation currency in the SIMM calculation
-            if (rt == RiskType::FX && itOuter->qualifier == calcCcy) {
+            if (rt == RiskType::FX && r.qualifier == calcCcy) {
                 if (!quiet_) {
-                    DLOG("Skipping qualifier " << itOuter->qualifier << " of risk type " << rt
+                    DLOG("Skipping qualifier " << r.qualifier << " of risk type " << rt
                                                << " since the qualifier equals the SIMM calculation currency "
                                                << calcCcy);
                 }
                 continue;
             }
             // Risk weight i.e. $RW_k$ from SIMM docs
-            QuantLib::Real rwOuter = simmConfiguration_->weight(rt, itOuter->qualifier, itOuter->label1, calcCcy);
+            QuantLib::Real rw = simmConfiguration_->weight(rt, r.qualifier, r.label1, calcCcy);
             // Get the sigma value if applicable - returns 1.0 if not applicable
-            QuantLib::Real sigmaOuter = simmConfiguration_->sigma(rt, itOuter->qualifier, itOuter->label1, calcCcy);
-            // Weighted sensitivity i.e. $WS_{k}$ from SIMM docs
-            QuantLib::Real wsOuter =
-                rwOuter * (itOuter->amountResultCcy * sigmaOuter * hvr) * concentrationRisk[itOuter->qualifier];
-            // Get concentration risk for outer qualifier
-            QuantLib::Real outerConcentrationRisk = concentrationRisk.at(itOuter->qualifier);
+            QuantLib::Real sigma = simmConfiguration_->sigma(rt, r.qualifier, r.label1, calcCcy);
+            records.push_back(&r);
+            cr.push_back(concentrationRisk.at(r.qualifier));
+            ws.push_back(rw * (r.amountResultCcy * sigma * hvr) * cr.back());
+            auto f = factorIndex.insert(make_pair(make_tuple(r.qualifier, r.label1, r.label2), factors.size()));
+            if (f.second)
+                factors.push_back(f.first->first);
+            recordFactors.push_back(f.first->second);
+        }
+
+        // Correlations, $\rho_{k,l}$ in the SIMM docs
+        Matrix corr = bucketCorrelations(rt, bucket, calcCcy, factors, recordFactors,
+                                         [this, &rt, &bucket, &calcCcy](const RiskFactor& f1, const RiskFactor& f2) {
+                                             return simmConfiguration_->correlation(
+                                                 rt, std::get<0>(f1), bucket, std::get<1>(f1), std::get<2>(f1), rt,
+                                                 std::get<0>(f2), bucket, std::get<1>(f2), std::get<2>(f2), calcCcy);
+                                         });
+
+        QuantLib::Real& kb = bucketMargin[bucket];
+        for (Size k = 0; k < records.size(); ++k) {
             // Update weighted sensitivity sum
-            sumWeightedSensis[bucket] += wsOuter;
+            sumWeightedSensis[bucket] += ws[k];
             // Add diagonal element to bucket margin
-            bucketMargin[bucket] += wsOuter * wsOuter;
+            kb += ws[k] * ws[k];
             // Add the cross elements to the bucket margin
-            for (auto itInner = pBucket.begin(); itInner != itOuter; ++itInner) {
-                // Do not include Risk_FX components in the calculation currency in the SIMM calculation
-                if (rt == RiskType::FX && itInner->qualifier == calcCcy) {
-                    if (!quiet_) {
-                        DLOG("Skipping qualifier " << itInner->qualifier << " of risk type " << rt
-                                                   << " since the qualifier equals the SIMM calculation currency "
-                                                   << calcCcy);
-                    }
-                    continue;
-                }
-                // Correlation, $\rho_{k,l}$ in the SIMM docs
-                QuantLib::Real corr = simmConfiguration_->correlation(
-                    rt, itOuter->qualifier, itOuter->bucket, itOuter->label1, itOuter->label2, rt, itInner->qualifier,
-                    itInner->bucket, itInner->label1, itInner->label2, calcCcy);
+            const Real* corrRow = corr[recordFactors[k]];
+            for (Size l = 0; l < k; ++l) {
                 // $f_{k,l}$ from the SIMM docs
-                QuantLib::Real f = std::min(outerConcentrationRisk, concentrationRisk.at(itInner->qualifier)) /
-                                   std::max(outerConcentrationRisk, concentrationRisk.at(itInner->qualifier));
-                // Add cross element to delta margin
-                QuantLib::Real sigmaInner = simmConfiguration_->sigma(rt, itInner->qualifier, itInner->label1, calcCcy);
-                QuantLib::Real rwInner = simmConfiguration_->weight(rt, itInner->qualifier, itInner->label1, calcCcy);
-                QuantLib::Real wsInner =
-                    rwInner * (itInner->amountResultCcy * sigmaInner * hvr) * concentrationRisk[itInner->qualifier];
-                bucketMargin[bucket] += 2 * corr * f * wsOuter * wsInner;
+                QuantLib::Real f = std::min(cr[k], cr[l]) / std::max(cr[k], cr[l]);
+                kb += 2 * corrRow[recordFactors[l]] * f * ws[k] * ws[l];
             }
             // For FX risk class, results are broken down by qualifier, i.e. currency, instead of bucket, which is not
             // used for Risk_FX
             if (riskClassIsFX)
-                bucketMargins[itOuter->qualifier] += wsOuter;
+                bucketMargins[records[k]->qualifier] += ws[k];
         }
 
         // Finally have the value of $K_b$
@@ -1144,16 +1246,16 @@ pair<map<string, QuantLib::Real>, bool> SimmCalculator::margin(const NettingSetD
             m.second = std::abs(m.second);
 
     bucketMargins["All"] = margin;
-    timer_.stop("margin()");
+    timer.stop("margin()");
     return make_pair(bucketMargins, true);
 }
 
 pair<map<string, QuantLib::Real>, bool> SimmCalculator::curvatureMargin(const NettingSetDetails& nettingSetDetails,
                                                                         const ProductClass& pc, const RiskType& rt,
                                                                         const SimmSide& side, const Crif& crif,
-                                                                        bool rfLabels) const {
+                                                                        ore::data::Timer& timer, bool rfLabels) const {
 
-    timer_.start("curvatureMargin()");
+    timer.start("curvatureMargin()");
 
     const string& calcCcy = side == SimmSide::Call ? calculationCcyCall_ : calculationCcyPost_;
 
@@ -1179,7 +1281,7 @@ pair<map<string, QuantLib::Real>, bool> SimmCalculator::curvatureMargin(const Ne
     // If there are no buckets, return early and set bool to false to indicate margin does not apply
     if (buckets.empty()) {
         bucketMargins["All"] = 0.0;
-        timer_.stop("curvatureMargin()");
+        timer.stop("curvatureMargin()");
         return make_pair(bucketMargins, false);
     }
 
@@ -1199,45 +1301,61 @@ pair<map<string, QuantLib::Real>, bool> SimmCalculator::curvatureMargin(const Ne
         // Calculate the margin component for the current bucket
         // Pair of iterators to start and end of sensitivities within current bucket
         auto pBucket = crif.filterByBucket(nettingSetDetails, pc, rt, bucket);
-        for (auto itOuter = pBucket.first; itOuter != pBucket.second; ++itOuter) {
+
+        // for ISDA SIMM 2.2 or higher, the $CVR_{ik}$ for EQ bucket 12 are zero
+        const string simmVersion = simmConfiguration_->version();
+        SimmVersion thresholdVersion = SimmVersion::V2_2;
+        bool zeroCurvature =
+            (simmConfiguration_->isSimmConfigCalibration() || parseSimmVersion(simmVersion) >= thresholdVersion) &&
+            bucket == "12" && rt == RiskType::EquityVol;
+
+        // The weighted curvature i.e. $CVR_{ik}$ from SIMM docs and the risk factor of each sensitivity
+        vector<string> qualifiers;
+        vector<QuantLib::Real> ws;
+        vector<RiskFactor> factors;
+        vector<Size> recordFactors;
+        map<RiskFactor, Size> factorIndex;
+        for (auto it = pBucket.first; it != pBucket.second; ++it) {
             // Curvature weight i.e. $SF(t_{kj})$ from SIMM docs
-            QuantLib::Real sfOuter = simmConfiguration_->curvatureWeight(rt, itOuter->getLabel1());
+            QuantLib::Real sf = simmConfiguration_->curvatureWeight(rt, it->getLabel1());
             // Get the sigma value if applicable - returns 1.0 if not applicable
-            QuantLib::Real sigmaOuter =
-                simmConfiguration_->sigma(rt, itOuter->getQualifier(), itOuter->getLabel1(), calcCcy);
-            // Weighted curvature i.e. $CVR_{ik}$ from SIMM docs
+            QuantLib::Real sigma = simmConfiguration_->sigma(rt, it->getQualifier(), it->getLabel1(), calcCcy);
             // WARNING: The order of multiplication here is important because unit tests fail if for
-            //          example you use sfOuter * (itOuter->amountResultCurrency() * multiplier) * sigmaOuter;
-            QuantLib::Real wsOuter = sfOuter * ((itOuter->amountResultCurrency() * multiplier) * sigmaOuter);
-            // for ISDA SIMM 2.2 or higher, this $CVR_{ik}$ for EQ bucket 12 is zero
-            const string simmVersion = simmConfiguration_->version();
-            SimmVersion thresholdVersion = SimmVersion::V2_2;
-            if ((simmConfiguration_->isSimmConfigCalibration() || parseSimmVersion(simmVersion) >= thresholdVersion) &&
-                bucket == "12" && rt == RiskType::EquityVol) {
-                wsOuter = 0.0;
-            }
+            //          example you use sf * (it->amountResultCurrency() * multiplier) * sigma;
+            ws.push_back(zeroCurvature ? 0.0 : sf * ((it->amountResultCurrency() * multiplier) * sigma));
+            qualifiers.push_back(it->getQualifier());
+            auto f = factorIndex.insert(
+                make_pair(make_tuple(it->getQualifier(), it->getLabel1(), it->getLabel2()), factors.size()));
+            if (f.second)
+                factors.push_back(f.first->first);
+            recordFactors.push_back(f.first->second);
+        }
+
+        // Correlations, $\rho_{k,l}$ in the SIMM docs
+        Matrix corr = bucketCorrelations(rt, bucket, calcCcy, factors, recordFactors,
+                                         [this, &rt, &bucket, &calcCcy](const RiskFactor& f1, const RiskFactor& f2) {
+                                             return simmConfiguration_->correlation(
+                                                 rt, std::get<0>(f1), bucket, std::get<1>(f1), std::get<2>(f1), rt,
+                                                 std::get<0>(f2), bucket, std::get<1>(f2), std::get<2>(f2), calcCcy);
+                                         });
+
+        QuantLib::Real& kb = curvatureMargin[bucket];
+        for (Size k = 0; k < ws.size(); ++k) {
             // Update weighted sensitivity sum
-            sumWeightedSensis[bucket] += wsOuter;
-            sumAbsTemp[bucket][itOuter->getQualifier()] += rfLabels ? std::abs(wsOuter) : wsOuter;
+            sumWeightedSensis[bucket] += ws[k];
+            sumAbsTemp[bucket][qualifiers[k]] += rfLabels ? std::abs(ws[k]) : ws[k];
             // Add diagonal element to curvature margin
-            curvatureMargin[bucket] += wsOuter * wsOuter;
+            kb += ws[k] * ws[k];
             // Add the cross elements to the curvature margin
-            for (auto itInner = pBucket.first; itInner != itOuter; ++itInner) {
-                // Correlation, $\rho_{k,l}$ in the SIMM docs
-                QuantLib::Real corr = simmConfiguration_->correlation(
-                    rt, itOuter->getQualifier(), itOuter->getBucket(), itOuter->getLabel1(), itOuter->getLabel2(), rt,
-                    itInner->getQualifier(), itInner->getBucket(), itInner->getLabel1(), itInner->getLabel2(), calcCcy);
-                // Add cross element to delta margin
-                QuantLib::Real sfInner = simmConfiguration_->curvatureWeight(rt, itInner->getLabel1());
-                QuantLib::Real sigmaInner =
-                    simmConfiguration_->sigma(rt, itInner->getQualifier(), itInner->getLabel1(), calcCcy);
-                QuantLib::Real wsInner = sfInner * ((itInner->amountResultCurrency() * multiplier) * sigmaInner);
-                curvatureMargin[bucket] += 2 * corr * corr * wsOuter * wsInner;
+            const Real* corrRow = corr[recordFactors[k]];
+            for (Size l = 0; l < k; ++l) {
+                QuantLib::Real c = corrRow[recordFactors[l]];
+                kb += 2 * c * c * ws[k] * ws[l];
             }
             // For FX risk class, results are broken down by qualifier, i.e. currency, instead of bucket, which is not
             // used for Risk_FX
             if (riskClassIsFX)
-                bucketMargins[itOuter->getQualifier()] += wsOuter;
+                bucketMargins[qualifiers[k]] += ws[k];
         }
 
         // Finally have the value of $K_b$
@@ -1317,15 +1435,14 @@ pair<map<string, QuantLib::Real>, bool> SimmCalculator::curvatureMargin(const Ne
             m.second = std::abs(m.second);
 
     bucketMargins["All"] = margin;
-    timer_.stop("curvatureMargin()");
+    timer.stop("curvatureMargin()");
     return make_pair(bucketMargins, true);
 }
 
 void SimmCalculator::calcAddMargin(const SimmSide& side, const NettingSetDetails& nettingSetDetails,
-                                   const set<Regulation>& regulations, const Crif& simmParameters) {
-    timer_.start("calcAddMargin()");
-    // Reference to SIMM results for this portfolio
-    auto& results = simmResults_[side][nettingSetDetails][regulations];
+                                   const set<Regulation>& regulations, const Crif& crif, SimmResults& results,
+                                   vector<CrifRecord>& simmParameters, ore::data::Timer& timer) const {
+    timer.start("calcAddMargin()");
 
     const bool overwrite = false;
 
@@ -1338,7 +1455,7 @@ void SimmCalculator::calcAddMargin(const SimmSide& side, const NettingSetDetails
     // risk type, for the portfolio
     auto pc = ProductClass::Empty;
     auto rt = RiskType::ProductClassMultiplier;
-    auto pIt = simmParameters.filterBy(nettingSetDetails, pc, rt);
+    auto pIt = crif.filterBy(nettingSetDetails, pc, rt);
 
     for (auto sit = pIt.first; sit != pIt.second; sit++) {
         CrifRecord it = sit->toCrifRecord();
@@ -1350,65 +1467,61 @@ void SimmCalculator::calcAddMargin(const SimmSide& side, const NettingSetDetails
             QL_REQUIRE(factor >= 0.0, "SIMM Calculator: Amount for risk type "
                                           << rt << " must be greater than or equal to 0 but we got " << factor);
             QuantLib::Real pcmMargin = (factor - 1.0) * im;
-            add(nettingSetDetails, regulations, qpc, RiskClass::All, MarginType::AdditionalIM, "All", pcmMargin, side,
+            add(results, nettingSetDetails, qpc, RiskClass::All, MarginType::AdditionalIM, "All", pcmMargin, side,
                 overwrite);
 
             // Add to aggregation at margin type level
-            add(nettingSetDetails, regulations, qpc, RiskClass::All, MarginType::All, "All", pcmMargin, side,
+            add(results, nettingSetDetails, qpc, RiskClass::All, MarginType::All, "All", pcmMargin, side,
                 overwrite);
             // Add to aggregation at product class level
-            add(nettingSetDetails, regulations, ProductClass::All, RiskClass::All, MarginType::AdditionalIM, "All",
+            add(results, nettingSetDetails, ProductClass::All, RiskClass::All, MarginType::AdditionalIM, "All",
                 pcmMargin, side, overwrite);
             // Add to aggregation at portfolio level
-            add(nettingSetDetails, regulations, ProductClass::All, RiskClass::All, MarginType::All, "All", pcmMargin,
+            add(results, nettingSetDetails, ProductClass::All, RiskClass::All, MarginType::All, "All", pcmMargin,
                 side, overwrite);
             CrifRecord spRecord = it;
             if (side == SimmSide::Call)
                 spRecord.collectRegulations = regulations;
             else
                 spRecord.postRegulations = regulations;
-            if (!simmParameters_)
-                simmParameters_ = QuantLib::ext::make_shared<Crif>();
-            simmParameters_->addRecord(spRecord);
+            simmParameters.push_back(spRecord);
         }
     }
 
     // Second, add fixed amounts IM, using "AddOnFixedAmount" risk type, for the portfolio
-    pIt = simmParameters.filterBy(nettingSetDetails, pc, RiskType::AddOnFixedAmount);
+    pIt = crif.filterBy(nettingSetDetails, pc, RiskType::AddOnFixedAmount);
     for (auto sit = pIt.first; sit != pIt.second; sit++) {
         CrifRecord it = sit->toCrifRecord();
         QuantLib::Real fixedMargin = it.amountResultCcy;
-        add(nettingSetDetails, regulations, ProductClass::AddOnFixedAmount, RiskClass::All, MarginType::AdditionalIM,
+        add(results, nettingSetDetails, ProductClass::AddOnFixedAmount, RiskClass::All, MarginType::AdditionalIM,
             "All", fixedMargin, side, overwrite);
 
         // Add to aggregation at margin type level
-        add(nettingSetDetails, regulations, ProductClass::AddOnFixedAmount, RiskClass::All, MarginType::All, "All",
+        add(results, nettingSetDetails, ProductClass::AddOnFixedAmount, RiskClass::All, MarginType::All, "All",
             fixedMargin, side, overwrite);
         // Add to aggregation at product class level
-        add(nettingSetDetails, regulations, ProductClass::All, RiskClass::All, MarginType::AdditionalIM, "All",
+        add(results, nettingSetDetails, ProductClass::All, RiskClass::All, MarginType::AdditionalIM, "All",
             fixedMargin, side, overwrite);
         // Add to aggregation at portfolio level
-        add(nettingSetDetails, regulations, ProductClass::All, RiskClass::All, MarginType::All, "All", fixedMargin,
+        add(results, nettingSetDetails, ProductClass::All, RiskClass::All, MarginType::All, "All", fixedMargin,
             side, overwrite);
         CrifRecord spRecord = it;
         if (side == SimmSide::Call)
             spRecord.collectRegulations = regulations;
         else
             spRecord.postRegulations = regulations;
-        if (!simmParameters_)
-            simmParameters_ = QuantLib::ext::make_shared<Crif>();
-        simmParameters_->addRecord(spRecord);
+        simmParameters.push_back(spRecord);
     }
 
     // Third, add percentage of notional amounts IM, using "AddOnNotionalFactor"
     // and "Notional" risk types, for the portfolio.
-    pIt = simmParameters.filterBy(nettingSetDetails, pc, RiskType::AddOnNotionalFactor);
+    pIt = crif.filterBy(nettingSetDetails, pc, RiskType::AddOnNotionalFactor);
     for (auto sit = pIt.first; sit != pIt.second; sit++) {
         CrifRecord it = sit->toCrifRecord();
 
         // We should have a single corresponding CrifRecord with risk type
         // "Notional" and the same qualifier. Search for it.
-        auto pQualifierIt = simmParameters.filterByQualifier(nettingSetDetails, pc, RiskType::Notional, it.qualifier);
+        auto pQualifierIt = crif.filterByQualifier(nettingSetDetails, pc, RiskType::Notional, it.qualifier);
         const auto count = std::distance(pQualifierIt.first, pQualifierIt.second);
         QL_REQUIRE(count < 2, "Expected either 0 or 1 elements for risk type "
                                   << RiskType::Notional << " and qualifier " << it.qualifier << " but got " << count);
@@ -1419,33 +1532,31 @@ void SimmCalculator::calcAddMargin(const SimmSide& side, const NettingSetDetails
             QuantLib::Real factor = it.amount;
             QuantLib::Real notionalFactorMargin = notional * factor / 100.0;
 
-            add(nettingSetDetails, regulations, ProductClass::AddOnNotionalFactor, RiskClass::All,
+            add(results, nettingSetDetails, ProductClass::AddOnNotionalFactor, RiskClass::All,
                 MarginType::AdditionalIM, "All", notionalFactorMargin, side, overwrite);
 
             // Add to aggregation at margin type level
-            add(nettingSetDetails, regulations, ProductClass::AddOnNotionalFactor, RiskClass::All, MarginType::All,
+            add(results, nettingSetDetails, ProductClass::AddOnNotionalFactor, RiskClass::All, MarginType::All,
                 "All", notionalFactorMargin, side, overwrite);
             // Add to aggregation at product class level
-            add(nettingSetDetails, regulations, ProductClass::All, RiskClass::All, MarginType::AdditionalIM, "All",
+            add(results, nettingSetDetails, ProductClass::All, RiskClass::All, MarginType::AdditionalIM, "All",
                 notionalFactorMargin, side, overwrite);
             // Add to aggregation at portfolio level
-            add(nettingSetDetails, regulations, ProductClass::All, RiskClass::All, MarginType::All, "All",
+            add(results, nettingSetDetails, ProductClass::All, RiskClass::All, MarginType::All, "All",
                 notionalFactorMargin, side, overwrite);
             CrifRecord spRecord = it;
             if (side == SimmSide::Call)
                 spRecord.collectRegulations = regulations;
             else
                 spRecord.postRegulations = regulations;
-            if (!simmParameters_)
-                simmParameters_ = QuantLib::ext::make_shared<Crif>();
-            simmParameters_->addRecord(spRecord);
+            simmParameters.push_back(spRecord);
         }
     }
-    timer_.stop("calcAddMargin()");
+    timer.stop("calcAddMargin()");
 }
 
 void SimmCalculator::populateResults(const SimmSide& side, const NettingSetDetails& nettingSetDetails,
-                                     const set<Regulation>& regulations) {
+                                     SimmResults& results) const {
 
     if (!quiet_) {
         LOG("SimmCalculator: Populating higher level results")
@@ -1458,9 +1569,6 @@ void SimmCalculator::populateResults(const SimmSide& side, const NettingSetDetai
 
     // Populate netting set level results for each portfolio
 
-    // Reference to SIMM results for this portfolio
-    auto& results = simmResults_[side][nettingSetDetails][regulations];
-
     // Fill in the margin within each (product class, risk class) combination
     for (const auto& pc : pcs) {
         for (const auto& rc : rcs) {
@@ -1478,7 +1586,7 @@ void SimmCalculator::populateResults(const SimmSide& side, const NettingSetDetai
 
             // Add the margin to the results if it was calculated
             if (hasRiskClass) {
-                add(nettingSetDetails, regulations, pc, rc, MarginType::All, "All", riskClassMargin, side);
+                add(results, nettingSetDetails, pc, rc, MarginType::All, "All", riskClassMargin, side);
             }
         }
     }
@@ -1516,7 +1624,7 @@ void SimmCalculator::populateResults(const SimmSide& side, const NettingSetDetai
         // Add the margin to the results if it was calculated
         if (hasProductClass) {
             productClassMargin = std::sqrt(std::max(productClassMargin, 0.0));
-            add(nettingSetDetails, regulations, pc, RiskClass::All, MarginType::All, "All", productClassMargin, side);
+            add(results, nettingSetDetails, pc, RiskClass::All, MarginType::All, "All", productClassMargin, side);
         }
     }
 
@@ -1528,7 +1636,7 @@ void SimmCalculator::populateResults(const SimmSide& side, const NettingSetDetai
             im += results.get(pc, RiskClass::All, MarginType::All, "All");
         }
     }
-    add(nettingSetDetails, regulations, ProductClass::All, RiskClass::All, MarginType::All, "All", im, side);
+    add(results, nettingSetDetails, ProductClass::All, RiskClass::All, MarginType::All, "All", im, side);
 
     // Combinations outside of the natural SIMM hierarchy
 
@@ -1566,7 +1674,7 @@ void SimmCalculator::populateResults(const SimmSide& side, const NettingSetDetai
             // Add the margin to the results if it was calculated
             if (hasPcMt) {
                 margin = std::sqrt(std::max(margin, 0.0));
-                add(nettingSetDetails, regulations, pc, RiskClass::All, mt, "All", margin, side);
+                add(results, nettingSetDetails, pc, RiskClass::All, mt, "All", margin, side);
             }
         }
     }
@@ -1591,7 +1699,7 @@ void SimmCalculator::populateResults(const SimmSide& side, const NettingSetDetai
 
             // Add the margin to the results if it was calculated
             if (hasRcMt) {
-                add(nettingSetDetails, regulations, ProductClass::All, rc, mt, "All", margin, side);
+                add(results, nettingSetDetails, ProductClass::All, rc, mt, "All", margin, side);
             }
         }
     }
@@ -1616,7 +1724,7 @@ void SimmCalculator::populateResults(const SimmSide& side, const NettingSetDetai
 
         // Add the margin to the results if it was calculated
         if (hasRc) {
-            add(nettingSetDetails, regulations, ProductClass::All, rc, MarginType::All, "All", margin, side);
+            add(results, nettingSetDetails, ProductClass::All, rc, MarginType::All, "All", margin, side);
         }
     }
 
@@ -1640,7 +1748,7 @@ void SimmCalculator::populateResults(const SimmSide& side, const NettingSetDetai
 
         // Add the margin to the results if it was calculated
         if (hasMt) {
-            add(nettingSetDetails, regulations, ProductClass::All, RiskClass::All, mt, "All", margin, side);
+            add(results, nettingSetDetails, ProductClass::All, RiskClass::All, mt, "All", margin, side);
         }
     }
 }
@@ -1698,9 +1806,9 @@ void SimmCalculator::populateFinalResults(const map<SimmSide, map<NettingSetDeta
 
 void SimmCalculator::populateFinalResults() { populateFinalResults(winningRegulations_); }
 
-void SimmCalculator::add(const NettingSetDetails& nettingSetDetails, const set<Regulation>& regulations,
-                         const ProductClass& pc, const RiskClass& rc, const MarginType& mt, const string& b,
-                         QuantLib::Real margin, SimmSide side, const bool overwrite) {
+void SimmCalculator::add(SimmResults& results, const NettingSetDetails& nettingSetDetails, const ProductClass& pc,
+                         const RiskClass& rc, const MarginType& mt, const string& b, QuantLib::Real margin,
+                         SimmSide side, const bool overwrite) const {
     if (!quiet_) {
         DLOG("Calculated " << side << " margin for [netting set details, product class, risk class, margin type] = ["
                            << "[" << NettingSetDetails(nettingSetDetails) << "]"
@@ -1708,16 +1816,15 @@ void SimmCalculator::add(const NettingSetDetails& nettingSetDetails, const set<R
     }
 
     const string& calculationCcy = side == SimmSide::Call ? calculationCcyCall_ : calculationCcyPost_;
-    simmResults_[side][nettingSetDetails][regulations].add(pc, rc, mt, b, margin, resultCcy_, calculationCcy,
-                                                           overwrite);
+    results.add(pc, rc, mt, b, margin, resultCcy_, calculationCcy, overwrite);
 }
 
-void SimmCalculator::add(const NettingSetDetails& nettingSetDetails, const set<Regulation>& regulations,
-                         const ProductClass& pc, const RiskClass& rc, const MarginType& mt,
-                         const map<string, QuantLib::Real>& margins, SimmSide side, const bool overwrite) {
+void SimmCalculator::add(SimmResults& results, const NettingSetDetails& nettingSetDetails, const ProductClass& pc,
+                         const RiskClass& rc, const MarginType& mt, const map<string, QuantLib::Real>& margins,
+                         SimmSide side, const bool overwrite) const {
 
     for (const auto& kv : margins)
-        add(nettingSetDetails, regulations, pc, rc, mt, kv.first, kv.second, side, overwrite);
+        add(results, nettingSetDetails, pc, rc, mt, kv.first, kv.second, side, overwrite);
 }
 
 void SimmCalculator::splitCrifByRegulationsAndPortfolios(const bool enforceIMRegulations,
@@ -2023,5 +2130,83 @@ QuantLib::Real SimmCalculator::fxRate(const string& ccyPair) const {
     return market_->fxRate(ccyPair)->value();
 }
 
+QuantLib::Real SimmCalculator::concentrationFxRate() const {
+    // the market is only accessed if a threshold is needed, in a parallel calculation the rate is looked up upfront
+    if (concentrationFxRate_ == Null<Real>())
+        concentrationFxRate_ = fxRate("USD" + resultCcy_);
+    return concentrationFxRate_;
+}
+
+Matrix
+SimmCalculator::bucketCorrelations(const RiskType& rt, const string& bucket, const string& calculationCcy,
+                                   const vector<RiskFactor>& factors, const vector<Size>& recordFactors,
+                                   const std::function<Real(const RiskFactor&, const RiskFactor&)>& correlation) const {
+
+    // Mark the required entries, i.e. the pairs of risk factors of two different records
+    Matrix result(factors.size(), factors.size(), Null<Real>());
+    vector<pair<Size, Size>> required;
+    for (Size i = 1; i < recordFactors.size(); ++i) {
+        for (Size j = 0; j < i; ++j) {
+            Real& c = result[recordFactors[i]][recordFactors[j]];
+            if (c == Null<Real>()) {
+                c = 0.0;
+                required.push_back(make_pair(recordFactors[i], recordFactors[j]));
+            }
+        }
+    }
+    if (required.empty())
+        return result;
+
+    // Read the cached correlations, the cache is shared between the threads of a parallel calculation
+    vector<Size> index(factors.size(), Null<Size>());
+    BucketCorrelations* cache;
+    {
+        std::lock_guard<std::mutex> lock(bucketCorrelationsMutex_);
+        cache = &bucketCorrelations_[make_tuple(rt, bucket, calculationCcy)];
+
+        // Index of the risk factors in the cache, null if the cache is full
+        for (Size i = 0; i < factors.size(); ++i) {
+            if (auto f = cache->index.find(factors[i]); f != cache->index.end()) {
+                index[i] = f->second;
+            } else if (cache->index.size() < maxCachedRiskFactors) {
+                index[i] = cache->index.size();
+                cache->index[factors[i]] = index[i];
+                for (auto& row : cache->correlation)
+                    row.push_back(Null<Real>());
+                cache->correlation.push_back(vector<Real>(index[i] + 1, Null<Real>()));
+            }
+        }
+
+        for (const auto& [i, j] : required) {
+            if (index[i] != Null<Size>() && index[j] != Null<Size>())
+                result[i][j] = cache->correlation[index[i]][index[j]];
+            else
+                result[i][j] = Null<Real>();
+        }
+    }
+
+    // Compute the missing correlations without holding the lock
+    vector<pair<Size, Size>> computed;
+    for (const auto& [i, j] : required) {
+        if (result[i][j] == Null<Real>()) {
+            result[i][j] = correlation(factors[i], factors[j]);
+            if (index[i] != Null<Size>() && index[j] != Null<Size>())
+                computed.push_back(make_pair(i, j));
+        }
+    }
+
+    // Add them to the cache, another thread might have added the same correlations in the meantime
+    if (!computed.empty()) {
+        std::lock_guard<std::mutex> lock(bucketCorrelationsMutex_);
+        for (const auto& [i, j] : computed) {
+            Real& c = cache->correlation[index[i]][index[j]];
+            if (c == Null<Real>())
+                c = result[i][j];
+        }
+    }
+
+    return result;
+}
+
 } // namespace analytics
 } // namespace ore
@@ -28,7 +28,13 @@
 #include <ored/utilities/timer.hpp>
 #include <ored/marketdata/market.hpp>
 
+#include <ql/math/matrix.hpp>
+
+#include <functional>
 #include <map>
+#include <mutex>
+#include <tuple>
+#include <vector>
 
 namespace ore {
 namespace analytics {
@@ -46,6 +52,9 @@ public:
         \p calculationCcy is not USD then the \p usdSpot parameter must be used to
         give the FX spot rate between USD and the \p calculationCcy. This spot rate is
         interpreted as the number of USD per unit of \p calculationCcy.
+
+        If \p nThreads is greater than 1, the SIMM for the different sides, netting sets and regulations is calculated
+        concurrently on up to \p nThreads threads. The results are the same as for the serial calculation.
     */
     SimmCalculator(const QuantLib::ext::shared_ptr<ore::analytics::Crif>& crif,
                    const QuantLib::ext::shared_ptr<SimmConfiguration>& simmConfiguration,
@@ -56,7 +65,8 @@ public:
                    const bool determineWinningRegulations = true, const bool enforceIMRegulations = false,
                    const bool quiet = false,
                    const std::map<SimmSide, std::set<NettingSetDetails>>& hasSEC =
-                       std::map<SimmSide, std::set<NettingSetDetails>>());
+                       std::map<SimmSide, std::set<NettingSetDetails>>(),
+                   const QuantLib::Size nThreads = 1);
 
     //! Calculates SIMM for a given regulation under a given netting set
     const void calculateRegulationSimm(const ore::analytics::Crif& crif, const ore::data::NettingSetDetails& nsd,
@@ -165,20 +175,51 @@ private:
 
     mutable ore::data::Timer timer_;
 
+    //! Risk factor (qualifier, label1, label2) within a bucket
+    typedef std::tuple<std::string, std::string, std::string> RiskFactor;
+
+    /*! Correlations between the risk factors of a risk type within a bucket for a calculation currency. The risk
+        factors are numbered in the order they are first seen, a correlation is computed on first use and then shared
+        between the sides, netting sets and regulations of the calculation. Null<Real>() marks correlations that have
+        not been computed yet.
+    */
+    struct BucketCorrelations {
+        std::map<RiskFactor, QuantLib::Size> index;
+        std::vector<std::vector<QuantLib::Real>> correlation;
+    };
+    //       risk type, bucket,      calculation currency
+    mutable std::map<std::tuple<RiskType, std::string, std::string>, BucketCorrelations> bucketCorrelations_;
+    mutable std::mutex bucketCorrelationsMutex_;
+
+    /*! FX rate converting the USD concentration thresholds to the result currency, looked up on first use, or before
+        the regulations are calculated on several threads */
+    mutable QuantLib::Real concentrationFxRate_ = QuantLib::Null<QuantLib::Real>();
+
+    /*! Calculates SIMM for a given regulation under a given netting set into \p results, the SIMM parameters used in
+        the calculation are appended to \p simmParameters and the run times are recorded in \p timer
+    */
+    void calculateRegulationSimm(const ore::analytics::Crif& crif, const ore::data::NettingSetDetails& nsd,
+                                 const std::set<CrifRecord::Regulation>& regulation, const SimmSide& side,
+                                 SimmResults& results, std::vector<CrifRecord>& simmParameters,
+                                 ore::data::Timer& timer) const;
+
+    //! Add the given records to the record of SIMM parameters that were used in the calculation
+    void addSimmParameters(const std::vector<CrifRecord>& simmParameters);
+
     //! Calculate the Interest Rate delta margin component for the given portfolio and product class
     std::pair<std::map<std::string, QuantLib::Real>, bool>
     irDeltaMargin(const ore::data::NettingSetDetails& nettingSetDetails, const CrifRecord::ProductClass& pc,
-                  const ore::analytics::Crif& netRecords, const SimmSide& side) const;
+                  const ore::analytics::Crif& netRecords, const SimmSide& side, ore::data::Timer& timer) const;
 
     //! Calculate the Interest Rate vega margin component for the given portfolio and product class
     std::pair<std::map<std::string, QuantLib::Real>, bool>
     irVegaMargin(const ore::data::NettingSetDetails& nettingSetDetails, const CrifRecord::ProductClass& pc,
-                 const ore::analytics::Crif& netRecords, const SimmSide& side) const;
+                 const ore::analytics::Crif& netRecords, const SimmSide& side, ore::data::Timer& timer) const;
 
     //! Calculate the Interest Rate curvature margin component for the given portfolio and product class
     std::pair<std::map<std::string, QuantLib::Real>, bool>
     irCurvatureMargin(const ore::data::NettingSetDetails& nettingSetDetails, const CrifRecord::ProductClass& pc,
-                      const SimmSide& side, const ore::analytics::Crif& crif) const;
+                      const SimmSide& side, const ore::analytics::Crif& crif, ore::data::Timer& timer) const;
 
     /*! Calculate the (delta or vega) margin component for the given portfolio, product class and risk type
         Used to calculate delta or vega or base correlation margin for all risk types except IR, IRVol
@@ -188,7 +229,7 @@ private:
                                                                   const CrifRecord::ProductClass& pc,
                                                                   const RiskType& rt,
                                                                   const ore::analytics::Crif& netRecords,
-                                                                  const SimmSide& side) const;
+                                                                  const SimmSide& side, ore::data::Timer& timer) const;
 
     /*! Calculate the curvature margin component for the given portfolio, product class and risk type
         Used to calculate curvature margin for all risk types except IR
@@ -196,37 +237,37 @@ private:
     std::pair<std::map<std::string, QuantLib::Real>, bool>
     curvatureMargin(const ore::data::NettingSetDetails& nettingSetDetails, const CrifRecord::ProductClass& pc,
                     const RiskType& rt, const SimmSide& side, const ore::analytics::Crif& netRecords,
-                    bool rfLabels = true) const;
+                    ore::data::Timer& timer, bool rfLabels = true) const;
 
     //! Calculate the additional initial margin for the portfolio ID and regulation
     void calcAddMargin(const SimmSide& side, const ore::data::NettingSetDetails& nsd,
-                       const std::set<CrifRecord::Regulation>& regulation, const ore::analytics::Crif& simmParameters);
+                       const std::set<CrifRecord::Regulation>& regulation, const ore::analytics::Crif& crif,
+                       SimmResults& results, std::vector<CrifRecord>& simmParameters, ore::data::Timer& timer) const;
 
     /*! Populate the results structure with the higher level results after the IMs have been
         calculated at the (product class, risk class, margin type) level for the given
         regulation under the given portfolio
     */
-    void populateResults(const SimmSide& side, const ore::data::NettingSetDetails& nsd, const std::set<CrifRecord::Regulation>& regulation);
+    void populateResults(const SimmSide& side, const ore::data::NettingSetDetails& nsd, SimmResults& results) const;
 
     /*! Populate final (i.e. winning regulators') using own list of winning regulators, which were determined
         solely by the SIMM results (i.e. not including any external IMSchedule results)
     */
     void populateFinalResults();
 
-    /*! Add a margin result to either call or post results container depending on the
-        \p side parameter.
+    /*! Add a margin result for the given netting set and \p side to the \p results container
 
         \remark all additions to the results containers should happen in this method
     */
-    void add(const ore::data::NettingSetDetails& nettingSetDetails, const std::set<CrifRecord::Regulation>& regulation,
+    void add(SimmResults& results, const ore::data::NettingSetDetails& nettingSetDetails,
              const CrifRecord::ProductClass& pc, const SimmConfiguration::RiskClass& rc,
              const SimmConfiguration::MarginType& mt, const std::string& b, QuantLib::Real margin, SimmSide side,
-             const bool overwrite = true);
+             const bool overwrite = true) const;
 
-    void add(const ore::data::NettingSetDetails& nettingSetDetails, const std::set<CrifRecord::Regulation>& regulation,
+    void add(SimmResults& results, const ore::data::NettingSetDetails& nettingSetDetails,
              const CrifRecord::ProductClass& pc, const SimmConfiguration::RiskClass& rc,
              const SimmConfiguration::MarginType& mt, const std::map<std::string, QuantLib::Real>& margins, SimmSide side,
-             const bool overwrite = true);
+             const bool overwrite = true) const;
 
     //! Add CRIF record to the CRIF records container that correspondsd to the given regulation/s and portfolio ID
     void splitCrifByRegulationsAndPortfolios(const bool enforceIMRegulations,
@@ -243,6 +284,19 @@ private:
                                         const std::vector<RiskType>& riskTypes) const;
 
     QuantLib::Real fxRate(const std::string& ccyPair) const;
+
+    //! FX rate converting the USD concentration thresholds to the result currency
+    QuantLib::Real concentrationFxRate() const;
+
+    /*! Correlations between the given risk factors of risk type \p rt in \p bucket, where the i-th record of the
+        bucket has the risk factor recordFactors[i]. The returned matrix has an entry (recordFactors[i],
+        recordFactors[j]) for j < i, given by \p correlation or taken from the cached bucket correlations, all other
+        entries are Null<Real>().
+    */
+    QuantLib::Matrix
+    bucketCorrelations(const RiskType& rt, const std::string& bucket, const std::string& calculationCcy,
+                       const std::vector<RiskFactor>& factors, const std::vector<QuantLib::Size>& recordFactors,
+                       const std::function<QuantLib::Real(const RiskFactor&, const RiskFactor&)>& correlation) const;
 };
 
 } // namespace analytics
@@ -0,0 +1,199 @@
+/*
+ Copyright (C) 2025 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+#include <boost/test/unit_test.hpp>
+#include <orea/app/analytic.hpp>
+#include <orea/app/analyticsmanager.hpp>
+#include <orea/app/inputparameters.hpp>
+#include <orea/app/marketdataloader.hpp>
+#include <orea/engine/sensitivitystream.hpp>
+#include <ored/report/inmemoryreport.hpp>
+#include <oret/toplevelfixture.hpp>
+#include <ql/settings.hpp>
+#include <test/oreatoplevelfixture.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+using namespace QuantLib;
+using namespace ore::analytics;
+using namespace ore::data;
+
+namespace {
+
+// the start and end of the analytic runs, in the order they happened
+struct RunLog {
+    Size position(const std::string& event) const {
+        auto it = std::find(events.begin(), events.end(), event);
+        BOOST_REQUIRE_MESSAGE(it != events.end(), "event '" << event << "' not found");
+        return std::distance(events.begin(), it);
+    }
+    std::mutex mutex;
+    std::vector<std::string> events;
+    std::map<std::string, bool> consistent;
+};
+
+/* Runs its dependent analytics, then changes the inputs and checks that they are not changed by other analytics while
+   it is running. Also checks that it sees the evaluation date of the thread that started the run. */
+class TestAnalyticImpl : public Analytic::Impl {
+public:
+    TestAnalyticImpl(const QuantLib::ext::shared_ptr<InputParameters>& inputs, const std::string& label,
+                     const Real threshold, const std::vector<QuantLib::ext::shared_ptr<Analytic>>& dependents,
+                     RunLog& log)
+        : Analytic::Impl(inputs), threshold_(threshold), dependents_(dependents), log_(log) {
+        setLabel(label);
+    }
+    void buildDependencies() override {
+        for (Size i = 0; i < dependents_.size(); ++i)
+            addDependentAnalytic("dependent_" + std::to_string(i), dependents_[i]);
+    }
+    void runAnalytic(const QuantLib::ext::shared_ptr<InMemoryLoader>& loader,
+                     const std::set<std::string>& runTypes) override {
+        for (auto const& d : dependents_)
+            d->runAnalytic(loader);
+        {
+            std::lock_guard<std::mutex> lock(log_.mutex);
+            log_.events.push_back(label() + " start");
+        }
+        bool consistent = Settings::instance().evaluationDate() == Date(15, January, 2025);
+        inputs_->setSensiThreshold(threshold_);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        consistent = consistent && inputs_->sensiThreshold() == threshold_;
+        auto report = QuantLib::ext::make_shared<InMemoryReport>();
+        report->addColumn("Label", string()).next().add(label()).end();
+        analytic()->addReport(label(), "run", report);
+        {
+            std::lock_guard<std::mutex> lock(log_.mutex);
+            log_.events.push_back(label() + " end");
+            log_.consistent[label()] = consistent;
+        }
+    }
+
+private:
+    Real threshold_;
+    std::vector<QuantLib::ext::shared_ptr<Analytic>> dependents_;
+    RunLog& log_;
+};
+
+class TestAnalytic : public Analytic {
+public:
+    TestAnalytic(const QuantLib::ext::shared_ptr<InputParameters>& inputs,
+                 const QuantLib::ext::weak_ptr<AnalyticsManager>& analyticsManager, const std::string& label,
+                 const Real threshold, RunLog& log,
+                 const std::vector<QuantLib::ext::shared_ptr<Analytic>>& dependents = {})
+        : Analytic(std::make_unique<TestAnalyticImpl>(inputs, label, threshold, dependents, log), {label}, inputs,
+                   analyticsManager) {}
+    bool requiresMarketData() const override { return false; }
+};
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(OREAnalyticsTestSuite, ore::test::OreaTopLevelFixture)
+
+BOOST_AUTO_TEST_SUITE(AnalyticsManagerTest)
+
+BOOST_AUTO_TEST_CASE(testConcurrentAnalytics) {
+
+    BOOST_TEST_MESSAGE("Testing running analytics concurrently...");
+
+    Settings::instance().evaluationDate() = Date(15, January, 2025);
+
+    for (Size nThreads : {1, 4}) {
+
+        BOOST_TEST_MESSAGE("analyticsThreads = " << nThreads);
+
+        auto inputs = QuantLib::ext::make_shared<InputParameters>();
+        inputs->setAnalyticsThreads(nThreads);
+        auto manager =
+            QuantLib::ext::make_shared<AnalyticsManager>(inputs, QuantLib::ext::make_shared<MarketDataLoader>(inputs));
+        manager->initialise();
+
+        /* A does not depend on any other analytic, B and C share the dependent analytic D, so that B and D are run
+           before C */
+        RunLog log;
+        auto d = QuantLib::ext::make_shared<TestAnalytic>(inputs, manager, "D", 0.4, log);
+        std::vector<QuantLib::ext::shared_ptr<Analytic>> analytics = {
+            QuantLib::ext::make_shared<TestAnalytic>(inputs, manager, "A", 0.1, log),
+            QuantLib::ext::make_shared<TestAnalytic>(inputs, manager, "B", 0.2, log,
+                                                     std::vector<QuantLib::ext::shared_ptr<Analytic>>{d}),
+            QuantLib::ext::make_shared<TestAnalytic>(inputs, manager, "C", 0.3, log,
+                                                     std::vector<QuantLib::ext::shared_ptr<Analytic>>{d})};
+        for (auto const& a : analytics) {
+            a->initialise();
+            manager->addAnalytic(a->label(), a);
+        }
+
+        manager->runAnalytics();
+
+        BOOST_CHECK(manager->failedAnalytics().empty());
+        BOOST_REQUIRE_EQUAL(log.events.size(), 8);
+        for (auto const& label : {"A", "B", "C", "D"}) {
+            BOOST_CHECK_MESSAGE(log.consistent[label], "analytic " << label << " saw a change of its inputs or a "
+                                                                   << "different evaluation date");
+        }
+        BOOST_CHECK_LT(log.position("D end"), log.position("B start"));
+        BOOST_CHECK_LT(log.position("B end"), log.position("C start"));
+
+        auto reports = manager->reports();
+        for (auto const& label : {"A", "B", "C"})
+            BOOST_CHECK(reports.find(label) != reports.end());
+
+        // after the run the analytics have the inputs of the manager again
+        for (auto const& a : analytics)
+            BOOST_CHECK(a->inputs() == inputs);
+        BOOST_CHECK(d->inputs() == inputs);
+
+#ifdef QL_ENABLE_SESSIONS
+        // the analytics changed copies of the inputs in the concurrent run, in the sequential run the last one wins
+        BOOST_CHECK_CLOSE(inputs->sensiThreshold(), nThreads > 1 ? 1E-6 : 0.3, 1E-10);
+#else
+        BOOST_CHECK_CLOSE(inputs->sensiThreshold(), 0.3, 1E-10);
+#endif
+    }
+}
+
+BOOST_AUTO_TEST_CASE(testCopiedInputsReadOwnStreams) {
+
+    BOOST_TEST_MESSAGE("Testing that copies of the inputs read their own sensitivity stream...");
+
+    auto inputs = QuantLib::ext::make_shared<InputParameters>();
+    inputs->setSensitivityStreamFromBuffer(
+        "#TradeId,IsPar,Factor_1,ShiftSize_1,Factor_2,ShiftSize_2,Currency,Base NPV,Delta,Gamma\n"
+        "trade_1,false,DiscountCurve/EUR/0/1Y,0.0001,,,EUR,100.0,1.5,0.1\n"
+        "trade_2,false,DiscountCurve/EUR/1/2Y,0.0001,,,EUR,200.0,2.5,0.2\n");
+    auto copy = inputs->copy();
+    BOOST_REQUIRE(copy->sensitivityStream());
+    BOOST_CHECK(copy->sensitivityStream() != inputs->sensitivityStream());
+
+    // reading the original stream to its end does not move the position of the copy
+    while (inputs->sensitivityStream()->next())
+        ;
+    auto record = copy->sensitivityStream()->next();
+    BOOST_CHECK_EQUAL(record.tradeId, "trade_1");
+    BOOST_CHECK_CLOSE(record.delta, 1.5, 1E-10);
+    record = copy->sensitivityStream()->next();
+    BOOST_CHECK_EQUAL(record.tradeId, "trade_2");
+    BOOST_CHECK(!copy->sensitivityStream()->next());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE_END()
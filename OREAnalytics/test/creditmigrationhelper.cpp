@@ -0,0 +1,186 @@
+/*
+ Copyright (C) 2025 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+#include <boost/test/unit_test.hpp>
+#include <orea/aggregation/creditmigrationhelper.hpp>
+#include <orea/aggregation/creditsimulationparameters.hpp>
+#include <orea/cube/inmemorycube.hpp>
+#include <orea/scenario/aggregationscenariodata.hpp>
+#include <ored/portfolio/trade.hpp>
+#include <oret/toplevelfixture.hpp>
+#include <qle/utilities/workerpool.hpp>
+#include <test/oreatoplevelfixture.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+using namespace std;
+using namespace QuantLib;
+using namespace ore::analytics;
+using namespace ore::data;
+
+namespace {
+
+const Date asof(15, January, 2025);
+const vector<Date> cubeDates = {Date(15, January, 2026), Date(15, January, 2027), Date(15, January, 2028)};
+const Size samples = 40;
+const Size nStates = 3;
+const Size cubeIndexCashflows = 1, cubeIndexStateNpvs = 2;
+
+// a trade with issuer and counterparty, it is never built
+class TestTrade : public Trade {
+public:
+    TestTrade(const string& id, const string& issuer, const Envelope& env) : Trade("TestTrade", env) {
+        this->id() = id;
+        issuer_ = issuer;
+    }
+    void build(const QuantLib::ext::shared_ptr<EngineFactory>&) override {}
+};
+
+QuantLib::ext::shared_ptr<CreditSimulationParameters> parameters() {
+    auto p = QuantLib::ext::make_shared<CreditSimulationParameters>();
+    Matrix m(nStates, nStates, 0.0);
+    std::vector<Real> rows = {0.90, 0.08, 0.02, 0.05, 0.90, 0.05, 0.0, 0.0, 1.0};
+    std::copy(rows.begin(), rows.end(), m.begin());
+    p->transitionMatrix()["TM"] = m;
+    p->entities() = {"ISSUER_A", "CPTY_B"};
+    p->factorLoadings() = {Array(1, 0.5), Array(1, 0.4)};
+    p->transitionMatrices() = {"TM", "TM"};
+    p->initialStates() = {0, 1};
+    p->marketRisk() = true;
+    p->creditRisk() = true;
+    p->zeroMarketPnl() = false;
+    p->evaluation() = "TerminalSimulation";
+    p->doubleDefault() = false;
+    p->seed() = 42;
+    p->paths() = 50;
+    p->creditMode() = "Migration";
+    p->loanExposureMode() = "Value";
+    p->nettingSetIds() = {"NS_B"};
+    return p;
+}
+
+/* T1 has issuer risk on ISSUER_A, T2 is a derivative with CPTY_B in the netting set NS_B. The npvs, cashflows and
+   global factor vary by path and date. */
+std::map<string, QuantLib::ext::shared_ptr<Trade>> trades() {
+    return {{"T1", QuantLib::ext::make_shared<TestTrade>("T1", "ISSUER_A", Envelope("CPTY_C", std::string("NS_C")))},
+            {"T2", QuantLib::ext::make_shared<TestTrade>("T2", "", Envelope("CPTY_B", std::string("NS_B")))}};
+}
+
+QuantLib::ext::shared_ptr<NPVCube> cube() {
+    QuantLib::ext::shared_ptr<NPVCube> cube = QuantLib::ext::make_shared<DoublePrecisionInMemoryCube>(
+        asof, std::set<string>{"T1", "T2"}, cubeDates, samples, cubeIndexStateNpvs + nStates);
+    for (auto const& [id, scale] : {std::make_pair(string("T1"), 10.0), std::make_pair(string("T2"), 4.0)}) {
+        cube->setT0(scale, id, 0);
+        cube->setT0(0.1 * scale, id, cubeIndexCashflows);
+        for (Size d = 0; d < cubeDates.size(); ++d) {
+            for (Size s = 0; s < samples; ++s) {
+                Real npv = scale * (1.0 + 0.2 * std::sin(0.7 * s + 1.3 * d));
+                cube->set(npv, id, cubeDates[d], s, 0);
+                cube->set(0.05 * scale, id, cubeDates[d], s, cubeIndexCashflows);
+                for (Size j = 0; j < nStates; ++j)
+                    cube->set(npv * (1.0 - 0.3 * j), id, cubeDates[d], s, cubeIndexStateNpvs + j);
+            }
+        }
+    }
+    return cube;
+}
+
+QuantLib::ext::shared_ptr<NPVCube> nettedCube() {
+    QuantLib::ext::shared_ptr<NPVCube> cube =
+        QuantLib::ext::make_shared<DoublePrecisionInMemoryCube>(asof, std::set<string>{"NS_B"}, cubeDates, samples);
+    for (Size d = 0; d < cubeDates.size(); ++d) {
+        for (Size s = 0; s < samples; ++s)
+            cube->set(3.0 * std::sin(0.9 * s + d), "NS_B", cubeDates[d], s);
+    }
+    return cube;
+}
+
+QuantLib::ext::shared_ptr<AggregationScenarioData> aggData() {
+    auto aggData = QuantLib::ext::make_shared<InMemoryAggregationScenarioData>(cubeDates.size(), samples);
+    for (Size d = 0; d < cubeDates.size(); ++d) {
+        for (Size s = 0; s < samples; ++s)
+            aggData->set(d, s, std::sqrt(d + 1.0) * 1.5 * std::sin(1.7 * s + 0.4 * d),
+                         AggregationScenarioDataType::CreditState, "0");
+    }
+    return aggData;
+}
+
+QuantLib::ext::shared_ptr<CreditMigrationHelper>
+helper(const QuantLib::ext::shared_ptr<QuantExt::WorkerPool>& workerPool) {
+    auto h = QuantLib::ext::make_shared<CreditMigrationHelper>(parameters(), cube(), nettedCube(), aggData(),
+                                                               cubeIndexCashflows, cubeIndexStateNpvs, -20.0, 20.0, 41,
+                                                               Matrix(1, 1, 1.0), "EUR", workerPool);
+    h->build(trades());
+    return h;
+}
+
+void checkEqual(const Array& a, const Array& b, const string& label) {
+    BOOST_REQUIRE_EQUAL(a.size(), b.size());
+    BOOST_CHECK_MESSAGE(std::equal(a.begin(), a.end(), b.begin()), "distributions differ: " << label);
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(OREAnalyticsTestSuite, ore::test::OreaTopLevelFixture)
+
+BOOST_AUTO_TEST_SUITE(CreditMigrationHelperTest)
+
+BOOST_AUTO_TEST_CASE(testTerminalSimulationPnlDistributions) {
+
+    BOOST_TEST_MESSAGE("Testing credit migration pnl distributions in terminal simulation mode...");
+
+    // 40 paths, i.e. two full blocks of 16 paths and a partial block of 8
+    auto serial = helper(QuantLib::ext::make_shared<QuantExt::WorkerPool>(1));
+    auto parallel = helper(QuantLib::ext::make_shared<QuantExt::WorkerPool>(4));
+
+    std::vector<Array> reference = serial->pnlDistributions({0, 1, 2});
+    BOOST_REQUIRE_EQUAL(reference.size(), 3);
+    for (Size d = 0; d < 3; ++d) {
+        // the distribution is a probability distribution and not a point mass
+        Real sum = std::accumulate(reference[d].begin(), reference[d].end(), 0.0);
+        BOOST_CHECK_CLOSE(sum, 1.0, 1E-10);
+        BOOST_CHECK_LT(*std::max_element(reference[d].begin(), reference[d].end()), 0.99);
+    }
+    BOOST_CHECK_MESSAGE(!std::equal(reference[0].begin(), reference[0].end(), reference[2].begin()),
+                        "distributions for dates 0 and 2 should differ");
+
+    // the result does not depend on the number of threads
+    std::vector<Array> parallelReference = parallel->pnlDistributions({0, 1, 2});
+    for (Size d = 0; d < 3; ++d)
+        checkEqual(parallelReference[d], reference[d], "1 vs 4 threads, date " + std::to_string(d));
+
+    // nor on the dates requested together or their order
+    for (auto const& h : {serial, parallel}) {
+        std::vector<Array> reversed = h->pnlDistributions({2, 0});
+        BOOST_REQUIRE_EQUAL(reversed.size(), 2);
+        checkEqual(reversed[0], reference[2], "dates {2, 0}, date 2");
+        checkEqual(reversed[1], reference[0], "dates {2, 0}, date 0");
+        checkEqual(h->pnlDistribution(1), reference[1], "single date 1");
+        std::vector<Array> repeated = h->pnlDistributions({1, 2, 1});
+        BOOST_REQUIRE_EQUAL(repeated.size(), 3);
+        checkEqual(repeated[0], reference[1], "dates {1, 2, 1}, date 1");
+        checkEqual(repeated[1], reference[2], "dates {1, 2, 1}, date 2");
+        checkEqual(repeated[2], reference[1], "dates {1, 2, 1}, second date 1");
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -19,9 +19,13 @@
 #include <boost/filesystem.hpp>
 #include <boost/test/unit_test.hpp>
 #include <orea/cube/inmemorycube.hpp>
+#include <orea/cube/contiguousinmemorycube.hpp>
 #include <orea/cube/cube_io.hpp>
 #include <orea/cube/npvcube.hpp>
 #include <orea/cube/jaggedcube.hpp>
+#include <orea/cube/mappednpvcube.hpp>
+#include <orea/cube/sensicube.hpp>
+#include <orea/cube/sensitivitycube.hpp>
 #include <orea/engine/filteredsensitivitystream.hpp>
 #include <orea/engine/observationmode.hpp>
 #include <orea/engine/parametricvar.hpp>
@@ -142,6 +146,53 @@ void testCubeFileIO(QuantLib::ext::shared_ptr<NPVCube> cube, const std::string&
     checkCube(*cube2, tolerance);
 }
 
+template <class T>
+void testCubeBinaryFileIO(QuantLib::ext::shared_ptr<NPVCube> cube, const std::string& cubeName, Real tolerance) {
+
+    initCube(*cube);
+    for (Size i = 0; i < cube->numIds(); ++i)
+        for (Size d = 0; d < cube->depth(); ++d)
+            cube->setT0(i * 10.0 + d, i, d);
+
+    // get a random filename with extension .bin to trigger the binary format
+    string filename = boost::filesystem::unique_path().string() + ".bin";
+    BOOST_TEST_MESSAGE("Saving cube " << cubeName << " to binary file " << filename);
+    saveCube(filename, NPVCubeWithMetaData{cube, nullptr, true, 2});
+
+    auto r = loadCube(filename);
+    auto cube2 = r.cube;
+    BOOST_CHECK(QuantLib::ext::dynamic_pointer_cast<MappedNPVCube<T>>(cube2) != nullptr);
+    BOOST_CHECK(r.scenarioGeneratorData == nullptr);
+    BOOST_REQUIRE(r.storeFlows);
+    BOOST_CHECK(*r.storeFlows);
+    BOOST_REQUIRE(r.storeCreditStateNPVs);
+    BOOST_CHECK_EQUAL(*r.storeCreditStateNPVs, Size(2));
+
+    // check dimensions, ids, dates and values
+    BOOST_CHECK_EQUAL(cube->numIds(), cube2->numIds());
+    BOOST_CHECK_EQUAL(cube->numDates(), cube2->numDates());
+    BOOST_CHECK_EQUAL(cube->samples(), cube2->samples());
+    BOOST_CHECK_EQUAL(cube->depth(), cube2->depth());
+    BOOST_CHECK(cube->idsAndIndexes() == cube2->idsAndIndexes());
+    BOOST_CHECK(cube->dates() == cube2->dates());
+    BOOST_CHECK_EQUAL(cube->asof(), cube2->asof());
+    for (Size i = 0; i < cube->numIds(); ++i)
+        for (Size d = 0; d < cube->depth(); ++d)
+            BOOST_CHECK_CLOSE(cube2->getT0(i, d), i * 10.0 + d, tolerance);
+    checkCube(*cube2, tolerance);
+
+    // the mapping is copy-on-write, setting a value must not change the file
+    cube2->set(42.0, 0, 0, 0, 0);
+    BOOST_CHECK_CLOSE(cube2->get(0, 0, 0, 0), 42.0, tolerance);
+    auto cube3 = loadCube(filename).cube;
+    checkCube(*cube3, tolerance);
+
+    cube2.reset();
+    cube3.reset();
+    r.cube.reset();
+    boost::filesystem::remove(filename);
+}
+
 void testCubeGetSetbyDateID(NPVCube& cube, Real tolerance) {
     std::map<string, Size> ids = cube.idsAndIndexes();
     vector<Date> dates = cube.dates();
@@ -164,6 +215,49 @@ void testCubeGetSetbyDateID(NPVCube& cube, Real tolerance) {
     }
 }
 
+void testCubeBulkAccessors(NPVCube& cube, Real tolerance) {
+    initCube(cube);
+    vector<Real> values;
+    for (Size i = 0; i < cube.numIds(); ++i) {
+        for (Size j = 0; j < cube.numDates(); ++j) {
+            for (Size d = 0; d < cube.depth(); ++d) {
+                cube.getSamples(values, i, j, d);
+                BOOST_REQUIRE_EQUAL(values.size(), cube.samples());
+                for (Size k = 0; k < cube.samples(); ++k)
+                    BOOST_CHECK_CLOSE(values[k], cube.get(i, j, k, d), tolerance);
+            }
+        }
+    }
+    for (Size j = 0; j < cube.numDates(); ++j) {
+        for (Size k = 0; k < cube.samples(); ++k) {
+            for (Size d = 0; d < cube.depth(); ++d) {
+                cube.getIds(values, j, k, d);
+                BOOST_REQUIRE_EQUAL(values.size(), cube.numIds());
+                for (Size i = 0; i < cube.numIds(); ++i)
+                    BOOST_CHECK_CLOSE(values[i], cube.get(i, j, k, d), tolerance);
+            }
+        }
+    }
+    // overwrite the samples of one (id, date, depth) and check that the neighbours are unchanged
+    vector<Real> newValues(cube.samples());
+    for (Size k = 0; k < cube.samples(); ++k)
+        newValues[k] = -1.0 - k;
+    cube.setSamples(newValues, 1, 2, cube.depth() - 1);
+    BOOST_CHECK_THROW(cube.setSamples(vector<Real>(cube.samples() + 1), 0, 0, 0), std::exception);
+    for (Size i = 0; i < cube.numIds(); ++i) {
+        for (Size j = 0; j < cube.numDates(); ++j) {
+            for (Size k = 0; k < cube.samples(); ++k) {
+                for (Size d = 0; d < cube.depth(); ++d) {
+                    Real expected = i == 1 && j == 2 && d == cube.depth() - 1
+                                        ? -1.0 - k
+                                        : i * 1000000.0 + j + k / 1000000.0 + d * 3;
+                    BOOST_CHECK_CLOSE(expected, cube.get(i, j, k, d), tolerance);
+                }
+            }
+        }
+    }
+}
+
 void initCube(NPVCube& cube, QuantLib::ext::shared_ptr<Portfolio>& portfolio, QuantLib::ext::shared_ptr<DateGrid>& dg) {
     // Set every (i,j,k,d) node to be i*1000000 + j + (k/1000000) + d*3
     for (const auto& [id, i]: cube.idsAndIndexes()) {
@@ -461,6 +555,18 @@ BOOST_AUTO_TEST_CASE(testDoublePrecisionInMemoryCubeFileNIO) {
     testCubeFileIO<DoublePrecisionInMemoryCubeN>(c, "DoublePrecisionInMemoryCubeN", 1e-14);
 }
 
+BOOST_AUTO_TEST_CASE(testInMemoryCubeBinaryFileIO) {
+    std::set<string> ids{string("id1"), string("id2"), string("id3")};
+    Date d(1, QuantLib::Jan, 2016);
+    vector<Date> dates(20, d);
+    Size samples = 200;
+    Size depth = 3;
+    auto c1 = QuantLib::ext::make_shared<DoublePrecisionInMemoryCubeN>(d, ids, dates, samples, depth);
+    testCubeBinaryFileIO<double>(c1, "DoublePrecisionInMemoryCubeN", 1e-14);
+    auto c2 = QuantLib::ext::make_shared<SinglePrecisionInMemoryCubeN>(d, ids, dates, samples, depth);
+    testCubeBinaryFileIO<float>(c2, "SinglePrecisionInMemoryCubeN", 1e-5);
+}
+
 BOOST_AUTO_TEST_CASE(testInMemoryCubeGetSetbyDateID) {
     std::set<string> ids = {"id1", "id2", "id3"}; // the overlap doesn't matter
     Date today = Date::todaysDate();
@@ -471,6 +577,84 @@ BOOST_AUTO_TEST_CASE(testInMemoryCubeGetSetbyDateID) {
     testCubeGetSetbyDateID(cube, 1e-14);
 }
 
+BOOST_AUTO_TEST_CASE(testContiguousInMemoryCube) {
+    std::set<string> ids{string("id1"), string("id2"), string("id3")};
+    vector<Date> dates(20, Date());
+    Size samples = 100;
+    Size depth = 3;
+    for (auto layout : {ContiguousInMemoryCube<double>::Layout::TradeMajor,
+                        ContiguousInMemoryCube<double>::Layout::SampleMajor}) {
+        ContiguousInMemoryCube<double> c(Date(), ids, dates, samples, depth, layout);
+        testCube(c, "ContiguousInMemoryCube<double>", 1e-14);
+        testCubeBulkAccessors(c, 1e-14);
+    }
+    for (auto layout : {ContiguousInMemoryCube<float>::Layout::TradeMajor,
+                        ContiguousInMemoryCube<float>::Layout::SampleMajor}) {
+        ContiguousInMemoryCube<float> c(Date(), ids, dates, samples, depth, layout);
+        testCube(c, "ContiguousInMemoryCube<float>", 1e-5);
+        testCubeBulkAccessors(c, 1e-5);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(testInMemoryCubeBulkAccessors) {
+    std::set<string> ids{string("id1"), string("id2"), string("id3")};
+    vector<Date> dates(20, Date());
+    Size samples = 100;
+    Size depth = 3;
+    DoublePrecisionInMemoryCubeN c(Date(), ids, dates, samples, depth);
+    testCubeBulkAccessors(c, 1e-14);
+    SinglePrecisionInMemoryCubeN c2(Date(), ids, dates, samples, depth);
+    testCubeBulkAccessors(c2, 1e-5);
+}
+
+BOOST_AUTO_TEST_CASE(testInMemoryCubeBulkAccessorsUnsetBlocks) {
+    // InMemoryCubeOpt allocates the samples of an (id, date) only on the first non-zero value
+    std::set<string> ids{string("id1"), string("id2")};
+    vector<Date> dates(3, Date());
+    Size samples = 10;
+    Size depth = 2;
+    DoublePrecisionInMemoryCubeN c(Date(), ids, dates, samples, depth);
+
+    // unset blocks read as zero
+    vector<Real> values(1, 42.0);
+    c.getSamples(values, 1, 2, 1);
+    BOOST_REQUIRE_EQUAL(values.size(), samples);
+    for (Size k = 0; k < samples; ++k)
+        BOOST_CHECK_EQUAL(values[k], 0.0);
+
+    // setting zeros on an unset block keeps it zero
+    c.setSamples(vector<Real>(samples, 0.0), 1, 2, 1);
+    c.getSamples(values, 1, 2, 1);
+    for (Size k = 0; k < samples; ++k)
+        BOOST_CHECK_EQUAL(values[k], 0.0);
+
+    // setting non-zero values on one depth leaves the other depth and the other blocks at zero
+    vector<Real> newValues(samples);
+    for (Size k = 0; k < samples; ++k)
+        newValues[k] = k % 2 == 0 ? 0.0 : 1.0 + k;
+    c.setSamples(newValues, 0, 1, 1);
+    for (Size i = 0; i < c.numIds(); ++i) {
+        for (Size j = 0; j < c.numDates(); ++j) {
+            for (Size d = 0; d < c.depth(); ++d) {
+                c.getSamples(values, i, j, d);
+                for (Size k = 0; k < samples; ++k) {
+                    Real expected = i == 0 && j == 1 && d == 1 ? newValues[k] : 0.0;
+                    BOOST_CHECK_EQUAL(values[k], expected);
+                    BOOST_CHECK_EQUAL(c.get(i, j, k, d), expected);
+                }
+            }
+        }
+    }
+
+    // setting zeros on an allocated block overwrites the previous values
+    c.setSamples(vector<Real>(samples, 0.0), 0, 1, 1);
+    c.getSamples(values, 0, 1, 1);
+    for (Size k = 0; k < samples; ++k) {
+        BOOST_CHECK_EQUAL(values[k], 0.0);
+        BOOST_CHECK_EQUAL(c.get(0, 1, k, 1), 0.0);
+    }
+}
+
 BOOST_AUTO_TEST_CASE(testSinglePrecisionJaggedCube) {
 
     SavedSettings backup;
@@ -539,6 +723,100 @@ BOOST_AUTO_TEST_CASE(testDoublePrecisionJaggedCube) {
     IndexManager::instance().clearHistories();
 }
 
+BOOST_AUTO_TEST_CASE(testSensitivityCubeFactorIds) {
+
+    BOOST_TEST_MESSAGE("Testing factor id based access to SensitivityCube...");
+
+    using ShiftScenarioDescription = SensitivityCube::ShiftScenarioDescription;
+
+    // one factor for each shift scheme, b has only an up shift, c has a down and an up shift
+    RiskFactorKey a(RiskFactorKey::KeyType::DiscountCurve, "EUR", 0);
+    RiskFactorKey b(RiskFactorKey::KeyType::DiscountCurve, "EUR", 1);
+    RiskFactorKey c(RiskFactorKey::KeyType::FXSpot, "USDEUR", 0);
+    vector<ShiftScenarioDescription> descriptions{
+        ShiftScenarioDescription(ShiftScenarioDescription::Type::Base),
+        ShiftScenarioDescription(ShiftScenarioDescription::Type::Up, c, "spot"),
+        ShiftScenarioDescription(ShiftScenarioDescription::Type::Up, a, "1Y"),
+        ShiftScenarioDescription(ShiftScenarioDescription::Type::Down, a, "1Y"),
+        ShiftScenarioDescription(ShiftScenarioDescription::Type::Up, b, "2Y"),
+        ShiftScenarioDescription(ShiftScenarioDescription::Type::Down, c, "spot")};
+    map<RiskFactorKey, Real> targetShiftSizes{{a, 1E-4}, {b, 1E-4}, {c, 0.01}};
+    map<RiskFactorKey, Real> actualShiftSizes{{a, 1E-4}, {b, 2E-4}, {c, 0.005}};
+    map<RiskFactorKey, ShiftScheme> shiftSchemes{
+        {a, ShiftScheme::Central}, {b, ShiftScheme::Forward}, {c, ShiftScheme::Backward}};
+
+    std::set<string> ids{"trade1", "trade2", "trade3"};
+    auto npvCube = QuantLib::ext::make_shared<DoublePrecisionSensiCube>(ids, Date(), descriptions.size());
+    MersenneTwisterUniformRng rng(42);
+    for (Size i = 0; i < ids.size(); ++i) {
+        npvCube->setT0(100.0 * (i + 1), i, 0);
+        // leave some scenarios unset, the cube returns the base npv for them
+        for (Size k = 1; k < descriptions.size(); ++k) {
+            if (k != i + 1)
+                npvCube->set(100.0 * (i + 1) + rng.nextReal() - 0.5, i, k);
+        }
+    }
+
+    SensitivityCube cube(npvCube, descriptions, targetShiftSizes, actualShiftSizes, shiftSchemes);
+
+    // factor ids follow the order of the risk factor keys
+    BOOST_REQUIRE_EQUAL(cube.numFactors(), 3);
+    BOOST_CHECK_EQUAL(cube.factorKey(0), a);
+    BOOST_CHECK_EQUAL(cube.factorKey(1), b);
+    BOOST_CHECK_EQUAL(cube.factorKey(2), c);
+    BOOST_CHECK_EQUAL(cube.factorId(c), 2);
+    BOOST_CHECK_EQUAL(cube.factorId(RiskFactorKey(RiskFactorKey::KeyType::FXSpot, "GBPEUR", 0)), Null<Size>());
+    BOOST_CHECK_EQUAL(cube.scenarioFactorId(0), Null<Size>());
+    BOOST_CHECK_EQUAL(cube.scenarioFactorId(1), 2);
+    BOOST_CHECK_EQUAL(cube.scenarioFactorId(3), 0);
+    BOOST_CHECK_EQUAL(cube.scenarioFactorId(descriptions.size()), Null<Size>());
+    BOOST_CHECK_EQUAL(cube.upDownFactor(5), c);
+    BOOST_CHECK_EQUAL(cube.factorData(2).index, 1);
+    BOOST_CHECK_EQUAL(cube.factorData(2).factorDesc, "spot");
+
+    // reference values from the definition of the shift schemes and scalings
+    auto npv = [&npvCube](Size i, Size k) { return npvCube->get(i, k); };
+    std::vector<Real> tradeDeltas, tradeGammas;
+    for (Size i = 0; i < ids.size(); ++i) {
+        Real base = npvCube->getT0(i, 0);
+        std::vector<Real> expectedDeltas{(npv(i, 2) - npv(i, 3)) / 2.0, (npv(i, 4) - base) * 0.5,
+                                         (base - npv(i, 5)) * 2.0};
+        cube.deltas(i, tradeDeltas);
+        cube.gammas(i, tradeGammas);
+        BOOST_REQUIRE_EQUAL(tradeDeltas.size(), 3);
+        BOOST_REQUIRE_EQUAL(tradeGammas.size(), 3);
+        for (Size id = 0; id < 3; ++id) {
+            BOOST_CHECK_CLOSE(cube.delta(i, id), expectedDeltas[id], 1E-10);
+            BOOST_CHECK_CLOSE(cube.delta(i, cube.factorKey(id)), expectedDeltas[id], 1E-10);
+            BOOST_CHECK_CLOSE(tradeDeltas[id], expectedDeltas[id], 1E-10);
+        }
+        Real expectedGammaA = npv(i, 2) - 2.0 * base + npv(i, 3);
+        Real expectedGammaC = (npv(i, 1) - 2.0 * base + npv(i, 5)) * 4.0;
+        BOOST_CHECK_CLOSE(cube.gamma(i, 0), expectedGammaA, 1E-10);
+        BOOST_CHECK_CLOSE(tradeGammas[0], expectedGammaA, 1E-10);
+        BOOST_CHECK_CLOSE(cube.gamma(i, a), expectedGammaA, 1E-10);
+        BOOST_CHECK_CLOSE(cube.gamma(i, 2), expectedGammaC, 1E-10);
+        BOOST_CHECK_CLOSE(tradeGammas[2], expectedGammaC, 1E-10);
+        BOOST_CHECK_EQUAL(tradeGammas[1], Null<Real>());
+    }
+    BOOST_CHECK_THROW(cube.gamma(0, 1), QuantLib::Error);
+    BOOST_CHECK_THROW(cube.delta(0, 3), QuantLib::Error);
+
+    // the bulk access by factor is consistent with the access by trade
+    std::vector<Real> factorDeltas, factorGammas;
+    for (Size id = 0; id < 3; ++id) {
+        cube.factorDeltas(id, factorDeltas);
+        BOOST_REQUIRE_EQUAL(factorDeltas.size(), ids.size());
+        for (Size i = 0; i < ids.size(); ++i)
+            BOOST_CHECK_CLOSE(factorDeltas[i], cube.delta(i, id), 1E-10);
+    }
+    cube.factorGammas(2, factorGammas);
+    BOOST_REQUIRE_EQUAL(factorGammas.size(), ids.size());
+    for (Size i = 0; i < ids.size(); ++i)
+        BOOST_CHECK_CLOSE(factorGammas[i], cube.gamma(i, 2), 1E-10);
+    BOOST_CHECK_THROW(cube.factorGammas(1, factorGammas), QuantLib::Error);
+}
+
 string writeCube(const QuantLib::ext::shared_ptr<NPVCube>& cube, Size bufferSize) {
     auto report = QuantLib::ext::make_shared<InMemoryReport>(bufferSize);
     ReportWriter().writeCube(*report, cube);
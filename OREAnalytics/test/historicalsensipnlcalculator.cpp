@@ -0,0 +1,330 @@
+/*
+ Copyright (C) 2025 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+#include <boost/test/unit_test.hpp>
+#include <orea/cube/inmemorycube.hpp>
+#include <orea/engine/historicalsensipnlcalculator.hpp>
+#include <orea/engine/sensitivityinmemorystream.hpp>
+#include <orea/scenario/historicalscenariogenerator.hpp>
+#include <orea/scenario/historicalscenarioreturn.hpp>
+#include <orea/scenario/simplescenario.hpp>
+#include <orea/scenario/simplescenariofactory.hpp>
+#include <ored/utilities/to_string.hpp>
+#include <oret/toplevelfixture.hpp>
+#include <qle/utilities/workerpool.hpp>
+#include <test/oreatoplevelfixture.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+
+using namespace std;
+using namespace QuantLib;
+using namespace ore::analytics;
+using namespace ore::data;
+
+namespace {
+
+const Size nDates = 41;
+const Date firstDate(1, January, 2020);
+
+const RiskFactorKey k1(RiskFactorKey::KeyType::DiscountCurve, "EUR", 0);
+const RiskFactorKey k2(RiskFactorKey::KeyType::DiscountCurve, "EUR", 1);
+const RiskFactorKey k3(RiskFactorKey::KeyType::FXSpot, "USDEUR", 0);
+
+// the historical shift of the key with the given column in scenario i
+Real shift(const Size column, const Size i) { return 0.001 * (static_cast<Real>((7 * i + 3 * column) % 11) - 5.0); }
+
+// a scenario (i.e. start and end date) per pair of consecutive dates
+QuantLib::ext::shared_ptr<HistoricalScenarioGenerator> scenarioGenerator() {
+    vector<QuantLib::ext::shared_ptr<Scenario>> scenarios;
+    set<Date> dates;
+    for (Size i = 0; i < nDates; ++i) {
+        scenarios.push_back(QuantLib::ext::make_shared<SimpleScenario>(firstDate + i));
+        dates.insert(firstDate + i);
+    }
+    return QuantLib::ext::make_shared<HistoricalScenarioGenerator>(
+        QuantLib::ext::make_shared<HistoricalScenarioLoader>(scenarios, dates),
+        QuantLib::ext::make_shared<SimpleScenarioFactory>(), QuantLib::ext::make_shared<ReturnConfiguration>());
+}
+
+QuantLib::ext::shared_ptr<NPVCube> shiftCube() {
+    set<string> ids = {to_string(k1), to_string(k2), to_string(k3)};
+    QuantLib::ext::shared_ptr<NPVCube> cube =
+        QuantLib::ext::make_shared<DoublePrecisionInMemoryCube>(firstDate, ids, vector<Date>(1, firstDate), nDates - 1);
+    for (Size i = 0; i < nDates - 1; ++i) {
+        cube->set(shift(0, i), cube->getTradeIndex(to_string(k1)), 0, i);
+        cube->set(shift(1, i), cube->getTradeIndex(to_string(k2)), 0, i);
+        cube->set(shift(2, i), cube->getTradeIndex(to_string(k3)), 0, i);
+    }
+    return cube;
+}
+
+SensitivityRecord record(const string& tradeId, const RiskFactorKey& key_1, const string& desc_1, const Real delta,
+                         const Real gamma, const RiskFactorKey& key_2 = RiskFactorKey(), const string& desc_2 = "") {
+    Real shift_2 = key_2 == RiskFactorKey() ? 0.0 : 0.0001;
+    return SensitivityRecord(tradeId, false, key_1, desc_1, 0.0001, key_2, desc_2, shift_2, "EUR", 0.0, delta, gamma);
+}
+
+/* The trade level sensitivities: T1 has two records for k1 which are added up, and a cross gamma w.r.t. k1 and k2
+   which contributes to the risk factor of k1. T3 is not in the trade ids and ignored. */
+QuantLib::ext::shared_ptr<SensitivityStream> tradeSensitivities() {
+    auto ss = QuantLib::ext::make_shared<SensitivityInMemoryStream>();
+    ss->add(record("T1", k1, "1Y", 30.0, 3.0));
+    ss->add(record("T1", k1, "1Y", 30.0, 3.0));
+    ss->add(record("T1", k2, "2Y", -50.0, 4.0));
+    ss->add(record("T1", k1, "1Y", 0.0, 3.0, k2, "2Y"));
+    ss->add(record("T2", k1, "1Y", 40.0, 4.0));
+    ss->add(record("T2", k3, "spot", 20.0, 0.0));
+    ss->add(record("T3", k3, "spot", 1000.0, 0.0));
+    return ss;
+}
+
+// the portfolio level sensitivities, i.e. the sum of the sensitivities of T1 and T2
+set<SensitivityRecord> portfolioSensitivities() {
+    return {record("", k1, "1Y", 100.0, 10.0), record("", k2, "2Y", -50.0, 4.0), record("", k3, "spot", 20.0, 0.0),
+            record("", k1, "1Y", 0.0, 3.0, k2, "2Y")};
+}
+
+// keeps the rows written for each scenario
+class RowPNLCalculator : public PNLCalculator {
+public:
+    using Row = std::tuple<Size, RiskFactorKey, Real, Real, Real, Real, Real, RiskFactorKey, Real, string>;
+    explicit RowPNLCalculator(const TimePeriod& period) : PNLCalculator(period) {}
+    void writePNL(Size scenarioIdx, bool isCall, const RiskFactorKey& key_1, Real shift_1, Real delta, Real gamma,
+                  Real deltaPnl, Real gammaPnl, const RiskFactorKey& key_2, Real shift_2,
+                  const string& tradeId) override {
+        rows.push_back(
+            std::make_tuple(scenarioIdx, key_1, shift_1, delta, gamma, deltaPnl, gammaPnl, key_2, shift_2, tradeId));
+    }
+    vector<Row> rows;
+};
+
+// historical shifts of the keys with non zero means and correlations
+QuantLib::ext::shared_ptr<NPVCube> covarianceShiftCube(const vector<RiskFactorKey>& keys, const Size nScenarios) {
+    set<string> ids;
+    for (const auto& k : keys)
+        ids.insert(to_string(k));
+    QuantLib::ext::shared_ptr<NPVCube> cube =
+        QuantLib::ext::make_shared<DoublePrecisionInMemoryCube>(firstDate, ids, vector<Date>(1, firstDate), nScenarios);
+    for (Size i = 0; i < nScenarios; ++i) {
+        Real common = std::sin(0.11 * i);
+        for (Size c = 0; c < keys.size(); ++c) {
+            Real x = 0.001 * c + 0.01 * (0.5 * common + std::sin(0.37 * i * (c + 1) + c));
+            cube->set(x, cube->getTradeIndex(to_string(keys[c])), 0, i);
+        }
+    }
+    return cube;
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(OREAnalyticsTestSuite, ore::test::OreaTopLevelFixture)
+
+BOOST_AUTO_TEST_SUITE(HistoricalSensiPnlCalculatorTest)
+
+BOOST_AUTO_TEST_CASE(testSensiPnl) {
+
+    BOOST_TEST_MESSAGE("Testing historical sensitivity based P&Ls...");
+
+    const vector<string> tradeIds = {"T1", "T2"};
+    const vector<string> riskFactors = {"DiscountCurve/EUR/0/1Y", "DiscountCurve/EUR/1/2Y", "FXSpot/USDEUR/0/spot"};
+    const Size nScenarios = nDates - 1;
+
+    // all scenarios, and the scenarios 10, ..., 24 with start and end date in the period
+    TimePeriod all({firstDate, firstDate + nScenarios});
+    TimePeriod part({firstDate + 10, firstDate + 25});
+
+    for (auto [includeGammaMargin, includeDeltaMargin] : {std::make_pair(true, true), std::make_pair(true, false),
+                                                         std::make_pair(false, true)}) {
+
+        Real g = includeGammaMargin ? 1.0 : 0.0;
+        Real d = includeDeltaMargin ? 1.0 : 0.0;
+        vector<RowPNLCalculator::Row> serialRows;
+
+        for (Size nThreads : {1, 4}) {
+
+            BOOST_TEST_MESSAGE("includeGammaMargin = " << includeGammaMargin << ", includeDeltaMargin = "
+                                                       << includeDeltaMargin << ", nThreads = " << nThreads);
+
+            auto cube = shiftCube();
+            vector<QuantLib::ext::shared_ptr<PNLCalculator>> calculators = {
+                QuantLib::ext::make_shared<PNLCalculator>(all), QuantLib::ext::make_shared<RowPNLCalculator>(part)};
+            auto workerPool = nThreads > 1 ? QuantLib::ext::make_shared<QuantExt::WorkerPool>(nThreads) : nullptr;
+            HistoricalSensiPnlCalculator calculator(scenarioGenerator(), tradeSensitivities(), workerPool);
+            calculator.calculateSensiPnl(portfolioSensitivities(), {k1, k2, k3}, cube, calculators, nullptr, tradeIds,
+                                         includeGammaMargin, includeDeltaMargin, true, true);
+
+            for (Size c = 0; c < calculators.size(); ++c) {
+                Size first = c == 0 ? 0 : 10;
+                Size n = c == 0 ? nScenarios : 15;
+                const auto& calc = calculators[c];
+                BOOST_REQUIRE_EQUAL(calc->pnls().size(), n);
+                BOOST_REQUIRE_EQUAL(calc->foPnls().size(), n);
+                BOOST_REQUIRE_EQUAL(calc->tradePnls().size(), n);
+                BOOST_REQUIRE_EQUAL(calc->foTradePnls().size(), n);
+                BOOST_REQUIRE_EQUAL(calc->riskFactorTradePnls().size(), n);
+                BOOST_REQUIRE_EQUAL(calc->riskFactorFoTradePnls().size(), n);
+                for (Size j = 0; j < n; ++j) {
+                    Size i = first + j;
+                    Real s1 = shift(0, i), s2 = shift(1, i), s3 = shift(2, i);
+
+                    // portfolio
+                    Real fo = 100.0 * s1 - 50.0 * s2 + 20.0 * s3;
+                    Real so = 5.0 * s1 * s1 + 2.0 * s2 * s2 + 3.0 * s1 * s2;
+                    BOOST_CHECK_SMALL(calc->foPnls()[j] - fo, 1E-12);
+                    BOOST_CHECK_SMALL(calc->pnls()[j] - (d * fo + g * so), 1E-12);
+
+                    // trades
+                    Real fo1 = 60.0 * s1 - 50.0 * s2, fo2 = 40.0 * s1 + 20.0 * s3;
+                    Real so1 = 3.0 * s1 * s1 + 2.0 * s2 * s2 + 3.0 * s1 * s2, so2 = 2.0 * s1 * s1;
+                    BOOST_REQUIRE_EQUAL(calc->tradePnls()[j].size(), 2);
+                    BOOST_CHECK_SMALL(calc->foTradePnls()[j][0] - fo1, 1E-12);
+                    BOOST_CHECK_SMALL(calc->foTradePnls()[j][1] - fo2, 1E-12);
+                    BOOST_CHECK_SMALL(calc->tradePnls()[j][0] - (d * fo1 + g * so1), 1E-12);
+                    BOOST_CHECK_SMALL(calc->tradePnls()[j][1] - (d * fo2 + g * so2), 1E-12);
+
+                    // risk factors, the cross gamma contributes to the risk factor of its first key
+                    map<string, vector<Real>> rfFo = {{riskFactors[0], {60.0 * s1, 40.0 * s1}},
+                                                      {riskFactors[1], {-50.0 * s2, 0.0}},
+                                                      {riskFactors[2], {0.0, 20.0 * s3}}};
+                    map<string, vector<Real>> rf = {
+                        {riskFactors[0],
+                         {d * 60.0 * s1 + g * (3.0 * s1 * s1 + 3.0 * s1 * s2), d * 40.0 * s1 + g * 2.0 * s1 * s1}},
+                        {riskFactors[1], {d * -50.0 * s2 + g * 2.0 * s2 * s2, 0.0}},
+                        {riskFactors[2], {0.0, d * 20.0 * s3}}};
+                    for (const auto& [expected, actual] :
+                         {std::make_pair(&rfFo, &calc->riskFactorFoTradePnls()[j]),
+                          std::make_pair(&rf, &calc->riskFactorTradePnls()[j])}) {
+                        BOOST_REQUIRE_EQUAL(actual->size(), riskFactors.size());
+                        for (const auto& [name, pnls] : *expected) {
+                            auto it = actual->find(name);
+                            BOOST_REQUIRE_MESSAGE(it != actual->end(), "risk factor " << name << " not found");
+                            BOOST_REQUIRE_EQUAL(it->second.size(), 2);
+                            for (Size t = 0; t < 2; ++t)
+                                BOOST_CHECK_SMALL(it->second[t] - pnls[t], 1E-12);
+                        }
+                    }
+                }
+            }
+
+            /* The rows of the scenarios in the period: a portfolio level row per record followed by a row per trade
+               with a sensitivity to it, i.e. 4 portfolio and 5 trade level rows per scenario */
+            const auto& rows = QuantLib::ext::dynamic_pointer_cast<RowPNLCalculator>(calculators[1])->rows;
+            BOOST_REQUIRE_EQUAL(rows.size(), 15 * 9);
+            for (Size j = 0; j < 15; ++j) {
+                Real pnl = 0.0;
+                for (Size r = 0; r < 9; ++r) {
+                    const auto& row = rows[j * 9 + r];
+                    BOOST_CHECK_EQUAL(std::get<0>(row), 10 + j);
+                    if (std::get<9>(row).empty())
+                        pnl += d * std::get<5>(row) + g * std::get<6>(row);
+                }
+                BOOST_CHECK_SMALL(pnl - (calculators[1]->pnls()[j]), 1E-12);
+            }
+            if (nThreads == 1)
+                serialRows = rows;
+            else
+                BOOST_CHECK(rows == serialRows);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(testCovariance) {
+
+    BOOST_TEST_MESSAGE("Testing the covariance of the historical shifts...");
+
+    const vector<RiskFactorKey> keys = {RiskFactorKey(RiskFactorKey::KeyType::DiscountCurve, "EUR", 0),
+                                        RiskFactorKey(RiskFactorKey::KeyType::DiscountCurve, "EUR", 1),
+                                        RiskFactorKey(RiskFactorKey::KeyType::DiscountCurve, "USD", 0),
+                                        RiskFactorKey(RiskFactorKey::KeyType::FXSpot, "USDEUR", 0),
+                                        RiskFactorKey(RiskFactorKey::KeyType::EquitySpot, "SP5", 0)};
+    const Size nScenarios = 170;
+    auto cube = covarianceShiftCube(keys, nScenarios);
+    set<pair<RiskFactorKey, Size>> indexedKeys;
+    for (const auto& k : keys)
+        indexedKeys.insert(make_pair(k, cube->getTradeIndex(to_string(k))));
+
+    // the scenarios 5, ..., 159 are in the period, i.e. two blocks of 64 scenarios and a partial block of 27
+    TimePeriod period({firstDate + 5, firstDate + 160});
+    const Size first = 5, nSamples = 155;
+
+    for (Real decayFactor : {1.0, 0.97}) {
+
+        // naive two pass weighted covariance, the last scenario has weight 1
+        Size n = indexedKeys.size();
+        vector<vector<Real>> x(nSamples, vector<Real>(n));
+        vector<Real> w(nSamples);
+        Real sumW = 0.0;
+        for (Size j = 0; j < nSamples; ++j) {
+            Size c = 0;
+            for (const auto& k : indexedKeys)
+                x[j][c++] = cube->get(k.second, 0, first + j);
+            w[j] = std::pow(decayFactor, static_cast<Real>(nSamples - 1 - j));
+            sumW += w[j];
+        }
+        vector<Real> mean(n, 0.0);
+        for (Size j = 0; j < nSamples; ++j) {
+            for (Size c = 0; c < n; ++c)
+                mean[c] += w[j] * x[j][c] / sumW;
+        }
+        Matrix expected(n, n, 0.0);
+        for (Size j = 0; j < nSamples; ++j) {
+            for (Size c = 0; c < n; ++c) {
+                for (Size l = 0; l < n; ++l)
+                    expected[c][l] += w[j] * (x[j][c] - mean[c]) * (x[j][l] - mean[l]) / sumW;
+            }
+        }
+
+        Matrix serialCovariance;
+        for (Size nThreads : {1, 4}) {
+
+            BOOST_TEST_MESSAGE("decayFactor = " << decayFactor << ", nThreads = " << nThreads);
+
+            auto workerPool = nThreads > 1 ? QuantLib::ext::make_shared<QuantExt::WorkerPool>(nThreads) : nullptr;
+            CovarianceCalculator calculator(period, workerPool, decayFactor);
+            calculator.initialise(indexedKeys);
+            for (Size i = 0; i < nScenarios; ++i)
+                calculator.updateAccumulators(cube, firstDate + i, firstDate + i + 1, i);
+            calculator.populateCovariance(indexedKeys);
+
+            BOOST_CHECK_EQUAL(calculator.samples(), nSamples);
+            const Matrix& covariance = calculator.covariance();
+            const Matrix& correlation = calculator.correlation();
+            BOOST_REQUIRE_EQUAL(covariance.rows(), n);
+            BOOST_REQUIRE_EQUAL(covariance.columns(), n);
+            for (Size c = 0; c < n; ++c) {
+                for (Size l = 0; l < n; ++l) {
+                    BOOST_CHECK_SMALL(covariance[c][l] - expected[c][l], 1E-15);
+                    Real expectedCorrelation = expected[c][l] / std::sqrt(expected[c][c] * expected[l][l]);
+                    BOOST_CHECK_SMALL(correlation[c][l] - expectedCorrelation, 1E-10);
+                }
+            }
+
+            // the threads update disjoint rows of the cross products in the same order as the serial run
+            if (nThreads == 1)
+                serialCovariance = covariance;
+            else
+                BOOST_CHECK(std::equal(covariance.begin(), covariance.end(), serialCovariance.begin()));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,153 @@
+/*
+ Copyright (C) 2025 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+#include <boost/test/unit_test.hpp>
+#include <orea/app/incrementalrevaluation.hpp>
+#include <orea/app/inputparameters.hpp>
+#include <ored/marketdata/inmemoryloader.hpp>
+#include <ored/marketdata/todaysmarket.hpp>
+#include <ored/portfolio/enginefactory.hpp>
+#include <ored/portfolio/fxforward.hpp>
+#include <ored/portfolio/portfolio.hpp>
+#include <ored/utilities/parsers.hpp>
+#include <oret/datapaths.hpp>
+#include <oret/toplevelfixture.hpp>
+#include <test/oreatoplevelfixture.hpp>
+
+#include <fstream>
+
+using namespace std;
+using namespace QuantLib;
+using namespace ore::analytics;
+using namespace ore::data;
+
+namespace {
+
+// USD OIS and ARS (collateralised in USD) curves, two USD/ARS fx forwards and a USD fixed leg
+QuantLib::ext::shared_ptr<InputParameters> inputs() {
+    auto inputs = QuantLib::ext::make_shared<InputParameters>();
+    inputs->setAsOfDate("2019-09-25");
+    inputs->setBaseCurrency("USD");
+    inputs->setLazyMarketBuilding(false);
+    inputs->setConventionsFromFile(TEST_INPUT_FILE("conventions.xml"));
+    inputs->setCurveConfigsFromFile(TEST_INPUT_FILE("curveconfig.xml"));
+    inputs->setTodaysMarketParamsFromFile(TEST_INPUT_FILE("todaysmarket.xml"));
+    inputs->setPricingEngineFromFile(TEST_INPUT_FILE("pricingengine.xml"));
+    inputs->setPortfolioFromFile(TEST_INPUT_FILE("portfolio.xml"), "");
+    return inputs;
+}
+
+// the quotes from market.txt, with the given values replaced
+QuantLib::ext::shared_ptr<InMemoryLoader> loader(const std::map<std::string, Real>& quotes = {}) {
+    auto loader = QuantLib::ext::make_shared<InMemoryLoader>();
+    std::ifstream file(TEST_INPUT_FILE("market.txt"));
+    std::string date, name;
+    Real value;
+    while (file >> date >> name >> value) {
+        auto q = quotes.find(name);
+        loader->add(parseDate(date), name, q == quotes.end() ? value : q->second);
+    }
+    return loader;
+}
+
+// npvs of a fresh build of market and portfolio
+std::map<std::string, Real> fullRevaluation(const QuantLib::ext::shared_ptr<InputParameters>& inputs,
+                                            const std::string& portfolioXml,
+                                            const std::map<std::string, Real>& quotes) {
+    auto market = QuantLib::ext::make_shared<TodaysMarket>(inputs->asof(), inputs->todaysMarketParams(),
+                                                           loader(quotes), inputs->curveConfigs().get(), false,
+                                                           false, false);
+    auto engineFactory = QuantLib::ext::make_shared<EngineFactory>(inputs->pricingEngine(), market);
+    Portfolio portfolio;
+    portfolio.fromXMLString(portfolioXml);
+    portfolio.build(engineFactory);
+    std::map<std::string, Real> npvs;
+    for (auto const& [tradeId, trade] : portfolio.trades())
+        npvs[tradeId] = trade->instrument()->NPV();
+    return npvs;
+}
+
+void checkNpvs(const std::map<std::string, Real>& npvs, const std::map<std::string, Real>& expected) {
+    BOOST_REQUIRE_EQUAL(npvs.size(), expected.size());
+    for (auto const& [tradeId, npv] : expected) {
+        auto n = npvs.find(tradeId);
+        BOOST_REQUIRE_MESSAGE(n != npvs.end(), "trade " << tradeId << " not found");
+        BOOST_CHECK_MESSAGE(n->second != Null<Real>(), "trade " << tradeId << " failed to price");
+        BOOST_CHECK_SMALL(n->second - npv, 1E-6);
+    }
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(OREAnalyticsTestSuite, ore::test::OreaTopLevelFixture)
+
+BOOST_AUTO_TEST_SUITE(IncrementalRevaluationTest)
+
+BOOST_AUTO_TEST_CASE(testIncrementalVsFullRevaluation) {
+
+    BOOST_TEST_MESSAGE("Testing incremental revaluation against a full revaluation...");
+
+    auto in = inputs();
+    std::map<std::string, Real> quotes;
+    IncrementalRevaluation rev(in, loader());
+
+    // initial build
+    BOOST_CHECK_EQUAL(rev.reprice().size(), 3);
+    checkNpvs(rev.npvs(), fullRevaluation(in, in->portfolio()->toXMLString(), quotes));
+    // the trades of the inputs are copied, not built
+    for (auto const& [tradeId, trade] : in->portfolio()->trades())
+        BOOST_CHECK_MESSAGE(trade->instrument() == nullptr, "trade " << tradeId << " of the inputs was built");
+
+    // a change to the ARS curve reprices the fx forwards only
+    quotes["FXFWD/RATE/USD/ARS/6M"] = 31.0;
+    quotes["FXFWD/RATE/USD/ARS/9M"] = 46.0;
+    rev.updateQuotes(quotes);
+    BOOST_CHECK(rev.reprice() == std::set<std::string>({"FXFWD_1", "FXFWD_2"}));
+    checkNpvs(rev.npvs(), fullRevaluation(in, in->portfolio()->toXMLString(), quotes));
+
+    // a change to the USD curve reprices all trades
+    quotes["IR_SWAP/RATE/USD/2D/1D/6M"] = 0.0175;
+    rev.updateQuotes({{"IR_SWAP/RATE/USD/2D/1D/6M", 0.0175}});
+    BOOST_CHECK(rev.reprice() == std::set<std::string>({"FIXED_USD", "FXFWD_1", "FXFWD_2"}));
+    checkNpvs(rev.npvs(), fullRevaluation(in, in->portfolio()->toXMLString(), quotes));
+
+    // no change, nothing to reprice
+    BOOST_CHECK(rev.reprice().empty());
+
+    // a trade amendment reprices the amended trade only, the caller's trade is not built
+    auto amended = QuantLib::ext::make_shared<FxForward>(Envelope("CPTY_A", std::string("CPTY_A")), "2020-03-25", "ARS",
+                                                         75000000.0, "USD", 1000000.0);
+    amended->id() = "FXFWD_1";
+    rev.addTrade(amended);
+    BOOST_CHECK(amended->instrument() == nullptr);
+    BOOST_CHECK(rev.reprice() == std::set<std::string>({"FXFWD_1"}));
+    checkNpvs(rev.npvs(), fullRevaluation(in, rev.portfolio()->toXMLString(), quotes));
+
+    // a removal reprices nothing
+    BOOST_CHECK(rev.removeTrade("FXFWD_2"));
+    BOOST_CHECK(rev.reprice().empty());
+    BOOST_CHECK(rev.removedTrades() == std::set<std::string>({"FXFWD_2"}));
+    checkNpvs(rev.npvs(), fullRevaluation(in, rev.portfolio()->toXMLString(), quotes));
+
+    // the linked quotes did not require a rebuild of the market
+    BOOST_CHECK_EQUAL(rev.marketRebuilds(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,171 @@
+/*
+ Copyright (C) 2025 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+#include <boost/test/unit_test.hpp>
+#include <orea/app/inputparameters.hpp>
+#include <orea/cube/jointnpvcube.hpp>
+#include <orea/engine/multithreadedvaluationengine.hpp>
+#include <orea/engine/valuationcalculator.hpp>
+#include <orea/scenario/scenariogenerator.hpp>
+#include <orea/scenario/scenariosimmarket.hpp>
+#include <orea/scenario/scenariosimmarketparameters.hpp>
+#include <ored/marketdata/inmemoryloader.hpp>
+#include <ored/marketdata/todaysmarket.hpp>
+#include <ored/utilities/parsers.hpp>
+#include <oret/datapaths.hpp>
+#include <oret/toplevelfixture.hpp>
+#include <test/oreatoplevelfixture.hpp>
+
+#include <cmath>
+#include <fstream>
+
+using namespace std;
+using namespace QuantLib;
+using namespace ore::analytics;
+using namespace ore::data;
+
+namespace {
+
+// USD OIS and ARS (collateralised in USD) curves, two USD/ARS fx forwards and a USD fixed leg
+QuantLib::ext::shared_ptr<InputParameters> inputs() {
+    auto inputs = QuantLib::ext::make_shared<InputParameters>();
+    inputs->setAsOfDate("2019-09-25");
+    inputs->setBaseCurrency("USD");
+    inputs->setConventionsFromFile(TEST_INPUT_FILE("conventions.xml"));
+    inputs->setCurveConfigsFromFile(TEST_INPUT_FILE("curveconfig.xml"));
+    inputs->setTodaysMarketParamsFromFile(TEST_INPUT_FILE("todaysmarket.xml"));
+    inputs->setPricingEngineFromFile(TEST_INPUT_FILE("pricingengine.xml"));
+    inputs->setPortfolioFromFile(TEST_INPUT_FILE("portfolio.xml"), "");
+    return inputs;
+}
+
+QuantLib::ext::shared_ptr<InMemoryLoader> loader() {
+    auto loader = QuantLib::ext::make_shared<InMemoryLoader>();
+    std::ifstream file(TEST_INPUT_FILE("market.txt"));
+    std::string date, name;
+    Real value;
+    while (file >> date >> name >> value)
+        loader->add(parseDate(date), name, value);
+    return loader;
+}
+
+QuantLib::ext::shared_ptr<ScenarioSimMarketParameters> simMarketParameters() {
+    auto parameters = QuantLib::ext::make_shared<ScenarioSimMarketParameters>();
+    parameters->baseCcy() = "USD";
+    parameters->setDiscountCurveNames({"USD", "ARS"});
+    parameters->setYieldCurveTenors("", {1 * Months, 3 * Months, 6 * Months, 1 * Years, 2 * Years});
+    parameters->setIndices({"USD-FedFunds"});
+    parameters->interpolation() = "LogLinear";
+    parameters->setFxCcyPairs({"ARSUSD"});
+    return parameters;
+}
+
+// the base scenario with all values perturbed by a factor depending on the sample, the date and the key
+class TestScenarioGenerator : public ScenarioGenerator {
+public:
+    TestScenarioGenerator(const QuantLib::ext::shared_ptr<Scenario>& baseScenario, const std::vector<Date>& dates)
+        : baseScenario_(baseScenario), dates_(dates) {}
+    QuantLib::ext::shared_ptr<Scenario> next(const Date& d) override {
+        Size dateIndex = std::distance(dates_.begin(), std::find(dates_.begin(), dates_.end(), d));
+        if (dateIndex == 0)
+            ++sample_;
+        auto s = baseScenario_->clone();
+        s->setAsof(d);
+        s->setNumeraire(1.0);
+        Size k = 0;
+        for (auto const& key : baseScenario_->keys())
+            s->add(key, baseScenario_->get(key) * (1.0 + 0.01 * std::sin(1.0 + sample_ + 2.0 * dateIndex + k++)));
+        return s;
+    }
+    void reset() override { sample_ = 0; }
+
+private:
+    QuantLib::ext::shared_ptr<Scenario> baseScenario_;
+    std::vector<Date> dates_;
+    Size sample_ = 0;
+};
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(OREAnalyticsTestSuite, ore::test::OreaTopLevelFixture)
+
+BOOST_AUTO_TEST_SUITE(MultiThreadedValuationEngineTest)
+
+BOOST_AUTO_TEST_CASE(testWorkUnitsPerThread) {
+
+    BOOST_TEST_MESSAGE("Testing the multi-threaded valuation engine with several work units per thread...");
+
+#ifdef QL_ENABLE_SESSIONS
+
+    auto in = inputs();
+    auto l = loader();
+    auto parameters = simMarketParameters();
+    auto market = QuantLib::ext::make_shared<TodaysMarket>(in->asof(), in->todaysMarketParams(), l,
+                                                           in->curveConfigs().get(), false, false, false);
+    auto simMarket = QuantLib::ext::make_shared<ScenarioSimMarket>(
+        market, parameters, Market::defaultConfiguration, *in->curveConfigs().get(), *in->todaysMarketParams());
+
+    auto grid = QuantLib::ext::make_shared<DateGrid>("1M,3M,6M");
+    const Size samples = 6;
+    auto generator =
+        QuantLib::ext::make_shared<TestScenarioGenerator>(simMarket->baseScenarioAbsolute(), grid->dates());
+
+    auto buildCube = [&](const Size nThreads, const Size workUnitsPerThread) {
+        MultiThreadedValuationEngine engine(nThreads, in->asof(), grid, samples, l, generator, in->pricingEngine(),
+                                            in->curveConfigs().get(), in->todaysMarketParams(),
+                                            Market::defaultConfiguration, parameters);
+        engine.setWorkUnitsPerThread(workUnitsPerThread);
+        engine.buildCube(in->portfolio(), []() {
+            return std::vector<QuantLib::ext::shared_ptr<ValuationCalculator>>{
+                QuantLib::ext::make_shared<NPVCalculator>("USD")};
+        });
+        return engine.outputCubes();
+    };
+
+    // one unit on one thread vs. three units (one per trade) on two threads
+    auto reference = buildCube(1, 1);
+    auto units = buildCube(2, 3);
+    BOOST_CHECK_EQUAL(reference.size(), 1);
+    BOOST_REQUIRE_EQUAL(units.size(), 3);
+    for (auto const& c : units)
+        BOOST_CHECK_EQUAL(c->numIds(), 1);
+
+    auto ids = in->portfolio()->ids();
+    QuantLib::ext::shared_ptr<NPVCube> referenceCube = QuantLib::ext::make_shared<JointNPVCube>(reference, ids);
+    QuantLib::ext::shared_ptr<NPVCube> unitsCube = QuantLib::ext::make_shared<JointNPVCube>(units, ids);
+    for (auto const& id : ids) {
+        BOOST_CHECK_CLOSE(unitsCube->getT0(id), referenceCube->getT0(id), 1E-10);
+        bool varies = false;
+        for (auto const& d : grid->dates()) {
+            for (Size s = 0; s < samples; ++s) {
+                Real npv = referenceCube->get(id, d, s);
+                BOOST_CHECK_CLOSE(unitsCube->get(id, d, s), npv, 1E-10);
+                varies = varies || !close_enough(npv, referenceCube->get(id, d, 0));
+            }
+        }
+        BOOST_CHECK_MESSAGE(varies, "npvs of trade " << id << " do not depend on the sample");
+    }
+
+#else
+    BOOST_TEST_MESSAGE("skipped, the multi-threaded valuation engine requires a build with QL_ENABLE_SESSIONS = ON");
+#endif
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE_END()
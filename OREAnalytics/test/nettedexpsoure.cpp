@@ -682,6 +682,32 @@ BOOST_AUTO_TEST_CASE(NettedExposureCalculatorTest) {
                     exposureCalculator->exposureCube(), 0, 0, false, mporStickyDate, MporCashFlowMode::Unspecified,
                     false);
             nettedExposureCalculator->build();
+
+            // the aggregation on a worker pool must reproduce the single threaded results exactly
+            auto workerPool = QuantLib::ext::make_shared<QuantExt::WorkerPool>(4);
+            auto exposureCalculatorMt = QuantLib::ext::make_shared<ExposureCalculator>(
+                portfolio, cube, cubeInterpreter, asd, initMarket, false, "EUR", "Market", 0.99, calcType, false, false,
+                false, false, false, workerPool);
+            exposureCalculatorMt->build();
+            auto nettedExposureCalculatorMt = QuantLib::ext::make_shared<NettedExposureCalculator>(
+                portfolio, initMarket, cube, "EUR", "Market", 0.99, calcType, false, nettingSetManager, collateralBalances,
+                exposureCalculatorMt->nettingSetDefaultValue(), exposureCalculatorMt->nettingSetCloseOutValue(),
+                exposureCalculatorMt->nettingSetMporPositiveFlow(), exposureCalculatorMt->nettingSetMporNegativeFlow(),
+                asd, cubeInterpreter, false, dimCalculator, false, false, 0.1, exposureCalculatorMt->exposureCube(), 0, 0,
+                false, mporStickyDate, MporCashFlowMode::Unspecified, false, false, false, workerPool);
+            nettedExposureCalculatorMt->build();
+            for (auto const& [tradeId, trade] : portfolio->trades()) {
+                BOOST_CHECK(exposureCalculatorMt->epe(tradeId) == exposureCalculator->epe(tradeId));
+                BOOST_CHECK(exposureCalculatorMt->pfe(tradeId) == exposureCalculator->pfe(tradeId));
+                BOOST_CHECK(exposureCalculatorMt->ee_b(tradeId) == exposureCalculator->ee_b(tradeId));
+            }
+            BOOST_CHECK(nettedExposureCalculatorMt->epe(nettingSetId) == nettedExposureCalculator->epe(nettingSetId));
+            BOOST_CHECK(nettedExposureCalculatorMt->ene(nettingSetId) == nettedExposureCalculator->ene(nettingSetId));
+            BOOST_CHECK(nettedExposureCalculatorMt->pfe(nettingSetId) == nettedExposureCalculator->pfe(nettingSetId));
+            BOOST_CHECK(nettedExposureCalculatorMt->expectedCollateral(nettingSetId) ==
+                        nettedExposureCalculator->expectedCollateral(nettingSetId));
+            BOOST_CHECK_EQUAL(nettedExposureCalculatorMt->colva(nettingSetId), nettedExposureCalculator->colva(nettingSetId));
+
             nettingSetValue = (calcType == CollateralExposureHelper::CalculationType::NoLag
                                 ? nettedExposureCalculator->nettingSetCloseOutValue()
                                 : nettedExposureCalculator->nettingSetDefaultValue());
@@ -355,6 +355,23 @@ void simulation(string dateGridString, bool checkFixings) {
     }
 }
 
+class CountingObserver : public Observer {
+public:
+    void update() override { ++notifications; }
+    Size notifications = 0;
+};
+
+// exposes the sim data quotes, so that the notifications per applied scenario can be counted
+class ObservedSimMarket : public analytics::ScenarioSimMarket {
+public:
+    using ScenarioSimMarket::ScenarioSimMarket;
+    Size registerWithSimData(Observer& observer) {
+        for (auto const& [key, quote] : simData_)
+            observer.registerWith(quote);
+        return simData_.size();
+    }
+};
+
 BOOST_FIXTURE_TEST_SUITE(OREAnalyticsTestSuite, ore::test::OreaTopLevelFixture)
 
 BOOST_AUTO_TEST_SUITE(ObservationModeTest)
@@ -432,6 +449,61 @@ BOOST_AUTO_TEST_CASE(testDefer) {
     simulation("10,1Y", true);
 }
 
+BOOST_AUTO_TEST_CASE(testBatchNotifications) {
+    BOOST_TEST_MESSAGE("Testing the number of notifications per applied scenario in Observation Mode Batch");
+
+    SavedSettings backup;
+    Date today = Date(14, April, 2016);
+    Settings::instance().evaluationDate() = today;
+
+    QuantLib::ext::shared_ptr<Market> initMarket = QuantLib::ext::make_shared<TestMarket>(today);
+    auto parameters = QuantLib::ext::make_shared<analytics::ScenarioSimMarketParameters>();
+    parameters->baseCcy() = "EUR";
+    parameters->setDiscountCurveNames({"EUR", "USD"});
+    parameters->setYieldCurveTenors("", {1 * Months, 6 * Months, 1 * Years, 2 * Years, 5 * Years, 10 * Years});
+    parameters->setIndices({"EUR-EURIBOR-6M", "USD-LIBOR-3M"});
+    parameters->interpolation() = "LogLinear";
+    parameters->setFxCcyPairs({"USDEUR"});
+
+    // Batch notifies each observer of the sim data once per scenario, None and Defer (which only defers the
+    // notifications within SimMarket::update()) once per changed quote
+    for (auto mode : {ObservationMode::Mode::None, ObservationMode::Mode::Defer, ObservationMode::Mode::Batch}) {
+        ObservationMode::instance().setMode(mode);
+        auto simMarket = QuantLib::ext::make_shared<ObservedSimMarket>(initMarket, parameters);
+        auto scenario = simMarket->baseScenario()->clone();
+        for (auto const& key : scenario->keys())
+            scenario->add(key, scenario->get(key) * 1.01);
+
+        CountingObserver observer;
+        Size quotes = simMarket->registerWithSimData(observer);
+        BOOST_REQUIRE(quotes > 1);
+        simMarket->applyScenario(scenario);
+        BOOST_CHECK_EQUAL(observer.notifications, mode == ObservationMode::Mode::Batch ? 1 : quotes);
+
+        // applying the same scenario again does not change any quote
+        simMarket->applyScenario(scenario);
+        BOOST_CHECK_EQUAL(observer.notifications, mode == ObservationMode::Mode::Batch ? 1 : quotes);
+    }
+    ObservationMode::instance().setMode(ObservationMode::Mode::None);
+}
+
+BOOST_AUTO_TEST_CASE(testBatch) {
+    ObservationMode::instance().setMode(ObservationMode::Mode::Batch);
+    setConventions();
+
+    BOOST_TEST_MESSAGE("Testing Observation Mode Batch, Long Grid, No Fixing Checks");
+    simulation("11,1Y", false);
+
+    BOOST_TEST_MESSAGE("Testing Observation Mode Batch, Long Grid, With Fixing Checks");
+    simulation("11,1Y", true);
+
+    BOOST_TEST_MESSAGE("Testing Observation Mode Batch, Short Grid, No Fixing Checks");
+    simulation("10,1Y", false);
+
+    BOOST_TEST_MESSAGE("Testing Observation Mode Batch, Short Grid, With Fixing Checks");
+    simulation("10,1Y", true);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_SUITE_END()
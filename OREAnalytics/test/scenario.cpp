@@ -5,10 +5,14 @@ All rights reserved.
 
 #include <oret/toplevelfixture.hpp>
 #include <boost/make_shared.hpp>
+#include <orea/scenario/scenarioarchive.hpp>
+#include <orea/scenario/scenarioloader.hpp>
 #include <orea/scenario/scenariowriter.hpp>
 #include <orea/scenario/simplescenario.hpp>
 #include <orea/scenario/simplescenariofactory.hpp>
 #include <orea/scenario/csvscenariogenerator.hpp>
+#include <boost/filesystem.hpp>
+#include <ql/time/calendars/nullcalendar.hpp>
 
 using namespace boost::unit_test_framework;
 using namespace QuantLib;
@@ -89,4 +93,79 @@ BOOST_AUTO_TEST_CASE(testCSVScenarioGenerator) {
 
 BOOST_AUTO_TEST_SUITE_END()
 
+BOOST_AUTO_TEST_SUITE(ScenarioArchiveTest)
+
+namespace {
+void testScenarioArchive(const bool singlePrecision) {
+
+    // Make up a history of scenarios sharing their keys
+    vector<RiskFactorKey> rfks = {{RiskFactorKey::KeyType::DiscountCurve, "EUR", 0},
+                                  {RiskFactorKey::KeyType::DiscountCurve, "EUR", 1},
+                                  {RiskFactorKey::KeyType::IndexCurve, "EUR-EURIBOR-6M", 0},
+                                  {RiskFactorKey::KeyType::FXSpot, "USDEUR"},
+                                  {RiskFactorKey::KeyType::SwaptionVolatility, "EUR", 3}};
+    SimpleScenarioFactory factory(true);
+    vector<QuantLib::ext::shared_ptr<Scenario>> scenarios;
+    Date d(2, Jan, 2024);
+    for (Size i = 0; i < 10; ++i, d += 1) {
+        auto s = factory.buildScenario(d, true, false, "", 1.0 + i);
+        for (Size k = 0; k < rfks.size(); ++k)
+            s->add(rfks[k], 0.5 + 0.01 * i + 0.1 * k);
+        scenarios.push_back(s);
+    }
+
+    // Write them to a binary archive
+    string filename = boost::filesystem::unique_path().string() + ".bin";
+    {
+        ScenarioWriter sw(filename, ',', "w+", {}, true, 8, singlePrecision);
+        for (Size i = 0; i < scenarios.size(); ++i)
+            sw.writeScenario(scenarios[i], i == 0);
+    }
+    BOOST_REQUIRE(ScenarioArchive::isScenarioArchive(filename));
+
+    // Load a sub period of the history from the archive
+    {
+        auto reader = QuantLib::ext::make_shared<ScenarioArchiveReader>(filename);
+        BOOST_CHECK_EQUAL(reader->archive()->numScenarios(), scenarios.size());
+        BOOST_CHECK_EQUAL(reader->archive()->numKeys(), rfks.size());
+        BOOST_CHECK_EQUAL(reader->archive()->singlePrecision(), singlePrecision);
+        HistoricalScenarioLoader loader(reader, scenarios[2]->asof(), scenarios[7]->asof(), NullCalendar());
+        BOOST_REQUIRE_EQUAL(loader.numScenarios(), Size(6));
+
+        Real tol = singlePrecision ? 1E-5 : 0.0;
+        for (Size i = 2; i <= 7; ++i) {
+            auto s = loader.getScenario(scenarios[i]->asof());
+            BOOST_REQUIRE(QuantLib::ext::dynamic_pointer_cast<MappedScenario>(s));
+            BOOST_CHECK_EQUAL(s->keys().size(), rfks.size());
+            BOOST_CHECK_EQUAL(s->getNumeraire(), scenarios[i]->getNumeraire());
+            BOOST_CHECK(s->isAbsolute());
+            for (auto const& k : rfks) {
+                BOOST_REQUIRE(s->has(k));
+                BOOST_CHECK_SMALL(s->get(k) - scenarios[i]->get(k), tol + QL_EPSILON);
+            }
+            // the view is read only, a clone can be modified
+            BOOST_CHECK_THROW(s->add(rfks[0], 1.0), QuantLib::Error);
+            auto c = s->clone();
+            c->add(rfks[0], 1.0);
+            BOOST_CHECK_EQUAL(c->get(rfks[0]), 1.0);
+            BOOST_CHECK_SMALL(c->get(rfks[1]) - scenarios[i]->get(rfks[1]), tol + QL_EPSILON);
+        }
+    }
+
+    boost::filesystem::remove(filename);
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(testScenarioArchiveDouble) {
+    BOOST_TEST_MESSAGE("Testing binary scenario archive with double precision...");
+    testScenarioArchive(false);
+}
+
+BOOST_AUTO_TEST_CASE(testScenarioArchiveFloat) {
+    BOOST_TEST_MESSAGE("Testing binary scenario archive with single precision...");
+    testScenarioArchive(true);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
 BOOST_AUTO_TEST_SUITE_END()
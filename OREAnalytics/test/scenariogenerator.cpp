@@ -30,6 +30,7 @@
 #include <ored/model/irlgmdata.hpp>
 #include <ored/portfolio/builders/swap.hpp>
 #include <ored/portfolio/swap.hpp>
+#include <ored/utilities/indexparser.hpp>
 #include <ored/utilities/log.hpp>
 #include <ored/utilities/to_string.hpp>
 #include <oret/toplevelfixture.hpp>
@@ -37,6 +38,8 @@
 
 #include <qle/instruments/fxforward.hpp>
 #include <qle/models/crossassetmodel.hpp>
+#include <qle/models/crossassetmodelimpliedswaptionvoltermstructure.hpp>
+#include <qle/models/modelimpliedyieldtermstructure.hpp>
 #include <qle/models/fxbspiecewiseconstantparametrization.hpp>
 #include <qle/models/irlgm1fpiecewiseconstantparametrization.hpp>
 #include <qle/models/lgm.hpp>
@@ -86,6 +89,7 @@ void setConventions() {
     QuantLib::ext::shared_ptr<data::Convention> swapIndexConv(
         new data::SwapIndexConvention("EUR-CMS-2Y", "EUR-6M-SWAP-CONVENTIONS"));
     conventions->add(swapIndexConv);
+    conventions->add(QuantLib::ext::make_shared<data::SwapIndexConvention>("EUR-CMS-30Y", "EUR-6M-SWAP-CONVENTIONS"));
 
     QuantLib::ext::shared_ptr<data::Convention> swapConv(
         new data::IRSwapConvention("EUR-6M-SWAP-CONVENTIONS", "TARGET", "Annual", "MF", "30/360", "EUR-EURIBOR-6M"));
@@ -481,6 +485,188 @@ BOOST_AUTO_TEST_CASE(testCrossAssetLowDiscrepancyBrownianBridge) {
     test_crossasset(true, false, true);
 }
 
+BOOST_AUTO_TEST_CASE(testCrossAssetBatchedPaths) {
+    BOOST_TEST_MESSAGE("Testing CrossAssetScenarioGenerator batched path generation...");
+    setConventions();
+
+    TestData d;
+
+    Date today = d.referenceDate;
+    QuantLib::ext::shared_ptr<DateGrid> grid =
+        QuantLib::ext::make_shared<DateGrid>(std::vector<Period>{1 * Years, 2 * Years, 5 * Years, 10 * Years});
+    QuantLib::ext::shared_ptr<QuantExt::CrossAssetModel> model = d.ccLgm;
+
+    QuantLib::ext::shared_ptr<ScenarioSimMarketParameters> simMarketConfig(new ScenarioSimMarketParameters);
+    simMarketConfig->setYieldCurveTenors("", {3 * Months, 1 * Years, 2 * Years, 5 * Years, 10 * Years, 30 * Years});
+    simMarketConfig->setSimulateFXVols(false);
+    simMarketConfig->setSimulateEquityVols(false);
+    simMarketConfig->baseCcy() = "EUR";
+    simMarketConfig->setDiscountCurveNames({"EUR", "USD", "GBP"});
+    simMarketConfig->setIndices({"EUR-EURIBOR-6M", "USD-LIBOR-3M", "GBP-LIBOR-6M"});
+    simMarketConfig->setFxCcyPairs({"USDEUR", "GBPEUR"});
+
+    auto buildGenerator = [&]() {
+        auto stateProcess = model->stateProcess();
+        if (auto tmp = QuantLib::ext::dynamic_pointer_cast<CrossAssetStateProcess>(stateProcess))
+            tmp->resetCache(grid->timeGrid().size() - 1);
+        auto pathGen =
+            QuantLib::ext::make_shared<MultiPathGeneratorMersenneTwister>(stateProcess, grid->timeGrid(), 42, false);
+        return QuantLib::ext::make_shared<CrossAssetModelScenarioGenerator>(
+            model, pathGen, QuantLib::ext::make_shared<SimpleScenarioFactory>(true), simMarketConfig, today, grid,
+            d.market);
+    };
+
+    auto reference = buildGenerator();
+    auto batched = buildGenerator();
+    batched->setBatchSize(7);
+
+    Size samples = 20;
+    auto batch = buildGenerator()->nextPaths(samples);
+    BOOST_REQUIRE_EQUAL(batch.size(), samples);
+
+    for (Size i = 0; i < samples; ++i) {
+        for (Size j = 0; j < grid->dates().size(); ++j) {
+            auto s0 = reference->next(grid->dates()[j]);
+            auto s1 = batched->next(grid->dates()[j]);
+            auto s2 = batch[i][j];
+            BOOST_REQUIRE_EQUAL(s0->keys().size(), s1->keys().size());
+            BOOST_REQUIRE_EQUAL(s0->keys().size(), s2->keys().size());
+            BOOST_CHECK_EQUAL(s0->asof(), s2->asof());
+            BOOST_CHECK_EQUAL(s0->getNumeraire(), s1->getNumeraire());
+            BOOST_CHECK_EQUAL(s0->getNumeraire(), s2->getNumeraire());
+            for (auto const& k : s0->keys()) {
+                BOOST_CHECK_EQUAL(s0->get(k), s1->get(k));
+                BOOST_CHECK_EQUAL(s0->get(k), s2->get(k));
+            }
+        }
+    }
+
+    // the zero bonds are the ones implied by the model
+    auto scenario = batch.front().back();
+    Date d0 = grid->dates().back();
+    Time t = grid->timeGrid().back();
+    DayCounter dc = model->irModel(0)->termStructure()->dayCounter();
+    auto curve = QuantLib::ext::make_shared<ModelImpliedYieldTermStructure>(model->irModel(0), dc, true);
+    Array state(1);
+    // the numeraire in the LGM model is a function of the state, we recover the state from the 1y zero bond
+    Real H0 = model->irlgm1f(0)->H(t);
+    Real H1 = model->irlgm1f(0)->H(t + dc.yearFraction(d0, d0 + 1 * Years));
+    Real zeta = model->irlgm1f(0)->zeta(t);
+    Real P = scenario->get(RiskFactorKey(RiskFactorKey::KeyType::DiscountCurve, "EUR", 1));
+    Real ratio = model->irlgm1f(0)->termStructure()->discount(t + dc.yearFraction(d0, d0 + 1 * Years)) /
+                 model->irlgm1f(0)->termStructure()->discount(t);
+    state[0] = -(std::log(P / ratio) + 0.5 * (H1 * H1 - H0 * H0) * zeta) / (H1 - H0);
+    curve->move(t, state);
+    for (Size k = 0; k < simMarketConfig->yieldCurveTenors("EUR").size(); ++k) {
+        Real expected = curve->discount(dc.yearFraction(d0, d0 + simMarketConfig->yieldCurveTenors("EUR")[k]));
+        BOOST_CHECK_CLOSE(scenario->get(RiskFactorKey(RiskFactorKey::KeyType::DiscountCurve, "EUR", k)), expected,
+                          1E-8);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(testCrossAssetBatchedPathsAgainstPerPathModelCurves) {
+    BOOST_TEST_MESSAGE("Testing CrossAssetScenarioGenerator batched paths against per path model implied curves...");
+    setConventions();
+
+    TestData d;
+
+    Date today = d.referenceDate;
+    QuantLib::ext::shared_ptr<DateGrid> grid =
+        QuantLib::ext::make_shared<DateGrid>(std::vector<Period>{1 * Years, 2 * Years, 5 * Years});
+    QuantLib::ext::shared_ptr<QuantExt::CrossAssetModel> model = d.ccLgm;
+
+    std::vector<Period> swapVolExpiries = {1 * Years, 5 * Years};
+    std::vector<Period> swapVolTerms = {2 * Years, 10 * Years};
+    std::vector<std::string> indexNames = {"EUR-EURIBOR-6M", "USD-LIBOR-3M"};
+
+    QuantLib::ext::shared_ptr<ScenarioSimMarketParameters> simMarketConfig(new ScenarioSimMarketParameters);
+    simMarketConfig->setYieldCurveTenors("", {3 * Months, 1 * Years, 5 * Years, 10 * Years});
+    simMarketConfig->setSimulateFXVols(false);
+    simMarketConfig->setSimulateEquityVols(false);
+    simMarketConfig->baseCcy() = "EUR";
+    simMarketConfig->setDiscountCurveNames({"EUR", "USD", "GBP"});
+    simMarketConfig->setIndices(indexNames);
+    simMarketConfig->setFxCcyPairs({"USDEUR", "GBPEUR"});
+    simMarketConfig->setSimulateSwapVols(true);
+    simMarketConfig->setSwapVolKeys({"EUR"});
+    simMarketConfig->setSwapVolExpiries("", swapVolExpiries);
+    simMarketConfig->setSwapVolTerms("", swapVolTerms);
+
+    auto buildPathGenerator = [&]() {
+        auto stateProcess = model->stateProcess();
+        if (auto tmp = QuantLib::ext::dynamic_pointer_cast<CrossAssetStateProcess>(stateProcess))
+            tmp->resetCache(grid->timeGrid().size() - 1);
+        return QuantLib::ext::make_shared<MultiPathGeneratorMersenneTwister>(stateProcess, grid->timeGrid(), 42,
+                                                                             false);
+    };
+
+    // reference: the model implied curves and swaption vols moved path by path
+    DayCounter dc = model->irModel(0)->termStructure()->dayCounter();
+    auto discountCurve = QuantLib::ext::make_shared<ModelImpliedYieldTermStructure>(model->irModel(0), dc, true);
+    std::vector<QuantLib::ext::shared_ptr<ModelImpliedYieldTermStructure>> fwdCurves;
+    std::vector<QuantLib::ext::shared_ptr<IborIndex>> indices;
+    std::vector<Size> indexCcys;
+    for (auto const& name : indexNames) {
+        auto index = *d.market->iborIndex(name);
+        indexCcys.push_back(model->ccyIndex(index->currency()));
+        fwdCurves.push_back(QuantLib::ext::make_shared<ModelImpliedYtsFwdFwdCorrected>(
+            model->irModel(indexCcys.back()), index->forwardingTermStructure(), dc, false));
+        indices.push_back(index->clone(Handle<YieldTermStructure>(fwdCurves.back())));
+    }
+    auto swaptionVol = QuantLib::ext::make_shared<CrossAssetModelImpliedSwaptionVolTermStructure>(
+        model, discountCurve, indices, parseSwapIndex(d.market->swapIndexBase("EUR")),
+        parseSwapIndex(d.market->shortSwapIndexBase("EUR")));
+
+    Size samples = 10;
+    auto referencePaths = buildPathGenerator();
+    std::vector<std::vector<std::map<RiskFactorKey, Real>>> expected(samples);
+    for (Size p = 0; p < samples; ++p) {
+        const MultiPath& path = referencePaths->next().value;
+        for (Size i = 0; i < grid->dates().size(); ++i) {
+            Date date = grid->dates()[i];
+            Time t = grid->timeGrid()[i + 1];
+            Array state(1, path[model->pIdx(CrossAssetModel::AssetType::IR, 0)][i + 1]);
+            discountCurve->move(t, state);
+            for (Size j = 0; j < fwdCurves.size(); ++j) {
+                Real z = path[model->pIdx(CrossAssetModel::AssetType::IR, indexCcys[j])][i + 1];
+                fwdCurves[j]->move(date, Array(1, z));
+            }
+            swaptionVol->move(date, state[0]);
+            std::map<RiskFactorKey, Real> values;
+            for (Size k = 0; k < simMarketConfig->yieldCurveTenors("EUR").size(); ++k) {
+                Time T = dc.yearFraction(date, date + simMarketConfig->yieldCurveTenors("EUR")[k]);
+                values[RiskFactorKey(RiskFactorKey::KeyType::DiscountCurve, "EUR", k)] = discountCurve->discount(T);
+            }
+            for (Size j = 0; j < swapVolExpiries.size(); ++j) {
+                for (Size k = 0; k < swapVolTerms.size(); ++k) {
+                    values[RiskFactorKey(RiskFactorKey::KeyType::SwaptionVolatility, "EUR",
+                                         j * swapVolTerms.size() + k)] =
+                        swaptionVol->volatility(date + swapVolExpiries[j], swapVolTerms[k], Null<Real>(), true);
+                }
+            }
+            expected[p].push_back(values);
+        }
+    }
+
+    for (Size batchSize : {1, 4, 10}) {
+        auto generator = QuantLib::ext::make_shared<CrossAssetModelScenarioGenerator>(
+            model, buildPathGenerator(), QuantLib::ext::make_shared<SimpleScenarioFactory>(true), simMarketConfig,
+            today, grid, d.market);
+        generator->setBatchSize(batchSize);
+        for (Size p = 0; p < samples; ++p) {
+            for (Size i = 0; i < grid->dates().size(); ++i) {
+                auto scenario = generator->next(grid->dates()[i]);
+                for (auto const& [key, value] : expected[p][i]) {
+                    BOOST_REQUIRE(scenario->has(key));
+                    BOOST_CHECK_MESSAGE(std::abs(scenario->get(key) - value) < 1E-10,
+                                        "batch size " << batchSize << ", path " << p << ", date " << i << ", " << key
+                                                      << ": " << scenario->get(key) << " vs expected " << value);
+                }
+            }
+        }
+    }
+}
+
 BOOST_AUTO_TEST_CASE(testCrossAssetSimMarket) {
     BOOST_TEST_MESSAGE("Testing CrossAssetScenarioGenerator via SimMarket (Martingale tests)...");
     setConventions();
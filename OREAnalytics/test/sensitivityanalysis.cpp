@@ -19,9 +19,11 @@
 #include <boost/test/unit_test.hpp>
 #include <boost/timer/timer.hpp>
 #include <orea/cube/inmemorycube.hpp>
+#include <orea/cube/sensicube.hpp>
 #include <orea/engine/filteredsensitivitystream.hpp>
 #include <orea/engine/observationmode.hpp>
 #include <orea/engine/parametricvar.hpp>
+#include <orea/engine/riskfactordependencies.hpp>
 #include <orea/engine/riskfilter.hpp>
 #include <orea/engine/sensitivityaggregator.hpp>
 #include <orea/engine/sensitivityanalysis.hpp>
@@ -34,6 +36,7 @@
 #include <orea/engine/valuationcalculator.hpp>
 #include <orea/engine/valuationengine.hpp>
 #include <orea/scenario/clonescenariofactory.hpp>
+#include <orea/scenario/deltascenariofactory.hpp>
 #include <orea/scenario/scenariosimmarket.hpp>
 #include <orea/scenario/sensitivityscenariogenerator.hpp>
 #include <ored/portfolio/builders/capfloor.hpp>
@@ -841,6 +844,11 @@ BOOST_AUTO_TEST_CASE(testPortfolioSensitivityUnregisterObs) {
     testPortfolioSensitivity(ObservationMode::Mode::Unregister);
 }
 
+BOOST_AUTO_TEST_CASE(testPortfolioSensitivityBatchObs) {
+    BOOST_TEST_MESSAGE("Testing Portfolio sensitivity (Batch observation mode)");
+    testPortfolioSensitivity(ObservationMode::Mode::Batch);
+}
+
 void test1dShifts(bool granular) {
     BOOST_TEST_MESSAGE("Testing 1d shifts " << (granular ? "granular" : "sparse"));
 
@@ -2010,6 +2018,112 @@ BOOST_AUTO_TEST_CASE(testCrossGamma) {
     IndexManager::instance().clearHistories();
 }
 
+BOOST_AUTO_TEST_CASE(testSkipIndependentTrades) {
+
+    BOOST_TEST_MESSAGE("Testing sensitivities when pricing the dependent trades only");
+
+    SavedSettings backup;
+
+    Date today = Date(14, April, 2016);
+    Settings::instance().evaluationDate() = today;
+
+    QuantLib::ext::shared_ptr<Market> initMarket = QuantLib::ext::make_shared<TestMarket>(today);
+    QuantLib::ext::shared_ptr<analytics::ScenarioSimMarketParameters> simMarketData =
+        TestConfigurationObjects::setupSimMarketData5();
+    QuantLib::ext::shared_ptr<SensitivityScenarioData> sensiData =
+        TestConfigurationObjects::setupSensitivityScenarioData5();
+    // include a few cross scenarios
+    sensiData->crossGammaFilter().push_back(pair<string, string>("DiscountCurve/EUR", "DiscountCurve/USD"));
+    sensiData->crossGammaFilter().push_back(pair<string, string>("FXSpot/EURUSD", "IndexCurve/EUR"));
+
+    auto simMarket = QuantLib::ext::make_shared<analytics::ScenarioSimMarket>(initMarket, simMarketData);
+    QuantLib::ext::shared_ptr<Scenario> baseScenario = simMarket->baseScenario();
+    auto scenarioFactory = QuantLib::ext::make_shared<DeltaScenarioFactory>(baseScenario);
+    auto scenarioGenerator = QuantLib::ext::make_shared<SensitivityScenarioGenerator>(
+        sensiData, baseScenario, simMarketData, simMarket, scenarioFactory, false);
+    simMarket->scenarioGenerator() = scenarioGenerator;
+
+    QuantLib::ext::shared_ptr<EngineData> data = QuantLib::ext::make_shared<EngineData>();
+    data->model("Swap") = "DiscountedCashflows";
+    data->engine("Swap") = "DiscountingSwapEngine";
+    data->model("EuropeanSwaption") = "BlackBachelier";
+    data->engine("EuropeanSwaption") = "BlackBachelierSwaptionEngine";
+    data->model("FxOption") = "GarmanKohlhagen";
+    data->engine("FxOption") = "AnalyticEuropeanEngine";
+    data->model("CapFloor") = "IborCapModel";
+    data->engine("CapFloor") = "IborCapEngine";
+    data->model("EquityOption") = "BlackScholesMerton";
+    data->engine("EquityOption") = "AnalyticEuropeanEngine";
+    data->model("CommodityForward") = "DiscountedCashflows";
+    data->engine("CommodityForward") = "DiscountingCommodityForwardEngine";
+    auto factory = QuantLib::ext::make_shared<EngineFactory>(data, simMarket);
+
+    auto portfolio = QuantLib::ext::make_shared<Portfolio>();
+    portfolio->add(buildSwap("1_Swap_EUR", "EUR", true, 10000000.0, 0, 10, 0.03, 0.00, "1Y", "30/360", "6M", "A360",
+                             "EUR-EURIBOR-6M"));
+    portfolio->add(buildSwap("2_Swap_USD", "USD", true, 10000000.0, 0, 15, 0.02, 0.00, "6M", "30/360", "3M", "A360",
+                             "USD-LIBOR-3M"));
+    portfolio->add(buildSwap("3_Swap_GBP", "GBP", true, 10000000.0, 0, 20, 0.04, 0.00, "6M", "30/360", "3M", "A360",
+                             "GBP-LIBOR-6M"));
+    portfolio->add(buildEuropeanSwaption("4_Swaption_EUR", "Long", "EUR", true, 1000000.0, 10, 10, 0.02, 0.00, "1Y",
+                                         "30/360", "6M", "A360", "EUR-EURIBOR-6M", "Physical"));
+    portfolio->add(buildFxOption("5_FxOption_EUR_USD", "Long", "Call", 3, "EUR", 10000000.0, "USD", 11000000.0));
+    portfolio->add(buildCap("6_Cap_EUR", "EUR", "Long", 0.05, 1000000.0, 0, 10, "6M", "A360", "EUR-EURIBOR-6M"));
+    portfolio->add(buildEquityOption("7_EquityOption_SP5", "Long", "Call", 2, "SP5", "USD", 2147.56, 775));
+    portfolio->add(buildCommodityForward("8_CommodityForward_GOLD", "Long", 1, "COMDTY_GOLD_USD", "USD", 1170.0, 100));
+
+    RiskFactorDependencies dependencies(portfolio, data, simMarketData->baseCcy(), baseScenario->keys());
+    BOOST_CHECK(dependencies.unknownTrades().empty());
+    BOOST_CHECK(dependencies.dependsOn("1_Swap_EUR", RiskFactorKey(RiskFactorKey::KeyType::DiscountCurve, "EUR", 0)));
+    BOOST_CHECK(!dependencies.dependsOn("1_Swap_EUR", RiskFactorKey(RiskFactorKey::KeyType::DiscountCurve, "USD", 0)));
+    BOOST_CHECK(!dependencies.dependsOn("1_Swap_EUR", RiskFactorKey(RiskFactorKey::KeyType::FXSpot, "EURUSD", 0)));
+    BOOST_CHECK(dependencies.dependsOn("2_Swap_USD", RiskFactorKey(RiskFactorKey::KeyType::FXSpot, "EURUSD", 0)));
+    BOOST_CHECK(!dependencies.dependsOn("2_Swap_USD", RiskFactorKey(RiskFactorKey::KeyType::FXSpot, "EURGBP", 0)));
+    BOOST_CHECK(dependencies.dependsOn("6_Cap_EUR",
+                                       RiskFactorKey(RiskFactorKey::KeyType::OptionletVolatility, "EUR", 0)));
+    BOOST_CHECK(!dependencies.dependsOn("2_Swap_USD",
+                                        RiskFactorKey(RiskFactorKey::KeyType::OptionletVolatility, "EUR", 0)));
+
+    portfolio->build(factory);
+
+    QuantLib::ext::shared_ptr<DateGrid> dg = QuantLib::ext::make_shared<DateGrid>("1,0W");
+    vector<QuantLib::ext::shared_ptr<ValuationCalculator>> calculators;
+    calculators.push_back(QuantLib::ext::make_shared<NPVCalculator>(simMarketData->baseCcy()));
+    ValuationEngine engine(today, dg, simMarket, factory->modelBuilders());
+
+    auto fullCube = QuantLib::ext::make_shared<DoublePrecisionSensiCube>(portfolio->ids(), today,
+                                                                         scenarioGenerator->samples());
+    engine.buildCube(portfolio, fullCube, calculators);
+
+    auto sampleTrades = dependencies.dependentTrades(*portfolio, scenarioGenerator->scenarios());
+    BOOST_REQUIRE_EQUAL(sampleTrades.size(), scenarioGenerator->samples());
+    BOOST_CHECK(!sampleTrades.front());
+    Size nValuations = 0;
+    for (auto const& t : sampleTrades)
+        nValuations += t ? t->size() : portfolio->size();
+    BOOST_TEST_MESSAGE("Trade valuations: " << nValuations << " instead of "
+                                            << portfolio->size() * scenarioGenerator->samples());
+    BOOST_CHECK(nValuations < portfolio->size() * scenarioGenerator->samples());
+
+    scenarioGenerator->reset();
+    auto cube = QuantLib::ext::make_shared<DoublePrecisionSensiCube>(portfolio->ids(), today,
+                                                                     scenarioGenerator->samples());
+    engine.buildCube(portfolio, cube, calculators, ValuationEngine::ErrorPolicy::RemoveAll, true, nullptr, nullptr, {},
+                     false, nullptr, sampleTrades);
+
+    for (Size i = 0; i < portfolio->size(); ++i) {
+        BOOST_CHECK_CLOSE(cube->getT0(i, 0), fullCube->getT0(i, 0), 1E-10);
+        for (Size k = 0; k < scenarioGenerator->samples(); ++k) {
+            BOOST_CHECK_MESSAGE(QuantLib::close_enough(cube->get(i, 0, k, 0), fullCube->get(i, 0, k, 0)),
+                                "trade " << i << ", scenario " << k << ": value " << cube->get(i, 0, k, 0)
+                                         << " does not match value " << fullCube->get(i, 0, k, 0)
+                                         << " from full revaluation");
+        }
+    }
+
+    IndexManager::instance().clearHistories();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -550,7 +550,9 @@ void test_performance(bool bigPortfolio, bool bigScenario, bool lotsOfSensis, bo
                               ? "Disable"
                               : (om == ObservationMode::Mode::Defer)
                                     ? "Defer"
-                                    : (om == ObservationMode::Mode::Unregister) ? "Unregister" : "???";
+                                    : (om == ObservationMode::Mode::Unregister)
+                                          ? "Unregister"
+                                          : (om == ObservationMode::Mode::Batch) ? "Batch" : "???";
     string bigPfolioStr = bigPortfolio ? "big" : "small";
     string bigScenarioStr = bigScenario ? "big" : "small";
     string lotsOfSensisStr = lotsOfSensis ? "lots" : "few";
@@ -644,6 +646,10 @@ BOOST_AUTO_TEST_CASE(testSensiPerformanceUnregisterObs) {
     test_performance(false, false, false, false, ObservationMode::Mode::Unregister);
 }
 
+BOOST_AUTO_TEST_CASE(testSensiPerformanceBatchObs) {
+    test_performance(false, false, false, false, ObservationMode::Mode::Batch);
+}
+
 BOOST_AUTO_TEST_CASE(testSensiPerformanceCrossGammaNoneObs) {
     test_performance(false, false, false, true, ObservationMode::Mode::None);
 }
@@ -0,0 +1,122 @@
+/*
+ Copyright (C) 2025 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+#include <boost/test/unit_test.hpp>
+#include <orea/simm/crifloader.hpp>
+#include <orea/simm/simmbucketmapperbase.hpp>
+#include <orea/simm/simmcalculator.hpp>
+#include <orea/simm/utilities.hpp>
+#include <oret/datapaths.hpp>
+#include <oret/toplevelfixture.hpp>
+#include <test/oreatoplevelfixture.hpp>
+
+using namespace std;
+using namespace QuantLib;
+using namespace ore::analytics;
+using namespace ore::data;
+
+namespace {
+
+typedef SimmConfiguration::SimmSide SimmSide;
+typedef SimmConfiguration::RiskClass RiskClass;
+typedef SimmConfiguration::MarginType MarginType;
+
+QuantLib::ext::shared_ptr<Crif> loadCrif(const QuantLib::ext::shared_ptr<SimmConfiguration>& config) {
+    CsvFileCrifLoader loader(TEST_INPUT_FILE("crif.csv"), config, CrifRecord::additionalHeaders, true, false, true,
+                             '\n', ',', '"');
+    return loader.loadCrif();
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(OREAnalyticsTestSuite, ore::test::OreaTopLevelFixture)
+
+BOOST_AUTO_TEST_SUITE(SimmCalculatorTest)
+
+BOOST_AUTO_TEST_CASE(testParallelCalculation) {
+
+    BOOST_TEST_MESSAGE("Testing SIMM calculated on several threads...");
+
+    /* The CRIF of Examples/InitialMargin for SIMM 2.6 with 10 day MPOR, and a second netting set with twice the
+       sensitivities, so that there are several netting sets and regulations to calculate concurrently */
+    auto config = buildSimmConfiguration("2.6", QuantLib::ext::make_shared<SimmBucketMapperBase>(), nullptr, 10);
+
+    auto calculator = [&config](const Size nThreads) {
+        return QuantLib::ext::make_shared<SimmCalculator>(loadCrif(config), config, "USD", "USD", "USD", nullptr, true,
+                                                          true, true, std::map<SimmSide, set<NettingSetDetails>>(),
+                                                          nThreads);
+    };
+    auto serial = calculator(1);
+    auto parallel = calculator(4);
+
+    // the results of the example, see Examples/InitialMargin/ExpectedOutput/SIMM2.6_10D/simm.csv
+    NettingSetDetails nsd("CRIF_20201228");
+    const auto& call = serial->finalSimmResults(SimmSide::Call, nsd);
+    const auto& post = serial->finalSimmResults(SimmSide::Post, nsd);
+    BOOST_CHECK_EQUAL(call.first, CrifRecord::Regulation::ESA);
+    BOOST_CHECK_EQUAL(post.first, CrifRecord::Regulation::CFTC);
+    BOOST_CHECK_CLOSE(call.second.get(CrifRecord::ProductClass::All, RiskClass::All, MarginType::All, "All"),
+                      1086219.458910127, 1E-8);
+    BOOST_CHECK_CLOSE(post.second.get(CrifRecord::ProductClass::All, RiskClass::All, MarginType::All, "All"),
+                      1022075.910765837, 1E-8);
+    BOOST_CHECK_CLOSE(call.second.get(CrifRecord::ProductClass::RatesFX, RiskClass::InterestRate, MarginType::Delta,
+                                      "All"),
+                      811888.163042849, 1E-8);
+    BOOST_CHECK_CLOSE(call.second.get(CrifRecord::ProductClass::RatesFX, RiskClass::InterestRate, MarginType::Vega,
+                                      "All"),
+                      210187.747722988, 1E-8);
+
+    // the parallel calculation gives the same results for all sides, netting sets and regulations
+    const auto& serialResults = serial->simmResults();
+    const auto& parallelResults = parallel->simmResults();
+    BOOST_REQUIRE_EQUAL(serialResults.size(), parallelResults.size());
+    for (const auto& [side, nettingSets] : serialResults) {
+        BOOST_REQUIRE(parallelResults.count(side) > 0);
+        BOOST_REQUIRE_EQUAL(nettingSets.size(), parallelResults.at(side).size());
+        for (const auto& [nettingSet, regulations] : nettingSets) {
+            BOOST_REQUIRE(parallelResults.at(side).count(nettingSet) > 0);
+            const auto& parallelRegulations = parallelResults.at(side).at(nettingSet);
+            BOOST_REQUIRE_EQUAL(regulations.size(), parallelRegulations.size());
+            for (const auto& [regulation, results] : regulations) {
+                BOOST_REQUIRE(parallelRegulations.count(regulation) > 0);
+                const auto& parallelData = parallelRegulations.at(regulation).data();
+                BOOST_REQUIRE_EQUAL(results.data().size(), parallelData.size());
+                for (const auto& [key, im] : results.data()) {
+                    BOOST_REQUIRE(parallelData.count(key) > 0);
+                    BOOST_CHECK_MESSAGE(parallelData.at(key) == im, "SIMM differs for " << side << ", "
+                                                                                         << nettingSet << ", " << key
+                                                                                         << ": serial " << im
+                                                                                         << ", parallel "
+                                                                                         << parallelData.at(key));
+                }
+            }
+        }
+        for (const auto& [nettingSet, winning] : serial->finalSimmResults(side)) {
+            const auto& parallelWinning = parallel->finalSimmResults(side, nettingSet);
+            BOOST_CHECK_EQUAL(winning.first, parallelWinning.first);
+            BOOST_CHECK_EQUAL(winning.second.get(CrifRecord::ProductClass::All, RiskClass::All, MarginType::All, "All"),
+                              parallelWinning.second.get(CrifRecord::ProductClass::All, RiskClass::All,
+                                                         MarginType::All, "All"));
+        }
+    }
+    BOOST_CHECK_EQUAL(serialResults.at(SimmSide::Call).size(), 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -159,10 +159,12 @@ void CurveConfigurations::parseNode(const CurveSpec::CurveType& type, const stri
 
 void CurveConfigurations::add(const CurveSpec::CurveType& type, const string& curveId,
     const QuantLib::ext::shared_ptr<CurveConfig>& config) {
+    boost::unique_lock<boost::shared_mutex> lock(mutex_);
     configs_[type][curveId] = config;
 }
 
 bool CurveConfigurations::has(const CurveSpec::CurveType& type, const string& curveId) const {
+    boost::shared_lock<boost::shared_mutex> lock(mutex_);
     return (curveConfigOverride_ && curveConfigOverride_->has(type, curveId)) ||
         (configs_.count(type) > 0 && configs_.at(type).count(curveId) > 0) ||
         (unparsed_.count(type) > 0 && unparsed_.at(type).count(curveId) > 0);
@@ -171,6 +173,19 @@ bool CurveConfigurations::has(const CurveSpec::CurveType& type, const string& cu
 const QuantLib::ext::shared_ptr<CurveConfig>& CurveConfigurations::get(const CurveSpec::CurveType& type,
                                                                        const string& curveId) const {
 
+    {
+        boost::shared_lock<boost::shared_mutex> lock(mutex_);
+        const auto& it = configs_.find(type);
+        if (it != configs_.end()) {
+            const auto& itc = it->second.find(curveId);
+            if (itc != it->second.end()) {
+                return itc->second;
+            }
+        }
+    }
+
+    // the config has to be added, check again, another thread might have done this in the meantime
+    boost::unique_lock<boost::shared_mutex> lock(mutex_);
     const auto& it = configs_.find(type);
     if (it != configs_.end()) {
         const auto& itc = it->second.find(curveId);
@@ -46,6 +46,8 @@
 #include <ored/portfolio/referencedata.hpp>
 #include <ored/utilities/xmlutils.hpp>
 
+#include <boost/thread/shared_mutex.hpp>
+
 #include <typeindex>
 #include <typeinfo>
 
@@ -198,6 +200,8 @@ public:
 
     mutable std::map<CurveSpec::CurveType, std::map<std::string, QuantLib::ext::shared_ptr<CurveConfig>>> configs_;
     mutable std::map<CurveSpec::CurveType, std::map<std::string, std::string>> unparsed_;
+    // guards the lazy parsing in get(), so that the configs can be retrieved from several threads
+    mutable boost::shared_mutex mutex_;
 
     // utility function for parsing a node of name "parentName" and storing the result in the map
     void parseNode(const CurveSpec::CurveType& type, const string& curveId) const;
@@ -22,191 +22,429 @@
 */
 
 #include <algorithm>
-#include <boost/algorithm/string.hpp>
-#include <fstream>
+#include <boost/filesystem/operations.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <cctype>
+#include <cstring>
 #include <map>
 #include <ored/marketdata/csvloader.hpp>
 #include <ored/marketdata/marketdatumparser.hpp>
 #include <ored/utilities/log.hpp>
 #include <ored/utilities/parsers.hpp>
+#include <qle/utilities/workerpool.hpp>
+#include <string_view>
+#include <unordered_map>
 
 using namespace std;
 
 namespace ore {
 namespace data {
 
+struct CSVLoader::LoadedData {
+    // in the order of the files and lines
+    std::vector<QuantLib::ext::shared_ptr<MarketDatum>> quotes;
+    std::vector<Fixing> fixings;
+    std::vector<QuantExt::Dividend> dividends;
+};
+
 CSVLoader::CSVLoader(const string& marketFilename, const string& fixingFilename, bool implyTodaysFixings,
-		     Date fixingCutOffDate)
-    : CSVLoader(marketFilename, fixingFilename, "", implyTodaysFixings, fixingCutOffDate) {}
+                     Date fixingCutOffDate, Size nThreads)
+    : CSVLoader(marketFilename, fixingFilename, "", implyTodaysFixings, fixingCutOffDate, nThreads) {}
 
-CSVLoader::CSVLoader(const vector<string>& marketFiles, const vector<string>& fixingFiles, bool implyTodaysFixings, Date fixingCutOffDate)
-    : CSVLoader(marketFiles, fixingFiles, {}, implyTodaysFixings, fixingCutOffDate) {}
+CSVLoader::CSVLoader(const vector<string>& marketFiles, const vector<string>& fixingFiles, bool implyTodaysFixings,
+                     Date fixingCutOffDate, Size nThreads)
+    : CSVLoader(marketFiles, fixingFiles, {}, implyTodaysFixings, fixingCutOffDate, nThreads) {}
 
 CSVLoader::CSVLoader(const string& marketFilename, const string& fixingFilename, const string& dividendFilename,
-                     bool implyTodaysFixings, Date fixingCutOffDate)
-    : implyTodaysFixings_(implyTodaysFixings), fixingCutOffDate_(fixingCutOffDate) {
-
-    // load market data
-    loadFile(marketFilename, DataType::Market);
-    // log
-    for (auto it : data_) {
-        LOG("CSVLoader loaded " << it.second.size() << " market data points for " << it.first);
-    }
-
-    // load fixings
-    loadFile(fixingFilename, DataType::Fixing);
-    LOG("CSVLoader loaded " << fixings_.size() << " fixings");
-
-    // load dividends
-    if (dividendFilename != "") {
-        loadFile(dividendFilename, DataType::Dividend);
-        LOG("CSVLoader loaded " << dividends_.size() << " dividends");
-    }
-
-    LOG("CSVLoader complete.");
-}
+                     bool implyTodaysFixings, Date fixingCutOffDate, Size nThreads)
+    : CSVLoader(vector<string>{marketFilename}, vector<string>{fixingFilename},
+                dividendFilename.empty() ? vector<string>() : vector<string>{dividendFilename}, implyTodaysFixings,
+                fixingCutOffDate, nThreads) {}
 
 CSVLoader::CSVLoader(const vector<string>& marketFiles, const vector<string>& fixingFiles,
-                     const vector<string>& dividendFiles, bool implyTodaysFixings,
-		     Date fixingCutOffDate)
+                     const vector<string>& dividendFiles, bool implyTodaysFixings, Date fixingCutOffDate,
+                     Size nThreads)
     : implyTodaysFixings_(implyTodaysFixings), fixingCutOffDate_(fixingCutOffDate) {
 
-    for (auto marketFile : marketFiles)
+    std::unique_ptr<QuantExt::WorkerPool> pool;
+    if (nThreads > 1)
+        pool = std::make_unique<QuantExt::WorkerPool>(nThreads);
+
+    LoadedData loaded;
+
+    for (auto const& marketFile : marketFiles)
         // load market data
-        loadFile(marketFile, DataType::Market);
+        loadFile(marketFile, DataType::Market, pool.get(), loaded);
+    setQuotes(loaded.quotes, pool.get());
 
     // log
-    for (auto it : data_)
-        LOG("CSVLoader loaded " << it.second.size() << " market data points for " << it.first);
+    for (auto const& it : data_)
+        LOG("CSVLoader loaded " << it.second.data.size() << " market data points for " << it.first);
 
-    for (auto fixingFile : fixingFiles)
+    for (auto const& fixingFile : fixingFiles)
         // load fixings
-        loadFile(fixingFile, DataType::Fixing);
-    LOG("CSVLoader loaded " << fixings_.size() << " fixings");
+        loadFile(fixingFile, DataType::Fixing, pool.get(), loaded);
+    setFixings(loaded.fixings);
+    LOG("CSVLoader loaded " << fixingDates_.size() << " fixings");
 
-    for (auto dividendFile : dividendFiles)
+    for (auto const& dividendFile : dividendFiles)
         // load dividends
-        loadFile(dividendFile, DataType::Dividend);
+        loadFile(dividendFile, DataType::Dividend, pool.get(), loaded);
+    for (auto const& d : loaded.dividends) {
+        if (!dividends_.insert(d).second) {
+            WLOG("Skipped Dividend " << d.name << "@" << QuantLib::io::iso_date(d.exDate)
+                                     << " - this is already present.");
+        }
+    }
     LOG("CSVLoader loaded " << dividends_.size() << " dividends");
 
     LOG("CSVLoader complete.");
 }
 
+namespace {
+
 QuantLib::ext::shared_ptr<MarketDatum> makeDummyMarketDatum(const Date& d, const std::string& name) {
     return QuantLib::ext::make_shared<MarketDatum>(0.0, d, name, MarketDatum::QuoteType::NONE,
-                                           MarketDatum::InstrumentType::NONE);
+                                                   MarketDatum::InstrumentType::NONE);
+}
+
+bool isFxSpotRate(const QuantLib::ext::shared_ptr<MarketDatum>& md) {
+    return md->instrumentType() == MarketDatum::InstrumentType::FX_SPOT &&
+           md->quoteType() == MarketDatum::QuoteType::RATE;
+}
+
+bool isSpace(const char c) { return std::isspace(static_cast<unsigned char>(c)); }
+
+bool isSeparator(const char c) { return c == ',' || c == ';' || c == '\t' || c == ' '; }
+
+// [begin, end) of a token
+using Token = std::pair<const char*, const char*>;
+
+/* splits the trimmed line into tokens, consecutive separators are treated as one, i.e. the result is the same as
+   boost::split(tokens, line, boost::is_any_of(",;\t "), boost::token_compress_on) */
+void tokenize(const char* begin, const char* end, std::vector<Token>& tokens) {
+    tokens.clear();
+    const char* t = begin;
+    for (const char* p = begin;; ++p) {
+        if (p == end || isSeparator(*p)) {
+            tokens.push_back(Token(t, p));
+            if (p == end)
+                break;
+            while (p + 1 < end && isSeparator(*(p + 1)))
+                ++p;
+            t = p + 1;
+        }
+    }
+}
+
+// begin positions of chunks of whole lines
+std::vector<const char*> chunkBoundaries(const char* begin, const char* end, const Size nChunks) {
+    std::vector<const char*> result(1, begin);
+    Size size = end - begin;
+    for (Size k = 1; k < nChunks; ++k) {
+        const char* p = std::max(begin + k * size / nChunks, result.back());
+        p = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        if (p == nullptr)
+            break;
+        if (p + 1 < end)
+            result.push_back(p + 1);
+    }
+    return result;
 }
 
-void CSVLoader::loadFile(const string& filename, DataType dataType) {
+// parses dates, dates on consecutive lines are usually the same and are only parsed once
+class DateParser {
+public:
+    Date operator()(const Token& t) {
+        Size n = t.second - t.first;
+        if (n != last_.size() || std::memcmp(t.first, last_.data(), n) != 0) {
+            last_.assign(t.first, t.second);
+            date_ = parseDate(last_);
+        }
+        return date_;
+    }
+
+private:
+    std::string last_ = "\n";
+    Date date_;
+};
+
+} // namespace
+
+void CSVLoader::loadFile(const string& filename, DataType dataType, QuantExt::WorkerPool* pool,
+                         LoadedData& loaded) const {
     LOG("CSVLoader loading from " << filename);
 
     Date today = QuantLib::Settings::instance().evaluationDate();
 
-    ifstream file;
-    file.open(filename.c_str());
+    QL_REQUIRE(boost::filesystem::is_regular_file(filename), "error opening file " << filename);
+    if (boost::filesystem::file_size(filename) == 0) {
+        LOG("CSVLoader completed processing " << filename << " (empty file)");
+        return;
+    }
+    boost::iostreams::mapped_file_source file;
+    try {
+        file.open(filename);
+    } catch (const std::exception& e) {
+        QL_FAIL("error opening file " << filename << ": " << e.what());
+    }
     QL_REQUIRE(file.is_open(), "error opening file " << filename);
 
-    while (!file.eof()) {
-        string line;
-        getline(file, line);
-        boost::trim(line);
-        // skip blank and comment lines
-        if (line.size() > 0 && line[0] != '#') {
-
-            vector<string> tokens;
-            boost::trim(line);
-            boost::split(tokens, line, boost::is_any_of(",;\t "), boost::token_compress_on);
-
-            // TODO: should we try, catch and log any invalid lines?
-            QL_REQUIRE(tokens.size() == 3 || dataType == DataType::Dividend,
-                       "Invalid CSVLoader line, expected 3 columns, got " << tokens.size() << ": " << line);
-            QL_REQUIRE(tokens.size() >= 3 || tokens.size() <= 5,
-                       "Invalid CSVLoader line, between 3 and 5 tokens expected, got " << tokens.size() << ": "
-                                                                                       << line);
-            Date date = parseDate(tokens[0]);
-            const string& key = tokens[1];
-            Real value = parseReal(tokens[2]);
-
-            if (dataType == DataType::Market) {
-                // process market
-                // build market datum and add to map
-                try {
-                    QuantLib::ext::shared_ptr<MarketDatum> md;
+    // parse the chunks of the file, this does not touch any thread local singletons
+
+    struct Chunk {
+        LoadedData data;
+        std::string error;
+    };
+
+    auto chunkBegin = chunkBoundaries(file.data(), file.data() + file.size(), pool ? 4 * pool->size() : 1);
+    chunkBegin.push_back(file.data() + file.size());
+    std::vector<Chunk> chunks(chunkBegin.size() - 1);
+
+    auto parseChunk = [this, dataType, today, &chunkBegin, &chunks](const Size c) {
+        auto& result = chunks[c].data;
+        std::vector<Token> tokens;
+        std::string key, value;
+        DateParser dateParser;
+        const char* end = chunkBegin[c + 1];
+        for (const char* lineBegin = chunkBegin[c]; lineBegin < end;) {
+            const char* lineEnd = static_cast<const char*>(std::memchr(lineBegin, '\n', end - lineBegin));
+            if (lineEnd == nullptr)
+                lineEnd = end;
+            const char* b = lineBegin;
+            const char* e = lineEnd;
+            lineBegin = lineEnd + 1;
+            while (b < e && isSpace(*b))
+                ++b;
+            while (e > b && isSpace(*(e - 1)))
+                --e;
+            // skip blank and comment lines
+            if (b == e || *b == '#')
+                continue;
+            tokenize(b, e, tokens);
+            try {
+                QL_REQUIRE(tokens.size() == 3 || dataType == DataType::Dividend,
+                           "Invalid CSVLoader line, expected 3 columns, got " << tokens.size() << ": "
+                                                                              << std::string(b, e));
+                QL_REQUIRE(tokens.size() >= 3 && tokens.size() <= 5,
+                           "Invalid CSVLoader line, between 3 and 5 tokens expected, got "
+                               << tokens.size() << ": " << std::string(b, e));
+                Date date = dateParser(tokens[0]);
+                key.assign(tokens[1].first, tokens[1].second);
+                value.assign(tokens[2].first, tokens[2].second);
+                Real v = parseReal(value);
+                if (dataType == DataType::Market) {
+                    // process market
                     try {
-                        md = parseMarketDatum(date, key, value);
+                        if (auto md = parseMarketDatum(date, key, v))
+                            result.quotes.push_back(md);
                     } catch (std::exception& e) {
                         WLOG("Failed to parse MarketDatum " << key << ": " << e.what());
                     }
-                    if (md != nullptr) {
-                        std::pair<bool, string> addFX = {true, ""};
-                        if (md->instrumentType() == MarketDatum::InstrumentType::FX_SPOT &&
-                            md->quoteType() == MarketDatum::QuoteType::RATE) {
-                            addFX = checkFxDuplicate(md, date);
-                            if (!addFX.second.empty()) {
-                                auto it2 = data_[date].find(makeDummyMarketDatum(date, addFX.second));
-                                TLOG("Replacing MarketDatum " << addFX.second << " with " << key
-                                                                  << " due to FX Dominance.");
-                                if (it2 != data_[date].end())
-                                    data_[date].erase(it2);
-                            }
-                        }
-                        if (addFX.first && data_[date].insert(md).second) {
-                            TLOG("Added MarketDatum " << key);
-                        } else if (!addFX.first) {
-                            DLOG("Skipped MarketDatum " << key << " - dominant FX already present.")
-                        }
-						else {
-                            DLOG("Skipped MarketDatum " << key << " - this is already present.");
-                        }
-                    }
-                } catch (std::exception& e) {
-                    WLOG("Failed to parse MarketDatum " << key << ": " << e.what());
-                }
-            } else if (dataType == DataType::Fixing) {
-                // process fixings
-                if (date < today || (date == today && !implyTodaysFixings_)
-		    || (fixingCutOffDate_ != Date() && date <= fixingCutOffDate_)) {
-                    if(!fixings_.insert(Fixing(date, key, value)).second) {
-                        WLOG("Skipped Fixing " << key << "@" << QuantLib::io::iso_date(date)
-                                               << " - this is already present.");
+                } else if (dataType == DataType::Fixing) {
+                    // process fixings
+                    if (date < today || (date == today && !implyTodaysFixings_) ||
+                        (fixingCutOffDate_ != Date() && date <= fixingCutOffDate_))
+                        result.fixings.push_back(Fixing(date, key, v));
+                } else if (dataType == DataType::Dividend) {
+                    Date payDate = date;
+                    Date announcementDate = date;
+                    if (tokens.size() > 3) {
+                        if (tokens[3].first != tokens[3].second)
+                            payDate = parseDate(std::string(tokens[3].first, tokens[3].second));
+                        if (tokens.size() == 5 && tokens[4].first != tokens[4].second)
+                            announcementDate = parseDate(std::string(tokens[4].first, tokens[4].second));
                     }
+                    // process dividends
+                    result.dividends.push_back(QuantExt::Dividend(date, key, v, payDate, announcementDate));
+                } else {
+                    QL_FAIL("CSVLoader: unknown data type (" << static_cast<int>(dataType) << ").");
                 }
-            } else if (dataType == DataType::Dividend) {
-                Date payDate = date;
-                Date announcementDate = date;
-                if (tokens.size() > 3) {
-                    if (!tokens[3].empty())
-                        payDate = parseDate(tokens[3]);
-                    if (tokens.size() == 5 && !tokens[4].empty())
-                        announcementDate = parseDate(tokens[4]);
-                }
-                // process dividends
-                if (!dividends_.insert(QuantExt::Dividend(date, key, value, payDate, announcementDate)).second) {
-                    WLOG("Skipped Dividend " << key << "@" << QuantLib::io::iso_date(date)
-                                                << " - this is already present.");
-                }
-            } else {
-                QL_FAIL("CSVLoader: unknown data type (" << static_cast<int>(dataType) << ").");
+            } catch (const std::exception& e) {
+                // the first error in the file is reported below
+                chunks[c].error = e.what();
+                return;
             }
         }
+    };
+
+    if (pool != nullptr && chunks.size() > 1) {
+        pool->parallelFor(chunks.size(), 1, [&parseChunk](std::size_t begin, std::size_t end, std::size_t) {
+            for (std::size_t c = begin; c < end; ++c)
+                parseChunk(c);
+        });
+    } else {
+        for (Size c = 0; c < chunks.size(); ++c)
+            parseChunk(c);
     }
-    file.close();
+
+    // collect the results in file order
+
+    for (auto& c : chunks) {
+        QL_REQUIRE(c.error.empty(), c.error);
+        loaded.quotes.insert(loaded.quotes.end(), c.data.quotes.begin(), c.data.quotes.end());
+        loaded.fixings.insert(loaded.fixings.end(), c.data.fixings.begin(), c.data.fixings.end());
+        loaded.dividends.insert(loaded.dividends.end(), c.data.dividends.begin(), c.data.dividends.end());
+        c.data = LoadedData();
+    }
+
     LOG("CSVLoader completed processing " << filename);
 }
 
+void CSVLoader::setQuotes(std::vector<QuantLib::ext::shared_ptr<MarketDatum>>& quotes, QuantExt::WorkerPool* pool) {
+
+    // group the quotes by date, keeping the file order
+
+    std::map<Date, std::vector<QuantLib::ext::shared_ptr<MarketDatum>>> byDate;
+    std::vector<QuantLib::ext::shared_ptr<MarketDatum>>* current = nullptr;
+    for (auto& md : quotes) {
+        if (current == nullptr || current->back()->asofDate() != md->asofDate())
+            current = &byDate[md->asofDate()];
+        current->push_back(std::move(md));
+    }
+    quotes.clear();
+    quotes.shrink_to_fit();
+
+    /* keep the first quote for duplicates and sort the quotes of a date by name; if a fx spot quote and its inverse
+       are present, keep the dominant one only, this is what adding the quotes one by one with checkFxDuplicate()
+       results in */
+
+    auto process = [](std::vector<QuantLib::ext::shared_ptr<MarketDatum>>& data) {
+        std::unordered_map<std::string_view, Size> names;
+        std::vector<QuantLib::ext::shared_ptr<MarketDatum>> unique;
+        names.reserve(data.size());
+        unique.reserve(data.size());
+        for (auto& md : data) {
+            auto [it, inserted] = names.emplace(md->name(), unique.size());
+            if (inserted) {
+                unique.push_back(std::move(md));
+            } else if (isFxSpotRate(md) && QuantLib::ext::dynamic_pointer_cast<FXSpotQuote>(md)->unitCcy() ==
+                                               QuantLib::ext::dynamic_pointer_cast<FXSpotQuote>(md)->ccy()) {
+                // a fx spot quote is its own inverse if the currencies are equal and replaces the previous quote
+                std::swap(unique[it->second], md);
+            } else {
+                DLOG("Skipped MarketDatum " << md->name() << " - this is already present.");
+            }
+        }
+        data.clear();
+        std::sort(unique.begin(), unique.end(), SharedPtrMarketDatumComparator());
+        for (auto& md : unique) {
+            if (isFxSpotRate(md)) {
+                auto fx = QuantLib::ext::dynamic_pointer_cast<FXSpotQuote>(md);
+                QL_REQUIRE(fx, "CSVLoader: expected FXSpotQuote for " << md->name());
+                auto inverse = makeDummyMarketDatum(md->asofDate(), "FX/RATE/" + fx->ccy() + "/" + fx->unitCcy());
+                if (std::binary_search(unique.begin(), unique.end(), inverse, SharedPtrMarketDatumComparator()) &&
+                    fxDominance(fx->unitCcy(), fx->ccy()) != fx->unitCcy() + fx->ccy()) {
+                    DLOG("Skipped MarketDatum " << md->name() << " - dominant FX already present.");
+                    continue;
+                }
+            }
+            data.push_back(md);
+        }
+    };
+
+    std::vector<std::vector<QuantLib::ext::shared_ptr<MarketDatum>>*> dates;
+    for (auto& [_, data] : byDate)
+        dates.push_back(&data);
+    if (pool != nullptr && dates.size() > 1) {
+        pool->parallelFor(dates.size(), 1, [&process, &dates](std::size_t begin, std::size_t end, std::size_t) {
+            for (std::size_t i = begin; i < end; ++i)
+                process(*dates[i]);
+        });
+    } else {
+        for (auto d : dates)
+            process(*d);
+    }
+
+    // intern the names, the ids are the positions in the sorted table
+
+    std::unordered_map<std::string_view, Size> ids;
+    for (auto const& [_, data] : byDate) {
+        for (auto const& md : data)
+            ids.emplace(md->name(), 0);
+    }
+    quoteNames_.clear();
+    quoteNames_.reserve(ids.size());
+    for (auto const& [n, _] : ids)
+        quoteNames_.push_back(std::string(n));
+    std::sort(quoteNames_.begin(), quoteNames_.end());
+    for (Size i = 0; i < quoteNames_.size(); ++i)
+        ids[quoteNames_[i]] = i;
+
+    // store the quotes by date, ascending in name
+
+    data_.clear();
+    for (auto& [d, data] : byDate) {
+        auto& q = data_[d];
+        q.nameIds.reserve(data.size());
+        for (auto const& md : data)
+            q.nameIds.push_back(ids.at(md->name()));
+        q.data = std::move(data);
+    }
+}
+
+void CSVLoader::setFixings(std::vector<Fixing>& fixings) {
+
+    // group the fixings by name, keeping the file order
+
+    std::unordered_map<std::string, std::vector<std::pair<Date, Real>>> byName;
+    std::vector<std::pair<Date, Real>>* current = nullptr;
+    const std::string* currentName = nullptr;
+    for (auto const& f : fixings) {
+        if (currentName == nullptr || *currentName != f.name) {
+            auto it = byName.try_emplace(f.name).first;
+            currentName = &it->first;
+            current = &it->second;
+        }
+        current->push_back(std::make_pair(f.date, f.fixing));
+    }
+    fixings.clear();
+    fixings.shrink_to_fit();
+
+    // store them ascending in name and date, for duplicates the first fixing is kept
+
+    fixingNames_.clear();
+    for (auto const& [n, _] : byName)
+        fixingNames_.push_back(n);
+    std::sort(fixingNames_.begin(), fixingNames_.end());
+    fixingOffsets_.assign(1, 0);
+    fixingDates_.clear();
+    fixingValues_.clear();
+    for (auto const& n : fixingNames_) {
+        auto& data = byName.at(n);
+        auto byDate = [](const std::pair<Date, Real>& a, const std::pair<Date, Real>& b) { return a.first < b.first; };
+        if (!std::is_sorted(data.begin(), data.end(), byDate))
+            std::stable_sort(data.begin(), data.end(), byDate);
+        for (Size i = 0; i < data.size(); ++i) {
+            if (i > 0 && data[i].first == data[i - 1].first) {
+                WLOG("Skipped Fixing " << n << "@" << QuantLib::io::iso_date(data[i].first)
+                                       << " - this is already present.");
+                continue;
+            }
+            fixingDates_.push_back(data[i].first);
+            fixingValues_.push_back(data[i].second);
+        }
+        fixingOffsets_.push_back(fixingDates_.size());
+        data = std::vector<std::pair<Date, Real>>();
+    }
+}
+
 vector<QuantLib::ext::shared_ptr<MarketDatum>> CSVLoader::loadQuotes(const QuantLib::Date& d) const {
     auto it = data_.find(d);
     if (it == data_.end())
         return {};
-    return std::vector<QuantLib::ext::shared_ptr<MarketDatum>>(it->second.begin(), it->second.end());
+    return it->second.data;
 }
 
 QuantLib::ext::shared_ptr<MarketDatum> CSVLoader::get(const string& name, const QuantLib::Date& d) const {
     auto it = data_.find(d);
     QL_REQUIRE(it != data_.end(), "No datum for " << name << " on date " << d);
-    auto it2 = it->second.find(makeDummyMarketDatum(d, name));
-    QL_REQUIRE(it2 != it->second.end(), "No datum for " << name << " on date " << d);
-    return *it2;
+    auto n = std::lower_bound(quoteNames_.begin(), quoteNames_.end(), name);
+    QL_REQUIRE(n != quoteNames_.end() && *n == name, "No datum for " << name << " on date " << d);
+    auto const& ids = it->second.nameIds;
+    auto id = std::lower_bound(ids.begin(), ids.end(), static_cast<Size>(n - quoteNames_.begin()));
+    QL_REQUIRE(id != ids.end() && quoteNames_[*id] == name, "No datum for " << name << " on date " << d);
+    return it->second.data[id - ids.begin()];
 }
 
 std::set<QuantLib::ext::shared_ptr<MarketDatum>> CSVLoader::get(const std::set<std::string>& names,
@@ -215,10 +453,14 @@ std::set<QuantLib::ext::shared_ptr<MarketDatum>> CSVLoader::get(const std::set<s
     if(it == data_.end())
         return {};
     std::set<QuantLib::ext::shared_ptr<MarketDatum>> result;
+    auto const& ids = it->second.nameIds;
     for (auto const& n : names) {
-        auto it2 = it->second.find(makeDummyMarketDatum(asof, n));
-        if (it2 != it->second.end())
-            result.insert(*it2);
+        auto nit = std::lower_bound(quoteNames_.begin(), quoteNames_.end(), n);
+        if (nit == quoteNames_.end() || *nit != n)
+            continue;
+        auto id = std::lower_bound(ids.begin(), ids.end(), static_cast<Size>(nit - quoteNames_.begin()));
+        if (id != ids.end() && quoteNames_[*id] == n)
+            result.insert(it->second.data[id - ids.begin()]);
     }
     return result;
 }
@@ -236,31 +478,57 @@ std::set<QuantLib::ext::shared_ptr<MarketDatum>> CSVLoader::get(const Wildcard&
     auto it = data_.find(asof);
     if (it == data_.end())
         return {};
-    std::set<QuantLib::ext::shared_ptr<MarketDatum>> result;
-    std::set<QuantLib::ext::shared_ptr<MarketDatum>>::iterator it1, it2;
-    if (wildcard.wildcardPos() == 0) {
-        // wildcard at first position => we have to search all of the data
-        it1 = it->second.begin();
-        it2 = it->second.end();
-    } else {
-        // search the range matching the substring of the pattern until the wildcard
+    auto const& ids = it->second.nameIds;
+    auto const& data = it->second.data;
+    Size from = 0, to = data.size();
+    if (wildcard.wildcardPos() > 0) {
+        // restrict the search to the range of names starting with the substring of the pattern until the wildcard
         std::string prefix = wildcard.pattern().substr(0, wildcard.wildcardPos());
-        it1 = it->second.lower_bound(makeDummyMarketDatum(asof, prefix));
-        it2 = it->second.upper_bound(makeDummyMarketDatum(asof, prefix + "\xFF"));
+        auto n1 = std::lower_bound(quoteNames_.begin(), quoteNames_.end(), prefix);
+        auto n2 = std::partition_point(n1, quoteNames_.end(), [&prefix](const std::string& n) {
+            return n.compare(0, prefix.size(), prefix) == 0;
+        });
+        from = std::lower_bound(ids.begin(), ids.end(), static_cast<Size>(n1 - quoteNames_.begin())) - ids.begin();
+        to = std::lower_bound(ids.begin(), ids.end(), static_cast<Size>(n2 - quoteNames_.begin())) - ids.begin();
     }
-    for (auto it = it1; it != it2; ++it) {
-        if (wildcard.isPrefix() || wildcard.matches((*it)->name()))
-            result.insert(*it);
+    std::set<QuantLib::ext::shared_ptr<MarketDatum>> result;
+    for (Size i = from; i < to; ++i) {
+        if (wildcard.isPrefix() || wildcard.matches(data[i]->name()))
+            result.insert(data[i]);
     }
     return result;
 }
 
+bool CSVLoader::hasQuotes(const QuantLib::Date& d) const { return data_.find(d) != data_.end(); }
+
 std::set<QuantLib::Date> CSVLoader::asofDates() const {
     std::set<QuantLib::Date> result;
     for (auto const& [d, _] : data_)
-        result.insert(d);
+        result.insert(result.end(), d);
+    return result;
+}
+
+std::set<Fixing> CSVLoader::loadFixings() const {
+    // the fixings are stored in the order of the set
+    std::set<Fixing> result;
+    for (Size i = 0; i < fixingNames_.size(); ++i) {
+        for (Size j = fixingOffsets_[i]; j < fixingOffsets_[i + 1]; ++j)
+            result.insert(result.end(), Fixing(fixingDates_[j], fixingNames_[i], fixingValues_[j]));
+    }
     return result;
 }
 
+Fixing CSVLoader::getFixing(const string& name, const QuantLib::Date& d) const {
+    auto n = std::lower_bound(fixingNames_.begin(), fixingNames_.end(), name);
+    if (n == fixingNames_.end() || *n != name)
+        return Fixing();
+    Size i = n - fixingNames_.begin();
+    auto begin = fixingDates_.begin() + fixingOffsets_[i], end = fixingDates_.begin() + fixingOffsets_[i + 1];
+    auto it = std::lower_bound(begin, end, d);
+    if (it == end || *it != d)
+        return Fixing();
+    return Fixing(d, name, fixingValues_[it - fixingDates_.begin()]);
+}
+
 } // namespace data
 } // namespace ore
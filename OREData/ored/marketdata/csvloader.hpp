@@ -26,6 +26,10 @@
 #include <map>
 #include <ored/marketdata/loader.hpp>
 
+namespace QuantExt {
+class WorkerPool;
+}
+
 namespace ore {
 namespace data {
 
@@ -34,7 +38,14 @@ namespace data {
   Data is loaded with the call to the constructor.
   Inspectors can be called to then retrieve quotes and fixings.
 
-  TODO implementation has large overlap with inmemoryloader.?pp, factor this out
+  The files are memory mapped and split into chunks of whole lines which are parsed on nThreads threads. The results
+  are merged in file order, i.e. duplicates and the FX dominance rule are resolved as if the lines were read one by
+  one.
+
+  The data is held in sorted flat arrays. The quote names are interned in a sorted table, for each date the quotes
+  are stored together with the (ascending) ids of their names, so that a lookup by name and a lookup by a wildcard
+  with a non-empty prefix are logarithmic in the number of quotes. The fixings are stored by index name, with the
+  dates and values of each index in contiguous ascending ranges.
 
   \ingroup marketdata
  */
@@ -50,7 +61,9 @@ public:
         //! Enable/disable implying today's fixings
         bool implyTodaysFixings = false,
         //! Load fixings up to this date
-        Date fixingCutOffDate = Date());
+        Date fixingCutOffDate = Date(),
+        //! Number of threads used to parse the files
+        Size nThreads = 1);
 
     CSVLoader( //! Quote file name
         const vector<string>& marketFiles,
@@ -59,7 +72,9 @@ public:
         //! Enable/disable implying today's fixings
         bool implyTodaysFixings = false,
         //! Load fixings up to this date
-        Date fixingCutOffDate = Date());
+        Date fixingCutOffDate = Date(),
+        //! Number of threads used to parse the files
+        Size nThreads = 1);
 
     CSVLoader( //! Quote file name
         const string& marketFilename,
@@ -70,7 +85,9 @@ public:
         //! Enable/disable implying today's fixings
         bool implyTodaysFixings = false,
         //! Load fixings up to this date
-        Date fixingCutOffDate = Date());
+        Date fixingCutOffDate = Date(),
+        //! Number of threads used to parse the files
+        Size nThreads = 1);
 
     CSVLoader( //! Quote file name
         const vector<string>& marketFiles,
@@ -81,7 +98,9 @@ public:
         //! Enable/disable implying today's fixings
         bool implyTodaysFixings = false,
         //! Load fixings up to this date
-        Date fixingCutOffDate = Date());
+        Date fixingCutOffDate = Date(),
+        //! Number of threads used to parse the files
+        Size nThreads = 1);
 
     std::vector<QuantLib::ext::shared_ptr<MarketDatum>> loadQuotes(const QuantLib::Date&) const override;
 
@@ -93,19 +112,37 @@ public:
     //! get quotes matching a wildcard
     std::set<QuantLib::ext::shared_ptr<MarketDatum>> get(const Wildcard& wildcard, const QuantLib::Date& asof) const override;
 
+    bool hasQuotes(const QuantLib::Date& d) const override;
+
     //! Load fixings
-    std::set<Fixing> loadFixings() const override { return fixings_; }
+    std::set<Fixing> loadFixings() const override;
+    Fixing getFixing(const string& name, const QuantLib::Date& d) const override;
     //! Load dividends
     std::set<QuantExt::Dividend> loadDividends() const override { return dividends_; }
     //@}
 
 private:
     enum class DataType { Market, Fixing, Dividend };
-    void loadFile(const string&, DataType);
+    struct LoadedData;
+    void loadFile(const string&, DataType, QuantExt::WorkerPool* pool, LoadedData& loaded) const;
+    void setQuotes(std::vector<QuantLib::ext::shared_ptr<MarketDatum>>& quotes, QuantExt::WorkerPool* pool);
+    void setFixings(std::vector<Fixing>& fixings);
 
     bool implyTodaysFixings_;
-    std::map<QuantLib::Date, std::set<QuantLib::ext::shared_ptr<MarketDatum>, SharedPtrMarketDatumComparator>> data_;
-    std::set<Fixing> fixings_;
+    // interned quote names, ascending
+    std::vector<std::string> quoteNames_;
+    // for each date the ids of the quote names (ascending) and the quotes
+    struct Quotes {
+        std::vector<Size> nameIds;
+        std::vector<QuantLib::ext::shared_ptr<MarketDatum>> data;
+    };
+    std::map<QuantLib::Date, Quotes> data_;
+    /* index names (ascending), the fixings of fixingNames_[i] are fixingDates_[j], fixingValues_[j] for
+       j = fixingOffsets_[i], ..., fixingOffsets_[i + 1] - 1 (ascending in date) */
+    std::vector<std::string> fixingNames_;
+    std::vector<Size> fixingOffsets_;
+    std::vector<QuantLib::Date> fixingDates_;
+    std::vector<QuantLib::Real> fixingValues_;
     std::set<QuantExt::Dividend> dividends_;
     Date fixingCutOffDate_;
 };
@@ -116,8 +116,11 @@ Handle<Quote> FXTriangulation::getQuote(const std::string& pair) const {
 
     // do we have a cached result?
 
-    if (auto it = quoteCache_.find(pair); it != quoteCache_.end())
-        return it->second;
+    {
+        std::lock_guard<std::mutex> lock(*cacheMutex_);
+        if (auto it = quoteCache_.find(pair); it != quoteCache_.end())
+            return it->second;
+    }
 
     // we need to construct the quote from the input quotes
 
@@ -159,10 +162,10 @@ Handle<Quote> FXTriangulation::getQuote(const std::string& pair) const {
         result = Handle<Quote>(QuantLib::ext::make_shared<CompositeVectorQuote<decltype(f)>>(quotes, f));
     }
 
-    // add the result to the lookup cache and return it
+    // add the result to the lookup cache and return it, if another thread was faster we return its result
 
-    quoteCache_[pair] = result;
-    return result;
+    std::lock_guard<std::mutex> lock(*cacheMutex_);
+    return quoteCache_.insert(std::make_pair(pair, result)).first->second;
 }
 
 Handle<FxIndex> FXTriangulation::getIndex(const std::string& indexOrPair, const Market* market,
@@ -170,8 +173,11 @@ Handle<FxIndex> FXTriangulation::getIndex(const std::string& indexOrPair, const
 
     // do we have a cached result?
 
-    if (auto it = indexCache_.find(std::make_pair(indexOrPair, configuration)); it != indexCache_.end()) {
-        return it->second;
+    {
+        std::lock_guard<std::mutex> lock(*cacheMutex_);
+        if (auto it = indexCache_.find(std::make_pair(indexOrPair, configuration)); it != indexCache_.end()) {
+            return it->second;
+        }
     }
 
     // otherwise we need to construct the index
@@ -253,10 +259,10 @@ Handle<FxIndex> FXTriangulation::getIndex(const std::string& indexOrPair, const
                                                              sourceYts, targetYts));
     }
 
-    // add the result to the lookup cache and return it
+    // add the result to the lookup cache and return it, if another thread was faster we return its result
 
-    indexCache_[std::make_pair(indexOrPair, configuration)] = result;
-    return result;
+    std::lock_guard<std::mutex> lock(*cacheMutex_);
+    return indexCache_.insert(std::make_pair(std::make_pair(indexOrPair, configuration), result)).first->second;
 }
 
 std::vector<std::string> FXTriangulation::getPath(const std::string& forCcy, const std::string& domCcy) const {
@@ -31,6 +31,7 @@
 #include <ql/quote.hpp>
 #include <ql/types.hpp>
 
+#include <mutex>
 #include <vector>
 
 namespace ore {
@@ -72,9 +73,11 @@ private:
     // the input quotes
     std::map<std::string, QuantLib::Handle<QuantLib::Quote>> quotes_;
 
-    // caches to improve perfomance
+    /* caches to improve perfomance, guarded by cacheMutex_, since curves can be built on several threads, the
+       mutex is held by a pointer to keep the class copyable */
     mutable std::map<std::string, QuantLib::Handle<QuantLib::Quote>> quoteCache_;
     mutable std::map<std::pair<std::string, std::string>, QuantLib::Handle<QuantExt::FxIndex>> indexCache_;
+    QuantLib::ext::shared_ptr<std::mutex> cacheMutex_ = QuantLib::ext::make_shared<std::mutex>();
 
     // internal data structure to represent the undirected graph of currencies
     std::vector<std::string> nodeToCcy_;
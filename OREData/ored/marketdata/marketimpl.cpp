@@ -23,6 +23,7 @@
 #include <ored/utilities/indexparser.hpp>
 #include <ored/utilities/marketdata.hpp>
 #include <ored/utilities/parsers.hpp>
+#include <ql/patterns/lazyobject.hpp>
 #include <qle/termstructures/blackinvertedvoltermstructure.hpp>
 
 using namespace std;
@@ -520,111 +521,120 @@ void MarketImpl::addSwapIndex(const string& swapIndex, const string& discountInd
     }
 }
 
-void MarketImpl::refresh(const string& configuration) {
-
-    auto it = refreshTs_.find(configuration);
-    if (it == refreshTs_.end()) {
-        it = refreshTs_.insert(make_pair(configuration, std::set<QuantLib::ext::shared_ptr<TermStructure>>())).first;
+std::set<QuantLib::ext::shared_ptr<TermStructure>>
+MarketImpl::termStructures(const std::function<bool(const string&)>& useConfiguration) const {
+    std::set<QuantLib::ext::shared_ptr<TermStructure>> result;
+    for (auto& x : yieldCurves_) {
+        if (useConfiguration(get<0>(x.first)))
+            result.insert(*x.second);
     }
-
-    if (it->second.empty()) {
-        for (auto& x : yieldCurves_) {
-            if (get<0>(x.first) == configuration || get<0>(x.first) == Market::defaultConfiguration)
-                it->second.insert(*x.second);
-        }
-        for (auto& x : iborIndices_) {
-            if (x.first.first == configuration || x.first.first == Market::defaultConfiguration) {
-                Handle<YieldTermStructure> y = x.second->forwardingTermStructure();
-                if (!y.empty())
-                    it->second.insert(*y);
-            }
-        }
-        for (auto& x : swapIndices_) {
-            if (x.first.first == configuration || x.first.first == Market::defaultConfiguration) {
-                Handle<YieldTermStructure> y = x.second->forwardingTermStructure();
-                if (!y.empty())
-                    it->second.insert(*y);
-                y = x.second->discountingTermStructure();
-                if (!y.empty())
-                    it->second.insert(*y);
-            }
-        }
-        for (auto& x : swaptionCurves_) {
-            if (x.first.first == configuration || x.first.first == Market::defaultConfiguration)
-                it->second.insert(*x.second);
-        }
-        for (auto& x : capFloorCurves_) {
-            if (x.first.first == configuration || x.first.first == Market::defaultConfiguration)
-                it->second.insert(*x.second);
-        }
-        for (auto& x : yoyCapFloorVolSurfaces_) {
-            if (x.first.first == configuration || x.first.first == Market::defaultConfiguration)
-                it->second.insert(*x.second);
-        }
-        for (auto& x : fxVols_) {
-            if (x.first.first == configuration || x.first.first == Market::defaultConfiguration)
-                it->second.insert(*x.second);
+    for (auto& x : iborIndices_) {
+        if (useConfiguration(x.first.first)) {
+            Handle<YieldTermStructure> y = x.second->forwardingTermStructure();
+            if (!y.empty())
+                result.insert(*y);
         }
-        for (auto& x : defaultCurves_) {
-            if (x.first.first == configuration || x.first.first == Market::defaultConfiguration)
-                it->second.insert(*x.second->curve());
-        }
-        for (auto& x : cdsVols_) {
-            if (x.first.first == configuration || x.first.first == Market::defaultConfiguration)
-                it->second.insert(*x.second);
-        }
-        for (auto& x : baseCorrelations_) {
-            if (x.first.first == configuration || x.first.first == Market::defaultConfiguration)
-                it->second.insert(*x.second);
-        }
-        for (auto& x : zeroInflationIndices_) {
-            if (x.first.first == configuration || x.first.first == Market::defaultConfiguration) {
-                it->second.insert(*x.second->zeroInflationTermStructure());
-            }
-        }
-        for (auto& x : yoyInflationIndices_) {
-            if (x.first.first == configuration || x.first.first == Market::defaultConfiguration) {
-                it->second.insert(*x.second->yoyInflationTermStructure());
-            }
-        }
-        for (auto& x : cpiInflationCapFloorVolatilitySurfaces_) {
-            if (x.first.first == configuration || x.first.first == Market::defaultConfiguration)
-                it->second.insert(*x.second);
-        }
-        for (auto& x : yoyCapFloorVolSurfaces_) {
-            if (x.first.first == configuration || x.first.first == Market::defaultConfiguration)
-                it->second.insert(*x.second);
+    }
+    for (auto& x : swapIndices_) {
+        if (useConfiguration(x.first.first)) {
+            Handle<YieldTermStructure> y = x.second->forwardingTermStructure();
+            if (!y.empty())
+                result.insert(*y);
+            y = x.second->discountingTermStructure();
+            if (!y.empty())
+                result.insert(*y);
         }
-        for (auto& x : equityVols_) {
-            if (x.first.first == configuration || x.first.first == Market::defaultConfiguration)
-                it->second.insert(*x.second);
+    }
+    for (auto& x : swaptionCurves_) {
+        if (useConfiguration(x.first.first))
+            result.insert(*x.second);
+    }
+    for (auto& x : capFloorCurves_) {
+        if (useConfiguration(x.first.first))
+            result.insert(*x.second);
+    }
+    for (auto& x : yoyCapFloorVolSurfaces_) {
+        if (useConfiguration(x.first.first))
+            result.insert(*x.second);
+    }
+    for (auto& x : fxVols_) {
+        if (useConfiguration(x.first.first))
+            result.insert(*x.second);
+    }
+    for (auto& x : defaultCurves_) {
+        if (useConfiguration(x.first.first))
+            result.insert(*x.second->curve());
+    }
+    for (auto& x : cdsVols_) {
+        if (useConfiguration(x.first.first))
+            result.insert(*x.second);
+    }
+    for (auto& x : baseCorrelations_) {
+        if (useConfiguration(x.first.first))
+            result.insert(*x.second);
+    }
+    for (auto& x : zeroInflationIndices_) {
+        if (useConfiguration(x.first.first)) {
+            result.insert(*x.second->zeroInflationTermStructure());
         }
-        for (auto& x : equityCurves_) {
-            if (x.first.first == configuration || x.first.first == Market::defaultConfiguration) {
-                Handle<YieldTermStructure> y = x.second->equityForecastCurve();
-                if (!y.empty())
-                    it->second.insert(*y);
-                y = x.second->equityDividendCurve();
-                if (!y.empty())
-                    it->second.insert(*y);
-            }
+    }
+    for (auto& x : yoyInflationIndices_) {
+        if (useConfiguration(x.first.first)) {
+            result.insert(*x.second->yoyInflationTermStructure());
         }
-        for (auto& x : commodityIndices_) {
-            if (x.first.first == configuration || x.first.first == Market::defaultConfiguration) {
-                const auto& pts = x.second->priceCurve();
-                if (!pts.empty())
-                    it->second.insert(*pts);
-            }
+    }
+    for (auto& x : cpiInflationCapFloorVolatilitySurfaces_) {
+        if (useConfiguration(x.first.first))
+            result.insert(*x.second);
+    }
+    for (auto& x : yoyCapFloorVolSurfaces_) {
+        if (useConfiguration(x.first.first))
+            result.insert(*x.second);
+    }
+    for (auto& x : equityVols_) {
+        if (useConfiguration(x.first.first))
+            result.insert(*x.second);
+    }
+    for (auto& x : equityCurves_) {
+        if (useConfiguration(x.first.first)) {
+            Handle<YieldTermStructure> y = x.second->equityForecastCurve();
+            if (!y.empty())
+                result.insert(*y);
+            y = x.second->equityDividendCurve();
+            if (!y.empty())
+                result.insert(*y);
         }
-        for (auto& x : commodityVols_) {
-            if (x.first.first == configuration || x.first.first == Market::defaultConfiguration)
-                it->second.insert(*x.second);
+    }
+    for (auto& x : commodityIndices_) {
+        if (useConfiguration(x.first.first)) {
+            const auto& pts = x.second->priceCurve();
+            if (!pts.empty())
+                result.insert(*pts);
         }
+    }
+    for (auto& x : commodityVols_) {
+        if (useConfiguration(x.first.first))
+            result.insert(*x.second);
+    }
 
-        for (auto& x : correlationCurves_) {
-            if (get<0>(x.first) == configuration || get<0>(x.first) == Market::defaultConfiguration)
-                it->second.insert(*x.second);
-        }
+    for (auto& x : correlationCurves_) {
+        if (useConfiguration(get<0>(x.first)))
+            result.insert(*x.second);
+    }
+    return result;
+}
+
+void MarketImpl::refresh(const string& configuration) {
+
+    auto it = refreshTs_.find(configuration);
+    if (it == refreshTs_.end()) {
+        it = refreshTs_.insert(make_pair(configuration, std::set<QuantLib::ext::shared_ptr<TermStructure>>())).first;
+    }
+
+    if (it->second.empty()) {
+        it->second = termStructures([&configuration](const string& c) {
+            return c == configuration || c == Market::defaultConfiguration;
+        });
     }
 
     // term structures might be wrappers around nested termstructures that need to be updated as well,
@@ -634,5 +644,18 @@ void MarketImpl::refresh(const string& configuration) {
 
 } // refresh
 
+void MarketImpl::calculateTermStructures() const {
+    for (auto const& ts : termStructures([](const string&) { return true; })) {
+        if (auto lazy = QuantLib::ext::dynamic_pointer_cast<QuantLib::LazyObject>(ts)) {
+            try {
+                lazy->recalculate();
+            } catch (const std::exception& e) {
+                // the error is reported when the term structure is used
+                DLOG("MarketImpl::calculateTermStructures(): " << e.what());
+            }
+        }
+    }
+}
+
 } // namespace data
 } // namespace ore
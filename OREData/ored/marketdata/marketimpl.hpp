@@ -30,6 +30,7 @@
 #include <qle/indexes/inflationindexobserver.hpp>
 #include <qle/indexes/fxindex.hpp>
 
+#include <functional>
 #include <map>
 
 namespace ore {
@@ -184,6 +185,10 @@ public:
     //! Send an explicit update() call to all term structures
     void refresh(const string& configuration = Market::defaultConfiguration) override;
 
+    /*! Calculate the lazy term structures of all configurations, so that the market can be read from several threads
+        afterwards, as long as its quotes and the evaluation date do not change. */
+    void calculateTermStructures() const;
+
 protected:
     /*! Require a market object, this can be used in derived classes to build objects lazily. If the
         method is not overwritten in a derived class, it is assumed that the class builds all market
@@ -243,6 +248,10 @@ protected:
     // set of term structure pointers for refresh (per configuration)
     map<string, std::set<QuantLib::ext::shared_ptr<TermStructure>>> refreshTs_;
 
+    //! the term structures of the configurations for which useConfiguration is true
+    std::set<QuantLib::ext::shared_ptr<TermStructure>>
+    termStructures(const std::function<bool(const string&)>& useConfiguration) const;
+
 private:
     pair<string, string> swapIndexBases(const string& key,
                                         const string& configuration = Market::defaultConfiguration) const;
@@ -0,0 +1,236 @@
+/*
+ Copyright (C) 2025 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+#include <ored/marketdata/synchronizedmarket.hpp>
+
+namespace ore {
+namespace data {
+
+SynchronizedMarket::SynchronizedMarket(const QuantLib::ext::shared_ptr<Market>& market)
+    : WrappedMarket(market, false) {}
+
+Date SynchronizedMarket::asofDate() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return WrappedMarket::asofDate();
+}
+
+Handle<YieldTermStructure>
+SynchronizedMarket::yieldCurve(const YieldCurveType& type, const string& name, const string& configuration) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return WrappedMarket::yieldCurve(type, name, configuration);
+}
+
+Handle<YieldTermStructure> SynchronizedMarket::discountCurveImpl(const string& ccy, const string& configuration) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return WrappedMarket::discountCurveImpl(ccy, configuration);
+}
+
+Handle<YieldTermStructure> SynchronizedMarket::yieldCurve(const string& name, const string& configuration) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return WrappedMarket::yieldCurve(name, configuration);
+}
+
+Handle<IborIndex> SynchronizedMarket::iborIndex(const string& indexName, const string& configuration) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return WrappedMarket::iborIndex(indexName, configuration);
+}
+
+Handle<SwapIndex> SynchronizedMarket::swapIndex(const string& indexName, const string& configuration) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return WrappedMarket::swapIndex(indexName, configuration);
+}
+
+Handle<SwaptionVolatilityStructure>
+SynchronizedMarket::swaptionVol(const string& key, const string& configuration) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return WrappedMarket::swaptionVol(key, configuration);
+}
+
+string SynchronizedMarket::shortSwapIndexBase(const string& ccy, const string& configuration) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return WrappedMarket::shortSwapIndexBase(ccy, configuration);
+}
+
+string SynchronizedMarket::swapIndexBase(const string& ccy, const string& configuration) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return WrappedMarket::swapIndexBase(ccy, configuration);
+}
+
+Handle<SwaptionVolatilityStructure>
+SynchronizedMarket::yieldVol(const string& securityID, const string& configuration) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return WrappedMarket::yieldVol(securityID, configuration);
+}
+
+Handle<QuantExt::FxIndex> SynchronizedMarket::fxIndexImpl(const string& fxIndex, const string& configuration) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return WrappedMarket::fxIndexImpl(fxIndex, configuration);
+}
+
+Handle<Quote> SynchronizedMarket::fxSpotImpl(const string& ccypair, const string& configuration) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return WrappedMarket::fxSpotImpl(ccypair, configuration);
+}
+
+Handle<Quote> SynchronizedMarket::fxRateImpl(const string& ccypair, const string& configuration) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return WrappedMarket::fxRateImpl(ccypair, configuration);
+}
+
+Handle<BlackVolTermStructure> SynchronizedMarket::fxVolImpl(const string& ccypair, const string& configuration) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return WrappedMarket::fxVolImpl(ccypair, configuration);
+}
+
+Handle<QuantExt::CreditCurve> SynchronizedMarket::defaultCurve(const string& name, const string& configuration) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return WrappedMarket::defaultCurve(name, configuration);
+}
+
+Handle<Quote> SynchronizedMarket::recoveryRate(const string& name, const string& configuration) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return WrappedMarket::recoveryRate(name, configuration);
+}
+
+Handle<Quote> SynchronizedMarket::conversionFactor(const string& name, const string& configuration) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return WrappedMarket::conversionFactor(name, configuration);
+}
+
+Handle<Quote> SynchronizedMarket::securityPrice(const string& name, const string& configuration) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return WrappedMarket::securityPrice(name, configuration);
+}
+
+Handle<QuantExt::CreditVolCurve> SynchronizedMarket::cdsVol(const string& name, const string& configuration) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return WrappedMarket::cdsVol(name, configuration);
+}
+
+Handle<QuantExt::BaseCorrelationTermStructure>
+SynchronizedMarket::baseCorrelation(const string& name, const string& configuration) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return WrappedMarket::baseCorrelation(name, configuration);
+}
+
+Handle<OptionletVolatilityStructure>
+SynchronizedMarket::capFloorVol(const string& key, const string& configuration) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return WrappedMarket::capFloorVol(key, configuration);
+}
+
+std::pair<string, QuantLib::Period>
+SynchronizedMarket::capFloorVolIndexBase(const string& key, const string& configuration) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return WrappedMarket::capFloorVolIndexBase(key, configuration);
+}
+
+Handle<QuantExt::YoYOptionletVolatilitySurface>
+SynchronizedMarket::yoyCapFloorVol(const string& indexName, const string& configuration) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return WrappedMarket::yoyCapFloorVol(indexName, configuration);
+}
+
+Handle<ZeroInflationIndex>
+SynchronizedMarket::zeroInflationIndex(const string& indexName, const string& configuration) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return WrappedMarket::zeroInflationIndex(indexName, configuration);
+}
+
+Handle<YoYInflationIndex>
+SynchronizedMarket::yoyInflationIndex(const string& indexName, const string& configuration) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return WrappedMarket::yoyInflationIndex(indexName, configuration);
+}
+
+Handle<CPIVolatilitySurface>
+SynchronizedMarket::cpiInflationCapFloorVolatilitySurface(const string& indexName, const string& configuration) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return WrappedMarket::cpiInflationCapFloorVolatilitySurface(indexName, configuration);
+}
+
+Handle<Quote> SynchronizedMarket::equitySpot(const string& eqName, const string& configuration) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return WrappedMarket::equitySpot(eqName, configuration);
+}
+
+Handle<YieldTermStructure>
+SynchronizedMarket::equityDividendCurve(const string& eqName, const string& configuration) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return WrappedMarket::equityDividendCurve(eqName, configuration);
+}
+
+Handle<YieldTermStructure>
+SynchronizedMarket::equityForecastCurve(const string& eqName, const string& configuration) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return WrappedMarket::equityForecastCurve(eqName, configuration);
+}
+
+Handle<QuantExt::EquityIndex2>
+SynchronizedMarket::equityCurve(const string& eqName, const string& configuration) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return WrappedMarket::equityCurve(eqName, configuration);
+}
+
+Handle<BlackVolTermStructure> SynchronizedMarket::equityVol(const string& eqName, const string& configuration) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return WrappedMarket::equityVol(eqName, configuration);
+}
+
+void SynchronizedMarket::refresh(const string& s) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    WrappedMarket::refresh(s);
+}
+
+Handle<Quote> SynchronizedMarket::securitySpread(const string& securityID, const string& configuration) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return WrappedMarket::securitySpread(securityID, configuration);
+}
+
+QuantLib::Handle<QuantExt::PriceTermStructure>
+SynchronizedMarket::commodityPriceCurve(const std::string& commodityName, const std::string& configuration) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return WrappedMarket::commodityPriceCurve(commodityName, configuration);
+}
+
+QuantLib::Handle<QuantExt::CommodityIndex>
+SynchronizedMarket::commodityIndex(const std::string& commodityName, const std::string& configuration) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return WrappedMarket::commodityIndex(commodityName, configuration);
+}
+
+QuantLib::Handle<QuantLib::BlackVolTermStructure>
+SynchronizedMarket::commodityVolatility(const std::string& commodityName, const std::string& configuration) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return WrappedMarket::commodityVolatility(commodityName, configuration);
+}
+
+QuantLib::Handle<QuantExt::CorrelationTermStructure>
+SynchronizedMarket::correlationCurve(const std::string& index1, const std::string& index2,
+                                     const std::string& configuration) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return WrappedMarket::correlationCurve(index1, index2, configuration);
+}
+
+Handle<Quote> SynchronizedMarket::cpr(const string& securityID, const string& configuration) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return WrappedMarket::cpr(securityID, configuration);
+}
+
+} // namespace data
+} // namespace ore
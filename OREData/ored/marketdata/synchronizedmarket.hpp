@@ -0,0 +1,138 @@
+/*
+ Copyright (C) 2025 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+/*! \file ored/marketdata/synchronizedmarket.hpp
+    \brief market that serialises the requests to an underlying market
+    \ingroup marketdata
+*/
+
+#pragma once
+
+#include <ored/marketdata/wrappedmarket.hpp>
+
+#include <mutex>
+
+namespace ore {
+namespace data {
+
+//! Synchronized Market
+/*!
+  All incoming requests are passed through to an underlying market, one request at a time. This class can be used to
+  share a market between threads, e.g. the trades of a portfolio built on several threads. The requests may change
+  the underlying market, e.g. a lazily built TodaysMarket builds the requested object on the first request.
+
+  The market objects that are returned are not synchronized.
+
+  \ingroup marketdata
+*/
+class SynchronizedMarket : public WrappedMarket {
+public:
+    explicit SynchronizedMarket(const QuantLib::ext::shared_ptr<Market>& market);
+
+    // market interface
+    Date asofDate() const override;
+    Handle<YieldTermStructure> yieldCurve(const YieldCurveType& type, const string& name,
+                                          const string& configuration = Market::defaultConfiguration) const override;
+    Handle<YieldTermStructure> discountCurveImpl(const string& ccy,
+                                             const string& configuration = Market::defaultConfiguration) const override;
+    Handle<YieldTermStructure> yieldCurve(const string& name,
+                                          const string& configuration = Market::defaultConfiguration) const override;
+    Handle<IborIndex> iborIndex(const string& indexName,
+                                const string& configuration = Market::defaultConfiguration) const override;
+    Handle<SwapIndex> swapIndex(const string& indexName,
+                                const string& configuration = Market::defaultConfiguration) const override;
+    Handle<SwaptionVolatilityStructure>
+    swaptionVol(const string& key, const string& configuration = Market::defaultConfiguration) const override;
+    string shortSwapIndexBase(const string& ccy,
+                                    const string& configuration = Market::defaultConfiguration) const override;
+    string swapIndexBase(const string& ccy,
+                               const string& configuration = Market::defaultConfiguration) const override;
+    Handle<SwaptionVolatilityStructure>
+    yieldVol(const string& securityID, const string& configuration = Market::defaultConfiguration) const override;
+    Handle<QuantExt::FxIndex> fxIndexImpl(const string& fxIndex,
+                                          const string& configuration = Market::defaultConfiguration) const override;
+    Handle<Quote> fxSpotImpl(const string& ccypair,
+                             const string& configuration = Market::defaultConfiguration) const override;
+    Handle<Quote> fxRateImpl(const string& ccypair,
+                             const string& configuration = Market::defaultConfiguration) const override;
+    Handle<BlackVolTermStructure> fxVolImpl(const string& ccypair,
+                                            const string& configuration = Market::defaultConfiguration) const override;
+    Handle<QuantExt::CreditCurve>
+    defaultCurve(const string& name, const string& configuration = Market::defaultConfiguration) const override;
+    Handle<Quote> recoveryRate(const string& name,
+                               const string& configuration = Market::defaultConfiguration) const override;
+    Handle<QuantExt::CreditVolCurve> cdsVol(const string& name,
+                                            const string& configuration = Market::defaultConfiguration) const override;
+    Handle<QuantExt::BaseCorrelationTermStructure>
+    baseCorrelation(const string& name, const string& configuration = Market::defaultConfiguration) const override;
+    Handle<OptionletVolatilityStructure>
+    capFloorVol(const string& key, const string& configuration = Market::defaultConfiguration) const override;
+    std::pair<string, QuantLib::Period>
+    capFloorVolIndexBase(const string& key, const string& configuration = Market::defaultConfiguration) const override;
+    Handle<QuantExt::YoYOptionletVolatilitySurface>
+    yoyCapFloorVol(const string& indexName, const string& configuration = Market::defaultConfiguration) const override;
+    Handle<ZeroInflationIndex>
+    zeroInflationIndex(const string& indexName,
+                       const string& configuration = Market::defaultConfiguration) const override;
+    Handle<YoYInflationIndex>
+    yoyInflationIndex(const string& indexName,
+                      const string& configuration = Market::defaultConfiguration) const override;
+    Handle<QuantLib::CPIVolatilitySurface>
+    cpiInflationCapFloorVolatilitySurface(const string& indexName,
+                                          const string& configuration = Market::defaultConfiguration) const override;
+    Handle<Quote> equitySpot(const string& eqName,
+                             const string& configuration = Market::defaultConfiguration) const override;
+    Handle<YieldTermStructure>
+    equityDividendCurve(const string& eqName,
+                        const string& configuration = Market::defaultConfiguration) const override;
+    Handle<YieldTermStructure>
+    equityForecastCurve(const string& eqName,
+                        const string& configuration = Market::defaultConfiguration) const override;
+    Handle<QuantExt::EquityIndex2>
+    equityCurve(const string& eqName, const string& configuration = Market::defaultConfiguration) const override;
+    Handle<BlackVolTermStructure> equityVol(const string& eqName,
+                                            const string& configuration = Market::defaultConfiguration) const override;
+    void refresh(const string& s) override;
+
+    Handle<Quote> securitySpread(const string& securityID,
+                                 const string& configuration = Market::defaultConfiguration) const override;
+    Handle<Quote> conversionFactor(const string& name,
+                                   const string& configuration = Market::defaultConfiguration) const override;
+    Handle<Quote> securityPrice(const string& name,
+                                const string& configuration = Market::defaultConfiguration) const override;
+
+    QuantLib::Handle<QuantExt::PriceTermStructure>
+    commodityPriceCurve(const std::string& commodityName,
+                        const std::string& configuration = Market::defaultConfiguration) const override;
+    QuantLib::Handle<QuantExt::CommodityIndex> commodityIndex(const std::string& commodityName,
+            const std::string& configuration = Market::defaultConfiguration) const override;
+    QuantLib::Handle<QuantLib::BlackVolTermStructure>
+    commodityVolatility(const std::string& commodityName,
+                        const std::string& configuration = Market::defaultConfiguration) const override;
+    QuantLib::Handle<QuantExt::CorrelationTermStructure>
+    correlationCurve(const std::string& index1, const std::string& index2,
+                     const std::string& configuration = Market::defaultConfiguration) const override;
+    Handle<Quote> cpr(const string& securityID,
+                      const string& configuration = Market::defaultConfiguration) const override;
+
+private:
+    mutable std::mutex mutex_;
+};
+
+} // namespace data
+} // namespace ore
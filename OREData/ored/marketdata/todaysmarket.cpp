@@ -44,6 +44,7 @@
 #include <ored/utilities/indexnametranslator.hpp>
 #include <ored/utilities/log.hpp>
 #include <ored/utilities/to_string.hpp>
+#include <ored/utilities/workerthreadstate.hpp>
 #include <qle/indexes/dividendmanager.hpp>
 #include <qle/indexes/equityindex.hpp>
 #include <qle/indexes/fallbackiborindex.hpp>
@@ -52,7 +53,12 @@
 #include <qle/indexes/inflationindexwrapper.hpp>
 #include <qle/termstructures/blackvolsurfacewithatm.hpp>
 #include <qle/termstructures/pricetermstructureadapter.hpp>
+#include <qle/utilities/workerpool.hpp>
 
+#include <ql/indexes/indexmanager.hpp>
+#include <ql/settings.hpp>
+
+#include <memory>
 #include <tuple>
 
 #include <boost/graph/topological_sort.hpp>
@@ -81,12 +87,12 @@ TodaysMarket::TodaysMarket(const Date& asof, const QuantLib::ext::shared_ptr<Tod
                            const bool preserveQuoteLinkage,
                            const QuantLib::ext::shared_ptr<ore::data::IborFallbackConfig>& iborFallbackConfig,
                            const bool buildCalibrationInfo, const bool handlePseudoCurrencies,
-                           const bool useAtParCoupons)
+                           const bool useAtParCoupons, const Size nThreads)
     : MarketImpl(handlePseudoCurrencies), params_(params), loader_(loader), curveConfigs_(curveConfigs),
       continueOnError_(continueOnError), loadFixings_(loadFixings), lazyBuild_(lazyBuild),
       preserveQuoteLinkage_(preserveQuoteLinkage), referenceData_(referenceData),
       iborFallbackConfig_(iborFallbackConfig), buildCalibrationInfo_(buildCalibrationInfo),
-      useAtParCoupons_(useAtParCoupons) {
+      useAtParCoupons_(useAtParCoupons), nThreads_(std::max<Size>(nThreads, 1)) {
     QL_REQUIRE(params_, "TodaysMarket: TodaysMarketParameters are null");
     QL_REQUIRE(loader_, "TodaysMarket: Loader is null");
     QL_REQUIRE(curveConfigs_, "TodaysMarket: CurveConfigurations are null");
@@ -173,6 +179,28 @@ void TodaysMarket::initialise(const Date& asof) {
             std::swap(*f, configurationNames.front());
         }
 
+        // set up the worker pool for a parallel build
+
+        std::unique_ptr<QuantExt::WorkerPool> pool;
+        WorkerThreadState threadState;
+        std::vector<char> threadInitialised;
+        std::vector<std::vector<QuantLib::ext::shared_ptr<Observable>>> threadObservables;
+        if (nThreads_ > 1) {
+#if defined(QL_ENABLE_SESSIONS) && defined(QL_ENABLE_THREAD_SAFE_OBSERVER_PATTERN)
+            if (handlePseudoCurrencies_ && !GlobalPseudoCurrencyMarketParameters::instance().get().treatAsFX) {
+                WLOG("TodaysMarket: pseudo currencies are not treated as fx, building the market serially.");
+            } else {
+                pool = std::make_unique<QuantExt::WorkerPool>(nThreads_);
+                threadState = WorkerThreadState::fromCurrentThread();
+                threadInitialised.resize(pool->size(), 0);
+                threadObservables.resize(pool->size());
+            }
+#else
+            WLOG("TodaysMarket: parallel build requires QuantLib to be built with sessions and the thread safe "
+                 "observer pattern, building the market serially.");
+#endif
+        }
+
         /* build objects for configurations, starting with inccy, because objects in other configs might require
            discount curves from configuration inccy */
 
@@ -203,8 +231,9 @@ void TodaysMarket::initialise(const Date& asof) {
             }
 
             Size countSuccess = 0, countError = 0;
-            for (auto const& m : order) {
-                timer.start();
+            auto build = [this, &configuration, &g, &buildErrors, &timings, &counts, &countSuccess,
+                          &countError](const ReducedVertex m, const boost::timer::nanosecond_type prebuildTime) {
+                boost::timer::cpu_timer nodeTimer;
                 try {
                     buildNode(configuration, g[m]);
                     ++countSuccess;
@@ -215,19 +244,109 @@ void TodaysMarket::initialise(const Date& asof) {
                     ALOG("error while building reduced node " << g[m] << " in configuration " << configuration << ": "
                                                               << e.what());
                 }
-                auto total = timer.elapsed().wall;
+                auto total = nodeTimer.elapsed().wall + prebuildTime;
                 for (auto const& node : g[m].nodes) {
                     timings["6 build " + ore::data::to_string(node.obj)] += total / g[m].nodes.size();
                     counts["6 build " + ore::data::to_string(node.obj)].inc();
                 }
+                calibrationInfo_->nodeBuildTimes[configuration][ore::data::to_string(g[m])] =
+                    static_cast<double>(total) / 1.0E6;
+            };
+
+            if (!pool) {
+                for (auto const& m : order)
+                    build(m, 0);
+            } else {
+
+                /* Split the nodes into waves: a node's wave is one more than the maximum wave of the nodes it depends
+                   on (its out edges), so all dependencies of a wave are built in previous waves. Within a wave the
+                   nodes keep their topological order. */
+
+                std::map<ReducedVertex, Size> level;
+                std::vector<std::vector<ReducedVertex>> waves;
+                for (auto const& m : order) {
+                    Size l = 0;
+                    boost::graph_traits<ReducedGraph>::out_edge_iterator e, eend;
+                    for (std::tie(e, eend) = boost::out_edges(m, g); e != eend; ++e) {
+                        if (auto t = level.find(boost::target(*e, g)); t != level.end())
+                            l = std::max(l, t->second + 1);
+                    }
+                    level[m] = l;
+                    if (waves.size() <= l)
+                        waves.resize(l + 1);
+                    waves[l].push_back(m);
+                }
+                DLOG("Build " << order.size() << " nodes in " << waves.size() << " waves using " << pool->size()
+                              << " threads.");
+
+                for (auto const& wave : waves) {
+
+                    // select the nodes for which the curve objects can be constructed on the worker threads
+
+                    std::vector<ReducedVertex> prebuild;
+                    std::set<std::string> specNames;
+                    for (auto const& m : wave) {
+                        if (!canBuildCurveInParallel(g[m]))
+                            continue;
+                        // a curve shared by several nodes is only built once
+                        if (std::any_of(g[m].nodes.begin(), g[m].nodes.end(),
+                                        [&specNames](const Node& n) { return specNames.count(n.curveSpec->name()); }))
+                            continue;
+                        for (auto const& n : g[m].nodes)
+                            specNames.insert(n.curveSpec->name());
+                        prebuild.push_back(m);
+                    }
+
+                    // construct the curve objects in parallel
+
+                    std::vector<std::pair<QuantLib::ext::shared_ptr<void>, std::exception_ptr>> curves(
+                        prebuild.size());
+                    std::vector<boost::timer::nanosecond_type> prebuildTimes(prebuild.size(), 0);
+                    pool->parallelFor(prebuild.size(), 1, [&](std::size_t begin, std::size_t end, std::size_t t) {
+                        if (t > 0 && !threadInitialised[t]) {
+                            threadState.apply();
+                            threadObservables[t] = threadState.observables();
+                            threadInitialised[t] = true;
+                        }
+                        for (std::size_t i = begin; i < end; ++i) {
+                            boost::timer::cpu_timer curveTimer;
+                            try {
+                                curves[i].first = buildCurve(configuration, g[prebuild[i]]);
+                            } catch (...) {
+                                curves[i].second = std::current_exception();
+                            }
+                            prebuildTimes[i] = curveTimer.elapsed().wall;
+                        }
+                    });
+
+                    // add the objects to the market on this thread, buildNode() picks up the prebuilt curves
+
+                    std::map<ReducedVertex, boost::timer::nanosecond_type> prebuildTime;
+                    for (Size i = 0; i < prebuild.size(); ++i) {
+                        prebuiltCurves_[&g[prebuild[i]]] = curves[i];
+                        prebuildTime[prebuild[i]] = prebuildTimes[i];
+                    }
+                    for (auto const& m : wave)
+                        build(m, prebuildTime[m]);
+                    prebuiltCurves_.clear();
+                }
             }
 
             LOG("Loaded CurvesSpecs: success: " << countSuccess << ", error: " << countError);
 
         }
 
+        // the objects built on the worker threads have to be notified of changes on the calling thread
+
+        if (pool) {
+            workerNotificationForwarders_ = threadState.notificationForwarders(threadObservables);
+            buildThreads_ = pool->size();
+        }
+
     } else {
         LOG("Build objects in TodaysMarket lazily, i.e. when requested.");
+        if (nThreads_ > 1)
+            LOG("TodaysMarket: the market is built lazily, the number of threads (" << nThreads_ << ") is ignored.");
     }
 
     // output stats on initialisation phase
@@ -297,11 +416,7 @@ void TodaysMarket::buildNode(const std::string& configuration, ReducedNode& redu
         if (std::any_of(ycspecs.begin(), ycspecs.end(), [this](const auto& s) {
                 return requiredYieldCurves_.find(s->name()) == requiredYieldCurves_.end();
             })) {
-            DLOG("Building YieldCurve " << reducedNode << " for asof " << asof_);
-            yieldCurve = QuantLib::ext::make_shared<YieldCurve>(
-                asof_, ycspecs, *curveConfigs_, *loader_, requiredYieldCurves_, requiredDefaultCurves_, *fx_,
-                referenceData_, iborFallbackConfig_, preserveQuoteLinkage_, buildCalibrationInfo_, this,
-                useAtParCoupons_);
+            yieldCurve = QuantLib::ext::static_pointer_cast<YieldCurve>(curve(configuration, reducedNode));
         }
 
         for (auto const& node: reducedNode.nodes) {
@@ -420,11 +535,8 @@ void TodaysMarket::buildNode(const std::string& configuration, ReducedNode& redu
 
             auto itr = requiredGenericYieldVolCurves_.find(swvolspec->name());
             if (itr == requiredGenericYieldVolCurves_.end()) {
-                DLOG("Building Swaption Volatility (" << node.name << ") for asof " << asof_);
-                QuantLib::ext::shared_ptr<SwaptionVolCurve> swaptionVolCurve =
-                    QuantLib::ext::make_shared<SwaptionVolCurve>(asof_, *swvolspec, *loader_, *curveConfigs_,
-                                                                 requiredSwapIndices_[configuration],
-                                                                 requiredGenericYieldVolCurves_, buildCalibrationInfo_);
+                auto swaptionVolCurve =
+                    QuantLib::ext::static_pointer_cast<SwaptionVolCurve>(curve(configuration, reducedNode));
                 calibrationInfo_->irVolCalibrationInfo[swvolspec->name()] = swaptionVolCurve->calibrationInfo();
                 itr = requiredGenericYieldVolCurves_.insert(make_pair(swvolspec->name(), swaptionVolCurve)).first;
             }
@@ -450,9 +562,7 @@ void TodaysMarket::buildNode(const std::string& configuration, ReducedNode& redu
             QL_REQUIRE(ydvolspec, "Failed to convert spec " << *spec);
             auto itr = requiredGenericYieldVolCurves_.find(ydvolspec->name());
             if (itr == requiredGenericYieldVolCurves_.end()) {
-                DLOG("Building Yield Volatility for asof " << asof_);
-                QuantLib::ext::shared_ptr<YieldVolCurve> yieldVolCurve = QuantLib::ext::make_shared<YieldVolCurve>(
-                    asof_, *ydvolspec, *loader_, *curveConfigs_, buildCalibrationInfo_);
+                auto yieldVolCurve = QuantLib::ext::static_pointer_cast<YieldVolCurve>(curve(configuration, reducedNode));
                 calibrationInfo_->irVolCalibrationInfo[ydvolspec->name()] = yieldVolCurve->calibrationInfo();
                 itr = requiredGenericYieldVolCurves_.insert(make_pair(ydvolspec->name(), yieldVolCurve)).first;
             }
@@ -473,40 +583,17 @@ void TodaysMarket::buildNode(const std::string& configuration, ReducedNode& redu
 
             auto itr = requiredCapFloorVolCurves_.find(cfVolSpec->name());
             if (itr == requiredCapFloorVolCurves_.end()) {
-                DLOG("Building cap/floor volatility for asof " << asof_);
+                auto capFloorVolCurve =
+                    QuantLib::ext::static_pointer_cast<CapFloorVolCurve>(curve(configuration, reducedNode));
 
-                // Firstly, need to retrieve ibor index and discount curve
-                // Ibor index
+                // for proxy curves the index and rate computation period are taken from the target index
                 std::string iborIndexName = cfg->index();
                 QuantLib::Period rateComputationPeriod = cfg->rateComputationPeriod();
-                Handle<IborIndex> iborIndex = MarketImpl::iborIndex(iborIndexName, configuration);
-                Handle<YieldTermStructure> discountCurve;
-                // Discount curve
-                if (!cfg->discountCurve().empty()) {
-                    auto it = requiredYieldCurves_.find(cfg->discountCurve());
-                    QL_REQUIRE(it != requiredYieldCurves_.end(), "Discount curve with spec, "
-                                                                     << cfg->discountCurve()
-                                                                     << ", not found in loaded yield curves");
-                    discountCurve = it->second->handle(it->first);
+                if (!cfg->proxySourceCurveId().empty() && !cfg->proxyTargetIndex().empty()) {
+                    iborIndexName = cfg->proxyTargetIndex();
+                    rateComputationPeriod = cfg->proxyTargetRateComputationPeriod();
                 }
 
-                // for proxy curves we need the source and target indices
-                QuantLib::ext::shared_ptr<IborIndex> sourceIndex, targetIndex;
-                if (!cfg->proxySourceCurveId().empty()) {
-                    if (!cfg->proxySourceIndex().empty())
-                        sourceIndex = *MarketImpl::iborIndex(cfg->proxySourceIndex(), configuration);
-                    if (!cfg->proxyTargetIndex().empty()) {
-                        targetIndex = *MarketImpl::iborIndex(cfg->proxyTargetIndex(), configuration);
-                        iborIndexName = cfg->proxyTargetIndex();
-                        rateComputationPeriod = cfg->proxyTargetRateComputationPeriod();
-                    }
-                }
-
-                // Now create cap/floor vol curve
-                QuantLib::ext::shared_ptr<CapFloorVolCurve> capFloorVolCurve =
-                    QuantLib::ext::make_shared<CapFloorVolCurve>(
-                        asof_, *cfVolSpec, *loader_, *curveConfigs_, iborIndex.currentLink(), discountCurve,
-                        sourceIndex, targetIndex, requiredCapFloorVolCurves_, buildCalibrationInfo_);
                 calibrationInfo_->irVolCalibrationInfo[cfVolSpec->name()] = capFloorVolCurve->calibrationInfo();
                 itr = requiredCapFloorVolCurves_
                           .insert(make_pair(
@@ -531,9 +618,7 @@ void TodaysMarket::buildNode(const std::string& configuration, ReducedNode& redu
             auto itr = requiredDefaultCurves_.find(defaultspec->name());
             if (itr == requiredDefaultCurves_.end()) {
                 // build the curve
-                DLOG("Building DefaultCurve for asof " << asof_);
-                QuantLib::ext::shared_ptr<DefaultCurve> defaultCurve = QuantLib::ext::make_shared<DefaultCurve>(
-                    asof_, *defaultspec, *loader_, *curveConfigs_, requiredYieldCurves_, requiredDefaultCurves_);
+                auto defaultCurve = QuantLib::ext::static_pointer_cast<DefaultCurve>(curve(configuration, reducedNode));
                 itr = requiredDefaultCurves_.insert(make_pair(defaultspec->name(), defaultCurve)).first;
             }
             DLOG("Adding DefaultCurve (" << node.name << ") with spec " << *defaultspec << " to configuration "
@@ -552,9 +637,7 @@ void TodaysMarket::buildNode(const std::string& configuration, ReducedNode& redu
             QL_REQUIRE(cdsvolspec, "Failed to convert spec " << *spec);
             auto itr = requiredCDSVolCurves_.find(cdsvolspec->name());
             if (itr == requiredCDSVolCurves_.end()) {
-                DLOG("Building CDSVol for asof " << asof_);
-                QuantLib::ext::shared_ptr<CDSVolCurve> cdsVolCurve = QuantLib::ext::make_shared<CDSVolCurve>(
-                    asof_, *cdsvolspec, *loader_, *curveConfigs_, requiredCDSVolCurves_, requiredDefaultCurves_);
+                auto cdsVolCurve = QuantLib::ext::static_pointer_cast<CDSVolCurve>(curve(configuration, reducedNode));
                 itr = requiredCDSVolCurves_.insert(make_pair(cdsvolspec->name(), cdsVolCurve)).first;
             }
             DLOG("Adding CDSVol (" << node.name << ") with spec " << *cdsvolspec << " to configuration "
@@ -571,11 +654,8 @@ void TodaysMarket::buildNode(const std::string& configuration, ReducedNode& redu
             QL_REQUIRE(baseCorrelationSpec, "Failed to convert spec " << *spec);
             auto itr = requiredBaseCorrelationCurves_.find(baseCorrelationSpec->name());
             if (itr == requiredBaseCorrelationCurves_.end()) {
-                DLOG("Building BaseCorrelation for asof " << asof_);
-                QuantLib::ext::shared_ptr<BaseCorrelationCurve> baseCorrelationCurve =
-                    QuantLib::ext::make_shared<BaseCorrelationCurve>(
-                        asof_, *baseCorrelationSpec, *loader_, *curveConfigs_, referenceData_, requiredYieldCurves_,
-                        requiredDefaultCurves_, params_->mapping(MarketObject::DefaultCurve, configuration));
+                auto baseCorrelationCurve =
+                    QuantLib::ext::static_pointer_cast<BaseCorrelationCurve>(curve(configuration, reducedNode));
                 itr =
                     requiredBaseCorrelationCurves_.insert(make_pair(baseCorrelationSpec->name(), baseCorrelationCurve))
                         .first;
@@ -595,9 +675,8 @@ void TodaysMarket::buildNode(const std::string& configuration, ReducedNode& redu
             QL_REQUIRE(inflationspec, "Failed to convert spec " << *spec << " to inflation curve spec");
             auto itr = requiredInflationCurves_.find(inflationspec->name());
             if (itr == requiredInflationCurves_.end()) {
-                DLOG("Building InflationCurve " << inflationspec->name() << " for asof " << asof_);
-                QuantLib::ext::shared_ptr<InflationCurve> inflationCurve = QuantLib::ext::make_shared<InflationCurve>(
-                    asof_, *inflationspec, *loader_, *curveConfigs_, requiredYieldCurves_, buildCalibrationInfo_);
+                auto inflationCurve =
+                    QuantLib::ext::static_pointer_cast<InflationCurve>(curve(configuration, reducedNode));
                 itr = requiredInflationCurves_.insert(make_pair(inflationspec->name(), inflationCurve)).first;
                 calibrationInfo_->inflationCurveCalibrationInfo[inflationspec->name()] =
                     inflationCurve->calibrationInfo();
@@ -639,11 +718,8 @@ void TodaysMarket::buildNode(const std::string& configuration, ReducedNode& redu
             QL_REQUIRE(infcapfloorspec, "Failed to convert spec " << *spec << " to inf cap floor spec");
             auto itr = requiredInflationCapFloorVolCurves_.find(infcapfloorspec->name());
             if (itr == requiredInflationCapFloorVolCurves_.end()) {
-                DLOG("Building InflationCapFloorVolatilitySurface for asof " << asof_);
-                QuantLib::ext::shared_ptr<InflationCapFloorVolCurve> inflationCapFloorVolCurve =
-                    QuantLib::ext::make_shared<InflationCapFloorVolCurve>(asof_, *infcapfloorspec, *loader_,
-                                                                          *curveConfigs_, requiredYieldCurves_,
-                                                                          requiredInflationCurves_);
+                auto inflationCapFloorVolCurve =
+                    QuantLib::ext::static_pointer_cast<InflationCapFloorVolCurve>(curve(configuration, reducedNode));
                 calibrationInfo_->cpiVolCalibrationInfo[infcapfloorspec->name()] =
                     inflationCapFloorVolCurve->calibrationInfo();
                 itr = requiredInflationCapFloorVolCurves_
@@ -742,9 +818,7 @@ void TodaysMarket::buildNode(const std::string& configuration, ReducedNode& redu
             QL_REQUIRE(securityspec, "Failed to convert spec " << *spec << " to security spec");
             auto itr = requiredSecurities_.find(securityspec->securityID());
             if (itr == requiredSecurities_.end()) {
-                DLOG("Building Securities for asof " << asof_);
-                QuantLib::ext::shared_ptr<Security> security =
-                    QuantLib::ext::make_shared<Security>(asof_, *securityspec, *loader_, *curveConfigs_);
+                auto security = QuantLib::ext::static_pointer_cast<Security>(curve(configuration, reducedNode));
                 itr = requiredSecurities_.insert(make_pair(securityspec->securityID(), security)).first;
             }
             DLOG("Adding Security (" << node.name << ") with spec " << *securityspec << " to configuration "
@@ -769,10 +843,8 @@ void TodaysMarket::buildNode(const std::string& configuration, ReducedNode& redu
             QL_REQUIRE(commodityCurveSpec, "Failed to convert spec, " << *spec << ", to CommodityCurveSpec");
             auto itr = requiredCommodityCurves_.find(commodityCurveSpec->name());
             if (itr == requiredCommodityCurves_.end()) {
-                DLOG("Building CommodityCurve " << commodityCurveSpec->name() << " for asof " << asof_);
-                QuantLib::ext::shared_ptr<CommodityCurve> commodityCurve = QuantLib::ext::make_shared<CommodityCurve>(
-                    asof_, *commodityCurveSpec, *loader_, *curveConfigs_, *fx_, requiredYieldCurves_,
-                    requiredCommodityCurves_, buildCalibrationInfo_);
+                auto commodityCurve =
+                    QuantLib::ext::static_pointer_cast<CommodityCurve>(curve(configuration, reducedNode));
                 itr = requiredCommodityCurves_.insert(make_pair(commodityCurveSpec->name(), commodityCurve)).first;
             }
 
@@ -829,10 +901,7 @@ void TodaysMarket::buildNode(const std::string& configuration, ReducedNode& redu
                 QuantLib::ext::dynamic_pointer_cast<CorrelationCurveSpec>(spec);
             auto itr = requiredCorrelationCurves_.find(corrspec->name());
             if (itr == requiredCorrelationCurves_.end()) {
-                DLOG("Building CorrelationCurve for asof " << asof_);
-                QuantLib::ext::shared_ptr<CorrelationCurve> corrCurve = QuantLib::ext::make_shared<CorrelationCurve>(
-                    asof_, *corrspec, *loader_, *curveConfigs_, requiredSwapIndices_[configuration],
-                    requiredYieldCurves_, requiredGenericYieldVolCurves_);
+                auto corrCurve = QuantLib::ext::static_pointer_cast<CorrelationCurve>(curve(configuration, reducedNode));
                 itr = requiredCorrelationCurves_.insert(make_pair(corrspec->name(), corrCurve)).first;
             }
 
@@ -878,6 +947,227 @@ void TodaysMarket::buildNode(const std::string& configuration, ReducedNode& redu
 
 } // TodaysMarket::buildNode()
 
+bool TodaysMarket::canBuildCurveInParallel(const ReducedNode& reducedNode) const {
+
+    if (std::all_of(reducedNode.nodes.begin(), reducedNode.nodes.end(), [](const Node& n) { return n.built; }))
+        return false;
+
+    auto const& spec = reducedNode.nodes.begin()->curveSpec;
+    if (std::any_of(reducedNode.nodes.begin(), reducedNode.nodes.end(),
+                    [&spec](const Node& n) { return n.curveSpec->baseType() != spec->baseType(); }))
+        return false;
+
+    // the curve is only constructed if buildNode() would construct it, i.e. if it is not cached yet
+
+    switch (spec->baseType()) {
+    case CurveSpec::CurveType::Yield:
+        return std::any_of(reducedNode.nodes.begin(), reducedNode.nodes.end(), [this](const Node& n) {
+            return requiredYieldCurves_.find(n.curveSpec->name()) == requiredYieldCurves_.end();
+        });
+    case CurveSpec::CurveType::SwaptionVolatility:
+    case CurveSpec::CurveType::YieldVolatility:
+        return reducedNode.nodes.size() == 1 &&
+               requiredGenericYieldVolCurves_.find(spec->name()) == requiredGenericYieldVolCurves_.end();
+    case CurveSpec::CurveType::CapFloorVolatility:
+        return reducedNode.nodes.size() == 1 &&
+               requiredCapFloorVolCurves_.find(spec->name()) == requiredCapFloorVolCurves_.end();
+    case CurveSpec::CurveType::Default:
+        return reducedNode.nodes.size() == 1 &&
+               requiredDefaultCurves_.find(spec->name()) == requiredDefaultCurves_.end();
+    case CurveSpec::CurveType::CDSVolatility:
+        return reducedNode.nodes.size() == 1 &&
+               requiredCDSVolCurves_.find(spec->name()) == requiredCDSVolCurves_.end();
+    case CurveSpec::CurveType::BaseCorrelation:
+        return reducedNode.nodes.size() == 1 &&
+               requiredBaseCorrelationCurves_.find(spec->name()) == requiredBaseCorrelationCurves_.end();
+    case CurveSpec::CurveType::Inflation:
+        return reducedNode.nodes.size() == 1 &&
+               requiredInflationCurves_.find(spec->name()) == requiredInflationCurves_.end();
+    case CurveSpec::CurveType::InflationCapFloorVolatility:
+        return reducedNode.nodes.size() == 1 &&
+               requiredInflationCapFloorVolCurves_.find(spec->name()) == requiredInflationCapFloorVolCurves_.end();
+    case CurveSpec::CurveType::Security: {
+        auto securityspec = QuantLib::ext::dynamic_pointer_cast<SecuritySpec>(spec);
+        return reducedNode.nodes.size() == 1 && securityspec &&
+               requiredSecurities_.find(securityspec->securityID()) == requiredSecurities_.end();
+    }
+    case CurveSpec::CurveType::Commodity:
+        return reducedNode.nodes.size() == 1 &&
+               requiredCommodityCurves_.find(spec->name()) == requiredCommodityCurves_.end();
+    case CurveSpec::CurveType::Correlation:
+        return reducedNode.nodes.size() == 1 &&
+               requiredCorrelationCurves_.find(spec->name()) == requiredCorrelationCurves_.end();
+    default:
+        // fx vols, equity curves and vols and commodity vols use the market and the dividend manager during their
+        // construction, swap indices are added to the market directly, all of them are built on the calling thread
+        return false;
+    }
+}
+
+QuantLib::ext::shared_ptr<void> TodaysMarket::curve(const std::string& configuration,
+                                                    const ReducedNode& reducedNode) const {
+    auto p = prebuiltCurves_.find(&reducedNode);
+    if (p == prebuiltCurves_.end())
+        return buildCurve(configuration, reducedNode);
+    auto result = p->second;
+    prebuiltCurves_.erase(p);
+    if (result.second)
+        std::rethrow_exception(result.second);
+    return result.first;
+}
+
+QuantLib::ext::shared_ptr<void> TodaysMarket::buildCurve(const std::string& configuration,
+                                                         const ReducedNode& reducedNode) const {
+
+    // this method only reads the cached market objects, so that it can be called on several threads at the same time
+
+    static const map<string, QuantLib::ext::shared_ptr<SwapIndex>> noSwapIndices;
+    auto swapIndices = requiredSwapIndices_.find(configuration);
+    const map<string, QuantLib::ext::shared_ptr<SwapIndex>>& requiredSwapIndices =
+        swapIndices == requiredSwapIndices_.end() ? noSwapIndices : swapIndices->second;
+
+    auto spec = reducedNode.nodes.begin()->curveSpec;
+
+    switch (spec->baseType()) {
+
+    case CurveSpec::CurveType::Yield: {
+        std::vector<QuantLib::ext::shared_ptr<YieldCurveSpec>> ycspecs;
+        for (auto const& node : reducedNode.nodes) {
+            auto ycspec = QuantLib::ext::dynamic_pointer_cast<YieldCurveSpec>(node.curveSpec);
+            QL_REQUIRE(ycspec, "Failed to convert spec " << *node.curveSpec << " to yield curve spec.");
+            ycspecs.push_back(ycspec);
+        }
+        DLOG("Building YieldCurve " << reducedNode << " for asof " << asof_);
+        return QuantLib::ext::make_shared<YieldCurve>(asof_, ycspecs, *curveConfigs_, *loader_, requiredYieldCurves_,
+                                                      requiredDefaultCurves_, *fx_, referenceData_, iborFallbackConfig_,
+                                                      preserveQuoteLinkage_, buildCalibrationInfo_, this,
+                                                      useAtParCoupons_);
+    }
+
+    case CurveSpec::CurveType::SwaptionVolatility: {
+        auto swvolspec = QuantLib::ext::dynamic_pointer_cast<SwaptionVolatilityCurveSpec>(spec);
+        QL_REQUIRE(swvolspec, "Failed to convert spec " << *spec);
+        DLOG("Building Swaption Volatility (" << reducedNode.nodes.begin()->name << ") for asof " << asof_);
+        return QuantLib::ext::make_shared<SwaptionVolCurve>(asof_, *swvolspec, *loader_, *curveConfigs_,
+                                                            requiredSwapIndices, requiredGenericYieldVolCurves_,
+                                                            buildCalibrationInfo_);
+    }
+
+    case CurveSpec::CurveType::YieldVolatility: {
+        auto ydvolspec = QuantLib::ext::dynamic_pointer_cast<YieldVolatilityCurveSpec>(spec);
+        QL_REQUIRE(ydvolspec, "Failed to convert spec " << *spec);
+        DLOG("Building Yield Volatility for asof " << asof_);
+        return QuantLib::ext::make_shared<YieldVolCurve>(asof_, *ydvolspec, *loader_, *curveConfigs_,
+                                                         buildCalibrationInfo_);
+    }
+
+    case CurveSpec::CurveType::CapFloorVolatility: {
+        auto cfVolSpec = QuantLib::ext::dynamic_pointer_cast<CapFloorVolatilityCurveSpec>(spec);
+        QL_REQUIRE(cfVolSpec, "Failed to convert spec " << *spec);
+        QuantLib::ext::shared_ptr<CapFloorVolatilityCurveConfig> cfg =
+            curveConfigs_->capFloorVolCurveConfig(cfVolSpec->curveConfigID());
+        DLOG("Building cap/floor volatility for asof " << asof_);
+
+        // Firstly, need to retrieve ibor index and discount curve
+        // Ibor index
+        Handle<IborIndex> iborIndex = MarketImpl::iborIndex(cfg->index(), configuration);
+        Handle<YieldTermStructure> discountCurve;
+        // Discount curve
+        if (!cfg->discountCurve().empty()) {
+            auto it = requiredYieldCurves_.find(cfg->discountCurve());
+            QL_REQUIRE(it != requiredYieldCurves_.end(), "Discount curve with spec, "
+                                                             << cfg->discountCurve()
+                                                             << ", not found in loaded yield curves");
+            discountCurve = it->second->handle(it->first);
+        }
+
+        // for proxy curves we need the source and target indices
+        QuantLib::ext::shared_ptr<IborIndex> sourceIndex, targetIndex;
+        if (!cfg->proxySourceCurveId().empty()) {
+            if (!cfg->proxySourceIndex().empty())
+                sourceIndex = *MarketImpl::iborIndex(cfg->proxySourceIndex(), configuration);
+            if (!cfg->proxyTargetIndex().empty())
+                targetIndex = *MarketImpl::iborIndex(cfg->proxyTargetIndex(), configuration);
+        }
+
+        // Now create cap/floor vol curve
+        return QuantLib::ext::make_shared<CapFloorVolCurve>(asof_, *cfVolSpec, *loader_, *curveConfigs_,
+                                                            iborIndex.currentLink(), discountCurve, sourceIndex,
+                                                            targetIndex, requiredCapFloorVolCurves_,
+                                                            buildCalibrationInfo_);
+    }
+
+    case CurveSpec::CurveType::Default: {
+        auto defaultspec = QuantLib::ext::dynamic_pointer_cast<DefaultCurveSpec>(spec);
+        QL_REQUIRE(defaultspec, "Failed to convert spec " << *spec);
+        DLOG("Building DefaultCurve for asof " << asof_);
+        return QuantLib::ext::make_shared<DefaultCurve>(asof_, *defaultspec, *loader_, *curveConfigs_,
+                                                        requiredYieldCurves_, requiredDefaultCurves_);
+    }
+
+    case CurveSpec::CurveType::CDSVolatility: {
+        auto cdsvolspec = QuantLib::ext::dynamic_pointer_cast<CDSVolatilityCurveSpec>(spec);
+        QL_REQUIRE(cdsvolspec, "Failed to convert spec " << *spec);
+        DLOG("Building CDSVol for asof " << asof_);
+        return QuantLib::ext::make_shared<CDSVolCurve>(asof_, *cdsvolspec, *loader_, *curveConfigs_,
+                                                       requiredCDSVolCurves_, requiredDefaultCurves_);
+    }
+
+    case CurveSpec::CurveType::BaseCorrelation: {
+        auto baseCorrelationSpec = QuantLib::ext::dynamic_pointer_cast<BaseCorrelationCurveSpec>(spec);
+        QL_REQUIRE(baseCorrelationSpec, "Failed to convert spec " << *spec);
+        DLOG("Building BaseCorrelation for asof " << asof_);
+        return QuantLib::ext::make_shared<BaseCorrelationCurve>(
+            asof_, *baseCorrelationSpec, *loader_, *curveConfigs_, referenceData_, requiredYieldCurves_,
+            requiredDefaultCurves_, params_->mapping(MarketObject::DefaultCurve, configuration));
+    }
+
+    case CurveSpec::CurveType::Inflation: {
+        auto inflationspec = QuantLib::ext::dynamic_pointer_cast<InflationCurveSpec>(spec);
+        QL_REQUIRE(inflationspec, "Failed to convert spec " << *spec << " to inflation curve spec");
+        DLOG("Building InflationCurve " << inflationspec->name() << " for asof " << asof_);
+        return QuantLib::ext::make_shared<InflationCurve>(asof_, *inflationspec, *loader_, *curveConfigs_,
+                                                          requiredYieldCurves_, buildCalibrationInfo_);
+    }
+
+    case CurveSpec::CurveType::InflationCapFloorVolatility: {
+        auto infcapfloorspec = QuantLib::ext::dynamic_pointer_cast<InflationCapFloorVolatilityCurveSpec>(spec);
+        QL_REQUIRE(infcapfloorspec, "Failed to convert spec " << *spec << " to inf cap floor spec");
+        DLOG("Building InflationCapFloorVolatilitySurface for asof " << asof_);
+        return QuantLib::ext::make_shared<InflationCapFloorVolCurve>(
+            asof_, *infcapfloorspec, *loader_, *curveConfigs_, requiredYieldCurves_, requiredInflationCurves_);
+    }
+
+    case CurveSpec::CurveType::Security: {
+        auto securityspec = QuantLib::ext::dynamic_pointer_cast<SecuritySpec>(spec);
+        QL_REQUIRE(securityspec, "Failed to convert spec " << *spec << " to security spec");
+        DLOG("Building Securities for asof " << asof_);
+        return QuantLib::ext::make_shared<Security>(asof_, *securityspec, *loader_, *curveConfigs_);
+    }
+
+    case CurveSpec::CurveType::Commodity: {
+        auto commodityCurveSpec = QuantLib::ext::dynamic_pointer_cast<CommodityCurveSpec>(spec);
+        QL_REQUIRE(commodityCurveSpec, "Failed to convert spec, " << *spec << ", to CommodityCurveSpec");
+        DLOG("Building CommodityCurve " << commodityCurveSpec->name() << " for asof " << asof_);
+        return QuantLib::ext::make_shared<CommodityCurve>(asof_, *commodityCurveSpec, *loader_, *curveConfigs_, *fx_,
+                                                          requiredYieldCurves_, requiredCommodityCurves_,
+                                                          buildCalibrationInfo_);
+    }
+
+    case CurveSpec::CurveType::Correlation: {
+        auto corrspec = QuantLib::ext::dynamic_pointer_cast<CorrelationCurveSpec>(spec);
+        DLOG("Building CorrelationCurve for asof " << asof_);
+        return QuantLib::ext::make_shared<CorrelationCurve>(asof_, *corrspec, *loader_, *curveConfigs_,
+                                                            requiredSwapIndices, requiredYieldCurves_,
+                                                            requiredGenericYieldVolCurves_);
+    }
+
+    default:
+        QL_FAIL("TodaysMarket::buildCurve(" << configuration << "," << reducedNode << "): Unhandled spec " << *spec);
+    }
+
+} // TodaysMarket::buildCurve()
+
 void TodaysMarket::require(const MarketObject o, const string& name, const string& configuration,
                            const bool forceBuild) const {
 
@@ -985,6 +1275,7 @@ void TodaysMarket::require(const MarketObject o, const string& name, const strin
     for (auto const& m : order) {
         if (std::all_of(g[m].nodes.begin(),g[m].nodes.end(),[](const Node&n) { return n.built;}))
             continue;
+        boost::timer::cpu_timer timer;
         try {
             buildNode(configuration, g[m]);
             ++countSuccess;
@@ -995,6 +1286,8 @@ void TodaysMarket::require(const MarketObject o, const string& name, const strin
             ALOG("error while building reduced node " << g[m] << " in configuration " << configuration << ": "
                                                       << e.what());
         }
+        calibrationInfo_->nodeBuildTimes[configuration][ore::data::to_string(g[m])] =
+            static_cast<double>(timer.elapsed().wall) / 1.0E6;
     }
 
     if (countSuccess + countError > 0) {
@@ -35,9 +35,11 @@
 #include <boost/graph/adjacency_list.hpp>
 #include <boost/graph/directed_graph.hpp>
 #include <boost/graph/graph_traits.hpp>
+#include <ql/patterns/observable.hpp>
 #include <ql/shared_ptr.hpp>
 #include <boost/enable_shared_from_this.hpp>
 
+#include <exception>
 #include <map>
 
 namespace ore {
@@ -75,6 +77,17 @@ class CorrelationCurve;
   Today's market's purpose is t0 pricing, the Simulation Market's purpose is
   pricing under future scenarios.
 
+  If nThreads > 1 and the market is not built lazily, the nodes of the dependency graph of a configuration are built
+  in waves, a wave consisting of the nodes whose dependencies are all built in previous waves. The curve objects of a
+  wave (yield curves, default curves, inflation curves, ir and credit vols, etc.) are constructed in parallel, then
+  they are added to the market on the calling thread in the same way as in the serial build. FX, equity and
+  commodity vols, equity curves and swap indices are always built on the calling thread. The parallel build requires
+  QuantLib to be built with sessions and the thread safe observer pattern, otherwise the market is built serially.
+  The worker threads use the evaluation date, settings and index fixings of the calling thread. Objects constructed on
+  a worker thread register with the evaluation date and the index notifiers of that thread. The market forwards the
+  notifications of the calling thread's evaluation date and of the notifiers of the indices with fixings to them, so
+  these objects are notified in the same way as in a serial build. The parallel build is not used for a lazy build.
+
   \ingroup marketdata
  */
 class TodaysMarket : public MarketImpl {
@@ -105,10 +118,18 @@ public:
         //! support pseudo currencies
         const bool handlePseudoCurrencies = true,
         //! use at par coupon convention for rate curve building
-        const bool useAtParCoupons = true);
+        const bool useAtParCoupons = true,
+        //! number of threads used to build the market objects if lazyBuild is false, 1 means a serial build
+        const QuantLib::Size nThreads = 1);
 
     QuantLib::ext::shared_ptr<TodaysMarketCalibrationInfo> calibrationInfo() const { return calibrationInfo_; }
 
+    //! true if the market objects are built on their first request
+    bool lazyBuild() const { return lazyBuild_; }
+
+    //! number of threads that were used to build the market objects, 1 for a serial or lazy build
+    QuantLib::Size buildThreads() const { return buildThreads_; }
+
 private:
     // MarketImpl interface
     void require(const MarketObject o, const string& name, const string& configuration,
@@ -128,6 +149,11 @@ private:
     QuantLib::ext::shared_ptr<ore::data::IborFallbackConfig> iborFallbackConfig_;
     bool buildCalibrationInfo_;
     bool useAtParCoupons_;
+    QuantLib::Size nThreads_;
+    QuantLib::Size buildThreads_ = 1;
+
+    // forward notifications from the calling thread's singletons to the ones of the worker threads of a parallel build
+    std::vector<QuantLib::ext::shared_ptr<QuantLib::Observer>> workerNotificationForwarders_;
 
     // initialise market
     void initialise(const Date& asof);
@@ -150,6 +176,20 @@ private:
     // build a single market object
     void buildNode(const std::string& configuration, ReducedNode& reducedNode) const;
 
+    /* construct the curve object of a node without adding it to the market or the caches, this only reads the
+       market state and can be called on several threads at the same time */
+    QuantLib::ext::shared_ptr<void> buildCurve(const std::string& configuration, const ReducedNode& reducedNode) const;
+
+    // the curve object of a node, taken from prebuiltCurves_ if available there, otherwise built by buildCurve()
+    QuantLib::ext::shared_ptr<void> curve(const std::string& configuration, const ReducedNode& reducedNode) const;
+
+    // true if buildCurve() can be called for the node on a worker thread
+    bool canBuildCurveInParallel(const ReducedNode& reducedNode) const;
+
+    // curve objects constructed on worker threads, or the error that occurred, by node
+    mutable std::map<const ReducedNode*, std::pair<QuantLib::ext::shared_ptr<void>, std::exception_ptr>>
+        prebuiltCurves_;
+
     // calibration results
     QuantLib::ext::shared_ptr<TodaysMarketCalibrationInfo> calibrationInfo_;
 
@@ -221,6 +221,8 @@ struct TodaysMarketCalibrationInfo {
     std::map<std::string, QuantLib::ext::shared_ptr<FxEqCommVolCalibrationInfo>> commVolCalibrationInfo;
     // cpi vols
     std::map<std::string, QuantLib::ext::shared_ptr<CpiVolCalibrationInfo>> cpiVolCalibrationInfo;
+    // wall time in ms to build the nodes of the dependency graph, configuration => reduced node => time
+    std::map<std::string, std::map<std::string, double>> nodeBuildTimes;
 };
 
 } // namespace data
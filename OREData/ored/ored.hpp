@@ -72,6 +72,7 @@
 #include <ored/marketdata/strike.hpp>
 #include <ored/marketdata/structuredcurveerror.hpp>
 #include <ored/marketdata/swaptionvolcurve.hpp>
+#include <ored/marketdata/synchronizedmarket.hpp>
 #include <ored/marketdata/todaysmarket.hpp>
 #include <ored/marketdata/todaysmarketcalibrationinfo.hpp>
 #include <ored/marketdata/todaysmarketparameters.hpp>
@@ -404,9 +405,11 @@
 #include <ored/scripting/scriptedinstrument.hpp>
 #include <ored/scripting/scriptengine.hpp>
 #include <ored/scripting/scriptparser.hpp>
+#include <ored/scripting/scriptprogram.hpp>
 #include <ored/scripting/staticanalyser.hpp>
 #include <ored/scripting/utilities.hpp>
 #include <ored/scripting/value.hpp>
+#include <ored/utilities/asynclogger.hpp>
 #include <ored/utilities/bondindexbuilder.hpp>
 #include <ored/utilities/calendaradjustmentconfig.hpp>
 #include <ored/utilities/calendarparser.hpp>
@@ -437,5 +440,6 @@
 #include <ored/utilities/to_string.hpp>
 #include <ored/utilities/vectorutils.hpp>
 #include <ored/utilities/wildcard.hpp>
+#include <ored/utilities/workerthreadstate.hpp>
 #include <ored/utilities/xmlutils.hpp>
 #include <ored/version.hpp>
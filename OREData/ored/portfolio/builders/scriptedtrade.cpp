@@ -367,7 +367,7 @@ ScriptedTradeEngineBuilder::engine(const std::string& id, const ScriptedTrade& s
         engine = QuantLib::ext::make_shared<ScriptedInstrumentPricingEngine>(
             script.npv(), script.results(), model_, ast_, context, script.code(), interactive_, amcCam_ != nullptr,
             std::set<std::string>(script.stickyCloseOutStates().begin(), script.stickyCloseOutStates().end()),
-            generateAdditionalResults, includePastCashflows_, staticNpvMem_);
+            generateAdditionalResults, includePastCashflows_, staticNpvMem_, compileScript_);
     } else if (modelCG_) {
         auto rt = globalParameters_.find("RunType");
         std::string runType = rt != globalParameters_.end() ? rt->second : "<<no run type set>>";
@@ -559,6 +559,7 @@ void ScriptedTradeEngineBuilder::populateModelParameters() {
     includePastCashflows_ =
         parseBool(engineParameter("IncludePastCashflows", getModelEngineQualifiers(), false, "false"));
     staticNpvMem_ = parseBool(engineParameter("StaticNpvMem", getModelEngineQualifiers(), false, "false"));
+    compileScript_ = parseBool(engineParameter("CompileScript", getModelEngineQualifiers(), false, "false"));
     params_.salvagingAlgorithm = parseSalvagingAlgorithmType(
         engineParameter("SalvagingAlgorithm", getModelEngineQualifiers(), false, "Spectral"));
     indicatorSmoothingForValues_ =
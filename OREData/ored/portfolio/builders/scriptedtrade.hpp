@@ -183,6 +183,7 @@ protected:
     std::string externalComputeDevice_;
     bool includePastCashflows_;
     bool staticNpvMem_;
+    bool compileScript_;
     Real indicatorSmoothingForValues_, indicatorSmoothingForDerivatives_;
 };
 
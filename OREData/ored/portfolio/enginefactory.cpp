@@ -186,6 +186,15 @@ EngineFactory::EngineFactory(const QuantLib::ext::shared_ptr<EngineData>& engine
     : market_(market), engineData_(engineData), configurations_(configurations), referenceData_(referenceData),
       extraEngineBuilders_(extraEngineBuilders), iborFallbackConfig_(iborFallbackConfig) {}
 
+QuantLib::ext::shared_ptr<EngineFactory> EngineFactory::clone(const QuantLib::ext::shared_ptr<Market>& market) const {
+    QL_REQUIRE(extraEngineBuilders_.empty(), "EngineFactory::clone(): extra engine builders can not be cloned");
+    auto f = QuantLib::ext::make_shared<EngineFactory>(engineData_, market ? market : market_, configurations_,
+                                                       referenceData_, iborFallbackConfig_);
+    f->setModelParameterOverrides(modelParameterOverrides_);
+    f->setEngineParameterOverrides(engineParameterOverrides_);
+    return f;
+}
+
 void EngineFactory::resetBuilders() {
     builders_.clear();
     legBuilders_.clear();
@@ -267,6 +267,17 @@ public:
     const QuantLib::ext::shared_ptr<ReferenceDataManager>& referenceData() const { return referenceData_; };
     //! Return the ibor fallback config
     const QuantLib::ext::shared_ptr<IborFallbackConfig>& iborFallbackConfig() const { return iborFallbackConfig_; }
+    //! Return the additional engine builders
+    const std::vector<QuantLib::ext::shared_ptr<EngineBuilder>>& extraEngineBuilders() const {
+        return extraEngineBuilders_;
+    }
+
+    /*! Return a factory with the same data, market, configurations and parameter overrides, but its own engine and
+        leg builders. Since the builders hold the state of the last init() call and their engine caches, a factory
+        must not be used on several threads at the same time, but its clones can. If a market is given, the clone
+        uses this market instead, e.g. a SynchronizedMarket wrapping the market of this factory. The clone has no
+        model builders. Requires that there are no extra engine builders, which can not be copied. */
+    QuantLib::ext::shared_ptr<EngineFactory> clone(const QuantLib::ext::shared_ptr<Market>& market = nullptr) const;
 
     //! Get a builder by trade type
     /*! This will look up configured model/engine for that trade type
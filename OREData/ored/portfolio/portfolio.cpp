@@ -16,6 +16,8 @@
  FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
 */
 
+#include <ored/marketdata/synchronizedmarket.hpp>
+#include <ored/marketdata/todaysmarket.hpp>
 #include <ored/portfolio/failedtrade.hpp>
 #include <ored/portfolio/fxforward.hpp>
 #include <ored/portfolio/portfolio.hpp>
@@ -24,13 +26,20 @@
 #include <ored/portfolio/swap.hpp>
 #include <ored/portfolio/swaption.hpp>
 #include <ored/utilities/log.hpp>
+#include <ored/utilities/workerthreadstate.hpp>
 #include <ored/utilities/xmlutils.hpp>
 
 #include <qle/utilities/localiborcouponsettings.hpp>
 
+#include <qle/utilities/workerpool.hpp>
+
 #include <ql/errors.hpp>
+#include <ql/indexes/indexmanager.hpp>
+#include <ql/settings.hpp>
 #include <ql/time/date.hpp>
 
+#include <memory>
+
 using namespace QuantLib;
 using namespace std;
 
@@ -50,42 +59,106 @@ void Portfolio::reset() {
         t->reset();
 }
 
+namespace {
+
+// returns a pool if the work should be done on several threads, otherwise null
+std::unique_ptr<QuantExt::WorkerPool> workerPool(const Size nThreads, const Size nTasks, const std::string& task) {
+    if (nThreads <= 1 || nTasks <= 1)
+        return nullptr;
+#if defined(QL_ENABLE_SESSIONS) && defined(QL_ENABLE_THREAD_SAFE_OBSERVER_PATTERN)
+    return std::make_unique<QuantExt::WorkerPool>(std::min(nThreads, nTasks));
+#else
+    WLOG("Portfolio: " << task << " on several threads requires QuantLib to be built with sessions and the thread safe "
+                                  "observer pattern, running serially.");
+    return nullptr;
+#endif
+}
+
+struct TradeNode {
+    XMLNode* node = nullptr;
+    std::string id, tradeType;
+    QuantLib::ext::shared_ptr<Trade> trade;
+};
+
+// parse the trade, a parsing error is logged and leaves the trade null
+void parseTrade(TradeNode& t) {
+    t.tradeType = XMLUtils::getChildValue(t.node, "TradeType", true);
+
+    // Get the id attribute
+    t.id = XMLUtils::getAttribute(t.node, "id");
+    QL_REQUIRE(t.id != "", "No id attribute in Trade Node");
+    DLOG("Parsing trade id:" << t.id);
+
+    try {
+        t.trade = TradeFactory::instance().build(t.tradeType);
+        t.trade->fromXML(t.node);
+        t.trade->id() = t.id;
+    } catch (std::exception& ex) {
+        t.trade = nullptr;
+        StructuredTradeErrorMessage(t.id, t.tradeType, "Error parsing Trade XML", ex.what()).log();
+    }
+}
+
+} // namespace
+
 void Portfolio::fromXML(XMLNode* node) {
     XMLUtils::checkNode(node, "Portfolio");
     vector<XMLNode*> nodes = XMLUtils::getChildrenNodes(node, "Trade");
-    for (Size i = 0; i < nodes.size(); i++) {
-        string tradeType = XMLUtils::getChildValue(nodes[i], "TradeType", true);
-
-        // Get the id attribute
-        string id = XMLUtils::getAttribute(nodes[i], "id");
-        QL_REQUIRE(id != "", "No id attribute in Trade Node");
-        DLOG("Parsing trade id:" << id);
-        
-        QuantLib::ext::shared_ptr<Trade> trade;
+    addTrades(nodes);
+    LOG("Finished Parsing XML doc");
+}
+
+void Portfolio::addTrades(const std::vector<XMLNode*>& nodes) {
+
+    // parse the trades, possibly on several threads
+
+    std::vector<TradeNode> tradeNodes(nodes.size());
+    for (Size i = 0; i < nodes.size(); ++i)
+        tradeNodes[i].node = nodes[i];
+
+    if (auto pool = workerPool(nThreads_, nodes.size(), "parsing trades")) {
+        LOG("Parsing " << nodes.size() << " trades on " << pool->size() << " threads");
+        auto threadState = WorkerThreadState::fromCurrentThread();
+        std::vector<char> threadInitialised(pool->size(), 0);
+        pool->parallelFor(nodes.size(), 1, [&](std::size_t begin, std::size_t end, std::size_t t) {
+            if (t > 0 && !threadInitialised[t]) {
+                threadState.apply();
+                threadInitialised[t] = true;
+            }
+            for (std::size_t i = begin; i < end; ++i)
+                parseTrade(tradeNodes[i]);
+        });
+    } else {
+        for (auto& t : tradeNodes)
+            parseTrade(t);
+    }
+
+    // add the trades in the order of the nodes
+
+    for (auto const& t : tradeNodes) {
         bool failedToLoad = true;
-        try {
-            trade = TradeFactory::instance().build(tradeType);
-            trade->fromXML(nodes[i]);
-            trade->id() = id;
-            add(trade);
-            DLOG("Added Trade " << id << " (" << trade->id() << ")"
-                                << " type:" << tradeType);
-            failedToLoad = false;
-        } catch (std::exception& ex) {
-            StructuredTradeErrorMessage(id, tradeType, "Error parsing Trade XML", ex.what()).log();
+        if (t.trade) {
+            try {
+                add(t.trade);
+                DLOG("Added Trade " << t.id << " (" << t.trade->id() << ")"
+                                    << " type:" << t.tradeType);
+                failedToLoad = false;
+            } catch (std::exception& ex) {
+                StructuredTradeErrorMessage(t.id, t.tradeType, "Error parsing Trade XML", ex.what()).log();
+            }
         }
 
         // If trade loading failed, then insert a dummy trade with same id, envelope and trade actions
         if (failedToLoad && buildFailedTrades_) {
             try {
-                trade = TradeFactory::instance().build("Failed");
+                auto trade = TradeFactory::instance().build("Failed");
                 // this loads only type, id, envelope and trade actions, but type will be set to the original trade's type
-                trade->fromXML(nodes[i]);
+                trade->fromXML(t.node);
                 // create a dummy trade of type "Dummy"
                 QuantLib::ext::shared_ptr<FailedTrade> failedTrade = QuantLib::ext::make_shared<FailedTrade>();
                 // copy id, envelope and trade actions
-                failedTrade->id() = id;
-                failedTrade->setUnderlyingTradeType(tradeType);
+                failedTrade->id() = t.id;
+                failedTrade->setUnderlyingTradeType(t.tradeType);
                 failedTrade->setEnvelope(trade->envelope());
                 failedTrade->tradeActions() = trade->tradeActions();
                 // and add it to the portfolio
@@ -93,11 +166,10 @@ void Portfolio::fromXML(XMLNode* node) {
                 WLOG("Added trade id " << failedTrade->id() << " type " << failedTrade->tradeType()
                                        << " for original trade type " << trade->tradeType());
             } catch (std::exception& ex) {
-                StructuredTradeErrorMessage(id, tradeType, "Error parsing type and envelope", ex.what()).log();
+                StructuredTradeErrorMessage(t.id, t.tradeType, "Error parsing type and envelope", ex.what()).log();
             }
         }
     }
-    LOG("Finished Parsing XML doc");
 }
 
 XMLNode* Portfolio::toXML(XMLDocument& doc) const {
@@ -132,30 +204,89 @@ void Portfolio::removeMatured(const Date& asof) {
 void Portfolio::build(const QuantLib::ext::shared_ptr<EngineFactory>& engineFactory, const std::string& context,
                       const bool emitStructuredError, const bool useAtParCoupons) {
     LOG("Building Portfolio of size " << trades_.size() << " for context = '" << context << "'");
-    auto trade = trades_.begin();
     Size initialSize = trades_.size();
     Size failedTrades = 0;
-    std::map<std::string, std::pair<std::size_t, boost::timer::nanosecond_type>> buildTimes;
-    while (trade != trades_.end()) {
-        std::string tradeType = trade->second->tradeType();
+
+    std::vector<std::map<std::string, QuantLib::ext::shared_ptr<Trade>>::iterator> entries;
+    std::vector<std::string> tradeTypes;
+    for (auto t = trades_.begin(); t != trades_.end(); ++t) {
+        entries.push_back(t);
+        tradeTypes.push_back(t->second->tradeType());
+    }
+
+    std::vector<std::pair<QuantLib::ext::shared_ptr<Trade>, bool>> results(entries.size());
+    std::vector<boost::timer::nanosecond_type> times(entries.size());
+    auto build = [this, &entries, &results, &times, &context, emitStructuredError,
+                  useAtParCoupons](const Size i, const QuantLib::ext::shared_ptr<EngineFactory>& factory) {
         boost::timer::cpu_timer timer;
-        auto [ft, success] = buildTrade((*trade).second, engineFactory, context, ignoreTradeBuildFail(),
-                                        buildFailedTrades(), emitStructuredError, useAtParCoupons);
-        if (success) {
-            ++trade;
-        } else if (ft) {
-            (*trade).second = ft;
-            ++failedTrades;
-            ++trade;
-        } else {
-            trade = trades_.erase(trade);
+        results[i] = buildTrade(entries[i]->second, factory, context, ignoreTradeBuildFail(), buildFailedTrades(),
+                                emitStructuredError, useAtParCoupons);
+        times[i] = timer.elapsed().wall;
+    };
+
+    /* A lazily built market would build the requested market objects on the worker threads, these would observe
+       the evaluation date and fixings of the worker thread and miss the updates from the calling thread. */
+    std::unique_ptr<QuantExt::WorkerPool> pool;
+    auto marketImpl = QuantLib::ext::dynamic_pointer_cast<MarketImpl>(engineFactory->market());
+    auto todaysMarket = QuantLib::ext::dynamic_pointer_cast<TodaysMarket>(engineFactory->market());
+    if (nThreads_ > 1 && !engineFactory->extraEngineBuilders().empty())
+        WLOG("Portfolio: the engine factory has extra engine builders, building trades serially.");
+    else if (nThreads_ > 1 && !marketImpl)
+        WLOG("Portfolio: the market of the engine factory is not a MarketImpl, building trades serially.");
+    else if (nThreads_ > 1 && todaysMarket && todaysMarket->lazyBuild())
+        WLOG("Portfolio: the market of the engine factory is built lazily, building trades serially.");
+    else
+        pool = workerPool(nThreads_, entries.size(), "building trades");
+
+    buildThreads_ = pool ? pool->size() : 1;
+    workerNotificationForwarders_.clear();
+    if (pool) {
+        LOG("Building " << entries.size() << " trades on " << pool->size() << " threads");
+        auto threadState = WorkerThreadState::fromCurrentThread();
+        // the market is shared between the threads, the requests to it are serialised and its lazy term structures
+        // are calculated here, the worker threads only read them
+        marketImpl->calculateTermStructures();
+        auto market = QuantLib::ext::make_shared<SynchronizedMarket>(engineFactory->market());
+        std::vector<QuantLib::ext::shared_ptr<EngineFactory>> factories(pool->size());
+        std::vector<std::vector<QuantLib::ext::shared_ptr<QuantLib::Observable>>> threadObservables(pool->size());
+        pool->parallelFor(entries.size(), 1, [&](std::size_t begin, std::size_t end, std::size_t t) {
+            if (!factories[t]) {
+                if (t > 0) {
+                    threadState.apply();
+                    threadObservables[t] = threadState.observables();
+                }
+                factories[t] = engineFactory->clone(market);
+            }
+            for (std::size_t i = begin; i < end; ++i)
+                build(i, factories[t]);
+        });
+        for (auto const& f : factories) {
+            if (f)
+                engineFactory->modelBuilders().insert(f->modelBuilders().begin(), f->modelBuilders().end());
+        }
+        // the trades built on the worker threads have to be notified of changes on the calling thread
+        workerNotificationForwarders_ = threadState.notificationForwarders(threadObservables);
+    } else {
+        for (Size i = 0; i < entries.size(); ++i)
+            build(i, engineFactory);
+    }
+
+    std::map<std::string, std::pair<std::size_t, boost::timer::nanosecond_type>> buildTimes;
+    for (Size i = 0; i < entries.size(); ++i) {
+        auto [ft, success] = results[i];
+        if (!success) {
+            if (ft) {
+                entries[i]->second = ft;
+                ++failedTrades;
+            } else {
+                trades_.erase(entries[i]);
+            }
         }
-        boost::timer::nanosecond_type t = timer.elapsed().wall;
-        if (auto f = buildTimes.find(tradeType); f != buildTimes.end()) {
+        if (auto f = buildTimes.find(tradeTypes[i]); f != buildTimes.end()) {
             f->second.first++;
-            f->second.second += t;
+            f->second.second += times[i];
         } else {
-            buildTimes[tradeType] = std::make_pair(1, t);
+            buildTimes[tradeTypes[i]] = std::make_pair(1, times[i]);
         }
     }
     LOG("Built Portfolio. Initial size = " << initialSize << ", size now " << trades_.size() << ", built "
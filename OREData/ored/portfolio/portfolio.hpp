@@ -27,6 +27,7 @@
 #include <ql/shared_ptr.hpp>
 #include <ored/portfolio/enginefactory.hpp>
 #include <ored/portfolio/tradefactory.hpp>
+#include <ql/patterns/observable.hpp>
 #include <ql/time/date.hpp>
 #include <ql/types.hpp>
 #include <vector>
@@ -73,6 +74,15 @@ public:
     void fromXML(XMLNode* node) override;
     XMLNode* toXML(XMLDocument& doc) const override;
 
+    /*! Set the number of threads used by fromXML() and build(). The parallel parsing and building requires QuantLib
+        to be built with sessions and the thread safe observer pattern, otherwise the trades are processed serially.
+        The default is 1. */
+    void setThreads(const QuantLib::Size nThreads) { nThreads_ = nThreads; }
+    //! Number of threads used to parse and build the trades
+    QuantLib::Size threads() const { return nThreads_; }
+    //! Number of threads that were used by the last call to build(), 1 for a serial build
+    QuantLib::Size buildThreads() const { return buildThreads_; }
+
     //! Remove specified trade from the portfolio
     bool remove(const std::string& tradeID);
 
@@ -82,7 +92,17 @@ public:
     //! set if trades should build as a FailedTrade if they fail
     void setBuildFailedTrades(const bool buildFailed) { buildFailedTrades_ = buildFailed; }
 
-    //! Call build on all trades in the portfolio, the context is included in error messages
+    /*! Call build on all trades in the portfolio, the context is included in error messages.
+
+        If more than one thread is set, see setThreads(), the trades are built concurrently. Each thread builds its
+        trades with its own copy of the engine factory, see EngineFactory::clone(), the model builders of the copies
+        are added to the given factory. The market of the factory is shared between the threads through a
+        SynchronizedMarket, i.e. one market request is processed at a time. Its lazy term structures are calculated on
+        the calling thread before the trades are built, see MarketImpl::calculateTermStructures(), so that they are not
+        calculated concurrently. QuantLib objects created on a worker thread register with the evaluation date and the
+        fixing notifiers of that thread, the portfolio forwards the notifications of the calling thread's evaluation
+        date and fixings to them. If the factory has extra engine builders or its market is not a MarketImpl or a
+        lazily built TodaysMarket, the trades are built serially. */
     void build(const QuantLib::ext::shared_ptr<EngineFactory>&, const std::string& context = "unspecified",
                const bool emitStructuredError = true, const bool useAtParCoupons = true);
 
@@ -135,9 +155,14 @@ public:
                       const QuantLib::ext::shared_ptr<ReferenceDataManager>& referenceDataManager = nullptr, const bool useCache = true);
 
 private:
+    void addTrades(const std::vector<XMLNode*>& nodes);
     bool buildFailedTrades_, ignoreTradeBuildFail_;
+    QuantLib::Size nThreads_ = 1;
+    QuantLib::Size buildThreads_ = 1;
     std::map<std::string, QuantLib::ext::shared_ptr<Trade>> trades_;
     std::map<AssetClass, std::set<std::string>> underlyingIndicesCache_;
+    // forward notifications from the calling thread's singletons to the ones of the worker threads of a parallel build
+    std::vector<QuantLib::ext::shared_ptr<QuantLib::Observer>> workerNotificationForwarders_;
 };
 
 std::pair<QuantLib::ext::shared_ptr<Trade>, bool>
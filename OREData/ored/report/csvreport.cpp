@@ -35,84 +35,96 @@ using std::string;
 namespace ore {
 namespace data {
 
-// Local class for printing each report type via fprintf
-class ReportTypePrinter : public boost::static_visitor<> {
-public:
-    ReportTypePrinter(FILE* fp, int prec, bool scientific, char quoteChar = '\0', char sep = ',',
-                      const string& nullString = "#N/A")
-        : fp_(fp), rounding_(prec, QuantLib::Rounding::Closest), scientific_(scientific), quoteChar_(quoteChar),
-          sep_(sep), null_(nullString) {}
-
-    void operator()(const Size i) const {
-        if (i == QuantLib::Null<Size>()) {
-            fprintNull();
-        } else {
-            fprintf(fp_, "%zu", i);
-        }
+namespace {
+// Appends the printf style formatted arguments to buffer
+template <class... Args> void appendFormatted(string& buffer, const char* format, const Args... args) {
+    char tmp[64];
+    int n = std::snprintf(tmp, sizeof(tmp), format, args...);
+    QL_REQUIRE(n >= 0, "ReportTypePrinter: formatting with '" << format << "' failed");
+    if (static_cast<std::size_t>(n) < sizeof(tmp)) {
+        buffer.append(tmp, n);
+    } else {
+        std::size_t pos = buffer.size();
+        buffer.resize(pos + n + 1);
+        std::snprintf(&buffer[pos], n + 1, format, args...);
+        buffer.resize(pos + n);
     }
-    void operator()(const Real d) const {
-        if (d == QuantLib::Null<Real>() || !std::isfinite(d)) {
-            fprintNull();
-        } else {
-            if(scientific_) {
-                fprintf(fp_, "%.*e", rounding_.precision(), d);
-            } else {
-                Real r = rounding_(d);
-                fprintf(fp_, "%.*f", rounding_.precision(), QuantLib::close_enough(r, 0.0) ? 0.0 : r);
-            }
-        }
+}
+} // namespace
+
+ReportTypePrinter::ReportTypePrinter(int prec, bool scientific, char quoteChar, char sep, const string& nullString)
+    : rounding_(prec, QuantLib::Rounding::Closest), scientific_(scientific), quoteChar_(quoteChar), sep_(sep),
+      null_(nullString) {}
+
+void ReportTypePrinter::operator()(const Size i) const {
+    buffer_.clear();
+    if (i == QuantLib::Null<Size>()) {
+        printNull();
+    } else {
+        appendFormatted(buffer_, "%zu", i);
     }
-    void operator()(const string& s) const { fprintString(s); }
-    void operator()(const Date& d) const {
-        if (d == QuantLib::Null<Date>()) {
-            fprintNull();
+}
+
+void ReportTypePrinter::operator()(const Real d) const {
+    buffer_.clear();
+    if (d == QuantLib::Null<Real>() || !std::isfinite(d)) {
+        printNull();
+    } else {
+        if (scientific_) {
+            appendFormatted(buffer_, "%.*e", rounding_.precision(), d);
         } else {
-            string s = to_string(d);
-            fprintString(s);
+            Real r = rounding_(d);
+            appendFormatted(buffer_, "%.*f", rounding_.precision(), QuantLib::close_enough(r, 0.0) ? 0.0 : r);
         }
     }
-    void operator()(const Period& p) const {
-        string s = to_string(p);
-        fprintString(s);
-    }
+}
 
-    void updateFile(FILE* fp) { fp_ = fp; }
+void ReportTypePrinter::operator()(const string& s) const {
+    buffer_.clear();
+    printString(s);
+}
 
-private:
-    void fprintNull() const { fprintf(fp_, "%s", null_.c_str()); }
+void ReportTypePrinter::operator()(const Date& d) const {
+    buffer_.clear();
+    if (d == QuantLib::Null<Date>()) {
+        printNull();
+    } else {
+        string s = to_string(d);
+        printString(s);
+    }
+}
 
-    // Shared implementation to include the quote character.
-    void fprintString(const string& s) const {
-        bool quoted = s.size() > 1 && s[0] == quoteChar_ && s[s.size() - 1] == quoteChar_;
-        string sc = quoted ? s.substr(1, s.size() - 2) : s;
+void ReportTypePrinter::operator()(const Period& p) const {
+    buffer_.clear();
+    string s = to_string(p);
+    printString(s);
+}
 
-        bool containsSep = sc.find(sep_) != std::string::npos;
-        
-        boost::replace_all(sc, "\n", "\\n");
-        boost::replace_all(sc, "\t", "\\t");
+void ReportTypePrinter::printNull() const { buffer_.append(null_.c_str()); }
 
-        // If quote character is \0, use double quotes instead
-        char effectiveQuoteChar = (quoteChar_ == '\0' && containsSep) ? '"' : quoteChar_;
+void ReportTypePrinter::printString(const string& s) const {
+    bool quoted = s.size() > 1 && s[0] == quoteChar_ && s[s.size() - 1] == quoteChar_;
+    string sc = quoted ? s.substr(1, s.size() - 2) : s;
 
-        if (effectiveQuoteChar != '\0') {
-            if (effectiveQuoteChar == '"')
-                boost::replace_all(sc, "\"", "\"\"");            
-            fputc(effectiveQuoteChar, fp_);
-        }
+    bool containsSep = sc.find(sep_) != std::string::npos;
+
+    boost::replace_all(sc, "\n", "\\n");
+    boost::replace_all(sc, "\t", "\\t");
 
-        fprintf(fp_, "%s", sc.c_str());
+    // If quote character is \0, use double quotes instead
+    char effectiveQuoteChar = (quoteChar_ == '\0' && containsSep) ? '"' : quoteChar_;
 
-        if (effectiveQuoteChar != '\0')
-            fputc(effectiveQuoteChar, fp_);
+    if (effectiveQuoteChar != '\0') {
+        if (effectiveQuoteChar == '"')
+            boost::replace_all(sc, "\"", "\"\"");
+        buffer_.push_back(effectiveQuoteChar);
     }
 
-    FILE* fp_;
-    QuantLib::Rounding rounding_;
-    bool scientific_;
-    char quoteChar_;
-    char sep_;
-    string null_;
-};
+    buffer_.append(sc.c_str());
+
+    if (effectiveQuoteChar != '\0')
+        buffer_.push_back(effectiveQuoteChar);
+}
 
 CSVFileReport::CSVFileReport(const string& filename, const char sep, const bool commentCharacter, char quoteChar,
                              const string& nullString, bool lowerHeader, QuantLib::Size rolloverSize)
@@ -133,8 +145,6 @@ void CSVFileReport::open() {
     LOG("Opening CSV file report '" << filename_ << "'");
     fp_ = FileIO::fopen(filename_.c_str(), "w");
     QL_REQUIRE(fp_, "Error opening file '" << filename_ << "'");
-    for (auto& p : printers_)
-        p.updateFile(fp_);
     finalized_ = false;
 }
 
@@ -160,7 +170,7 @@ Report& CSVFileReport::addColumn(const string& name, const ReportType& rt, Size
     checkIsOpen("addColumn(" + name + ")");
     columnTypes_.push_back(rt);
     headers_.push_back(name);
-    printers_.push_back(ReportTypePrinter(fp_, precision, scientific, quoteChar_, sep_, nullString_));
+    printers_.push_back(ReportTypePrinter(precision, scientific, quoteChar_, sep_, nullString_));
     if (i_ == 0 && commentCharacter_)
         fprintf(fp_, "#");
     if (i_ > 0)
@@ -207,10 +217,20 @@ Report& CSVFileReport::add(const ReportType& rt) {
     if (i_ != 0)
         fprintf(fp_, "%c", sep_);
     boost::apply_visitor(printers_[i_], rt);
+    const string& s = printers_[i_].formatted();
+    fwrite(s.data(), 1, s.size(), fp_);
     i_++;
     return *this;
 }
 
+void CSVFileReport::addFormattedRows(const string& rows) {
+    checkIsOpen("addFormattedRows()");
+    QL_REQUIRE(i_ == columnTypes_.size(), "Cannot add formatted rows, only "
+                                              << i_
+                                              << " entries filled, report headers are: " << boost::join(headers_, ","));
+    fwrite(rows.data(), 1, rows.size(), fp_);
+}
+
 void CSVFileReport::end() {
     checkIsOpen("end()");
 
@@ -24,13 +24,44 @@
 #pragma once
 
 #include <ored/report/report.hpp>
+#include <ql/math/rounding.hpp>
+#include <boost/variant/static_visitor.hpp>
 #include <stdio.h>
 #include <vector>
 
 namespace ore {
 namespace data {
 
-class ReportTypePrinter;
+/*! Formats report values as they are written to a csv file, the result of the last call is returned by formatted()
+
+\ingroup report
+*/
+class ReportTypePrinter : public boost::static_visitor<> {
+public:
+    ReportTypePrinter(int prec, bool scientific, char quoteChar = '\0', char sep = ',',
+                      const string& nullString = "#N/A");
+
+    void operator()(const Size i) const;
+    void operator()(const Real d) const;
+    void operator()(const string& s) const;
+    void operator()(const Date& d) const;
+    void operator()(const Period& p) const;
+
+    const string& formatted() const { return buffer_; }
+
+private:
+    void printNull() const;
+    // Shared implementation to include the quote character.
+    void printString(const string& s) const;
+
+    QuantLib::Rounding rounding_;
+    bool scientific_;
+    char quoteChar_;
+    char sep_;
+    string null_;
+    mutable string buffer_;
+};
+
 /*! CSV Report class
 
 \ingroup report
@@ -60,6 +91,11 @@ public:
     void end() override;
     void flush() override;
 
+    /*! Writes rows that were formatted with ReportTypePrinter. Each row must start with a newline and contain all
+        columns separated by the separator character, i.e. the output is the same as for calls to next() and add().
+        The file is not rolled over while writing the rows. */
+    void addFormattedRows(const string& rows);
+
 private:
     void checkIsOpen(const std::string& op) const;
 
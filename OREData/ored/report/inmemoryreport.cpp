@@ -19,11 +19,11 @@
 #include <ored/report/inmemoryreport.hpp>
 #include <qle/utilities/serializationdate.hpp>
 #include <qle/utilities/serializationperiod.hpp>
+#include <qle/utilities/workerpool.hpp>
 
 #include <boost/algorithm/string/join.hpp>
 #include <boost/serialization/serialization.hpp>
 #include <boost/serialization/vector.hpp>
-#include <boost/serialization/variant.hpp>
 #include <boost/archive/binary_oarchive.hpp>
 #include <boost/archive/binary_iarchive.hpp>
 #include <boost/filesystem.hpp>
@@ -35,10 +35,112 @@
 #include <boost/iostreams/filtering_stream.hpp>
 
 #include <fstream>
+#include <limits>
+#include <memory>
 
 namespace ore {
 namespace data {
 
+namespace {
+// number of rows formatted by one task in toFile()
+constexpr Size toFileBlockSize = 10000;
+// reports with fewer rows are written by the calling thread only
+constexpr Size toFileParallelRows = 100000;
+} // namespace
+
+void InMemoryReport::Column::clear() {
+    sizes.clear();
+    reals.clear();
+    strings.clear();
+    dates.clear();
+    periods.clear();
+}
+
+InMemoryReport::InMemoryReport(const InMemoryReport& other) : i_(0), bufferSize_(0), cacheIndex_(0) {
+    *this = other;
+}
+
+InMemoryReport& InMemoryReport::operator=(const InMemoryReport& other) {
+    if (this == &other)
+        return *this;
+
+    for (const auto& f : files_)
+        std::remove(f.c_str());
+
+    i_ = other.i_;
+    bufferSize_ = other.bufferSize_;
+    nThreads_ = other.nThreads_;
+    headers_ = other.headers_;
+    columnTypes_ = other.columnTypes_;
+    columnPrecision_ = other.columnPrecision_;
+    columnScientific_ = other.columnScientific_;
+    data_ = other.data_;
+    headersMap_ = other.headersMap_;
+    strings_ = other.strings_;
+    cache_ = other.cache_;
+    cacheIndex_ = other.cacheIndex_;
+
+    // the buffer files are removed by the destructor, so each report needs its own copies
+    files_.clear();
+    for (const auto& f : other.files_) {
+        boost::filesystem::path p = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+        boost::filesystem::copy_file(f, p);
+        files_.push_back(p.string());
+    }
+
+    // the keys of the index must refer to the strings of this report, not to the ones of other
+    stringIndex_.clear();
+    stringIndex_.reserve(strings_.size());
+    for (Size k = 0; k < strings_.size(); ++k)
+        stringIndex_.emplace(strings_[k], static_cast<std::uint32_t>(k));
+
+    return *this;
+}
+
+InMemoryReport::InMemoryReport(InMemoryReport&& other) noexcept : i_(0), bufferSize_(0), cacheIndex_(0) {
+    *this = std::move(other);
+}
+
+InMemoryReport& InMemoryReport::operator=(InMemoryReport&& other) noexcept {
+    if (this == &other)
+        return *this;
+
+    for (const auto& f : files_)
+        std::remove(f.c_str());
+
+    i_ = other.i_;
+    bufferSize_ = other.bufferSize_;
+    nThreads_ = other.nThreads_;
+    headers_ = std::move(other.headers_);
+    columnTypes_ = std::move(other.columnTypes_);
+    columnPrecision_ = std::move(other.columnPrecision_);
+    columnScientific_ = std::move(other.columnScientific_);
+    data_ = std::move(other.data_);
+    files_ = std::move(other.files_);
+    headersMap_ = std::move(other.headersMap_);
+    // the deque hands over its elements, so the keys of the index still refer to the strings of this report
+    strings_ = std::move(other.strings_);
+    stringIndex_ = std::move(other.stringIndex_);
+    cache_ = std::move(other.cache_);
+    cacheIndex_ = other.cacheIndex_;
+
+    // leave other as an empty report, in particular its destructor must not remove the buffer files
+    other.i_ = 0;
+    other.cacheIndex_ = 0;
+    other.headers_.clear();
+    other.columnTypes_.clear();
+    other.columnPrecision_.clear();
+    other.columnScientific_.clear();
+    other.data_.clear();
+    other.files_.clear();
+    other.headersMap_.clear();
+    other.stringIndex_.clear();
+    other.strings_.clear();
+    other.cache_.clear();
+
+    return *this;
+}
+
 InMemoryReport::~InMemoryReport() {
     for (const auto &f : files_)
         std::remove(f.c_str());
@@ -49,7 +151,7 @@ Report& InMemoryReport::addColumn(const string& name, const ReportType& rt, Size
     columnTypes_.push_back(rt);
     columnPrecision_.push_back(precision);
     columnScientific_.push_back(scientific);
-    data_.push_back(vector<ReportType>()); // Initialise vector for column
+    data_.push_back(Column()); // Initialise column
     headersMap_[name] = i_;
     i_++;
     return *this;
@@ -82,6 +184,17 @@ Report& InMemoryReport::next() {
     return *this;
 }
 
+std::uint32_t InMemoryReport::stringIndex(const string& s) {
+    if (auto it = stringIndex_.find(s); it != stringIndex_.end())
+        return it->second;
+    QL_REQUIRE(strings_.size() < std::numeric_limits<std::uint32_t>::max(),
+               "InMemoryReport: too many distinct strings, report headers are: " << boost::join(headers_, ","));
+    std::uint32_t index = static_cast<std::uint32_t>(strings_.size());
+    strings_.push_back(s);
+    stringIndex_.emplace(strings_.back(), index);
+    return index;
+}
+
 Report& InMemoryReport::add(const ReportType& rt) {
     // check type is valid
     QL_REQUIRE(i_ < headers_.size(), "No column to add [" << rt << "] to.");
@@ -90,7 +203,26 @@ Report& InMemoryReport::add(const ReportType& rt) {
                                                            << headers_[i_] << " of type " << columnTypes_[i_].which()
                                                            << ", report headers are: " << boost::join(headers_, ","));
 
-    data_[i_].push_back(rt);
+    Column& column = data_[i_];
+    switch (rt.which()) {
+    case 0:
+        column.sizes.push_back(boost::get<Size>(rt));
+        break;
+    case 1:
+        column.reals.push_back(boost::get<Real>(rt));
+        break;
+    case 2:
+        column.strings.push_back(stringIndex(boost::get<string>(rt)));
+        break;
+    case 3:
+        column.dates.push_back(boost::get<Date>(rt));
+        break;
+    case 4:
+        column.periods.push_back(boost::get<Period>(rt));
+        break;
+    default:
+        QL_FAIL("InMemoryReport::add(): unexpected report type " << rt.which());
+    }
     i_++;
     return *this;
 }
@@ -126,7 +258,7 @@ void InMemoryReport::end() {
                                                      << ", report headers are: " << boost::join(headers_, ","));
 }
 
-const vector<vector<Report::ReportType>>& InMemoryReport::cache(Size cacheIndex) const {
+const vector<InMemoryReport::Column>& InMemoryReport::cache(Size cacheIndex) const {
     if (cache_.empty() || cacheIndex_ != cacheIndex) {
         auto numColumns = columns();
         cache_.clear();
@@ -141,15 +273,28 @@ const vector<vector<Report::ReportType>>& InMemoryReport::cache(Size cacheIndex)
     return cache_;
 }
 
-const Report::ReportType& InMemoryReport::dataImpl(const vector<vector<ReportType>>& data, Size i, Size j, Size expectedSize) const {
+Report::ReportType InMemoryReport::dataImpl(const vector<Column>& data, Size i, Size j, Size expectedSize) const {
     QL_REQUIRE(data[i].size() == expectedSize, "internal error: report column "
         << i << " (" << header(i) << ") contains " << data[i].size()
         << " rows, expected are " << expectedSize
         << " rows, report headers are: " << boost::join(headers_, ","));
-    return data[i][j];
+    switch (columnTypes_[i].which()) {
+    case 0:
+        return data[i].sizes[j];
+    case 1:
+        return data[i].reals[j];
+    case 2:
+        return strings_[data[i].strings[j]];
+    case 3:
+        return data[i].dates[j];
+    case 4:
+        return data[i].periods[j];
+    default:
+        QL_FAIL("InMemoryReport::data(): unexpected report type " << columnTypes_[i].which());
+    }
 }
 
-const Report::ReportType& InMemoryReport::data(Size i, Size j) const {
+Report::ReportType InMemoryReport::data(Size i, Size j) const {
     if (files_.empty()) {
         // Buffering is not active - retrieve the requested data from the data_ container
         return dataImpl(data_, i, j, rows());
@@ -159,7 +304,7 @@ const Report::ReportType& InMemoryReport::data(Size i, Size j) const {
         if (j < bufferRowCount) {
             // The requested data is in the buffer - retrieve it and return it
             auto dv = std::div(int(j), int(bufferSize_));
-            const vector<vector<ReportType>>& data = cache(dv.quot);
+            const vector<Column>& data = cache(dv.quot);
             return dataImpl(data, i, dv.rem, bufferSize_);
         } else {
             // The requested data is not in the buffer, it's in the data_ container so use that
@@ -173,36 +318,91 @@ void InMemoryReport::toFile(const string& filename, const char sep, const bool c
 
     CSVFileReport cReport(filename, sep, commentCharacter, quoteChar, nullString, lowerHeader);
 
+    vector<ReportTypePrinter> printers;
     for (Size i = 0; i < headers_.size(); i++) {
         cReport.addColumn(headers_[i], columnTypes_[i], columnPrecision_[i], columnScientific_[i]);
+        printers.push_back(ReportTypePrinter(columnPrecision_[i], columnScientific_[i], quoteChar, sep, nullString));
     }
 
     auto numColumns = columns();
     if (numColumns > 0) {
 
-        for (Size cacheIndex = 0; cacheIndex < files_.size(); cacheIndex++) {
-            const vector<vector<ReportType>>& data = cache(cacheIndex);
-            for (Size i = 0; i < data[0].size(); i++) {
-                cReport.next();
-                for (Size j = 0; j < numColumns; j++) {
-                    cReport.add(data[j][i]);
-                }
-            }
-        }
+        std::unique_ptr<QuantExt::WorkerPool> pool;
+        if (nThreads_ != 1 && rows() >= toFileParallelRows)
+            pool = std::make_unique<QuantExt::WorkerPool>(nThreads_);
 
-        auto numRows = data_[0].size();
+        for (Size cacheIndex = 0; cacheIndex < files_.size(); cacheIndex++)
+            writeRows(cReport, printers, cache(cacheIndex), sep, pool.get());
 
-        for (Size i = 0; i < numRows; i++) {
-            cReport.next();
-            for (Size j = 0; j < numColumns; j++) {
-                cReport.add(data_[j][i]);
-            }
-        }
+        writeRows(cReport, printers, data_, sep, pool.get());
     }
 
     cReport.end();
 }
 
+void InMemoryReport::writeRows(CSVFileReport& report, const vector<ReportTypePrinter>& printers,
+                               const vector<Column>& data, const char sep, QuantExt::WorkerPool* pool) const {
+
+    // the rows are formatted in blocks, a wave of blocks is formatted in parallel and then written in order
+
+    Size numRows = data[0].size();
+    Size numBlocks = (numRows + toFileBlockSize - 1) / toFileBlockSize;
+    Size nThreads = pool ? pool->size() : 1;
+    vector<vector<ReportTypePrinter>> threadPrinters(nThreads, printers);
+    vector<string> blocks(std::min(numBlocks, 4 * nThreads));
+
+    auto format = [this, &data, &threadPrinters, &blocks, numRows, sep](const Size firstBlock, const Size begin,
+                                                                        const Size end, const Size threadIndex) {
+        auto& p = threadPrinters[threadIndex];
+        for (Size b = begin; b < end; ++b) {
+            string& out = blocks[b];
+            out.clear();
+            Size firstRow = (firstBlock + b) * toFileBlockSize;
+            Size lastRow = std::min(firstRow + toFileBlockSize, numRows);
+            for (Size row = firstRow; row < lastRow; ++row) {
+                out.push_back('\n');
+                for (Size col = 0; col < data.size(); ++col) {
+                    if (col > 0)
+                        out.push_back(sep);
+                    switch (columnTypes_[col].which()) {
+                    case 0:
+                        p[col](data[col].sizes[row]);
+                        break;
+                    case 1:
+                        p[col](data[col].reals[row]);
+                        break;
+                    case 2:
+                        p[col](strings_[data[col].strings[row]]);
+                        break;
+                    case 3:
+                        p[col](data[col].dates[row]);
+                        break;
+                    case 4:
+                        p[col](data[col].periods[row]);
+                        break;
+                    default:
+                        QL_FAIL("InMemoryReport::toFile(): unexpected report type " << columnTypes_[col].which());
+                    }
+                    out.append(p[col].formatted());
+                }
+            }
+        }
+    };
+
+    for (Size firstBlock = 0; firstBlock < numBlocks; firstBlock += blocks.size()) {
+        Size n = std::min(blocks.size(), numBlocks - firstBlock);
+        if (pool)
+            pool->parallelFor(n, 1, [&format, firstBlock](std::size_t begin, std::size_t end,
+                                                          std::size_t threadIndex) {
+                format(firstBlock, begin, end, threadIndex);
+            });
+        else
+            format(firstBlock, 0, n, 0);
+        for (Size b = 0; b < n; ++b)
+            report.addFormattedRows(blocks[b]);
+    }
+}
+
 bool use_compression(const std::string& filename) {
 #ifdef ORE_USE_ZLIB
     // assume compression for all filenames that do not end with csv or txt
@@ -248,7 +448,7 @@ void InMemoryReport::toZip(const string& filename, const char sep, const bool co
                     if (col > 0)
                         out << sep;
 
-                    const ReportType& val = data[col][row];
+                    ReportType val = dataImpl(data, col, row, numRows);
                     if (val.empty())
                         out << nullString;
                     else
@@ -264,7 +464,7 @@ void InMemoryReport::toZip(const string& filename, const char sep, const bool co
                 if (col > 0)
                     out << sep;
 
-                const ReportType& val = data_[col][row];
+                ReportType val = dataImpl(data_, col, row, numRows);
                 if (val.empty())
                     out << nullString;
                 else
@@ -26,10 +26,18 @@
 #include <ored/report/csvreport.hpp>
 #include <ored/report/report.hpp>
 #include <ql/errors.hpp>
+#include <cstdint>
+#include <deque>
+#include <string_view>
 #include <tuple>
+#include <unordered_map>
 #include <vector>
 #include <map>
 
+namespace QuantExt {
+class WorkerPool;
+}
+
 namespace ore {
 namespace data {
 using std::string;
@@ -37,11 +45,24 @@ using std::vector;
 
 /*! InMemoryReport just stores report information in local vectors and provides an interface to access
  *  the values. It could be used as a backend to a GUI
+ *
+ *  The values are stored column by column in vectors of the column's type. Strings are dictionary encoded, i.e.
+ *  each distinct string (trade id, currency, risk factor, ...) is stored once per report and the columns hold indices
+ *  into the dictionary. If a buffer size is given, the rows are flushed to temporary files in chunks of this size,
+ *  the dictionary is kept in memory.
+ *
+ *  toFile() formats large reports on several threads, see setThreads().
  \ingroup report
  */
 class InMemoryReport : public Report {
 public:
     explicit InMemoryReport(Size bufferSize=0) : i_(0), bufferSize_(bufferSize), cacheIndex_(0) {}
+    //! The copy gets its own string dictionary index and its own copies of the buffer files
+    InMemoryReport(const InMemoryReport& other);
+    InMemoryReport& operator=(const InMemoryReport& other);
+    //! The moved-from report is left empty, the string index stays valid since moving the deque keeps the strings
+    InMemoryReport(InMemoryReport&& other) noexcept;
+    InMemoryReport& operator=(InMemoryReport&& other) noexcept;
     ~InMemoryReport() override;
 
     Report& addColumn(const string& name, const ReportType& rt, Size precision = 0, bool scientific = false) override;
@@ -57,8 +78,12 @@ public:
     bool hasHeader(string h) const { return std::find(headers_.begin(), headers_.end(), h) != headers_.end(); }
     ReportType columnType(Size i) const { return columnTypes_[i]; }
     Size columnPrecision(Size i) const { return columnPrecision_[i]; }
-    //! Returns the data
-    const ReportType& data(Size i, Size j) const;
+    //! Returns the data for column i and row j
+    ReportType data(Size i, Size j) const;
+    //! Number of distinct strings stored in the report
+    Size distinctStrings() const { return strings_.size(); }
+    //! Number of threads used by toFile() for large reports, 0 means hardware concurrency (default)
+    void setThreads(Size nThreads) { nThreads_ = nThreads; }
     void toFile(const string& filename, const char sep = ',', const bool commentCharacter = true, char quoteChar = '\0',
                 const string& nullString = "#N/A", bool lowerHeader = false);
     void toZip(const string& filename, const char sep = ',', const bool commentCharacter = true, char quoteChar = '\0',
@@ -72,19 +97,44 @@ public:
         return it->second;
     }  
 private:
+    // values of one column, only the vector for the column's type is used, strings are indices into strings_
+    struct Column {
+        vector<Size> sizes;
+        vector<Real> reals;
+        vector<std::uint32_t> strings;
+        vector<Date> dates;
+        vector<Period> periods;
+        Size size() const { return sizes.size() + reals.size() + strings.size() + dates.size() + periods.size(); }
+        void clear();
+        template <class Archive> void serialize(Archive& ar, const unsigned int) {
+            ar& sizes;
+            ar& reals;
+            ar& strings;
+            ar& dates;
+            ar& periods;
+        }
+    };
+
     Size i_;
     Size bufferSize_;
+    Size nThreads_ = 0;
     vector<string> headers_;
     vector<ReportType> columnTypes_;
     vector<Size> columnPrecision_;
     vector<bool> columnScientific_;
-    vector<vector<ReportType>> data_;
+    vector<Column> data_;
     vector<string> files_;
     std::map<std::string, size_t> headersMap_;
-    mutable vector<vector<ReportType>> cache_;
+    // string dictionary, the deque keeps the strings in place, so that the index can refer to them
+    std::deque<string> strings_;
+    std::unordered_map<std::string_view, std::uint32_t> stringIndex_;
+    mutable vector<Column> cache_;
     mutable Size cacheIndex_;
-    const vector<vector<ReportType>>& cache(Size cacheIndex) const;
-    const Report::ReportType& dataImpl(const vector<vector<ReportType>>& data, Size i, Size j, Size expectedSize) const;
+    std::uint32_t stringIndex(const string& s);
+    const vector<Column>& cache(Size cacheIndex) const;
+    ReportType dataImpl(const vector<Column>& data, Size i, Size j, Size expectedSize) const;
+    void writeRows(CSVFileReport& report, const vector<ReportTypePrinter>& printers, const vector<Column>& data,
+                   const char sep, QuantExt::WorkerPool* pool) const;
 };
 
 //! InMemoryReport with access to plain types instead of boost::variant<>, to facilitate language bindings
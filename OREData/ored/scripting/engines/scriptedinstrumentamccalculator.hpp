@@ -40,9 +40,10 @@ public:
     ScriptedInstrumentAmcCalculator(const std::string& npv, const QuantLib::ext::shared_ptr<Model>& model, const ASTNodePtr ast,
                                     const QuantLib::ext::shared_ptr<Context>& context, const std::string& script = "",
                                     const bool interactive = false,
-                                    const std::set<std::string>& stickyCloseOutStates = {})
+                                    const std::set<std::string>& stickyCloseOutStates = {},
+                                    const bool compileScript = false)
         : npv_(npv), model_(model), ast_(ast), context_(context), script_(script), interactive_(interactive),
-          stickyCloseOutStates_(stickyCloseOutStates) {}
+          stickyCloseOutStates_(stickyCloseOutStates), compileScript_(compileScript) {}
 
     QuantLib::Currency npvCurrency() override;
 
@@ -59,6 +60,7 @@ private:
     const std::string script_;
     const bool interactive_;
     const std::set<std::string> stickyCloseOutStates_;
+    const bool compileScript_;
     //
     std::map<std::string, ValueType> stickyCloseOutRunScalars_;
     std::map<std::string, std::vector<ValueType>> stickyCloseOutRunArrays_;
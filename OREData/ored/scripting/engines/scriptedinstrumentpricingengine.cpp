@@ -101,13 +101,13 @@ void ScriptedInstrumentPricingEngine::calculate() const {
             ~TrainingPathToggle() { model->toggleTrainingPaths(); }
             QuantLib::ext::shared_ptr<Model> model;
         } toggle(model_);
-        ScriptEngine trainingEngine(ast_, trainingContext, model_);
+        ScriptEngine trainingEngine(ast_, trainingContext, model_, compileScript_);
         trainingEngine.run(script_, interactive_);
     }
 
     // set up script engine and run it
 
-    ScriptEngine engine(ast_, workingContext, model_);
+    ScriptEngine engine(ast_, workingContext, model_, compileScript_);
 
     QuantLib::ext::shared_ptr<PayLog> paylog;
     if (generateAdditionalResults_)
@@ -235,7 +235,7 @@ void ScriptedInstrumentPricingEngine::calculate() const {
         DLOG("add amc calculator to results");
         results_.additionalResults["amcCalculator"] =
             QuantLib::ext::static_pointer_cast<AmcCalculator>(QuantLib::ext::make_shared<ScriptedInstrumentAmcCalculator>(
-                npv_, model_, ast_, context_, script_, interactive_, amcStickyCloseOutStates_));
+                npv_, model_, ast_, context_, script_, interactive_, amcStickyCloseOutStates_, compileScript_));
     }
 
     lastCalculationWasValid_ = true;
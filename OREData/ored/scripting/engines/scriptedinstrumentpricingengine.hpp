@@ -42,11 +42,11 @@ public:
                                     const std::set<std::string>& amcStickyCloseOutStates = {},
                                     const bool generateAdditionalResults = false,
                                     const bool includePastCashflows = false,
-                                    const bool staticNpvMem = false)
+                                    const bool staticNpvMem = false, const bool compileScript = false)
         : npv_(npv), additionalResults_(additionalResults), model_(model), ast_(ast), context_(context),
           script_(script), interactive_(interactive), amcEnabled_(amcEnabled),
           amcStickyCloseOutStates_(amcStickyCloseOutStates), generateAdditionalResults_(generateAdditionalResults),
-          includePastCashflows_(includePastCashflows), staticNpvMem_(staticNpvMem) {
+          includePastCashflows_(includePastCashflows), staticNpvMem_(staticNpvMem), compileScript_(compileScript) {
         registerWith(model_);
     }
 
@@ -71,6 +71,7 @@ private:
     const bool generateAdditionalResults_;
     const bool includePastCashflows_;
     const bool staticNpvMem_;
+    const bool compileScript_;
 };
 
 } // namespace data
@@ -1164,14 +1164,382 @@ public:
     SafeStack<ValueType> value;
 };
 
+// executes a compiled program, sharing the filter and value stacks with the interpreter the program delegates to
+
+class ProgramRunner {
+public:
+    using Op = ScriptProgram::Op;
+
+    ProgramRunner(const ScriptProgram& program, ASTRunner& runner, const Size size, Context& context,
+                  ASTNode*& lastVisitedNode)
+        : program_(program), runner_(runner), size_(size), context_(context), lastVisitedNode_(lastVisitedNode),
+          temps_(program.registers), refs_(program.registers, nullptr), scalars_(program.variables.size(), nullptr),
+          arrays_(program.variables.size(), nullptr), ignored_(program.variables.size(), false),
+          constant_(program.variables.size(), false), loops_(program.loops) {
+        for (auto const& c : program.constants)
+            constants_.push_back(RandomVariable(size_, c));
+        for (Size v = 0; v < program.variables.size(); ++v) {
+            ignored_[v] = context_.ignoreAssignments.find(program.variables[v]) != context_.ignoreAssignments.end();
+            constant_[v] = context_.constants.find(program.variables[v]) != context_.constants.end();
+        }
+    }
+
+    void run() {
+        const auto& instructions = program_.instructions;
+        Size pc = 0;
+        while (pc < instructions.size()) {
+            const auto& i = instructions[pc++];
+            // the subscript checks refer to the last node of the subscript evaluation as in the interpreter
+            ASTNode* previousNode = lastVisitedNode_;
+            lastVisitedNode_ = i.node;
+            switch (i.op) {
+            case Op::LoadConst:
+                refs_[i.a] = &constants_[i.index];
+                break;
+            case Op::LoadVar:
+                refs_[i.a] = &variable(i.index, i.flag, i.a, previousNode);
+                break;
+            case Op::Plus:
+                binaryOp(i, [](RandomVariable& x, const RandomVariable& y) { x += y; }, operator+);
+                break;
+            case Op::Minus:
+                binaryOp(
+                    i, [](RandomVariable& x, const RandomVariable& y) { x -= y; },
+                    [](const ValueType& x, const ValueType& y) { return x - y; });
+                break;
+            case Op::Multiply:
+                binaryOp(i, [](RandomVariable& x, const RandomVariable& y) { x *= y; }, operator*);
+                break;
+            case Op::Divide:
+                binaryOp(i, [](RandomVariable& x, const RandomVariable& y) { x /= y; }, operator/);
+                break;
+            case Op::Min:
+                binaryOp(
+                    i, [](RandomVariable& x, const RandomVariable& y) { x = QuantExt::min(std::move(x), y); }, min);
+                break;
+            case Op::Max:
+                binaryOp(
+                    i, [](RandomVariable& x, const RandomVariable& y) { x = QuantExt::max(std::move(x), y); }, max);
+                break;
+            case Op::Round:
+                binaryOp(
+                    i, [](RandomVariable& x, const RandomVariable& y) { x = QuantExt::round(std::move(x), y); }, round);
+                break;
+            case Op::Pow:
+                binaryOp(
+                    i, [](RandomVariable& x, const RandomVariable& y) { x = QuantExt::pow(std::move(x), y); }, pow);
+                break;
+            case Op::Negate:
+                unaryOp(
+                    i, [](RandomVariable& x) { x = -std::move(x); }, [](const ValueType& x) { return -x; });
+                break;
+            case Op::Abs:
+                unaryOp(i, [](RandomVariable& x) { x = QuantExt::abs(std::move(x)); }, abs);
+                break;
+            case Op::Exp:
+                unaryOp(i, [](RandomVariable& x) { x = QuantExt::exp(std::move(x)); }, exp);
+                break;
+            case Op::Log:
+                unaryOp(i, [](RandomVariable& x) { x = QuantExt::log(std::move(x)); }, log);
+                break;
+            case Op::Sqrt:
+                unaryOp(i, [](RandomVariable& x) { x = QuantExt::sqrt(std::move(x)); }, sqrt);
+                break;
+            case Op::NormalCdf:
+                unaryOp(i, [](RandomVariable& x) { x = QuantExt::normalCdf(std::move(x)); }, normalCdf);
+                break;
+            case Op::NormalPdf:
+                unaryOp(i, [](RandomVariable& x) { x = QuantExt::normalPdf(std::move(x)); }, normalPdf);
+                break;
+            case Op::Frac:
+                unaryOp(i, [](RandomVariable& x) { x = QuantExt::frac(std::move(x)); }, frac);
+                break;
+            case Op::Eq:
+                compare(i, [](const RandomVariable& x, const RandomVariable& y) { return close_enough(x, y); }, equal);
+                break;
+            case Op::Neq:
+                compare(
+                    i, [](const RandomVariable& x, const RandomVariable& y) { return !close_enough(x, y); },
+                    notequal);
+                break;
+            case Op::Lt:
+                compare(i, [](const RandomVariable& x, const RandomVariable& y) { return x < y; }, lt);
+                break;
+            case Op::Leq:
+                compare(i, [](const RandomVariable& x, const RandomVariable& y) { return x <= y; }, leq);
+                break;
+            case Op::Gt:
+                compare(i, [](const RandomVariable& x, const RandomVariable& y) { return x > y; }, gt);
+                break;
+            case Op::Geq:
+                compare(i, [](const RandomVariable& x, const RandomVariable& y) { return x >= y; }, geq);
+                break;
+            case Op::And:
+            case Op::Or: {
+                if (reg(i.a).which() == ValueTypeWhich::Filter && reg(i.b).which() == ValueTypeWhich::Filter) {
+                    Filter& x = boost::get<Filter>(own(i.a));
+                    const Filter& y = boost::get<Filter>(reg(i.b));
+                    x = i.op == Op::And ? std::move(x) && y : std::move(x) || y;
+                } else {
+                    set(i.a, i.op == Op::And ? logicalAnd(reg(i.a), reg(i.b)) : logicalOr(reg(i.a), reg(i.b)));
+                }
+                break;
+            }
+            case Op::Not:
+                if (reg(i.a).which() == ValueTypeWhich::Filter) {
+                    Filter& x = boost::get<Filter>(own(i.a));
+                    x = !std::move(x);
+                } else {
+                    set(i.a, logicalNot(reg(i.a)));
+                }
+                break;
+            case Op::AndLeft:
+            case Op::OrLeft: {
+                QL_REQUIRE(reg(i.a).which() == ValueTypeWhich::Filter, "expected condition");
+                const Filter& l = boost::get<Filter>(reg(i.a));
+                bool shortCut = i.op == Op::AndLeft ? !l[0] : l[0];
+                if (l.deterministic() && shortCut) {
+                    // short cut if first expression is already false (and) / true (or)
+                    Size n = l.size();
+                    set(i.a, Filter(n, i.op == Op::OrLeft));
+                    pc = i.target;
+                }
+                break;
+            }
+            case Op::Assign:
+                assign(i, previousNode);
+                break;
+            case Op::IfThen: {
+                QL_REQUIRE(reg(i.a).which() == ValueTypeWhich::Filter,
+                           "IF must be followed by a boolean, got " << valueTypeLabels.at(reg(i.a).which()));
+                const Filter& cond = boost::get<Filter>(reg(i.a));
+                Filter currentFilter = runner_.filter.top() && cond;
+                currentFilter.updateDeterministic();
+                if (i.flag)
+                    conditions_.push_back(std::make_pair(runner_.filter.top(), cond));
+                bool skip = currentFilter.deterministic() && !currentFilter[0];
+                runner_.filter.push(std::move(currentFilter));
+                if (skip)
+                    pc = i.target;
+                break;
+            }
+            case Op::ThenEnd: {
+                runner_.filter.pop();
+                if (i.flag) {
+                    Filter currentFilter = std::move(conditions_.back().first) && !std::move(conditions_.back().second);
+                    conditions_.pop_back();
+                    currentFilter.updateDeterministic();
+                    bool skip = currentFilter.deterministic() && !currentFilter[0];
+                    runner_.filter.push(std::move(currentFilter));
+                    if (skip)
+                        pc = i.target;
+                }
+                break;
+            }
+            case Op::ElseEnd:
+                runner_.filter.pop();
+                break;
+            case Op::LoopBegin:
+                loopBegin(i);
+                break;
+            case Op::LoopTest: {
+                Loop& l = loops_[i.b];
+                if ((l.step > 0 && l.current <= l.end) || (l.step < 0 && l.current >= l.end))
+                    *l.var = RandomVariable(size_, static_cast<double>(l.current));
+                else
+                    pc = i.target;
+                break;
+            }
+            case Op::LoopNext: {
+                Loop& l = loops_[i.b];
+                QL_REQUIRE(l.var->which() == ValueTypeWhich::Number &&
+                               close_enough_all(boost::get<RandomVariable>(*l.var),
+                                                RandomVariable(size_, static_cast<double>(l.current))),
+                           "loop variable was modified in body from " << l.current << " to " << *l.var
+                                                                      << ", this is illegal.");
+                l.current += l.step;
+                pc = i.target;
+                break;
+            }
+            case Op::Eval:
+                i.node->accept(runner_);
+                if (i.flag)
+                    set(i.a, runner_.value.pop());
+                break;
+            default:
+                QL_FAIL("internal error: unhandled instruction " << static_cast<int>(i.op));
+            }
+        }
+    }
+
+private:
+    struct Loop {
+        long current, end, step;
+        ValueType* var;
+    };
+
+    // register access, a register refers to its own temporary, a constant or a context variable
+
+    const ValueType& reg(const Size k) const { return *refs_[k]; }
+
+    ValueType& own(const Size k) {
+        if (refs_[k] != &temps_[k]) {
+            temps_[k] = *refs_[k];
+            refs_[k] = &temps_[k];
+        }
+        return temps_[k];
+    }
+
+    void set(const Size k, ValueType&& v) {
+        temps_[k] = std::move(v);
+        refs_[k] = &temps_[k];
+    }
+
+    // numeric operations are done in place, for other types the generic operation reports the error
+
+    template <typename F, typename G> void binaryOp(const ScriptProgram::Instruction& i, const F& f, const G& g) {
+        if (reg(i.a).which() == ValueTypeWhich::Number && reg(i.b).which() == ValueTypeWhich::Number)
+            f(boost::get<RandomVariable>(own(i.a)), boost::get<RandomVariable>(reg(i.b)));
+        else
+            set(i.a, g(reg(i.a), reg(i.b)));
+    }
+
+    template <typename F, typename G> void unaryOp(const ScriptProgram::Instruction& i, const F& f, const G& g) {
+        if (reg(i.a).which() == ValueTypeWhich::Number)
+            f(boost::get<RandomVariable>(own(i.a)));
+        else
+            set(i.a, g(reg(i.a)));
+    }
+
+    template <typename F, typename G> void compare(const ScriptProgram::Instruction& i, const F& f, const G& g) {
+        if (reg(i.a).which() == ValueTypeWhich::Number && reg(i.b).which() == ValueTypeWhich::Number)
+            set(i.a, f(boost::get<RandomVariable>(reg(i.a)), boost::get<RandomVariable>(reg(i.b))));
+        else
+            set(i.a, g(reg(i.a), reg(i.b)));
+    }
+
+    // get ref to context variable, the array subscript is read from register k
+
+    ValueType& variable(const Size v, const bool subscript, const Size k, ASTNode* subscriptNode) {
+        if (scalars_[v] == nullptr && arrays_[v] == nullptr) {
+            const std::string& name = program_.variables[v];
+            auto scalar = context_.scalars.find(name);
+            if (scalar != context_.scalars.end()) {
+                QL_REQUIRE(!subscript, "no array subscript allowed for variable '" << name << "'");
+                scalars_[v] = &scalar->second;
+            } else {
+                auto array = context_.arrays.find(name);
+                QL_REQUIRE(array != context_.arrays.end(), "variable '" << name << "' is not defined.");
+                arrays_[v] = &array->second;
+            }
+        }
+        if (scalars_[v] != nullptr)
+            return *scalars_[v];
+        QL_REQUIRE(subscript, "array subscript required for variable '" << program_.variables[v] << "'");
+        ASTNode* node = lastVisitedNode_;
+        lastVisitedNode_ = subscriptNode;
+        const ValueType& arg = reg(k);
+        QL_REQUIRE(arg.which() == ValueTypeWhich::Number,
+                   "array subscript must be of type NUMBER, got " << valueTypeLabels.at(arg.which()));
+        const RandomVariable& i = boost::get<RandomVariable>(arg);
+        QL_REQUIRE(i.deterministic(), "array subscript must be deterministic");
+        long il = std::lround(i.at(0));
+        QL_REQUIRE(static_cast<long>(arrays_[v]->size()) >= il && il >= 1,
+                   "array index " << il << " out of bounds 1..." << arrays_[v]->size());
+        lastVisitedNode_ = node;
+        return (*arrays_[v])[il - 1];
+    }
+
+    void assign(const ScriptProgram::Instruction& i, ASTNode* subscriptNode) {
+        const std::string& name = program_.variables[i.index];
+        if (ignored_[i.index])
+            return;
+        QL_REQUIRE(!constant_[i.index], "can not assign to const variable '" << name << "'");
+        lastVisitedNode_ = i.node->args[0].get();
+        ValueType& ref = variable(i.index, i.flag, i.b, subscriptNode);
+        lastVisitedNode_ = i.node;
+        // the right hand side must not change while the variable is updated
+        if (refs_[i.a] == &ref)
+            own(i.a);
+        const ValueType& right = reg(i.a);
+        if (ref.which() == ValueTypeWhich::Event || ref.which() == ValueTypeWhich::Currency ||
+            ref.which() == ValueTypeWhich::Index) {
+            typeSafeAssign(ref, right);
+        } else {
+            QL_REQUIRE(ref.which() == ValueTypeWhich::Number,
+                       "internal error: expected NUMBER, got " << valueTypeLabels.at(ref.which()));
+            QL_REQUIRE(right.which() == ValueTypeWhich::Number, "invalid assignment: type "
+                                                                    << valueTypeLabels.at(ref.which()) << " <- "
+                                                                    << valueTypeLabels.at(right.which()));
+            RandomVariable& r = boost::get<RandomVariable>(ref);
+            // disable check in assignments
+            r.setTime(Null<Real>());
+            // a temporary right hand side is not needed anymore and can be moved
+            if (refs_[i.a] == &temps_[i.a])
+                r = conditionalResult(runner_.filter.top(), std::move(boost::get<RandomVariable>(temps_[i.a])), r);
+            else
+                r = conditionalResult(runner_.filter.top(), boost::get<RandomVariable>(right), r);
+            r.updateDeterministic();
+        }
+    }
+
+    void loopBegin(const ScriptProgram::Instruction& i) {
+        const std::string& name = program_.variables[i.index];
+        auto var = context_.scalars.find(name);
+        QL_REQUIRE(var != context_.scalars.end(), "loop variable '" << name << "' not defined or not scalar");
+        QL_REQUIRE(!constant_[i.index], "loop variable '" << name << "' is constant");
+        const ValueType& left = reg(i.a);
+        const ValueType& right = reg(i.a + 1);
+        const ValueType& step = reg(i.a + 2);
+        QL_REQUIRE(left.which() == ValueTypeWhich::Number && right.which() == ValueTypeWhich::Number &&
+                       step.which() == ValueTypeWhich::Number,
+                   "loop bounds and step must be of type NUMBER, got " << valueTypeLabels.at(left.which()) << ", "
+                                                                       << valueTypeLabels.at(right.which()) << ", "
+                                                                       << valueTypeLabels.at(step.which()));
+        const RandomVariable& a = boost::get<RandomVariable>(left);
+        const RandomVariable& b = boost::get<RandomVariable>(right);
+        const RandomVariable& s = boost::get<RandomVariable>(step);
+        QL_REQUIRE(a.deterministic(), "first loop bound must be deterministic");
+        QL_REQUIRE(b.deterministic(), "second loop bound must be deterministic");
+        QL_REQUIRE(s.deterministic(), "loop step must be deterministic");
+        Loop& l = loops_[i.b];
+        l.current = std::lround(a.at(0));
+        l.end = std::lround(b.at(0));
+        l.step = std::lround(s.at(0));
+        l.var = &var->second;
+        QL_REQUIRE(l.step != 0, "loop step must be non-zero");
+    }
+
+    const ScriptProgram& program_;
+    ASTRunner& runner_;
+    const Size size_;
+    Context& context_;
+    ASTNode*& lastVisitedNode_;
+    // registers
+    std::vector<ValueType> constants_, temps_;
+    std::vector<const ValueType*> refs_;
+    // context variables resolved on first access, assignment restrictions
+    std::vector<ValueType*> scalars_;
+    std::vector<std::vector<ValueType>*> arrays_;
+    std::vector<bool> ignored_, constant_;
+    // loop states and (base filter, condition) of the enclosing if-then-else statements with else branch
+    std::vector<Loop> loops_;
+    std::vector<std::pair<Filter, Filter>> conditions_;
+};
+
 } // namespace
 
 void ScriptEngine::run(const std::string& script, bool interactive, QuantLib::ext::shared_ptr<PayLog> paylog,
                        bool includePastCashflows) {
 
-    ASTNode* loc;
+    ASTNode* loc = nullptr;
     ASTRunner runner(model_, script, interactive, *context_, loc, paylog, paylog != nullptr && includePastCashflows);
 
+    // the interactive mode traces the single nodes, so we interpret the ast in this case
+    QuantLib::ext::shared_ptr<const ScriptProgram> program;
+    if (compiled_ && !interactive)
+        program = cachedScriptProgram(root_);
+
     randomvariable_output_pattern pattern;
     if (model_ == nullptr || model_->type() == Model::Type::MC) {
         pattern = randomvariable_output_pattern(randomvariable_output_pattern::pattern::expectation);
@@ -1191,7 +1559,10 @@ void ScriptEngine::run(const std::string& script, bool interactive, QuantLib::ex
     boost::timer::cpu_timer timer;
     try {
         reset(root_);
-        root_->accept(runner);
+        if (program)
+            ProgramRunner(*program, runner, model_ ? model_->size() : 1, *context_, loc).run();
+        else
+            root_->accept(runner);
         timer.stop();
         QL_REQUIRE(runner.value.size() == 1,
                    "ScriptEngine::run(): value stack has wrong size (" << runner.value.size() << "), should be 1");
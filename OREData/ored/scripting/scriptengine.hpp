@@ -27,17 +27,21 @@
 #include <ored/scripting/ast.hpp>
 #include <ored/scripting/context.hpp>
 #include <ored/scripting/paylog.hpp>
+#include <ored/scripting/scriptprogram.hpp>
 
 #include <ored/configuration/conventions.hpp>
 
 namespace ore {
 namespace data {
 
+/*! Runs a script on a context. By default the whole ast is interpreted. If compiled is true, the ast is compiled to a
+    ScriptProgram (which is cached per ast) and the program is executed, nodes not covered by the program are
+    evaluated by the interpreter. In interactive mode the ast is always interpreted. */
 class ScriptEngine {
 public:
     ScriptEngine(const ASTNodePtr root, const QuantLib::ext::shared_ptr<Context> context,
-                 const QuantLib::ext::shared_ptr<Model> model = nullptr)
-        : root_(root), context_(context), model_(model) {}
+                 const QuantLib::ext::shared_ptr<Model> model = nullptr, const bool compiled = false)
+        : root_(root), context_(context), model_(model), compiled_(compiled) {}
     void run(const std::string& script = "", bool interactive = false, QuantLib::ext::shared_ptr<PayLog> paylog = nullptr,
              bool includePastCashflows = false);
 
@@ -45,6 +49,7 @@ private:
     const ASTNodePtr root_;
     const QuantLib::ext::shared_ptr<Context> context_;
     const QuantLib::ext::shared_ptr<Model> model_;
+    const bool compiled_;
 };
 
 } // namespace data
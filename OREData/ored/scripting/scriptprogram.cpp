@@ -0,0 +1,345 @@
+/*
+ Copyright (C) 2025 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+#include <ored/scripting/scriptprogram.hpp>
+#include <ored/scripting/value.hpp>
+
+#include <ql/errors.hpp>
+#include <ql/optional.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <mutex>
+
+namespace ore {
+namespace data {
+
+namespace {
+class ASTCompiler : public AcyclicVisitor,
+                    public Visitor<ASTNode>,
+                    public Visitor<OperatorPlusNode>,
+                    public Visitor<OperatorMinusNode>,
+                    public Visitor<OperatorMultiplyNode>,
+                    public Visitor<OperatorDivideNode>,
+                    public Visitor<NegateNode>,
+                    public Visitor<FunctionAbsNode>,
+                    public Visitor<FunctionExpNode>,
+                    public Visitor<FunctionLogNode>,
+                    public Visitor<FunctionSqrtNode>,
+                    public Visitor<FunctionNormalCdfNode>,
+                    public Visitor<FunctionNormalPdfNode>,
+                    public Visitor<FunctionMinNode>,
+                    public Visitor<FunctionMaxNode>,
+                    public Visitor<FunctionFractionNode>,
+                    public Visitor<FunctionRoundNode>,
+                    public Visitor<FunctionPowNode>,
+                    public Visitor<ConstantNumberNode>,
+                    public Visitor<VariableNode>,
+                    public Visitor<AssignmentNode>,
+                    public Visitor<SequenceNode>,
+                    public Visitor<ConditionEqNode>,
+                    public Visitor<ConditionNeqNode>,
+                    public Visitor<ConditionLtNode>,
+                    public Visitor<ConditionLeqNode>,
+                    public Visitor<ConditionGtNode>,
+                    public Visitor<ConditionGeqNode>,
+                    public Visitor<ConditionNotNode>,
+                    public Visitor<ConditionAndNode>,
+                    public Visitor<ConditionOrNode>,
+                    public Visitor<IfThenElseNode>,
+                    public Visitor<LoopNode> {
+public:
+    using Op = ScriptProgram::Op;
+    using Instruction = ScriptProgram::Instruction;
+
+    explicit ASTCompiler(ScriptProgram& program) : program_(program) {}
+
+    // compile a statement
+
+    void statement(ASTNode& n) {
+        bool expression = expression_;
+        expression_ = false;
+        n.accept(*this);
+        expression_ = expression;
+    }
+
+    // compile an expression into register k, returns the value if the expression is a numeric constant
+
+    QuantLib::ext::optional<double> expression(ASTNode& n, const Size k) {
+        bool expression = expression_;
+        Size reg = reg_;
+        expression_ = true;
+        reg_ = k;
+        constant_ = QuantLib::ext::nullopt;
+        program_.registers = std::max(program_.registers, k + 1);
+        n.accept(*this);
+        expression_ = expression;
+        reg_ = reg;
+        auto result = constant_;
+        constant_ = QuantLib::ext::nullopt;
+        return result;
+    }
+
+    Size emit(const Instruction& i) {
+        program_.instructions.push_back(i);
+        return program_.instructions.size() - 1;
+    }
+
+    Size variable(const std::string& name) {
+        auto v = variables_.find(name);
+        if (v != variables_.end())
+            return v->second;
+        program_.variables.push_back(name);
+        variables_[name] = program_.variables.size() - 1;
+        return program_.variables.size() - 1;
+    }
+
+    void loadConstant(ASTNode& n, const double value) {
+        Size c = 0;
+        while (c < program_.constants.size() && program_.constants[c] != value)
+            ++c;
+        if (c == program_.constants.size())
+            program_.constants.push_back(value);
+        emit({Op::LoadConst, &n, reg_, 0, c});
+        constant_ = value;
+    }
+
+    // helper functions to compile operations, constant arguments are folded
+
+    void binaryOp(ASTNode& n, const Op op,
+                  const std::function<RandomVariable(const RandomVariable&, const RandomVariable&)>& f) {
+        Size k = reg_, start = program_.instructions.size();
+        auto x = expression(*n.args[0], k);
+        auto y = expression(*n.args[1], k + 1);
+        if (x && y && fold(n, start, [&f, &x, &y]() { return f(RandomVariable(1, *x), RandomVariable(1, *y)); }))
+            return;
+        emit({op, &n, k, k + 1});
+    }
+
+    void unaryOp(ASTNode& n, const Op op, const std::function<RandomVariable(const RandomVariable&)>& f) {
+        Size k = reg_, start = program_.instructions.size();
+        auto x = expression(*n.args[0], k);
+        if (x && fold(n, start, [&f, &x]() { return f(RandomVariable(1, *x)); }))
+            return;
+        emit({op, &n, k});
+    }
+
+    void conditionOp(ASTNode& n, const Op op) {
+        expression(*n.args[0], reg_);
+        expression(*n.args[1], reg_ + 1);
+        emit({op, &n, reg_, reg_ + 1});
+    }
+
+    // replaces the instructions from start on by the constant result of f, if f succeeds
+
+    bool fold(ASTNode& n, const Size start, const std::function<RandomVariable()>& f) {
+        double value;
+        try {
+            value = f().at(0);
+        } catch (...) {
+            // leave it to the run to report the error
+            return false;
+        }
+        program_.instructions.erase(program_.instructions.begin() + start, program_.instructions.end());
+        loadConstant(n, value);
+        return true;
+    }
+
+    void logicalOp(ASTNode& n, const Op left, const Op op) {
+        Size k = reg_;
+        expression(*n.args[0], k);
+        Size shortCut = emit({left, &n, k});
+        expression(*n.args[1], k + 1);
+        emit({op, &n, k, k + 1});
+        program_.instructions[shortCut].target = program_.instructions.size();
+    }
+
+    // all nodes not compiled are delegated to the interpreter
+
+    void visit(ASTNode& n) override { emit({Op::Eval, &n, reg_, 0, 0, 0, expression_}); }
+
+    // operator / function node types
+
+    void visit(OperatorPlusNode& n) override {
+        binaryOp(n, Op::Plus, [](const RandomVariable& x, const RandomVariable& y) { return x + y; });
+    }
+    void visit(OperatorMinusNode& n) override {
+        binaryOp(n, Op::Minus, [](const RandomVariable& x, const RandomVariable& y) { return x - y; });
+    }
+    void visit(OperatorMultiplyNode& n) override {
+        binaryOp(n, Op::Multiply, [](const RandomVariable& x, const RandomVariable& y) { return x * y; });
+    }
+    void visit(OperatorDivideNode& n) override {
+        binaryOp(n, Op::Divide, [](const RandomVariable& x, const RandomVariable& y) { return x / y; });
+    }
+    void visit(FunctionMinNode& n) override {
+        binaryOp(n, Op::Min, [](const RandomVariable& x, const RandomVariable& y) { return QuantExt::min(x, y); });
+    }
+    void visit(FunctionMaxNode& n) override {
+        binaryOp(n, Op::Max, [](const RandomVariable& x, const RandomVariable& y) { return QuantExt::max(x, y); });
+    }
+    void visit(FunctionRoundNode& n) override {
+        binaryOp(n, Op::Round, [](const RandomVariable& x, const RandomVariable& y) { return QuantExt::round(x, y); });
+    }
+    void visit(FunctionPowNode& n) override {
+        binaryOp(n, Op::Pow, [](const RandomVariable& x, const RandomVariable& y) { return QuantExt::pow(x, y); });
+    }
+    void visit(NegateNode& n) override {
+        unaryOp(n, Op::Negate, [](const RandomVariable& x) { return -x; });
+    }
+    void visit(FunctionAbsNode& n) override {
+        unaryOp(n, Op::Abs, [](const RandomVariable& x) { return QuantExt::abs(x); });
+    }
+    void visit(FunctionExpNode& n) override {
+        unaryOp(n, Op::Exp, [](const RandomVariable& x) { return QuantExt::exp(x); });
+    }
+    void visit(FunctionLogNode& n) override {
+        unaryOp(n, Op::Log, [](const RandomVariable& x) { return QuantExt::log(x); });
+    }
+    void visit(FunctionSqrtNode& n) override {
+        unaryOp(n, Op::Sqrt, [](const RandomVariable& x) { return QuantExt::sqrt(x); });
+    }
+    void visit(FunctionNormalCdfNode& n) override {
+        unaryOp(n, Op::NormalCdf, [](const RandomVariable& x) { return QuantExt::normalCdf(x); });
+    }
+    void visit(FunctionNormalPdfNode& n) override {
+        unaryOp(n, Op::NormalPdf, [](const RandomVariable& x) { return QuantExt::normalPdf(x); });
+    }
+    void visit(FunctionFractionNode& n) override {
+        unaryOp(n, Op::Frac, [](const RandomVariable& x) { return QuantExt::frac(x); });
+    }
+
+    // condition nodes
+
+    void visit(ConditionEqNode& n) override { conditionOp(n, Op::Eq); }
+    void visit(ConditionNeqNode& n) override { conditionOp(n, Op::Neq); }
+    void visit(ConditionLtNode& n) override { conditionOp(n, Op::Lt); }
+    void visit(ConditionLeqNode& n) override { conditionOp(n, Op::Leq); }
+    void visit(ConditionGtNode& n) override { conditionOp(n, Op::Gt); }
+    void visit(ConditionGeqNode& n) override { conditionOp(n, Op::Geq); }
+    void visit(ConditionNotNode& n) override {
+        expression(*n.args[0], reg_);
+        emit({Op::Not, &n, reg_});
+    }
+    void visit(ConditionAndNode& n) override { logicalOp(n, Op::AndLeft, Op::And); }
+    void visit(ConditionOrNode& n) override { logicalOp(n, Op::OrLeft, Op::Or); }
+
+    // constants / variable related nodes
+
+    void visit(ConstantNumberNode& n) override {
+        if (!expression_) {
+            visit(static_cast<ASTNode&>(n));
+            return;
+        }
+        loadConstant(n, n.value);
+    }
+
+    void visit(VariableNode& n) override {
+        if (!expression_) {
+            visit(static_cast<ASTNode&>(n));
+            return;
+        }
+        if (n.args[0])
+            expression(*n.args[0], reg_);
+        emit({Op::LoadVar, &n, reg_, 0, variable(n.name), 0, n.args[0] != nullptr});
+    }
+
+    void visit(AssignmentNode& n) override {
+        auto v = QuantLib::ext::dynamic_pointer_cast<VariableNode>(n.args[0]);
+        if (v == nullptr) {
+            visit(static_cast<ASTNode&>(n));
+            return;
+        }
+        expression(*n.args[1], 0);
+        if (v->args[0])
+            expression(*v->args[0], 1);
+        emit({Op::Assign, &n, 0, 1, variable(v->name), 0, v->args[0] != nullptr});
+    }
+
+    // control flow nodes
+
+    void visit(SequenceNode& n) override {
+        for (auto const& arg : n.args)
+            statement(*arg);
+    }
+
+    void visit(IfThenElseNode& n) override {
+        expression(*n.args[0], 0);
+        Size ifThen = emit({Op::IfThen, &n, 0, 0, 0, 0, n.args[2] != nullptr});
+        statement(*n.args[1]);
+        Size thenEnd = emit({Op::ThenEnd, &n, 0, 0, 0, 0, n.args[2] != nullptr});
+        program_.instructions[ifThen].target = thenEnd;
+        if (n.args[2]) {
+            statement(*n.args[2]);
+            program_.instructions[thenEnd].target = emit({Op::ElseEnd, &n});
+        }
+    }
+
+    void visit(LoopNode& n) override {
+        Size loop = program_.loops++, var = variable(n.name);
+        expression(*n.args[0], 0);
+        expression(*n.args[1], 1);
+        expression(*n.args[2], 2);
+        emit({Op::LoopBegin, &n, 0, loop, var});
+        Size test = emit({Op::LoopTest, &n, 0, loop, var});
+        statement(*n.args[3]);
+        emit({Op::LoopNext, &n, 0, loop, var, test});
+        program_.instructions[test].target = program_.instructions.size();
+    }
+
+private:
+    ScriptProgram& program_;
+    std::map<std::string, Size> variables_;
+    bool expression_ = false;
+    Size reg_ = 0;
+    QuantLib::ext::optional<double> constant_;
+};
+} // namespace
+
+QuantLib::ext::shared_ptr<const ScriptProgram> compileScript(const ASTNodePtr& root) {
+    QL_REQUIRE(root, "compileScript(): no ast given");
+    auto program = QuantLib::ext::make_shared<ScriptProgram>();
+    ASTCompiler compiler(*program);
+    compiler.statement(*root);
+    return program;
+}
+
+QuantLib::ext::shared_ptr<const ScriptProgram> cachedScriptProgram(const ASTNodePtr& root) {
+    static std::mutex mutex;
+    static std::map<const ASTNode*,
+                    std::pair<QuantLib::ext::weak_ptr<ASTNode>, QuantLib::ext::shared_ptr<const ScriptProgram>>>
+        cache;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto c = cache.find(root.get());
+    if (c != cache.end() && c->second.first.lock() == root)
+        return c->second.second;
+    // remove the programs of asts that do not exist anymore
+    for (auto it = cache.begin(); it != cache.end();) {
+        if (it->second.first.expired())
+            it = cache.erase(it);
+        else
+            ++it;
+    }
+    auto program = compileScript(root);
+    cache[root.get()] = std::make_pair(QuantLib::ext::weak_ptr<ASTNode>(root), program);
+    return program;
+}
+
+} // namespace data
+} // namespace ore
@@ -0,0 +1,125 @@
+/*
+ Copyright (C) 2025 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+/*! \file ored/scripting/scriptprogram.hpp
+    \brief linear instruction sequence an ast is compiled to for the script engine
+    \ingroup utilities
+*/
+
+#pragma once
+
+#include <ored/scripting/ast.hpp>
+
+#include <string>
+#include <vector>
+
+namespace ore {
+namespace data {
+
+//! Compiled script
+/*! The ast is lowered to a flat sequence of instructions operating on a fixed set of registers, so that the script
+    engine can execute the hot part of a script (arithmetic, comparisons, variable access, assignments, if-then-else
+    and loops) without the visitor dispatch, the value stack and the copies of variables on each access.
+
+    Expressions are evaluated into registers allocated in stack order, i.e. the result of an expression compiled into
+    register k is computed using the registers k, k+1, ... only. Numeric subexpressions that only depend on constants
+    are folded at compile time. Variables are referred to by their index in the variables table and resolved against
+    the context when the script is run.
+
+    All other nodes (model dependent functions, declarations, SORT, PERMUTE, REQUIRE, ...) are delegated to the
+    interpreter, an Eval instruction runs the node on the interpreter and takes its result (if any) from its value
+    stack.
+
+    The program does not depend on the context or the model, it can be shared between engines running the same ast. */
+struct ScriptProgram {
+    enum class Op {
+        // a <- constant, a <- variable (with subscript in a if flag is set)
+        LoadConst,
+        LoadVar,
+        // a <- a op b
+        Plus,
+        Minus,
+        Multiply,
+        Divide,
+        Min,
+        Max,
+        Round,
+        Pow,
+        Eq,
+        Neq,
+        Lt,
+        Leq,
+        Gt,
+        Geq,
+        And,
+        Or,
+        // a <- op a
+        Negate,
+        Abs,
+        Exp,
+        Log,
+        Sqrt,
+        NormalCdf,
+        NormalPdf,
+        Frac,
+        Not,
+        // short cut for and / or on a deterministic left operand in a, jumps to target
+        AndLeft,
+        OrLeft,
+        // variable (with subscript in b if flag is set) <- a
+        Assign,
+        // if a then (flag = has else branch), end of then branch, end of else branch
+        IfThen,
+        ThenEnd,
+        ElseEnd,
+        // loop with bounds a, a+1, step a+2 over variable, b is the loop index
+        LoopBegin,
+        LoopTest,
+        LoopNext,
+        // run node on the interpreter, if flag is set its result is stored in a
+        Eval
+    };
+
+    struct Instruction {
+        Op op;
+        //! node for diagnostics and for delegation to the interpreter
+        ASTNode* node;
+        Size a = 0, b = 0;
+        //! index of the constant or variable
+        Size index = 0;
+        //! jump target
+        Size target = 0;
+        bool flag = false;
+    };
+
+    std::vector<Instruction> instructions;
+    std::vector<double> constants;
+    std::vector<std::string> variables;
+    Size registers = 0;
+    Size loops = 0;
+};
+
+//! compile the given ast to a program
+QuantLib::ext::shared_ptr<const ScriptProgram> compileScript(const ASTNodePtr& root);
+
+/*! as compileScript(), but the program is cached for the ast, so that engines constructing a new script engine on
+    each calculation compile the script once only; the cache does not keep the ast alive */
+QuantLib::ext::shared_ptr<const ScriptProgram> cachedScriptProgram(const ASTNodePtr& root);
+
+} // namespace data
+} // namespace ore
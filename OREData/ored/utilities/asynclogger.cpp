@@ -0,0 +1,199 @@
+/*
+ Copyright (C) 2025 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+#include <ored/utilities/asynclogger.hpp>
+
+#include <ql/errors.hpp>
+
+#include <algorithm>
+
+using namespace std;
+
+namespace ore {
+namespace data {
+
+namespace {
+std::atomic<std::size_t> nextAsyncLoggerId{0};
+}
+
+AsyncLogger::AsyncLogger(const QuantLib::ext::shared_ptr<Logger>& target, const QuantLib::Size bufferSize,
+                         const OverflowPolicy overflowPolicy, const std::chrono::milliseconds flushInterval)
+    : Logger(target ? target->name() : string()), target_(target), capacity_(1), overflowPolicy_(overflowPolicy),
+      flushInterval_(flushInterval), id_(nextAsyncLoggerId.fetch_add(1, std::memory_order_relaxed)) {
+    QL_REQUIRE(target_, "AsyncLogger: no target logger given");
+    QL_REQUIRE(bufferSize > 0, "AsyncLogger: buffer size must be positive");
+    // round up to a power of 2, so that the slot index is a simple mask
+    while (capacity_ < bufferSize)
+        capacity_ *= 2;
+    writer_ = std::thread(&AsyncLogger::writerLoop, this);
+}
+
+AsyncLogger::~AsyncLogger() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wakeUp_.notify_one();
+    writer_.join();
+    // the rings may outlive the logger in the producer threads' registries
+    std::lock_guard<std::mutex> lock(ringsMutex_);
+    for (auto& r : rings_)
+        r->closed.store(true, std::memory_order_release);
+}
+
+AsyncLogger::Ring& AsyncLogger::localRing() {
+    // the rings of the current thread, keyed by logger id, marked as abandoned when the thread terminates
+    struct LocalRings {
+        ~LocalRings() {
+            for (auto& r : rings)
+                r.second->abandoned.store(true, std::memory_order_release);
+        }
+        std::vector<std::pair<std::size_t, QuantLib::ext::shared_ptr<Ring>>> rings;
+    };
+    thread_local LocalRings local;
+
+    for (auto& r : local.rings) {
+        if (r.first == id_)
+            return *r.second;
+    }
+
+    local.rings.erase(std::remove_if(local.rings.begin(), local.rings.end(),
+                                     [](const std::pair<std::size_t, QuantLib::ext::shared_ptr<Ring>>& r) {
+                                         return r.second->closed.load(std::memory_order_acquire);
+                                     }),
+                      local.rings.end());
+    auto ring = QuantLib::ext::make_shared<Ring>(capacity_);
+    {
+        std::lock_guard<std::mutex> lock(ringsMutex_);
+        rings_.push_back(ring);
+    }
+    local.rings.emplace_back(id_, ring);
+    return *ring;
+}
+
+void AsyncLogger::log(unsigned level, const string& s) {
+    Ring& ring = localRing();
+    std::size_t head = ring.head.load(std::memory_order_relaxed);
+    while (head - ring.tail.load(std::memory_order_acquire) == capacity_) {
+        if (overflowPolicy_ == OverflowPolicy::Drop && level > ORE_ERROR) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        wakeWriter();
+        std::this_thread::yield();
+    }
+    Message& m = ring.slots[head & (capacity_ - 1)];
+    m.level = level;
+    m.seq = seq_.fetch_add(1, std::memory_order_relaxed);
+    m.text.assign(s);
+    ring.head.store(head + 1, std::memory_order_release);
+    if (level == ORE_ALERT || 2 * (head + 1 - ring.tail.load(std::memory_order_relaxed)) >= capacity_)
+        wakeWriter();
+}
+
+void AsyncLogger::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    std::size_t request = ++flushRequested_;
+    wakeUpRequested_ = true;
+    wakeUp_.notify_one();
+    flushed_.wait(lock, [this, request] { return flushCompleted_ >= request; });
+}
+
+void AsyncLogger::wakeWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        wakeUpRequested_ = true;
+    }
+    wakeUp_.notify_one();
+}
+
+void AsyncLogger::writerLoop() {
+    for (;;) {
+        bool stop;
+        std::size_t flushRequest;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wakeUp_.wait_for(lock, flushInterval_, [this] { return wakeUpRequested_ || stop_; });
+            wakeUpRequested_ = false;
+            stop = stop_;
+            flushRequest = flushRequested_;
+        }
+        drain();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            flushCompleted_ = flushRequest;
+        }
+        flushed_.notify_all();
+        if (stop)
+            break;
+    }
+}
+
+void AsyncLogger::drain() {
+    std::size_t n = 0;
+    {
+        std::lock_guard<std::mutex> lock(ringsMutex_);
+        for (auto r = rings_.begin(); r != rings_.end();) {
+            Ring& ring = **r;
+            // read abandoned before head, so that no message published before the thread terminated is missed
+            bool abandoned = ring.abandoned.load(std::memory_order_acquire);
+            std::size_t tail = ring.tail.load(std::memory_order_relaxed);
+            std::size_t head = ring.head.load(std::memory_order_acquire);
+            for (std::size_t p = tail; p != head; ++p) {
+                Message& m = ring.slots[p & (capacity_ - 1)];
+                if (n == batch_.size())
+                    batch_.emplace_back();
+                batch_[n].level = m.level;
+                batch_[n].seq = m.seq;
+                // swap, so that the string capacity is reused by the producer
+                batch_[n].text.swap(m.text);
+                ++n;
+            }
+            ring.tail.store(head, std::memory_order_release);
+            if (abandoned)
+                r = rings_.erase(r);
+            else
+                ++r;
+        }
+    }
+
+    std::sort(batch_.begin(), batch_.begin() + n,
+              [](const Message& a, const Message& b) { return a.seq < b.seq; });
+
+    std::size_t dropped = dropped_.load(std::memory_order_relaxed);
+    bool written = n > 0;
+    try {
+        for (std::size_t i = 0; i < n; ++i)
+            target_->log(batch_[i].level, batch_[i].text);
+        if (dropped > droppedReported_) {
+            target_->log(ORE_WARNING, "AsyncLogger: " + std::to_string(dropped - droppedReported_) +
+                                          " log messages dropped, because the buffer was full");
+            droppedReported_ = dropped;
+            written = true;
+        }
+        if (written)
+            target_->flush();
+    } catch (const std::exception& e) {
+        std::cerr << "AsyncLogger: error writing log messages: " << e.what() << std::endl;
+    } catch (...) {
+        std::cerr << "AsyncLogger: unknown error writing log messages" << std::endl;
+    }
+}
+
+} // namespace data
+} // namespace ore
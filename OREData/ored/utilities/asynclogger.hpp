@@ -0,0 +1,139 @@
+/*
+ Copyright (C) 2025 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+/*! \file ored/utilities/asynclogger.hpp
+    \brief Logger writing messages on a background thread
+    \ingroup utilities
+*/
+
+#pragma once
+
+#include <ored/utilities/log.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ore {
+namespace data {
+
+//! AsyncLogger
+/*!
+  This logger passes log messages on to a target logger on a background writer thread.
+
+  Each thread calling log() writes into its own lock-free single producer / single consumer ring buffer of fixed
+  capacity, so the logging threads only copy the message and do not wait for each other or for the target. The writer
+  thread wakes up every flushInterval (or earlier if a buffer is half full or an alert is logged), drains all buffers,
+  passes the messages in the order in which log() was called to the target and then calls flush() on the target once
+  per batch. A FileLogger used as a target should therefore be constructed with autoFlush = false.
+
+  If a buffer is full, the overflow policy decides what happens:
+  - Block: the logging thread waits until the writer has made space
+  - Drop: messages with level warning or lower are dropped, the number of dropped messages is reported to the target
+    as a warning; alerts, critical messages and errors are never dropped
+
+  The logger takes the name of the target, so that it can be retrieved and removed from the Log by that name. The
+  target must not be used from other threads while it is wrapped, for this reason a BufferLogger should not be used
+  as a target.
+
+  Messages still buffered are written in flush() and on destruction.
+
+  If only thread safe loggers such as this one are registered, the logging macros format the message on the calling
+  thread and pass it on without taking the Log mutex, see Log::logLockFree().
+
+  \ingroup utilities
+  \see Log
+ */
+class AsyncLogger : public Logger {
+public:
+    enum class OverflowPolicy { Block, Drop };
+
+    AsyncLogger(const QuantLib::ext::shared_ptr<Logger>& target, const QuantLib::Size bufferSize = 8192,
+                const OverflowPolicy overflowPolicy = OverflowPolicy::Block,
+                const std::chrono::milliseconds flushInterval = std::chrono::milliseconds(100));
+    //! Destructor, writes the buffered messages and stops the writer thread
+    virtual ~AsyncLogger();
+
+    AsyncLogger(const AsyncLogger&) = delete;
+    AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+    //! The log callback, only buffers the message
+    virtual void log(unsigned level, const std::string& s) override;
+    //! Blocks until all messages logged before the call are passed to the target and the target is flushed
+    virtual void flush() override;
+    //! log() only writes into the calling thread's buffer, so the Log does not need to serialise the calls
+    virtual bool threadSafe() const override { return true; }
+
+    const QuantLib::ext::shared_ptr<Logger>& target() const { return target_; }
+    OverflowPolicy overflowPolicy() const { return overflowPolicy_; }
+    //! The total number of messages dropped so far
+    QuantLib::Size dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    struct Message {
+        unsigned level = 0;
+        std::size_t seq = 0;
+        std::string text;
+    };
+
+    struct Ring {
+        explicit Ring(const std::size_t capacity) : slots(capacity) {}
+        std::vector<Message> slots;
+        std::atomic<std::size_t> head{0}; // next slot written by the producer
+        std::atomic<std::size_t> tail{0}; // next slot read by the writer
+        std::atomic<bool> abandoned{false}; // producer thread has terminated
+        std::atomic<bool> closed{false};    // logger is destroyed
+    };
+
+    Ring& localRing();
+    void wakeWriter();
+    void writerLoop();
+    void drain();
+
+    QuantLib::ext::shared_ptr<Logger> target_;
+    std::size_t capacity_;
+    OverflowPolicy overflowPolicy_;
+    std::chrono::milliseconds flushInterval_;
+    std::size_t id_;
+
+    std::mutex ringsMutex_;
+    std::vector<QuantLib::ext::shared_ptr<Ring>> rings_;
+
+    std::atomic<std::size_t> seq_{0};
+    std::atomic<std::size_t> dropped_{0};
+    std::size_t droppedReported_ = 0;
+
+    std::mutex mutex_;
+    std::condition_variable wakeUp_;
+    std::condition_variable flushed_;
+    bool wakeUpRequested_ = false;
+    bool stop_ = false;
+    std::size_t flushRequested_ = 0;
+    std::size_t flushCompleted_ = 0;
+
+    // writer thread only
+    std::vector<Message> batch_;
+
+    std::thread writer_;
+};
+
+} // namespace data
+} // namespace ore
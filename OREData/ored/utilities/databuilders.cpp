@@ -217,6 +217,7 @@
 #include <ored/portfolio/worstofbasketswap.hpp>
 
 #include <qle/math/basiccpuenvironment.hpp>
+#include <qle/math/cpujitenvironment.hpp>
 #include <qle/math/cudaenvironment.hpp>
 #include <qle/math/openclenvironment.hpp>
 
@@ -595,6 +596,7 @@ void dataBuilders() {
 
     ORE_REGISTER_COMPUTE_FRAMEWORK_CREATOR("OpenCL", QuantExt::OpenClFramework, false);
     ORE_REGISTER_COMPUTE_FRAMEWORK_CREATOR("BasicCpu", QuantExt::BasicCpuFramework, false);
+    ORE_REGISTER_COMPUTE_FRAMEWORK_CREATOR("CpuJit", QuantExt::CpuJitFramework, false);
     ORE_REGISTER_COMPUTE_FRAMEWORK_CREATOR("CUDA", QuantExt::CudaFramework, false);
 }
 
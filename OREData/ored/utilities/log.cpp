@@ -31,6 +31,8 @@
 #include <boost/log/support/date_time.hpp>
 #include <boost/log/sources/severity_feature.hpp>
 #include <boost/phoenix/bind/bind_function.hpp>
+#include <algorithm>
+#include <cstring>
 #include <iomanip>
 #include <ored/utilities/log.hpp>
 #include <ored/utilities/to_string.hpp>
@@ -81,7 +83,8 @@ string BufferLogger::next() {
 
 // -- File Logger
 
-FileLogger::FileLogger(const string& filename) : Logger(name), filename_(filename) {
+FileLogger::FileLogger(const string& filename, const bool autoFlush)
+    : Logger(name), filename_(filename), autoFlush_(autoFlush) {
     fout_.open(filename.c_str(), ios_base::out);
     QL_REQUIRE(fout_.is_open(), "Error opening file " << filename);
     fout_.setf(ios::fixed, ios::floatfield);
@@ -94,8 +97,16 @@ FileLogger::~FileLogger() {
 }
 
 void FileLogger::log(unsigned, const string& msg) {
+    if (fout_.is_open()) {
+        fout_ << msg << '\n';
+        if (autoFlush_)
+            fout_.flush();
+    }
+}
+
+void FileLogger::flush() {
     if (fout_.is_open())
-        fout_ << msg << endl;
+        fout_.flush();
 }
 
 void IndependentLogger::clear() { messages_.clear(); }
@@ -282,6 +293,7 @@ void Log::registerLogger(const QuantLib::ext::shared_ptr<Logger>& logger) {
     QL_REQUIRE(loggers_.find(logger->name()) == loggers_.end(),
                "Logger with name " << logger->name() << " already registered");
     loggers_[logger->name()] = logger;
+    updateLockFreeState();
 }
 
 void Log::registerIndependentLogger(const QuantLib::ext::shared_ptr<IndependentLogger>& logger) {
@@ -324,6 +336,7 @@ void Log::removeLogger(const string& name) {
     map<string, QuantLib::ext::shared_ptr<Logger>>::iterator it = loggers_.find(name);
     if (it != loggers_.end()) {
         loggers_.erase(it);
+        updateLockFreeState();
     } else {
         QL_FAIL("No logger found with name " << name);
     }
@@ -345,28 +358,88 @@ void Log::removeAllLoggers() {
     loggers_.clear();
     logging::core::get()->remove_all_sinks();
     independentLoggers_.clear();
+    updateLockFreeState();
+}
+
+void Log::updateLockFreeState() {
+    std::shared_ptr<const LockFreeState> state;
+    if (!loggers_.empty() &&
+        std::all_of(loggers_.begin(), loggers_.end(), [](const auto& l) { return l.second->threadSafe(); })) {
+        auto s = std::make_shared<LockFreeState>();
+        for (auto const& l : loggers_)
+            s->loggers.push_back(l.second);
+        s->rootPath = rootPath_;
+        s->maxLen = maxLen_;
+        s->pid = pid_;
+        s->sameSourceLocationCutoff = sameSourceLocationCutoff_;
+        state = s;
+    }
+    std::atomic_store(&lockFreeState_, state);
+}
+
+bool Log::logLockFree(unsigned m, const char* filename, int lineNo, const std::string& text) {
+    std::shared_ptr<const LockFreeState> state = std::atomic_load(&lockFreeState_);
+    if (!state)
+        return false;
+
+    // the suppression of repeated messages from the same source location is tracked per thread on this path
+    thread_local const char* lastFileName = nullptr;
+    thread_local int lastLineNo = 0;
+    thread_local std::size_t sameSourceLocationSince = 0;
+    thread_local bool writeSuppressedMessagesHint = true;
+    if (lastLineNo == lineNo && lastFileName != nullptr && std::strcmp(lastFileName, filename) == 0) {
+        ++sameSourceLocationSince;
+    } else {
+        lastFileName = filename;
+        lastLineNo = lineNo;
+        sameSourceLocationSince = 0;
+        writeSuppressedMessagesHint = true;
+    }
+
+    std::string suffix;
+    if (m < ORE_DEBUG && sameSourceLocationSince > state->sameSourceLocationCutoff) {
+        if (!writeSuppressedMessagesHint)
+            return true;
+        if (text.find(StructuredMessage::name) == string::npos) {
+            suffix = " ... suppressing more messages from same source code location (cutoff = " +
+                     std::to_string(state->sameSourceLocationCutoff) + " lines)";
+        }
+        writeSuppressedMessagesHint = false;
+    }
+
+    std::ostringstream os;
+    writeHeader(os, m, source(filename, lineNo, state->rootPath, state->maxLen), state->pid);
+    os << text << suffix;
+    string msg = os.str();
+    for (auto const& l : state->loggers)
+        l->log(m, msg);
+    return true;
 }
 
 string Log::source(const char* filename, int lineNo) const {
+    return source(filename, lineNo, rootPath_, maxLen_);
+}
+
+string Log::source(const char* filename, int lineNo, const boost::filesystem::path& rootPath, const int maxLen) {
     string filepath;
-    if (rootPath_.empty()) {
+    if (rootPath.empty()) {
         filepath = filename;
     } else {
-        filepath = relative(path(filename), rootPath_).string();
+        filepath = relative(path(filename), rootPath).string();
     }
     int lineNoLen = (int)log10((double)lineNo) + 1;      // Length of the int as a string
     int len = 2 + filepath.length() + 1 + lineNoLen + 1; // " (" + file + ':' + line + ')'
 
-    if (maxLen_ == 0) {
+    if (maxLen == 0) {
         return "(" + filepath + ':' + to_string(lineNo) + ')';
     } else {
-        if (len <= maxLen_) {
+        if (len <= maxLen) {
             // pad out spaces
-            return string(maxLen_ - len, ' ') + "(" + filepath + ':' + to_string(lineNo) + ')';
+            return string(maxLen - len, ' ') + "(" + filepath + ':' + to_string(lineNo) + ')';
         } else {
             // need to trim the filename to fit into maxLen chars
-            // need to remove (len - maxLen_) chars + 3 for the "..."
-            return "(..." + filepath.substr(3 + len - maxLen_) + ':' + to_string(lineNo) + ')';
+            // need to remove (len - maxLen) chars + 3 for the "..."
+            return "(..." + filepath.substr(3 + len - maxLen) + ':' + to_string(lineNo) + ')';
         }
     }
 }
@@ -374,14 +447,18 @@ string Log::source(const char* filename, int lineNo) const {
 void Log::addExcludeFilter(const string& key, const std::function<bool(const std::string&)> func) {
     boost::unique_lock<boost::shared_mutex> lock(mutex_);
     excludeFilters_[key] = func;
+    hasExcludeFilters_.store(true, std::memory_order_relaxed);
 }
 
 void Log::removeExcludeFilter(const string& key) {
     boost::unique_lock<boost::shared_mutex> lock(mutex_);
     excludeFilters_.erase(key);
+    hasExcludeFilters_.store(!excludeFilters_.empty(), std::memory_order_relaxed);
 }
 
 bool Log::checkExcludeFilters(const std::string& msg) {
+    if (!hasExcludeFilters_.load(std::memory_order_relaxed))
+        return false;
     boost::shared_lock<boost::shared_mutex> lock(mutex_);
     for (const auto& f : excludeFilters_) {
         if (f.second(msg))
@@ -390,52 +467,56 @@ bool Log::checkExcludeFilters(const std::string& msg) {
     return false;
 }
 
-void Log::header(unsigned m, const char* filename, int lineNo) {
-    // 1. Reset stringstream
-    ls_.str(string());
-    ls_.clear();
-
+void Log::writeHeader(std::ostream& os, unsigned m, const string& source, const int pid) {
     // Write the header to the stream
     // TYPE [Time Stamp] (file:line)
     switch (m) {
     case ORE_ALERT:
-        ls_ << "ALERT    ";
+        os << "ALERT    ";
         break;
     case ORE_CRITICAL:
-        ls_ << "CRITICAL ";
+        os << "CRITICAL ";
         break;
     case ORE_ERROR:
-        ls_ << "ERROR    ";
+        os << "ERROR    ";
         break;
     case ORE_WARNING:
-        ls_ << "WARNING  ";
+        os << "WARNING  ";
         break;
     case ORE_NOTICE:
-        ls_ << "NOTICE   ";
+        os << "NOTICE   ";
         break;
     case ORE_DEBUG:
-        ls_ << "DEBUG    ";
+        os << "DEBUG    ";
         break;
     case ORE_DATA:
-        ls_ << "DATA     ";
+        os << "DATA     ";
         break;
     case ORE_MEMORY:
-        ls_ << "MEMORY   ";
+        os << "MEMORY   ";
         break;
     }
 
     // Timestamp
     // Use boost::posix_time microsecond clock to get better precision (when available).
     // format is "2014-Apr-04 11:10:16.179347"
-    ls_ << '[' << to_simple_string(microsec_clock::local_time()) << ']';
+    os << '[' << to_simple_string(microsec_clock::local_time()) << ']';
 
     // Filename & line no
     // format is " (file:line)"
-    ls_ << "  " << source(filename, lineNo) << " : ";
+    os << "  " << source << " : ";
 
     // log pid if given
-    if (pid_ > 0)
-        ls_ << " [" << pid_ << "] ";
+    if (pid > 0)
+        os << " [" << pid << "] ";
+}
+
+void Log::header(unsigned m, const char* filename, int lineNo) {
+    // 1. Reset stringstream
+    ls_.str(string());
+    ls_.clear();
+
+    writeHeader(ls_, m, source(filename, lineNo), pid_);
 
     // update statistics
     if (lastLineNo_ == lineNo && lastFileName_ == filename) {
@@ -481,7 +562,8 @@ LoggerStream::~LoggerStream() {
     string text;
     while (getline(ss_, text)) {
         // we expand the MLOG macro here so we can overwrite __FILE__ and __LINE__
-        if (ore::data::Log::instance().enabled() && ore::data::Log::instance().filter(mask_)) {
+        if (ore::data::Log::instance().enabled() && ore::data::Log::instance().filter(mask_) &&
+            !ore::data::Log::instance().logLockFree(mask_, filename_, lineNo_, text)) {
             boost::unique_lock<boost::shared_mutex> lock(ore::data::Log::instance().mutex());
             ore::data::Log::instance().header(mask_, filename_, lineNo_);
             ore::data::Log::instance().logStream() << text;
@@ -33,8 +33,10 @@
 #define ORE_DATA 64    // 01000000  127
 #define ORE_MEMORY 128 // 10000000  255
 
+#include <atomic>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <time.h>
 
@@ -53,6 +55,7 @@
 #include <map>
 #include <ql/qldefines.hpp>
 #include <queue>
+#include <vector>
 
 #ifndef BOOST_MSVC
 #include <unistd.h>
@@ -140,6 +143,12 @@ public:
      */
     virtual void log(unsigned level, const std::string& s) = 0;
 
+    //! Writes out buffered messages, if any
+    virtual void flush() {}
+
+    //! Returns true if log() may be called from several threads at the same time
+    virtual bool threadSafe() const { return false; }
+
     //! Returns the Logger name
     const std::string& name() { return name_; }
 
@@ -186,7 +195,8 @@ private:
 //! FileLogger
 /*!
   This logger writes each log message out to the given file.
-  The file is flushed, but not closed, after each log message.
+  If autoFlush is true, the file is flushed, but not closed, after each log message. Otherwise the file is only
+  flushed in flush(), this is meant for use as the target of an AsyncLogger which flushes once per batch of messages.
   \ingroup utilities
   \see Log
  */
@@ -199,15 +209,19 @@ public:
       Construct a file logger using the given filename, this filename is passed to std::fostream::open()
       and this constructor will throw an exception if the file is not opened (e.g. if the filename is invalid)
       \param filename the log filename
+      \param autoFlush flush the file after each log message
      */
-    FileLogger(const std::string& filename);
+    FileLogger(const std::string& filename, const bool autoFlush = true);
     //! Destructor
     virtual ~FileLogger();
     //! The log callback
     virtual void log(unsigned, const std::string&) override;
+    //! Flushes the file
+    virtual void flush() override;
 
 private:
     std::string filename_;
+    bool autoFlush_;
     std::fstream fout_;
 };
 
@@ -362,7 +376,10 @@ private:
   Once a message is received, it is immediately dispatched to each of the registered loggers, the order in which
   the loggers are called is not guaranteed.
 
-  Logging is done by the calling thread and the LOG call blocks until all the loggers have returned.
+  Logging is done by the calling thread and the LOG call blocks until all the loggers have returned. To move the
+  writing of the messages off the calling threads, wrap a logger into an AsyncLogger before registering it.
+
+  Checking whether logging is enabled for a level does not acquire a lock, so disabled LOG() calls are cheap.
 
   At start up, the Log class has no loggers and so will ignore any LOG() messages until it is configured.
 
@@ -445,23 +462,20 @@ public:
     std::ostream& logStream() { return ls_; }
     //! macro utility function - do not use directly, not thread safe
     void log(unsigned m);
+    /*! macro utility function - do not use directly. If all registered loggers are thread safe, formats and dispatches
+        the message without taking the Log mutex and returns true, otherwise returns false. */
+    bool logLockFree(unsigned m, const char* filename, int lineNo, const std::string& text);
 
     //! mutex to acquire locks
     boost::shared_mutex& mutex() { return mutex_; }
 
+    /* enabled() and filter() are checked for every log message before anything else is done, the flags are atomic
+       so that disabled levels can be skipped without taking a lock */
+
     // Avoid a large number of warnings in VS by adding 0 !=
-    bool filter(unsigned mask) {
-        boost::shared_lock<boost::shared_mutex> lock(mutex());
-        return 0 != (mask & mask_);
-    }
-    unsigned mask() {
-        boost::shared_lock<boost::shared_mutex> lock(mutex());
-        return mask_;
-    }
-    void setMask(unsigned mask) {
-        boost::unique_lock<boost::shared_mutex> lock(mutex());
-        mask_ = mask;
-    }
+    bool filter(unsigned mask) { return 0 != (mask & mask_.load(std::memory_order_relaxed)); }
+    unsigned mask() { return mask_.load(std::memory_order_relaxed); }
+    void setMask(unsigned mask) { mask_.store(mask, std::memory_order_relaxed); }
     const boost::filesystem::path& rootPath() {
         boost::shared_lock<boost::shared_mutex> lock(mutex());
         return rootPath_;
@@ -469,6 +483,7 @@ public:
     void setRootPath(const boost::filesystem::path& pth) {
         boost::unique_lock<boost::shared_mutex> lock(mutex());
         rootPath_ = pth;
+        updateLockFreeState();
     }
     int maxLen() {
         boost::shared_lock<boost::shared_mutex> lock(mutex());
@@ -477,20 +492,12 @@ public:
     void setMaxLen(const int n) {
         boost::unique_lock<boost::shared_mutex> lock(mutex());
         maxLen_ = n;
+        updateLockFreeState();
     }
 
-    bool enabled() {
-        boost::shared_lock<boost::shared_mutex> lock(mutex());
-        return enabled_;
-    }
-    void switchOn() {
-        boost::unique_lock<boost::shared_mutex> lock(mutex());
-        enabled_ = true;
-    }
-    void switchOff() {
-        boost::unique_lock<boost::shared_mutex> lock(mutex());
-        enabled_ = false;
-    }
+    bool enabled() { return enabled_.load(std::memory_order_relaxed); }
+    void switchOn() { enabled_.store(true, std::memory_order_relaxed); }
+    void switchOff() { enabled_.store(false, std::memory_order_relaxed); }
 
     bool writeSuppressedMessagesHint() {
         boost::shared_lock<boost::shared_mutex> lock(mutex());
@@ -498,18 +505,36 @@ public:
     }
 
     //! if a PID is set for the logger, messages are tagged with [1234] if pid = 1234
-    void setPid(const int pid) { pid_ = pid; }
+    void setPid(const int pid) {
+        boost::unique_lock<boost::shared_mutex> lock(mutex());
+        pid_ = pid;
+        updateLockFreeState();
+    }
 
 private:
     Log();
 
     // not thread safe
     std::string source(const char* filename, int lineNo) const;
+    static std::string source(const char* filename, int lineNo, const boost::filesystem::path& rootPath,
+                              const int maxLen);
+    static void writeHeader(std::ostream& os, unsigned m, const std::string& source, const int pid);
+
+    /* immutable copy of the loggers and header settings used by logLockFree(), only set if all loggers are thread
+       safe, replaced under the unique lock whenever one of them changes */
+    struct LockFreeState {
+        std::vector<QuantLib::ext::shared_ptr<Logger>> loggers;
+        boost::filesystem::path rootPath;
+        int maxLen;
+        int pid;
+        std::size_t sameSourceLocationCutoff;
+    };
+    void updateLockFreeState();
 
     std::map<std::string, QuantLib::ext::shared_ptr<Logger>> loggers_;
     std::map<std::string, QuantLib::ext::shared_ptr<IndependentLogger>> independentLoggers_;
-    bool enabled_;
-    unsigned mask_;
+    std::atomic<bool> enabled_;
+    std::atomic<unsigned> mask_;
     boost::filesystem::path rootPath_;
     std::ostringstream ls_;
 
@@ -525,6 +550,9 @@ private:
     mutable boost::shared_mutex mutex_;
 
     std::map<std::string, std::function<bool(const std::string&)>> excludeFilters_;
+    std::atomic<bool> hasExcludeFilters_{false};
+
+    std::shared_ptr<const LockFreeState> lockFreeState_;
 };
 
 /*!
@@ -535,7 +563,9 @@ private:
         if (ore::data::Log::instance().enabled() && ore::data::Log::instance().filter(mask)) {                         \
             std::ostringstream __ore_mlog_tmp_stringstream__;                                                          \
             __ore_mlog_tmp_stringstream__ << text;                                                                     \
-            if (!ore::data::Log::instance().checkExcludeFilters(__ore_mlog_tmp_stringstream__.str())) {                \
+            if (!ore::data::Log::instance().checkExcludeFilters(__ore_mlog_tmp_stringstream__.str()) &&                \
+                !ore::data::Log::instance().logLockFree(mask, __FILE__, __LINE__,                                      \
+                                                        __ore_mlog_tmp_stringstream__.str())) {                        \
                 boost::unique_lock<boost::shared_mutex> lock(ore::data::Log::instance().mutex());                      \
                 ore::data::Log::instance().header(mask, __FILE__, __LINE__);                                           \
                 ore::data::Log::instance().logStream() << __ore_mlog_tmp_stringstream__.str();                         \
@@ -0,0 +1,98 @@
+/*
+ Copyright (C) 2025 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+#include <ored/utilities/workerthreadstate.hpp>
+
+#include <ql/indexes/indexmanager.hpp>
+
+using namespace QuantLib;
+
+namespace ore {
+namespace data {
+
+namespace {
+// passes the notifications of an observable of the calling thread on to the corresponding worker thread observables
+class NotificationForwarder : public Observer {
+public:
+    NotificationForwarder(const QuantLib::ext::shared_ptr<Observable>& source,
+                          std::vector<QuantLib::ext::shared_ptr<Observable>> targets)
+        : targets_(std::move(targets)) {
+        registerWith(source);
+    }
+    void update() override {
+        for (auto const& t : targets_)
+            t->notifyObservers();
+    }
+
+private:
+    std::vector<QuantLib::ext::shared_ptr<Observable>> targets_;
+};
+} // namespace
+
+WorkerThreadState WorkerThreadState::fromCurrentThread() {
+    WorkerThreadState s;
+    s.evaluationDate_ = Settings::instance().evaluationDate();
+    s.includeReferenceDateEvents_ = Settings::instance().includeReferenceDateEvents();
+    s.includeTodaysCashFlows_ = Settings::instance().includeTodaysCashFlows();
+    s.enforcesTodaysHistoricFixings_ = Settings::instance().enforcesTodaysHistoricFixings();
+    s.updatesEnabled_ = ObservableSettings::instance().updatesEnabled();
+    s.updatesDeferred_ = ObservableSettings::instance().updatesDeferred();
+    for (auto const& name : IndexManager::instance().histories())
+        s.fixings_.push_back(std::make_pair(name, IndexManager::instance().getHistory(name)));
+    return s;
+}
+
+void WorkerThreadState::apply() const {
+    Settings::instance().evaluationDate() = evaluationDate_;
+    Settings::instance().includeReferenceDateEvents() = includeReferenceDateEvents_;
+    Settings::instance().includeTodaysCashFlows() = includeTodaysCashFlows_;
+    Settings::instance().enforcesTodaysHistoricFixings() = enforcesTodaysHistoricFixings_;
+    if (updatesEnabled_)
+        ObservableSettings::instance().enableUpdates();
+    else
+        ObservableSettings::instance().disableUpdates(updatesDeferred_);
+    for (auto const& f : fixings_)
+        IndexManager::instance().setHistory(f.first, f.second);
+}
+
+std::vector<QuantLib::ext::shared_ptr<Observable>> WorkerThreadState::observables() const {
+    std::vector<QuantLib::ext::shared_ptr<Observable>> result;
+    result.push_back(static_cast<QuantLib::ext::shared_ptr<Observable>>(Settings::instance().evaluationDate()));
+    for (auto const& f : fixings_)
+        result.push_back(IndexManager::instance().notifier(f.first));
+    return result;
+}
+
+std::vector<QuantLib::ext::shared_ptr<Observer>> WorkerThreadState::notificationForwarders(
+    const std::vector<std::vector<QuantLib::ext::shared_ptr<Observable>>>& workerObservables) const {
+    std::vector<QuantLib::ext::shared_ptr<Observer>> result;
+    std::vector<QuantLib::ext::shared_ptr<Observable>> sources = observables();
+    for (Size k = 0; k < sources.size(); ++k) {
+        std::vector<QuantLib::ext::shared_ptr<Observable>> targets;
+        for (auto const& o : workerObservables) {
+            if (!o.empty())
+                targets.push_back(o[k]);
+        }
+        if (!targets.empty())
+            result.push_back(QuantLib::ext::make_shared<NotificationForwarder>(sources[k], std::move(targets)));
+    }
+    return result;
+}
+
+} // namespace data
+} // namespace ore
@@ -0,0 +1,74 @@
+/*
+ Copyright (C) 2025 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+/*! \file ored/utilities/workerthreadstate.hpp
+    \brief copy the thread local QuantLib singletons of a thread to worker threads
+    \ingroup utilities
+*/
+
+#pragma once
+
+#include <ql/patterns/observable.hpp>
+#include <ql/settings.hpp>
+#include <ql/time/date.hpp>
+#include <ql/timeseries.hpp>
+
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ore {
+namespace data {
+
+//! State of the thread local QuantLib singletons of a thread
+/*! If QuantLib is built with sessions, the settings, the observable settings and the index manager are thread local.
+    A worker thread that builds or prices market objects or trades on behalf of another thread needs the same state,
+    i.e. the state is taken with fromCurrentThread() on the calling thread and applied on each worker thread.
+
+    \ingroup utilities
+*/
+class WorkerThreadState {
+public:
+    //! The state of the current thread
+    static WorkerThreadState fromCurrentThread();
+    //! Set the state on the current thread
+    void apply() const;
+    /*! The observables of the current thread's singletons that market objects register with, i.e. the evaluation date
+        and the notifiers of the indices with fixings, in the same order on each thread */
+    std::vector<QuantLib::ext::shared_ptr<QuantLib::Observable>> observables() const;
+    /*! Observers passing the notifications of the observables() of the current thread on to the corresponding
+        observables of the worker threads, as returned by observables() on each worker, empty entries are skipped. The
+        observers have to be kept alive as long as the objects built on the worker threads are used. */
+    std::vector<QuantLib::ext::shared_ptr<QuantLib::Observer>> notificationForwarders(
+        const std::vector<std::vector<QuantLib::ext::shared_ptr<QuantLib::Observable>>>& workerObservables) const;
+
+    const QuantLib::Date& evaluationDate() const { return evaluationDate_; }
+
+private:
+    QuantLib::Date evaluationDate_;
+    bool includeReferenceDateEvents_ = false;
+    std::decay_t<decltype(QuantLib::Settings::instance().includeTodaysCashFlows())> includeTodaysCashFlows_;
+    bool enforcesTodaysHistoricFixings_ = false;
+    bool updatesEnabled_ = true;
+    bool updatesDeferred_ = false;
+    std::vector<std::pair<std::string, QuantLib::TimeSeries<QuantLib::Real>>> fixings_;
+};
+
+} // namespace data
+} // namespace ore
@@ -0,0 +1,218 @@
+/*
+ Copyright (C) 2025 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+#include <boost/test/unit_test.hpp>
+
+#include <ored/utilities/asynclogger.hpp>
+
+#include <oret/toplevelfixture.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+using namespace ore::data;
+using namespace QuantLib;
+
+namespace {
+
+// collects the messages, log() can be made to wait until open() is called
+class CollectingLogger : public Logger {
+public:
+    CollectingLogger(bool closed = false) : Logger("CollectingLogger"), closed_(closed) {}
+    void log(unsigned level, const std::string& s) override {
+        std::unique_lock<std::mutex> lock(mutex_);
+        gate_.wait(lock, [this] { return !closed_; });
+        levels_.push_back(level);
+        messages_.push_back(s);
+    }
+    void flush() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++flushes_;
+    }
+    void open() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = false;
+        }
+        gate_.notify_all();
+    }
+    std::vector<unsigned> levels_;
+    std::vector<std::string> messages_;
+    Size flushes_ = 0;
+
+private:
+    std::mutex mutex_;
+    std::condition_variable gate_;
+    bool closed_;
+};
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(OREDataTestSuite, ore::test::TopLevelFixture)
+
+BOOST_AUTO_TEST_SUITE(AsyncLoggerTest)
+
+BOOST_AUTO_TEST_CASE(testMessagesFromSeveralThreads) {
+
+    BOOST_TEST_MESSAGE("Testing AsyncLogger with several logging threads and a small buffer...");
+
+    const Size nThreads = 4, nMessages = 20000;
+    auto target = QuantLib::ext::make_shared<CollectingLogger>();
+    {
+        // the buffer is small enough to exercise the blocking overflow policy
+        AsyncLogger logger(target, 64);
+        BOOST_CHECK_EQUAL(logger.name(), target->name());
+        std::vector<std::thread> threads;
+        for (Size t = 0; t < nThreads; ++t) {
+            threads.emplace_back([&logger, t, nMessages] {
+                for (Size i = 0; i < nMessages; ++i)
+                    logger.log(ORE_DEBUG, std::to_string(t) + " " + std::to_string(i));
+            });
+        }
+        for (auto& t : threads)
+            t.join();
+        logger.flush();
+        BOOST_CHECK_EQUAL(target->messages_.size(), nThreads * nMessages);
+        BOOST_CHECK(target->flushes_ > 0);
+        BOOST_CHECK_EQUAL(logger.dropped(), 0);
+        // a message logged after the threads are gone is still written on destruction
+        logger.log(ORE_NOTICE, "last");
+    }
+
+    BOOST_REQUIRE_EQUAL(target->messages_.size(), nThreads * nMessages + 1);
+    BOOST_CHECK_EQUAL(target->messages_.back(), "last");
+    BOOST_CHECK_EQUAL(target->levels_.back(), unsigned(ORE_NOTICE));
+
+    // the messages of each thread are written in the order in which they were logged
+    std::vector<Size> next(nThreads, 0);
+    for (Size i = 0; i < nThreads * nMessages; ++i) {
+        const std::string& m = target->messages_[i];
+        Size t = std::stoul(m.substr(0, m.find(' ')));
+        BOOST_REQUIRE(t < nThreads);
+        BOOST_CHECK_EQUAL(std::stoul(m.substr(m.find(' ') + 1)), next[t]);
+        ++next[t];
+    }
+}
+
+BOOST_AUTO_TEST_CASE(testDropOverflowPolicy) {
+
+    BOOST_TEST_MESSAGE("Testing AsyncLogger drop overflow policy...");
+
+    const Size bufferSize = 16, nMessages = 200;
+    auto target = QuantLib::ext::make_shared<CollectingLogger>(true);
+    Size dropped;
+    {
+        AsyncLogger logger(target, bufferSize, AsyncLogger::OverflowPolicy::Drop);
+        // the target blocks the writer thread, so the buffer fills up and debug messages are dropped
+        for (Size i = 0; i < nMessages; ++i)
+            logger.log(ORE_DEBUG, std::to_string(i));
+        BOOST_CHECK(logger.dropped() > 0);
+        BOOST_CHECK(logger.dropped() <= nMessages - bufferSize);
+        target->open();
+        logger.flush();
+        // errors are never dropped
+        for (Size i = 0; i < 4 * bufferSize; ++i)
+            logger.log(ORE_ERROR, "error");
+        dropped = logger.dropped();
+    }
+
+    BOOST_REQUIRE_EQUAL(target->messages_.size(), nMessages - dropped + 1 + 4 * bufferSize);
+    Size droppedMessage = 0;
+    for (Size i = 0; i < target->messages_.size(); ++i) {
+        if (target->messages_[i].find("log messages dropped") != std::string::npos) {
+            BOOST_CHECK_EQUAL(target->messages_[i],
+                              "AsyncLogger: " + std::to_string(dropped) +
+                                  " log messages dropped, because the buffer was full");
+            BOOST_CHECK_EQUAL(target->levels_[i], unsigned(ORE_WARNING));
+            ++droppedMessage;
+        }
+    }
+    BOOST_CHECK_EQUAL(droppedMessage, 1);
+}
+
+BOOST_AUTO_TEST_CASE(testLoggingMacrosFromSeveralThreads) {
+
+    BOOST_TEST_MESSAGE("Testing the logging macros with an AsyncLogger from several threads...");
+
+    const Size nThreads = 4, nMessages = 5000;
+    auto target = QuantLib::ext::make_shared<CollectingLogger>();
+    bool enabled = Log::instance().enabled();
+    unsigned mask = Log::instance().mask();
+    Log::instance().registerLogger(QuantLib::ext::make_shared<AsyncLogger>(target, 64));
+    Log::instance().switchOn();
+    Log::instance().setMask(255);
+
+    // if only thread safe loggers are registered, the macros must not take the Log mutex, so they have to complete
+    // while another thread holds it
+    bool lockFree = Log::instance().logLockFree(ORE_NOTICE, __FILE__, __LINE__, "probe");
+    std::atomic<Size> finished{0};
+    std::vector<std::thread> threads;
+    {
+        boost::unique_lock<boost::shared_mutex> lock(Log::instance().mutex(), boost::defer_lock);
+        if (lockFree)
+            lock.lock();
+        else
+            BOOST_TEST_MESSAGE("other loggers are registered, the Log mutex is not held while logging");
+        for (Size t = 0; t < nThreads; ++t) {
+            threads.emplace_back([&finished, t, nMessages] {
+                for (Size i = 0; i < nMessages; ++i)
+                    DLOG("thread " << t << " message " << i);
+                ++finished;
+            });
+        }
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(60);
+        while (finished.load() < nThreads && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        BOOST_CHECK_EQUAL(finished.load(), nThreads);
+    }
+    for (auto& t : threads)
+        t.join();
+
+    Log::instance().logger(target->name())->flush();
+    Log::instance().removeLogger(target->name());
+    Log::instance().setMask(mask);
+    if (!enabled)
+        Log::instance().switchOff();
+
+    // each message carries the usual header and the messages of each thread arrive in order
+    Size probe = lockFree ? 1 : 0;
+    BOOST_REQUIRE_EQUAL(target->messages_.size(), nThreads * nMessages + probe);
+    std::vector<Size> next(nThreads, 0);
+    for (Size i = probe; i < target->messages_.size(); ++i) {
+        const std::string& m = target->messages_[i];
+        BOOST_CHECK_EQUAL(m.substr(0, 9), "DEBUG    ");
+        BOOST_CHECK(m.find("asynclogger.cpp") != std::string::npos);
+        Size pos = m.find("thread ");
+        BOOST_REQUIRE(pos != std::string::npos);
+        std::istringstream is(m.substr(pos));
+        std::string word1, word2;
+        Size t, n;
+        is >> word1 >> t >> word2 >> n;
+        BOOST_REQUIRE(t < nThreads);
+        BOOST_CHECK_EQUAL(n, next[t]);
+        ++next[t];
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE_END()
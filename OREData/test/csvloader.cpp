@@ -0,0 +1,181 @@
+/*
+ Copyright (C) 2025 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+#include <oret/toplevelfixture.hpp>
+
+#include <ored/marketdata/csvloader.hpp>
+
+#include <ql/settings.hpp>
+
+#include <fstream>
+#include <sstream>
+
+using namespace ore::data;
+using namespace QuantLib;
+
+namespace {
+
+std::string tempFile(const std::string& content) {
+    std::string file = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string();
+    std::ofstream os(file, std::ios::binary);
+    os << content;
+    return file;
+}
+
+std::string toString(const std::set<QuantLib::ext::shared_ptr<MarketDatum>>& quotes) {
+    std::map<std::string, Real> values;
+    for (auto const& q : quotes)
+        values[q->name()] = q->quote()->value();
+    std::ostringstream result;
+    for (auto const& [n, v] : values)
+        result << n << ":" << v << " ";
+    return result.str();
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(OREDataTestSuite, ore::test::TopLevelFixture)
+
+BOOST_AUTO_TEST_SUITE(CSVLoaderTest)
+
+BOOST_AUTO_TEST_CASE(testLoad) {
+
+    BOOST_TEST_MESSAGE("Testing CSVLoader...");
+
+    Settings::instance().evaluationDate() = Date(10, January, 2024);
+
+    // comments, blank lines, different separators, windows line endings, duplicates and an fx quote and its inverse
+    std::string market = "# market data\n"
+                         "2024-01-10 MM/RATE/EUR/0D/1D 0.01\n"
+                         "\n"
+                         "  2024-01-10,MM/RATE/EUR/2D/6M,0.02\r\n"
+                         "2024-01-10;\tIR_SWAP/RATE/EUR/2D/6M/2Y;0.03\n"
+                         "2024-01-10 MM/RATE/EUR/0D/1D 0.04\n"
+                         "2024-01-10 FX/RATE/USD/EUR 0.9\n"
+                         "2024-01-10 FX/RATE/EUR/USD 1.1\n"
+                         "2024-01-10 FX/RATE/USD/EUR 0.8\n"
+                         "2024-01-10 INVALID/QUOTE 1.0\n"
+                         "2024-01-09 MM/RATE/EUR/0D/1D 0.05";
+    std::string fixings = "2024-01-08 EUR-EONIA 0.01\n"
+                          "2024-01-09 EUR-EONIA 0.02\n"
+                          "2024-01-05 EUR-EURIBOR-6M 0.03\n"
+                          "2024-01-08 EUR-EONIA 0.04\n"
+                          "2024-01-10 EUR-EONIA 0.05\n"
+                          "2024-01-04 EUR-EONIA 0.06\n";
+    std::string dividends = "2024-01-05 SP5 0.1 2024-01-08\n"
+                            "2024-01-06 SP5 0.2\n";
+    std::string marketFile = tempFile(market), fixingFile = tempFile(fixings), dividendFile = tempFile(dividends);
+
+    for (Size nThreads : {1, 4}) {
+        BOOST_TEST_MESSAGE("threads = " << nThreads);
+        CSVLoader loader(marketFile, fixingFile, dividendFile, true, Date(), nThreads);
+
+        Date d(10, January, 2024);
+        BOOST_CHECK_EQUAL(loader.asofDates().size(), 2);
+        BOOST_CHECK(loader.hasQuotes(d));
+        BOOST_CHECK(!loader.hasQuotes(Date(11, January, 2024)));
+        BOOST_CHECK_EQUAL(loader.loadQuotes(d).size(), 4);
+        BOOST_CHECK_EQUAL(loader.loadQuotes(Date(9, January, 2024)).size(), 1);
+
+        // the first quote is kept for duplicates, the dominant fx quote is kept
+        BOOST_CHECK_CLOSE(loader.get("MM/RATE/EUR/0D/1D", d)->quote()->value(), 0.01, 1E-10);
+        BOOST_CHECK_CLOSE(loader.get("MM/RATE/EUR/0D/1D", Date(9, January, 2024))->quote()->value(), 0.05, 1E-10);
+        BOOST_CHECK_CLOSE(loader.get("FX/RATE/EUR/USD", d)->quote()->value(), 1.1, 1E-10);
+        BOOST_CHECK(!loader.has("FX/RATE/USD/EUR", d));
+        BOOST_CHECK(!loader.has("INVALID/QUOTE", d));
+        BOOST_CHECK_THROW(loader.get("MM/RATE/EUR/2D/3M", d), QuantLib::Error);
+
+        BOOST_CHECK_EQUAL(toString(loader.get(std::set<std::string>{"MM/RATE/EUR/2D/6M", "MM/RATE/EUR/2D/3M"}, d)),
+                          "MM/RATE/EUR/2D/6M:0.02 ");
+        BOOST_CHECK_EQUAL(toString(loader.get(Wildcard("MM/RATE/EUR/*"), d)),
+                          "MM/RATE/EUR/0D/1D:0.01 MM/RATE/EUR/2D/6M:0.02 ");
+        BOOST_CHECK_EQUAL(toString(loader.get(Wildcard("*/EUR/2D/*"), d)),
+                          "IR_SWAP/RATE/EUR/2D/6M/2Y:0.03 MM/RATE/EUR/2D/6M:0.02 ");
+        BOOST_CHECK_EQUAL(toString(loader.get(Wildcard("MM/RATE/*/6M"), d)), "MM/RATE/EUR/2D/6M:0.02 ");
+        BOOST_CHECK_EQUAL(toString(loader.get(Wildcard("MM/RATE/USD/*"), d)), "");
+        BOOST_CHECK_EQUAL(toString(loader.get(Wildcard("FX/RATE/EUR/USD"), d)), "FX/RATE/EUR/USD:1.1 ");
+
+        // today's fixing is implied, i.e. not loaded, the first fixing is kept for duplicates
+        auto f = loader.loadFixings();
+        BOOST_CHECK_EQUAL(f.size(), 4);
+        BOOST_CHECK_CLOSE(loader.getFixing("EUR-EONIA", Date(8, January, 2024)).fixing, 0.01, 1E-10);
+        BOOST_CHECK_CLOSE(loader.getFixing("EUR-EONIA", Date(4, January, 2024)).fixing, 0.06, 1E-10);
+        BOOST_CHECK_CLOSE(loader.getFixing("EUR-EURIBOR-6M", Date(5, January, 2024)).fixing, 0.03, 1E-10);
+        BOOST_CHECK(loader.hasFixing("EUR-EONIA", Date(9, January, 2024)));
+        BOOST_CHECK(!loader.hasFixing("EUR-EONIA", Date(10, January, 2024)));
+        BOOST_CHECK(!loader.hasFixing("EUR-EURIBOR-3M", Date(5, January, 2024)));
+
+        auto div = loader.loadDividends();
+        BOOST_REQUIRE_EQUAL(div.size(), 2);
+        BOOST_CHECK_EQUAL(div.begin()->payDate, Date(8, January, 2024));
+    }
+
+    // a line with a wrong number of tokens is an error
+    std::string invalidFile = tempFile(market + "\n2024-01-10 MM/RATE/EUR/0D/1D\n");
+    BOOST_CHECK_THROW(CSVLoader(invalidFile, fixingFile, false, Date(), 4), QuantLib::Error);
+    BOOST_CHECK_THROW(CSVLoader(marketFile + "_missing", fixingFile), QuantLib::Error);
+
+    for (auto const& f : {marketFile, fixingFile, dividendFile, invalidFile})
+        boost::filesystem::remove(f);
+}
+
+BOOST_AUTO_TEST_CASE(testParallelLoad) {
+
+    BOOST_TEST_MESSAGE("Testing CSVLoader on several threads...");
+
+    Settings::instance().evaluationDate() = Date(10, January, 2024);
+
+    std::ostringstream market, fixings;
+    std::vector<std::string> tenors = {"1M", "3M", "6M", "1Y", "2Y", "5Y", "10Y"};
+    for (Size i = 0; i < 20000; ++i) {
+        Date d = Date(10, January, 2024) - static_cast<Integer>(i % 13);
+        market << io::iso_date(d) << " MM/RATE/EUR/2D/" << tenors[i % tenors.size()] << " " << i << "\n";
+        market << io::iso_date(d) << " IR_SWAP/RATE/EUR/2D/6M/" << tenors[(i / 3) % tenors.size()] << " " << i
+               << "\n";
+        fixings << io::iso_date(d - 1) << " EUR-EURIBOR-" << tenors[i % 3] << " " << i << "\n";
+    }
+    std::string marketFile = tempFile(market.str()), fixingFile = tempFile(fixings.str());
+
+    CSVLoader serial(marketFile, fixingFile, false, Date(), 1);
+    CSVLoader parallel(marketFile, fixingFile, false, Date(), 8);
+    boost::filesystem::remove(marketFile);
+    boost::filesystem::remove(fixingFile);
+
+    BOOST_CHECK(parallel.asofDates() == serial.asofDates());
+    for (auto const& d : serial.asofDates()) {
+        std::set<QuantLib::ext::shared_ptr<MarketDatum>> s, p;
+        for (auto const& q : serial.loadQuotes(d))
+            s.insert(q);
+        for (auto const& q : parallel.loadQuotes(d))
+            p.insert(q);
+        BOOST_CHECK_EQUAL(toString(p), toString(s));
+    }
+    auto s = serial.loadFixings(), p = parallel.loadFixings();
+    BOOST_REQUIRE_EQUAL(p.size(), s.size());
+    for (auto i = s.begin(), j = p.begin(); i != s.end(); ++i, ++j) {
+        BOOST_CHECK_EQUAL(j->name, i->name);
+        BOOST_CHECK_EQUAL(j->date, i->date);
+        BOOST_CHECK_EQUAL(j->fixing, i->fixing);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,212 @@
+/*
+ Copyright (C) 2025 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+#include <boost/test/unit_test.hpp>
+
+#include <ored/report/csvreport.hpp>
+#include <ored/report/inmemoryreport.hpp>
+
+#include <oret/toplevelfixture.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+#include <sstream>
+
+using namespace ore::data;
+using namespace QuantLib;
+
+namespace {
+
+void fillReport(Report& report, const Size rows) {
+    report.addColumn("TradeId", string())
+        .addColumn("Index", Size())
+        .addColumn("Value", Real(), 4)
+        .addColumn("Scientific", Real(), 6, true)
+        .addColumn("Date", Date())
+        .addColumn("Tenor", Period())
+        .addColumn("Currency", string());
+    for (Size i = 0; i < rows; ++i) {
+        report.next()
+            .add("trade_" + std::to_string(i % 97))
+            .add(i % 13 == 0 ? Size(Null<Size>()) : i)
+            .add(i * 0.123456789 - 1000.0)
+            .add(i % 17 == 0 ? Real(Null<Real>()) : i * 1.7E-3)
+            .add(i % 5 == 0 ? Date() : Date(1, Jan, 2025) + i % 1000)
+            .add(Period(i % 12, Months))
+            .add(i % 3 == 0 ? string("EUR,USD") : string("USD"));
+    }
+    report.end();
+}
+
+string readFile(const string& fileName) {
+    std::ifstream is(fileName);
+    std::stringstream s;
+    s << is.rdbuf();
+    return s.str();
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(OREDataTestSuite, ore::test::TopLevelFixture)
+
+BOOST_AUTO_TEST_SUITE(InMemoryReportTest)
+
+BOOST_AUTO_TEST_CASE(testDataAccess) {
+
+    BOOST_TEST_MESSAGE("Testing InMemoryReport data access with and without buffering...");
+
+    Size rows = 2503;
+    InMemoryReport report, bufferedReport(100);
+    fillReport(report, rows);
+    fillReport(bufferedReport, rows);
+
+    BOOST_REQUIRE_EQUAL(report.rows(), rows);
+    BOOST_REQUIRE_EQUAL(bufferedReport.rows(), rows);
+    BOOST_REQUIRE_EQUAL(report.columns(), Size(7));
+    BOOST_CHECK_EQUAL(report.distinctStrings(), Size(99));
+
+    for (Size j = 0; j < rows; ++j) {
+        BOOST_CHECK_EQUAL(boost::get<string>(report.data(0, j)), "trade_" + std::to_string(j % 97));
+        BOOST_CHECK_EQUAL(boost::get<Real>(report.data(2, j)), j * 0.123456789 - 1000.0);
+        for (Size i = 0; i < report.columns(); ++i)
+            BOOST_CHECK(report.data(i, j) == bufferedReport.data(i, j));
+    }
+
+    InMemoryReport combined;
+    combined.addColumn("TradeId", string())
+        .addColumn("Index", Size())
+        .addColumn("Value", Real(), 4)
+        .addColumn("Scientific", Real(), 6, true)
+        .addColumn("Date", Date())
+        .addColumn("Tenor", Period())
+        .addColumn("Currency", string());
+    combined.add(bufferedReport);
+    BOOST_REQUIRE_EQUAL(combined.rows(), rows);
+    for (Size i = 0; i < combined.columns(); ++i)
+        BOOST_CHECK(combined.data(i, rows - 1) == report.data(i, rows - 1));
+}
+
+BOOST_AUTO_TEST_CASE(testToFile) {
+
+    BOOST_TEST_MESSAGE("Testing InMemoryReport::toFile() against CSVFileReport...");
+
+    // enough rows to format the report on several threads
+    Size rows = 250003;
+    auto dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    boost::filesystem::create_directories(dir);
+    string expectedFile = (dir / "expected.csv").string();
+    string serialFile = (dir / "serial.csv").string();
+    string parallelFile = (dir / "parallel.csv").string();
+
+    {
+        CSVFileReport csvReport(expectedFile);
+        fillReport(csvReport, rows);
+    }
+
+    InMemoryReport serialReport(10000);
+    fillReport(serialReport, rows);
+    serialReport.setThreads(1);
+    serialReport.toFile(serialFile);
+
+    InMemoryReport parallelReport;
+    fillReport(parallelReport, rows);
+    parallelReport.setThreads(4);
+    parallelReport.toFile(parallelFile);
+
+    string expected = readFile(expectedFile);
+    BOOST_CHECK(!expected.empty());
+    BOOST_CHECK(readFile(serialFile) == expected);
+    BOOST_CHECK(readFile(parallelFile) == expected);
+
+    boost::filesystem::remove_all(dir);
+}
+
+BOOST_AUTO_TEST_CASE(testCopyThenAdd) {
+
+    BOOST_TEST_MESSAGE("Testing InMemoryReport copies outliving their source...");
+
+    for (Size bufferSize : {0, 100}) {
+        Size rows = 250;
+        auto source = QuantLib::ext::make_shared<InMemoryReport>(bufferSize);
+        fillReport(*source, rows);
+        InMemoryReport copy(*source);
+        InMemoryReport assigned;
+        assigned = *source;
+        source.reset();
+
+        // the copies must not refer to the dictionary or the buffer files of the destroyed source
+        for (InMemoryReport* r : {&copy, &assigned}) {
+            Size distinct = r->distinctStrings();
+            r->next().add("trade_5").add(Size(1)).add(1.0).add(2.0).add(Date(1, Jan, 2025)).add(1 * Years).add("USD");
+            r->next().add("new_trade").add(Size(2)).add(3.0).add(4.0).add(Date(2, Jan, 2025)).add(2 * Years).add("GBP");
+            r->end();
+            BOOST_CHECK_EQUAL(r->distinctStrings(), distinct + 2);
+            BOOST_REQUIRE_EQUAL(r->rows(), rows + 2);
+            BOOST_CHECK_EQUAL(boost::get<string>(r->data(0, 5)), "trade_5");
+            BOOST_CHECK_EQUAL(boost::get<string>(r->data(6, 3)), "EUR,USD");
+            BOOST_CHECK_EQUAL(boost::get<Size>(r->data(1, 1)), 1);
+            BOOST_CHECK_EQUAL(boost::get<string>(r->data(0, rows)), "trade_5");
+            BOOST_CHECK_EQUAL(boost::get<string>(r->data(0, rows + 1)), "new_trade");
+            BOOST_CHECK_EQUAL(boost::get<string>(r->data(6, rows + 1)), "GBP");
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(testMoveThenAdd) {
+
+    BOOST_TEST_MESSAGE("Testing moved InMemoryReports...");
+
+    for (Size bufferSize : {0, 100}) {
+        Size rows = 250;
+        auto source1 = QuantLib::ext::make_shared<InMemoryReport>(bufferSize);
+        auto source2 = QuantLib::ext::make_shared<InMemoryReport>(bufferSize);
+        fillReport(*source1, rows);
+        fillReport(*source2, rows);
+        InMemoryReport moved(std::move(*source1));
+        InMemoryReport assigned;
+        assigned = std::move(*source2);
+
+        // the moved-from reports are empty and their destruction must not remove the buffer files
+        for (InMemoryReport* r : {source1.get(), source2.get()}) {
+            BOOST_CHECK_EQUAL(r->columns(), 0);
+            BOOST_CHECK_EQUAL(r->rows(), 0);
+            BOOST_CHECK_EQUAL(r->distinctStrings(), 0);
+        }
+        source1.reset();
+        source2.reset();
+
+        for (InMemoryReport* r : {&moved, &assigned}) {
+            Size distinct = r->distinctStrings();
+            r->next().add("trade_5").add(Size(1)).add(1.0).add(2.0).add(Date(1, Jan, 2025)).add(1 * Years).add("USD");
+            r->next().add("new_trade").add(Size(2)).add(3.0).add(4.0).add(Date(2, Jan, 2025)).add(2 * Years).add("GBP");
+            r->end();
+            BOOST_CHECK_EQUAL(r->distinctStrings(), distinct + 2);
+            BOOST_REQUIRE_EQUAL(r->rows(), rows + 2);
+            BOOST_CHECK_EQUAL(boost::get<string>(r->data(0, 5)), "trade_5");
+            BOOST_CHECK_EQUAL(boost::get<string>(r->data(6, 3)), "EUR,USD");
+            BOOST_CHECK_EQUAL(boost::get<string>(r->data(0, rows)), "trade_5");
+            BOOST_CHECK_EQUAL(boost::get<string>(r->data(0, rows + 1)), "new_trade");
+            BOOST_CHECK_EQUAL(boost::get<string>(r->data(6, rows + 1)), "GBP");
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE_END()
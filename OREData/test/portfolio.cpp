@@ -18,15 +18,53 @@
 
 #include <boost/make_shared.hpp>
 #include <boost/test/unit_test.hpp>
+#include <ored/marketdata/marketimpl.hpp>
+#include <ored/portfolio/enginedata.hpp>
 #include <ored/portfolio/fxforward.hpp>
 #include <ored/portfolio/portfolio.hpp>
 #include <oret/toplevelfixture.hpp>
+#include <ql/termstructures/yield/flatforward.hpp>
+#include <ql/time/daycounters/actual365fixed.hpp>
 
 using namespace QuantLib;
 using namespace boost::unit_test_framework;
 using namespace std;
 using namespace ore::data;
 
+namespace {
+
+class TestMarket : public MarketImpl {
+public:
+    TestMarket() : MarketImpl(false) {
+        asof_ = Date(3, Feb, 2016);
+        yieldCurves_[make_tuple(Market::defaultConfiguration, YieldCurveType::Discount, "EUR")] = flatRateYts(0.02);
+        yieldCurves_[make_tuple(Market::defaultConfiguration, YieldCurveType::Discount, "USD")] = flatRateYts(0.03);
+        std::map<std::string, Handle<Quote>> quotes;
+        quotes["EURUSD"] = Handle<Quote>(QuantLib::ext::make_shared<SimpleQuote>(1.2));
+        fx_ = QuantLib::ext::make_shared<FXTriangulation>(quotes);
+    }
+
+private:
+    Handle<YieldTermStructure> flatRateYts(Real forward) {
+        return Handle<YieldTermStructure>(
+            QuantLib::ext::make_shared<FlatForward>(0, NullCalendar(), forward, Actual365Fixed()));
+    }
+};
+
+// a portfolio of fx forwards as xml
+std::string fxForwardPortfolio(const Size n) {
+    Portfolio portfolio;
+    for (Size i = 0; i < n; ++i) {
+        auto trade = QuantLib::ext::make_shared<FxForward>(Envelope("CP" + std::to_string(i % 3)), "2017-02-03", "EUR",
+                                                           1.0E6 + 1000.0 * i, "USD", 1.2E6);
+        trade->id() = "FXF_" + std::to_string(i);
+        portfolio.add(trade);
+    }
+    return portfolio.toXMLString();
+}
+
+} // namespace
+
 BOOST_FIXTURE_TEST_SUITE(OREDataTestSuite, ore::test::TopLevelFixture)
 
 BOOST_AUTO_TEST_SUITE(PortfolioTests)
@@ -119,6 +157,65 @@ BOOST_AUTO_TEST_CASE(testIds) {
     BOOST_CHECK(portfolio->ids() == trade_ids);
 }
 
+BOOST_AUTO_TEST_CASE(testParallelParseAndBuild) {
+
+    BOOST_TEST_MESSAGE("Testing parsing and building a portfolio on several threads...");
+
+    Settings::instance().evaluationDate() = Date(3, Feb, 2016);
+
+    // add a trade that fails to parse and a trade with a duplicate id
+    std::string xml = fxForwardPortfolio(50);
+    std::string extra = "<Trade id=\"broken\"><TradeType>FxForward</TradeType><Envelope><CounterParty>CP0"
+                        "</CounterParty><NettingSetId>N</NettingSetId><AdditionalFields/></Envelope><FxForwardData>"
+                        "<ValueDate>2017-02-03</ValueDate></FxForwardData></Trade>";
+    std::string firstTrade = xml.substr(xml.find("<Trade "), xml.find("</Trade>") + 8 - xml.find("<Trade "));
+    std::string withErrors = xml;
+    withErrors.insert(withErrors.rfind("</Portfolio>"), extra + firstTrade);
+
+    Portfolio serial, parallel;
+    parallel.setThreads(4);
+    serial.fromXMLString(withErrors);
+    parallel.fromXMLString(withErrors);
+    BOOST_CHECK_EQUAL(serial.size(), 51);
+    BOOST_CHECK_EQUAL(parallel.size(), 51);
+    BOOST_REQUIRE(parallel.has("broken"));
+    BOOST_CHECK_EQUAL(parallel.get("broken")->tradeType(), "Failed");
+    BOOST_CHECK_EQUAL(parallel.toXMLString(), serial.toXMLString());
+
+    // build the valid trades on several threads, the results must match the serial build
+
+    auto engineData = QuantLib::ext::make_shared<EngineData>();
+    engineData->model("FxForward") = "DiscountedCashflows";
+    engineData->engine("FxForward") = "DiscountingFxForwardEngine";
+    auto market = QuantLib::ext::make_shared<TestMarket>();
+
+    Portfolio serialBuild, parallelBuild;
+    parallelBuild.setThreads(4);
+    serialBuild.fromXMLString(xml);
+    parallelBuild.fromXMLString(xml);
+    serialBuild.build(QuantLib::ext::make_shared<EngineFactory>(engineData, market), "test");
+    parallelBuild.build(QuantLib::ext::make_shared<EngineFactory>(engineData, market), "test");
+    BOOST_CHECK_EQUAL(serialBuild.buildThreads(), 1);
+#if defined(QL_ENABLE_SESSIONS) && defined(QL_ENABLE_THREAD_SAFE_OBSERVER_PATTERN)
+    BOOST_CHECK_EQUAL(parallelBuild.buildThreads(), 4);
+#else
+    BOOST_CHECK_EQUAL(parallelBuild.buildThreads(), 1);
+#endif
+    BOOST_REQUIRE_EQUAL(parallelBuild.size(), serialBuild.size());
+    BOOST_CHECK(parallelBuild.isBuilt());
+    for (auto const& [id, t] : serialBuild.trades()) {
+        BOOST_REQUIRE(parallelBuild.has(id));
+        BOOST_CHECK_CLOSE(parallelBuild.get(id)->instrument()->NPV(), t->instrument()->NPV(), 1.0E-10);
+    }
+
+    // the trades built on the worker threads see a change of the evaluation date on this thread
+    Real npv = serialBuild.trades().begin()->second->instrument()->NPV();
+    Settings::instance().evaluationDate() = Date(3, Aug, 2016);
+    BOOST_CHECK(!close_enough(serialBuild.trades().begin()->second->instrument()->NPV(), npv));
+    for (auto const& [id, t] : serialBuild.trades())
+        BOOST_CHECK_CLOSE(parallelBuild.get(id)->instrument()->NPV(), t->instrument()->NPV(), 1.0E-10);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -50,6 +50,7 @@
 
 #include <iomanip>
 #include <iostream>
+#include <sstream>
 
 using namespace ore::data;
 using namespace QuantExt;
@@ -1493,6 +1494,77 @@ BOOST_AUTO_TEST_CASE(testNestedIfThenElse) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(testCompiledScript) {
+    BOOST_TEST_MESSAGE("Testing compiled script execution against interpreter...");
+
+    constexpr Size nPaths = 8;
+    RandomVariable x(nPaths), z(nPaths);
+    for (Size i = 0; i < nPaths; ++i) {
+        x.set(i, static_cast<Real>(i));
+        z.set(i, 3.0 - 0.5 * static_cast<Real>(i));
+    }
+
+    auto c0 = QuantLib::ext::make_shared<Context>();
+    c0->scalars["x"] = x;
+    c0->scalars["z"] = z;
+    c0->scalars["d"] = RandomVariable(nPaths, 2.0);
+    c0->scalars["y"] = RandomVariable(nPaths, 0.0);
+    c0->scalars["ccy"] = CurrencyVec{nPaths, "EUR"};
+    c0->scalars["ccy2"] = CurrencyVec{nPaths, "USD"};
+    c0->scalars["today"] = EventVec{nPaths, Date(6, June, 2019)};
+    c0->scalars["later"] = EventVec{nPaths, Date(6, June, 2022)};
+    c0->scalars["cst"] = RandomVariable(nPaths, 1.0);
+    c0->constants.insert("cst");
+    c0->scalars["ign"] = RandomVariable(nPaths, 7.0);
+    c0->ignoreAssignments.insert("ign");
+    c0->arrays["a"] = std::vector<ValueType>(5, RandomVariable(nPaths, 1.5));
+    c0->scalars["dc"] = DaycounterVec{nPaths, "A365F"};
+
+    std::vector<std::string> scripts = {
+        // arithmetic, functions, constant folding
+        "y = x + z * 2 - d / 4 + 3 * (2 + 5);",
+        "y = max(x, z) + min(x, 3) + pow(d, 2) + abs(z) + exp(z / 10) + ln(d) + sqrt(d) + normalCdf(z) + "
+        "normalPdf(z) + round(z, 1) - -x;",
+        "y = x; y = y + y; x = y * x;",
+        // control flow, filters and short cuts
+        "IF x > 3 THEN y = x; ELSE y = -x; END;",
+        "IF {x > 3 AND z < 1} OR NOT {x == 2} THEN y = 5; END; IF x != 2 THEN d = 3; END;",
+        "IF d > 3 AND q > 1 THEN y = 1; END; IF d < 3 OR q > 1 THEN y = 2; END;",
+        "NUMBER i, j; FOR i IN (5, 1, -2) DO FOR j IN (1, i, 1) DO IF x > j THEN y = y + i * j; END; END; END;",
+        // arrays, declarations, delegated nodes
+        "NUMBER i; FOR i IN (1, SIZE(a), 1) DO a[i] = a[i] * x + i; END; y = a[2] + a[SIZE(a)];",
+        "NUMBER b[3], i; FOR i IN (1, 3, 1) DO b[i] = x + i; END; SORT(b); y = b[1] * b[3];",
+        "ccy = ccy2; today = later; IF today < later THEN y = 1; END; y = dcf(dc, today, later);",
+        // errors
+        "y = x + ccy;", "y = q;", "y = a;", "y = a[6];", "a[x] = 1;", "cst = 1;", "ign = 1; y = ign;", "ccy = 1;",
+        "IF ccy == 1 THEN y = 1; END;", "NUMBER i; FOR i IN (1, 3, 1) DO i = 4; END;",
+        "NUMBER i; FOR i IN (1, x, 1) DO y = 1; END;", "IF d < 100 AND q > 1 THEN y = 2; END;"};
+
+    auto model = QuantLib::ext::make_shared<DummyModel>(nPaths);
+    auto run = [&c0, &model](const ASTNodePtr& ast, const bool compiled) {
+        auto c = QuantLib::ext::make_shared<Context>(*c0);
+        std::ostringstream result;
+        try {
+            ScriptEngine engine(ast, c, model, compiled);
+            engine.run();
+        } catch (const std::exception& e) {
+            result << "error: " << e.what() << "\n";
+        }
+        result << *c;
+        return result.str();
+    };
+
+    for (auto const& script : scripts) {
+        BOOST_TEST_MESSAGE("running '" << script << "'");
+        ScriptParser parser(script);
+        BOOST_REQUIRE(parser.success());
+        std::string interpreted = run(parser.ast(), false);
+        BOOST_CHECK_EQUAL(run(parser.ast(), true), interpreted);
+        // second run uses the cached program
+        BOOST_CHECK_EQUAL(run(parser.ast(), true), interpreted);
+    }
+}
+
 BOOST_AUTO_TEST_CASE(testInteractive, *boost::unit_test::disabled()) {
 
     // not a test, just for convenience, to be removed at some stage...
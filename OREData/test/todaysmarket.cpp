@@ -1039,6 +1039,74 @@ BOOST_AUTO_TEST_CASE(testCorrelationCurve) {
     BOOST_CHECK_SMALL(npvCash - expectedNpv2Y, 0.000001);
 }
 
+BOOST_AUTO_TEST_CASE(testParallelBuild) {
+
+    BOOST_TEST_MESSAGE("Testing parallel build of todays market...");
+
+    // the fixture's market is built serially, the parallel build falls back to a serial build if QuantLib is not
+    // built with sessions and the thread safe observer pattern, in any case the results must be identical
+    Date asof = market->asofDate();
+    auto parallelMarket = QuantLib::ext::make_shared<TodaysMarket>(
+        asof, marketParameters(), QuantLib::ext::make_shared<MarketDataLoader>(), curveConfigurations(), false, true,
+        false, nullptr, false, QuantLib::ext::make_shared<IborFallbackConfig>(IborFallbackConfig::defaultConfig()),
+        true, true, true, 4);
+
+#if defined(QL_ENABLE_SESSIONS) && defined(QL_ENABLE_THREAD_SAFE_OBSERVER_PATTERN)
+    BOOST_CHECK_EQUAL(parallelMarket->buildThreads(), 4);
+#else
+    BOOST_TEST_MESSAGE("QuantLib is not built with sessions and the thread safe observer pattern, the market is "
+                       "built serially.");
+    BOOST_CHECK_EQUAL(parallelMarket->buildThreads(), 1);
+#endif
+
+    auto compare = [&asof, &parallelMarket, this]() {
+        DayCounter dc = Actual365Fixed();
+        for (auto const& c : {"EUR", "USD"}) {
+            Handle<YieldTermStructure> s = market->discountCurve(c), p = parallelMarket->discountCurve(c);
+            for (Size i = 1; i <= 120; ++i) {
+                Date d = asof + i * Months;
+                BOOST_CHECK_EQUAL(s->discount(d), p->discount(d));
+            }
+        }
+        for (auto const& c : {"EUR_LEND", "EUR_BORROW"}) {
+            Handle<YieldTermStructure> s = market->yieldCurve(c), p = parallelMarket->yieldCurve(c);
+            for (Size i = 1; i <= 120; ++i) {
+                Date d = asof + i * Months;
+                BOOST_CHECK_EQUAL(s->zeroRate(d, dc, Continuous).rate(), p->zeroRate(d, dc, Continuous).rate());
+            }
+        }
+
+        Handle<OptionletVolatilityStructure> sv = market->capFloorVol("USD"), pv = parallelMarket->capFloorVol("USD");
+        for (auto const& t : {1 * Years, 5 * Years, 10 * Years}) {
+            for (auto const& k : {0.005, 0.015, 0.030})
+                BOOST_CHECK_EQUAL(sv->volatility(t, k), pv->volatility(t, k));
+        }
+
+        BOOST_CHECK_EQUAL(market->commodityPriceCurve("COMDTY_GOLD_USD")->price(asof + 1 * Years),
+                          parallelMarket->commodityPriceCurve("COMDTY_GOLD_USD")->price(asof + 1 * Years));
+    };
+
+    compare();
+
+    // objects built on worker threads are notified of a change of the evaluation date on this thread
+    Settings::instance().evaluationDate() = asof + 1 * Months;
+    compare();
+    Settings::instance().evaluationDate() = asof;
+    compare();
+
+    // the build times are recorded for the same nodes
+    auto const& serialTimes = market->calibrationInfo()->nodeBuildTimes;
+    auto const& parallelTimes = parallelMarket->calibrationInfo()->nodeBuildTimes;
+    BOOST_REQUIRE(!serialTimes.empty());
+    BOOST_REQUIRE_EQUAL(serialTimes.size(), parallelTimes.size());
+    for (auto st = serialTimes.begin(), pt = parallelTimes.begin(); st != serialTimes.end(); ++st, ++pt) {
+        BOOST_CHECK_EQUAL(st->first, pt->first);
+        BOOST_CHECK_EQUAL(st->second.size(), pt->second.size());
+        for (auto const& t : pt->second)
+            BOOST_CHECK(t.second >= 0.0);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,656 @@
+/*
+ Copyright (C) 2025 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+#include <qle/ad/backwardderivatives.hpp>
+#include <qle/ad/forwardevaluation.hpp>
+#include <qle/ad/tiledevaluation.hpp>
+
+#include <ql/errors.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <set>
+
+namespace QuantExt {
+
+namespace {
+
+/* max number of nodes evaluated per tile between two synchronisation points, this bounds the number of tile slots
+   that are allocated at a time */
+constexpr std::size_t maxNodesPerBlock = 4096;
+
+class TileLayout {
+public:
+    TileLayout(const std::size_t n, const std::size_t tileSize)
+        : n_(n), tileSize_(std::max<std::size_t>(tileSize, 1)), nTiles_((n + tileSize_ - 1) / tileSize_) {}
+    std::size_t size() const { return n_; }
+    std::size_t nTiles() const { return nTiles_; }
+    std::size_t begin(const std::size_t t) const { return t * tileSize_; }
+    std::size_t size(const std::size_t t) const { return std::min(n_, (t + 1) * tileSize_) - t * tileSize_; }
+    bool lastTileIsShort() const { return n_ % tileSize_ != 0; }
+    std::size_t tileSize() const { return tileSize_; }
+
+private:
+    std::size_t n_, tileSize_, nTiles_;
+};
+
+RandomVariable slice(RandomVariable& x, const std::size_t begin, const std::size_t size) {
+    if (!x.initialised())
+        return RandomVariable();
+    if (x.deterministic())
+        return RandomVariable(size, x[0], x.time());
+    return RandomVariable(size, x.data() + begin, x.time());
+}
+
+/* Storage for the node values split into tiles. Deterministic and uninitialised values are stored once for all
+   tiles, the per tile parts are only created for the nodes involved in the block that is currently evaluated and
+   collapsed again afterwards, if possible. */
+class TiledValues {
+public:
+    TiledValues(const TileLayout& layout, const std::size_t nNodes)
+        : layout_(layout), single_(nNodes), parts_(nNodes) {}
+
+    bool initialised(const std::size_t node) const {
+        return parts_[node].empty() ? single_[node].initialised() : parts_[node].front().initialised();
+    }
+
+    RandomVariable& part(const std::size_t node, const std::size_t t) { return parts_[node][t]; }
+
+    void scatter(const std::size_t node, RandomVariable& x) {
+        parts_[node].clear();
+        if (!x.initialised() || x.deterministic()) {
+            single_[node] = std::move(x);
+            return;
+        }
+        single_[node] = RandomVariable();
+        parts_[node].resize(layout_.nTiles());
+        for (std::size_t t = 0; t < layout_.nTiles(); ++t)
+            parts_[node][t] = slice(x, layout_.begin(t), layout_.size(t));
+        x = RandomVariable();
+    }
+
+    RandomVariable gather(const std::size_t node) {
+        if (parts_[node].empty())
+            return single_[node];
+        auto& p = parts_[node];
+        if (!p.front().initialised()) {
+            QL_REQUIRE(std::none_of(p.begin(), p.end(), [](const RandomVariable& x) { return x.initialised(); }),
+                       "TiledValues::gather(): node " << node << " is initialised on a subset of tiles only");
+            return RandomVariable();
+        }
+        if (collapsible(p))
+            return RandomVariable(layout_.size(), p.front()[0], p.front().time());
+        RandomVariable r(layout_.size(), 0.0, p.front().time());
+        r.expand();
+        double* d = r.data();
+        for (std::size_t t = 0; t < p.size(); ++t) {
+            QL_REQUIRE(p[t].initialised(),
+                       "TiledValues::gather(): node " << node << " is initialised on a subset of tiles only");
+            if (p[t].deterministic())
+                std::fill(d + layout_.begin(t), d + layout_.begin(t) + p[t].size(), p[t][0]);
+            else
+                std::copy(p[t].data(), p[t].data() + p[t].size(), d + layout_.begin(t));
+        }
+        return r;
+    }
+
+    void materialise(const std::size_t node) {
+        if (!parts_[node].empty())
+            return;
+        parts_[node].resize(layout_.nTiles());
+        if (!single_[node].initialised())
+            return;
+        for (std::size_t t = 0; t < layout_.nTiles(); ++t)
+            parts_[node][t] = RandomVariable(layout_.size(t), single_[node][0], single_[node].time());
+        single_[node] = RandomVariable();
+    }
+
+    void compact(const std::size_t node) {
+        auto& p = parts_[node];
+        if (p.empty())
+            return;
+        if (std::none_of(p.begin(), p.end(), [](const RandomVariable& x) { return x.initialised(); })) {
+            std::vector<RandomVariable>().swap(p);
+            single_[node] = RandomVariable();
+        } else if (collapsible(p)) {
+            single_[node] = RandomVariable(layout_.size(), p.front()[0], p.front().time());
+            std::vector<RandomVariable>().swap(p);
+        }
+    }
+
+    void remove(const std::size_t node, const std::function<void(RandomVariable&)>& deleter) {
+        if (parts_[node].empty()) {
+            deleter(single_[node]);
+        } else {
+            for (auto& x : parts_[node])
+                deleter(x);
+            compact(node);
+        }
+    }
+
+    void clear(const std::size_t node) {
+        single_[node] = RandomVariable();
+        std::vector<RandomVariable>().swap(parts_[node]);
+    }
+
+    // node += x, x given on all paths
+    void add(const std::size_t node, RandomVariable x) {
+        materialise(node);
+        for (std::size_t t = 0; t < layout_.nTiles(); ++t)
+            parts_[node][t] += slice(x, layout_.begin(t), layout_.size(t));
+        compact(node);
+    }
+
+private:
+    static bool collapsible(const std::vector<RandomVariable>& p) {
+        return std::all_of(p.begin(), p.end(), [&p](const RandomVariable& x) {
+            return x.initialised() && x.deterministic() && x[0] == p.front()[0] && x.time() == p.front().time();
+        });
+    }
+
+    const TileLayout& layout_;
+    std::vector<RandomVariable> single_;
+    std::vector<std::vector<RandomVariable>> parts_;
+};
+
+// ops resp. gradients for the tile sizes and the full sample size (the latter created on demand)
+template <class Op> class SizedOps {
+public:
+    SizedOps(const std::function<std::vector<Op>(const std::size_t)>& factory, const TileLayout& layout)
+        : factory_(factory), layout_(layout) {
+        QL_REQUIRE(factory_, "SizedOps: no factory given");
+        tile_ = factory_(layout_.tileSize());
+        if (layout_.lastTileIsShort())
+            last_ = factory_(layout_.size(layout_.nTiles() - 1));
+    }
+    const std::vector<Op>& tile(const std::size_t t) const {
+        return t + 1 == layout_.nTiles() && layout_.lastTileIsShort() ? last_ : tile_;
+    }
+    const std::vector<Op>& full() {
+        if (full_.empty())
+            full_ = factory_(layout_.size());
+        return full_;
+    }
+
+private:
+    std::function<std::vector<Op>(const std::size_t)> factory_;
+    const TileLayout& layout_;
+    std::vector<Op> tile_, last_, full_;
+};
+
+/* The nodes to delete after the evaluation of each node in [startNode, endNode), this reproduces the logic in
+   forwardEvaluation(), the result is indexed by node - startNode. */
+std::vector<std::vector<std::size_t>>
+forwardDeletionPlan(const ComputationGraph& g, const bool hasDeleter, const bool keepValuesForDerivatives,
+                    const std::vector<RandomVariableOpNodeRequirements>& opRequiresNodesForDerivatives,
+                    const std::vector<bool>& keepNodes, const std::size_t startNode, const std::size_t endNode,
+                    const bool redBlockReconstruction) {
+
+    std::vector<std::vector<std::size_t>> plan(endNode - startNode);
+    if (!hasDeleter)
+        return plan;
+
+    std::vector<bool> keepNodesDerivatives;
+    if (keepValuesForDerivatives)
+        keepNodesDerivatives = std::vector<bool>(g.size(), false);
+
+    for (std::size_t node = startNode; node < endNode; ++node) {
+        auto const& pred = g.predecessors(node);
+        if (pred.empty())
+            continue;
+        std::set<std::size_t> nodesToDelete;
+        for (std::size_t arg = 0; arg < pred.size(); ++arg) {
+            std::size_t p = pred[arg];
+            if (!keepNodesDerivatives.empty()) {
+                if (opRequiresNodesForDerivatives[g.opId(p)](pred.size()).second ||
+                    opRequiresNodesForDerivatives[g.opId(node)](pred.size()).first[arg])
+                    keepNodesDerivatives[p] = true;
+            }
+            if (g.maxNodeRequiringArg(p) > node)
+                continue;
+            if ((!keepNodes.empty() && keepNodes[p]) ||
+                (!keepNodesDerivatives.empty() && keepNodesDerivatives[p] &&
+                 (g.redBlockId(p) == 0 || redBlockReconstruction)))
+                continue;
+            nodesToDelete.insert(p);
+        }
+        plan[node - startNode].assign(nodesToDelete.begin(), nodesToDelete.end());
+    }
+
+    return plan;
+}
+
+/* Evaluates the nodes in [startNode, endNode) on the tiled values. The callback afterBlock is called with the first
+   node that is not yet evaluated after each synchronisation point. */
+void forwardEvaluationOnTiles(WorkerPool& pool, const TileLayout& layout, TiledValues& tv, const ComputationGraph& g,
+                              SizedOps<RandomVariableOp>& ops, const std::vector<bool>& opIsPathwise,
+                              const std::function<void(RandomVariable&)>& deleter,
+                              const std::vector<std::vector<std::size_t>>& plan, const std::size_t startNode,
+                              const std::size_t endNode, const std::function<void(std::size_t)>& afterBlock = {}) {
+
+    std::size_t node = startNode;
+    while (node < endNode) {
+
+        if (g.predecessors(node).empty()) {
+            ++node;
+            continue;
+        }
+
+        if (!opIsPathwise[g.opId(node)]) {
+
+            // barrier: evaluate the node on all paths
+
+            auto const& pred = g.predecessors(node);
+            std::vector<RandomVariable> fullArgs(pred.size());
+            std::vector<const RandomVariable*> args(pred.size());
+            for (std::size_t arg = 0; arg < pred.size(); ++arg) {
+                fullArgs[arg] = tv.gather(pred[arg]);
+                args[arg] = &fullArgs[arg];
+            }
+
+            RandomVariable result = ops.full()[g.opId(node)](args, node);
+            QL_REQUIRE(result.initialised(), "forwardEvaluation(): value at active node "
+                                                 << node << " is not initialized, opId = " << g.opId(node));
+            fullArgs.clear();
+            tv.scatter(node, result);
+
+            if (deleter) {
+                for (auto n : plan[node - startNode])
+                    tv.remove(n, deleter);
+            }
+
+            ++node;
+
+        } else {
+
+            // block of nodes with pathwise ops: evaluate the whole block tile by tile
+
+            std::size_t blockEnd = node;
+            std::vector<std::size_t> involved;
+            for (std::size_t nNodes = 0; blockEnd < endNode && nNodes < maxNodesPerBlock; ++blockEnd) {
+                auto const& pred = g.predecessors(blockEnd);
+                if (pred.empty())
+                    continue;
+                if (!opIsPathwise[g.opId(blockEnd)])
+                    break;
+                involved.push_back(blockEnd);
+                involved.insert(involved.end(), pred.begin(), pred.end());
+                ++nNodes;
+            }
+
+            std::sort(involved.begin(), involved.end());
+            involved.erase(std::unique(involved.begin(), involved.end()), involved.end());
+            for (auto n : involved)
+                tv.materialise(n);
+
+            std::size_t blockStart = node;
+            pool.parallelFor(layout.nTiles(), 1,
+                             [&tv, &g, &ops, &deleter, &plan, startNode, blockStart,
+                              blockEnd](const std::size_t tBegin, const std::size_t tEnd, const std::size_t) {
+                                 std::vector<const RandomVariable*> args;
+                                 for (std::size_t t = tBegin; t < tEnd; ++t) {
+                                     auto const& tileOps = ops.tile(t);
+                                     for (std::size_t n = blockStart; n < blockEnd; ++n) {
+                                         auto const& pred = g.predecessors(n);
+                                         if (pred.empty())
+                                             continue;
+                                         args.resize(pred.size());
+                                         for (std::size_t arg = 0; arg < pred.size(); ++arg)
+                                             args[arg] = &tv.part(pred[arg], t);
+                                         tv.part(n, t) = tileOps[g.opId(n)](args, n);
+                                         QL_REQUIRE(tv.part(n, t).initialised(),
+                                                    "forwardEvaluation(): value at active node "
+                                                        << n << " is not initialized, opId = " << g.opId(n));
+                                         if (deleter) {
+                                             for (auto d : plan[n - startNode])
+                                                 deleter(tv.part(d, t));
+                                         }
+                                     }
+                                 }
+                             });
+
+            for (auto n : involved)
+                tv.compact(n);
+
+            node = blockEnd;
+        }
+
+        if (afterBlock)
+            afterBlock(node);
+    }
+}
+
+std::size_t sampleSize(const std::vector<RandomVariable>& values) {
+    for (auto const& v : values) {
+        if (v.initialised())
+            return v.size();
+    }
+    return 0;
+}
+
+} // namespace
+
+void forwardEvaluationTiled(WorkerPool& pool, const std::size_t tileSize, const ComputationGraph& g,
+                            std::vector<RandomVariable>& values, const RandomVariableOpsFactory& opsFactory,
+                            const std::vector<bool>& opIsPathwise, std::function<void(RandomVariable&)> deleter,
+                            bool keepValuesForDerivatives,
+                            const std::vector<RandomVariableOpNodeRequirements>& opRequiresNodesForDerivatives,
+                            const std::vector<bool>& keepNodes, const std::size_t startNode,
+                            const std::size_t endNode, const bool redBlockReconstruction) {
+
+    std::size_t end = endNode == ComputationGraph::nan ? g.size() : endNode;
+
+    // the inputs are the args of the evaluated nodes which are not evaluated themselves
+
+    std::vector<std::size_t> lastUse(g.size(), ComputationGraph::nan);
+    std::vector<std::size_t> inputs;
+    for (std::size_t node = startNode; node < end; ++node) {
+        for (auto p : g.predecessors(node)) {
+            if (p >= startNode && !g.predecessors(p).empty())
+                continue;
+            if (lastUse[p] == ComputationGraph::nan)
+                inputs.push_back(p);
+            lastUse[p] = node;
+        }
+    }
+
+    std::size_t n = 0;
+    for (auto p : inputs) {
+        if (values[p].initialised()) {
+            n = values[p].size();
+            break;
+        }
+    }
+
+    if (n <= tileSize) {
+        forwardEvaluation(g, values, opsFactory(n), deleter, keepValuesForDerivatives, opRequiresNodesForDerivatives,
+                          keepNodes, startNode, end, redBlockReconstruction);
+        return;
+    }
+
+    auto plan = forwardDeletionPlan(g, static_cast<bool>(deleter), keepValuesForDerivatives,
+                                    opRequiresNodesForDerivatives, keepNodes, startNode, end, redBlockReconstruction);
+
+    std::vector<bool> inputIsDeleted(g.size(), false);
+    for (auto const& nodesToDelete : plan) {
+        for (auto d : nodesToDelete) {
+            if (lastUse[d] != ComputationGraph::nan)
+                inputIsDeleted[d] = true;
+        }
+    }
+
+    TileLayout layout(n, tileSize);
+    TiledValues tv(layout, g.size());
+
+    /* Copy the inputs to the tiles. Inputs which are deleted during the evaluation are deleted right away, the others
+       stay untouched and their tile copies are released after their last use. */
+
+    for (auto p : inputs) {
+        RandomVariable tmp = values[p];
+        tv.scatter(p, tmp);
+        if (inputIsDeleted[p])
+            deleter(values[p]);
+    }
+
+    std::sort(inputs.begin(), inputs.end(),
+              [&lastUse](const std::size_t a, const std::size_t b) { return lastUse[a] < lastUse[b]; });
+    std::size_t nextInputToRelease = 0;
+
+    SizedOps<RandomVariableOp> ops(opsFactory, layout);
+    forwardEvaluationOnTiles(pool, layout, tv, g, ops, opIsPathwise, deleter, plan, startNode, end,
+                             [&tv, &inputs, &lastUse, &nextInputToRelease](const std::size_t nextNode) {
+                                 while (nextInputToRelease < inputs.size() &&
+                                        lastUse[inputs[nextInputToRelease]] < nextNode)
+                                     tv.clear(inputs[nextInputToRelease++]);
+                             });
+
+    // move the evaluated nodes back to the full value vector
+
+    for (std::size_t node = startNode; node < end; ++node) {
+        if (g.predecessors(node).empty())
+            continue;
+        values[node] = tv.gather(node);
+        tv.clear(node);
+    }
+}
+
+void backwardDerivativesTiled(WorkerPool& pool, const std::size_t tileSize, const ComputationGraph& g,
+                              std::vector<RandomVariable>& values, std::vector<RandomVariable>& derivatives,
+                              const RandomVariableGradsFactory& gradsFactory, const std::vector<bool>& gradIsPathwise,
+                              std::function<void(RandomVariable&)> deleter, const std::vector<bool>& keepNodes,
+                              const RandomVariableOpsFactory& fwdOpsFactory, const std::vector<bool>& fwdOpIsPathwise,
+                              const std::vector<RandomVariableOpNodeRequirements>& fwdOpRequiresNodesForDerivatives,
+                              const std::vector<bool>& fwdOpKeepNodes, const std::size_t conditionalExpectationOpId,
+                              const RandomVariableOp& conditionalExpectation) {
+
+    if (g.size() == 0)
+        return;
+
+    std::size_t n = sampleSize(derivatives);
+    if (n == 0)
+        n = sampleSize(values);
+
+    if (n <= tileSize) {
+        backwardDerivatives(g, values, derivatives, gradsFactory(n), deleter, keepNodes,
+                            fwdOpsFactory ? fwdOpsFactory(n) : std::vector<RandomVariableOp>{},
+                            fwdOpRequiresNodesForDerivatives, fwdOpKeepNodes, conditionalExpectationOpId,
+                            conditionalExpectation);
+        return;
+    }
+
+    TileLayout layout(n, tileSize);
+    TiledValues tv(layout, g.size()), td(layout, g.size());
+
+    // move the values and derivatives to the tiles, they are moved back at the end
+
+    for (std::size_t node = 0; node < g.size(); ++node) {
+        tv.scatter(node, values[node]);
+        td.scatter(node, derivatives[node]);
+    }
+
+    SizedOps<RandomVariableGrad> grads(gradsFactory, layout);
+    std::unique_ptr<SizedOps<RandomVariableOp>> fwdOps;
+
+    auto isBarrier = [&g, &gradIsPathwise, &conditionalExpectation,
+                      conditionalExpectationOpId](const std::size_t node) {
+        return !g.predecessors(node).empty() &&
+               ((g.opId(node) == conditionalExpectationOpId && conditionalExpectation) ||
+                !gradIsPathwise[g.opId(node)]);
+    };
+
+    auto deleteDerivative = [&keepNodes, &deleter](const std::size_t node) {
+        return deleter && (keepNodes.empty() || !keepNodes[node]);
+    };
+
+    std::size_t redBlockId = 0;
+
+    // loop over the nodes in the graph in reverse order
+
+    std::size_t node = g.size() - 1;
+    while (node > 0) {
+
+        if (g.redBlockId(node) != redBlockId) {
+
+            // delete the values in the previous red block
+
+            if (deleter && redBlockId > 0) {
+                auto range = g.redBlockRanges()[redBlockId - 1];
+                QL_REQUIRE(range.second != ComputationGraph::nan,
+                           "backwardDerivatives(): red block " << redBlockId << " was not closed.");
+                for (std::size_t m = range.first; m < range.second; ++m) {
+                    if (g.redBlockId(m) == redBlockId && (fwdOpKeepNodes.empty() || !fwdOpKeepNodes[m]))
+                        tv.remove(m, deleter);
+                }
+            }
+
+            // populate the values in the current red block
+
+            if (g.redBlockId(node) > 0) {
+                auto range = g.redBlockRanges()[g.redBlockId(node) - 1];
+                QL_REQUIRE(range.second != ComputationGraph::nan,
+                           "backwardDerivatives(): red block " << g.redBlockId(node) << " was not closed.");
+                if (!fwdOps)
+                    fwdOps = std::make_unique<SizedOps<RandomVariableOp>>(fwdOpsFactory, layout);
+                auto plan = forwardDeletionPlan(g, static_cast<bool>(deleter), true, fwdOpRequiresNodesForDerivatives,
+                                                fwdOpKeepNodes, range.first, range.second, true);
+                forwardEvaluationOnTiles(pool, layout, tv, g, *fwdOps, fwdOpIsPathwise, deleter, plan, range.first,
+                                         range.second);
+            }
+
+            // update the red block id
+
+            redBlockId = g.redBlockId(node);
+        }
+
+        if (isBarrier(node)) {
+
+            // propagate the derivative on all paths
+
+            auto const& pred = g.predecessors(node);
+            RandomVariable derivative = td.gather(node);
+
+            if (!isDeterministicAndZero(derivative)) {
+
+                QL_REQUIRE(derivative.initialised(),
+                           "backwardDerivatives(): derivative at active node " << node << " is not initialized.");
+
+                bool isConditionalExpectation = g.opId(node) == conditionalExpectationOpId && conditionalExpectation;
+
+                std::vector<RandomVariable> fullArgs(pred.size());
+                std::vector<const RandomVariable*> args(pred.size());
+                for (std::size_t arg = 0; arg < pred.size(); ++arg) {
+                    if (!isConditionalExpectation || arg > 0)
+                        fullArgs[arg] = tv.gather(pred[arg]);
+                    args[arg] = &fullArgs[arg];
+                }
+
+                if (isConditionalExpectation) {
+
+                    // expected stochastic automatic differentiaion, Fries, 2017
+                    args[0] = &derivative;
+                    td.add(pred[0], conditionalExpectation(args, node));
+
+                } else {
+
+                    RandomVariable value = tv.gather(node);
+                    auto gr = grads.full()[g.opId(node)](args, &value, node);
+
+                    for (std::size_t p = 0; p < pred.size(); ++p) {
+                        QL_REQUIRE(td.initialised(pred[p]),
+                                   "backwardDerivatives: derivative at node "
+                                       << pred[p] << " not initialized, which is an active predecessor of " << node);
+                        QL_REQUIRE(gr[p].initialised(),
+                                   "backwardDerivatives: gradient at node "
+                                       << node << " (opId " << g.opId(node) << ") not initialized at component " << p
+                                       << " but required to push to predecessor " << pred[p]);
+                        td.add(pred[p], derivative * gr[p]);
+                    }
+                }
+            }
+
+            if (deleteDerivative(node))
+                td.remove(node, deleter);
+
+            --node;
+            continue;
+        }
+
+        // block of nodes with pathwise gradients within the current red block: process tile by tile
+
+        std::size_t blockStart = node;
+        for (std::size_t nNodes = 1; blockStart > 1 && nNodes < maxNodesPerBlock; ++nNodes) {
+            if (g.redBlockId(blockStart - 1) != redBlockId || isBarrier(blockStart - 1))
+                break;
+            --blockStart;
+        }
+
+        std::vector<std::size_t> involvedValues, involvedDerivatives;
+        for (std::size_t m = blockStart; m <= node; ++m) {
+            auto const& pred = g.predecessors(m);
+            involvedDerivatives.push_back(m);
+            if (pred.empty())
+                continue;
+            involvedValues.push_back(m);
+            involvedValues.insert(involvedValues.end(), pred.begin(), pred.end());
+            involvedDerivatives.insert(involvedDerivatives.end(), pred.begin(), pred.end());
+        }
+        for (auto* v : {&involvedValues, &involvedDerivatives}) {
+            std::sort(v->begin(), v->end());
+            v->erase(std::unique(v->begin(), v->end()), v->end());
+        }
+        for (auto m : involvedValues)
+            tv.materialise(m);
+        for (auto m : involvedDerivatives)
+            td.materialise(m);
+
+        std::size_t blockEnd = node;
+        pool.parallelFor(
+            layout.nTiles(), 1,
+            [&tv, &td, &g, &grads, &deleteDerivative, &deleter, blockStart,
+             blockEnd](const std::size_t tBegin, const std::size_t tEnd, const std::size_t) {
+                std::vector<const RandomVariable*> args;
+                for (std::size_t t = tBegin; t < tEnd; ++t) {
+                    auto const& tileGrads = grads.tile(t);
+                    for (std::size_t m = blockEnd + 1; m-- > blockStart;) {
+                        auto const& pred = g.predecessors(m);
+                        RandomVariable& derivative = td.part(m, t);
+                        if (!pred.empty() && !isDeterministicAndZero(derivative)) {
+                            args.resize(pred.size());
+                            for (std::size_t arg = 0; arg < pred.size(); ++arg)
+                                args[arg] = &tv.part(pred[arg], t);
+                            QL_REQUIRE(derivative.initialised(), "backwardDerivatives(): derivative at active node "
+                                                                     << m << " is not initialized.");
+                            auto gr = tileGrads[g.opId(m)](args, &tv.part(m, t), m);
+                            for (std::size_t p = 0; p < pred.size(); ++p) {
+                                RandomVariable& predDerivative = td.part(pred[p], t);
+                                QL_REQUIRE(predDerivative.initialised(),
+                                           "backwardDerivatives: derivative at node "
+                                               << pred[p] << " not initialized, which is an active predecessor of "
+                                               << m);
+                                QL_REQUIRE(gr[p].initialised(),
+                                           "backwardDerivatives: gradient at node "
+                                               << m << " (opId " << g.opId(m) << ") not initialized at component "
+                                               << p << " but required to push to predecessor " << pred[p]);
+                                predDerivative += derivative * gr[p];
+                            }
+                        }
+                        if (deleteDerivative(m))
+                            deleter(derivative);
+                    }
+                }
+            });
+
+        for (auto m : involvedValues)
+            tv.compact(m);
+        for (auto m : involvedDerivatives)
+            td.compact(m);
+
+        node = blockStart - 1;
+    }
+
+    // move the values and derivatives back
+
+    for (std::size_t m = 0; m < g.size(); ++m) {
+        values[m] = tv.gather(m);
+        tv.clear(m);
+        derivatives[m] = td.gather(m);
+        td.clear(m);
+    }
+}
+
+} // namespace QuantExt
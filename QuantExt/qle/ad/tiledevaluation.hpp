@@ -0,0 +1,67 @@
+/*
+ Copyright (C) 2025 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+/*! \file qle/ad/tiledevaluation.hpp
+    \brief forward evaluation and backward derivatives on tiles of paths, multi-threaded
+*/
+
+#pragma once
+
+#include <qle/ad/computationgraph.hpp>
+#include <qle/math/randomvariable_ops.hpp>
+#include <qle/utilities/workerpool.hpp>
+
+namespace QuantExt {
+
+//! creates the ops resp. gradients for a given sample size
+using RandomVariableOpsFactory = std::function<std::vector<RandomVariableOp>(const std::size_t)>;
+using RandomVariableGradsFactory = std::function<std::vector<RandomVariableGrad>(const std::size_t)>;
+
+/*! Same as forwardEvaluation() for T = RandomVariable, but the sample dimension is split into tiles of size tileSize.
+    Runs of nodes with pathwise ops (see getRandomVariableOpIsPathwise()) are evaluated tile by tile on the worker pool,
+    so that the working set of a tile stays in the cache. Nodes with an op that is not pathwise (e.g. conditional
+    expectation) act as a barrier, they are evaluated on all paths after merging their args from the tiles.
+
+    The ops are created via opsFactory for the tile sizes and, if a barrier is hit, for the full sample size. The
+    deleter / keepNodes / red block semantics is the same as in forwardEvaluation(), pre-deletion is not supported. If
+    the sample size does not exceed the tile size, forwardEvaluation() is called. */
+void forwardEvaluationTiled(WorkerPool& pool, const std::size_t tileSize, const ComputationGraph& g,
+                            std::vector<RandomVariable>& values, const RandomVariableOpsFactory& opsFactory,
+                            const std::vector<bool>& opIsPathwise, std::function<void(RandomVariable&)> deleter = {},
+                            bool keepValuesForDerivatives = true,
+                            const std::vector<RandomVariableOpNodeRequirements>& opRequiresNodesForDerivatives = {},
+                            const std::vector<bool>& keepNodes = {}, const std::size_t startNode = 0,
+                            const std::size_t endNode = ComputationGraph::nan,
+                            const bool redBlockReconstruction = false);
+
+/*! Same as backwardDerivatives() for T = RandomVariable, with the sample dimension split into tiles as in
+    forwardEvaluationTiled(). Nodes for which the gradient is not pathwise and, if given, conditional expectation nodes
+    are processed on all paths. Red blocks are reconstructed with forwardEvaluationTiled() logic using the ops from
+    fwdOpsFactory. */
+void backwardDerivativesTiled(WorkerPool& pool, const std::size_t tileSize, const ComputationGraph& g,
+                              std::vector<RandomVariable>& values, std::vector<RandomVariable>& derivatives,
+                              const RandomVariableGradsFactory& gradsFactory, const std::vector<bool>& gradIsPathwise,
+                              std::function<void(RandomVariable&)> deleter = {},
+                              const std::vector<bool>& keepNodes = {}, const RandomVariableOpsFactory& fwdOpsFactory = {},
+                              const std::vector<bool>& fwdOpIsPathwise = {},
+                              const std::vector<RandomVariableOpNodeRequirements>& fwdOpRequiresNodesForDerivatives = {},
+                              const std::vector<bool>& fwdOpKeepNodes = {},
+                              const std::size_t conditionalExpectationOpId = 0,
+                              const RandomVariableOp& conditionalExpectation = {});
+
+} // namespace QuantExt
@@ -0,0 +1,932 @@
+/*
+ Copyright (C) 2025 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+#include <qle/math/cpujitenvironment.hpp>
+#include <qle/math/randomvariable.hpp>
+#include <qle/math/randomvariable_opcodes.hpp>
+#include <qle/math/randomvariable_ops.hpp>
+#include <qle/utilities/workerpool.hpp>
+
+#include <ql/errors.hpp>
+#include <ql/math/comparison.hpp>
+#include <ql/math/distributions/normaldistribution.hpp>
+#include <ql/math/randomnumbers/mt19937uniformrng.hpp>
+
+#include <boost/math/distributions/normal.hpp>
+#include <boost/timer/timer.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+
+namespace QuantExt {
+
+namespace {
+
+/* The recorded program is compiled into segments. A segment consists of
+
+   - scalar instructions: ops on deterministic values only, evaluated once per calculation
+   - vector instructions: pathwise ops, evaluated chunk by chunk, each chunk running through all vector instructions
+     of the segment on one thread, so that intermediate results stay in the cache
+   - optionally a barrier instruction closing the segment: an op that needs all paths of its arguments (conditional
+     expectation) or that we leave to the generic random variable implementation (round)
+
+   Values only used by vector instructions of the segment in which they are defined live in chunk sized local
+   registers. All other path dependent values live in global registers of full size. Registers are reused once their
+   value is dead. */
+
+enum class Storage { Scalar, Input, Variate, Global, Local };
+
+struct Operand {
+    Storage storage = Storage::Scalar;
+    std::size_t index = 0;
+};
+
+struct Instruction {
+    std::size_t op = RandomVariableOpCode::None;
+    std::size_t firstArg = 0;
+    std::size_t nArgs = 0;
+    Operand result;
+    std::size_t node = 0;
+};
+
+struct Segment {
+    std::vector<Instruction> scalarInstructions;
+    std::vector<Instruction> vectorInstructions;
+    bool hasBarrier = false;
+    Instruction barrier;
+};
+
+struct CompiledProgram {
+    std::vector<bool> scalarInputs;
+    std::vector<Operand> args;
+    std::vector<Segment> segments;
+    std::vector<Operand> outputs;
+    std::size_t nScalarRegisters = 0;
+    std::size_t nGlobalRegisters = 0;
+    std::size_t nLocalRegisters = 0;
+    std::size_t maxVectorArgs = 0;
+    std::size_t chunkSize = 0;
+};
+
+// target size of the local registers of one thread
+constexpr std::size_t localRegistersCacheBytes = 256 * 1024;
+
+bool isBarrierOp(const std::size_t op) {
+    return op == RandomVariableOpCode::ConditionalExpectation || op == RandomVariableOpCode::Round;
+}
+
+// a pathwise argument, p = nullptr indicates a scalar with value v
+struct Arg {
+    const double* p;
+    double v;
+};
+
+template <class F> inline void kernel1(double* r, const double* x, const std::size_t len, F f) {
+    for (std::size_t i = 0; i < len; ++i)
+        r[i] = f(x[i]);
+}
+
+template <class F> inline void kernel2(double* r, const Arg& x, const Arg& y, const std::size_t len, F f) {
+    if (x.p != nullptr && y.p != nullptr) {
+        const double* xp = x.p;
+        const double* yp = y.p;
+        for (std::size_t i = 0; i < len; ++i)
+            r[i] = f(xp[i], yp[i]);
+    } else if (x.p != nullptr) {
+        const double* xp = x.p;
+        const double b = y.v;
+        for (std::size_t i = 0; i < len; ++i)
+            r[i] = f(xp[i], b);
+    } else {
+        const double a = x.v;
+        const double* yp = y.p;
+        for (std::size_t i = 0; i < len; ++i)
+            r[i] = f(a, yp[i]);
+    }
+}
+
+inline void copyKernel(double* r, const Arg& x, const std::size_t len) {
+    if (x.p == nullptr)
+        std::fill(r, r + len, x.v);
+    else if (x.p != r)
+        std::copy(x.p, x.p + len, r);
+}
+
+// executes a pathwise op on len paths, the semantics follow the RandomVariable implementation
+void executeVectorOp(const std::size_t op, double* r, const Arg* a, const std::size_t nArgs, const std::size_t len) {
+    static const boost::math::normal_distribution<double> normal;
+    switch (op) {
+    case RandomVariableOpCode::None:
+        copyKernel(r, a[0], len);
+        break;
+    case RandomVariableOpCode::Add:
+        if (nArgs == 1) {
+            copyKernel(r, a[0], len);
+            break;
+        }
+        kernel2(r, a[0], a[1], len, [](double x, double y) { return x + y; });
+        for (std::size_t k = 2; k < nArgs; ++k)
+            kernel2(r, Arg{r, 0.0}, a[k], len, [](double x, double y) { return x + y; });
+        break;
+    case RandomVariableOpCode::Subtract:
+        if (a[1].p == nullptr && QuantLib::close_enough(a[1].v, 0.0))
+            copyKernel(r, a[0], len);
+        else
+            kernel2(r, a[0], a[1], len, [](double x, double y) { return x - y; });
+        break;
+    case RandomVariableOpCode::Negative:
+        kernel1(r, a[0].p, len, [](double x) { return -x; });
+        break;
+    case RandomVariableOpCode::Mult:
+        if (a[1].p == nullptr && QuantLib::close_enough(a[1].v, 1.0))
+            copyKernel(r, a[0], len);
+        else
+            kernel2(r, a[0], a[1], len, [](double x, double y) { return x * y; });
+        break;
+    case RandomVariableOpCode::Div:
+        if (a[1].p == nullptr && QuantLib::close_enough(a[1].v, 1.0))
+            copyKernel(r, a[0], len);
+        else
+            kernel2(r, a[0], a[1], len, [](double x, double y) { return x / y; });
+        break;
+    case RandomVariableOpCode::IndicatorEq:
+        kernel2(r, a[0], a[1], len, [](double x, double y) { return QuantLib::close_enough(x, y) ? 1.0 : 0.0; });
+        break;
+    case RandomVariableOpCode::IndicatorGt:
+        kernel2(r, a[0], a[1], len,
+                [](double x, double y) { return (x > y && !QuantLib::close_enough(x, y)) ? 1.0 : 0.0; });
+        break;
+    case RandomVariableOpCode::IndicatorGeq:
+        kernel2(r, a[0], a[1], len,
+                [](double x, double y) { return (x > y || QuantLib::close_enough(x, y)) ? 1.0 : 0.0; });
+        break;
+    case RandomVariableOpCode::Min:
+        kernel2(r, a[0], a[1], len, [](double x, double y) { return std::min(x, y); });
+        break;
+    case RandomVariableOpCode::Max:
+        kernel2(r, a[0], a[1], len, [](double x, double y) { return std::max(x, y); });
+        break;
+    case RandomVariableOpCode::Abs:
+        kernel1(r, a[0].p, len, [](double x) { return std::abs(x); });
+        break;
+    case RandomVariableOpCode::Exp:
+        kernel1(r, a[0].p, len, [](double x) { return std::exp(x); });
+        break;
+    case RandomVariableOpCode::Sqrt:
+        kernel1(r, a[0].p, len, [](double x) { return std::sqrt(x); });
+        break;
+    case RandomVariableOpCode::Log:
+        kernel1(r, a[0].p, len, [](double x) { return std::log(x); });
+        break;
+    case RandomVariableOpCode::Pow:
+        if (a[1].p == nullptr && QuantLib::close_enough(a[1].v, 1.0))
+            copyKernel(r, a[0], len);
+        else
+            kernel2(r, a[0], a[1], len, [](double x, double y) { return std::pow(x, y); });
+        break;
+    case RandomVariableOpCode::NormalCdf:
+        kernel1(r, a[0].p, len, [](double x) { return boost::math::cdf(normal, x); });
+        break;
+    case RandomVariableOpCode::NormalPdf:
+        kernel1(r, a[0].p, len, [](double x) { return boost::math::pdf(normal, x); });
+        break;
+    case RandomVariableOpCode::Frac:
+        kernel1(r, a[0].p, len, [](double x) {
+            double iptr;
+            return std::modf(x, &iptr);
+        });
+        break;
+    default:
+        QL_FAIL("CpuJitContext: internal error, op " << op << " is not supported as a pathwise op.");
+    }
+}
+
+} // namespace
+
+class CpuJitContext : public ComputeContext {
+public:
+    explicit CpuJitContext(const std::size_t nThreads);
+    ~CpuJitContext() override final;
+    void init() override final;
+
+    std::pair<std::size_t, bool> initiateCalculation(const std::size_t n, const std::size_t id = 0,
+                                                     const std::size_t version = 0,
+                                                     const Settings settings = {}) override final;
+    void disposeCalculation(const std::size_t id) override final;
+    std::size_t createInputVariable(double v) override final;
+    std::size_t createInputVariable(double* v) override final;
+    std::vector<std::vector<std::size_t>> createInputVariates(const std::size_t dim,
+                                                              const std::size_t steps) override final;
+    std::size_t applyOperation(const std::size_t randomVariableOpCode,
+                               const std::vector<std::size_t>& args) override final;
+    void freeVariable(const std::size_t id) override final;
+    void declareOutputVariable(const std::size_t id) override final;
+    void finalizeCalculation(std::vector<double*>& output) override final;
+
+    std::vector<std::pair<std::string, std::string>> deviceInfo() const override;
+    bool supportsDoublePrecision() const override { return true; }
+
+    const DebugInfo& debugInfo() const override final;
+
+private:
+    enum class ComputeState { idle, createInput, createVariates, calc };
+
+    struct Program {
+        void clear() {
+            args.clear();
+            op.clear();
+            resultId.clear();
+            compiled.reset();
+        }
+        std::vector<std::vector<std::size_t>> args;
+        std::vector<std::size_t> op;
+        std::vector<std::size_t> resultId;
+        std::unique_ptr<CompiledProgram> compiled;
+    };
+
+    void compile();
+    void executeVectorInstructions(const CompiledProgram& cp, const Segment& s, const std::size_t begin,
+                                   const std::size_t end, const std::size_t thread);
+    const double* vectorData(const Operand& o) const;
+    RandomVariable randomVariable(const Operand& o) const;
+
+    std::size_t nThreads_;
+    std::unique_ptr<WorkerPool> pool_;
+
+    bool initialized_ = false;
+
+    // will be accumulated over all calcs
+    ComputeContext::DebugInfo debugInfo_;
+
+    // 1a vectors per current calc id
+
+    std::vector<std::size_t> size_;
+    std::vector<std::size_t> version_;
+    std::vector<bool> disposed_;
+    std::vector<Program> program_;
+    std::vector<std::size_t> numberOfInputVars_;
+    std::vector<std::size_t> numberOfVariates_;
+    std::vector<std::size_t> numberOfVars_;
+    std::vector<std::vector<std::size_t>> outputVars_;
+    std::vector<std::size_t> numberOfOperations_;
+
+    // 2 curent calc
+
+    std::size_t currentId_ = 0;
+    ComputeState currentState_ = ComputeState::idle;
+    Settings settings_;
+    bool newCalc_;
+
+    std::vector<std::size_t> freedVariables_;
+
+    std::vector<bool> inputIsScalar_;
+    std::vector<double> inputScalars_;
+    std::vector<std::vector<double>> inputData_;
+
+    // working storage, reused over calcs
+
+    std::vector<double> scalarRegisters_;
+    std::vector<std::vector<double>> globalRegisters_;
+    std::vector<std::vector<double>> localRegisters_;
+    std::vector<std::vector<Arg>> localArgs_;
+
+    // shared random variates for all calcs
+
+    std::unique_ptr<QuantLib::MersenneTwisterUniformRng> rng_;
+    QuantLib::InverseCumulativeNormal icn_;
+    std::vector<std::vector<double>> variates_;
+};
+
+CpuJitFramework::CpuJitFramework(const std::size_t nThreads) {
+    contexts_["CpuJit/Default/Default"] = new CpuJitContext(nThreads);
+}
+
+CpuJitFramework::~CpuJitFramework() {
+    for (auto& [_, c] : contexts_) {
+        delete c;
+    }
+}
+
+CpuJitContext::CpuJitContext(const std::size_t nThreads) : nThreads_(nThreads), initialized_(false) {}
+
+CpuJitContext::~CpuJitContext() {}
+
+void CpuJitContext::init() {
+
+    if (initialized_) {
+        return;
+    }
+
+    // the threads are only started if the context is actually used
+
+    pool_ = std::make_unique<WorkerPool>(nThreads_);
+
+    debugInfo_.numberOfOperations = 0;
+    debugInfo_.nanoSecondsDataCopy = 0;
+    debugInfo_.nanoSecondsProgramBuild = 0;
+    debugInfo_.nanoSecondsCalculation = 0;
+
+    initialized_ = true;
+}
+
+std::vector<std::pair<std::string, std::string>> CpuJitContext::deviceInfo() const {
+    return {{"threads", std::to_string(pool_ == nullptr ? nThreads_ : pool_->size())}};
+}
+
+void CpuJitContext::disposeCalculation(const std::size_t id) {
+    QL_REQUIRE(!disposed_[id - 1], "CpuJitContext::disposeCalculation(): id " << id << " was already disposed.");
+    program_[id - 1].clear();
+    disposed_[id - 1] = true;
+}
+
+std::pair<std::size_t, bool> CpuJitContext::initiateCalculation(const std::size_t n, const std::size_t id,
+                                                                const std::size_t version, const Settings settings) {
+
+    QL_REQUIRE(n > 0, "CpuJitContext::initiateCalculation(): n must not be zero");
+
+    newCalc_ = false;
+    settings_ = settings;
+
+    if (id == 0) {
+
+        // initiate new calcaultion
+
+        size_.push_back(n);
+        version_.push_back(version);
+        disposed_.push_back(false);
+        program_.push_back(Program());
+        numberOfInputVars_.push_back(0);
+        numberOfVariates_.push_back(0);
+        numberOfVars_.push_back(0);
+        outputVars_.push_back({});
+        numberOfOperations_.push_back(0);
+
+        currentId_ = size_.size();
+        newCalc_ = true;
+
+    } else {
+
+        // initiate calculation on existing id
+
+        QL_REQUIRE(id <= size_.size(),
+                   "CpuJitContext::initiateCalculation(): id (" << id << ") invalid, got 1..." << size_.size());
+        QL_REQUIRE(size_[id - 1] == n, "CpuJitContext::initiateCalculation(): size ("
+                                           << size_[id - 1] << ") for id " << id << " does not match current size ("
+                                           << n << ")");
+        QL_REQUIRE(!disposed_[id - 1], "CpuJitContext::initiateCalculation(): id ("
+                                           << id << ") was already disposed, it can not be used any more.");
+
+        if (version != version_[id - 1]) {
+            version_[id - 1] = version;
+            program_[id - 1].clear();
+            numberOfInputVars_[id - 1] = 0;
+            numberOfVariates_[id - 1] = 0;
+            numberOfVars_[id - 1] = 0;
+            outputVars_[id - 1].clear();
+            numberOfOperations_[id - 1] = 0;
+            newCalc_ = true;
+        }
+
+        currentId_ = id;
+    }
+
+    // reset variables, the input data buffers are kept to avoid reallocation on replays
+
+    numberOfInputVars_[currentId_ - 1] = 0;
+
+    inputIsScalar_.clear();
+    inputScalars_.clear();
+    if (newCalc_)
+        freedVariables_.clear();
+
+    // set state
+
+    currentState_ = ComputeState::createInput;
+
+    // return calc id
+
+    return std::make_pair(currentId_, newCalc_);
+}
+
+std::size_t CpuJitContext::createInputVariable(double v) {
+    QL_REQUIRE(currentState_ == ComputeState::createInput,
+               "CpuJitContext::createInputVariable(): not in state createInput (" << static_cast<int>(currentState_)
+                                                                                  << ")");
+    inputIsScalar_.push_back(true);
+    inputScalars_.push_back(v);
+    return numberOfInputVars_[currentId_ - 1]++;
+}
+
+std::size_t CpuJitContext::createInputVariable(double* v) {
+    QL_REQUIRE(currentState_ == ComputeState::createInput,
+               "CpuJitContext::createInputVariable(): not in state createInput (" << static_cast<int>(currentState_)
+                                                                                  << ")");
+    std::size_t k = inputIsScalar_.size();
+    if (inputData_.size() <= k)
+        inputData_.resize(k + 1);
+    inputData_[k].assign(v, v + size_[currentId_ - 1]);
+    inputIsScalar_.push_back(false);
+    inputScalars_.push_back(0.0);
+    return numberOfInputVars_[currentId_ - 1]++;
+}
+
+std::vector<std::vector<std::size_t>> CpuJitContext::createInputVariates(const std::size_t dim,
+                                                                         const std::size_t steps) {
+    QL_REQUIRE(currentState_ == ComputeState::createInput || currentState_ == ComputeState::createVariates,
+               "CpuJitContext::createInputVariates(): not in state createInput or createVariates ("
+                   << static_cast<int>(currentState_) << ")");
+    QL_REQUIRE(currentId_ > 0, "CpuJitContext::createInputVariates(): current id is not set");
+    QL_REQUIRE(newCalc_, "CpuJitContext::createInputVariates(): id (" << currentId_ << ") in version "
+                                                                      << version_[currentId_ - 1] << " is replayed.");
+    currentState_ = ComputeState::createVariates;
+
+    // same sequence as in BasicCpuContext, so that results of both contexts are comparable
+
+    if (rng_ == nullptr) {
+        rng_ = std::make_unique<MersenneTwisterUniformRng>(settings_.rngSeed);
+    }
+
+    if (variates_.size() < numberOfVariates_[currentId_ - 1] + dim * steps) {
+        for (std::size_t i = variates_.size(); i < numberOfVariates_[currentId_ - 1] + dim * steps; ++i) {
+            variates_.push_back(std::vector<double>(size_[currentId_ - 1]));
+            for (std::size_t j = 0; j < variates_.back().size(); ++j)
+                variates_.back()[j] = icn_(rng_->nextReal());
+        }
+    }
+
+    std::vector<std::vector<std::size_t>> resultIds(dim, std::vector<std::size_t>(steps));
+    for (std::size_t i = 0; i < dim; ++i) {
+        for (std::size_t j = 0; j < steps; ++j) {
+            resultIds[i][j] = numberOfInputVars_[currentId_ - 1] + numberOfVariates_[currentId_ - 1] + j * dim + i;
+        }
+    }
+
+    numberOfVariates_[currentId_ - 1] += dim * steps;
+
+    return resultIds;
+}
+
+std::size_t CpuJitContext::applyOperation(const std::size_t randomVariableOpCode,
+                                          const std::vector<std::size_t>& args) {
+    QL_REQUIRE(currentState_ == ComputeState::createInput || currentState_ == ComputeState::createVariates ||
+                   currentState_ == ComputeState::calc,
+               "CpuJitContext::applyOperation(): not in state createInput or calc (" << static_cast<int>(currentState_)
+                                                                                     << ")");
+    currentState_ = ComputeState::calc;
+    QL_REQUIRE(currentId_ > 0, "CpuJitContext::applyOperation(): current id is not set");
+    QL_REQUIRE(newCalc_, "CpuJitContext::applyOperation(): id (" << currentId_ << ") in version "
+                                                                 << version_[currentId_ - 1] << " is replayed.");
+
+    // determine variable id to use for result
+
+    std::size_t resultId;
+    if (!freedVariables_.empty()) {
+        resultId = freedVariables_.back();
+        freedVariables_.pop_back();
+    } else {
+        resultId =
+            numberOfInputVars_[currentId_ - 1] + numberOfVariates_[currentId_ - 1] + numberOfVars_[currentId_ - 1]++;
+    }
+
+    // store operation
+
+    auto& p = program_[currentId_ - 1];
+    p.args.push_back(args);
+    p.op.push_back(randomVariableOpCode);
+    p.resultId.push_back(resultId);
+
+    // update num of ops in debug info
+
+    if (settings_.debug)
+        numberOfOperations_[currentId_ - 1] += size_[currentId_ - 1];
+
+    // return result id
+
+    return resultId;
+}
+
+void CpuJitContext::freeVariable(const std::size_t id) {
+    QL_REQUIRE(currentId_ > 0, "CpuJitContext::freeVariable(): current id is not set");
+    QL_REQUIRE(newCalc_, "CpuJitContext::freeVariable(): id (" << currentId_ << ") in version "
+                                                               << version_[currentId_ - 1] << " is replayed.");
+
+    // we do not free variates, since they are shared
+
+    if (id >= numberOfInputVars_[currentId_ - 1] &&
+        id < numberOfInputVars_[currentId_ - 1] + numberOfVariates_[currentId_ - 1])
+        return;
+
+    freedVariables_.push_back(id);
+}
+
+void CpuJitContext::declareOutputVariable(const std::size_t id) {
+    QL_REQUIRE(currentState_ != ComputeState::idle, "CpuJitContext::declareOutputVariable(): state is idle");
+    QL_REQUIRE(currentId_ > 0, "CpuJitContext::declareOutputVariable(): current id not set");
+    QL_REQUIRE(newCalc_, "CpuJitContext::declareOutputVariable(): id ("
+                             << currentId_ << ") in version " << version_[currentId_ - 1] << " is replayed.");
+    outputVars_[currentId_ - 1].push_back(id);
+}
+
+void CpuJitContext::compile() {
+
+    auto& p = program_[currentId_ - 1];
+    const std::size_t nInput = numberOfInputVars_[currentId_ - 1];
+    const std::size_t nVariates = numberOfVariates_[currentId_ - 1];
+    const std::size_t nIds = nInput + nVariates + numberOfVars_[currentId_ - 1];
+    const std::size_t nInstr = p.op.size();
+    constexpr std::size_t none = std::numeric_limits<std::size_t>::max();
+
+    // 1 translate variable ids into values, i.e. one value per input, variate and instruction result
+
+    const std::size_t nValues = nInput + nVariates + nInstr;
+    std::vector<std::size_t> idToValue(nIds, none);
+    for (std::size_t i = 0; i < nInput + nVariates; ++i)
+        idToValue[i] = i;
+
+    std::vector<std::vector<std::size_t>> argValues(nInstr);
+    for (std::size_t k = 0; k < nInstr; ++k) {
+        for (auto const& a : p.args[k]) {
+            QL_REQUIRE(a < nIds && idToValue[a] != none,
+                       "CpuJitContext::compile(): op #" << k << " refers to undefined variable id " << a);
+            argValues[k].push_back(idToValue[a]);
+        }
+        idToValue[p.resultId[k]] = nInput + nVariates + k;
+    }
+
+    std::vector<std::size_t> outputValues;
+    for (auto const& id : outputVars_[currentId_ - 1]) {
+        QL_REQUIRE(id < nIds && idToValue[id] != none,
+                   "CpuJitContext::compile(): output variable id " << id << " is undefined");
+        outputValues.push_back(idToValue[id]);
+    }
+
+    // 2 determine the scalar values, i.e. those that are represented by deterministic random variables
+
+    std::vector<bool> isScalar(nValues, false);
+    for (std::size_t i = 0; i < nInput; ++i)
+        isScalar[i] = inputIsScalar_[i];
+    std::vector<std::size_t> op(p.op);
+    for (std::size_t k = 0; k < nInstr; ++k) {
+        auto const& a = argValues[k];
+        bool allScalar = std::all_of(a.begin(), a.end(), [&isScalar](const std::size_t v) { return isScalar[v]; });
+        if (op[k] == RandomVariableOpCode::ConditionalExpectation) {
+            QL_REQUIRE(a.size() >= 2, "CpuJitContext::compile(): conditional expectation requires at least 2 args");
+            if (isScalar[a[0]]) {
+                // the conditional expectation of a deterministic regressand is the regressand itself
+                op[k] = RandomVariableOpCode::None;
+                argValues[k].resize(1);
+                isScalar[nInput + nVariates + k] = true;
+            } else {
+                isScalar[nInput + nVariates + k] =
+                    std::all_of(std::next(a.begin(), 2), a.end(), [&isScalar](const std::size_t v) { return isScalar[v]; });
+            }
+        } else {
+            isScalar[nInput + nVariates + k] = allScalar;
+        }
+    }
+
+    // 3 dead code elimination
+
+    std::vector<bool> isLive(nValues, false);
+    for (auto const& v : outputValues)
+        isLive[v] = true;
+    for (std::size_t k = nInstr; k > 0; --k) {
+        if (isLive[nInput + nVariates + k - 1]) {
+            for (auto const& v : argValues[k - 1])
+                isLive[v] = true;
+        }
+    }
+
+    // 4 assign instructions to segments and collect information on the usage of the values
+
+    auto isBarrier = [&op, &argValues, &isScalar](const std::size_t k) {
+        return isBarrierOp(op[k]) && std::any_of(argValues[k].begin(), argValues[k].end(),
+                                                 [&isScalar](const std::size_t v) { return !isScalar[v]; });
+    };
+
+    std::vector<std::size_t> segment(nValues, 0);
+    std::vector<std::size_t> lastUse(nValues, none);
+    std::vector<bool> needsGlobal(nValues, false);
+    std::size_t currentSegment = 0;
+    for (std::size_t k = 0; k < nInstr; ++k) {
+        std::size_t v = nInput + nVariates + k;
+        if (!isLive[v])
+            continue;
+        segment[v] = currentSegment;
+        bool barrier = isBarrier(k);
+        for (auto const& a : argValues[k]) {
+            lastUse[a] = k;
+            if (barrier || segment[a] != currentSegment)
+                needsGlobal[a] = true;
+        }
+        if (barrier) {
+            needsGlobal[v] = true;
+            ++currentSegment;
+        }
+    }
+    for (auto const& v : outputValues)
+        needsGlobal[v] = true;
+
+    // 5 build the compiled program, allocating registers on the fly
+
+    auto cp = std::make_unique<CompiledProgram>();
+    cp->scalarInputs = inputIsScalar_;
+    cp->segments.resize(currentSegment + 1);
+
+    std::vector<Operand> operand(nValues);
+    for (std::size_t i = 0; i < nInput; ++i) {
+        if (isScalar[i]) {
+            // scalar registers are never reused, see below
+            operand[i] = Operand{Storage::Scalar, cp->nScalarRegisters++};
+        } else {
+            operand[i] = Operand{Storage::Input, i};
+        }
+    }
+    for (std::size_t i = 0; i < nVariates; ++i)
+        operand[nInput + i] = Operand{Storage::Variate, i};
+
+    std::vector<std::size_t> freeGlobal, freeLocal;
+    std::vector<bool> released(nValues, false);
+    std::vector<bool> isOutput(nValues, false);
+    for (auto const& v : outputValues)
+        isOutput[v] = true;
+
+    for (std::size_t k = 0; k < nInstr; ++k) {
+        std::size_t v = nInput + nVariates + k;
+        if (!isLive[v])
+            continue;
+
+        // allocate the result register before releasing the args, so that results never alias args
+
+        if (isScalar[v]) {
+            // scalar instructions are hoisted to the start of their segment, therefore we do not reuse scalar
+            // registers, a scalar instruction might otherwise overwrite a value still needed by a vector instruction
+            operand[v] = Operand{Storage::Scalar, cp->nScalarRegisters++};
+        } else if (needsGlobal[v]) {
+            std::size_t r;
+            if (freeGlobal.empty()) {
+                r = cp->nGlobalRegisters++;
+            } else {
+                r = freeGlobal.back();
+                freeGlobal.pop_back();
+            }
+            operand[v] = Operand{Storage::Global, r};
+        } else {
+            std::size_t r;
+            if (freeLocal.empty()) {
+                r = cp->nLocalRegisters++;
+            } else {
+                r = freeLocal.back();
+                freeLocal.pop_back();
+            }
+            operand[v] = Operand{Storage::Local, r};
+        }
+
+        Instruction instr;
+        instr.op = op[k];
+        instr.firstArg = cp->args.size();
+        instr.nArgs = argValues[k].size();
+        instr.result = operand[v];
+        instr.node = p.resultId[k];
+        for (auto const& a : argValues[k])
+            cp->args.push_back(operand[a]);
+
+        auto& s = cp->segments[segment[v]];
+        if (isBarrier(k)) {
+            s.hasBarrier = true;
+            s.barrier = instr;
+        } else if (isScalar[v]) {
+            s.scalarInstructions.push_back(instr);
+        } else {
+            s.vectorInstructions.push_back(instr);
+            cp->maxVectorArgs = std::max(cp->maxVectorArgs, instr.nArgs);
+        }
+
+        // release registers of values that are dead after this instruction
+
+        for (auto const& a : argValues[k]) {
+            if (lastUse[a] != k || released[a] || isOutput[a])
+                continue;
+            released[a] = true;
+            if (operand[a].storage == Storage::Global)
+                freeGlobal.push_back(operand[a].index);
+            else if (operand[a].storage == Storage::Local)
+                freeLocal.push_back(operand[a].index);
+        }
+    }
+
+    for (auto const& v : outputValues)
+        cp->outputs.push_back(operand[v]);
+
+    // 6 choose the chunk size such that the local registers of one thread fit into the cache
+
+    std::size_t chunkSize = localRegistersCacheBytes / (sizeof(double) * std::max<std::size_t>(cp->nLocalRegisters, 1));
+    chunkSize = std::max<std::size_t>(64, std::min<std::size_t>(4096, chunkSize));
+    cp->chunkSize = chunkSize - chunkSize % 8;
+
+    p.compiled = std::move(cp);
+}
+
+const double* CpuJitContext::vectorData(const Operand& o) const {
+    switch (o.storage) {
+    case Storage::Input:
+        return inputData_[o.index].data();
+    case Storage::Variate:
+        return variates_[o.index].data();
+    case Storage::Global:
+        return globalRegisters_[o.index].data();
+    default:
+        QL_FAIL("CpuJitContext::vectorData(): internal error, storage " << static_cast<int>(o.storage)
+                                                                        << " does not hold full path data");
+    }
+}
+
+RandomVariable CpuJitContext::randomVariable(const Operand& o) const {
+    if (o.storage == Storage::Scalar)
+        return RandomVariable(size_[currentId_ - 1], scalarRegisters_[o.index]);
+    return RandomVariable(size_[currentId_ - 1], vectorData(o));
+}
+
+void CpuJitContext::executeVectorInstructions(const CompiledProgram& cp, const Segment& s, const std::size_t begin,
+                                              const std::size_t end, const std::size_t thread) {
+    const std::size_t len = end - begin;
+    double* local = localRegisters_[thread].data();
+    Arg* args = localArgs_[thread].data();
+    for (auto const& instr : s.vectorInstructions) {
+        for (std::size_t j = 0; j < instr.nArgs; ++j) {
+            auto const& o = cp.args[instr.firstArg + j];
+            if (o.storage == Storage::Scalar)
+                args[j] = Arg{nullptr, scalarRegisters_[o.index]};
+            else if (o.storage == Storage::Local)
+                args[j] = Arg{local + o.index * cp.chunkSize, 0.0};
+            else
+                args[j] = Arg{vectorData(o) + begin, 0.0};
+        }
+        double* r = instr.result.storage == Storage::Local ? local + instr.result.index * cp.chunkSize
+                                                           : globalRegisters_[instr.result.index].data() + begin;
+        executeVectorOp(instr.op, r, args, instr.nArgs, len);
+    }
+}
+
+void CpuJitContext::finalizeCalculation(std::vector<double*>& output) {
+    struct exitGuard {
+        exitGuard() {}
+        ~exitGuard() { *currentState = ComputeState::idle; }
+        ComputeState* currentState;
+    } guard;
+
+    guard.currentState = &currentState_;
+
+    QL_REQUIRE(currentId_ > 0, "CpuJitContext::finalizeCalculation(): current id is not set");
+    init();
+    QL_REQUIRE(output.size() == outputVars_[currentId_ - 1].size(),
+               "CpuJitContext::finalizeCalculation(): output size ("
+                   << output.size() << ") inconsistent to kernel output size (" << outputVars_[currentId_ - 1].size()
+                   << ")");
+    QL_REQUIRE(inputIsScalar_.size() == numberOfInputVars_[currentId_ - 1],
+               "CpuJitContext::finalizeCalculation(): internal error, inconsistent number of input variables");
+
+    boost::timer::cpu_timer timer;
+    boost::timer::nanosecond_type timerBase = 0;
+
+    // compile the program if this was not done yet or if the structure of the inputs changed on a replay
+
+    auto& p = program_[currentId_ - 1];
+    if (p.compiled == nullptr || p.compiled->scalarInputs != inputIsScalar_) {
+        if (settings_.debug)
+            timerBase = timer.elapsed().wall;
+        compile();
+        if (settings_.debug)
+            debugInfo_.nanoSecondsProgramBuild += timer.elapsed().wall - timerBase;
+    }
+
+    const CompiledProgram& cp = *p.compiled;
+    const std::size_t n = size_[currentId_ - 1];
+
+    if (settings_.debug)
+        timerBase = timer.elapsed().wall;
+
+    // set up the registers
+
+    scalarRegisters_.resize(cp.nScalarRegisters);
+    for (std::size_t i = 0, r = 0; i < inputIsScalar_.size(); ++i) {
+        if (inputIsScalar_[i])
+            scalarRegisters_[r++] = inputScalars_[i];
+    }
+
+    if (globalRegisters_.size() < cp.nGlobalRegisters)
+        globalRegisters_.resize(cp.nGlobalRegisters);
+    for (std::size_t i = 0; i < cp.nGlobalRegisters; ++i) {
+        if (globalRegisters_[i].size() < n)
+            globalRegisters_[i].resize(n);
+    }
+
+    localRegisters_.resize(pool_->size());
+    for (auto& l : localRegisters_) {
+        if (l.size() < cp.nLocalRegisters * cp.chunkSize)
+            l.resize(cp.nLocalRegisters * cp.chunkSize);
+    }
+
+    localArgs_.resize(pool_->size());
+    for (auto& a : localArgs_) {
+        if (a.size() < cp.maxVectorArgs)
+            a.resize(cp.maxVectorArgs);
+    }
+
+    // execute the segments
+
+    // generic instructions run on the calling thread, the regressions use the pool
+    auto ops = getRandomVariableOps(n, settings_.regressionOrder, QuantLib::LsmBasisSystem::Monomial, 0.0, Null<Real>(),
+                                    {}, false, pool_.get());
+    std::vector<RandomVariable> rvArgs;
+    std::vector<const RandomVariable*> rvArgPtrs;
+
+    auto runGeneric = [this, &cp, &ops, &rvArgs, &rvArgPtrs](const Instruction& instr) {
+        rvArgs.clear();
+        for (std::size_t j = 0; j < instr.nArgs; ++j)
+            rvArgs.push_back(randomVariable(cp.args[instr.firstArg + j]));
+        rvArgPtrs = vec2vecptr(rvArgs);
+        return ops[instr.op](rvArgPtrs, instr.node);
+    };
+
+    for (auto const& s : cp.segments) {
+
+        for (auto const& instr : s.scalarInstructions) {
+            RandomVariable r = runGeneric(instr);
+            QL_REQUIRE(r.deterministic(), "CpuJitContext::finalizeCalculation(): internal error, op "
+                                              << instr.op << " on deterministic args gives non-deterministic result");
+            scalarRegisters_[instr.result.index] = r[0];
+        }
+
+        if (!s.vectorInstructions.empty()) {
+            pool_->parallelFor(n, cp.chunkSize,
+                               [this, &cp, &s](const std::size_t begin, const std::size_t end, const std::size_t t) {
+                                   executeVectorInstructions(cp, s, begin, end, t);
+                               });
+        }
+
+        if (s.hasBarrier) {
+            RandomVariable r = runGeneric(s.barrier);
+            if (s.barrier.result.storage == Storage::Scalar) {
+                QL_REQUIRE(r.deterministic(), "CpuJitContext::finalizeCalculation(): internal error, op "
+                                                  << s.barrier.op << " expected to give deterministic result");
+                scalarRegisters_[s.barrier.result.index] = r[0];
+            } else {
+                auto& g = globalRegisters_[s.barrier.result.index];
+                if (r.deterministic())
+                    std::fill(g.begin(), g.begin() + n, r[0]);
+                else
+                    std::copy(r.data(), r.data() + n, g.begin());
+            }
+        }
+    }
+
+    // fill output
+
+    for (Size i = 0; i < cp.outputs.size(); ++i) {
+        auto const& o = cp.outputs[i];
+        if (o.storage == Storage::Scalar)
+            std::fill(output[i], output[i] + n, scalarRegisters_[o.index]);
+        else {
+            const double* d = vectorData(o);
+            std::copy(d, d + n, output[i]);
+        }
+    }
+
+    if (settings_.debug)
+        debugInfo_.nanoSecondsCalculation += timer.elapsed().wall - timerBase;
+
+    // update debug info
+
+    if (settings_.debug)
+        debugInfo_.numberOfOperations += numberOfOperations_[currentId_ - 1];
+}
+
+const ComputeContext::DebugInfo& CpuJitContext::debugInfo() const { return debugInfo_; }
+
+std::set<std::string> CpuJitFramework::getAvailableDevices() const { return {"CpuJit/Default/Default"}; }
+
+ComputeContext* CpuJitFramework::getContext(const std::string& deviceName) {
+    QL_REQUIRE(deviceName == "CpuJit/Default/Default",
+               "CpuJitFramework::getContext(): device '"
+                   << deviceName << "' not supported. Available device is 'CpuJit/Default/Default'.");
+    return contexts_[deviceName];
+}
+
+} // namespace QuantExt
@@ -0,0 +1,44 @@
+/*
+ Copyright (C) 2025 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+/*! \file qle/math/cpujitenvironment.hpp
+    \brief compute env implementation using the cpu, compiling the recorded program into an instruction tape
+           that is evaluated chunk-wise over the paths on all cores
+*/
+
+#pragma once
+
+#include <qle/math/computeenvironment.hpp>
+
+#include <map>
+
+namespace QuantExt {
+
+class CpuJitFramework : public ComputeFramework {
+public:
+    //! nThreads = 0 means hardware concurrency
+    explicit CpuJitFramework(const std::size_t nThreads = 0);
+    ~CpuJitFramework() override final;
+    std::set<std::string> getAvailableDevices() const override final;
+    ComputeContext* getContext(const std::string& deviceName) override final;
+
+private:
+    std::map<std::string, ComputeContext*> contexts_;
+};
+
+} // namespace QuantExt
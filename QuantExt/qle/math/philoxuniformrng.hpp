@@ -0,0 +1,93 @@
+/*
+ Copyright (C) 2025 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+/*! \file qle/math/philoxuniformrng.hpp
+    \brief counter based uniform random number generator
+*/
+
+#pragma once
+
+#include <ql/methods/montecarlo/sample.hpp>
+#include <ql/types.hpp>
+
+#include <array>
+#include <cstdint>
+
+namespace QuantExt {
+
+//! Philox4x32-10 uniform random number generator
+/*! Counter based generator, see Salmon, Moraes, Dror, Shaw: Parallel random numbers: as easy as 1, 2, 3 (2011). The
+    n-th block of four 32 bit numbers is a bijection of the counter (n, stream) keyed by the seed, so that the sequences
+    for different streams are independent and each of them can be generated without generating any other. This is
+    useful to assign one stream to each path of a simulation that is run on several threads, the results are then the
+    same for any number of threads.
+
+    The interface follows the QuantLib uniform random number generators, the numbers are in (0, 1) with 32 bit
+    resolution, as the ones from MersenneTwisterUniformRng. */
+class Philox4x32UniformRng {
+public:
+    typedef QuantLib::Sample<QuantLib::Real> sample_type;
+
+    explicit Philox4x32UniformRng(const std::uint64_t seed = 0, const std::uint64_t stream = 0)
+        : key_{static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32)},
+          stream_{static_cast<std::uint32_t>(stream), static_cast<std::uint32_t>(stream >> 32)} {}
+
+    //! returns a sample with weight 1.0 containing a random number in (0, 1)
+    sample_type next() const { return sample_type(nextReal(), 1.0); }
+
+    //! return a random number in (0, 1)
+    QuantLib::Real nextReal() const { return (static_cast<QuantLib::Real>(nextInt32()) + 0.5) / 4294967296.0; }
+
+    //! return a random integer in [0, 0xffffffff]
+    std::uint32_t nextInt32() const {
+        if (index_ == 4) {
+            buffer_ = block({static_cast<std::uint32_t>(counter_), static_cast<std::uint32_t>(counter_ >> 32),
+                             stream_[0], stream_[1]},
+                            key_);
+            ++counter_;
+            index_ = 0;
+        }
+        return buffer_[index_++];
+    }
+
+    //! the Philox4x32-10 bijection
+    static std::array<std::uint32_t, 4> block(std::array<std::uint32_t, 4> counter, std::array<std::uint32_t, 2> key) {
+        constexpr std::uint64_t m0 = 0xD2511F53, m1 = 0xCD9E8D57;
+        constexpr std::uint32_t w0 = 0x9E3779B9, w1 = 0xBB67AE85;
+        for (int round = 0; round < 10; ++round) {
+            if (round > 0) {
+                key[0] += w0;
+                key[1] += w1;
+            }
+            std::uint64_t p0 = m0 * counter[0];
+            std::uint64_t p1 = m1 * counter[2];
+            counter = {static_cast<std::uint32_t>(p1 >> 32) ^ counter[1] ^ key[0], static_cast<std::uint32_t>(p1),
+                       static_cast<std::uint32_t>(p0 >> 32) ^ counter[3] ^ key[1], static_cast<std::uint32_t>(p0)};
+        }
+        return counter;
+    }
+
+private:
+    std::array<std::uint32_t, 2> key_;
+    std::array<std::uint32_t, 2> stream_;
+    mutable std::uint64_t counter_ = 0;
+    mutable std::array<std::uint32_t, 4> buffer_ = {};
+    mutable unsigned int index_ = 4;
+};
+
+} // namespace QuantExt
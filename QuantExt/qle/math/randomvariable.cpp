@@ -18,6 +18,7 @@
 
 #include <qle/math/randomvariable.hpp>
 #include <qle/math/randomvariablelsmbasissystem.hpp>
+#include <qle/math/randomvariableregression.hpp>
 
 #include <ql/experimental/math/moorepenroseinverse.hpp>
 #include <ql/math/comparison.hpp>
@@ -1219,7 +1220,8 @@ std::vector<const RandomVariable*> vec2vecptr(const std::vector<RandomVariable>&
 Array regressionCoefficients(
     RandomVariable r, std::vector<const RandomVariable*> regressor,
     const std::vector<std::function<RandomVariable(const std::vector<const RandomVariable*>&)>>& basisFn,
-    const Filter& filter, const RandomVariableRegressionMethod regressionMethod, const std::string& debugLabel) {
+    const Filter& filter, const RandomVariableRegressionMethod regressionMethod, const std::string& debugLabel,
+    WorkerPool* pool) {
 
     for (auto const reg : regressor) {
         QL_REQUIRE(reg->size() == r.size(),
@@ -1235,49 +1237,8 @@ Array regressionCoefficients(
 
     resumeCalcStats();
 
-    Matrix A(r.size(), basisFn.size());
-    for (Size j = 0; j < basisFn.size(); ++j) {
-        RandomVariable a = basisFn[j](regressor);
-        if (filter.initialised()) {
-            a = applyFilter(a, filter);
-        }
-        if (a.deterministic())
-            std::fill(A.column_begin(j), A.column_end(j), a[0]);
-        else
-            a.copyToMatrixCol(A, j);
-    }
-
-    if (filter.size() > 0) {
-        r = applyFilter(r, filter);
-    }
-
-    Array b(r.size());
-    if (r.deterministic())
-        std::fill(b.begin(), b.end(), r[0]);
-    else
-        r.copyToArray(b);
-
-    Array res;
-    if (regressionMethod == RandomVariableRegressionMethod::SVD) {
-        SVD svd(A);
-        const Matrix& V = svd.V();
-        const Matrix& U = svd.U();
-        const Array& w = svd.singularValues();
-        Real threshold = r.size() * QL_EPSILON * svd.singularValues()[0];
-        res = Array(basisFn.size(), 0.0);
-        for (Size i = 0; i < basisFn.size(); ++i) {
-            if (w[i] > threshold) {
-                Real u = std::inner_product(U.column_begin(i), U.column_end(i), b.begin(), Real(0.0)) / w[i];
-                for (Size j = 0; j < basisFn.size(); ++j) {
-                    res[j] += u * V[j][i];
-                }
-            }
-        }
-    } else if (regressionMethod == RandomVariableRegressionMethod::QR) {
-        res = qrSolve(A, b);
-    } else {
-        QL_FAIL("regressionCoefficients(): unknown regression method, expected SVD or QR");
-    }
+    RandomVariableRegression regression(r.size(), regressor, basisFn, filter, regressionMethod, pool);
+    Array res = regression.coefficients(r, pool);
 
     if (!debugLabel.empty()) {
         RandomVariable y(r.size(), 0.0);
@@ -1320,11 +1281,19 @@ RandomVariable conditionalExpectation(
 RandomVariable conditionalExpectation(
     const RandomVariable& r, const std::vector<const RandomVariable*>& regressor,
     const std::vector<std::function<RandomVariable(const std::vector<const RandomVariable*>&)>>& basisFn,
-    const Filter& filter, const RandomVariableRegressionMethod regressionMethod) {
+    const Filter& filter, const RandomVariableRegressionMethod regressionMethod, WorkerPool* pool) {
     if (r.deterministic())
         return r;
-    auto coeff = regressionCoefficients(r, regressor, basisFn, filter, regressionMethod);
-    return conditionalExpectation(regressor, basisFn, coeff);
+    for (auto const reg : regressor) {
+        QL_REQUIRE(reg->size() == r.size(),
+                   "regressor size (" << reg->size() << ") must match regressand size (" << r.size() << ")");
+    }
+    // the basis functions are evaluated once for the regression and the evaluation of the regression function
+    resumeCalcStats();
+    RandomVariableRegression regression(r.size(), regressor, basisFn, filter, regressionMethod, pool);
+    auto result = regression.conditionalExpectation(r, pool);
+    stopCalcStats(r.size() * basisFn.size() * std::min(r.size(), basisFn.size()));
+    return result;
 }
 
 RandomVariable expectation(const RandomVariable& r) {
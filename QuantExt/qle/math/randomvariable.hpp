@@ -314,13 +314,15 @@ std::vector<RandomVariable> applyCoordinateTransform(const std::vector<const Ran
 /* Create vector of pointers to rvs from vector of rvs */
 std::vector<const RandomVariable*> vec2vecptr(const std::vector<RandomVariable>& values);
 
-// compute regression coefficients
+class WorkerPool;
+
+// compute regression coefficients, if a worker pool is given the paths are processed on its threads
 enum class RandomVariableRegressionMethod { QR, SVD };
 Array regressionCoefficients(
     RandomVariable r, std::vector<const RandomVariable*> regressor,
     const std::vector<std::function<RandomVariable(const std::vector<const RandomVariable*>&)>>& basisFn,
     const Filter& filter = Filter(), const RandomVariableRegressionMethod = RandomVariableRegressionMethod::QR,
-    const std::string& debugLabel = std::string());
+    const std::string& debugLabel = std::string(), WorkerPool* pool = nullptr);
 
 // evaluate regression function
 RandomVariable conditionalExpectation(
@@ -328,11 +330,12 @@ RandomVariable conditionalExpectation(
     const std::vector<std::function<RandomVariable(const std::vector<const RandomVariable*>&)>>& basisFn,
     const Array& coefficients);
 
-// compute and evaluate regression in one run
+// compute and evaluate regression in one run, if a worker pool is given the paths are processed on its threads
 RandomVariable conditionalExpectation(
     const RandomVariable& r, const std::vector<const RandomVariable*>& regressor,
     const std::vector<std::function<RandomVariable(const std::vector<const RandomVariable*>&)>>& basisFn,
-    const Filter& filter = Filter(), const RandomVariableRegressionMethod = RandomVariableRegressionMethod::QR);
+    const Filter& filter = Filter(), const RandomVariableRegressionMethod = RandomVariableRegressionMethod::QR,
+    WorkerPool* pool = nullptr);
 
 // time zero expectation
 RandomVariable expectation(const RandomVariable& r);
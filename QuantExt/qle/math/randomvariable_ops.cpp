@@ -21,6 +21,8 @@
 
 #include <ql/math/comparison.hpp>
 
+#include <sstream>
+
 #include <boost/math/distributions/normal.hpp>
 
 namespace QuantExt {
@@ -30,7 +32,9 @@ RandomVariable randomVariableOpConditionalExpectation(const Size size, const Siz
                                                       QuantLib::Real regressionVarianceCutoff,
                                                       const std::set<std::set<std::size_t>>& regressorGroups,
                                                       const bool usePythonIntegration,
-                                                      const std::vector<const RandomVariable*>& args) {
+                                                      const std::vector<const RandomVariable*>& args,
+                                                      RandomVariableRegressionCache* regressionCache,
+                                                      WorkerPool* pool) {
 
     std::vector<const RandomVariable*> regressor;
     for (auto r = std::next(args.begin(), 2); r != args.end(); ++r) {
@@ -71,9 +75,21 @@ RandomVariable randomVariableOpConditionalExpectation(const Size size, const Siz
         return PythonFunctions::instance().conditionalExpectation(*args[0], regressor);
 
     } else {
-        auto tmp = multiPathBasisSystem(regressor.size(), regressionOrder, polynomType,
-                                        trivialRegressorGroups ? std::set<std::set<size_t>>{} : regressorGroups, size);
-        return conditionalExpectation(*args[0], regressor, tmp, !close_enough(*args[1], RandomVariable(size, 0.0)));
+        auto groups = trivialRegressorGroups ? std::set<std::set<size_t>>{} : regressorGroups;
+        auto tmp = multiPathBasisSystem(regressor.size(), regressionOrder, polynomType, groups, size);
+        if (regressionCache == nullptr)
+            return conditionalExpectation(*args[0], regressor, tmp, filter, RandomVariableRegressionMethod::QR, pool);
+        std::ostringstream basisId;
+        basisId << regressor.size() << "," << regressionOrder << "," << polynomType << "," << size;
+        for (auto const& g : groups) {
+            basisId << ",{";
+            for (auto const& v : g)
+                basisId << v << ",";
+            basisId << "}";
+        }
+        return regressionCache
+            ->get(size, basisId.str(), regressor, tmp, filter, RandomVariableRegressionMethod::QR, pool)
+            ->conditionalExpectation(*args[0], pool);
     }
 }
 
@@ -81,7 +97,7 @@ std::vector<RandomVariableOp>
 getRandomVariableOps(const Size size, const Size regressionOrder, QuantLib::LsmBasisSystem::PolynomialType polynomType,
                      const double eps, QuantLib::Real regressionVarianceCutoff,
                      const std::map<std::size_t, std::set<std::set<std::size_t>>>& regressorGroups,
-                     const bool usePythonIntegration) {
+                     const bool usePythonIntegration, WorkerPool* pool) {
 
     std::vector<RandomVariableOp> ops;
 
@@ -115,12 +131,17 @@ getRandomVariableOps(const Size size, const Size regressionOrder, QuantLib::LsmB
         [](const std::vector<const RandomVariable*>& args, const Size node) { return *args[0] / (*args[1]); });
 
     // ConditionalExpectation = 6
-    ops.push_back([size, regressionOrder, polynomType, regressionVarianceCutoff, regressorGroups,
-                   usePythonIntegration](const std::vector<const RandomVariable*>& args, const Size node) {
+    /* consecutive conditional expectations against the same regressors, typically several regressands on one regression
+       date, share the regression via the cache, which only keeps the last regression, so that the design matrices of
+       earlier dates are released */
+    auto regressionCache = QuantLib::ext::make_shared<RandomVariableRegressionCache>(1);
+    ops.push_back([size, regressionOrder, polynomType, regressionVarianceCutoff, regressorGroups, usePythonIntegration,
+                   regressionCache, pool](const std::vector<const RandomVariable*>& args, const Size node) {
         auto g = regressorGroups.find(node);
         return randomVariableOpConditionalExpectation(
             size, regressionOrder, polynomType, regressionVarianceCutoff,
-            g == regressorGroups.end() ? std::set<std::set<std::size_t>>{} : g->second, usePythonIntegration, args);
+            g == regressorGroups.end() ? std::set<std::set<std::size_t>>{} : g->second, usePythonIntegration, args,
+            regressionCache.get(), pool);
     });
 
     // IndicatorEq = 7
@@ -400,4 +421,23 @@ std::vector<bool> getRandomVariableOpAllowsPredeletion() {
     return result;
 }
 
+namespace {
+std::vector<bool> randomVariableIsPathwise(const double eps) {
+    std::vector<bool> result(getRandomVariableOpLabels().size(), true);
+    result[RandomVariableOpCode::ConditionalExpectation] = false;
+    // the smoothing width is derived from the values on all paths
+    if (eps != 0.0) {
+        result[RandomVariableOpCode::IndicatorGt] = false;
+        result[RandomVariableOpCode::IndicatorGeq] = false;
+        result[RandomVariableOpCode::Min] = false;
+        result[RandomVariableOpCode::Max] = false;
+    }
+    return result;
+}
+} // namespace
+
+std::vector<bool> getRandomVariableOpIsPathwise(const double eps) { return randomVariableIsPathwise(eps); }
+
+std::vector<bool> getRandomVariableGradientIsPathwise(const double eps) { return randomVariableIsPathwise(eps); }
+
 } // namespace QuantExt
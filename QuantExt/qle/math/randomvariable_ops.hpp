@@ -24,6 +24,7 @@
 
 #include <qle/math/randomvariable.hpp>
 #include <qle/math/randomvariable_opcodes.hpp>
+#include <qle/math/randomvariableregression.hpp>
 
 #include <ql/methods/montecarlo/lsmbasissystem.hpp>
 
@@ -35,20 +36,26 @@ namespace QuantExt {
 
 using RandomVariableOp = std::function<RandomVariable(const std::vector<const RandomVariable*>&, const Size)>;
 
+/* if a regression cache is given, the regression is looked up in / stored in the cache, so that regressands with the
+   same regressors and filter share one factorisation, if a worker pool is given the regression processes the paths
+   on its threads */
 RandomVariable randomVariableOpConditionalExpectation(const Size size, const Size regressionOrder,
                                                       QuantLib::LsmBasisSystem::PolynomialType polynomType,
                                                       QuantLib::Real regressionVarianceCutoff,
                                                       const std::set<std::set<std::size_t>>& regressorGroups,
                                                       const bool usePythonIntegration,
-                                                      const std::vector<const RandomVariable*>& args);
+                                                      const std::vector<const RandomVariable*>& args,
+                                                      RandomVariableRegressionCache* regressionCache = nullptr,
+                                                      WorkerPool* pool = nullptr);
 
-// eps determines the smoothing, 0 means no smoothing (default)
+/* eps determines the smoothing, 0 means no smoothing (default), the conditional expectation op runs the regressions
+   on the worker pool if one is given, the pool must outlive the ops */
 std::vector<RandomVariableOp>
 getRandomVariableOps(const Size size, const Size regressionOrder = 2,
                      const QuantLib::LsmBasisSystem::PolynomialType polynomType = QuantLib::LsmBasisSystem::Monomial,
                      const double eps = 0.0, QuantLib::Real regressionVarianceCutoff = Null<Real>(),
                      const std::map<std::size_t, std::set<std::set<std::size_t>>>& regressorGroups = {},
-                     const bool usePythonIntegration = false);
+                     const bool usePythonIntegration = false, WorkerPool* pool = nullptr);
 
 // random variable gradients
 
@@ -68,4 +75,10 @@ std::vector<RandomVariableOpNodeRequirements> getRandomVariableOpNodeRequirement
 
 std::vector<bool> getRandomVariableOpAllowsPredeletion();
 
+/* flags ops resp. gradients that act path by path, i.e. the value on a subset of paths only depends on the args on the
+   same subset of paths, these can be evaluated on tiles of paths independently, eps as in getRandomVariableOps() resp.
+   getRandomVariableGradients() */
+std::vector<bool> getRandomVariableOpIsPathwise(const double eps = 0.0);
+std::vector<bool> getRandomVariableGradientIsPathwise(const double eps = 0.2);
+
 } // namespace QuantExt
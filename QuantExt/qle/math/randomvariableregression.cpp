@@ -0,0 +1,317 @@
+/*
+ Copyright (C) 2025 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+#include <qle/math/randomvariableregression.hpp>
+#include <qle/utilities/workerpool.hpp>
+
+#include <ql/math/matrixutilities/qrdecomposition.hpp>
+#include <ql/math/matrixutilities/svd.hpp>
+
+#include <boost/functional/hash.hpp>
+
+namespace QuantExt {
+
+namespace {
+
+// number of paths processed in one go, the basis functions create temporaries of this size
+constexpr Size blockSize = 1024;
+
+Size numberOfBlocks(const Size n) { return (n + blockSize - 1) / blockSize; }
+
+// calls f(block, begin, end) for all blocks of paths, on the pool's threads if a pool is given
+void forEachBlock(WorkerPool* pool, const Size n, const std::function<void(Size, Size, Size)>& f) {
+    auto g = [&f, n](std::size_t begin, std::size_t end, std::size_t) {
+        for (Size b = begin; b < end; ++b)
+            f(b, b * blockSize, std::min(n, (b + 1) * blockSize));
+    };
+    if (pool)
+        pool->parallelFor(numberOfBlocks(n), 1, g);
+    else
+        g(0, numberOfBlocks(n), 0);
+}
+
+std::size_t hashValue(const std::vector<const RandomVariable*>& regressor) {
+    std::size_t h = 0;
+    for (auto const r : regressor) {
+        boost::hash_combine(h, r->size());
+        boost::hash_combine(h, r->deterministic());
+        if (r->deterministic()) {
+            boost::hash_combine(h, (*r)[0]);
+        } else {
+            for (Size i = 0; i < r->size(); ++i)
+                boost::hash_combine(h, (*r)[i]);
+        }
+    }
+    return h;
+}
+
+} // namespace
+
+RandomVariableRegression::RandomVariableRegression(const Size n, const std::vector<const RandomVariable*>& regressor,
+                                                   const std::vector<BasisFn>& basisFn, const Filter& filter,
+                                                   const RandomVariableRegressionMethod method, WorkerPool* pool)
+    : n_(n), method_(method) {
+
+    QL_REQUIRE(n_ > 0, "RandomVariableRegression: sample size must be positive");
+    for (Size i = 0; i < regressor.size(); ++i) {
+        QL_REQUIRE(regressor[i] != nullptr, "RandomVariableRegression: regressor #" << i << " is null.");
+        QL_REQUIRE(regressor[i]->size() == n_, "RandomVariableRegression: regressor #"
+                                                   << i << " size (" << regressor[i]->size()
+                                                   << ") must match sample size (" << n_ << ")");
+        if (time_ == Null<Real>())
+            time_ = regressor[i]->time();
+    }
+    QL_REQUIRE(filter.size() == 0 || filter.size() == n_,
+               "RandomVariableRegression: filter size (" << filter.size() << ") must match sample size (" << n_
+                                                         << ")");
+    QL_REQUIRE(n_ >= basisFn.size(), "RandomVariableRegression: sample size ("
+                                         << n_ << ") must be geq basis fns size (" << basisFn.size() << ")");
+
+    // a filter that is true on all paths is the same as no filter
+
+    if (filter.initialised() && !(filter.deterministic() && filter[0]))
+        filter_ = filter;
+
+    // evaluate the basis functions block by block
+
+    A_ = Matrix(n_, basisFn.size());
+
+    auto copyBasisValues = [this](const Size j, const RandomVariable& a, const Size begin, const Size end) {
+        QL_REQUIRE(a.deterministic() || a.size() == end - begin, "RandomVariableRegression: basis function #"
+                                                                     << j << " returned size " << a.size()
+                                                                     << ", expected " << end - begin);
+        for (Size k = begin; k < end; ++k)
+            A_[k][j] = a[k - begin];
+    };
+
+    if (regressor.empty()) {
+        // no regressors to split into blocks, the basis functions must return constants or full size variables
+        for (Size j = 0; j < basisFn.size(); ++j)
+            copyBasisValues(j, basisFn[j](regressor), 0, n_);
+    } else {
+        forEachBlock(pool, n_, [this, &regressor, &basisFn, &copyBasisValues](Size, Size begin, Size end) {
+            std::vector<RandomVariable> blockRegressor(regressor.size());
+            for (Size i = 0; i < regressor.size(); ++i) {
+                if (regressor[i]->deterministic()) {
+                    blockRegressor[i] = RandomVariable(end - begin, (*regressor[i])[0], regressor[i]->time());
+                } else {
+                    std::vector<double> values(end - begin);
+                    for (Size k = begin; k < end; ++k)
+                        values[k - begin] = (*regressor[i])[k];
+                    blockRegressor[i] = RandomVariable(values, regressor[i]->time());
+                }
+            }
+            auto blockRegressorPtr = vec2vecptr(blockRegressor);
+            for (Size j = 0; j < basisFn.size(); ++j)
+                copyBasisValues(j, basisFn[j](blockRegressorPtr), begin, end);
+        });
+    }
+
+    // factorise the design matrix, paths outside the filter enter with zero basis values and regressand
+
+    Matrix filteredA;
+    if (filter_.initialised()) {
+        filteredA = A_;
+        for (Size k = 0; k < n_; ++k) {
+            if (!filter_[k])
+                std::fill(filteredA.row_begin(k), filteredA.row_end(k), 0.0);
+        }
+    }
+    const Matrix& A = filter_.initialised() ? filteredA : A_;
+
+    if (method_ == RandomVariableRegressionMethod::SVD) {
+        QuantLib::SVD svd(A);
+        u_ = svd.U();
+        v_ = svd.V();
+        w_ = svd.singularValues();
+        threshold_ = w_.empty() ? 0.0 : n_ * QL_EPSILON * w_[0];
+    } else if (method_ == RandomVariableRegressionMethod::QR) {
+        pivot_ = QuantLib::qrDecomposition(A, q_, r_, true);
+    } else {
+        QL_FAIL("RandomVariableRegression: unknown regression method, expected SVD or QR");
+    }
+}
+
+Array RandomVariableRegression::transposedProduct(const Matrix& factor, const RandomVariable& r,
+                                                  WorkerPool* pool) const {
+    Size m = factor.columns();
+    std::vector<Array> partialSums(numberOfBlocks(n_), Array(m, 0.0));
+    forEachBlock(pool, n_, [this, &factor, &r, &partialSums, m](Size block, Size begin, Size end) {
+        Array& s = partialSums[block];
+        for (Size k = begin; k < end; ++k) {
+            if (filter_.initialised() && !filter_[k])
+                continue;
+            Real rk = r[k];
+            auto row = factor.row_begin(k);
+            for (Size i = 0; i < m; ++i)
+                s[i] += row[i] * rk;
+        }
+    });
+    Array result(m, 0.0);
+    for (auto const& s : partialSums)
+        result += s;
+    return result;
+}
+
+Array RandomVariableRegression::coefficients(const RandomVariable& r, WorkerPool* pool) const {
+    QL_REQUIRE(r.size() == n_, "RandomVariableRegression::coefficients(): regressand size ("
+                                   << r.size() << ") must match sample size (" << n_ << ")");
+
+    Size m = basisSize();
+    Array res(m, 0.0);
+
+    if (method_ == RandomVariableRegressionMethod::SVD) {
+        Array y = transposedProduct(u_, r, pool);
+        for (Size i = 0; i < w_.size(); ++i) {
+            if (w_[i] > threshold_) {
+                Real u = y[i] / w_[i];
+                for (Size j = 0; j < m; ++j) {
+                    res[j] += u * v_[j][i];
+                }
+            }
+        }
+    } else {
+        // solve R y = Q^T b as MINPACK's qrsolv (used by QuantLib's qrSolve()) does for a zero diagonal, i.e. for a
+        // singular R the components from the first zero diagonal element on are set to zero
+        Array y = transposedProduct(q_, r, pool);
+        Size nsing = m;
+        for (Size j = 0; j < m && nsing == m; ++j) {
+            if (r_[j][j] == 0.0)
+                nsing = j;
+        }
+        for (Size j = nsing; j < m; ++j)
+            y[j] = 0.0;
+        for (Size k = 1; k <= nsing; ++k) {
+            Size j = nsing - k;
+            Real sum = 0.0;
+            for (Size i = j + 1; i < nsing; ++i)
+                sum += r_[j][i] * y[i];
+            y[j] = (y[j] - sum) / r_[j][j];
+        }
+        for (Size j = 0; j < m; ++j)
+            res[pivot_[j]] = y[j];
+    }
+
+    return res;
+}
+
+RandomVariable RandomVariableRegression::conditionalExpectation(const Array& coefficients, WorkerPool* pool) const {
+    QL_REQUIRE(coefficients.size() == basisSize(),
+               "RandomVariableRegression::conditionalExpectation(): coefficients size ("
+                   << coefficients.size() << ") must match basis size (" << basisSize() << ")");
+    std::vector<double> values(n_, 0.0);
+    forEachBlock(pool, n_, [this, &coefficients, &values](Size, Size begin, Size end) {
+        for (Size k = begin; k < end; ++k) {
+            auto row = A_.row_begin(k);
+            for (Size j = 0; j < coefficients.size(); ++j)
+                values[k] += coefficients[j] * row[j];
+        }
+    });
+    return RandomVariable(values, time_);
+}
+
+RandomVariable RandomVariableRegression::conditionalExpectation(const RandomVariable& r, WorkerPool* pool) const {
+    return conditionalExpectation(coefficients(r, pool), pool);
+}
+
+Size RandomVariableRegression::memory() const {
+    Size n = A_.rows() * A_.columns() + q_.rows() * q_.columns() + r_.rows() * r_.columns() +
+             u_.rows() * u_.columns() + v_.rows() * v_.columns() + w_.size();
+    return n * sizeof(Real);
+}
+
+QuantLib::ext::shared_ptr<const RandomVariableRegression>
+RandomVariableRegressionCache::get(const Size n, const std::string& basisId,
+                                   const std::vector<const RandomVariable*>& regressor,
+                                   const std::vector<RandomVariableRegression::BasisFn>& basisFn, const Filter& filter,
+                                   const RandomVariableRegressionMethod method, WorkerPool* pool) {
+
+    std::size_t hash = hashValue(regressor);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto e = entries_.begin(); e != entries_.end(); ++e) {
+            if (e->hash != hash || e->method != method || e->basisId != basisId ||
+                e->regressor.size() != regressor.size() || e->regression->size() != n || !(e->filter == filter))
+                continue;
+            bool match = true;
+            for (Size i = 0; i < regressor.size() && match; ++i)
+                match = e->regressor[i] == *regressor[i];
+            if (match) {
+                entries_.splice(entries_.begin(), entries_, e);
+                ++hits_;
+                return entries_.front().regression;
+            }
+        }
+        ++misses_;
+    }
+
+    // factorise outside the lock, concurrent misses for the same key just compute the same regression twice
+
+    Entry entry;
+    entry.hash = hash;
+    entry.basisId = basisId;
+    for (auto const r : regressor)
+        entry.regressor.push_back(*r);
+    entry.filter = filter;
+    entry.method = method;
+    entry.regression =
+        QuantLib::ext::make_shared<RandomVariableRegression>(n, regressor, basisFn, filter, method, pool);
+    entry.bytes = entry.regression->memory() + regressor.size() * n * sizeof(Real);
+    auto result = entry.regression;
+
+    if (entry.bytes > maxBytes_)
+        return result;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    bytes_ += entry.bytes;
+    entries_.push_front(std::move(entry));
+    while (entries_.size() > maxEntries_ || bytes_ > maxBytes_) {
+        bytes_ -= entries_.back().bytes;
+        entries_.pop_back();
+    }
+    return result;
+}
+
+Size RandomVariableRegressionCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+Size RandomVariableRegressionCache::memory() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bytes_;
+}
+
+Size RandomVariableRegressionCache::hits() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return hits_;
+}
+
+Size RandomVariableRegressionCache::misses() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return misses_;
+}
+
+void RandomVariableRegressionCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    bytes_ = hits_ = misses_ = 0;
+}
+
+} // namespace QuantExt
@@ -0,0 +1,135 @@
+/*
+ Copyright (C) 2025 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+/*! \file qle/math/randomvariableregression.hpp
+    \brief factorised least squares regression of random variables
+*/
+
+#pragma once
+
+#include <qle/math/randomvariable.hpp>
+
+#include <ql/math/array.hpp>
+#include <ql/math/matrix.hpp>
+#include <ql/shared_ptr.hpp>
+
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace QuantExt {
+
+class WorkerPool;
+
+//! Least squares regression against a fixed set of regressors
+/*! The design matrix \f$ A_{ij} = f_j(x)_i \f$ is evaluated on blocks of paths, so that the basis functions only create
+    temporaries of the block size, and factorised once (QR with column pivoting resp. SVD). The coefficients for a
+    regressand are then obtained from one matrix-vector product with the stored factor and a back substitution, i.e.
+    regressing several regressands against the same regressors and filter costs one factorisation only.
+
+    The basis functions must act path by path (as the ones from multiPathBasisSystem() do). If a worker pool is given,
+    the blocks of paths are processed on its threads, the pool is not kept. The products with the stored factor are
+    accumulated block by block in a fixed order, so the results do not depend on the number of threads. */
+class RandomVariableRegression {
+public:
+    using BasisFn = std::function<RandomVariable(const std::vector<const RandomVariable*>&)>;
+
+    /*! n is the number of paths, the regressors must all have this size. Paths on which the filter is false do not
+        enter the regression. */
+    RandomVariableRegression(const Size n, const std::vector<const RandomVariable*>& regressor,
+                             const std::vector<BasisFn>& basisFn, const Filter& filter = Filter(),
+                             const RandomVariableRegressionMethod method = RandomVariableRegressionMethod::QR,
+                             WorkerPool* pool = nullptr);
+
+    Size size() const { return n_; }
+    Size basisSize() const { return A_.columns(); }
+    //! bytes held by the design matrix and its factorisation
+    Size memory() const;
+
+    //! regression coefficients for the given regressand
+    Array coefficients(const RandomVariable& r, WorkerPool* pool = nullptr) const;
+
+    //! regression function with the given coefficients evaluated on all paths
+    RandomVariable conditionalExpectation(const Array& coefficients, WorkerPool* pool = nullptr) const;
+
+    //! regression function for the given regressand evaluated on all paths
+    RandomVariable conditionalExpectation(const RandomVariable& r, WorkerPool* pool = nullptr) const;
+
+private:
+    // columns of factor multiplied with the filtered regressand
+    Array transposedProduct(const Matrix& factor, const RandomVariable& r, WorkerPool* pool) const;
+
+    Size n_;
+    Filter filter_;
+    RandomVariableRegressionMethod method_;
+    Real time_ = Null<Real>();
+    // basis functions evaluated on all paths (not filtered)
+    Matrix A_;
+    // QR: A P = Q R, pivot_ holds the permutation P
+    Matrix q_, r_;
+    std::vector<Size> pivot_;
+    // SVD: A = U diag(w) V^T
+    Matrix u_, v_;
+    Array w_;
+    Real threshold_ = 0.0;
+};
+
+//! Cache of regressions keyed on the regressors, the filter and a basis system identifier
+/*! The regressors and the filter are compared by value. The basis id must identify the basis functions passed on a
+    cache miss, e.g. by their dimension, order, polynomial type and variable groups. The least recently used entries
+    are dropped once the cache holds more than the given number of entries or the regressions and regressors held
+    exceed the given number of bytes. A regression that alone exceeds this bound is returned, but not kept. The cache
+    can be used from several threads. */
+class RandomVariableRegressionCache {
+public:
+    explicit RandomVariableRegressionCache(const Size maxEntries = 8, const Size maxBytes = 256 * 1024 * 1024)
+        : maxEntries_(maxEntries), maxBytes_(maxBytes) {}
+
+    QuantLib::ext::shared_ptr<const RandomVariableRegression>
+    get(const Size n, const std::string& basisId, const std::vector<const RandomVariable*>& regressor,
+        const std::vector<RandomVariableRegression::BasisFn>& basisFn, const Filter& filter = Filter(),
+        const RandomVariableRegressionMethod method = RandomVariableRegressionMethod::QR, WorkerPool* pool = nullptr);
+
+    Size size() const;
+    Size memory() const;
+    Size hits() const;
+    Size misses() const;
+    void clear();
+
+private:
+    struct Entry {
+        std::size_t hash;
+        std::string basisId;
+        std::vector<RandomVariable> regressor;
+        Filter filter;
+        RandomVariableRegressionMethod method;
+        QuantLib::ext::shared_ptr<const RandomVariableRegression> regression;
+        Size bytes;
+    };
+
+    Size maxEntries_, maxBytes_;
+    mutable std::mutex mutex_;
+    // most recently used first
+    std::list<Entry> entries_;
+    Size bytes_ = 0;
+    Size hits_ = 0, misses_ = 0;
+};
+
+} // namespace QuantExt
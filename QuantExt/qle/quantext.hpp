@@ -11,6 +11,7 @@
 #include <qle/ad/forwardderivatives.hpp>
 #include <qle/ad/forwardevaluation.hpp>
 #include <qle/ad/ssaform.hpp>
+#include <qle/ad/tiledevaluation.hpp>
 #include <qle/calendars/amendedcalendar.hpp>
 #include <qle/calendars/austria.hpp>
 #include <qle/calendars/belgium.hpp>
@@ -235,6 +236,7 @@
 #include <qle/math/bucketeddistribution.hpp>
 #include <qle/math/compiledformula.hpp>
 #include <qle/math/computeenvironment.hpp>
+#include <qle/math/cpujitenvironment.hpp>
 #include <qle/math/constantinterpolation.hpp>
 #include <qle/math/continuousinterpolation.hpp>
 #include <qle/math/covariancesalvage.hpp>
@@ -253,6 +255,7 @@
 #include <qle/math/method_mt.hpp>
 #include <qle/math/nadarayawatson.hpp>
 #include <qle/math/openclenvironment.hpp>
+#include <qle/math/philoxuniformrng.hpp>
 #include <qle/math/problem_mt.hpp>
 #include <qle/math/quadraticinterpolation.hpp>
 #include <qle/math/randomvariable.hpp>
@@ -260,6 +263,7 @@
 #include <qle/math/randomvariable_opcodes.hpp>
 #include <qle/math/randomvariable_ops.hpp>
 #include <qle/math/randomvariablelsmbasissystem.hpp>
+#include <qle/math/randomvariableregression.hpp>
 #include <qle/math/stabilisedglls.hpp>
 #include <qle/math/stoplightbounds.hpp>
 #include <qle/math/trace.hpp>
@@ -644,4 +648,5 @@
 #include <qle/utilities/serializationdate.hpp>
 #include <qle/utilities/serializationperiod.hpp>
 #include <qle/utilities/time.hpp>
+#include <qle/utilities/workerpool.hpp>
 #include <qle/version.hpp>
@@ -0,0 +1,131 @@
+/*
+ Copyright (C) 2025 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+#include <qle/utilities/workerpool.hpp>
+
+#include <algorithm>
+
+namespace QuantExt {
+
+namespace {
+// true on pool threads and on the calling thread while it takes part in a loop
+thread_local bool insideWorkerPoolLoop = false;
+} // namespace
+
+WorkerPool::WorkerPool(const std::size_t nThreads)
+    : nThreads_(nThreads == 0 ? std::max<std::size_t>(1, std::thread::hardware_concurrency()) : nThreads),
+      nextChunk_(0), failed_(false) {
+    for (std::size_t i = 1; i < nThreads_; ++i)
+        threads_.emplace_back(&WorkerPool::workerLoop, this, i);
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        shutdown_ = true;
+    }
+    startCondition_.notify_all();
+    for (auto& t : threads_)
+        t.join();
+}
+
+void WorkerPool::parallelFor(const std::size_t n, const std::size_t chunkSize,
+                             const std::function<void(std::size_t, std::size_t, std::size_t)>& f) {
+
+    if (n == 0)
+        return;
+
+    std::size_t cs = std::max<std::size_t>(chunkSize, 1);
+
+    // serial execution on the calling thread
+
+    if (threads_.empty() || n <= cs || insideWorkerPoolLoop) {
+        for (std::size_t b = 0; b < n; b += cs)
+            f(b, std::min(n, b + cs), 0);
+        return;
+    }
+
+    // only one loop at a time, concurrent callers wait
+
+    std::lock_guard<std::mutex> loopLock(loopMutex_);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        f_ = &f;
+        n_ = n;
+        chunkSize_ = cs;
+        nextChunk_ = 0;
+        failed_ = false;
+        error_ = nullptr;
+        busyWorkers_ = threads_.size();
+        ++generation_;
+    }
+    startCondition_.notify_all();
+
+    insideWorkerPoolLoop = true;
+    runChunks(0);
+    insideWorkerPoolLoop = false;
+
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        doneCondition_.wait(lock, [this]() { return busyWorkers_ == 0; });
+        f_ = nullptr;
+    }
+
+    if (error_)
+        std::rethrow_exception(error_);
+}
+
+void WorkerPool::workerLoop(const std::size_t threadIndex) {
+    insideWorkerPoolLoop = true;
+    std::size_t seenGeneration = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            startCondition_.wait(lock, [this, seenGeneration]() { return shutdown_ || generation_ != seenGeneration; });
+            if (shutdown_)
+                return;
+            seenGeneration = generation_;
+        }
+        runChunks(threadIndex);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (--busyWorkers_ == 0)
+                doneCondition_.notify_one();
+        }
+    }
+}
+
+void WorkerPool::runChunks(const std::size_t threadIndex) {
+    std::size_t nChunks = (n_ + chunkSize_ - 1) / chunkSize_;
+    for (;;) {
+        std::size_t c = nextChunk_++;
+        if (c >= nChunks || failed_)
+            return;
+        try {
+            (*f_)(c * chunkSize_, std::min(n_, (c + 1) * chunkSize_), threadIndex);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!error_)
+                error_ = std::current_exception();
+            failed_ = true;
+        }
+    }
+}
+
+} // namespace QuantExt
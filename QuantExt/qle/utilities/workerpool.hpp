@@ -0,0 +1,81 @@
+/*
+ Copyright (C) 2025 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+/*! \file qle/utilities/workerpool.hpp
+    \brief persistent pool of threads running data parallel loops
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace QuantExt {
+
+/*! A fixed set of threads executing data parallel loops. The calling thread takes part in each loop, so a pool of
+    size n starts n - 1 background threads. Chunks of a loop are handed out dynamically to idle threads.
+
+    The functions executed by the pool must not rely on QuantLib's thread local singletons (evaluation date, observer
+    settings etc.), the pool is meant for pure numerical work. Nested calls to parallelFor() from within a loop and
+    calls on a pool of size 1 run serially on the calling thread. */
+class WorkerPool {
+public:
+    //! nThreads = 0 means hardware concurrency
+    explicit WorkerPool(const std::size_t nThreads = 0);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    std::size_t size() const { return nThreads_; }
+
+    /*! Calls f(begin, end, threadIndex) on a partition of [0, n) into chunks of length chunkSize, the last chunk can be
+        shorter. The thread index is in 0, ..., size() - 1 and can be used to address thread local scratch space. If a
+        call throws, the remaining chunks are skipped and the first exception is rethrown on the calling thread. */
+    void parallelFor(const std::size_t n, const std::size_t chunkSize,
+                     const std::function<void(std::size_t, std::size_t, std::size_t)>& f);
+
+private:
+    void workerLoop(const std::size_t threadIndex);
+    void runChunks(const std::size_t threadIndex);
+
+    std::size_t nThreads_;
+    std::vector<std::thread> threads_;
+
+    std::mutex loopMutex_;
+    std::mutex mutex_;
+    std::condition_variable startCondition_;
+    std::condition_variable doneCondition_;
+    std::size_t generation_ = 0;
+    std::size_t busyWorkers_ = 0;
+    bool shutdown_ = false;
+
+    const std::function<void(std::size_t, std::size_t, std::size_t)>* f_ = nullptr;
+    std::size_t n_ = 0;
+    std::size_t chunkSize_ = 1;
+    std::atomic<std::size_t> nextChunk_;
+    std::atomic<bool> failed_;
+    std::exception_ptr error_;
+};
+
+} // namespace QuantExt
@@ -22,6 +22,7 @@
 #include <qle/ad/forwardderivatives.hpp>
 #include <qle/ad/forwardevaluation.hpp>
 #include <qle/ad/ssaform.hpp>
+#include <qle/ad/tiledevaluation.hpp>
 #include <qle/math/randomvariable_ops.hpp>
 
 #include <ql/math/distributions/normaldistribution.hpp>
@@ -218,6 +219,83 @@ BOOST_AUTO_TEST_CASE(testPow) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(testTiledEvaluation) {
+    BOOST_TEST_MESSAGE("Testing tiled forward evaluation and backward derivatives against serial versions...");
+
+    constexpr Real tol = 1E-12;
+    constexpr Size n = 10007;
+
+    // w = E( max(exp(x) * y, 1) | x ) * x + exp(x) * y
+    ComputationGraph g;
+    auto x = cg_var(g, "x", ComputationGraph::VarDoesntExist::Create);
+    auto y = cg_var(g, "y", ComputationGraph::VarDoesntExist::Create);
+    auto u = cg_mult(g, cg_exp(g, x), y);
+    auto v = cg_max(g, u, cg_const(g, 1.0));
+    auto c = cg_conditionalExpectation(g, v, {x}, cg_const(g, 1.0));
+    auto w = cg_add(g, cg_mult(g, c, x), u);
+
+    InverseCumulativeRng<MersenneTwisterUniformRng, InverseCumulativeNormal> normal(MersenneTwisterUniformRng(42));
+
+    std::vector<RandomVariable> values(g.size());
+    for (auto const& [value, id] : g.constants())
+        values[id] = RandomVariable(n, value);
+    values[x] = RandomVariable(n);
+    values[y] = RandomVariable(n);
+    for (Size i = 0; i < n; ++i) {
+        values[x].set(i, 0.2 * normal.next().value);
+        values[y].set(i, 1.0 + 0.1 * normal.next().value);
+    }
+
+    std::vector<bool> keepNodes(g.size(), false);
+    for (auto const& [value, id] : g.constants())
+        keepNodes[id] = true;
+    keepNodes[x] = true;
+    keepNodes[y] = true;
+
+    auto opsFactory = [](const std::size_t size) { return getRandomVariableOps(size); };
+    auto gradsFactory = [](const std::size_t size) {
+        return getRandomVariableGradients(size, 2, QuantLib::LsmBasisSystem::Monomial, 0.0);
+    };
+
+    std::vector<RandomVariable> valuesSerial(values), valuesTiled(values);
+
+    forwardEvaluation(g, valuesSerial, opsFactory(n), RandomVariable::deleter, true,
+                      getRandomVariableOpNodeRequirements(), keepNodes);
+
+    WorkerPool pool(4);
+    forwardEvaluationTiled(pool, 1000, g, valuesTiled, opsFactory, getRandomVariableOpIsPathwise(),
+                           RandomVariable::deleter, true, getRandomVariableOpNodeRequirements(), keepNodes);
+
+    for (Size i = 0; i < g.size(); ++i) {
+        BOOST_REQUIRE_EQUAL(valuesSerial[i].initialised(), valuesTiled[i].initialised());
+        if (valuesSerial[i].initialised()) {
+            BOOST_CHECK_EQUAL(valuesSerial[i].deterministic(), valuesTiled[i].deterministic());
+            for (Size k = 0; k < n; ++k)
+                BOOST_CHECK_SMALL(valuesSerial[i][k] - valuesTiled[i][k], tol);
+        }
+    }
+
+    std::vector<RandomVariable> derivativesSerial(g.size(), RandomVariable(n, 0.0));
+    derivativesSerial[w] = RandomVariable(n, 1.0);
+    std::vector<RandomVariable> derivativesTiled(derivativesSerial);
+
+    auto ops = opsFactory(n);
+    backwardDerivatives(g, valuesSerial, derivativesSerial, gradsFactory(n), RandomVariable::deleter, keepNodes, ops,
+                        getRandomVariableOpNodeRequirements(), keepNodes, RandomVariableOpCode::ConditionalExpectation,
+                        ops[RandomVariableOpCode::ConditionalExpectation]);
+    backwardDerivativesTiled(pool, 1000, g, valuesTiled, derivativesTiled, gradsFactory,
+                             getRandomVariableGradientIsPathwise(0.0), RandomVariable::deleter, keepNodes, opsFactory,
+                             getRandomVariableOpIsPathwise(), getRandomVariableOpNodeRequirements(), keepNodes,
+                             RandomVariableOpCode::ConditionalExpectation,
+                             ops[RandomVariableOpCode::ConditionalExpectation]);
+
+    for (auto node : {x, y}) {
+        BOOST_REQUIRE(derivativesTiled[node].initialised());
+        for (Size k = 0; k < n; ++k)
+            BOOST_CHECK_SMALL(derivativesSerial[node][k] - derivativesTiled[node][k], tol);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_SUITE_END()
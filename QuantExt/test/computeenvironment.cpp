@@ -18,6 +18,7 @@
 
 #include <qle/math/basiccpuenvironment.hpp>
 #include <qle/math/computeenvironment.hpp>
+#include <qle/math/cpujitenvironment.hpp>
 #include <qle/math/openclenvironment.hpp>
 #include <qle/math/cudaenvironment.hpp>
 #include <qle/math/randomvariable.hpp>
@@ -45,6 +46,8 @@ struct ComputeEnvironmentFixture {
             .add("OpenCL", &QuantExt::createComputeFrameworkCreator<QuantExt::OpenClFramework>, true);
                 QuantExt::ComputeFrameworkRegistry::instance()
             .add("BasicCpu", &QuantExt::createComputeFrameworkCreator<QuantExt::BasicCpuFramework>, true);
+        QuantExt::ComputeFrameworkRegistry::instance().add(
+            "CpuJit", &QuantExt::createComputeFrameworkCreator<QuantExt::CpuJitFramework>, true);
 		QuantExt::ComputeFrameworkRegistry::instance().add(
             "Cuda", &QuantExt::createComputeFrameworkCreator<QuantExt::CudaFramework>, true);
     }
@@ -563,6 +566,77 @@ BOOST_AUTO_TEST_CASE(testConditionalExpectation2) {
     BOOST_CHECK(true);
 }
 
+BOOST_AUTO_TEST_CASE(testCpuJitAgainstBasicCpu) {
+    ComputeEnvironmentFixture fixture;
+    BOOST_TEST_MESSAGE("testing CpuJit device against BasicCpu device");
+
+    const std::size_t n = 10000;
+
+    // a program mixing scalar and pathwise ops, reused variables and conditional expectations
+
+    auto run = [n](const std::string& device, const double s) {
+        ComputeEnvironment::instance().selectContext(device);
+        auto& c = ComputeEnvironment::instance().context();
+        ComputeContext::Settings settings;
+        settings.useDoublePrecision = true;
+        std::vector<double> rx(n);
+        for (std::size_t i = 0; i < n; ++i)
+            rx[i] = 0.5 + static_cast<double>(i) / static_cast<double>(n);
+        auto [id, _] = c.initiateCalculation(n, 0, 0, settings);
+        auto x = c.createInputVariable(&rx[0]);
+        auto a = c.createInputVariable(s);
+        auto b = c.createInputVariable(0.25);
+        auto one = c.createInputVariable(1.0);
+        auto vs = c.createInputVariates(1, 2);
+        auto ab = c.applyOperation(RandomVariableOpCode::Mult, {a, b});
+        auto y = c.applyOperation(RandomVariableOpCode::Add, {x, vs[0][0], ab});
+        auto e = c.applyOperation(RandomVariableOpCode::Exp, {y});
+        c.freeVariable(y);
+        auto m = c.applyOperation(RandomVariableOpCode::Max, {e, a});
+        c.freeVariable(e);
+        auto ce = c.applyOperation(RandomVariableOpCode::ConditionalExpectation, {m, one, vs[0][1]});
+        auto ex = c.applyOperation(RandomVariableOpCode::ConditionalExpectation, {m, one});
+        auto d = c.applyOperation(RandomVariableOpCode::Subtract, {m, ce});
+        auto ind = c.applyOperation(RandomVariableOpCode::IndicatorGt, {d, b});
+        auto l = c.applyOperation(RandomVariableOpCode::Log, {m});
+        auto z = c.applyOperation(RandomVariableOpCode::Mult, {ind, l});
+        auto w = c.applyOperation(RandomVariableOpCode::NormalCdf, {z});
+        c.declareOutputVariable(w);
+        c.declareOutputVariable(ex);
+        c.declareOutputVariable(ab);
+        c.declareOutputVariable(x);
+        std::vector<std::vector<double>> output(4, std::vector<double>(n));
+        c.finalizeCalculation(output);
+
+        // replay with a different input value
+
+        c.initiateCalculation(n, id, 0, settings);
+        c.createInputVariable(&rx[0]);
+        c.createInputVariable(2.0 * s);
+        c.createInputVariable(0.25);
+        c.createInputVariable(1.0);
+        std::vector<std::vector<double>> output2(4, std::vector<double>(n));
+        c.finalizeCalculation(output2);
+        output.insert(output.end(), output2.begin(), output2.end());
+        return output;
+    };
+
+    auto ref = run("BasicCpu/Default/Default", 1.5);
+    auto res = run("CpuJit/Default/Default", 1.5);
+
+    BOOST_REQUIRE_EQUAL(ref.size(), res.size());
+    for (std::size_t k = 0; k < ref.size(); ++k) {
+        Size noErrors = 0, errorThreshold = 10;
+        for (std::size_t i = 0; i < n; ++i) {
+            if (std::abs(ref[k][i] - res[k][i]) > 1E-12 && noErrors < errorThreshold) {
+                BOOST_ERROR("CpuJit value (" << res[k][i] << ") at k=" << k << ", i=" << i
+                                             << " does not match BasicCpu value (" << ref[k][i] << ")");
+                noErrors++;
+            }
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,103 @@
+/*
+ Copyright (C) 2025 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+#include "toplevelfixture.hpp"
+#include <boost/test/unit_test.hpp>
+
+#include <qle/math/philoxuniformrng.hpp>
+
+#include <vector>
+
+using namespace QuantExt;
+using namespace QuantLib;
+
+BOOST_FIXTURE_TEST_SUITE(QuantExtTestSuite, qle::test::TopLevelFixture)
+
+BOOST_AUTO_TEST_SUITE(PhiloxUniformRngTest)
+
+BOOST_AUTO_TEST_CASE(testKnownAnswers) {
+
+    BOOST_TEST_MESSAGE("Testing Philox4x32-10 against known answer vectors...");
+
+    // test vectors from the Random123 distribution
+
+    std::vector<std::array<std::uint32_t, 4>> counter = {
+        {0, 0, 0, 0}, {0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}, {0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}};
+    std::vector<std::array<std::uint32_t, 2>> key = {{0, 0}, {0xffffffff, 0xffffffff}, {0xa4093822, 0x299f31d0}};
+    std::vector<std::array<std::uint32_t, 4>> expected = {{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8},
+                                                          {0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd},
+                                                          {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}};
+
+    for (Size i = 0; i < counter.size(); ++i) {
+        auto result = Philox4x32UniformRng::block(counter[i], key[i]);
+        for (Size j = 0; j < 4; ++j)
+            BOOST_CHECK_EQUAL(result[j], expected[i][j]);
+    }
+
+    // the first numbers of stream 0 for seed 0 are the first block above
+
+    Philox4x32UniformRng rng;
+    for (Size j = 0; j < 4; ++j)
+        BOOST_CHECK_EQUAL(rng.nextInt32(), expected[0][j]);
+}
+
+BOOST_AUTO_TEST_CASE(testStreams) {
+
+    BOOST_TEST_MESSAGE("Testing Philox4x32-10 streams...");
+
+    // a stream generated on its own is the same as when generated interleaved with other streams
+
+    constexpr Size n = 1000;
+    std::vector<Real> reference;
+    Philox4x32UniformRng rng(42, 7);
+    for (Size i = 0; i < n; ++i)
+        reference.push_back(rng.next().value);
+
+    Philox4x32UniformRng rng7(42, 7), rng8(42, 8), rng7b(43, 7);
+    Size differentStream = 0, differentSeed = 0;
+    for (Size i = 0; i < n; ++i) {
+        Real x8 = rng8.nextReal();
+        Real x7b = rng7b.nextReal();
+        Real x7 = rng7.nextReal();
+        BOOST_CHECK_EQUAL(x7, reference[i]);
+        BOOST_CHECK(x7 > 0.0 && x7 < 1.0);
+        if (x7 != x8)
+            ++differentStream;
+        if (x7 != x7b)
+            ++differentSeed;
+    }
+    BOOST_CHECK_EQUAL(differentStream, n);
+    BOOST_CHECK_EQUAL(differentSeed, n);
+
+    // first two moments
+
+    Real sum = 0.0, sum2 = 0.0;
+    constexpr Size m = 100000;
+    Philox4x32UniformRng rng2(1234);
+    for (Size i = 0; i < m; ++i) {
+        Real x = rng2.nextReal();
+        sum += x;
+        sum2 += x * x;
+    }
+    BOOST_CHECK_SMALL(sum / m - 0.5, 0.005);
+    BOOST_CHECK_SMALL(sum2 / m - 1.0 / 3.0, 0.005);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -24,8 +24,12 @@
 // clang-format on
 
 #include <qle/math/randomvariable.hpp>
+#include <qle/math/randomvariable_ops.hpp>
+#include <qle/math/randomvariableregression.hpp>
+#include <qle/utilities/workerpool.hpp>
 
 #include <ql/time/date.hpp>
+#include <ql/math/matrixutilities/qrdecomposition.hpp>
 #include <ql/pricingengines/blackformula.hpp>
 
 #include <boost/math/distributions/normal.hpp>
@@ -192,6 +196,116 @@ BOOST_AUTO_TEST_CASE(testBlack) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(testRegression) {
+    BOOST_TEST_MESSAGE("Testing factorised regression...");
+
+    // two regressors and a noisy quadratic regressand on more paths than one block
+    Size n = 2500;
+    RandomVariable x(n), z(n), y(n), w(n);
+    Filter filter(n, true);
+    for (Size i = 0; i < n; ++i) {
+        x.set(i, std::sin(static_cast<Real>(i)));
+        z.set(i, std::cos(0.7 * static_cast<Real>(i)));
+        y.set(i, 1.0 + 2.0 * x[i] - 0.5 * z[i] + 3.0 * x[i] * z[i] + 0.1 * std::cos(3.0 * static_cast<Real>(i)));
+        w.set(i, std::exp(x[i]) - z[i] * z[i]);
+        filter.set(i, i % 3 != 0);
+    }
+    std::vector<const RandomVariable*> regressor = {&x, &z};
+    auto basisFn = multiPathBasisSystem(2, 2, QuantLib::LsmBasisSystem::Monomial);
+
+    // reference: dense design matrix with filtered rows set to zero, solved with QuantLib's qrSolve()
+    Matrix A(n, basisFn.size());
+    for (Size j = 0; j < basisFn.size(); ++j) {
+        RandomVariable a = applyFilter(basisFn[j](regressor), filter);
+        for (Size i = 0; i < n; ++i)
+            A[i][j] = a[i];
+    }
+
+    WorkerPool pool(4);
+
+    for (auto method : {RandomVariableRegressionMethod::QR, RandomVariableRegressionMethod::SVD}) {
+        RandomVariableRegression regression(n, regressor, basisFn, filter, method);
+        RandomVariableRegression regressionMt(n, regressor, basisFn, filter, method, &pool);
+        for (auto const r : {&y, &w}) {
+            Array b(n);
+            applyFilter(*r, filter).copyToArray(b);
+            Array ref = qrSolve(A, b);
+            Array c = regression.coefficients(*r);
+            Array cMt = regressionMt.coefficients(*r, &pool);
+            BOOST_REQUIRE_EQUAL(c.size(), ref.size());
+            for (Size j = 0; j < c.size(); ++j) {
+                BOOST_CHECK_SMALL(c[j] - ref[j], 1E-10);
+                // the result does not depend on the number of threads
+                BOOST_CHECK_EQUAL(c[j], cMt[j]);
+            }
+            RandomVariable ce = regression.conditionalExpectation(*r);
+            RandomVariable ceRef = conditionalExpectation(regressor, basisFn, ref);
+            for (Size i = 0; i < n; ++i)
+                BOOST_CHECK_SMALL(ce[i] - ceRef[i], 1E-10);
+        }
+    }
+
+    // the free functions and the conditional expectation op pass the worker pool on to the regression
+
+    Array c = regressionCoefficients(y, regressor, basisFn, filter);
+    Array cMt =
+        regressionCoefficients(y, regressor, basisFn, filter, RandomVariableRegressionMethod::QR, std::string(), &pool);
+    BOOST_REQUIRE_EQUAL(c.size(), cMt.size());
+    for (Size j = 0; j < c.size(); ++j)
+        BOOST_CHECK_EQUAL(c[j], cMt[j]);
+
+    RandomVariable ce = conditionalExpectation(y, regressor, basisFn, filter);
+    RandomVariable ceMt =
+        conditionalExpectation(y, regressor, basisFn, filter, RandomVariableRegressionMethod::QR, &pool);
+    auto ops = getRandomVariableOps(n, 2);
+    auto opsMt = getRandomVariableOps(n, 2, QuantLib::LsmBasisSystem::Monomial, 0.0, Null<Real>(), {}, false, &pool);
+    RandomVariable one(n, 1.0);
+    std::vector<const RandomVariable*> args = {&y, &one, &x, &z};
+    RandomVariable ceOp = ops[RandomVariableOpCode::ConditionalExpectation](args, 0);
+    RandomVariable ceOpMt = opsMt[RandomVariableOpCode::ConditionalExpectation](args, 0);
+    for (Size i = 0; i < n; ++i) {
+        BOOST_CHECK_EQUAL(ce[i], ceMt[i]);
+        BOOST_CHECK_EQUAL(ceOp[i], ceOpMt[i]);
+    }
+
+    // repeated regressands against the same regressors and filter share the regression
+
+    RandomVariableRegressionCache cache(2);
+    auto r1 = cache.get(n, "basis", regressor, basisFn, filter);
+    auto r2 = cache.get(n, "basis", regressor, basisFn, filter);
+    BOOST_CHECK(r1 == r2);
+    BOOST_CHECK_EQUAL(cache.hits(), 1);
+    BOOST_CHECK_EQUAL(cache.misses(), 1);
+
+    // another filter, basis id or regressor value gives another regression
+    auto r3 = cache.get(n, "basis", regressor, basisFn, Filter(n, true));
+    auto r4 = cache.get(n, "otherBasis", regressor, basisFn, filter);
+    BOOST_CHECK(r3 != r1);
+    BOOST_CHECK(r4 != r1);
+    BOOST_CHECK_EQUAL(cache.misses(), 3);
+    BOOST_CHECK_EQUAL(cache.size(), 2);
+    RandomVariable z2 = z;
+    z2.set(n - 1, z[n - 1] + 1.0);
+    auto r5 = cache.get(n, "otherBasis", {&x, &z2}, basisFn, filter);
+    BOOST_CHECK(r5 != r4);
+    BOOST_CHECK_EQUAL(cache.misses(), 4);
+    BOOST_CHECK_EQUAL(cache.memory(), r5->memory() + r4->memory() + 4 * n * sizeof(Real));
+
+    // the memory bound drops the least recently used regressions, a regression exceeding it is not kept at all
+
+    RandomVariableRegressionCache smallCache(8, r1->memory() + 2 * n * sizeof(Real));
+    smallCache.get(n, "basis", regressor, basisFn, filter);
+    smallCache.get(n, "otherBasis", regressor, basisFn, filter);
+    BOOST_CHECK_EQUAL(smallCache.size(), 1);
+    smallCache.get(n, "otherBasis", regressor, basisFn, filter);
+    BOOST_CHECK_EQUAL(smallCache.hits(), 1);
+    RandomVariableRegressionCache tinyCache(8, 0);
+    tinyCache.get(n, "basis", regressor, basisFn, filter);
+    tinyCache.get(n, "basis", regressor, basisFn, filter);
+    BOOST_CHECK_EQUAL(tinyCache.size(), 0);
+    BOOST_CHECK_EQUAL(tinyCache.misses(), 2);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_SUITE_END()